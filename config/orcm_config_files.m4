@@ -19,6 +19,7 @@ AC_DEFUN([ORCM_CONFIG_FILES],[
     orcm/tools/oflow/Makefile
     orcm/tools/ops/Makefile
     orcm/tools/opwrvirus/Makefile
+    orcm/tools/orcm-cfgc/Makefile
     orcm/tools/orcm-emulator/Makefile
     orcm/tools/orcm-info/Makefile
     orcm/tools/orcmd/Makefile
@@ -0,0 +1,792 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/dss/dss.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+#include "orte/util/proc_info.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "analytics_aggregate.h"
+
+/*
+ * Aggregate operator
+ *
+ * Reduces the samples of each (sensor, label) of all the nodes seen by
+ * the step, period by period, to partial aggregates: how many samples,
+ * their sum, min and max, the sum of the mean of each node (the power
+ * of a rack, say, rather than of its samples), how many nodes, and if
+ * quantiles are asked for a sketch (see analytics_base_sketch.c).
+ * Partials merge exactly, so a step placed on an aggregator can take
+ * those of the steps below it instead of their samples (see
+ * analytics_base_aggregate.c): a rack gets one partial per (sensor,
+ * label) and period from each node, the top one from each rack.
+ *
+ * The step attributes:
+ *
+ *    name=<name>                  the partials of the step go to the steps
+ *                                 of the same name above, default aggregate
+ *    forward=yes|no               send the closed partials up the routing
+ *                                 tree instead of emitting them, default no
+ *    compute=<stat>[;<stat>...]   total, sum, min, max, count, mean, nodes
+ *                                 or pNN (e.g. p99); default total;mean;min;max
+ *    group=<node>                 node given to the statistics emitted,
+ *                                 default the name of this node
+ *    period=<n>[ms|s|m|h]         length of the periods, default 60s
+ *    accuracy=<a>                 relative accuracy of the quantiles,
+ *                                 default 0.01
+ *    max_bins=<n>                 buckets per sign of a sketch, default 2048
+ *
+ * Periods are aligned on multiples of their length, the same on every
+ * level. A period is closed - emitted or sent up - when data two periods
+ * past it arrives, so a child may be a period behind the others; older
+ * data is dropped. The periods still open when the workflow stops are
+ * closed then, their statistics stored but not passed on. Quantiles above need the steps below to compute some
+ * too, with the same accuracy.
+ */
+
+#define AGGREGATE_DEFAULT_NAME      "aggregate"
+#define AGGREGATE_DEFAULT_ACCURACY  0.01
+#define AGGREGATE_DEFAULT_BINS      2048
+#define AGGREGATE_MAX_BINS          (1 << 16)
+#define AGGREGATE_DEFAULT_PERIOD    60.0
+#define AGGREGATE_DEFAULT_COMPUTE   "total;mean;min;max"
+#define AGGREGATE_KEY_MAX           512
+#define AGGREGATE_STATES_INIT       1024
+
+static int init(orcm_analytics_base_module_t *imod);
+static void finalize(orcm_analytics_base_module_t *imod);
+static int analyze(int sd, short args, void *cbdata);
+static void flush_open(orcm_analytics_base_module_t *imod, orcm_workflow_t *wf,
+                       orcm_workflow_step_t *wf_step);
+
+mca_analytics_aggregate_module_t orcm_analytics_aggregate_module = {
+    {
+        init,
+        finalize,
+        analyze,
+        NULL,
+        flush_open
+    }
+};
+
+static void state_con(orcm_analytics_aggregate_state_t *p)
+{
+    int i;
+
+    p->key_id = ORCM_ANALYTICS_KEY_INVALID;
+    for (i=0; i < ORCM_ANALYTICS_AGGREGATE_MAX_STATS; i++) {
+        p->out_ids[i] = ORCM_ANALYTICS_KEY_INVALID;
+    }
+    for (i=0; i < ORCM_ANALYTICS_AGGREGATE_SLOTS; i++) {
+        p->slots[i].period = -1;
+        p->slots[i].sketch = NULL;
+    }
+}
+static void state_des(orcm_analytics_aggregate_state_t *p)
+{
+    int i;
+
+    for (i=0; i < ORCM_ANALYTICS_AGGREGATE_SLOTS; i++) {
+        if (NULL != p->slots[i].sketch) {
+            OBJ_RELEASE(p->slots[i].sketch);
+        }
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_aggregate_state_t,
+                   opal_object_t,
+                   state_con, state_des);
+
+static void node_con(orcm_analytics_aggregate_node_t *p)
+{
+    int i;
+
+    p->state = NULL;
+    for (i=0; i < ORCM_ANALYTICS_AGGREGATE_SLOTS; i++) {
+        p->period[i] = -1;
+        p->count[i] = 0;
+        p->sum[i] = 0.0;
+    }
+}
+static void node_des(orcm_analytics_aggregate_node_t *p)
+{
+    if (NULL != p->state) {
+        OBJ_RELEASE(p->state);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_aggregate_node_t,
+                   opal_object_t,
+                   node_con, node_des);
+
+static int init(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_aggregate_module_t *mod;
+
+    if (NULL == imod) {
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_aggregate_module_t*)imod;
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    mod->configured = false;
+    mod->name = NULL;
+    mod->group = NULL;
+    mod->period = AGGREGATE_DEFAULT_PERIOD;
+    mod->forward = false;
+    mod->need_sketch = false;
+    mod->accuracy = AGGREGATE_DEFAULT_ACCURACY;
+    mod->max_bins = AGGREGATE_DEFAULT_BINS;
+    mod->ncompute = 0;
+    OBJ_CONSTRUCT(&mod->states, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->states, AGGREGATE_STATES_INIT, INT32_MAX,
+                            AGGREGATE_STATES_INIT);
+    OBJ_CONSTRUCT(&mod->nodes, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->nodes, AGGREGATE_STATES_INIT, INT32_MAX,
+                            AGGREGATE_STATES_INIT);
+    mod->pending = NULL;
+    mod->npending = 0;
+    mod->late = 0;
+    return ORCM_SUCCESS;
+}
+
+static void release_objects(opal_pointer_array_t *objects)
+{
+    opal_object_t *obj;
+    int i;
+
+    for (i=0; i < objects->size; i++) {
+        obj = (opal_object_t*)opal_pointer_array_get_item(objects, i);
+        if (NULL != obj) {
+            OBJ_RELEASE(obj);
+        }
+    }
+    OBJ_DESTRUCT(objects);
+}
+
+static void finalize(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_aggregate_module_t *mod;
+    int i;
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:aggregate:finalize",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+    if (NULL == imod) {
+        return;
+    }
+    mod = (mca_analytics_aggregate_module_t*)imod;
+    /* the nodes hold their states */
+    release_objects(&mod->nodes);
+    release_objects(&mod->states);
+    for (i=0; i < mod->ncompute; i++) {
+        free(mod->compute[i].name);
+    }
+    if (NULL != mod->pending) {
+        OBJ_RELEASE(mod->pending);
+    }
+    free(mod->name);
+    free(mod->group);
+    free(mod);
+}
+
+static const orcm_analytics_base_stat_name_t stat_names[] = {
+    {"total", ORCM_ANALYTICS_AGGREGATE_TOTAL},
+    {"sum", ORCM_ANALYTICS_AGGREGATE_SUM},
+    {"min", ORCM_ANALYTICS_AGGREGATE_MIN},
+    {"max", ORCM_ANALYTICS_AGGREGATE_MAX},
+    {"count", ORCM_ANALYTICS_AGGREGATE_COUNT},
+    {"mean", ORCM_ANALYTICS_AGGREGATE_MEAN},
+    {"average", ORCM_ANALYTICS_AGGREGATE_MEAN},
+    {"nodes", ORCM_ANALYTICS_AGGREGATE_NODES},
+    {NULL, 0}
+};
+
+static int parse_compute(mca_analytics_aggregate_module_t *mod, const char *str)
+{
+    orcm_analytics_aggregate_compute_t *c;
+    char **stats;
+    double percent;
+    int i, stat, rc = ORCM_SUCCESS;
+
+    stats = opal_argv_split(str, ';');
+    for (i=0; NULL != stats && NULL != stats[i]; i++) {
+        if (ORCM_ANALYTICS_AGGREGATE_MAX_STATS == mod->ncompute ||
+            ORCM_SUCCESS != (rc = orcm_analytics_base_parse_stat(stats[i], stat_names,
+                                                                 ORCM_ANALYTICS_AGGREGATE_QUANTILE,
+                                                                 &stat, &percent))) {
+            rc = ORCM_ERR_BAD_PARAM;
+            break;
+        }
+        c = &mod->compute[mod->ncompute];
+        c->stat = (orcm_analytics_aggregate_stat_t)stat;
+        c->quantile = percent / 100.0;
+        if (ORCM_ANALYTICS_AGGREGATE_QUANTILE == c->stat) {
+            mod->need_sketch = true;
+        }
+        c->name = strdup(stats[i]);
+        mod->ncompute++;
+    }
+    opal_argv_free(stats);
+    return rc;
+}
+
+static int configure(mca_analytics_aggregate_module_t *mod, orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+    int rc;
+
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL == attr->key || NULL == attr->data.string) {
+            continue;
+        }
+        rc = ORCM_SUCCESS;
+        if (0 == strcmp(attr->key, "name")) {
+            free(mod->name);
+            mod->name = strdup(attr->data.string);
+        } else if (0 == strcmp(attr->key, "forward")) {
+            if (0 == strcmp(attr->data.string, "yes")) {
+                mod->forward = true;
+            } else if (0 != strcmp(attr->data.string, "no")) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "compute")) {
+            rc = parse_compute(mod, attr->data.string);
+        } else if (0 == strcmp(attr->key, "group")) {
+            free(mod->group);
+            mod->group = strdup(attr->data.string);
+        } else if (0 == strcmp(attr->key, "period")) {
+            rc = orcm_analytics_base_parse_period(attr->data.string, false, &mod->period);
+        } else if (0 == strcmp(attr->key, "accuracy")) {
+            mod->accuracy = strtod(attr->data.string, NULL);
+            if (0.0 >= mod->accuracy || 0.5 <= mod->accuracy) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "max_bins")) {
+            mod->max_bins = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= mod->max_bins || AGGREGATE_MAX_BINS < mod->max_bins) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        }
+        if (ORCM_SUCCESS != rc) {
+            opal_output(0, "%s analytics:aggregate: bad value %s for attribute %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        attr->data.string, attr->key);
+            return rc;
+        }
+    }
+    if (0 == mod->ncompute &&
+        ORCM_SUCCESS != (rc = parse_compute(mod, AGGREGATE_DEFAULT_COMPUTE))) {
+        return rc;
+    }
+    if (NULL == mod->name) {
+        mod->name = strdup(AGGREGATE_DEFAULT_NAME);
+    }
+    if (NULL == mod->group) {
+        mod->group = strdup((NULL != orte_process_info.nodename) ?
+                            orte_process_info.nodename : mod->name);
+    }
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:aggregate: %s for %s every %g sec, %s, "
+                         "%d statistics", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                         mod->name, mod->group, mod->period,
+                         mod->forward ? "forwarded" : "emitted", mod->ncompute));
+    mod->configured = true;
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_aggregate_state_t* get_state(mca_analytics_aggregate_module_t *mod,
+                                                   const char *sensor, int index,
+                                                   const char *label, const char *units)
+{
+    orcm_analytics_aggregate_state_t *st;
+    char name[AGGREGATE_KEY_MAX];
+    uint32_t id;
+    int i;
+
+    id = orcm_analytics_base_key_intern(mod->group, sensor, index, label, units);
+    if (ORCM_ANALYTICS_KEY_INVALID == id) {
+        return NULL;
+    }
+    st = (orcm_analytics_aggregate_state_t*)opal_pointer_array_get_item(&mod->states, (int)id);
+    if (NULL != st) {
+        return st;
+    }
+
+    st = OBJ_NEW(orcm_analytics_aggregate_state_t);
+    st->key_id = id;
+    /* intern the keys of the emitted statistics once, here */
+    if (!mod->forward) {
+        for (i=0; i < mod->ncompute; i++) {
+            snprintf(name, sizeof(name), "%s %s", label, mod->compute[i].name);
+            st->out_ids[i] = orcm_analytics_base_key_intern(mod->group, sensor,
+                                                            index, name, units);
+        }
+    }
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&mod->states, (int)id, st)) {
+        OBJ_RELEASE(st);
+        return NULL;
+    }
+    return st;
+}
+
+static orcm_analytics_aggregate_node_t* get_node(mca_analytics_aggregate_module_t *mod,
+                                                 orcm_analytics_value_t *value)
+{
+    orcm_analytics_aggregate_node_t *node;
+    orcm_analytics_key_t *key;
+
+    node = (orcm_analytics_aggregate_node_t*)opal_pointer_array_get_item(&mod->nodes,
+                                                                        (int)value->key_id);
+    if (NULL != node) {
+        return node;
+    }
+    if (NULL == (key = orcm_analytics_base_key_get(value->key_id))) {
+        return NULL;
+    }
+    node = OBJ_NEW(orcm_analytics_aggregate_node_t);
+    node->state = get_state(mod, key->sensor_name, key->index, key->label, key->units);
+    if (NULL == node->state) {
+        OBJ_RELEASE(node);
+        return NULL;
+    }
+    OBJ_RETAIN(node->state);
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&mod->nodes, (int)value->key_id, node)) {
+        OBJ_RELEASE(node);
+        return NULL;
+    }
+    return node;
+}
+
+static void emit(mca_analytics_aggregate_module_t *mod, orcm_analytics_aggregate_state_t *st,
+                 orcm_analytics_aggregate_partial_t *p, opal_value_array_t *results)
+{
+    orcm_analytics_value_t out;
+    double x = 0.0;
+    int i;
+
+    for (i=0; i < mod->ncompute; i++) {
+        switch (mod->compute[i].stat) {
+        case ORCM_ANALYTICS_AGGREGATE_TOTAL:
+            x = p->total;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_SUM:
+            x = p->sum;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_MIN:
+            x = p->min;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_MAX:
+            x = p->max;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_COUNT:
+            x = (double)p->count;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_MEAN:
+            x = p->sum / (double)p->count;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_NODES:
+            x = (double)p->nodes;
+            break;
+        case ORCM_ANALYTICS_AGGREGATE_QUANTILE:
+            if (NULL == p->sketch || 0 == p->sketch->count) {
+                continue;
+            }
+            x = orcm_analytics_base_sketch_quantile(p->sketch, mod->compute[i].quantile);
+            break;
+        }
+
+        memset(&out, 0, sizeof(out));
+        if (ORCM_SUCCESS != orcm_analytics_base_value_set_key(&out, st->out_ids[i])) {
+            continue;
+        }
+        out.comma_sep_plugin_list = "aggregate";
+        out.data.value.type = OPAL_DOUBLE;
+        out.data.value.data.dval = x;
+        orcm_analytics_base_to_timeval((double)p->period * mod->period, &out.start_time);
+        orcm_analytics_base_to_timeval((double)(p->period + 1) * mod->period, &out.end_time);
+        out.measured = false;
+        opal_value_array_append_item(results, &out);
+    }
+}
+
+/* a partial is sent as the (sensor, index, label, units) it is for, the
+ * start of its period and its values */
+static int pack_partial(mca_analytics_aggregate_module_t *mod,
+                        orcm_analytics_aggregate_state_t *st,
+                        orcm_analytics_aggregate_partial_t *p)
+{
+    orcm_analytics_key_t *key;
+    double start;
+    bool has_sketch;
+    int rc;
+
+    if (NULL == (key = orcm_analytics_base_key_get(st->key_id))) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    if (NULL == mod->pending) {
+        mod->pending = OBJ_NEW(opal_buffer_t);
+        mod->npending = 0;
+    }
+    start = (double)p->period * mod->period;
+    has_sketch = (NULL != p->sketch);
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &key->sensor_name, 1, OPAL_STRING)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &key->index, 1, OPAL_INT)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &key->label, 1, OPAL_STRING)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &key->units, 1, OPAL_STRING)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &start, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->count, 1, OPAL_UINT64)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->sum, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->min, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->max, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->total, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &p->nodes, 1, OPAL_UINT64)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(mod->pending, &has_sketch, 1, OPAL_BOOL)) ||
+        (has_sketch &&
+         OPAL_SUCCESS != (rc = orcm_analytics_base_sketch_pack(mod->pending, p->sketch)))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    mod->npending++;
+    return ORCM_SUCCESS;
+}
+
+static void close_slot(mca_analytics_aggregate_module_t *mod,
+                       orcm_analytics_aggregate_state_t *st,
+                       orcm_analytics_aggregate_partial_t *p,
+                       opal_value_array_t *results)
+{
+    if (0 < p->count) {
+        if (mod->forward) {
+            (void)pack_partial(mod, st, p);
+        } else {
+            emit(mod, st, p, results);
+        }
+    }
+    p->period = -1;
+}
+
+/* the slot of the period, closing those two periods or more behind -
+ * NULL if the period is closed already */
+static orcm_analytics_aggregate_partial_t* open_slot(mca_analytics_aggregate_module_t *mod,
+                                                     orcm_analytics_aggregate_state_t *st,
+                                                     int64_t period,
+                                                     opal_value_array_t *results)
+{
+    orcm_analytics_aggregate_partial_t *p;
+    int i;
+
+    for (i=0; i < ORCM_ANALYTICS_AGGREGATE_SLOTS; i++) {
+        p = &st->slots[i];
+        if (0 <= p->period && p->period + ORCM_ANALYTICS_AGGREGATE_SLOTS <= period) {
+            close_slot(mod, st, p, results);
+        }
+    }
+
+    p = &st->slots[period % ORCM_ANALYTICS_AGGREGATE_SLOTS];
+    if (p->period == period) {
+        return p;
+    }
+    if (0 <= p->period) {
+        /* a newer period has the slot */
+        mod->late++;
+        return NULL;
+    }
+    p->period = period;
+    p->count = 0;
+    p->sum = 0.0;
+    p->min = 0.0;
+    p->max = 0.0;
+    p->total = 0.0;
+    p->nodes = 0;
+    if (mod->need_sketch) {
+        if (NULL == p->sketch) {
+            p->sketch = OBJ_NEW(orcm_analytics_sketch_t);
+            if (ORCM_SUCCESS != orcm_analytics_base_sketch_init(p->sketch, mod->accuracy,
+                                                                mod->max_bins)) {
+                OBJ_RELEASE(p->sketch);
+            }
+        } else {
+            orcm_analytics_base_sketch_reset(p->sketch);
+        }
+    }
+    return p;
+}
+
+static void aggregate_sample(mca_analytics_aggregate_module_t *mod,
+                             orcm_analytics_aggregate_node_t *node,
+                             opal_value_array_t *results, double x, double t)
+{
+    orcm_analytics_aggregate_partial_t *p;
+    int64_t period;
+    double mean = 0.0;
+    int s;
+
+    if (0.0 > t) {
+        return;
+    }
+    period = (int64_t)floor(t / mod->period);
+    if (NULL == (p = open_slot(mod, node->state, period, results))) {
+        return;
+    }
+
+    if (0 == p->count || x < p->min) {
+        p->min = x;
+    }
+    if (0 == p->count || x > p->max) {
+        p->max = x;
+    }
+    p->count++;
+    p->sum += x;
+    if (NULL != p->sketch) {
+        orcm_analytics_base_sketch_add(p->sketch, x);
+    }
+
+    /* the total moves by the change of the mean of the node */
+    s = (int)(period % ORCM_ANALYTICS_AGGREGATE_SLOTS);
+    if (node->period[s] != period) {
+        node->period[s] = period;
+        node->count[s] = 0;
+        node->sum[s] = 0.0;
+        p->nodes++;
+    } else {
+        mean = node->sum[s] / (double)node->count[s];
+    }
+    node->count[s]++;
+    node->sum[s] += x;
+    p->total += node->sum[s] / (double)node->count[s] - mean;
+}
+
+static int merge_partials(mca_analytics_aggregate_module_t *mod, opal_buffer_t *buffer,
+                          opal_value_array_t *results)
+{
+    orcm_analytics_aggregate_partial_t *p, in;
+    orcm_analytics_aggregate_state_t *st;
+    orcm_analytics_sketch_t *sketch;
+    char *sensor, *label, *units;
+    double start;
+    bool has_sketch;
+    int32_t i, npartials, n = 1;
+    int index, rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &npartials, &n, OPAL_INT32))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    for (i=0; i < npartials; i++) {
+        sensor = label = units = NULL;
+        sketch = NULL;
+        has_sketch = false;
+        if ((n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sensor, &n, OPAL_STRING))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &index, &n, OPAL_INT))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &label, &n, OPAL_STRING))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &units, &n, OPAL_STRING))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &start, &n, OPAL_DOUBLE))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.count, &n, OPAL_UINT64))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.sum, &n, OPAL_DOUBLE))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.min, &n, OPAL_DOUBLE))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.max, &n, OPAL_DOUBLE))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.total, &n, OPAL_DOUBLE))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &in.nodes, &n, OPAL_UINT64))) ||
+            (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &has_sketch, &n, OPAL_BOOL))) ||
+            (has_sketch &&
+             OPAL_SUCCESS != (rc = orcm_analytics_base_sketch_unpack(buffer, &sketch)))) {
+            ORTE_ERROR_LOG(rc);
+            free(sensor);
+            free(label);
+            free(units);
+            return rc;
+        }
+
+        st = get_state(mod, sensor, index, label, units);
+        free(sensor);
+        free(label);
+        free(units);
+        p = NULL;
+        if (NULL != st && 0 < in.count && 0.0 <= start) {
+            /* allow for the rounding of the start of the period */
+            p = open_slot(mod, st, (int64_t)floor(start / mod->period + 1e-9), results);
+        }
+        if (NULL != p) {
+            if (0 == p->count || in.min < p->min) {
+                p->min = in.min;
+            }
+            if (0 == p->count || in.max > p->max) {
+                p->max = in.max;
+            }
+            p->count += in.count;
+            p->sum += in.sum;
+            p->total += in.total;
+            p->nodes += in.nodes;
+            if (NULL != p->sketch && NULL != sketch &&
+                ORCM_SUCCESS != orcm_analytics_base_sketch_merge(p->sketch, sketch)) {
+                OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                                     "%s analytics:aggregate:%s sketch of another accuracy",
+                                     ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), mod->name));
+            }
+        }
+        if (NULL != sketch) {
+            OBJ_RELEASE(sketch);
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/* send the partials closed by this data up */
+static void flush(mca_analytics_aggregate_module_t *mod, orcm_workflow_t *wf)
+{
+    opal_buffer_t *buffer;
+    int rc;
+
+    if (NULL == mod->pending || 0 == mod->npending) {
+        return;
+    }
+    buffer = OBJ_NEW(opal_buffer_t);
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &mod->npending, 1, OPAL_INT32)) ||
+        OPAL_SUCCESS != (rc = opal_dss.copy_payload(buffer, mod->pending))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buffer);
+    } else {
+        (void)orcm_analytics_base_aggregate_forward(wf, mod->name, buffer);
+    }
+    OBJ_RELEASE(mod->pending);
+    mod->npending = 0;
+}
+
+static int analyze(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t *)cbdata;
+    mca_analytics_aggregate_module_t *mod;
+    orcm_analytics_aggregate_node_t *node;
+    orcm_analytics_value_t *value;
+    opal_value_array_t *results = NULL;
+    struct timeval now;
+    double x, t;
+    size_t index, size;
+    int rc;
+
+    if (NULL == caddy) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:aggregate:NULL caddy data passed by the previous workflow step",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_aggregate_module_t*)caddy->imod;
+
+    if (!mod->configured && ORCM_SUCCESS != (rc = configure(mod, caddy->wf_step))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_step_array(caddy->wf_step, &results, 0))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    if (OBJ_CLASS(orcm_analytics_partials_t) == ((opal_object_t*)caddy->data)->obj_class) {
+        /* partials of the steps below */
+        (void)merge_partials(mod, ((orcm_analytics_partials_t*)caddy->data)->buffer, results);
+    } else {
+        size = opal_value_array_get_size(caddy->data);
+        now.tv_sec = 0;
+        for (index=0; index < size; index++) {
+            value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, index);
+            if (NULL == value || ORCM_ANALYTICS_KEY_INVALID == value->key_id ||
+                !orcm_analytics_base_value_to_double(&value->data.value, &x)) {
+                continue;
+            }
+            /* samples are placed at the end of the time they cover */
+            if (0 != value->end_time.tv_sec) {
+                t = value->end_time.tv_sec + value->end_time.tv_usec / 1000000.0;
+            } else {
+                if (0 == now.tv_sec) {
+                    gettimeofday(&now, NULL);
+                }
+                t = now.tv_sec + now.tv_usec / 1000000.0;
+            }
+            if (NULL == (node = get_node(mod, value))) {
+                OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                                     "%s analytics:aggregate:no state for %s:%s",
+                                     ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                     value->node_regex, value->sensor_name));
+                continue;
+            }
+            aggregate_sample(mod, node, results, x, t);
+        }
+    }
+
+    if (mod->forward) {
+        flush(mod, caddy->wf);
+    }
+    if (0 < opal_value_array_get_size(results)) {
+        /* load data to database if needed */
+        orcm_analytics_base_store(caddy->wf, caddy->wf_step, results);
+        ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(caddy->wf, caddy->wf_step, results);
+    } else {
+        OBJ_RELEASE(results);
+    }
+    OBJ_RELEASE(caddy);
+
+    return ORCM_SUCCESS;
+}
+
+/* close the open periods, oldest first, as the workflow stops */
+static void flush_open(orcm_analytics_base_module_t *imod, orcm_workflow_t *wf,
+                       orcm_workflow_step_t *wf_step)
+{
+    mca_analytics_aggregate_module_t *mod = (mca_analytics_aggregate_module_t*)imod;
+    orcm_analytics_aggregate_state_t *st;
+    orcm_analytics_aggregate_partial_t *p;
+    opal_value_array_t *results = NULL;
+    int i, j, rc;
+
+    if (!mod->configured) {
+        return;
+    }
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_step_array(wf_step, &results, 0))) {
+        ORTE_ERROR_LOG(rc);
+        return;
+    }
+    for (i=0; i < mod->states.size; i++) {
+        st = (orcm_analytics_aggregate_state_t*)opal_pointer_array_get_item(&mod->states, i);
+        if (NULL == st) {
+            continue;
+        }
+        do {
+            p = NULL;
+            for (j=0; j < ORCM_ANALYTICS_AGGREGATE_SLOTS; j++) {
+                if (0 <= st->slots[j].period &&
+                    (NULL == p || st->slots[j].period < p->period)) {
+                    p = &st->slots[j];
+                }
+            }
+            if (NULL != p) {
+                close_slot(mod, st, p, results);
+            }
+        } while (NULL != p);
+    }
+
+    if (mod->forward) {
+        flush(mod, wf);
+    }
+    if (0 < opal_value_array_get_size(results)) {
+        orcm_analytics_base_store(wf, wf_step, results);
+    }
+    OBJ_RELEASE(results);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ *
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ */
+
+#ifndef MCA_analytics_aggregate_EXPORT_H
+#define MCA_analytics_aggregate_EXPORT_H
+
+#include "orcm_config.h"
+
+#include "opal/class/opal_pointer_array.h"
+#include "opal/dss/dss_types.h"
+
+#include "orcm/mca/analytics/analytics.h"
+
+BEGIN_C_DECLS
+
+/*
+ * Local Component structures
+ */
+
+ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_aggregate_component;
+
+/* statistics of the partial aggregates of a period */
+typedef enum {
+    ORCM_ANALYTICS_AGGREGATE_TOTAL,
+    ORCM_ANALYTICS_AGGREGATE_SUM,
+    ORCM_ANALYTICS_AGGREGATE_MIN,
+    ORCM_ANALYTICS_AGGREGATE_MAX,
+    ORCM_ANALYTICS_AGGREGATE_COUNT,
+    ORCM_ANALYTICS_AGGREGATE_MEAN,
+    ORCM_ANALYTICS_AGGREGATE_NODES,
+    ORCM_ANALYTICS_AGGREGATE_QUANTILE
+} orcm_analytics_aggregate_stat_t;
+
+#define ORCM_ANALYTICS_AGGREGATE_MAX_STATS 8
+
+/* periods open at a time - samples of older ones are dropped */
+#define ORCM_ANALYTICS_AGGREGATE_SLOTS 2
+
+typedef struct {
+    orcm_analytics_aggregate_stat_t stat;
+    double quantile;
+    char *name;
+} orcm_analytics_aggregate_compute_t;
+
+/* what the samples of a period reduce to, and what is sent up */
+typedef struct {
+    int64_t period;             /* -1 if the slot is free */
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+    double total;               /* sum of the means of the nodes */
+    uint64_t nodes;
+    orcm_analytics_sketch_t *sketch;
+} orcm_analytics_aggregate_partial_t;
+
+/* a (sensor, label) aggregated over the nodes below */
+typedef struct {
+    opal_object_t super;
+    /* interned (group, sensor, index, label) */
+    uint32_t key_id;
+    /* interned key of each statistic emitted */
+    uint32_t out_ids[ORCM_ANALYTICS_AGGREGATE_MAX_STATS];
+    orcm_analytics_aggregate_partial_t slots[ORCM_ANALYTICS_AGGREGATE_SLOTS];
+} orcm_analytics_aggregate_state_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_aggregate_state_t);
+
+/* the samples of one (node, sensor, label) in the open periods, for
+ * the mean of the node */
+typedef struct {
+    opal_object_t super;
+    orcm_analytics_aggregate_state_t *state;
+    int64_t period[ORCM_ANALYTICS_AGGREGATE_SLOTS];
+    uint64_t count[ORCM_ANALYTICS_AGGREGATE_SLOTS];
+    double sum[ORCM_ANALYTICS_AGGREGATE_SLOTS];
+} orcm_analytics_aggregate_node_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_aggregate_node_t);
+
+typedef struct {
+    orcm_analytics_base_module_t api;
+    /* aggregation, taken from the workflow step attributes */
+    bool configured;
+    char *name;
+    char *group;
+    double period;
+    bool forward;
+    bool need_sketch;
+    double accuracy;
+    int max_bins;
+    int ncompute;
+    orcm_analytics_aggregate_compute_t compute[ORCM_ANALYTICS_AGGREGATE_MAX_STATS];
+    /* states by interned group key id, and nodes by the key id of
+     * their samples */
+    opal_pointer_array_t states;
+    opal_pointer_array_t nodes;
+    /* closed partials not sent up yet */
+    opal_buffer_t *pending;
+    int32_t npending;
+    uint64_t late;
+} mca_analytics_aggregate_module_t;
+ORCM_DECLSPEC extern mca_analytics_aggregate_module_t orcm_analytics_aggregate_module;
+
+END_C_DECLS
+
+#endif /* MCA_analytics_aggregate_EXPORT_H */
@@ -35,12 +35,19 @@ typedef void (*orcm_analytics_base_module_finalize_fn_t)(orcm_analytics_base_mod
 /* do the real work in the selected module */
 typedef int (*orcm_analytics_base_module_analyze_fn_t)(int fd, short args, void* cb);
 
+/* hand on what the module holds back - its workflow is stopping and no
+ * more data will come. Optional */
+typedef void (*orcm_analytics_base_module_flush_fn_t)(orcm_analytics_base_module_t *mod,
+                                                       orcm_workflow_t *wf,
+                                                       orcm_workflow_step_t *wf_step);
+
 
 struct orcm_analytics_base_module {
     orcm_analytics_base_module_init_fn_t        init;
     orcm_analytics_base_module_finalize_fn_t    finalize;
     orcm_analytics_base_module_analyze_fn_t     analyze;
     opal_hash_table_t*                          orcm_mca_analytics_hash_table;
+    orcm_analytics_base_module_flush_fn_t       flush;
 };
 
 
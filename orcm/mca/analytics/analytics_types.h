@@ -20,12 +20,17 @@
 #include "opal/class/opal_object.h"
 #include "opal/class/opal_value_array.h"
 #include "opal/class/opal_list.h"
+#include "opal/dss/dss_types.h"
 #include "opal/mca/event/event.h"
+#include "opal/threads/mutex.h"
+#include "opal/threads/threads.h"
 #include "orcm/runtime/orcm_globals.h"
 
 BEGIN_C_DECLS
 
 struct orcm_analytics_base_module;
+struct orcm_analytics_base_db_buffer;
+struct orcm_workflow_caddy;
 
 typedef struct orcm_analytics_base_module orcm_analytics_base_module_t;
 
@@ -37,6 +42,14 @@ typedef struct {
     opal_list_t attributes;
     char *analytic;
     orcm_analytics_base_module_t *mod;
+    /* results waiting to be stored, if the step stores them */
+    struct orcm_analytics_base_db_buffer *db_buffer;
+    /* run in the same call as the previous step (see the fusion pass
+     * in analytics_base_fuse.c), with the caddy and output array it
+     * keeps for that */
+    bool fused;
+    struct orcm_workflow_caddy *caddy;
+    opal_value_array_t *output;
 } orcm_workflow_step_t;
 OBJ_CLASS_DECLARATION(orcm_workflow_step_t);
 
@@ -48,13 +61,22 @@ typedef struct {
     opal_list_t steps;
     opal_event_base_t *ev_base;
     bool ev_active;
+    /* steps waiting for the analytics executor, in order - a workflow
+     * is queued on or run by at most one executor worker at a time */
+    opal_mutex_t lock;
+    opal_list_t tasks;
+    bool scheduled;
+    int worker;
+    /* the executor thread running a step of the workflow, if any */
+    opal_thread_t *runner;
 } orcm_workflow_t;
 OBJ_CLASS_DECLARATION(orcm_workflow_t);
 
 /* define a workflow caddy object */
-typedef struct {
-    opal_object_t super;
+typedef struct orcm_workflow_caddy {
+    opal_list_item_t super;
     opal_event_t ev;
+    uint64_t queued; /* usec */
     orcm_workflow_step_t *wf_step;
     orcm_workflow_t    *wf;
     opal_value_array_t *data;
@@ -62,9 +84,27 @@ typedef struct {
 } orcm_workflow_caddy_t;
 OBJ_CLASS_DECLARATION(orcm_workflow_caddy_t);
 
-/* define a orcm_analytics_value_t object */
+/* define an interned key object - every (node, sensor, index, label)
+ * seen by analytics is given a stable id the first time it is seen,
+ * and keeps the one copy of its strings */
+typedef struct {
+    opal_object_t  super;
+    uint32_t       id;
+    char           *node_regex;
+    char           *sensor_name;
+    int            index;
+    char           *label;
+    char           *units;
+} orcm_analytics_key_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_key_t);
+
+#define ORCM_ANALYTICS_KEY_INVALID UINT32_MAX
+
+/* define a orcm_analytics_value_t object - the strings of a value
+ * belong to its interned key (or are constants), never to the value */
 typedef struct {
     opal_object_t  super;
+    uint32_t       key_id; /*id of the interned key of this data*/
     orcm_metric_value_t data;  /*data*/
     char           *comma_sep_plugin_list; /*comma separated list of plugins that contributed to this data*/
     char           *sensor_name; /*name of the actual sensor*/
@@ -75,6 +115,42 @@ typedef struct {
 } orcm_analytics_value_t;
 OBJ_CLASS_DECLARATION(orcm_analytics_value_t);
 
+/* the buckets of one sign of a sketch - bucket i counts the values
+ * in (gamma^(i-1), gamma^i], counts[0] being bucket offset */
+typedef struct {
+    int offset;
+    int nbins;
+    uint64_t *counts;
+} orcm_analytics_sketch_store_t;
+
+/* define a quantile sketch - a log histogram of relative accuracy
+ * accuracy, bounded to max_bins buckets per sign, that sketches of the
+ * same accuracy can be merged into */
+typedef struct {
+    opal_object_t super;
+    double accuracy;
+    double gamma;
+    double log_gamma;
+    int max_bins;
+    orcm_analytics_sketch_store_t positive;
+    orcm_analytics_sketch_store_t negative;
+    uint64_t zero;
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+} orcm_analytics_sketch_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_sketch_t);
+
+/* define the partial aggregates sent up by an aggregate step to the
+ * one of the same name above it - handed to that step as its data,
+ * the partials being in the buffer, not in the (empty) array */
+typedef struct {
+    opal_value_array_t super;
+    opal_buffer_t *buffer;
+} orcm_analytics_partials_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_partials_t);
+
 /* define a few commands */
 typedef uint8_t orcm_analytics_cmd_flag_t;
 #define ORCM_ANALYTICS_CMD_T OPAL_UINT8
@@ -83,7 +159,9 @@ typedef enum {
     ORCM_ANALYTICS_WORKFLOW_CREATE = 1,
     ORCM_ANALYTICS_WORKFLOW_DELETE,
     ORCM_ANALYTICS_WORKFLOW_LIST,
-    ORCM_ANALYTICS_WORFLOW_ERROR
+    ORCM_ANALYTICS_WORFLOW_ERROR,
+    ORCM_ANALYTICS_EXECUTOR_STATS,
+    ORCM_ANALYTICS_AGGREGATE
 }orcm_analytics_workflow_commands;
 
 END_C_DECLS
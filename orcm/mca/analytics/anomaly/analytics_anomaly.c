@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/evgen/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "analytics_anomaly.h"
+
+/*
+ * Anomaly operator
+ *
+ * Keeps an exponentially weighted mean and variance of the samples of
+ * each (node, sensor, label) and flags the samples too many standard
+ * deviations away from the mean - a fan slowing down or a core warming
+ * up faster than it ever did, well before a fixed limit is reached.
+ * Optionally, a seasonal baseline (e.g. the time of day) is taken off
+ * the samples first, learnt the same way for each bin of the season.
+ *
+ * The state of a key is a few bytes kept by value in an array indexed
+ * by its interned key id, plus a float per bin of the season, so memory
+ * does not grow with time and a million series take tens of MB. An
+ * outlier only moves the mean as far as the limit, so that a spike does
+ * not mask what follows, while a lasting shift is slowly taken in; and
+ * the variance only learns from the samples within the clear level, so
+ * that a drift still stands out of it. A drift is seen once the mean
+ * lags it by z deviations - a drift of more than about alpha * z
+ * deviations per sample.
+ *
+ * As with the threshold step, a key is raised once count consecutive
+ * samples are outliers on the same side, and cleared once a sample is
+ * back within clear deviations; an orcm_ras_event_t is generated on
+ * each of these transitions only. The step attributes:
+ *
+ *    alpha=<a>                  weight of a new sample, default 0.05
+ *    z=<k>                      deviations making an outlier, default 4
+ *    clear=<k>                  deviations clearing a key, default 2
+ *    min_sd=<v>                 least deviation assumed, for series that
+ *                               barely move, default 0
+ *    warmup=<n>                 samples learnt before flagging any,
+ *                               default 30
+ *    count=<n>                  consecutive outliers, default 1
+ *    severity=<level>           of the raised events, default warning
+ *    season=<n>[s|m|h]          length of the season, default none
+ *    bins=<n>                   bins of the season, default 24
+ *    gamma=<g>                  weight of a new sample in its bin,
+ *                               default 0.1
+ *
+ * The samples are passed on unchanged to the next step.
+ */
+
+#define ANOMALY_DEFAULT_ALPHA   0.05
+#define ANOMALY_DEFAULT_Z       4.0
+#define ANOMALY_DEFAULT_CLEAR   2.0
+#define ANOMALY_DEFAULT_WARMUP  30
+#define ANOMALY_DEFAULT_BINS    24
+#define ANOMALY_MAX_BINS        4096
+#define ANOMALY_DEFAULT_GAMMA   0.1
+#define ANOMALY_MAX_COUNT       255
+#define ANOMALY_STATES_INIT     1024
+
+static int init(orcm_analytics_base_module_t *imod);
+static void finalize(orcm_analytics_base_module_t *imod);
+static int analyze(int sd, short args, void *cbdata);
+
+mca_analytics_anomaly_module_t orcm_analytics_anomaly_module = {
+    {
+        init,
+        finalize,
+        analyze,
+        NULL
+    }
+};
+
+static int init(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_anomaly_module_t *mod;
+
+    if (NULL == imod) {
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_anomaly_module_t*)imod;
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    mod->configured = false;
+    mod->alpha = ANOMALY_DEFAULT_ALPHA;
+    mod->z = ANOMALY_DEFAULT_Z;
+    mod->clear_z = ANOMALY_DEFAULT_CLEAR;
+    mod->min_sd = 0.0;
+    mod->var_scale = 1.0;
+    mod->warmup = ANOMALY_DEFAULT_WARMUP;
+    mod->count = 1;
+    mod->severity = ORCM_RAS_SEVERITY_WARNING;
+    mod->season = 0.0;
+    mod->bins = 0;
+    mod->gamma = ANOMALY_DEFAULT_GAMMA;
+    mod->states = NULL;
+    mod->seasons = NULL;
+    mod->nstates = 0;
+    mod->nseries = 0;
+    mod->raised = 0;
+    mod->cleared = 0;
+    return ORCM_SUCCESS;
+}
+
+static void finalize(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_anomaly_module_t *mod;
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:anomaly:finalize",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+    if (NULL == imod) {
+        return;
+    }
+    mod = (mca_analytics_anomaly_module_t*)imod;
+    free(mod->states);
+    free(mod->seasons);
+    free(mod);
+}
+
+static int parse_float(const char *str, float *x, float min, float max)
+{
+    char *end;
+
+    *x = strtof(str, &end);
+    if (end == str || '\0' != *end || min > *x || max < *x) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    return ORCM_SUCCESS;
+}
+
+static int parse_severity(const char *str, int *severity)
+{
+    static const char *names[] = {"emerg", "fatal", "alert", "crit", "error",
+                                  "warning", "notice", "info", NULL};
+    static const int levels[] = {ORCM_RAS_SEVERITY_EMERG, ORCM_RAS_SEVERITY_FATAL,
+                                 ORCM_RAS_SEVERITY_ALERT, ORCM_RAS_SEVERITY_CRIT,
+                                 ORCM_RAS_SEVERITY_ERROR, ORCM_RAS_SEVERITY_WARNING,
+                                 ORCM_RAS_SEVERITY_NOTICE, ORCM_RAS_SEVERITY_INFO};
+    int i;
+
+    for (i=0; NULL != names[i]; i++) {
+        if (0 == strncasecmp(str, names[i], strlen(names[i]))) {
+            *severity = levels[i];
+            return ORCM_SUCCESS;
+        }
+    }
+    return ORCM_ERR_BAD_PARAM;
+}
+
+static int configure(mca_analytics_anomaly_module_t *mod, orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+    double c;
+    long n;
+    int rc, bins = ANOMALY_DEFAULT_BINS;
+
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL == attr->key || NULL == attr->data.string) {
+            continue;
+        }
+        rc = ORCM_SUCCESS;
+        if (0 == strcmp(attr->key, "alpha")) {
+            rc = parse_float(attr->data.string, &mod->alpha, 1e-6, 1.0);
+        } else if (0 == strcmp(attr->key, "z")) {
+            rc = parse_float(attr->data.string, &mod->z, 0.0, INFINITY);
+        } else if (0 == strcmp(attr->key, "clear")) {
+            rc = parse_float(attr->data.string, &mod->clear_z, 1e-3, INFINITY);
+        } else if (0 == strcmp(attr->key, "min_sd")) {
+            rc = parse_float(attr->data.string, &mod->min_sd, 0.0, INFINITY);
+        } else if (0 == strcmp(attr->key, "warmup")) {
+            n = strtol(attr->data.string, NULL, 10);
+            if (0 > n) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+            mod->warmup = (uint32_t)n;
+        } else if (0 == strcmp(attr->key, "count")) {
+            mod->count = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= mod->count || ANOMALY_MAX_COUNT < mod->count) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "severity")) {
+            rc = parse_severity(attr->data.string, &mod->severity);
+        } else if (0 == strcmp(attr->key, "season")) {
+            rc = orcm_analytics_base_parse_period(attr->data.string, false, &mod->season);
+        } else if (0 == strcmp(attr->key, "bins")) {
+            bins = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= bins || ANOMALY_MAX_BINS < bins) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "gamma")) {
+            rc = parse_float(attr->data.string, &mod->gamma, 0.0, 1.0);
+        }
+        if (ORCM_SUCCESS != rc) {
+            opal_output(0, "%s analytics:anomaly: bad value %s for attribute %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        attr->data.string, attr->key);
+            return rc;
+        }
+    }
+    if (mod->clear_z > mod->z) {
+        mod->clear_z = mod->z;
+    }
+    /* the variance of normal samples within the clear level is less than
+     * that of all of them - by this much */
+    c = mod->clear_z;
+    mod->var_scale = 1.0 / (1.0 - 2.0 * c * exp(-0.5 * c * c) / sqrt(2.0 * M_PI) /
+                            erf(c / sqrt(2.0)));
+    if (0.0 < mod->season) {
+        mod->bins = bins;
+    }
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:anomaly: alpha %g, outliers past %g deviations, "
+                         "cleared within %g, %d bins of a %g sec season",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), mod->alpha, mod->z,
+                         mod->clear_z, mod->bins, mod->season));
+    mod->configured = true;
+    return ORCM_SUCCESS;
+}
+
+/* the state of a key, the arrays growing to take it */
+static orcm_analytics_anomaly_state_t* get_state(mca_analytics_anomaly_module_t *mod,
+                                                 uint32_t key_id)
+{
+    orcm_analytics_anomaly_state_t *states;
+    float *seasons;
+    int size;
+
+    if ((int)key_id >= mod->nstates) {
+        size = (0 == mod->nstates) ? ANOMALY_STATES_INIT : mod->nstates;
+        while (size <= (int)key_id) {
+            size *= 2;
+        }
+        states = (orcm_analytics_anomaly_state_t*)realloc(mod->states,
+                                                          size * sizeof(*states));
+        if (NULL == states) {
+            return NULL;
+        }
+        memset(&states[mod->nstates], 0, (size - mod->nstates) * sizeof(*states));
+        mod->states = states;
+        if (0 < mod->bins) {
+            seasons = (float*)realloc(mod->seasons, (size_t)size * mod->bins * sizeof(float));
+            if (NULL == seasons) {
+                return NULL;
+            }
+            memset(&seasons[(size_t)mod->nstates * mod->bins], 0,
+                   (size_t)(size - mod->nstates) * mod->bins * sizeof(float));
+            mod->seasons = seasons;
+        }
+        mod->nstates = size;
+    }
+    return &mod->states[key_id];
+}
+
+static void generate_event(mca_analytics_anomaly_module_t *mod,
+                           orcm_analytics_anomaly_state_t *st, uint32_t key_id,
+                           float x, float expected, float z, time_t t)
+{
+    orcm_analytics_key_t *key = orcm_analytics_base_key_get(key_id);
+    orcm_ras_event_t *ev;
+
+    if (NULL == key) {
+        return;
+    }
+    if (ORCM_ANALYTICS_ANOMALY_NORMAL == st->level) {
+        mod->cleared++;
+    } else {
+        mod->raised++;
+    }
+    opal_output_verbose(1, orcm_analytics_base_framework.framework_output,
+                        "%s analytics:anomaly: %s:%s:%s %s at %g (expected %g, z %.1f)",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        key->node_regex, key->sensor_name, key->label,
+                        (ORCM_ANALYTICS_ANOMALY_HIGH == st->level) ? "high" :
+                        (ORCM_ANALYTICS_ANOMALY_LOW == st->level) ? "low" : "cleared",
+                        x, expected, z);
+    if (NULL == orcm_evgen_evbase) {
+        /* no event generator in this process */
+        return;
+    }
+
+    ev = OBJ_NEW(orcm_ras_event_t);
+    ev->type = ORCM_RAS_EVENT_SENSOR;
+    ev->timestamp = t;
+    ev->severity = (ORCM_ANALYTICS_ANOMALY_NORMAL == st->level) ?
+                   ORCM_RAS_SEVERITY_INFO : mod->severity;
+    ORCM_RAS_REPORTER(ev, ORCM_LOC_NODE, key->node_regex, OPAL_STRING);
+    ORCM_RAS_REPORTER(ev, ORCM_COMPONENT_MON, key->sensor_name, OPAL_STRING);
+    ORCM_RAS_DESCRIPTION(ev, ORCM_DESC_ZSCORE, &z, OPAL_FLOAT);
+    ORCM_RAS_DESCRIPTION(ev, ORCM_DESC_EXPECTED, &expected, OPAL_FLOAT);
+    ORCM_RAS_DATA(ev, key->label, &x, OPAL_FLOAT);
+    ORCM_RAS_EVENT(ev);
+}
+
+/* run the state machine of a key on the z-score of a sample */
+static void update_level(mca_analytics_anomaly_module_t *mod,
+                         orcm_analytics_anomaly_state_t *st, uint32_t key_id,
+                         float x, float expected, float z, time_t t)
+{
+    orcm_analytics_anomaly_level_t side;
+
+    /* a raised key only looks at its clear level */
+    if (ORCM_ANALYTICS_ANOMALY_NORMAL != st->level) {
+        if ((ORCM_ANALYTICS_ANOMALY_HIGH == st->level && z > mod->clear_z) ||
+            (ORCM_ANALYTICS_ANOMALY_LOW == st->level && z < -mod->clear_z)) {
+            return;
+        }
+        st->level = ORCM_ANALYTICS_ANOMALY_NORMAL;
+        generate_event(mod, st, key_id, x, expected, z, t);
+    }
+
+    if (z > mod->z) {
+        side = ORCM_ANALYTICS_ANOMALY_HIGH;
+    } else if (z < -mod->z) {
+        side = ORCM_ANALYTICS_ANOMALY_LOW;
+    } else {
+        side = ORCM_ANALYTICS_ANOMALY_NORMAL;
+    }
+    if (ORCM_ANALYTICS_ANOMALY_NORMAL == side) {
+        st->count = 0;
+    } else if (side != st->pending) {
+        st->count = 1;
+    } else {
+        st->count++;
+    }
+    st->pending = side;
+    if (ORCM_ANALYTICS_ANOMALY_NORMAL != side && mod->count <= st->count) {
+        st->level = side;
+        st->count = 0;
+        st->pending = ORCM_ANALYTICS_ANOMALY_NORMAL;
+        generate_event(mod, st, key_id, x, expected, z, t);
+    }
+}
+
+static void detect(mca_analytics_anomaly_module_t *mod, uint32_t key_id,
+                   float x, double t)
+{
+    orcm_analytics_anomaly_state_t *st;
+    float *bin = NULL, y, e, ev, sd, z, alpha, limit;
+    bool learn;
+    long b;
+
+    if (NULL == (st = get_state(mod, key_id))) {
+        return;
+    }
+    if (0 < mod->bins) {
+        b = (long)floor(fmod(t, mod->season) / mod->season * mod->bins);
+        bin = &mod->seasons[(size_t)key_id * mod->bins + (b % mod->bins)];
+    }
+    y = (NULL == bin) ? x : x - *bin;
+
+    if (0 == st->n) {
+        st->mean = y;
+        st->var = 0.0;
+        st->n = 1;
+        mod->nseries++;
+        return;
+    }
+
+    e = y - st->mean;
+    sd = sqrtf(st->var);
+    if (sd < mod->min_sd) {
+        sd = mod->min_sd;
+    }
+    if (0.0 < sd) {
+        z = e / sd;
+    } else {
+        z = (0.0 == e) ? 0.0 : copysignf(INFINITY, e);
+    }
+    /* learn quickly while warming up */
+    alpha = 1.0f / (float)(st->n + 1);
+    if (alpha < mod->alpha) {
+        alpha = mod->alpha;
+    }
+    learn = true;
+    if (mod->warmup <= st->n) {
+        update_level(mod, st, key_id, x, x - e, z, (time_t)t);
+        /* an outlier only takes the mean as far as the limit, and the
+         * variance only learns from the samples within the clear level -
+         * else a drift would widen it as fast as it moves away */
+        if (0.0 < sd) {
+            limit = mod->z * sd;
+            if (e > limit) {
+                e = limit;
+            } else if (e < -limit) {
+                e = -limit;
+            }
+            learn = (fabsf(e) < mod->clear_z * sd);
+        }
+    }
+
+    ev = e * e;
+    st->mean += alpha * e;
+    if (learn) {
+        if (mod->warmup <= st->n) {
+            ev *= mod->var_scale;
+        }
+        st->var = (1.0f - alpha) * st->var + alpha * ev;
+        if (NULL != bin) {
+            *bin += mod->gamma * (x - st->mean - *bin);
+        }
+    }
+    if (UINT32_MAX > st->n) {
+        st->n++;
+    }
+}
+
+static int analyze(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t *)cbdata;
+    mca_analytics_anomaly_module_t *mod;
+    orcm_analytics_value_t *value;
+    opal_value_array_t *data;
+    struct timeval now;
+    double x, t;
+    size_t index, size;
+    int rc;
+
+    if (NULL == caddy) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:anomaly:NULL caddy data passed by the previous workflow step",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_anomaly_module_t*)caddy->imod;
+
+    if (!mod->configured && ORCM_SUCCESS != (rc = configure(mod, caddy->wf_step))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    size = opal_value_array_get_size(caddy->data);
+    now.tv_sec = 0;
+    for (index=0; index < size; index++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, index);
+        if (NULL == value || ORCM_ANALYTICS_KEY_INVALID == value->key_id ||
+            !orcm_analytics_base_value_to_double(&value->data.value, &x)) {
+            continue;
+        }
+        if (0 != value->end_time.tv_sec) {
+            t = value->end_time.tv_sec + value->end_time.tv_usec / 1000000.0;
+        } else {
+            if (0 == now.tv_sec) {
+                gettimeofday(&now, NULL);
+            }
+            t = now.tv_sec + now.tv_usec / 1000000.0;
+        }
+        detect(mod, value->key_id, (float)x, t);
+    }
+
+    /* pass the samples on */
+    data = caddy->data;
+    OBJ_RETAIN(data);
+    orcm_analytics_base_store(caddy->wf, caddy->wf_step, data);
+    ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(caddy->wf, caddy->wf_step, data);
+    OBJ_RELEASE(caddy);
+
+    return ORCM_SUCCESS;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ *
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ */
+
+#ifndef MCA_analytics_anomaly_EXPORT_H
+#define MCA_analytics_anomaly_EXPORT_H
+
+#include "orcm_config.h"
+
+#include "orcm/mca/analytics/analytics.h"
+
+BEGIN_C_DECLS
+
+/*
+ * Local Component structures
+ */
+
+ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_anomaly_component;
+
+/* where a (node, sensor, label) stands with respect to its baseline */
+typedef enum {
+    ORCM_ANALYTICS_ANOMALY_NORMAL,
+    ORCM_ANALYTICS_ANOMALY_HIGH,
+    ORCM_ANALYTICS_ANOMALY_LOW
+} orcm_analytics_anomaly_level_t;
+
+/* state of one (node, sensor, label), kept by value - the mean and
+ * variance are those of the samples less their season. count is the
+ * number of consecutive outliers on the side given by pending */
+typedef struct {
+    float mean;
+    float var;
+    uint32_t n;                 /* samples seen, 0 for none */
+    uint8_t level;
+    uint8_t pending;
+    uint8_t count;
+    uint8_t spare;
+} orcm_analytics_anomaly_state_t;
+
+typedef struct {
+    orcm_analytics_base_module_t api;
+    /* detector, taken from the workflow step attributes */
+    bool configured;
+    float alpha;
+    float z;
+    float clear_z;
+    float min_sd;
+    float var_scale;
+    uint32_t warmup;
+    int count;
+    int severity;
+    double season;
+    int bins;
+    float gamma;
+    /* states, and bins of the season of each, by interned key id */
+    orcm_analytics_anomaly_state_t *states;
+    float *seasons;
+    int nstates;
+    /* number of series seen, and of events raised and cleared */
+    uint64_t nseries;
+    uint64_t raised;
+    uint64_t cleared;
+} mca_analytics_anomaly_module_t;
+ORCM_DECLSPEC extern mca_analytics_anomaly_module_t orcm_analytics_anomaly_module;
+
+END_C_DECLS
+
+#endif /* MCA_analytics_anomaly_EXPORT_H */
@@ -21,15 +21,16 @@
 #include "orcm/mca/analytics/base/analytics_private.h"
 #include "orcm/mca/analytics/average/analytics_average.h"
 
-#define HASH_TABLE_SIZE 10000
+#define ITEMS_INITIAL_SIZE 1024
 
 static int init(orcm_analytics_base_module_t *imod);
 static void finalize(orcm_analytics_base_module_t *imod);
 static int analyze(int sd, short args, void *cbdata);
 
 /* analyze function for each data of the sample */
-static orcm_metric_value_t* analyze_sample_item(orcm_analytics_value_t *current_value,
-                                                opal_hash_table_t *orcm_mca_analytics_hash_table,
+static orcm_mca_analytics_average_item_value* analyze_sample_item(
+                                                orcm_analytics_value_t *current_value,
+                                                opal_pointer_array_t *items,
                                                 int index, int wf_id);
 
 /* handle the first sample data */
@@ -43,17 +44,12 @@ static void compute_average(orcm_mca_analytics_average_item_value *previous_item
 static void average_item_value_con(orcm_mca_analytics_average_item_value *value)
 {
     value->num_sample = 0;
-    value->value_average = OBJ_NEW(orcm_metric_value_t);
-}
-
-static void average_item_value_des(orcm_mca_analytics_average_item_value *value)
-{
-    OBJ_RELEASE(value->value_average);
+    value->value_average = 0.0;
 }
 
 OBJ_CLASS_INSTANCE(orcm_mca_analytics_average_item_value,
                    opal_object_t,
-                   average_item_value_con, average_item_value_des);
+                   average_item_value_con, NULL);
 
 mca_analytics_average_module_t orcm_analytics_average_module = {
     {
@@ -70,16 +66,27 @@ static int init(orcm_analytics_base_module_t *imod)
         return ORCM_ERROR;
     }
     mca_analytics_average_module_t *mod = (mca_analytics_average_module_t *)imod;
-    mod->api.orcm_mca_analytics_hash_table = OBJ_NEW(opal_hash_table_t);
-    opal_hash_table_init(mod->api.orcm_mca_analytics_hash_table, HASH_TABLE_SIZE);
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    OBJ_CONSTRUCT(&mod->items, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->items, ITEMS_INITIAL_SIZE, INT32_MAX, ITEMS_INITIAL_SIZE);
     return ORCM_SUCCESS;
 }
 
 static void finalize(orcm_analytics_base_module_t *imod)
 {
+    orcm_mca_analytics_average_item_value *item = NULL;
+    int i;
+
     if (NULL != imod) {
         mca_analytics_average_module_t *mod = (mca_analytics_average_module_t *)imod;
-        OBJ_RELEASE(mod->api.orcm_mca_analytics_hash_table);
+        for (i = 0; i < mod->items.size; i++) {
+            item = (orcm_mca_analytics_average_item_value*)
+                       opal_pointer_array_get_item(&mod->items, i);
+            if (NULL != item) {
+                OBJ_RELEASE(item);
+            }
+        }
+        OBJ_DESTRUCT(&mod->items);
         free(mod);
     }
 }
@@ -91,10 +98,7 @@ static orcm_mca_analytics_average_item_value* create_first_average(
                                                   orcm_mca_analytics_average_item_value);
     if (NULL != current_item) {
         current_item->num_sample = 1;
-        current_item->value_average->units = strdup(current_value->data.units);
-        current_item->value_average->value.key = strdup(current_value->data.value.key);
-        current_item->value_average->value.type = current_value->data.value.type;
-        current_item->value_average->value.data.fval = current_value->data.value.data.fval;
+        current_item->value_average = current_value->data.value.data.fval;
     }
 
     return current_item;
@@ -105,18 +109,16 @@ static void compute_average(orcm_mca_analytics_average_item_value *previous_item
 {
     unsigned int num_sample = previous_item->num_sample;
     previous_item->num_sample++;
-    previous_item->value_average->value.data.fval = (num_sample *
-                     previous_item->value_average->value.data.fval +
+    previous_item->value_average = (num_sample * previous_item->value_average +
                      current_value->data.value.data.fval) / previous_item->num_sample;
 }
 
-static orcm_metric_value_t* analyze_sample_item(orcm_analytics_value_t *current_value,
-                                                opal_hash_table_t *orcm_mca_analytics_hash_table,
+static orcm_mca_analytics_average_item_value* analyze_sample_item(
+                                                orcm_analytics_value_t *current_value,
+                                                opal_pointer_array_t *items,
                                                 int index, int wf_id)
 {
-    orcm_mca_analytics_average_item_value *current_item = NULL, *previous_item = NULL;
-    char *key = NULL;
-    int ret = -1;
+    orcm_mca_analytics_average_item_value *current_item = NULL;
 
     if (NULL == current_value) {
         OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
@@ -124,36 +126,32 @@ static orcm_metric_value_t* analyze_sample_item(orcm_analytics_value_t *current_
             "is NULL", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), index));
         return NULL;
     }
-    if (0 > (ret = asprintf(&key, "%s%d%s", current_value->node_regex,
-                            index, current_value->sensor_name))) {
-        /* the key is the combination of node name, core id (index), and sensor name */
+    if (ORCM_ANALYTICS_KEY_INVALID == current_value->key_id) {
         OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
-            "%s analytics:average:OUT OF RESOURCE", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+            "%s analytics:average:the %dth data item has no key",
+            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), index));
         return NULL;
     }
-    ret = opal_hash_table_get_value_ptr(orcm_mca_analytics_hash_table,
-                           key, strlen(key), (void **)&previous_item);
-    if (OPAL_ERR_NOT_FOUND == ret) {
-        /* not found this key, this is the first data */
+
+    /* the state of each (node, sensor, core) is found by its interned key id */
+    current_item = (orcm_mca_analytics_average_item_value*)
+                       opal_pointer_array_get_item(items, (int)current_value->key_id);
+    if (NULL == current_item) {
+        /* this is the first data */
         current_item = create_first_average(current_value);
-    } else if (OPAL_SUCCESS == ret) {
-        /* found this key, more data sample is coming */
-        if (NULL == previous_item) {
+        if (NULL == current_item ||
+            OPAL_SUCCESS != opal_pointer_array_set_item(items, (int)current_value->key_id,
+                                                        current_item)) {
             OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
-                "%s analytics:average:Hash Table getting NULL value for the key:%s",
-                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), key));
-            free(key);
+                "%s analytics:average:OUT OF RESOURCE", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+            if (NULL != current_item) {
+                OBJ_RELEASE(current_item);
+            }
             return NULL;
         }
-        compute_average(previous_item, current_value);
-        current_item = previous_item;
     } else {
-        /* Hash table lookup failed */
-        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
-            "%s analytics:average:getting item from Hash Table error, key is:%s",
-            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), key));
-        free(key);
-        return NULL;
+        /* more data sample is coming */
+        compute_average(current_item, current_value);
     }
 
 #if OPAL_ENABLE_DEBUG
@@ -161,29 +159,20 @@ static orcm_metric_value_t* analyze_sample_item(orcm_analytics_value_t *current_
         "%s analytics:average:this is the %dth data:%f, node id:%s, core id:%d, sensor "
         "name:%s, workflow:%d, and the AVERAGE:%f", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
         current_item->num_sample, current_value->data.value.data.fval, current_value->node_regex,
-        index, current_value->sensor_name, wf_id, current_item->value_average->value.data.fval));
+        index, current_value->sensor_name, wf_id, current_item->value_average));
 #endif
 
-    ret = opal_hash_table_set_value_ptr(orcm_mca_analytics_hash_table,
-                                        key, strlen(key), current_item);
-    free(key);
-    if (OPAL_SUCCESS != ret) {
-        /* Hash table insert failed */
-        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
-            "%s analytics:average:inserting in Hash Table error",
-            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
-        return NULL;
-    }
-    return current_item->value_average;
+    return current_item;
 }
 
 static int analyze(int sd, short args, void *cbdata)
 {
     orcm_workflow_caddy_t *current_caddy = NULL;
     orcm_analytics_value_t *current_value = NULL;
+    orcm_analytics_value_t average_value;
     opal_value_array_t *analytics_average_array = NULL;
     mca_analytics_average_module_t *mod = NULL;
-    orcm_metric_value_t *average_metric_value = NULL;
+    orcm_mca_analytics_average_item_value *average_item = NULL;
     int index = -1, array_size = -1, rc = -1;
 
     if (NULL == cbdata) {
@@ -195,7 +184,8 @@ static int analyze(int sd, short args, void *cbdata)
 
     current_caddy = (orcm_workflow_caddy_t *)cbdata;
     array_size = opal_value_array_get_size(current_caddy->data);
-    rc = orcm_analytics.array_create(&analytics_average_array, array_size);
+    rc = orcm_analytics_base_step_array(current_caddy->wf_step, &analytics_average_array,
+                                        array_size);
     if (ORCM_SUCCESS != rc) {
             return ORCM_ERR_OUT_OF_RESOURCE;
     }
@@ -204,14 +194,15 @@ static int analyze(int sd, short args, void *cbdata)
     for (index = 0; index < array_size; index++) {
         current_value = (orcm_analytics_value_t*)
                             opal_value_array_get_item(current_caddy->data, index);
-        average_metric_value = analyze_sample_item(current_value,
-          mod->api.orcm_mca_analytics_hash_table, index, current_caddy->wf->workflow_id);
-        if (NULL != average_metric_value) {
-            /* fill the data for the next workflow step */
-            orcm_analytics.array_append(analytics_average_array, index,
-                                        current_value->sensor_name,
-                                        current_value->node_regex,
-                                        average_metric_value);
+        average_item = analyze_sample_item(current_value, &mod->items,
+                                           index, current_caddy->wf->workflow_id);
+        if (NULL != average_item) {
+            /* fill the data for the next workflow step - same key as the sample */
+            average_value = *current_value;
+            average_value.data.value.type = OPAL_FLOAT;
+            average_value.data.value.data.fval = average_item->value_average;
+            average_value.measured = false;
+            opal_value_array_append_item(analytics_average_array, &average_value);
         }
     }
 
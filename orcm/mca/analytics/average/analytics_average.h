@@ -18,6 +18,8 @@
 
 #include "orcm_config.h"
 
+#include "opal/class/opal_pointer_array.h"
+
 #include "orcm/mca/analytics/analytics.h"
 
 BEGIN_C_DECLS
@@ -30,7 +32,7 @@ typedef struct
 {
     opal_object_t super;
     unsigned int num_sample;
-    orcm_metric_value_t *value_average;
+    float value_average;
 } orcm_mca_analytics_average_item_value;
 
 OBJ_CLASS_DECLARATION(orcm_mca_analytics_average_item_value);
@@ -39,6 +41,8 @@ ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_averag
 
 typedef struct {
     orcm_analytics_base_module_t api;
+    /* running averages, indexed by interned key id */
+    opal_pointer_array_t items;
 } mca_analytics_average_module_t;
 ORCM_DECLSPEC extern mca_analytics_average_module_t orcm_analytics_average_module;
 
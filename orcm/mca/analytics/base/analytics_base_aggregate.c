@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <string.h>
+
+#include "opal/dss/dss.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/mca/rml/rml.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Hierarchical aggregation
+ *
+ * An aggregate step reduces the samples of its period to partial
+ * aggregates - count, sum, min, max, ... - and, when forwarding, sends
+ * them up the routing tree (node -> rack -> row -> scheduler) to the
+ * aggregate step of the same name in the parent, which merges them
+ * with those of its other children and its own samples. Only partials
+ * travel between the levels, one per (sensor, label) and period, how
+ * many nodes are below.
+ *
+ * The aggregate steps are kept here by name; partials received are
+ * handed to the step in a workflow of its own as orcm_analytics_partials_t,
+ * so that merging runs on the workflow like any other data.
+ */
+
+orcm_analytics_base_aggregates_t orcm_analytics_base_aggregates = {0};
+
+static char *aggregate_name = "aggregate";
+static char *name_label = "name";
+
+static int forward_to_parent(orcm_workflow_t *wf, const char *name,
+                             opal_buffer_t *partials);
+
+static void aggregator_con(orcm_analytics_base_aggregator_t *p)
+{
+    p->name = NULL;
+    p->wf = NULL;
+    p->step = NULL;
+}
+static void aggregator_des(orcm_analytics_base_aggregator_t *p)
+{
+    free(p->name);
+    if (NULL != p->step) {
+        OBJ_RELEASE(p->step);
+    }
+    if (NULL != p->wf) {
+        OBJ_RELEASE(p->wf);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_base_aggregator_t,
+                   opal_list_item_t,
+                   aggregator_con, aggregator_des);
+
+static void partials_con(orcm_analytics_partials_t *p)
+{
+    p->buffer = NULL;
+}
+static void partials_des(orcm_analytics_partials_t *p)
+{
+    if (NULL != p->buffer) {
+        OBJ_RELEASE(p->buffer);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_partials_t,
+                   opal_value_array_t,
+                   partials_con, partials_des);
+
+void orcm_analytics_base_aggregates_init(void)
+{
+    if (orcm_analytics_base_aggregates.initialized) {
+        return;
+    }
+    OBJ_CONSTRUCT(&orcm_analytics_base_aggregates.lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&orcm_analytics_base_aggregates.aggregators, opal_list_t);
+    if (NULL == orcm_analytics_base_aggregates.forward) {
+        orcm_analytics_base_aggregates.forward = forward_to_parent;
+    }
+    orcm_analytics_base_aggregates.initialized = true;
+}
+
+void orcm_analytics_base_aggregates_finalize(void)
+{
+    if (!orcm_analytics_base_aggregates.initialized) {
+        return;
+    }
+    OPAL_LIST_DESTRUCT(&orcm_analytics_base_aggregates.aggregators);
+    OBJ_DESTRUCT(&orcm_analytics_base_aggregates.lock);
+    orcm_analytics_base_aggregates.initialized = false;
+}
+
+/* the name of the partials of an aggregate step */
+static char* aggregate_step_name(orcm_workflow_step_t *step)
+{
+    opal_value_t *attr;
+
+    OPAL_LIST_FOREACH(attr, &step->attributes, opal_value_t) {
+        if (NULL != attr->key && OPAL_STRING == attr->type &&
+            0 == strcmp(attr->key, name_label) && NULL != attr->data.string) {
+            return attr->data.string;
+        }
+    }
+    return aggregate_name;
+}
+
+int orcm_analytics_base_aggregate_register(orcm_workflow_t *wf)
+{
+    orcm_workflow_step_t *step;
+    orcm_analytics_base_aggregator_t *agg;
+
+    if (!orcm_analytics_base_aggregates.initialized) {
+        return ORCM_SUCCESS;
+    }
+
+    OPAL_LIST_FOREACH(step, &wf->steps, orcm_workflow_step_t) {
+        if (NULL == step->analytic || 0 != strcmp(step->analytic, aggregate_name)) {
+            continue;
+        }
+        agg = OBJ_NEW(orcm_analytics_base_aggregator_t);
+        if (NULL == agg) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        agg->name = strdup(aggregate_step_name(step));
+        OBJ_RETAIN(wf);
+        agg->wf = wf;
+        OBJ_RETAIN(step);
+        agg->step = step;
+
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:base:aggregate workflow %d takes partials of %s",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                             wf->workflow_id, agg->name));
+
+        OPAL_THREAD_LOCK(&orcm_analytics_base_aggregates.lock);
+        opal_list_append(&orcm_analytics_base_aggregates.aggregators, &agg->super);
+        OPAL_THREAD_UNLOCK(&orcm_analytics_base_aggregates.lock);
+    }
+    return ORCM_SUCCESS;
+}
+
+void orcm_analytics_base_aggregate_unregister(orcm_workflow_t *wf)
+{
+    orcm_analytics_base_aggregator_t *agg, *next;
+
+    if (!orcm_analytics_base_aggregates.initialized) {
+        return;
+    }
+
+    OPAL_THREAD_LOCK(&orcm_analytics_base_aggregates.lock);
+    OPAL_LIST_FOREACH_SAFE(agg, next, &orcm_analytics_base_aggregates.aggregators,
+                           orcm_analytics_base_aggregator_t) {
+        if (agg->wf == wf) {
+            opal_list_remove_item(&orcm_analytics_base_aggregates.aggregators, &agg->super);
+            OBJ_RELEASE(agg);
+        }
+    }
+    OPAL_THREAD_UNLOCK(&orcm_analytics_base_aggregates.lock);
+}
+
+int orcm_analytics_base_aggregate_deliver(orcm_workflow_t *wf, const char *name,
+                                          opal_buffer_t *partials)
+{
+    orcm_analytics_base_aggregator_t *agg;
+    orcm_analytics_partials_t *data;
+    int rc, delivered = 0;
+
+    if (!orcm_analytics_base_aggregates.initialized) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+
+    OPAL_THREAD_LOCK(&orcm_analytics_base_aggregates.lock);
+    OPAL_LIST_FOREACH(agg, &orcm_analytics_base_aggregates.aggregators,
+                      orcm_analytics_base_aggregator_t) {
+        if ((NULL != wf && agg->wf != wf) || 0 != strcmp(agg->name, name)) {
+            continue;
+        }
+        data = OBJ_NEW(orcm_analytics_partials_t);
+        if (NULL == data) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            break;
+        }
+        /* each step gets its own copy to unpack */
+        data->buffer = OBJ_NEW(opal_buffer_t);
+        if (OPAL_SUCCESS != (rc = opal_dss.copy_payload(data->buffer, partials))) {
+            ORTE_ERROR_LOG(rc);
+            OBJ_RELEASE(data);
+            break;
+        }
+        orcm_analytics_base_activate_analytics_workflow_step(agg->wf, agg->step,
+                                                             &data->super);
+        delivered++;
+    }
+    OPAL_THREAD_UNLOCK(&orcm_analytics_base_aggregates.lock);
+
+    if (0 == delivered) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:base:aggregate no workflow takes partials of %s",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), name));
+        return ORCM_ERR_NOT_FOUND;
+    }
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_aggregate_forward(orcm_workflow_t *wf, const char *name,
+                                          opal_buffer_t *partials)
+{
+    if (NULL == orcm_analytics_base_aggregates.forward) {
+        orcm_analytics_base_aggregates.forward = forward_to_parent;
+    }
+    return orcm_analytics_base_aggregates.forward(wf, name, partials);
+}
+
+static int forward_to_parent(orcm_workflow_t *wf, const char *name,
+                             opal_buffer_t *partials)
+{
+    orcm_analytics_cmd_flag_t command = ORCM_ANALYTICS_AGGREGATE;
+    opal_buffer_t *buffer;
+    int rc;
+
+    if (ORTE_JOBID_INVALID == ORTE_PROC_MY_PARENT->jobid ||
+        OPAL_EQUAL == orte_util_compare_name_fields(ORTE_NS_CMP_ALL,
+                                                    ORTE_PROC_MY_PARENT,
+                                                    ORTE_PROC_MY_NAME)) {
+        /* the top of the tree - nowhere to go */
+        OBJ_RELEASE(partials);
+        return ORCM_ERR_NOT_FOUND;
+    }
+
+    buffer = OBJ_NEW(opal_buffer_t);
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &command, 1, ORCM_ANALYTICS_CMD_T)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &name, 1, OPAL_STRING)) ||
+        OPAL_SUCCESS != (rc = opal_dss.copy_payload(buffer, partials))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buffer);
+        OBJ_RELEASE(partials);
+        return rc;
+    }
+    OBJ_RELEASE(partials);
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:base:aggregate workflow %d sending partials of %s to %s",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), wf->workflow_id, name,
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_PARENT)));
+
+    if (ORTE_SUCCESS != (rc = orte_rml.send_buffer_nb(ORTE_PROC_MY_PARENT, buffer,
+                                                      ORCM_RML_TAG_ANALYTICS,
+                                                      orte_rml_send_callback, NULL))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buffer);
+    }
+    return rc;
+}
+
+void orcm_analytics_base_aggregate_recv(orte_process_name_t *sender, opal_buffer_t *buffer)
+{
+    char *name = NULL;
+    int rc, n = 1;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &name, &n, OPAL_STRING))) {
+        ORTE_ERROR_LOG(rc);
+        return;
+    }
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:base:aggregate partials of %s from %s",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), name,
+                         ORTE_NAME_PRINT(sender)));
+
+    (void)orcm_analytics_base_aggregate_deliver(NULL, name, buffer);
+    free(name);
+}
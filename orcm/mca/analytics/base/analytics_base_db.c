@@ -7,35 +7,46 @@
  * $HEADER$
  */
 
+#include "opal/mca/event/event.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+
 #include "orcm/mca/analytics/base/analytics_private.h"
 #include "orcm/mca/db/db.h"
 
-/* check whether this workflow step needs to load the data results to store */
-static bool orcm_analytics_base_db_check(orcm_workflow_step_t *wf_step);
-
 /* create a opal_value_t according to the key and data type*/
 static opal_value_t *orcm_analytics_create_opal_value(char *key, opal_data_type_t type);
 
-/* fill the primary key of the record to the database */
-static int orcm_analytics_base_db_fill_primary_key(opal_list_t *db_input,
-                                                   orcm_analytics_value_t *data_item,
-                                                   char *plugin_name, int wf_id);
+/* the buffer of a workflow step storing its results, per its attributes */
+static orcm_analytics_base_db_buffer_t *orcm_analytics_base_db_buffer(orcm_workflow_step_t *wf_step);
 
-/* fill the data of the record to the database*/
-static int orcm_analytics_db_fill_data(opal_list_t *db_input,
-                                       opal_value_array_t *data_results, int data_size);
+/* add the data results of an invocation as a record */
+static int orcm_analytics_base_db_buffer_append(orcm_analytics_base_db_buffer_t *buffer,
+                                                opal_value_array_t *data_results);
 
-/* storing data to the database */
-static int orcm_analytics_base_db_store(orcm_workflow_t *wf,
-                                        orcm_workflow_step_t *wf_step,
-                                        opal_value_array_t *data_results);
+/* flush the buffer of the step of a timer caddy, on its workflow */
+static int orcm_analytics_base_db_timed_flush(int sd, short args, void *cbdata);
 
-/* call back function to clean up for the db store function */
+/* have a buffer flushed once its interval is up */
+static void orcm_analytics_base_db_arm(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step,
+                                       orcm_analytics_base_db_buffer_t *buffer);
+
+/* call back function returning the record lists of a flush to the pool */
 static void orcm_analytics_db_cleanup(int db_handle, int status, opal_list_t *list,
                                       opal_list_t *ret, void *cbdata);
 
 orcm_analytics_base_db_t orcm_analytics_base_db = {-1, false};
 
+/* runs the timed flushes on the executor like a step */
+static orcm_analytics_base_module_t orcm_analytics_base_db_flusher = {
+    NULL,
+    NULL,
+    orcm_analytics_base_db_timed_flush,
+    NULL,
+    NULL
+};
+
 void orcm_analytics_base_db_open_cb(int handle, int status, opal_list_t *props,
                                     opal_list_t *ret, void *cbdata)
 {
@@ -69,7 +80,7 @@ void orcm_analytics_base_close_db(void)
     }
 }
 
-static bool orcm_analytics_base_db_check(orcm_workflow_step_t *wf_step)
+bool orcm_analytics_base_db_check(orcm_workflow_step_t *wf_step)
 {
     bool load_to_db = false;
     opal_value_t *attribute = NULL;
@@ -102,159 +113,596 @@ static opal_value_t *orcm_analytics_create_opal_value(char *key, opal_data_type_
     return kv;
 }
 
+/* the record lists of a flush, on their way to the database */
+typedef struct {
+    orcm_analytics_base_db_buffer_t *buffer;
+    size_t nlists;
+    opal_list_t *lists[];
+} orcm_analytics_db_flush_t;
+
 static void orcm_analytics_db_cleanup(int db_handle, int status, opal_list_t *list,
                                       opal_list_t *ret, void *cbdata)
 {
-    OPAL_LIST_RELEASE(list);
+    orcm_analytics_db_flush_t *flush = (orcm_analytics_db_flush_t*)cbdata;
+    orcm_analytics_base_db_buffer_t *buffer = flush->buffer;
+    opal_list_t **pool;
+    size_t i;
+
+    if (ORCM_SUCCESS != status) {
+        opal_output_verbose(2, orcm_analytics_base_framework.framework_output,
+                            "%s analytics:base:db failed to store %lu records: %d",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            (unsigned long)flush->nlists, status);
+    }
+
+    /* the lists keep their values for the next flush to refill */
+    OPAL_THREAD_LOCK(&buffer->lock);
+    if (buffer->npool + (int)flush->nlists > buffer->pool_size) {
+        pool = (opal_list_t**)realloc(buffer->pool, (buffer->npool + flush->nlists) *
+                                      sizeof(opal_list_t*));
+        if (NULL != pool) {
+            buffer->pool = pool;
+            buffer->pool_size = buffer->npool + (int)flush->nlists;
+        }
+    }
+    for (i=0; i < flush->nlists; i++) {
+        if (buffer->npool < buffer->pool_size) {
+            buffer->pool[buffer->npool++] = flush->lists[i];
+        } else {
+            OPAL_LIST_RELEASE(flush->lists[i]);
+        }
+    }
+    OPAL_THREAD_UNLOCK(&buffer->lock);
+
+    OBJ_RELEASE(buffer);
+    free(flush);
 }
 
-static int orcm_analytics_base_db_fill_primary_key(opal_list_t *db_input,
-                                                   orcm_analytics_value_t *data_item,
-                                                   char *plugin_name, int wf_id)
+/*
+ * The results of a step storing them are buffered until its db_flush
+ * attribute - <n>[ms|s|m|h], 0 by default - has passed since the oldest,
+ * or ORCM_ANALYTICS_DB_MAX_ROWS values are waiting, and then go to the
+ * database as a single request. A timer flushes them once the interval
+ * is up should the step go quiet before it stores again.
+ */
+static orcm_analytics_base_db_buffer_t *orcm_analytics_base_db_buffer(orcm_workflow_step_t *wf_step)
 {
-    struct timeval current_time;
-    opal_value_t *kv = NULL;
-    int rc = -1;
-
-    /* fill the time to the db input */
-    gettimeofday(&current_time, NULL);
-    kv = orcm_analytics_create_opal_value("ctime", OPAL_TIMEVAL);
-    if (NULL == kv) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
+    orcm_analytics_base_db_buffer_t *buffer;
+    opal_value_t *attribute = NULL;
+
+    if (NULL != wf_step->db_buffer) {
+        return wf_step->db_buffer;
+    }
+    if (!orcm_analytics_base_db_check(wf_step)) {
+        return NULL;
     }
-    kv->data.tv = current_time;
-    opal_list_append(db_input, &(kv->super));
 
-    /* fill the hostname to the db input */
-    kv = orcm_analytics_create_opal_value("hostname", OPAL_STRING);
-    if (NULL == kv) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
+    buffer = OBJ_NEW(orcm_analytics_base_db_buffer_t);
+    OPAL_LIST_FOREACH(attribute, &(wf_step->attributes), opal_value_t) {
+        if (NULL == attribute->key || 0 != strcmp(attribute->key, "db_flush") ||
+            OPAL_STRING != attribute->type) {
+            continue;
+        }
+        if (ORCM_SUCCESS != orcm_analytics_base_parse_period(attribute->data.string, true,
+                                                          &buffer->interval)) {
+            opal_output(0, "Analytics framework: invalid db_flush %s, storing every "
+                        "invocation", attribute->data.string);
+            buffer->interval = 0.0;
+        }
     }
-    kv->data.string = strdup(data_item->node_regex);
-    opal_list_append(db_input, &(kv->super));
+    wf_step->db_buffer = buffer;
+    return buffer;
+}
 
-    /* fill the data_group to the db input: sensorname_pluginname_workflowid */
-    kv = orcm_analytics_create_opal_value("data_group", OPAL_STRING);
-    if (NULL == kv) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
+/* the numeric data of a value as it is to be stored, false if it has none */
+static bool orcm_analytics_db_get_value(opal_value_t *value, orcm_analytics_base_db_number_t *x)
+{
+    switch (value->type) {
+    case OPAL_FLOAT:
+        x->dval = value->data.fval;
+        break;
+    case OPAL_DOUBLE:
+        x->dval = value->data.dval;
+        break;
+    case OPAL_INT:
+        x->ival = value->data.integer;
+        break;
+    case OPAL_INT8:
+        x->ival = value->data.int8;
+        break;
+    case OPAL_INT16:
+        x->ival = value->data.int16;
+        break;
+    case OPAL_INT32:
+        x->ival = value->data.int32;
+        break;
+    case OPAL_INT64:
+        x->ival = value->data.int64;
+        break;
+    case OPAL_UINT:
+        x->uval = value->data.uint;
+        break;
+    case OPAL_UINT8:
+        x->uval = value->data.uint8;
+        break;
+    case OPAL_UINT16:
+        x->uval = value->data.uint16;
+        break;
+    case OPAL_UINT32:
+        x->uval = value->data.uint32;
+        break;
+    case OPAL_UINT64:
+        x->uval = value->data.uint64;
+        break;
+    default:
+        return false;
     }
-    rc = asprintf(&(kv->data.string), "%s_%s_workflow %d",
-                  data_item->sensor_name, plugin_name, wf_id);
-    if (0 > rc) {
-        OBJ_RELEASE(kv);
+    return true;
+}
+
+static int orcm_analytics_base_db_grow(void **column, size_t width, int size)
+{
+    void *grown = realloc(*column, width * size);
+
+    if (NULL == grown) {
         return ORCM_ERR_OUT_OF_RESOURCE;
     }
-    opal_list_append(db_input, &(kv->super));
-
+    *column = grown;
     return ORCM_SUCCESS;
 }
 
-static int orcm_analytics_db_fill_data(opal_list_t *db_input,
-                                       opal_value_array_t *data_results, int data_size)
+static int orcm_analytics_base_db_buffer_append(orcm_analytics_base_db_buffer_t *buffer,
+                                                opal_value_array_t *data_results)
 {
     orcm_analytics_value_t *data_item = NULL;
-    orcm_metric_value_t *analytics_metric = NULL;
-    int index = -1, rc = -1;
+    int data_size, index, size, first;
+    uint32_t id;
+
+    data_size = (int)opal_value_array_get_size(data_results);
+    if (0 >= data_size) {
+        return ORCM_ERR_BAD_PARAM;
+    }
 
-    /* fill the actual data results to the db input */
+    if (buffer->nrecords == buffer->records_size) {
+        size = (0 == buffer->records_size) ? 16 : 2 * buffer->records_size;
+        if (ORCM_SUCCESS != orcm_analytics_base_db_grow((void**)&buffer->ctime,
+                                                        sizeof(struct timeval), size) ||
+            ORCM_SUCCESS != orcm_analytics_base_db_grow((void**)&buffer->first,
+                                                        sizeof(int), size)) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        buffer->records_size = size;
+    }
+    if (buffer->nrows + data_size > buffer->rows_size) {
+        size = (0 == buffer->rows_size) ? 256 : 2 * buffer->rows_size;
+        while (size < buffer->nrows + data_size) {
+            size *= 2;
+        }
+        if (ORCM_SUCCESS != orcm_analytics_base_db_grow((void**)&buffer->key_id,
+                                                        sizeof(uint32_t), size) ||
+            ORCM_SUCCESS != orcm_analytics_base_db_grow((void**)&buffer->type,
+                                                        sizeof(opal_data_type_t), size) ||
+            ORCM_SUCCESS != orcm_analytics_base_db_grow((void**)&buffer->value,
+                                                        sizeof(orcm_analytics_base_db_number_t),
+                                                        size)) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        buffer->rows_size = size;
+    }
+
+    /* a row per numeric value, which carries its node, sensor and units
+     * in its key */
+    first = buffer->nrows;
     for (index = 0; index < data_size; index++) {
         data_item = (orcm_analytics_value_t*)opal_value_array_get_item(data_results, index);
         if (NULL == data_item) {
-            OPAL_LIST_RELEASE(db_input);
+            buffer->nrows = first;
             return ORCM_ERR_DATA_VALUE_NOT_FOUND;
         }
-        analytics_metric = OBJ_NEW(orcm_metric_value_t);
-        if (NULL == analytics_metric) {
-            return ORCM_ERR_OUT_OF_RESOURCE;
+        if (!orcm_analytics_db_get_value(&data_item->data.value,
+                                         &buffer->value[buffer->nrows])) {
+            continue;
         }
-        analytics_metric->units = strdup(data_item->data.units);
-        rc = asprintf(&(analytics_metric->value.key), "core %d", index);
-        if (0 > rc) {
-            OBJ_RELEASE(analytics_metric);
-            return ORCM_ERR_OUT_OF_RESOURCE;
+        id = data_item->key_id;
+        if (ORCM_ANALYTICS_KEY_INVALID == id) {
+            id = orcm_analytics_base_key_intern(data_item->node_regex,
+                                                data_item->sensor_name, index,
+                                                data_item->data.value.key,
+                                                data_item->data.units);
+            if (ORCM_ANALYTICS_KEY_INVALID == id) {
+                continue;
+            }
         }
-        analytics_metric->value.type = data_item->data.value.type;
-        analytics_metric->value.data.fval = data_item->data.value.data.fval;
-        opal_list_append(db_input, (opal_list_item_t*)(analytics_metric));
+        buffer->key_id[buffer->nrows] = id;
+        buffer->type[buffer->nrows] = data_item->data.value.type;
+        buffer->nrows++;
+    }
+    if (first == buffer->nrows) {
+        return ORCM_SUCCESS;
     }
 
+    gettimeofday(&buffer->ctime[buffer->nrecords], NULL);
+    if (0 == buffer->nrecords) {
+        buffer->oldest = buffer->ctime[0];
+    }
+    buffer->first[buffer->nrecords++] = first;
+    buffer->records++;
     return ORCM_SUCCESS;
-
 }
 
-static int orcm_analytics_base_db_store(orcm_workflow_t *wf,
-                                        orcm_workflow_step_t *wf_step,
-                                        opal_value_array_t *data_results)
+/* point a string at a copy of another, unless it is one already */
+static int orcm_analytics_db_set_string(char **str, const char *value)
 {
-    opal_list_t *db_input = NULL;
-    orcm_analytics_value_t *data_item = NULL;
-    int data_size = -1, rc = -1;
+    if (NULL != *str && NULL != value && 0 == strcmp(*str, value)) {
+        return ORCM_SUCCESS;
+    }
+    free(*str);
+    *str = NULL;
+    if (NULL != value && NULL == (*str = strdup(value))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    return ORCM_SUCCESS;
+}
 
-    /* if the size of the data results is 0, simply return */
-    data_size = opal_value_array_get_size(data_results);
-    if (0 >= data_size) {
-        return ORCM_ERR_BAD_PARAM;
+static void orcm_analytics_db_set_value(opal_value_t *kv, opal_data_type_t type,
+                                        orcm_analytics_base_db_number_t *x)
+{
+    kv->type = type;
+    switch (type) {
+    case OPAL_FLOAT:
+        kv->data.fval = (float)x->dval;
+        break;
+    case OPAL_INT:
+        kv->data.integer = (int)x->ival;
+        break;
+    case OPAL_INT8:
+        kv->data.int8 = (int8_t)x->ival;
+        break;
+    case OPAL_INT16:
+        kv->data.int16 = (int16_t)x->ival;
+        break;
+    case OPAL_INT32:
+        kv->data.int32 = (int32_t)x->ival;
+        break;
+    case OPAL_INT64:
+        kv->data.int64 = x->ival;
+        break;
+    case OPAL_UINT:
+        kv->data.uint = (unsigned int)x->uval;
+        break;
+    case OPAL_UINT8:
+        kv->data.uint8 = (uint8_t)x->uval;
+        break;
+    case OPAL_UINT16:
+        kv->data.uint16 = (uint16_t)x->uval;
+        break;
+    case OPAL_UINT32:
+        kv->data.uint32 = (uint32_t)x->uval;
+        break;
+    case OPAL_UINT64:
+        kv->data.uint64 = x->uval;
+        break;
+    default:
+        kv->type = OPAL_DOUBLE;
+        kv->data.dval = x->dval;
+        break;
     }
+}
 
-    /* try to fill the primary key of the record */
-    data_item = (orcm_analytics_value_t*)opal_value_array_get_item(data_results, 0);
-    if (NULL == data_item) {
+/*
+ * Fill a record list - the primary key of the record, then its values as
+ * metrics named after their position - reusing the values it holds from
+ * an earlier flush
+ */
+static int orcm_analytics_db_fill_record(orcm_analytics_base_db_buffer_t *buffer,
+                                         opal_list_t *db_input, int record,
+                                         char *plugin_name, int wf_id)
+{
+    orcm_analytics_key_t *key;
+    opal_list_item_t *item;
+    opal_value_t *kv;
+    orcm_metric_value_t *analytics_metric;
+    char name[256];
+    int row, last, rc;
+
+    key = orcm_analytics_base_key_get(buffer->key_id[buffer->first[record]]);
+    if (NULL == key) {
         return ORCM_ERR_DATA_VALUE_NOT_FOUND;
     }
-    db_input = OBJ_NEW(opal_list_t);
-    if (NULL == db_input) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
+
+    /* primary key: time, hostname and sensorname_pluginname_workflowid */
+    if (0 == opal_list_get_size(db_input)) {
+        if (NULL == (kv = orcm_analytics_create_opal_value("ctime", OPAL_TIMEVAL))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        opal_list_append(db_input, &(kv->super));
+        if (NULL == (kv = orcm_analytics_create_opal_value("hostname", OPAL_STRING))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        opal_list_append(db_input, &(kv->super));
+        if (NULL == (kv = orcm_analytics_create_opal_value("data_group", OPAL_STRING))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        opal_list_append(db_input, &(kv->super));
     }
-    rc = orcm_analytics_base_db_fill_primary_key(db_input, data_item,
-                                                 wf_step->analytic, wf->workflow_id);
-    if (ORCM_ERR_OUT_OF_RESOURCE == rc) {
-        goto cleanup;
+    kv = (opal_value_t*)opal_list_get_first(db_input);
+    kv->data.tv = buffer->ctime[record];
+    kv = (opal_value_t*)opal_list_get_next(&kv->super);
+    if (ORCM_SUCCESS != (rc = orcm_analytics_db_set_string(&kv->data.string,
+                                                           key->node_regex))) {
+        return rc;
     }
-
-    /* try to fill the actual data of the record */
-    rc = orcm_analytics_db_fill_data(db_input, data_results, data_size);
-    if (ORCM_ERR_DATA_VALUE_NOT_FOUND == rc) {
+    kv = (opal_value_t*)opal_list_get_next(&kv->super);
+    snprintf(name, sizeof(name), "%s_%s_workflow %d", key->sensor_name, plugin_name, wf_id);
+    if (ORCM_SUCCESS != (rc = orcm_analytics_db_set_string(&kv->data.string, name))) {
         return rc;
     }
-    if (ORCM_ERR_OUT_OF_RESOURCE == rc) {
-        goto cleanup;
+
+    /* the values */
+    item = opal_list_get_next(&kv->super);
+    last = (record + 1 < buffer->nrecords) ? buffer->first[record + 1] : buffer->nrows;
+    for (row = buffer->first[record]; row < last; row++) {
+        if (item == opal_list_get_end(db_input)) {
+            analytics_metric = OBJ_NEW(orcm_metric_value_t);
+            if (NULL == analytics_metric) {
+                return ORCM_ERR_OUT_OF_RESOURCE;
+            }
+            opal_list_append(db_input, &(analytics_metric->value.super));
+            buffer->allocated++;
+        } else {
+            analytics_metric = (orcm_metric_value_t*)item;
+            item = opal_list_get_next(item);
+        }
+        if (NULL == (key = orcm_analytics_base_key_get(buffer->key_id[row]))) {
+            return ORCM_ERR_DATA_VALUE_NOT_FOUND;
+        }
+        snprintf(name, sizeof(name), "core %d", row - buffer->first[record]);
+        if (ORCM_SUCCESS != (rc = orcm_analytics_db_set_string(&analytics_metric->value.key,
+                                                               name)) ||
+            ORCM_SUCCESS != (rc = orcm_analytics_db_set_string(&analytics_metric->units,
+                                                               key->units))) {
+            return rc;
+        }
+        orcm_analytics_db_set_value(&analytics_metric->value, buffer->type[row],
+                                    &buffer->value[row]);
+    }
+
+    /* values left over from a larger record */
+    while (item != opal_list_get_end(db_input)) {
+        kv = (opal_value_t*)item;
+        item = opal_list_get_next(item);
+        opal_list_remove_item(db_input, &kv->super);
+        OBJ_RELEASE(kv);
     }
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_db_flush(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step)
+{
+    orcm_analytics_base_db_buffer_t *buffer;
+    orcm_analytics_db_flush_t *flush;
+    opal_list_t *db_input;
+    int record, rc = ORCM_SUCCESS;
 
-    /* try to load the data to database */
-    if (0 <= orcm_analytics_base_db.db_handle) {
-        orcm_db.store_new(orcm_analytics_base_db.db_handle, ORCM_DB_ENV_DATA,
-                          db_input, NULL, orcm_analytics_db_cleanup, NULL);
+    if (NULL == wf || NULL == wf_step) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    buffer = wf_step->db_buffer;
+    if (NULL == buffer || 0 == buffer->nrecords) {
         return ORCM_SUCCESS;
     }
+    if (false == orcm_analytics_base_db.db_handle_acquired ||
+        0 > orcm_analytics_base_db.db_handle) {
+        rc = ORCM_ERR_NO_CONNECTION_ALLOWED;
+        goto reset;
+    }
 
-    OPAL_LIST_RELEASE(db_input);
-    return ORCM_ERR_NO_CONNECTION_ALLOWED;
+    flush = (orcm_analytics_db_flush_t*)malloc(sizeof(orcm_analytics_db_flush_t) +
+                                               buffer->nrecords * sizeof(opal_list_t*));
+    if (NULL == flush) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto reset;
+    }
+    flush->nlists = 0;
+    for (record = 0; record < buffer->nrecords; record++) {
+        db_input = NULL;
+        OPAL_THREAD_LOCK(&buffer->lock);
+        if (0 < buffer->npool) {
+            db_input = buffer->pool[--buffer->npool];
+        }
+        OPAL_THREAD_UNLOCK(&buffer->lock);
+        if (NULL == db_input && NULL == (db_input = OBJ_NEW(opal_list_t))) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            break;
+        }
+        flush->lists[flush->nlists] = db_input;
+        rc = orcm_analytics_db_fill_record(buffer, db_input, record,
+                                           wf_step->analytic, wf->workflow_id);
+        if (ORCM_SUCCESS != rc) {
+            OPAL_LIST_RELEASE(db_input);
+            break;
+        }
+        flush->nlists++;
+    }
+    if (0 == flush->nlists) {
+        free(flush);
+        goto reset;
+    }
 
-cleanup:
-    OPAL_LIST_RELEASE(db_input);
-    return ORCM_ERR_OUT_OF_RESOURCE;
+    /* the callback gives the lists back, and the buffer */
+    OBJ_RETAIN(buffer);
+    flush->buffer = buffer;
+    buffer->flushes++;
+    orcm_db.store_batch(orcm_analytics_base_db.db_handle, ORCM_DB_ENV_DATA,
+                        flush->lists, flush->nlists, orcm_analytics_db_cleanup, flush);
+
+reset:
+    buffer->nrecords = 0;
+    buffer->nrows = 0;
+    return rc;
 }
 
 int orcm_analytics_base_store(orcm_workflow_t *wf,
                               orcm_workflow_step_t *wf_step,
                               opal_value_array_t *data_results)
 {
+    orcm_analytics_base_db_buffer_t *buffer;
+    struct timeval now;
+    int rc;
+
     /* If any parameter is NULL, then return bad parameter */
     if (NULL == wf || NULL == wf_step || NULL == data_results) {
         return ORCM_ERR_BAD_PARAM;
     }
 
-    /* Database connection is open */
-    if (true == orcm_analytics_base_db.db_handle_acquired) {
-        /* DB attribute matches "yes", load data to db */
-        if (true == orcm_analytics_base_db_check(wf_step)) {
-            return orcm_analytics_base_db_store(wf, wf_step, data_results);
-        }
+    /* Database connection is not allowed */
+    if (true != orcm_analytics_base_db.db_handle_acquired) {
+        return ORCM_ERR_NO_CONNECTION_ALLOWED;
+    }
 
-        /* DB attribute does not match "yes", no need to load data */
+    /* DB attribute does not match "yes", no need to load data */
+    if (NULL == (buffer = orcm_analytics_base_db_buffer(wf_step))) {
         return ORCM_ERR_NO_MATCH_YET;
     }
 
-    /* Database connection is not allowed */
-    return ORCM_ERR_NO_CONNECTION_ALLOWED;
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_db_buffer_append(buffer, data_results))) {
+        return rc;
+    }
+
+    /* time to send what has been buffered */
+    if (0.0 < buffer->interval && ORCM_ANALYTICS_DB_MAX_ROWS > buffer->nrows) {
+        gettimeofday(&now, NULL);
+        if ((double)(now.tv_sec - buffer->oldest.tv_sec) +
+            (double)(now.tv_usec - buffer->oldest.tv_usec) / 1000000.0 < buffer->interval) {
+            orcm_analytics_base_db_arm(wf, wf_step, buffer);
+            return ORCM_SUCCESS;
+        }
+    }
+    return orcm_analytics_base_db_flush(wf, wf_step);
+}
+
+static int orcm_analytics_base_db_timed_flush(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    int rc;
+
+    rc = orcm_analytics_base_db_flush(caddy->wf, caddy->wf_step);
+    OBJ_RELEASE(caddy);
+    return rc;
+}
+
+/* the interval is up - flush on the thread running the workflow, so
+ * that the step is not storing meanwhile */
+static void orcm_analytics_base_db_timer_fired(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_base_db_buffer_t *buffer = caddy->wf_step->db_buffer;
+    bool stopped;
+
+    /* a stop taking the timer meanwhile releases it */
+    OPAL_THREAD_LOCK(&buffer->lock);
+    stopped = (caddy != buffer->timer);
+    buffer->timer = NULL;
+    OPAL_THREAD_UNLOCK(&buffer->lock);
+    if (stopped) {
+        return;
+    }
+
+    if (NULL == caddy->wf->ev_base) {
+        orcm_analytics_base_executor_submit(caddy);
+    } else {
+        (void)orcm_analytics_base_db_timed_flush(sd, args, caddy);
+    }
+}
+
+static void orcm_analytics_base_db_arm(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step,
+                                       orcm_analytics_base_db_buffer_t *buffer)
+{
+    opal_event_base_t *evbase = (NULL == wf->ev_base) ? orte_event_base : wf->ev_base;
+    orcm_workflow_caddy_t *caddy;
+    struct timeval tv;
+
+    /* without an event base, the next store flushes */
+    if (NULL == evbase || NULL != buffer->timer) {
+        return;
+    }
+    if (NULL == (caddy = OBJ_NEW(orcm_workflow_caddy_t))) {
+        return;
+    }
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(wf_step);
+    caddy->wf_step = wf_step;
+    caddy->imod = &orcm_analytics_base_db_flusher;
+
+    orcm_analytics_base_to_timeval(buffer->interval, &tv);
+    opal_event_evtimer_set(evbase, &caddy->ev, orcm_analytics_base_db_timer_fired, caddy);
+    OPAL_THREAD_LOCK(&buffer->lock);
+    buffer->timer = caddy;
+    OPAL_THREAD_UNLOCK(&buffer->lock);
+    opal_event_evtimer_add(&caddy->ev, &tv);
+}
+
+int orcm_analytics_base_db_stop(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step)
+{
+    orcm_analytics_base_db_buffer_t *buffer;
+    orcm_workflow_caddy_t *caddy;
+
+    if (NULL == wf || NULL == wf_step) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (NULL != (buffer = wf_step->db_buffer)) {
+        OPAL_THREAD_LOCK(&buffer->lock);
+        caddy = buffer->timer;
+        buffer->timer = NULL;
+        OPAL_THREAD_UNLOCK(&buffer->lock);
+        if (NULL != caddy) {
+            opal_event_evtimer_del(&caddy->ev);
+            OBJ_RELEASE(caddy);
+        }
+    }
+    return orcm_analytics_base_db_flush(wf, wf_step);
+}
+
+/****    INSTANCE CLASSES    ****/
+static void db_buffer_con(orcm_analytics_base_db_buffer_t *p)
+{
+    p->interval = 0.0;
+    p->oldest.tv_sec = 0;
+    p->oldest.tv_usec = 0;
+    p->timer = NULL;
+    p->nrecords = 0;
+    p->records_size = 0;
+    p->ctime = NULL;
+    p->first = NULL;
+    p->nrows = 0;
+    p->rows_size = 0;
+    p->key_id = NULL;
+    p->type = NULL;
+    p->value = NULL;
+    OBJ_CONSTRUCT(&p->lock, opal_mutex_t);
+    p->pool = NULL;
+    p->npool = 0;
+    p->pool_size = 0;
+    p->records = 0;
+    p->flushes = 0;
+    p->allocated = 0;
+}
+static void db_buffer_des(orcm_analytics_base_db_buffer_t *p)
+{
+    int i;
+
+    free(p->ctime);
+    free(p->first);
+    free(p->key_id);
+    free(p->type);
+    free(p->value);
+    for (i=0; i < p->npool; i++) {
+        OPAL_LIST_RELEASE(p->pool[i]);
+    }
+    free(p->pool);
+    OBJ_DESTRUCT(&p->lock);
 }
+OBJ_CLASS_INSTANCE(orcm_analytics_base_db_buffer_t,
+                   opal_object_t,
+                   db_buffer_con, db_buffer_des);
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "opal/dss/dss.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Executor
+ *
+ * The workflow steps of the aggregator run on a fixed set of worker
+ * threads, one per core unless analytics_base_num_workers says
+ * otherwise, instead of on a progress thread per workflow.
+ *
+ * The steps of a workflow are queued on the workflow, in order, and the
+ * workflow itself is queued on a worker when it gets its first step.
+ * A workflow is queued on or run by at most one worker at a time, so
+ * its steps run one after the other, in order, and the state they keep
+ * is never touched by two threads at once. Each workflow has a home
+ * worker it is queued on; a worker with nothing to do steals the
+ * workflow queued last on another worker, and a worker hands a
+ * workflow back to its queue after EXECUTOR_BUDGET steps so that busy
+ * workflows do not starve the others.
+ *
+ * Each worker counts the steps it ran, the workflows it stole, and the
+ * time the steps spent queued - octl reads them with "analytics stats".
+ */
+
+#define EXECUTOR_BUDGET      64
+#define EXECUTOR_QUEUE_INIT  16
+#define EXECUTOR_IDLE_USEC   100000
+#define EXECUTOR_SPINS       16
+
+orcm_analytics_base_executor_t orcm_analytics_base_executor = {0};
+
+static uint64_t now_usec(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* the worker lock must be held */
+static int push(orcm_analytics_base_worker_t *w, orcm_workflow_t *wf)
+{
+    orcm_workflow_t **queue;
+    int i;
+
+    if (w->count == w->size) {
+        queue = (orcm_workflow_t**)malloc(2 * w->size * sizeof(orcm_workflow_t*));
+        if (NULL == queue) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        for (i=0; i < w->count; i++) {
+            queue[i] = w->queue[(w->head + i) % w->size];
+        }
+        free(w->queue);
+        w->queue = queue;
+        w->head = 0;
+        w->size *= 2;
+    }
+    w->queue[(w->head + w->count) % w->size] = wf;
+    w->count++;
+    return ORCM_SUCCESS;
+}
+
+static orcm_workflow_t* pop_head(orcm_analytics_base_worker_t *w)
+{
+    orcm_workflow_t *wf = NULL;
+
+    pthread_mutex_lock(&w->lock);
+    if (0 < w->count) {
+        wf = w->queue[w->head];
+        w->head = (w->head + 1) % w->size;
+        w->count--;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return wf;
+}
+
+static orcm_workflow_t* steal(orcm_analytics_base_worker_t *me)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+    orcm_analytics_base_worker_t *w;
+    orcm_workflow_t *wf = NULL;
+    int i;
+
+    for (i=1; i < ex->nworkers && NULL == wf; i++) {
+        w = &ex->workers[(me->id + i) % ex->nworkers];
+        if (0 == w->count) {
+            continue;
+        }
+        pthread_mutex_lock(&w->lock);
+        if (0 < w->count) {
+            w->count--;
+            wf = w->queue[(w->head + w->count) % w->size];
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    if (NULL != wf) {
+        me->steals++;
+    }
+    return wf;
+}
+
+/* wake a sleeping worker, if any, to steal from a busy one */
+static void wake_idle(orcm_analytics_base_worker_t *busy)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+    orcm_analytics_base_worker_t *w;
+    int i;
+
+    for (i=1; i < ex->nworkers; i++) {
+        w = &ex->workers[(busy->id + i) % ex->nworkers];
+        if (w->sleeping) {
+            pthread_mutex_lock(&w->lock);
+            pthread_cond_signal(&w->cond);
+            pthread_mutex_unlock(&w->lock);
+            return;
+        }
+    }
+}
+
+/* drop the queued steps of a workflow no worker holds */
+static void drop_workflow(orcm_workflow_t *wf)
+{
+    orcm_workflow_caddy_t *caddy;
+
+    opal_mutex_lock(&wf->lock);
+    while (NULL != (caddy = (orcm_workflow_caddy_t*)opal_list_remove_first(&wf->tasks))) {
+        opal_mutex_unlock(&wf->lock);
+        OBJ_RELEASE(caddy);
+        opal_mutex_lock(&wf->lock);
+    }
+    wf->scheduled = false;
+    opal_mutex_unlock(&wf->lock);
+    OBJ_RELEASE(wf);
+}
+
+static void enqueue(orcm_analytics_base_worker_t *w, orcm_workflow_t *wf)
+{
+    bool sleeping;
+    int rc;
+
+    pthread_mutex_lock(&w->lock);
+    rc = push(w, wf);
+    sleeping = w->sleeping;
+    if (sleeping) {
+        pthread_cond_signal(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    if (ORCM_SUCCESS != rc) {
+        /* nowhere to put it - drop its steps */
+        ORTE_ERROR_LOG(rc);
+        drop_workflow(wf);
+        return;
+    }
+    if (!sleeping) {
+        wake_idle(w);
+    }
+}
+
+/* run the queued steps of a workflow, until there are none left or the
+ * budget is spent */
+static void run_workflow(orcm_analytics_base_worker_t *w, orcm_workflow_t *wf)
+{
+    orcm_workflow_caddy_t *caddy;
+    uint64_t wait;
+    int n;
+
+    for (n=0; ; n++) {
+        opal_mutex_lock(&wf->lock);
+        if (EXECUTOR_BUDGET == n && 0 < opal_list_get_size(&wf->tasks)) {
+            /* still scheduled - back in line */
+            opal_mutex_unlock(&wf->lock);
+            enqueue(w, wf);
+            return;
+        }
+        caddy = (orcm_workflow_caddy_t*)opal_list_remove_first(&wf->tasks);
+        if (NULL == caddy) {
+            wf->scheduled = false;
+            opal_mutex_unlock(&wf->lock);
+            OBJ_RELEASE(wf);
+            return;
+        }
+        opal_mutex_unlock(&wf->lock);
+
+        wait = now_usec() - caddy->queued;
+        w->wait_usec += wait;
+        if (wait > w->max_wait_usec) {
+            w->max_wait_usec = wait;
+        }
+        w->tasks++;
+        /* fused steps run in this call */
+        wf->runner = &w->thread;
+        caddy->imod->analyze(-1, 0, caddy);
+        wf->runner = NULL;
+    }
+}
+
+static void* worker_main(opal_object_t *obj)
+{
+    opal_thread_t *t = (opal_thread_t*)obj;
+    orcm_analytics_base_worker_t *w = (orcm_analytics_base_worker_t*)t->t_arg;
+    orcm_workflow_t *wf;
+    struct timespec until;
+    uint64_t deadline;
+    int spins = 0;
+
+    while (orcm_analytics_base_executor.active) {
+        if (NULL == (wf = pop_head(w)) && NULL == (wf = steal(w))) {
+            /* steps come in bursts - let the thread queueing them go on
+             * for a bit before paying for a sleep and a wakeup */
+            if (spins < EXECUTOR_SPINS) {
+                spins++;
+                sched_yield();
+                continue;
+            }
+            spins = 0;
+            /* nothing to do - sleep until something is queued here, or
+             * for a while so as to look for work to steal */
+            pthread_mutex_lock(&w->lock);
+            if (0 == w->count && orcm_analytics_base_executor.active) {
+                w->sleeping = true;
+                deadline = now_usec() + EXECUTOR_IDLE_USEC;
+                until.tv_sec = deadline / 1000000;
+                until.tv_nsec = (deadline % 1000000) * 1000;
+                pthread_cond_timedwait(&w->cond, &w->lock, &until);
+                w->sleeping = false;
+            }
+            pthread_mutex_unlock(&w->lock);
+            continue;
+        }
+        spins = 0;
+        run_workflow(w, wf);
+    }
+    return OPAL_THREAD_CANCELLED;
+}
+
+int orcm_analytics_base_executor_start(void)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+    orcm_analytics_base_worker_t *w;
+    int i, rc;
+
+    if (ex->active) {
+        return ORCM_SUCCESS;
+    }
+    ex->nworkers = ex->num_workers;
+    if (0 >= ex->nworkers) {
+        ex->nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (0 >= ex->nworkers) {
+            ex->nworkers = 1;
+        }
+    }
+    ex->workers = (orcm_analytics_base_worker_t*)calloc(ex->nworkers,
+                                                        sizeof(orcm_analytics_base_worker_t));
+    if (NULL == ex->workers) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        w->id = i;
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->cond, NULL);
+        OBJ_CONSTRUCT(&w->thread, opal_thread_t);
+        w->size = EXECUTOR_QUEUE_INIT;
+        if (NULL == (w->queue = (orcm_workflow_t**)malloc(w->size * sizeof(orcm_workflow_t*)))) {
+            ex->nworkers = i + 1;
+            orcm_analytics_base_executor_stop();
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+    }
+
+    ex->active = true;
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        w->thread.t_run = worker_main;
+        w->thread.t_arg = w;
+        if (OPAL_SUCCESS != (rc = opal_thread_start(&w->thread))) {
+            ORTE_ERROR_LOG(rc);
+            /* the ones started are joined */
+            ex->nworkers = i;
+            orcm_analytics_base_executor_stop();
+            return rc;
+        }
+    }
+
+    opal_output_verbose(2, orcm_analytics_base_framework.framework_output,
+                        "%s analytics:base:executor started %d workers",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), ex->nworkers);
+    return ORCM_SUCCESS;
+}
+
+void orcm_analytics_base_executor_stop(void)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+    orcm_analytics_base_worker_t *w;
+    orcm_workflow_t *wf;
+    bool started = ex->active;
+    int i;
+
+    if (NULL == ex->workers) {
+        return;
+    }
+    ex->active = false;
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        if (started) {
+            opal_thread_join(&w->thread, NULL);
+        }
+        OBJ_DESTRUCT(&w->thread);
+    }
+    /* what was never run */
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        while (NULL != (wf = pop_head(w))) {
+            drop_workflow(wf);
+        }
+        free(w->queue);
+        pthread_mutex_destroy(&w->lock);
+        pthread_cond_destroy(&w->cond);
+    }
+    free(ex->workers);
+    ex->workers = NULL;
+    ex->nworkers = 0;
+}
+
+void orcm_analytics_base_executor_add_workflow(orcm_workflow_t *wf)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+
+    wf->worker = (0 < ex->nworkers) ? ex->next_worker++ % ex->nworkers : 0;
+    wf->ev_active = true;
+}
+
+void orcm_analytics_base_executor_stop_workflow(orcm_workflow_t *wf)
+{
+    orcm_workflow_caddy_t *caddy;
+    bool scheduled;
+
+    opal_mutex_lock(&wf->lock);
+    wf->ev_active = false;
+    while (NULL != (caddy = (orcm_workflow_caddy_t*)opal_list_remove_first(&wf->tasks))) {
+        opal_mutex_unlock(&wf->lock);
+        OBJ_RELEASE(caddy);
+        opal_mutex_lock(&wf->lock);
+    }
+    scheduled = wf->scheduled;
+    opal_mutex_unlock(&wf->lock);
+
+    /* a worker running it finds no more steps, unless it is queued
+     * where no worker will ever look */
+    while (scheduled && orcm_analytics_base_executor.active) {
+        usleep(1000);
+        opal_mutex_lock(&wf->lock);
+        scheduled = wf->scheduled;
+        opal_mutex_unlock(&wf->lock);
+    }
+}
+
+void orcm_analytics_base_executor_submit(orcm_workflow_caddy_t *caddy)
+{
+    orcm_workflow_t *wf = caddy->wf;
+    bool queue = false;
+
+    caddy->queued = now_usec();
+    opal_mutex_lock(&wf->lock);
+    if (!wf->ev_active) {
+        /* the workflow is being deleted */
+        opal_mutex_unlock(&wf->lock);
+        OBJ_RELEASE(caddy);
+        return;
+    }
+    opal_list_append(&wf->tasks, &caddy->super);
+    if (!wf->scheduled) {
+        /* the queue holds the workflow until it has no more steps */
+        wf->scheduled = true;
+        OBJ_RETAIN(wf);
+        queue = true;
+    }
+    opal_mutex_unlock(&wf->lock);
+
+    if (queue) {
+        enqueue(&orcm_analytics_base_executor.workers[wf->worker], wf);
+    }
+}
+
+int orcm_analytics_base_executor_pack_stats(opal_buffer_t *buffer)
+{
+    orcm_analytics_base_executor_t *ex = &orcm_analytics_base_executor;
+    orcm_analytics_base_worker_t *w;
+    uint64_t stats[5];
+    int i, rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &ex->nworkers, 1, OPAL_INT))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    for (i=0; i < ex->nworkers; i++) {
+        w = &ex->workers[i];
+        pthread_mutex_lock(&w->lock);
+        stats[0] = w->tasks;
+        stats[1] = w->steals;
+        stats[2] = w->wait_usec;
+        stats[3] = w->max_wait_usec;
+        stats[4] = w->count;
+        pthread_mutex_unlock(&w->lock);
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, stats, 5, OPAL_UINT64))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
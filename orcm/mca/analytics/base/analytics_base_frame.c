@@ -17,7 +17,6 @@
 #include "opal/mca/event/event.h"
 #include "opal/dss/dss.h"
 #include "opal/util/output.h"
-#include "opal/runtime/opal_progress_threads.h"
 
 #include "orte/mca/errmgr/errmgr.h"
 
@@ -33,7 +32,7 @@
 #include "orcm/mca/analytics/base/static-components.h"
 
 static void orcm_analytics_stop_wokflow_step(orcm_workflow_step_t *wf_step);
-static void orcm_analytics_stop_wokflow_thread(orcm_workflow_t *wf);
+static int orcm_analytics_base_register(mca_base_register_flag_t flags);
 static int orcm_analytics_base_close(void);
 static int orcm_analytics_base_open(mca_base_open_flag_t flags);
 
@@ -48,6 +47,17 @@ orcm_analytics_API_module_t orcm_analytics = {
 };
 orcm_analytics_base_wf_t orcm_analytics_base_wf;
 
+static void orcm_analytics_flush_wokflow_step(orcm_workflow_t *wf,
+                                              orcm_workflow_step_t *wf_step)
+{
+    orcm_analytics_base_module_t *module = NULL;
+
+    module = (orcm_analytics_base_module_t *)wf_step->mod;
+    if (NULL != module && NULL != module->flush) {
+        module->flush(wf_step->mod, wf, wf_step);
+    }
+}
+
 static void orcm_analytics_stop_wokflow_step(orcm_workflow_step_t *wf_step)
 {
     orcm_analytics_base_module_t *module = NULL;
@@ -56,27 +66,40 @@ static void orcm_analytics_stop_wokflow_step(orcm_workflow_step_t *wf_step)
     module->finalize(wf_step->mod);
 }
 
-static void orcm_analytics_stop_wokflow_thread(orcm_workflow_t *wf)
+static int orcm_analytics_base_register(mca_base_register_flag_t flags)
 {
-    char *threadname = NULL;
-
-    if (NULL != wf && false != wf->ev_active) {
-        wf->ev_active = false;
-        /* Stop each Workflow thread */
-        asprintf(&threadname, "wfid%i", wf->workflow_id);
-        opal_progress_thread_finalize(threadname);
-    }
-    free(threadname);
+    orcm_analytics_base_executor.num_workers = 0;
+    (void)mca_base_var_register("orcm", "analytics", "base", "num_workers",
+                                "Number of threads running the workflow steps (0 for one per core)",
+                                MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_analytics_base_executor.num_workers);
+    orcm_analytics_base_fuse_steps = true;
+    (void)mca_base_var_register("orcm", "analytics", "base", "fuse_steps",
+                                "Run chained workflow steps in a single call instead of "
+                                "queueing each one (disable to debug the steps one by one)",
+                                MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_analytics_base_fuse_steps);
+    return ORCM_SUCCESS;
 }
 
 void orcm_analytics_stop_wokflow(orcm_workflow_t *wf)
 {
     orcm_workflow_step_t *wf_step = NULL;
 
+    /* no more samples, and no worker may be running a step when the
+     * modules go */
+    orcm_analytics_base_unsubscribe(wf);
+    orcm_analytics_base_aggregate_unregister(wf);
+    orcm_analytics_base_executor_stop_workflow(wf);
     OPAL_LIST_FOREACH (wf_step, &wf->steps, orcm_workflow_step_t) {
+        orcm_analytics_flush_wokflow_step(wf, wf_step);
+        orcm_analytics_base_db_stop(wf, wf_step);
         orcm_analytics_stop_wokflow_step(wf_step);
     }
-    orcm_analytics_stop_wokflow_thread(wf);
 
 }
 
@@ -88,6 +111,7 @@ static int orcm_analytics_base_close(void)
         orcm_analytics_stop_wokflow(wf);
     }
     orcm_analytics_base_comm_stop();
+    orcm_analytics_base_executor_stop();
 
     /* Destroy the base objects */
     OPAL_LIST_DESTRUCT(&orcm_analytics_base_wf.workflows);
@@ -95,6 +119,12 @@ static int orcm_analytics_base_close(void)
     /* close the database handle */
     orcm_analytics_base_close_db();
 
+    orcm_analytics_base_subscriptions_finalize();
+    orcm_analytics_base_aggregates_finalize();
+
+    /* the values still around no longer have keys */
+    orcm_analytics_base_keys_finalize();
+
     return mca_base_framework_components_close(&orcm_analytics_base_framework,
                                                NULL);
 }
@@ -109,6 +139,9 @@ static int orcm_analytics_base_open(mca_base_open_flag_t flags)
 
     /* setup the base objects */
     OBJ_CONSTRUCT(&orcm_analytics_base_wf.workflows, opal_list_t);
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_subscriptions_init();
+    orcm_analytics_base_aggregates_init();
 
     rc = mca_base_framework_components_open(&orcm_analytics_base_framework, flags);
     if (OPAL_SUCCESS != rc) {
@@ -127,7 +160,7 @@ static int orcm_analytics_base_open(mca_base_open_flag_t flags)
     return rc;
 }
 
-MCA_BASE_FRAMEWORK_DECLARE(orcm, analytics, NULL, NULL,
+MCA_BASE_FRAMEWORK_DECLARE(orcm, analytics, NULL, orcm_analytics_base_register,
                            orcm_analytics_base_open, orcm_analytics_base_close,
                            mca_analytics_base_static_components, 0);
 
@@ -137,6 +170,10 @@ static void wkstep_con(orcm_workflow_step_t *p)
     OBJ_CONSTRUCT(&p->attributes, opal_list_t);
     p->analytic = NULL;
     p->mod = NULL;
+    p->db_buffer = NULL;
+    p->fused = false;
+    p->caddy = NULL;
+    p->output = NULL;
 }
 static void wkstep_des(orcm_workflow_step_t *p)
 {
@@ -145,6 +182,15 @@ static void wkstep_des(orcm_workflow_step_t *p)
     }
     OPAL_LIST_DESTRUCT(&p->attributes);
     free(p->analytic);
+    if (NULL != p->db_buffer) {
+        OBJ_RELEASE(p->db_buffer);
+    }
+    if (NULL != p->caddy) {
+        OBJ_RELEASE(p->caddy);
+    }
+    if (NULL != p->output) {
+        OBJ_RELEASE(p->output);
+    }
 }
 OBJ_CLASS_INSTANCE(orcm_workflow_step_t,
                    opal_list_item_t,
@@ -155,6 +201,12 @@ static void wk_con(orcm_workflow_t *p)
     p->name = NULL;
     OBJ_CONSTRUCT(&p->steps, opal_list_t);
     p->ev_base = NULL;
+    p->ev_active = false;
+    OBJ_CONSTRUCT(&p->lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&p->tasks, opal_list_t);
+    p->scheduled = false;
+    p->worker = 0;
+    p->runner = NULL;
 }
 static void wk_des(orcm_workflow_t *p)
 {
@@ -162,10 +214,12 @@ static void wk_des(orcm_workflow_t *p)
         return;
     }
     if (NULL != p->ev_base) {
-        orcm_analytics_stop_wokflow_thread(p);
+        opal_event_base_free(p->ev_base);
     }
     free(p->name);
     OPAL_LIST_DESTRUCT(&p->steps);
+    OPAL_LIST_DESTRUCT(&p->tasks);
+    OBJ_DESTRUCT(&p->lock);
 }
 OBJ_CLASS_INSTANCE(orcm_workflow_t,
                    opal_list_item_t,
@@ -173,6 +227,7 @@ OBJ_CLASS_INSTANCE(orcm_workflow_t,
 
 static void wkcaddy_con(orcm_workflow_caddy_t *p)
 {
+    p->queued = 0;
     p->wf = NULL;
     p->wf_step = NULL;
     p->data = NULL;
@@ -183,29 +238,29 @@ static void wkcaddy_des(orcm_workflow_caddy_t *p)
     if (NULL == p) {
         return;
     }
-    OBJ_RELEASE(p->wf);
-    OBJ_RELEASE(p->wf_step);
-    OBJ_RELEASE(p->data);
+    /* a caddy a step keeps for its fused runs holds nothing between them */
+    if (NULL != p->wf) {
+        OBJ_RELEASE(p->wf);
+    }
+    if (NULL != p->wf_step) {
+        OBJ_RELEASE(p->wf_step);
+    }
+    if (NULL != p->data) {
+        OBJ_RELEASE(p->data);
+    }
 }
 OBJ_CLASS_INSTANCE(orcm_workflow_caddy_t,
-                   opal_object_t,
+                   opal_list_item_t,
                    wkcaddy_con, wkcaddy_des);
 
+/* the strings of a value belong to its interned key */
 static void value_con(orcm_analytics_value_t *p)
 {
+    p->key_id = ORCM_ANALYTICS_KEY_INVALID;
     p->comma_sep_plugin_list = NULL;
     p->sensor_name = NULL;
     p->node_regex = NULL;
 }
-static void value_des(orcm_analytics_value_t *p)
-{
-    if (NULL == p) {
-        return;
-    }
-    free(p->comma_sep_plugin_list);
-    free(p->sensor_name);
-    free(p->node_regex);
-}
 OBJ_CLASS_INSTANCE(orcm_analytics_value_t,
                    opal_object_t,
-                   value_con, value_des);
+                   value_con, NULL);
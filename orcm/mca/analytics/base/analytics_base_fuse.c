@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <string.h>
+
+#include "opal/util/output.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Step fusion
+ *
+ * The steps of a workflow all work on a batch of samples as it comes and
+ * hand on what they make of it right away, so a step gains nothing from
+ * being queued on the executor behind the one before it: the workflow is
+ * run by a single worker at a time anyway. When a workflow is created,
+ * each step after the first is marked as fused to the one before it,
+ * unless either says fuse=no or analytics_base_fuse_steps is off. A
+ * fused step activated by the step before it, on the worker running the
+ * workflow, is called there and then - a chain of fused steps takes a
+ * single executor task per batch.
+ *
+ * A fused step keeps the caddy it is called with, and the steps creating
+ * their output array with orcm_analytics_base_step_array() keep that
+ * array, both to be reused by the next batch once the steps after are
+ * done with them - which, when they are fused, is by the time the step
+ * returns.
+ */
+
+bool orcm_analytics_base_fuse_steps = true;
+
+static bool fuse_disabled(orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL != attr->key && 0 == strcmp(attr->key, "fuse") &&
+            OPAL_STRING == attr->type && 0 == strcmp(attr->data.string, "no")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void orcm_analytics_base_workflow_fuse(orcm_workflow_t *wf)
+{
+    orcm_workflow_step_t *wf_step, *prev = NULL;
+    int nfused = 0;
+
+    OPAL_LIST_FOREACH(wf_step, &wf->steps, orcm_workflow_step_t) {
+        wf_step->fused = (orcm_analytics_base_fuse_steps && NULL != prev &&
+                          !fuse_disabled(prev) && !fuse_disabled(wf_step));
+        if (wf_step->fused) {
+            nfused++;
+            opal_output_verbose(5, orcm_analytics_base_framework.framework_output,
+                                "%s analytics:base:fuse workflow %d: %s runs with %s",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), wf->workflow_id,
+                                wf_step->analytic, prev->analytic);
+        }
+        prev = wf_step;
+    }
+    opal_output_verbose(2, orcm_analytics_base_framework.framework_output,
+                        "%s analytics:base:fuse workflow %d: %d of %d steps fused",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), wf->workflow_id,
+                        nfused, (int)opal_list_get_size(&wf->steps));
+}
+
+/* a caddy is free for the next batch when only its step holds it */
+static bool idle(opal_object_t *obj)
+{
+    return 1 == obj->obj_reference_count;
+}
+
+bool orcm_analytics_base_run_fused(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step,
+                                   opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    bool kept;
+
+    if (!wf_step->fused || NULL == wf->runner || !opal_thread_self_compare(wf->runner)) {
+        return false;
+    }
+
+    if (NULL == wf_step->caddy) {
+        wf_step->caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    }
+    caddy = wf_step->caddy;
+    kept = (NULL != caddy && idle(&caddy->super.super));
+    if (kept) {
+        OBJ_RETAIN(caddy);
+    } else if (NULL == (caddy = OBJ_NEW(orcm_workflow_caddy_t))) {
+        return false;
+    }
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(wf_step);
+    caddy->wf_step = wf_step;
+    /* data was retain'd before it got here */
+    caddy->data = data;
+    caddy->imod = wf_step->mod;
+
+    caddy->imod->analyze(-1, 0, caddy);
+
+    if (!kept) {
+        return true;
+    }
+    if (idle(&caddy->super.super)) {
+        /* what the caddy destructor would have let go */
+        OBJ_RELEASE(caddy->wf);
+        caddy->wf = NULL;
+        OBJ_RELEASE(caddy->wf_step);
+        caddy->wf_step = NULL;
+        if (NULL != caddy->data) {
+            OBJ_RELEASE(caddy->data);
+            caddy->data = NULL;
+        }
+    } else {
+        /* the step held on to it - it is the step's to release now */
+        wf_step->caddy = NULL;
+        OBJ_RELEASE(caddy);
+    }
+    return true;
+}
+
+int orcm_analytics_base_step_array(orcm_workflow_step_t *wf_step,
+                                   opal_value_array_t **array, int size)
+{
+    opal_value_array_t *output = wf_step->output;
+    int rc;
+
+    if (NULL == output || !idle(&output->super)) {
+        rc = orcm_analytics_base_array_create(array, size);
+        if (ORCM_SUCCESS != rc || NULL != output) {
+            return rc;
+        }
+        /* keep it for the next batch */
+        OBJ_RETAIN(*array);
+        wf_step->output = *array;
+        return ORCM_SUCCESS;
+    }
+
+    if (OPAL_SUCCESS != (rc = opal_value_array_set_size(output, 0)) ||
+        OPAL_SUCCESS != (rc = opal_value_array_reserve(output, size))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    OBJ_RETAIN(output);
+    *array = output;
+    return ORCM_SUCCESS;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <string.h>
+
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Key interning
+ *
+ * Every (node, sensor, index, label) that enters analytics is given a
+ * stable integer id the first time it is seen. The key keeps the only
+ * copy of its strings - the values carry the id and point at them - so
+ * appending a sample costs one hash lookup and no allocation, and the
+ * workflow steps keep their state in flat arrays indexed by id instead
+ * of building and hashing a string key per sample.
+ *
+ * Ids are never reused, and keys live until the framework closes.
+ */
+
+/* longest (node, sensor, index, label) that can be interned */
+#define ANALYTICS_KEY_MAX 1024
+
+orcm_analytics_base_keys_t orcm_analytics_base_keys = {0};
+
+static void key_con(orcm_analytics_key_t *p)
+{
+    p->id = ORCM_ANALYTICS_KEY_INVALID;
+    p->node_regex = NULL;
+    p->sensor_name = NULL;
+    p->index = 0;
+    p->label = NULL;
+    p->units = NULL;
+}
+static void key_des(orcm_analytics_key_t *p)
+{
+    free(p->node_regex);
+    free(p->sensor_name);
+    free(p->label);
+    free(p->units);
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_key_t,
+                   opal_object_t,
+                   key_con, key_des);
+
+void orcm_analytics_base_keys_init(void)
+{
+    if (orcm_analytics_base_keys.initialized) {
+        return;
+    }
+    OBJ_CONSTRUCT(&orcm_analytics_base_keys.lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&orcm_analytics_base_keys.keys, opal_pointer_array_t);
+    opal_pointer_array_init(&orcm_analytics_base_keys.keys, 1024, INT32_MAX, 1024);
+    OBJ_CONSTRUCT(&orcm_analytics_base_keys.ids, opal_hash_table_t);
+    opal_hash_table_init(&orcm_analytics_base_keys.ids, 4096);
+    orcm_analytics_base_keys.num_keys = 0;
+    orcm_analytics_base_keys.initialized = true;
+}
+
+void orcm_analytics_base_keys_finalize(void)
+{
+    orcm_analytics_key_t *key;
+    uint32_t i;
+
+    if (!orcm_analytics_base_keys.initialized) {
+        return;
+    }
+    for (i=0; i < orcm_analytics_base_keys.num_keys; i++) {
+        key = (orcm_analytics_key_t*)opal_pointer_array_get_item(&orcm_analytics_base_keys.keys,
+                                                                 (int)i);
+        if (NULL != key) {
+            OBJ_RELEASE(key);
+        }
+    }
+    OBJ_DESTRUCT(&orcm_analytics_base_keys.keys);
+    OBJ_DESTRUCT(&orcm_analytics_base_keys.ids);
+    OBJ_DESTRUCT(&orcm_analytics_base_keys.lock);
+    orcm_analytics_base_keys.initialized = false;
+}
+
+static orcm_analytics_key_t* key_intern(const char *node_regex, const char *sensor_name,
+                                        int index, const char *label, const char *units)
+{
+    orcm_analytics_key_t *key = NULL;
+    char buf[ANALYTICS_KEY_MAX];
+    size_t nlen, slen, llen, len;
+
+    if (NULL == node_regex || NULL == sensor_name || NULL == label) {
+        return NULL;
+    }
+    /* the framework open does this before any sampling starts */
+    if (!orcm_analytics_base_keys.initialized) {
+        orcm_analytics_base_keys_init();
+    }
+
+    /* node, sensor, index and label separated by NULs */
+    nlen = strlen(node_regex) + 1;
+    slen = strlen(sensor_name) + 1;
+    llen = strlen(label);
+    len = nlen + slen + sizeof(int) + llen;
+    if (sizeof(buf) < len) {
+        return NULL;
+    }
+    memcpy(buf, node_regex, nlen);
+    memcpy(buf + nlen, sensor_name, slen);
+    memcpy(buf + nlen + slen, &index, sizeof(int));
+    memcpy(buf + nlen + slen + sizeof(int), label, llen);
+
+    opal_mutex_lock(&orcm_analytics_base_keys.lock);
+    if (OPAL_SUCCESS == opal_hash_table_get_value_ptr(&orcm_analytics_base_keys.ids,
+                                                      buf, len, (void**)&key)) {
+        opal_mutex_unlock(&orcm_analytics_base_keys.lock);
+        return key;
+    }
+
+    key = OBJ_NEW(orcm_analytics_key_t);
+    key->id = orcm_analytics_base_keys.num_keys;
+    key->node_regex = strdup(node_regex);
+    key->sensor_name = strdup(sensor_name);
+    key->index = index;
+    key->label = strdup(label);
+    key->units = (NULL == units) ? NULL : strdup(units);
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&orcm_analytics_base_keys.keys,
+                                                    (int)key->id, key) ||
+        OPAL_SUCCESS != opal_hash_table_set_value_ptr(&orcm_analytics_base_keys.ids,
+                                                      buf, len, key)) {
+        opal_pointer_array_set_item(&orcm_analytics_base_keys.keys, (int)key->id, NULL);
+        opal_mutex_unlock(&orcm_analytics_base_keys.lock);
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        OBJ_RELEASE(key);
+        return NULL;
+    }
+    orcm_analytics_base_keys.num_keys++;
+    opal_mutex_unlock(&orcm_analytics_base_keys.lock);
+
+    OPAL_OUTPUT_VERBOSE((10, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:base:key %u is %s:%s:%d:%s",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), key->id,
+                         node_regex, sensor_name, index, label));
+    return key;
+}
+
+uint32_t orcm_analytics_base_key_intern(const char *node_regex, const char *sensor_name,
+                                        int index, const char *label, const char *units)
+{
+    orcm_analytics_key_t *key;
+
+    if (NULL == (key = key_intern(node_regex, sensor_name, index, label, units))) {
+        return ORCM_ANALYTICS_KEY_INVALID;
+    }
+    return key->id;
+}
+
+orcm_analytics_key_t* orcm_analytics_base_key_get(uint32_t id)
+{
+    orcm_analytics_key_t *key;
+
+    if (!orcm_analytics_base_keys.initialized || ORCM_ANALYTICS_KEY_INVALID == id) {
+        return NULL;
+    }
+    /* workflow steps run on the executor threads while samples are
+     * interned, and the array may be growing */
+    opal_mutex_lock(&orcm_analytics_base_keys.lock);
+    key = (orcm_analytics_key_t*)opal_pointer_array_get_item(&orcm_analytics_base_keys.keys,
+                                                             (int)id);
+    opal_mutex_unlock(&orcm_analytics_base_keys.lock);
+    return key;
+}
+
+uint32_t orcm_analytics_base_num_keys(void)
+{
+    return orcm_analytics_base_keys.num_keys;
+}
+
+static void value_point_at(orcm_analytics_value_t *value, orcm_analytics_key_t *key)
+{
+    value->key_id = key->id;
+    value->node_regex = key->node_regex;
+    value->sensor_name = key->sensor_name;
+    value->data.value.key = key->label;
+    value->data.units = key->units;
+}
+
+int orcm_analytics_base_value_set_key(orcm_analytics_value_t *value, uint32_t id)
+{
+    orcm_analytics_key_t *key;
+
+    if (NULL == (key = orcm_analytics_base_key_get(id))) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    value_point_at(value, key);
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_value_intern(orcm_analytics_value_t *value,
+                                     const char *node_regex, const char *sensor_name,
+                                     int index, const char *label, const char *units)
+{
+    orcm_analytics_key_t *key;
+
+    if (NULL == (key = key_intern(node_regex, sensor_name, index, label, units))) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    value_point_at(value, key);
+    return ORCM_SUCCESS;
+}
+
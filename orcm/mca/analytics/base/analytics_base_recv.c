@@ -174,6 +174,14 @@ static void orcm_analytics_base_recv(int status, orte_process_name_t* sender,
         case ORCM_ANALYTICS_WORKFLOW_LIST:
             ret = orcm_analytics_base_workflow_list(ans);
             break;
+        case ORCM_ANALYTICS_EXECUTOR_STATS:
+            ret = orcm_analytics_base_executor_pack_stats(ans);
+            break;
+        case ORCM_ANALYTICS_AGGREGATE:
+            /* partial aggregates from a child - nothing to answer */
+            orcm_analytics_base_aggregate_recv(sender, buffer);
+            OBJ_RELEASE(ans);
+            return;
         default:
             OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
                                  "%s analytics:base:receive got unknown command from %s",
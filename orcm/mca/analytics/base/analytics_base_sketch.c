@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "opal/dss/dss.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Quantile sketches
+ *
+ * A sketch counts values in logarithmic buckets (DDSketch): with
+ * gamma = (1 + accuracy) / (1 - accuracy), a positive value x goes in
+ * bucket ceil(log(x) / log(gamma)), negative ones likewise in a bucket
+ * of their own sign, and values too close to zero are only counted.
+ * Any quantile read back is then within the relative accuracy of the
+ * true one, whatever the distribution, and sketches of the same
+ * accuracy merge exactly by adding their counts - so sketches kept
+ * anywhere can be shipped and merged instead of the samples.
+ *
+ * The buckets of each sign are a dense range, limited to max_bins: when
+ * a value falls further away, the lowest buckets are folded into the
+ * lowest one kept, giving up accuracy on the smallest values first.
+ */
+
+/* values closer to zero are counted as zero */
+#define SKETCH_MIN_VALUE 1.0e-9
+
+static void sketch_con(orcm_analytics_sketch_t *p)
+{
+    p->accuracy = 0.0;
+    p->gamma = 1.0;
+    p->log_gamma = 0.0;
+    p->max_bins = 0;
+    memset(&p->positive, 0, sizeof(p->positive));
+    memset(&p->negative, 0, sizeof(p->negative));
+    p->zero = 0;
+    p->count = 0;
+    p->min = 0.0;
+    p->max = 0.0;
+    p->sum = 0.0;
+}
+static void sketch_des(orcm_analytics_sketch_t *p)
+{
+    free(p->positive.counts);
+    free(p->negative.counts);
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_sketch_t,
+                   opal_object_t,
+                   sketch_con, sketch_des);
+
+int orcm_analytics_base_sketch_init(orcm_analytics_sketch_t *sketch,
+                                    double accuracy, int max_bins)
+{
+    if (NULL == sketch || 0.0 >= accuracy || 1.0 <= accuracy || 0 >= max_bins) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    orcm_analytics_base_sketch_reset(sketch);
+    sketch->accuracy = accuracy;
+    sketch->gamma = (1.0 + accuracy) / (1.0 - accuracy);
+    sketch->log_gamma = log(sketch->gamma);
+    sketch->max_bins = max_bins;
+    return ORCM_SUCCESS;
+}
+
+void orcm_analytics_base_sketch_reset(orcm_analytics_sketch_t *sketch)
+{
+    free(sketch->positive.counts);
+    free(sketch->negative.counts);
+    memset(&sketch->positive, 0, sizeof(sketch->positive));
+    memset(&sketch->negative, 0, sizeof(sketch->negative));
+    sketch->zero = 0;
+    sketch->count = 0;
+    sketch->min = 0.0;
+    sketch->max = 0.0;
+    sketch->sum = 0.0;
+}
+
+/* make the buckets cover lo..hi, folding those below lo into it */
+static int store_extend(orcm_analytics_sketch_store_t *st, int lo, int hi)
+{
+    uint64_t *counts;
+    int i, j;
+
+    counts = (uint64_t*)calloc(hi - lo + 1, sizeof(uint64_t));
+    if (NULL == counts) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    for (i=0; i < st->nbins; i++) {
+        j = st->offset + i - lo;
+        counts[(0 > j) ? 0 : j] += st->counts[i];
+    }
+    free(st->counts);
+    st->counts = counts;
+    st->offset = lo;
+    st->nbins = hi - lo + 1;
+    return ORCM_SUCCESS;
+}
+
+static int store_add(orcm_analytics_sketch_store_t *st, int index, uint64_t n, int max_bins)
+{
+    int lo, hi, rc;
+
+    if (0 == st->nbins) {
+        lo = hi = index;
+    } else {
+        lo = (index < st->offset) ? index : st->offset;
+        hi = (index > st->offset + st->nbins - 1) ? index : st->offset + st->nbins - 1;
+    }
+    if (hi - lo + 1 > max_bins) {
+        lo = hi - max_bins + 1;
+    }
+    if (index < lo) {
+        index = lo;
+    }
+    if (0 == st->nbins || lo != st->offset || hi != st->offset + st->nbins - 1) {
+        if (ORCM_SUCCESS != (rc = store_extend(st, lo, hi))) {
+            return rc;
+        }
+    }
+    st->counts[index - st->offset] += n;
+    return ORCM_SUCCESS;
+}
+
+static int sketch_index(orcm_analytics_sketch_t *sketch, double x)
+{
+    return (int)ceil(log(x) / sketch->log_gamma);
+}
+
+/* the value a bucket stands for, within accuracy of all it counts */
+static double sketch_value(orcm_analytics_sketch_t *sketch, int index)
+{
+    return 2.0 * pow(sketch->gamma, (double)index) / (1.0 + sketch->gamma);
+}
+
+int orcm_analytics_base_sketch_add(orcm_analytics_sketch_t *sketch, double x)
+{
+    int rc = ORCM_SUCCESS;
+
+    if (0 == sketch->max_bins || isnan(x)) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (x > SKETCH_MIN_VALUE) {
+        rc = store_add(&sketch->positive, sketch_index(sketch, x), 1, sketch->max_bins);
+    } else if (x < -SKETCH_MIN_VALUE) {
+        rc = store_add(&sketch->negative, sketch_index(sketch, -x), 1, sketch->max_bins);
+    } else {
+        sketch->zero++;
+    }
+    if (ORCM_SUCCESS != rc) {
+        return rc;
+    }
+    if (0 == sketch->count || x < sketch->min) {
+        sketch->min = x;
+    }
+    if (0 == sketch->count || x > sketch->max) {
+        sketch->max = x;
+    }
+    sketch->count++;
+    sketch->sum += x;
+    return ORCM_SUCCESS;
+}
+
+static int store_merge(orcm_analytics_sketch_store_t *dst, orcm_analytics_sketch_store_t *src,
+                       int max_bins)
+{
+    int i, rc;
+
+    if (0 == src->nbins) {
+        return ORCM_SUCCESS;
+    }
+    /* cover the whole range once, rather than bucket by bucket */
+    if (ORCM_SUCCESS != (rc = store_add(dst, src->offset, 0, max_bins)) ||
+        ORCM_SUCCESS != (rc = store_add(dst, src->offset + src->nbins - 1, 0, max_bins))) {
+        return rc;
+    }
+    for (i=0; i < src->nbins; i++) {
+        if (0 != src->counts[i] &&
+            ORCM_SUCCESS != (rc = store_add(dst, src->offset + i, src->counts[i], max_bins))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_sketch_merge(orcm_analytics_sketch_t *dst,
+                                     orcm_analytics_sketch_t *src)
+{
+    int rc;
+
+    if (NULL == dst || NULL == src || dst->gamma != src->gamma) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 == src->count) {
+        return ORCM_SUCCESS;
+    }
+    if (ORCM_SUCCESS != (rc = store_merge(&dst->positive, &src->positive, dst->max_bins)) ||
+        ORCM_SUCCESS != (rc = store_merge(&dst->negative, &src->negative, dst->max_bins))) {
+        return rc;
+    }
+    if (0 == dst->count || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (0 == dst->count || src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->zero += src->zero;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    return ORCM_SUCCESS;
+}
+
+static double clamp(orcm_analytics_sketch_t *sketch, double x)
+{
+    if (x < sketch->min) {
+        return sketch->min;
+    }
+    if (x > sketch->max) {
+        return sketch->max;
+    }
+    return x;
+}
+
+double orcm_analytics_base_sketch_quantile(orcm_analytics_sketch_t *sketch, double q)
+{
+    orcm_analytics_sketch_store_t *st;
+    double rank, seen = 0.0;
+    int i;
+
+    if (0 == sketch->count) {
+        return 0.0;
+    }
+    if (0.0 > q) {
+        q = 0.0;
+    } else if (1.0 < q) {
+        q = 1.0;
+    }
+    rank = q * (double)(sketch->count - 1);
+
+    /* the most negative values first */
+    st = &sketch->negative;
+    for (i=st->nbins - 1; 0 <= i; i--) {
+        seen += (double)st->counts[i];
+        if (seen > rank) {
+            return clamp(sketch, -sketch_value(sketch, st->offset + i));
+        }
+    }
+    seen += (double)sketch->zero;
+    if (seen > rank) {
+        return clamp(sketch, 0.0);
+    }
+    st = &sketch->positive;
+    for (i=0; i < st->nbins; i++) {
+        seen += (double)st->counts[i];
+        if (seen > rank) {
+            return clamp(sketch, sketch_value(sketch, st->offset + i));
+        }
+    }
+    return sketch->max;
+}
+
+static int store_pack(opal_buffer_t *buffer, orcm_analytics_sketch_store_t *st)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &st->offset, 1, OPAL_INT)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &st->nbins, 1, OPAL_INT))) {
+        return rc;
+    }
+    if (0 < st->nbins &&
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, st->counts, st->nbins, OPAL_UINT64))) {
+        return rc;
+    }
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_sketch_pack(opal_buffer_t *buffer, orcm_analytics_sketch_t *sketch)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->accuracy, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->max_bins, 1, OPAL_INT)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->zero, 1, OPAL_UINT64)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->count, 1, OPAL_UINT64)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->min, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->max, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = opal_dss.pack(buffer, &sketch->sum, 1, OPAL_DOUBLE)) ||
+        OPAL_SUCCESS != (rc = store_pack(buffer, &sketch->positive)) ||
+        OPAL_SUCCESS != (rc = store_pack(buffer, &sketch->negative))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    return ORCM_SUCCESS;
+}
+
+static int store_unpack(opal_buffer_t *buffer, orcm_analytics_sketch_store_t *st, int max_bins)
+{
+    int32_t n = 1;
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &st->offset, &n, OPAL_INT))) {
+        return rc;
+    }
+    n = 1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &st->nbins, &n, OPAL_INT))) {
+        return rc;
+    }
+    if (0 > st->nbins || max_bins < st->nbins) {
+        st->nbins = 0;
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 == st->nbins) {
+        return ORCM_SUCCESS;
+    }
+    if (NULL == (st->counts = (uint64_t*)malloc(st->nbins * sizeof(uint64_t)))) {
+        st->nbins = 0;
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    n = st->nbins;
+    return opal_dss.unpack(buffer, st->counts, &n, OPAL_UINT64);
+}
+
+int orcm_analytics_base_sketch_unpack(opal_buffer_t *buffer, orcm_analytics_sketch_t **sketch)
+{
+    orcm_analytics_sketch_t *sk;
+    double accuracy;
+    int32_t n = 1;
+    int max_bins, rc;
+
+    *sketch = NULL;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &accuracy, &n, OPAL_DOUBLE))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    n = 1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &max_bins, &n, OPAL_INT))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    sk = OBJ_NEW(orcm_analytics_sketch_t);
+    if (NULL == sk) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_sketch_init(sk, accuracy, max_bins))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(sk);
+        return rc;
+    }
+    n = 1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sk->zero, &n, OPAL_UINT64)) ||
+        (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sk->count, &n, OPAL_UINT64))) ||
+        (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sk->min, &n, OPAL_DOUBLE))) ||
+        (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sk->max, &n, OPAL_DOUBLE))) ||
+        (n = 1, OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sk->sum, &n, OPAL_DOUBLE))) ||
+        OPAL_SUCCESS != (rc = store_unpack(buffer, &sk->positive, max_bins)) ||
+        OPAL_SUCCESS != (rc = store_unpack(buffer, &sk->negative, max_bins))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(sk);
+        return rc;
+    }
+    *sketch = sk;
+    return ORCM_SUCCESS;
+}
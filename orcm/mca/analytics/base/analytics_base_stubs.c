@@ -12,6 +12,9 @@
 #include "orcm/constants.h"
 #include "orcm/types.h"
 
+#include <string.h>
+#include <sys/time.h>
+
 #include "opal/dss/dss.h"
 #include "opal/threads/threads.h"
 #include "opal/util/output.h"
@@ -20,16 +23,12 @@
 #include "orte/mca/rml/rml.h"
 #include "orte/util/name_fns.h"
 
-#include "opal/runtime/opal_progress_threads.h"
-
 #include "orcm/mca/analytics/base/base.h"
 #include "orcm/mca/analytics/base/analytics_private.h"
 
 static orcm_workflow_t* orcm_analytics_base_workflow_object_init(int *wfid);
 static int orcm_analytics_base_workflow_step_create(orcm_workflow_t *wf,
                                                     opal_value_t **values, int i);
-static int orcm_analytics_base_create_new_workflow_event_base(orcm_workflow_t *wf);
-static int orcm_analytics_base_create_event_base(orcm_workflow_t *wf, char *threadname);
 static int orcm_analytics_base_parse_attributes(opal_list_t *attr_list, char *attr_string);
 static int orcm_analytics_base_subtokenize_attributes(char **tokens, opal_list_t *attr_list);
 static void orcm_analytics_base_append_attributes(char **subtokens, opal_list_t *attr_list);
@@ -134,6 +133,11 @@ static void orcm_analytics_base_set_event_workflow_step(orcm_workflow_t *wf,
 {
     orcm_analytics_base_module_t *module = (orcm_analytics_base_module_t *)wf_step->mod;
 
+    /* a workflow given its own event base runs there */
+    if (NULL == wf->ev_base) {
+        orcm_analytics_base_executor_submit(caddy);
+        return;
+    }
     opal_event_set(wf->ev_base, &caddy->ev, -1,
                    OPAL_EV_WRITE, module->analyze, caddy);
     opal_event_active(&caddy->ev, OPAL_EV_WRITE, 1);
@@ -145,6 +149,15 @@ void orcm_analytics_base_activate_analytics_workflow_step(orcm_workflow_t *wf,
 {
     orcm_workflow_caddy_t *caddy = NULL;
 
+#ifdef ANALYTICS_TAP_INFO
+    orcm_analytics_base_tapinfo(wf_step, data);
+#endif
+
+    /* a step fused to the one activating it runs right away */
+    if (orcm_analytics_base_run_fused(wf, wf_step, data)) {
+        return;
+    }
+
     caddy = orcm_analytics_base_create_caddy(wf, wf_step, data);
 
     if (NULL == caddy) {
@@ -154,10 +167,6 @@ void orcm_analytics_base_activate_analytics_workflow_step(orcm_workflow_t *wf,
         return;
     }
 
-#ifdef ANALYTICS_TAP_INFO
-    orcm_analytics_base_tapinfo(wf_step, data);
-#endif
-
     orcm_analytics_base_set_event_workflow_step(wf, wf_step, caddy);
 }
 
@@ -222,29 +231,6 @@ static int orcm_analytics_base_parse_attributes(opal_list_t *attr_list, char *at
     return ret;
 }
 
-static int orcm_analytics_base_create_event_base(orcm_workflow_t *wf, char *threadname)
-{
-
-    wf->ev_active = true;
-    if (NULL == (wf->ev_base = opal_progress_thread_init(threadname))) {
-        wf->ev_active = false;
-        return ORCM_ERR_OUT_OF_RESOURCE;
-    }
-    return ORCM_SUCCESS;
-}
-
-static int orcm_analytics_base_create_new_workflow_event_base(orcm_workflow_t *wf)
-{
-    int rc;
-    char *threadname = NULL;
-
-    asprintf(&threadname, "wfid%i", wf->workflow_id);
-    rc = orcm_analytics_base_create_event_base(wf, threadname);
-    free(threadname);
-
-    return rc;
-}
-
 static int orcm_analytics_base_workflow_step_create(orcm_workflow_t *wf,
                                                     opal_value_t **values, int i)
 {
@@ -318,11 +304,13 @@ int orcm_analytics_base_workflow_create(opal_buffer_t* buffer, int *wfid)
         goto error;
     }
 
-    rc = orcm_analytics_base_create_new_workflow_event_base(wf);
+    /* the steps run on the shared executor */
+    rc = orcm_analytics_base_executor_start();
     if (ORCM_SUCCESS != rc) {
         ORTE_ERROR_LOG(rc);
         goto error;
     }
+    orcm_analytics_base_executor_add_workflow(wf);
 
 
     cnt = MAX_ALLOWED_ATTRIBUTES_PER_WORKFLOW_STEP * num_steps;
@@ -347,10 +335,33 @@ int orcm_analytics_base_workflow_create(opal_buffer_t* buffer, int *wfid)
 
     free(values);
 
+    /* chained steps run in one call */
+    orcm_analytics_base_workflow_fuse(wf);
+
     /* add workflow to the master list of workflows */
     opal_list_append(&orcm_analytics_base_wf.workflows, &wf->super);
+
+    /* and have the samples it takes routed to it */
+    rc = orcm_analytics_base_subscribe(wf);
+    if (ORCM_SUCCESS != rc) {
+        ORTE_ERROR_LOG(rc);
+        goto teardown;
+    }
+
+    /* and the partials of its aggregate steps */
+    rc = orcm_analytics_base_aggregate_register(wf);
+    if (ORCM_SUCCESS != rc) {
+        ORTE_ERROR_LOG(rc);
+        goto teardown;
+    }
     return ORCM_SUCCESS;
 
+teardown:
+    /* the workflow is listed and its steps are up - take it down as
+     * a delete would */
+    orcm_analytics_stop_wokflow(wf);
+    opal_list_remove_item(&orcm_analytics_base_wf.workflows, &wf->super);
+
 error:
     if (NULL != wf) {
         OBJ_RELEASE(wf);
@@ -439,15 +450,22 @@ int orcm_analytics_base_array_append(opal_value_array_t *analytics_sample_array,
     orcm_analytics_value_t analytics_sample;
     int rc;
 
-    /*fill the analytics structure with the sensor data */
-    analytics_sample.sensor_name = strdup(plugin_name);
-    analytics_sample.node_regex = strdup(host_name);
-
-    analytics_sample.data.units = strdup(sample->units);
-    analytics_sample.data.value.key = strdup(sample->value.key);
+    /*fill the analytics structure with the sensor data - the strings
+     * are those of the interned key, so nothing is copied */
+    rc = orcm_analytics_base_value_intern(&analytics_sample, host_name, plugin_name,
+                                          index, sample->value.key, sample->units);
+    if (ORCM_SUCCESS != rc) {
+        return ORCM_ERR_BAD_PARAM;
+    }
     analytics_sample.data.value.type = sample->value.type;
     analytics_sample.data.value.data = sample->value.data;
 
+    /* a sample covers the instant it was taken */
+    analytics_sample.comma_sep_plugin_list = NULL;
+    gettimeofday(&analytics_sample.start_time, NULL);
+    analytics_sample.end_time = analytics_sample.start_time;
+    analytics_sample.measured = true;
+
     rc = opal_value_array_set_item(analytics_sample_array, index, &analytics_sample);
     if (OPAL_SUCCESS != rc) {
         ORTE_ERROR_LOG(rc);
@@ -463,12 +481,104 @@ void orcm_analytics_base_array_cleanup(opal_value_array_t *analytics_sample_arra
 }
 
 
-void orcm_analytics_base_array_send(opal_value_array_t *data)
+bool orcm_analytics_base_value_to_double(opal_value_t *value, double *x)
 {
-    orcm_workflow_t *wf = NULL;
+    switch (value->type) {
+    case OPAL_FLOAT:
+        *x = value->data.fval;
+        break;
+    case OPAL_DOUBLE:
+        *x = value->data.dval;
+        break;
+    case OPAL_INT:
+        *x = value->data.integer;
+        break;
+    case OPAL_INT8:
+        *x = value->data.int8;
+        break;
+    case OPAL_INT16:
+        *x = value->data.int16;
+        break;
+    case OPAL_INT32:
+        *x = value->data.int32;
+        break;
+    case OPAL_INT64:
+        *x = value->data.int64;
+        break;
+    case OPAL_UINT:
+        *x = value->data.uint;
+        break;
+    case OPAL_UINT8:
+        *x = value->data.uint8;
+        break;
+    case OPAL_UINT16:
+        *x = value->data.uint16;
+        break;
+    case OPAL_UINT32:
+        *x = value->data.uint32;
+        break;
+    case OPAL_UINT64:
+        *x = value->data.uint64;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
 
-    OPAL_LIST_FOREACH(wf, &orcm_analytics_base_wf.workflows, orcm_workflow_t) {
-        OBJ_RETAIN(data);
-        ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(wf,(&(wf->steps.opal_list_sentinel)), data);
+int orcm_analytics_base_parse_period(const char *str, bool zero_ok, double *period)
+{
+    char *end;
+    double val;
+
+    val = strtod(str, &end);
+    if (end == str || 0 > val || (!zero_ok && 0 == val)) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 == strcmp(end, "ms")) {
+        val /= 1000.0;
+    } else if (0 == strcmp(end, "m")) {
+        val *= 60.0;
+    } else if (0 == strcmp(end, "h")) {
+        val *= 3600.0;
+    } else if ('\0' != *end && 0 != strcmp(end, "s")) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    *period = val;
+    return ORCM_SUCCESS;
+}
+
+int orcm_analytics_base_parse_stat(const char *str,
+                                   const orcm_analytics_base_stat_name_t *names,
+                                   int percentile_stat, int *stat, double *percent)
+{
+    char *end;
+    int i;
+
+    *percent = 0.0;
+    for (i=0; NULL != names[i].name; i++) {
+        if (0 == strcmp(str, names[i].name)) {
+            *stat = names[i].stat;
+            return ORCM_SUCCESS;
+        }
+    }
+    if ('p' != str[0]) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    *percent = strtod(&str[1], &end);
+    if (end == &str[1] || '\0' != *end || 0.0 > *percent || 100.0 < *percent) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    *stat = percentile_stat;
+    return ORCM_SUCCESS;
+}
+
+void orcm_analytics_base_to_timeval(double t, struct timeval *tv)
+{
+    tv->tv_sec = (time_t)t;
+    tv->tv_usec = (suseconds_t)((t - (double)tv->tv_sec) * 1000000.0 + 0.5);
+    if (1000000 <= tv->tv_usec) {
+        tv->tv_sec++;
+        tv->tv_usec -= 1000000;
     }
 }
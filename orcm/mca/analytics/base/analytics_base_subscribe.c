@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <string.h>
+
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+
+/*
+ * Subscriptions
+ *
+ * A workflow starting with a filter step only ever uses the samples
+ * the filter lets through. The filter attributes (nodeid, sensorname
+ * and coreid) are taken from that step when the workflow is created,
+ * and for every interned key the index keeps which of these workflows
+ * take its samples - worked out the first time the key is sent after
+ * a workflow came or went. A sensor array then goes only to the
+ * workflows it has samples for: as is if they take all of it, or as
+ * a slice of the values they take - the strings of the values belong
+ * to their keys, so nothing but the values is copied.
+ *
+ * Unless it stores what it lets through, the filter step itself is
+ * then skipped, the samples going straight to the step after it.
+ * Workflows not starting with a filter get every array.
+ */
+
+orcm_analytics_base_subscriptions_t orcm_analytics_base_subscriptions = {0};
+
+/* the filter attributes, matched as the filter step does */
+static char *nodeid_label = "nodeid";
+static char *sensor_label = "sensorname";
+static char *coreid_label = "coreid";
+
+void orcm_analytics_base_subscriptions_init(void)
+{
+    if (orcm_analytics_base_subscriptions.initialized) {
+        return;
+    }
+    OBJ_CONSTRUCT(&orcm_analytics_base_subscriptions.lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&orcm_analytics_base_subscriptions.by_key, opal_pointer_array_t);
+    opal_pointer_array_init(&orcm_analytics_base_subscriptions.by_key, 1024, INT32_MAX, 1024);
+    orcm_analytics_base_subscriptions.generation = 1;
+    orcm_analytics_base_subscriptions.count = 0;
+    orcm_analytics_base_subscriptions.size = 0;
+    orcm_analytics_base_subscriptions.subscribers = NULL;
+    orcm_analytics_base_subscriptions.initialized = true;
+}
+
+static void subscriber_clear(orcm_analytics_base_subscriber_t *sub)
+{
+    opal_argv_free(sub->nodeid);
+    opal_argv_free(sub->sensorname);
+    opal_argv_free(sub->coreid);
+    OBJ_RELEASE(sub->wf);
+}
+
+void orcm_analytics_base_subscriptions_finalize(void)
+{
+    orcm_analytics_base_key_subscribers_t *entry;
+    int i;
+
+    if (!orcm_analytics_base_subscriptions.initialized) {
+        return;
+    }
+    for (i=0; i < orcm_analytics_base_subscriptions.count; i++) {
+        subscriber_clear(&orcm_analytics_base_subscriptions.subscribers[i]);
+    }
+    free(orcm_analytics_base_subscriptions.subscribers);
+    orcm_analytics_base_subscriptions.subscribers = NULL;
+    orcm_analytics_base_subscriptions.count = 0;
+    orcm_analytics_base_subscriptions.size = 0;
+    for (i=0; i < orcm_analytics_base_subscriptions.by_key.size; i++) {
+        entry = (orcm_analytics_base_key_subscribers_t*)
+                opal_pointer_array_get_item(&orcm_analytics_base_subscriptions.by_key, i);
+        if (NULL != entry) {
+            free(entry->subscribers);
+            free(entry);
+        }
+    }
+    OBJ_DESTRUCT(&orcm_analytics_base_subscriptions.by_key);
+    OBJ_DESTRUCT(&orcm_analytics_base_subscriptions.lock);
+    orcm_analytics_base_subscriptions.initialized = false;
+}
+
+static bool match_any(char **patterns, const char *s)
+{
+    int i;
+
+    if (NULL == patterns || NULL == patterns[0]) {
+        return true;
+    }
+    if (NULL == s) {
+        return false;
+    }
+    for (i=0; NULL != patterns[i]; i++) {
+        if (0 == strncmp(patterns[i], s, strlen(patterns[i]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool subscriber_match(orcm_analytics_base_subscriber_t *sub,
+                             orcm_analytics_value_t *value)
+{
+    return match_any(sub->nodeid, value->node_regex) &&
+           match_any(sub->sensorname, value->sensor_name) &&
+           match_any(sub->coreid, value->data.value.key);
+}
+
+int orcm_analytics_base_subscribe(orcm_workflow_t *wf)
+{
+    orcm_analytics_base_subscriber_t *sub, *subs;
+    orcm_workflow_step_t *first = NULL;
+    opal_value_t *attr;
+    int size;
+
+    if (NULL == wf) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    orcm_analytics_base_subscriptions_init();
+
+    opal_mutex_lock(&orcm_analytics_base_subscriptions.lock);
+    if (orcm_analytics_base_subscriptions.count == orcm_analytics_base_subscriptions.size) {
+        size = (0 == orcm_analytics_base_subscriptions.size) ?
+               8 : 2 * orcm_analytics_base_subscriptions.size;
+        subs = (orcm_analytics_base_subscriber_t*)
+               realloc(orcm_analytics_base_subscriptions.subscribers,
+                       size * sizeof(orcm_analytics_base_subscriber_t));
+        if (NULL == subs) {
+            opal_mutex_unlock(&orcm_analytics_base_subscriptions.lock);
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        orcm_analytics_base_subscriptions.subscribers = subs;
+        orcm_analytics_base_subscriptions.size = size;
+    }
+    sub = &orcm_analytics_base_subscriptions.subscribers[orcm_analytics_base_subscriptions.count];
+    memset(sub, 0, sizeof(*sub));
+    OBJ_RETAIN(wf);
+    sub->wf = wf;
+
+    if (0 < opal_list_get_size(&wf->steps)) {
+        first = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    }
+    if (NULL != first && NULL != first->analytic && 0 == strcmp(first->analytic, "filter")) {
+        sub->filter = first;
+        sub->store = orcm_analytics_base_db_check(first);
+        OPAL_LIST_FOREACH(attr, &first->attributes, opal_value_t) {
+            if (NULL == attr->key || NULL == attr->data.string) {
+                continue;
+            }
+            if (0 == strncmp(attr->key, nodeid_label, strlen(attr->key))) {
+                opal_argv_free(sub->nodeid);
+                sub->nodeid = opal_argv_split(attr->data.string, ';');
+            } else if (0 == strncmp(attr->key, sensor_label, strlen(attr->key))) {
+                opal_argv_free(sub->sensorname);
+                sub->sensorname = opal_argv_split(attr->data.string, ';');
+            } else if (0 == strncmp(attr->key, coreid_label, strlen(attr->key))) {
+                opal_argv_free(sub->coreid);
+                sub->coreid = opal_argv_split(attr->data.string, ';');
+            }
+        }
+    }
+    orcm_analytics_base_subscriptions.count++;
+    orcm_analytics_base_subscriptions.generation++;
+    opal_mutex_unlock(&orcm_analytics_base_subscriptions.lock);
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:base:subscribe workflow %d %s",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), wf->workflow_id,
+                         (NULL == sub->filter) ? "takes all samples" : "is filtered"));
+    return ORCM_SUCCESS;
+}
+
+void orcm_analytics_base_unsubscribe(orcm_workflow_t *wf)
+{
+    orcm_analytics_base_subscriber_t *subs;
+    int i;
+
+    if (!orcm_analytics_base_subscriptions.initialized) {
+        return;
+    }
+    opal_mutex_lock(&orcm_analytics_base_subscriptions.lock);
+    subs = orcm_analytics_base_subscriptions.subscribers;
+    for (i=0; i < orcm_analytics_base_subscriptions.count; i++) {
+        if (wf == subs[i].wf) {
+            subscriber_clear(&subs[i]);
+            memmove(&subs[i], &subs[i + 1], (orcm_analytics_base_subscriptions.count - i - 1) *
+                    sizeof(orcm_analytics_base_subscriber_t));
+            orcm_analytics_base_subscriptions.count--;
+            /* the positions in the index changed */
+            orcm_analytics_base_subscriptions.generation++;
+            break;
+        }
+    }
+    opal_mutex_unlock(&orcm_analytics_base_subscriptions.lock);
+}
+
+/* which filtered subscribers take the samples of a key - keys that
+ * could not be interned are worked out in the scratch entry each time */
+static orcm_analytics_base_key_subscribers_t*
+key_subscribers(orcm_analytics_value_t *value,
+                orcm_analytics_base_key_subscribers_t *scratch)
+{
+    orcm_analytics_base_key_subscribers_t *entry = NULL;
+    orcm_analytics_base_subscriber_t *sub;
+    int *subscribers;
+    int i;
+
+    if (ORCM_ANALYTICS_KEY_INVALID != value->key_id) {
+        entry = (orcm_analytics_base_key_subscribers_t*)
+                opal_pointer_array_get_item(&orcm_analytics_base_subscriptions.by_key,
+                                            (int)value->key_id);
+        if (NULL == entry) {
+            entry = (orcm_analytics_base_key_subscribers_t*)calloc(1, sizeof(*entry));
+            if (NULL == entry ||
+                OPAL_SUCCESS != opal_pointer_array_set_item(&orcm_analytics_base_subscriptions.by_key,
+                                                            (int)value->key_id, entry)) {
+                free(entry);
+                entry = NULL;
+            }
+        } else if (entry->generation == orcm_analytics_base_subscriptions.generation) {
+            return entry;
+        }
+    }
+    if (NULL == entry) {
+        entry = scratch;
+    }
+
+    if (entry->size < orcm_analytics_base_subscriptions.count) {
+        subscribers = (int*)realloc(entry->subscribers,
+                                    orcm_analytics_base_subscriptions.count * sizeof(int));
+        if (NULL == subscribers) {
+            entry->count = 0;
+            entry->generation = 0;
+            return entry;
+        }
+        entry->subscribers = subscribers;
+        entry->size = orcm_analytics_base_subscriptions.count;
+    }
+    entry->count = 0;
+    for (i=0; i < orcm_analytics_base_subscriptions.count; i++) {
+        sub = &orcm_analytics_base_subscriptions.subscribers[i];
+        if (NULL != sub->filter && subscriber_match(sub, value)) {
+            entry->subscribers[entry->count++] = i;
+        }
+    }
+    entry->generation = orcm_analytics_base_subscriptions.generation;
+    return entry;
+}
+
+static void subscriber_send(orcm_analytics_base_subscriber_t *sub, opal_value_array_t *data)
+{
+    opal_list_item_t *prev = &(sub->wf->steps.opal_list_sentinel);
+
+    /* the samples are what the filter would let through */
+    if (NULL != sub->filter &&
+        !(sub->store && orcm_analytics_base_db.db_handle_acquired)) {
+        prev = &sub->filter->super;
+    }
+    ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(sub->wf, prev, data);
+}
+
+void orcm_analytics_base_array_send(opal_value_array_t *data)
+{
+    orcm_analytics_base_key_subscribers_t *entry, scratch = {0};
+    orcm_analytics_base_subscriber_t *sub;
+    orcm_analytics_value_t *value;
+    size_t i, size;
+    int j, rc;
+    bool sliced = false;
+
+    if (NULL == data || !orcm_analytics_base_subscriptions.initialized) {
+        return;
+    }
+    size = opal_value_array_get_size(data);
+
+    opal_mutex_lock(&orcm_analytics_base_subscriptions.lock);
+    for (j=0; j < orcm_analytics_base_subscriptions.count; j++) {
+        orcm_analytics_base_subscriptions.subscribers[j].hits = 0;
+        orcm_analytics_base_subscriptions.subscribers[j].slice = NULL;
+    }
+
+    /* count the samples each filtered workflow takes */
+    for (i=0; i < size; i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(data, i);
+        entry = key_subscribers(value, &scratch);
+        for (j=0; j < entry->count; j++) {
+            orcm_analytics_base_subscriptions.subscribers[entry->subscribers[j]].hits++;
+        }
+    }
+
+    for (j=0; j < orcm_analytics_base_subscriptions.count; j++) {
+        sub = &orcm_analytics_base_subscriptions.subscribers[j];
+        if (NULL == sub->filter || size == sub->hits) {
+            OBJ_RETAIN(data);
+            subscriber_send(sub, data);
+        } else if (0 < sub->hits) {
+            rc = orcm_analytics_base_array_create(&sub->slice, (int)sub->hits);
+            if (ORCM_SUCCESS != rc) {
+                if (NULL != sub->slice) {
+                    OBJ_RELEASE(sub->slice);
+                }
+                continue;
+            }
+            sliced = true;
+        }
+    }
+
+    /* fill the slices of those taking part of the array */
+    if (sliced) {
+        for (i=0; i < size; i++) {
+            value = (orcm_analytics_value_t*)opal_value_array_get_item(data, i);
+            entry = key_subscribers(value, &scratch);
+            for (j=0; j < entry->count; j++) {
+                sub = &orcm_analytics_base_subscriptions.subscribers[entry->subscribers[j]];
+                if (NULL != sub->slice) {
+                    opal_value_array_append_item(sub->slice, value);
+                }
+            }
+        }
+        for (j=0; j < orcm_analytics_base_subscriptions.count; j++) {
+            sub = &orcm_analytics_base_subscriptions.subscribers[j];
+            if (NULL != sub->slice) {
+                subscriber_send(sub, sub->slice);
+                sub->slice = NULL;
+            }
+        }
+    }
+    opal_mutex_unlock(&orcm_analytics_base_subscriptions.lock);
+    free(scratch.subscribers);
+}
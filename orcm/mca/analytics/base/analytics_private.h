@@ -12,6 +12,15 @@
 #ifndef MCA_ANALYTICS_PRIVATE_H
 #define MCA_ANALYTICS_PRIVATE_H
 
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "opal/class/opal_hash_table.h"
+#include "opal/class/opal_pointer_array.h"
+#include "opal/dss/dss_types.h"
+#include "opal/threads/mutex.h"
+#include "opal/threads/threads.h"
+
 #include "orcm/mca/analytics/base/base.h"
 
 BEGIN_C_DECLS
@@ -34,6 +43,111 @@ ORCM_DECLSPEC int orcm_analytics_base_array_append(opal_value_array_t *analytics
                                                    char *host_name, orcm_metric_value_t *sample);
 ORCM_DECLSPEC void orcm_analytics_base_array_cleanup(opal_value_array_t *analytics_sample_array);
 ORCM_DECLSPEC void orcm_analytics_base_array_send(opal_value_array_t *data);
+/* the numeric data of a value as a double, false if it has none */
+ORCM_DECLSPEC bool orcm_analytics_base_value_to_double(opal_value_t *value, double *x);
+
+/* a statistic a step can be asked to compute, and its value to the step */
+typedef struct {
+    const char *name;
+    int stat;
+} orcm_analytics_base_stat_name_t;
+
+/* a time attribute - <n>[ms|s|m|h], in secs if no unit is given - which
+ * must be positive unless zero_ok */
+ORCM_DECLSPEC int orcm_analytics_base_parse_period(const char *str, bool zero_ok,
+                                                   double *period);
+/* one statistic of a compute attribute: a name of the NULL terminated
+ * names, or p<percent> for the percentile_stat */
+ORCM_DECLSPEC int orcm_analytics_base_parse_stat(const char *str,
+                                                 const orcm_analytics_base_stat_name_t *names,
+                                                 int percentile_stat, int *stat,
+                                                 double *percent);
+/* secs since the epoch as a timeval, rounded to the usec */
+ORCM_DECLSPEC void orcm_analytics_base_to_timeval(double t, struct timeval *tv);
+
+/* intern a (node, sensor, index, label), returning its id or
+ * ORCM_ANALYTICS_KEY_INVALID */
+ORCM_DECLSPEC uint32_t orcm_analytics_base_key_intern(const char *node_regex,
+                                                      const char *sensor_name,
+                                                      int index, const char *label,
+                                                      const char *units);
+ORCM_DECLSPEC orcm_analytics_key_t* orcm_analytics_base_key_get(uint32_t id);
+ORCM_DECLSPEC uint32_t orcm_analytics_base_num_keys(void);
+/* point the strings of a value at those of an interned key */
+ORCM_DECLSPEC int orcm_analytics_base_value_set_key(orcm_analytics_value_t *value,
+                                                    uint32_t id);
+/* intern a key and point the strings of a value at it */
+ORCM_DECLSPEC int orcm_analytics_base_value_intern(orcm_analytics_value_t *value,
+                                                   const char *node_regex,
+                                                   const char *sensor_name,
+                                                   int index, const char *label,
+                                                   const char *units);
+void orcm_analytics_base_keys_init(void);
+void orcm_analytics_base_keys_finalize(void);
+
+/* keep track of the aggregate steps of a workflow, by name */
+int orcm_analytics_base_aggregate_register(orcm_workflow_t *wf);
+void orcm_analytics_base_aggregate_unregister(orcm_workflow_t *wf);
+void orcm_analytics_base_aggregates_init(void);
+void orcm_analytics_base_aggregates_finalize(void);
+/* hand partial aggregates to the aggregate steps of that name - those
+ * of wf only, unless NULL - the buffer is left to the caller */
+ORCM_DECLSPEC int orcm_analytics_base_aggregate_deliver(orcm_workflow_t *wf, const char *name,
+                                                        opal_buffer_t *partials);
+/* send partial aggregates up to the steps of that name - takes the buffer */
+ORCM_DECLSPEC int orcm_analytics_base_aggregate_forward(orcm_workflow_t *wf, const char *name,
+                                                        opal_buffer_t *partials);
+/* partial aggregates received from a child */
+void orcm_analytics_base_aggregate_recv(orte_process_name_t *sender, opal_buffer_t *buffer);
+
+/* set the accuracy and size of an empty sketch */
+ORCM_DECLSPEC int orcm_analytics_base_sketch_init(orcm_analytics_sketch_t *sketch,
+                                                  double accuracy, int max_bins);
+ORCM_DECLSPEC void orcm_analytics_base_sketch_reset(orcm_analytics_sketch_t *sketch);
+ORCM_DECLSPEC int orcm_analytics_base_sketch_add(orcm_analytics_sketch_t *sketch, double x);
+/* add the values of src to dst - both must have the same accuracy */
+ORCM_DECLSPEC int orcm_analytics_base_sketch_merge(orcm_analytics_sketch_t *dst,
+                                                   orcm_analytics_sketch_t *src);
+/* the q-quantile (0 <= q <= 1), within the accuracy of the sketch */
+ORCM_DECLSPEC double orcm_analytics_base_sketch_quantile(orcm_analytics_sketch_t *sketch,
+                                                         double q);
+ORCM_DECLSPEC int orcm_analytics_base_sketch_pack(opal_buffer_t *buffer,
+                                                  orcm_analytics_sketch_t *sketch);
+/* unpack a sketch into a new object */
+ORCM_DECLSPEC int orcm_analytics_base_sketch_unpack(opal_buffer_t *buffer,
+                                                    orcm_analytics_sketch_t **sketch);
+
+/* start the workers of the executor, if not running yet */
+int orcm_analytics_base_executor_start(void);
+/* stop the workers, dropping the steps still queued */
+void orcm_analytics_base_executor_stop(void);
+/* give a new workflow a home worker */
+void orcm_analytics_base_executor_add_workflow(orcm_workflow_t *wf);
+/* drop the queued steps of a workflow and wait until no worker runs it */
+void orcm_analytics_base_executor_stop_workflow(orcm_workflow_t *wf);
+/* queue a workflow step - takes the caddy */
+void orcm_analytics_base_executor_submit(orcm_workflow_caddy_t *caddy);
+/* pack the statistics of the workers */
+int orcm_analytics_base_executor_pack_stats(opal_buffer_t *buffer);
+
+/* mark the steps of a new workflow that run in the same call as the
+ * step before them */
+void orcm_analytics_base_workflow_fuse(orcm_workflow_t *wf);
+/* run a fused step right away, if called from the step before it -
+ * takes the data if it does */
+bool orcm_analytics_base_run_fused(orcm_workflow_t *wf, orcm_workflow_step_t *wf_step,
+                                   opal_value_array_t *data);
+/* an empty array for the output of a step, the one it used last if
+ * the next steps are done with it */
+ORCM_DECLSPEC int orcm_analytics_base_step_array(orcm_workflow_step_t *wf_step,
+                                                 opal_value_array_t **array, int size);
+
+/* route the samples of a workflow to it - through the subscription
+ * index if its first step is a filter */
+int orcm_analytics_base_subscribe(orcm_workflow_t *wf);
+void orcm_analytics_base_unsubscribe(orcm_workflow_t *wf);
+void orcm_analytics_base_subscriptions_init(void);
+void orcm_analytics_base_subscriptions_finalize(void);
 
 void orcm_analytics_base_db_open_cb(int handle, int status, opal_list_t *props,
                                     opal_list_t *ret, void *cbdata);
@@ -44,10 +158,21 @@ void orcm_analytics_base_open_db(void);
 /* close a database handle */
 void orcm_analytics_base_close_db(void);
 
+/* check whether this workflow step needs to load the data results to store */
+bool orcm_analytics_base_db_check(orcm_workflow_step_t *wf_step);
+
 /* function to store the data results after each workflow step when required */
-int orcm_analytics_base_store(orcm_workflow_t *wf,
-                              orcm_workflow_step_t *wf_step,
-                              opal_value_array_t *data_results);
+ORCM_DECLSPEC int orcm_analytics_base_store(orcm_workflow_t *wf,
+                                            orcm_workflow_step_t *wf_step,
+                                            opal_value_array_t *data_results);
+
+/* send the data results a workflow step has buffered to the database */
+ORCM_DECLSPEC int orcm_analytics_base_db_flush(orcm_workflow_t *wf,
+                                               orcm_workflow_step_t *wf_step);
+
+/* stop the flush timer of a workflow step and send what it buffered */
+ORCM_DECLSPEC int orcm_analytics_base_db_stop(orcm_workflow_t *wf,
+                                              orcm_workflow_step_t *wf_step);
 
 #define ANALYTICS_COUNT_DEFAULT 1
 #define MAX_ALLOWED_ATTRIBUTES_PER_WORKFLOW_STEP 2
@@ -58,6 +183,107 @@ typedef struct {
 } orcm_analytics_base_wf_t;
 ORCM_DECLSPEC extern orcm_analytics_base_wf_t orcm_analytics_base_wf;
 
+typedef struct {
+    bool initialized;
+    opal_mutex_t lock;
+    /* keys by id, and ids by (node, sensor, index, label) */
+    opal_pointer_array_t keys;
+    opal_hash_table_t ids;
+    uint32_t num_keys;
+} orcm_analytics_base_keys_t;
+ORCM_DECLSPEC extern orcm_analytics_base_keys_t orcm_analytics_base_keys;
+
+/* a worker of the executor - the workflows it is to run are kept in
+ * a ring, taken from the head by the worker and stolen from the tail
+ * by the others */
+typedef struct {
+    int id;
+    opal_thread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool sleeping;
+    orcm_workflow_t **queue;
+    int head;
+    int count;
+    int size;
+    /* steps run, workflows stolen, and time steps spent queued */
+    uint64_t tasks;
+    uint64_t steals;
+    uint64_t wait_usec;
+    uint64_t max_wait_usec;
+} orcm_analytics_base_worker_t;
+
+typedef struct {
+    /* number of workers, 0 for one per core */
+    int num_workers;
+    volatile bool active;
+    int nworkers;
+    orcm_analytics_base_worker_t *workers;
+    int next_worker;
+} orcm_analytics_base_executor_t;
+ORCM_DECLSPEC extern orcm_analytics_base_executor_t orcm_analytics_base_executor;
+
+/* whether chained steps may be fused (analytics_base_fuse_steps) */
+ORCM_DECLSPEC extern bool orcm_analytics_base_fuse_steps;
+
+/* a workflow as the samples see it - if it starts with a filter, the
+ * samples it lets through, counted and sliced on each send */
+typedef struct {
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *filter;
+    bool store;
+    char **nodeid;
+    char **sensorname;
+    char **coreid;
+    size_t hits;
+    opal_value_array_t *slice;
+} orcm_analytics_base_subscriber_t;
+
+/* the filtered subscribers (by position) taking the samples of a key,
+ * as of a generation of the subscribers */
+typedef struct {
+    uint32_t generation;
+    int count;
+    int size;
+    int *subscribers;
+} orcm_analytics_base_key_subscribers_t;
+
+typedef struct {
+    bool initialized;
+    opal_mutex_t lock;
+    /* bumped whenever a workflow comes or goes */
+    uint32_t generation;
+    int count;
+    int size;
+    orcm_analytics_base_subscriber_t *subscribers;
+    /* orcm_analytics_base_key_subscribers_t by key id */
+    opal_pointer_array_t by_key;
+} orcm_analytics_base_subscriptions_t;
+ORCM_DECLSPEC extern orcm_analytics_base_subscriptions_t orcm_analytics_base_subscriptions;
+
+/* an aggregate step, by the name its partial aggregates go by */
+typedef struct {
+    opal_list_item_t super;
+    char *name;
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+} orcm_analytics_base_aggregator_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_base_aggregator_t);
+
+typedef int (*orcm_analytics_base_aggregate_forward_fn_t)(orcm_workflow_t *wf,
+                                                         const char *name,
+                                                         opal_buffer_t *partials);
+
+typedef struct {
+    bool initialized;
+    opal_mutex_t lock;
+    opal_list_t aggregators;
+    /* where forwarded partials go - to the same step of the routing
+     * parent, unless replaced (e.g. by a test) */
+    orcm_analytics_base_aggregate_forward_fn_t forward;
+} orcm_analytics_base_aggregates_t;
+ORCM_DECLSPEC extern orcm_analytics_base_aggregates_t orcm_analytics_base_aggregates;
+
 typedef struct {
     int db_handle;
     bool db_handle_acquired;
@@ -65,6 +291,52 @@ typedef struct {
 
 ORCM_DECLSPEC extern orcm_analytics_base_db_t orcm_analytics_base_db;
 
+/* most rows a step buffers before it flushes, whatever its interval */
+#define ORCM_ANALYTICS_DB_MAX_ROWS 65536
+
+/* a value waiting to be stored - integers are kept as such, a double
+ * holds them exactly only up to 2^53 */
+typedef union {
+    double dval;
+    int64_t ival;
+    uint64_t uval;
+} orcm_analytics_base_db_number_t;
+
+/* the data results of a workflow step waiting to be stored, a record
+ * per invocation and a row per value, by column. The record lists
+ * sent to the database come back to the pool once stored, to be
+ * refilled by the next flush */
+typedef struct orcm_analytics_base_db_buffer {
+    opal_object_t super;
+    /* secs between flushes, 0 to store every invocation, and the
+     * caddy of the timer flushing the buffer when the step goes quiet -
+     * NULL unless it is pending */
+    double interval;
+    struct timeval oldest;
+    orcm_workflow_caddy_t *timer;
+    /* records - when each was stored and its first row */
+    int nrecords;
+    int records_size;
+    struct timeval *ctime;
+    int *first;
+    /* rows */
+    int nrows;
+    int rows_size;
+    uint32_t *key_id;
+    opal_data_type_t *type;
+    orcm_analytics_base_db_number_t *value;
+    /* record lists back from the database, under lock */
+    opal_mutex_t lock;
+    opal_list_t **pool;
+    int npool;
+    int pool_size;
+    /* records, flushes, and metrics allocated so far */
+    uint64_t records;
+    uint64_t flushes;
+    uint64_t allocated;
+} orcm_analytics_base_db_buffer_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_base_db_buffer_t);
+
 /* executes the next workflow step in a workflow */
 #define ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(wf, prev_wf_step, data)                   \
     do {                                                                           \
@@ -34,25 +34,6 @@ static int analytics_filter_data(opal_value_array_t *filter_sample_array,
                                  filter_workflow_value_t *workflow_value,
                                  void* cbdata);
 
-static int filter_analytics_array_create(opal_value_array_t **analytics_sample_array)
-{
-    int rc = -1;
-
-    /*Init the analytics array and set its size */
-    *analytics_sample_array = OBJ_NEW(opal_value_array_t);
-
-    if (NULL == *analytics_sample_array) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
-    }
-
-    rc = opal_value_array_init(*analytics_sample_array, sizeof(orcm_analytics_value_t));
-    if (OPAL_SUCCESS != rc) {
-        return ORCM_ERR_OUT_OF_RESOURCE;
-    }
-
-    return ORCM_SUCCESS;
-}
-
 static int init(orcm_analytics_base_module_t *imod)
 {
     return ORCM_SUCCESS;
@@ -326,7 +307,8 @@ static int analyze(int sd, short args, void *cbdata)
         return ORCM_ERROR;
     }
 
-    analytics_rc = filter_analytics_array_create(&filter_sample_array);
+    analytics_rc = orcm_analytics_base_step_array(filter_analyze_caddy->wf_step,
+                                                  &filter_sample_array, 0);
     if (ORCM_SUCCESS != analytics_rc) {
         return ORCM_ERROR;
     }
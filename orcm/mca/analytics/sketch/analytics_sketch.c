@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "analytics_sketch.h"
+
+/*
+ * Sketch operator
+ *
+ * Keeps a quantile sketch (see analytics_base_sketch.c) of the samples
+ * of each (node, sensor, label) seen by the step - or, given a group,
+ * one per (sensor, label) for all the nodes of the group - in fixed
+ * memory whatever the horizon, and emits the statistics read from it
+ * every period. The sketches of different nodes or aggregators merge
+ * exactly, so quantiles over many nodes need not see their samples.
+ *
+ * The step attributes:
+ *
+ *    compute=<stat>[;<stat>...]   pNN (e.g. p99.9), min, max, mean or count;
+ *                                 default p50;p95;p99
+ *    accuracy=<a>                 relative accuracy of the quantiles,
+ *                                 default 0.01
+ *    max_bins=<n>                 buckets per sign of a sketch, default 2048
+ *    group=<name>                 sketch the nodes together, the statistics
+ *                                 being given <name> as node
+ *    period=<n>[ms|s|m|h]         how often the statistics are emitted,
+ *                                 default 60s
+ *    reset=yes|no                 start each period over, default no (the
+ *                                 sketch covers all samples seen)
+ *
+ * Periods are aligned on multiples of their length, and emitted when
+ * the first sample past them arrives. Each statistic is emitted with
+ * its name appended to the label, covering the samples from start_time
+ * to end_time.
+ */
+
+#define SKETCH_DEFAULT_ACCURACY  0.01
+#define SKETCH_DEFAULT_BINS      2048
+#define SKETCH_MAX_BINS          (1 << 16)
+#define SKETCH_DEFAULT_PERIOD    60.0
+#define SKETCH_DEFAULT_COMPUTE   "p50;p95;p99"
+#define SKETCH_KEY_MAX           512
+#define SKETCH_STATES_INIT       1024
+
+static int init(orcm_analytics_base_module_t *imod);
+static void finalize(orcm_analytics_base_module_t *imod);
+static int analyze(int sd, short args, void *cbdata);
+
+mca_analytics_sketch_module_t orcm_analytics_sketch_module = {
+    {
+        init,
+        finalize,
+        analyze,
+        NULL
+    }
+};
+
+static void state_con(orcm_analytics_sketch_state_t *p)
+{
+    int i;
+
+    for (i=0; i < ORCM_ANALYTICS_SKETCH_MAX_STATS; i++) {
+        p->out_ids[i] = ORCM_ANALYTICS_KEY_INVALID;
+    }
+    OBJ_CONSTRUCT(&p->sketch, orcm_analytics_sketch_t);
+    p->start = 0.0;
+    p->next_emit = 0.0;
+}
+static void state_des(orcm_analytics_sketch_state_t *p)
+{
+    OBJ_DESTRUCT(&p->sketch);
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_sketch_state_t,
+                   opal_object_t,
+                   state_con, state_des);
+
+static int init(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_sketch_module_t *mod;
+
+    if (NULL == imod) {
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_sketch_module_t*)imod;
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    mod->configured = false;
+    mod->accuracy = SKETCH_DEFAULT_ACCURACY;
+    mod->max_bins = SKETCH_DEFAULT_BINS;
+    mod->period = SKETCH_DEFAULT_PERIOD;
+    mod->reset = false;
+    mod->group = NULL;
+    mod->ncompute = 0;
+    OBJ_CONSTRUCT(&mod->states, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->states, SKETCH_STATES_INIT, INT32_MAX, SKETCH_STATES_INIT);
+    OBJ_CONSTRUCT(&mod->groups, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->groups, SKETCH_STATES_INIT, INT32_MAX, SKETCH_STATES_INIT);
+    return ORCM_SUCCESS;
+}
+
+static void release_states(opal_pointer_array_t *states)
+{
+    orcm_analytics_sketch_state_t *st;
+    int i;
+
+    for (i=0; i < states->size; i++) {
+        st = (orcm_analytics_sketch_state_t*)opal_pointer_array_get_item(states, i);
+        if (NULL != st) {
+            OBJ_RELEASE(st);
+        }
+    }
+    OBJ_DESTRUCT(states);
+}
+
+static void finalize(orcm_analytics_base_module_t *imod)
+{
+    mca_analytics_sketch_module_t *mod;
+    int i;
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:sketch:finalize",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+    if (NULL == imod) {
+        return;
+    }
+    mod = (mca_analytics_sketch_module_t*)imod;
+    release_states(&mod->states);
+    release_states(&mod->groups);
+    for (i=0; i < mod->ncompute; i++) {
+        free(mod->compute[i].name);
+    }
+    free(mod->group);
+    free(mod);
+}
+
+static const orcm_analytics_base_stat_name_t stat_names[] = {
+    {"min", ORCM_ANALYTICS_SKETCH_MIN},
+    {"max", ORCM_ANALYTICS_SKETCH_MAX},
+    {"mean", ORCM_ANALYTICS_SKETCH_MEAN},
+    {"average", ORCM_ANALYTICS_SKETCH_MEAN},
+    {"count", ORCM_ANALYTICS_SKETCH_COUNT},
+    {NULL, 0}
+};
+
+static int parse_compute(mca_analytics_sketch_module_t *mod, const char *str)
+{
+    orcm_analytics_sketch_compute_t *c;
+    char **stats;
+    double percent;
+    int i, stat, rc = ORCM_SUCCESS;
+
+    stats = opal_argv_split(str, ';');
+    for (i=0; NULL != stats && NULL != stats[i]; i++) {
+        if (ORCM_ANALYTICS_SKETCH_MAX_STATS == mod->ncompute ||
+            ORCM_SUCCESS != (rc = orcm_analytics_base_parse_stat(stats[i], stat_names,
+                                                                 ORCM_ANALYTICS_SKETCH_QUANTILE,
+                                                                 &stat, &percent))) {
+            rc = ORCM_ERR_BAD_PARAM;
+            break;
+        }
+        c = &mod->compute[mod->ncompute];
+        c->stat = (orcm_analytics_sketch_stat_t)stat;
+        c->quantile = percent / 100.0;
+        c->name = strdup(stats[i]);
+        mod->ncompute++;
+    }
+    opal_argv_free(stats);
+    return rc;
+}
+
+static int configure(mca_analytics_sketch_module_t *mod, orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+    int rc;
+
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL == attr->key || NULL == attr->data.string) {
+            continue;
+        }
+        rc = ORCM_SUCCESS;
+        if (0 == strcmp(attr->key, "compute")) {
+            rc = parse_compute(mod, attr->data.string);
+        } else if (0 == strcmp(attr->key, "accuracy")) {
+            mod->accuracy = strtod(attr->data.string, NULL);
+            if (0.0 >= mod->accuracy || 0.5 <= mod->accuracy) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "max_bins")) {
+            mod->max_bins = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= mod->max_bins || SKETCH_MAX_BINS < mod->max_bins) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "group")) {
+            free(mod->group);
+            mod->group = strdup(attr->data.string);
+        } else if (0 == strcmp(attr->key, "period")) {
+            rc = orcm_analytics_base_parse_period(attr->data.string, false, &mod->period);
+        } else if (0 == strcmp(attr->key, "reset")) {
+            if (0 == strcmp(attr->data.string, "yes")) {
+                mod->reset = true;
+            } else if (0 != strcmp(attr->data.string, "no")) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        }
+        if (ORCM_SUCCESS != rc) {
+            opal_output(0, "%s analytics:sketch: bad value %s for attribute %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        attr->data.string, attr->key);
+            return rc;
+        }
+    }
+    if (0 == mod->ncompute &&
+        ORCM_SUCCESS != (rc = parse_compute(mod, SKETCH_DEFAULT_COMPUTE))) {
+        return rc;
+    }
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:sketch: accuracy %g, %d bins, every %g sec%s%s, "
+                         "%d statistics", ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                         mod->accuracy, mod->max_bins, mod->period,
+                         (NULL == mod->group) ? "" : " for group ",
+                         (NULL == mod->group) ? "" : mod->group, mod->ncompute));
+    mod->configured = true;
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_sketch_state_t* get_state(mca_analytics_sketch_module_t *mod,
+                                                orcm_analytics_value_t *value)
+{
+    orcm_analytics_sketch_state_t *st, *group = NULL;
+    orcm_analytics_key_t *key;
+    char label[SKETCH_KEY_MAX];
+    char *node;
+    int i;
+
+    st = (orcm_analytics_sketch_state_t*)opal_pointer_array_get_item(&mod->states,
+                                                                     (int)value->key_id);
+    if (NULL != st) {
+        return st;
+    }
+
+    if (NULL == (key = orcm_analytics_base_key_get(value->key_id))) {
+        return NULL;
+    }
+    st = OBJ_NEW(orcm_analytics_sketch_state_t);
+    if (ORCM_SUCCESS != orcm_analytics_base_sketch_init(&st->sketch, mod->accuracy,
+                                                        mod->max_bins)) {
+        OBJ_RELEASE(st);
+        return NULL;
+    }
+    /* intern the keys of the emitted statistics once, here */
+    node = (NULL == mod->group) ? key->node_regex : mod->group;
+    for (i=0; i < mod->ncompute; i++) {
+        snprintf(label, sizeof(label), "%s %s", key->label, mod->compute[i].name);
+        st->out_ids[i] = orcm_analytics_base_key_intern(node, key->sensor_name,
+                                                        key->index, label, key->units);
+    }
+
+    /* the other nodes of the group may have got there first */
+    if (NULL != mod->group && ORCM_ANALYTICS_KEY_INVALID != st->out_ids[0]) {
+        group = (orcm_analytics_sketch_state_t*)
+                opal_pointer_array_get_item(&mod->groups, (int)st->out_ids[0]);
+        if (NULL != group) {
+            OBJ_RELEASE(st);
+            st = group;
+        } else if (OPAL_SUCCESS != opal_pointer_array_set_item(&mod->groups,
+                                                               (int)st->out_ids[0], st)) {
+            OBJ_RELEASE(st);
+            return NULL;
+        }
+        OBJ_RETAIN(st);
+    }
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&mod->states, (int)value->key_id, st)) {
+        OBJ_RELEASE(st);
+        return NULL;
+    }
+    return st;
+}
+
+static void emit(mca_analytics_sketch_module_t *mod, orcm_analytics_sketch_state_t *st,
+                 opal_value_array_t *results, double end)
+{
+    orcm_analytics_value_t out;
+    orcm_analytics_sketch_t *sk = &st->sketch;
+    double x = 0.0;
+    int i;
+
+    if (0 == sk->count) {
+        return;
+    }
+    for (i=0; i < mod->ncompute; i++) {
+        switch (mod->compute[i].stat) {
+        case ORCM_ANALYTICS_SKETCH_QUANTILE:
+            x = orcm_analytics_base_sketch_quantile(sk, mod->compute[i].quantile);
+            break;
+        case ORCM_ANALYTICS_SKETCH_MIN:
+            x = sk->min;
+            break;
+        case ORCM_ANALYTICS_SKETCH_MAX:
+            x = sk->max;
+            break;
+        case ORCM_ANALYTICS_SKETCH_MEAN:
+            x = sk->sum / (double)sk->count;
+            break;
+        case ORCM_ANALYTICS_SKETCH_COUNT:
+            x = (double)sk->count;
+            break;
+        }
+
+        memset(&out, 0, sizeof(out));
+        if (ORCM_SUCCESS != orcm_analytics_base_value_set_key(&out, st->out_ids[i])) {
+            continue;
+        }
+        out.comma_sep_plugin_list = "sketch";
+        out.data.value.type = OPAL_FLOAT;
+        out.data.value.data.fval = (float)x;
+        orcm_analytics_base_to_timeval(st->start, &out.start_time);
+        orcm_analytics_base_to_timeval(end, &out.end_time);
+        out.measured = false;
+        opal_value_array_append_item(results, &out);
+    }
+}
+
+static void sketch_sample(mca_analytics_sketch_module_t *mod,
+                          orcm_analytics_sketch_state_t *st,
+                          opal_value_array_t *results, double x, double t)
+{
+    /* close the period this sample is past */
+    if (0 < st->sketch.count && t >= st->next_emit) {
+        emit(mod, st, results, st->next_emit);
+        if (mod->reset) {
+            orcm_analytics_base_sketch_reset(&st->sketch);
+        }
+        st->next_emit = (floor(t / mod->period) + 1.0) * mod->period;
+    }
+    if (0 == st->sketch.count) {
+        st->start = t;
+        st->next_emit = (floor(t / mod->period) + 1.0) * mod->period;
+    }
+    orcm_analytics_base_sketch_add(&st->sketch, x);
+}
+
+static int analyze(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t *)cbdata;
+    mca_analytics_sketch_module_t *mod;
+    orcm_analytics_sketch_state_t *st;
+    orcm_analytics_value_t *value;
+    opal_value_array_t *results = NULL;
+    struct timeval now;
+    double x, t;
+    size_t index, size;
+    int rc;
+
+    if (NULL == caddy) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:sketch:NULL caddy data passed by the previous workflow step",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_sketch_module_t*)caddy->imod;
+
+    if (!mod->configured && ORCM_SUCCESS != (rc = configure(mod, caddy->wf_step))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    size = opal_value_array_get_size(caddy->data);
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_step_array(caddy->wf_step, &results, 0))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    now.tv_sec = 0;
+    for (index=0; index < size; index++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, index);
+        if (NULL == value || ORCM_ANALYTICS_KEY_INVALID == value->key_id ||
+            !orcm_analytics_base_value_to_double(&value->data.value, &x)) {
+            continue;
+        }
+        /* samples are placed at the end of the time they cover */
+        if (0 != value->end_time.tv_sec) {
+            t = value->end_time.tv_sec + value->end_time.tv_usec / 1000000.0;
+        } else {
+            if (0 == now.tv_sec) {
+                gettimeofday(&now, NULL);
+            }
+            t = now.tv_sec + now.tv_usec / 1000000.0;
+        }
+        if (NULL == (st = get_state(mod, value))) {
+            OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                                 "%s analytics:sketch:no sketch for %s:%s",
+                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                 value->node_regex, value->sensor_name));
+            continue;
+        }
+        sketch_sample(mod, st, results, x, t);
+    }
+
+    if (0 < opal_value_array_get_size(results)) {
+        /* load data to database if needed */
+        orcm_analytics_base_store(caddy->wf, caddy->wf_step, results);
+        ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(caddy->wf, caddy->wf_step, results);
+    } else {
+        OBJ_RELEASE(results);
+    }
+    OBJ_RELEASE(caddy);
+
+    return ORCM_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ *
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ */
+
+#ifndef MCA_analytics_sketch_EXPORT_H
+#define MCA_analytics_sketch_EXPORT_H
+
+#include "orcm_config.h"
+
+#include "opal/class/opal_pointer_array.h"
+
+#include "orcm/mca/analytics/analytics.h"
+
+BEGIN_C_DECLS
+
+/*
+ * Local Component structures
+ */
+
+ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_sketch_component;
+
+/* statistics read from a sketch */
+typedef enum {
+    ORCM_ANALYTICS_SKETCH_QUANTILE,
+    ORCM_ANALYTICS_SKETCH_MIN,
+    ORCM_ANALYTICS_SKETCH_MAX,
+    ORCM_ANALYTICS_SKETCH_MEAN,
+    ORCM_ANALYTICS_SKETCH_COUNT
+} orcm_analytics_sketch_stat_t;
+
+#define ORCM_ANALYTICS_SKETCH_MAX_STATS 8
+
+typedef struct {
+    orcm_analytics_sketch_stat_t stat;
+    double quantile;
+    char *name;
+} orcm_analytics_sketch_compute_t;
+
+/* sketch of one (node or group, sensor, label) - the samples of every
+ * key of a group go to the same state */
+typedef struct {
+    opal_object_t super;
+    /* interned key of each statistic emitted */
+    uint32_t out_ids[ORCM_ANALYTICS_SKETCH_MAX_STATS];
+    orcm_analytics_sketch_t sketch;
+    /* time of the first sample sketched, and end of the period */
+    double start;
+    double next_emit;
+} orcm_analytics_sketch_state_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_sketch_state_t);
+
+typedef struct {
+    orcm_analytics_base_module_t api;
+    /* sketch definition, taken from the workflow step attributes */
+    bool configured;
+    double accuracy;
+    int max_bins;
+    double period;
+    bool reset;
+    char *group;
+    int ncompute;
+    orcm_analytics_sketch_compute_t compute[ORCM_ANALYTICS_SKETCH_MAX_STATS];
+    /* states by interned key id of the samples, and of a group by the
+     * id of its first statistic */
+    opal_pointer_array_t states;
+    opal_pointer_array_t groups;
+} mca_analytics_sketch_module_t;
+ORCM_DECLSPEC extern mca_analytics_sketch_module_t orcm_analytics_sketch_module;
+
+END_C_DECLS
+
+#endif /* MCA_analytics_sketch_EXPORT_H */
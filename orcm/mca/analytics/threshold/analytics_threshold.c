@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014      Intel, Inc. All rights reserved.
+ * Copyright (c) 2014-2015 Intel, Inc. All rights reserved.
  * $COPYRIGHT$
  * 
  * Additional copyrights may follow
@@ -11,16 +11,61 @@
 #include "orcm/constants.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
+#include <math.h>
+#include <sys/time.h>
 
+#include "opal/util/argv.h"
 #include "opal/util/output.h"
 
+#include "orte/mca/errmgr/errmgr.h"
 #include "orte/util/name_fns.h"
 #include "orte/runtime/orte_globals.h"
 
-#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/evgen/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
 #include "analytics_threshold.h"
 
+/*
+ * Threshold operator
+ *
+ * The limits are compiled once, when the step first runs, into packed
+ * float arrays indexed by a sensor id interned from the sensor name. A
+ * batch is then evaluated in three passes: the values and the limits of
+ * their sensor are gathered into flat arrays, every value is compared
+ * against its limits in a branch-free loop the compiler can vectorize,
+ * and only the values past a limit - or belonging to a (node, sensor,
+ * label) flagged as not at rest - go on to the per-key state machine,
+ * whose states are indexed by the interned key id of the samples.
+ *
+ * A key is raised once count consecutive samples are past the same
+ * limit, and cleared once a sample is back within the limit by at least
+ * the hysteresis. An orcm_ras_event_t is generated on each of these
+ * transitions only, never for every sample past a limit.
+ *
+ * The limits are defined by the step attributes:
+ *
+ *    hi=<v>, lo=<v>                   limits of the sensors not listed
+ *                                     in limits
+ *    limits=<sensor>:<lo>:<hi>[;...]  limits of a sensor - either may be
+ *                                     left empty for no limit
+ *    hysteresis=<v>                   default 0
+ *    count=<n>                        consecutive samples, default 1
+ *    severity=<level>                 of the raised events (emerg, fatal,
+ *                                     alert, crit, error, warning,
+ *                                     notice, info), default warning
+ *
+ * The samples are passed on unchanged to the next step.
+ */
+
+#define THRESHOLD_STATES_INIT 1024
+
+#define THRESHOLD_PAST_HI     0x01
+#define THRESHOLD_PAST_LO     0x02
+#define THRESHOLD_ABOVE_CLEAR 0x04
+#define THRESHOLD_BELOW_CLEAR 0x08
+
 static int init(orcm_analytics_base_module_t *imod);
 static void finalize(orcm_analytics_base_module_t *imod);
 static int analyze(int sd, short args, void *cbdata);
@@ -29,37 +74,537 @@ mca_analytics_threshold_module_t orcm_analytics_threshold_module = {
     {
         init,
         finalize,
-        analyze
+        analyze,
+        NULL
     }
 };
 
+static void state_con(orcm_analytics_threshold_state_t *p)
+{
+    p->key_id = ORCM_ANALYTICS_KEY_INVALID;
+    p->level = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+    p->pending = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+    p->count = 0;
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_threshold_state_t,
+                   opal_object_t,
+                   state_con, NULL);
+
+static void free_batch(mca_analytics_threshold_module_t *mod)
+{
+    free(mod->index);
+    free(mod->x);
+    free(mod->bhi);
+    free(mod->blo);
+    free(mod->bclear_hi);
+    free(mod->bclear_lo);
+    free(mod->flags);
+    mod->index = NULL;
+    mod->x = NULL;
+    mod->bhi = NULL;
+    mod->blo = NULL;
+    mod->bclear_hi = NULL;
+    mod->bclear_lo = NULL;
+    mod->flags = NULL;
+    mod->batch_size = 0;
+}
+
 static int init(orcm_analytics_base_module_t *imod)
 {
-#if 0
     mca_analytics_threshold_module_t *mod;
-    mod = (mca_analytics_threshold_module_t *)imod;
-#endif
+
+    if (NULL == imod) {
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_threshold_module_t*)imod;
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    mod->configured = false;
+    OBJ_CONSTRUCT(&mod->sensor_ids, opal_hash_table_t);
+    opal_hash_table_init(&mod->sensor_ids, 32);
+    mod->nsensors = 0;
+    mod->sensor_names = NULL;
+    mod->hi = NULL;
+    mod->lo = NULL;
+    mod->clear_hi = NULL;
+    mod->clear_lo = NULL;
+    mod->hysteresis = 0.0;
+    mod->count = 1;
+    mod->severity = ORCM_RAS_SEVERITY_WARNING;
+    OBJ_CONSTRUCT(&mod->states, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->states, THRESHOLD_STATES_INIT, INT32_MAX,
+                            THRESHOLD_STATES_INIT);
+    mod->active = NULL;
+    mod->active_size = 0;
+    mod->index = NULL;
+    mod->x = NULL;
+    mod->bhi = NULL;
+    mod->blo = NULL;
+    mod->bclear_hi = NULL;
+    mod->bclear_lo = NULL;
+    mod->flags = NULL;
+    mod->batch_size = 0;
+    mod->raised = 0;
+    mod->cleared = 0;
     return ORCM_SUCCESS;
 }
 
 static void finalize(orcm_analytics_base_module_t *imod)
 {
-#if 0
     mca_analytics_threshold_module_t *mod;
-    mod = (mca_analytics_threshold_module_t *)imod;
-#endif
+    orcm_analytics_threshold_state_t *st;
+    int i;
+
     OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
                          "%s analytics:threshold:finalize",
                          ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+    if (NULL == imod) {
+        return;
+    }
+    mod = (mca_analytics_threshold_module_t*)imod;
+    OBJ_DESTRUCT(&mod->sensor_ids);
+    for (i=0; i < mod->states.size; i++) {
+        st = (orcm_analytics_threshold_state_t*)opal_pointer_array_get_item(&mod->states, i);
+        if (NULL != st) {
+            OBJ_RELEASE(st);
+        }
+    }
+    OBJ_DESTRUCT(&mod->states);
+    free(mod->active);
+    opal_argv_free(mod->sensor_names);
+    free(mod->hi);
+    free(mod->lo);
+    free(mod->clear_hi);
+    free(mod->clear_lo);
+    free_batch(mod);
+    free(mod);
+}
+
+static int parse_limit(const char *str, float *limit)
+{
+    char *end;
+
+    if ('\0' == *str) {
+        return ORCM_SUCCESS;
+    }
+    *limit = strtof(str, &end);
+    if (end == str || '\0' != *end) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    return ORCM_SUCCESS;
+}
+
+static int parse_severity(const char *str, int *severity)
+{
+    static const char *names[] = {"emerg", "fatal", "alert", "crit", "error",
+                                  "warning", "notice", "info", NULL};
+    static const int levels[] = {ORCM_RAS_SEVERITY_EMERG, ORCM_RAS_SEVERITY_FATAL,
+                                 ORCM_RAS_SEVERITY_ALERT, ORCM_RAS_SEVERITY_CRIT,
+                                 ORCM_RAS_SEVERITY_ERROR, ORCM_RAS_SEVERITY_WARNING,
+                                 ORCM_RAS_SEVERITY_NOTICE, ORCM_RAS_SEVERITY_INFO};
+    int i;
+
+    for (i=0; NULL != names[i]; i++) {
+        if (0 == strncasecmp(str, names[i], strlen(names[i]))) {
+            *severity = levels[i];
+            return ORCM_SUCCESS;
+        }
+    }
+    return ORCM_ERR_BAD_PARAM;
+}
+
+/* add a sensor to the packed limits, returning its id */
+static int add_sensor(mca_analytics_threshold_module_t *mod, const char *name,
+                      float lo, float hi)
+{
+    int id = mod->nsensors;
+    uintptr_t stored;
+    float *tmp;
+
+    if (0 < id && OPAL_SUCCESS == opal_hash_table_get_value_ptr(&mod->sensor_ids, name,
+                                                                strlen(name),
+                                                                (void**)&stored)) {
+        id = (int)stored;
+    } else {
+        /* keep the arrays we have if either cannot grow - a grown one
+         * merely has room to spare */
+        if (NULL == (tmp = (float*)realloc(mod->hi, (id + 1) * sizeof(float)))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        mod->hi = tmp;
+        if (NULL == (tmp = (float*)realloc(mod->lo, (id + 1) * sizeof(float)))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        mod->lo = tmp;
+        opal_argv_append_nosize(&mod->sensor_names, name);
+        if (0 < id) {
+            stored = (uintptr_t)id;
+            opal_hash_table_set_value_ptr(&mod->sensor_ids, name, strlen(name),
+                                          (void*)stored);
+        }
+        mod->nsensors++;
+    }
+    mod->hi[id] = hi;
+    mod->lo[id] = lo;
+    return id;
+}
+
+static int parse_limits(mca_analytics_threshold_module_t *mod, const char *str)
+{
+    char **sensors, **fields;
+    float lo, hi;
+    int i, rc = ORCM_SUCCESS;
+
+    sensors = opal_argv_split(str, ';');
+    for (i=0; NULL != sensors && NULL != sensors[i]; i++) {
+        fields = opal_argv_split_with_empty(sensors[i], ':');
+        lo = -INFINITY;
+        hi = INFINITY;
+        if (3 != opal_argv_count(fields) || '\0' == fields[0][0] ||
+            ORCM_SUCCESS != parse_limit(fields[1], &lo) ||
+            ORCM_SUCCESS != parse_limit(fields[2], &hi)) {
+            rc = ORCM_ERR_BAD_PARAM;
+        } else if (0 > (rc = add_sensor(mod, fields[0], lo, hi))) {
+            ORTE_ERROR_LOG(rc);
+        } else {
+            rc = ORCM_SUCCESS;
+        }
+        opal_argv_free(fields);
+        if (ORCM_SUCCESS != rc) {
+            break;
+        }
+    }
+    opal_argv_free(sensors);
+    return rc;
+}
+
+static int configure(mca_analytics_threshold_module_t *mod, orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+    float hi = INFINITY, lo = -INFINITY;
+    int i, rc;
+
+    /* id 0 is every sensor not listed */
+    if (0 > (rc = add_sensor(mod, "*", lo, hi))) {
+        return rc;
+    }
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL == attr->key || NULL == attr->data.string) {
+            continue;
+        }
+        rc = ORCM_SUCCESS;
+        if (0 == strcmp(attr->key, "hi")) {
+            rc = parse_limit(attr->data.string, &mod->hi[0]);
+        } else if (0 == strcmp(attr->key, "lo")) {
+            rc = parse_limit(attr->data.string, &mod->lo[0]);
+        } else if (0 == strcmp(attr->key, "limits")) {
+            rc = parse_limits(mod, attr->data.string);
+        } else if (0 == strcmp(attr->key, "hysteresis")) {
+            rc = parse_limit(attr->data.string, &mod->hysteresis);
+            if (0.0 > mod->hysteresis) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "count")) {
+            mod->count = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= mod->count) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "severity")) {
+            rc = parse_severity(attr->data.string, &mod->severity);
+        }
+        if (ORCM_SUCCESS != rc) {
+            opal_output(0, "%s analytics:threshold: bad value %s for attribute %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        attr->data.string, attr->key);
+            return rc;
+        }
+    }
+
+    /* a key past a limit is cleared once back within it by the hysteresis */
+    mod->clear_hi = (float*)malloc(mod->nsensors * sizeof(float));
+    mod->clear_lo = (float*)malloc(mod->nsensors * sizeof(float));
+    if (NULL == mod->clear_hi || NULL == mod->clear_lo) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    for (i=0; i < mod->nsensors; i++) {
+        mod->clear_hi[i] = mod->hi[i] - mod->hysteresis;
+        mod->clear_lo[i] = mod->lo[i] + mod->hysteresis;
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:threshold: %s limits %g to %g",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                             mod->sensor_names[i], mod->lo[i], mod->hi[i]));
+    }
+    mod->configured = true;
+    return ORCM_SUCCESS;
+}
+
+static int grow_batch(mca_analytics_threshold_module_t *mod, int size)
+{
+    if (size <= mod->batch_size) {
+        return ORCM_SUCCESS;
+    }
+    free_batch(mod);
+    mod->index = (int*)malloc(size * sizeof(int));
+    mod->x = (float*)malloc(size * sizeof(float));
+    mod->bhi = (float*)malloc(size * sizeof(float));
+    mod->blo = (float*)malloc(size * sizeof(float));
+    mod->bclear_hi = (float*)malloc(size * sizeof(float));
+    mod->bclear_lo = (float*)malloc(size * sizeof(float));
+    mod->flags = (uint8_t*)malloc(size * sizeof(uint8_t));
+    if (NULL == mod->index || NULL == mod->x || NULL == mod->bhi || NULL == mod->blo ||
+        NULL == mod->bclear_hi || NULL == mod->bclear_lo || NULL == mod->flags) {
+        free_batch(mod);
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    mod->batch_size = size;
+    return ORCM_SUCCESS;
+}
+
+/* flag a key as not at rest, growing the flags to take its id */
+static int set_active(mca_analytics_threshold_module_t *mod, uint32_t key_id, bool active)
+{
+    uint32_t n;
+    uint8_t *tmp;
+
+    if (key_id >= mod->active_size) {
+        if (!active) {
+            return ORCM_SUCCESS;
+        }
+        n = (0 == mod->active_size) ? THRESHOLD_STATES_INIT : 2 * mod->active_size;
+        if (n <= key_id) {
+            n = key_id + 1;
+        }
+        if (NULL == (tmp = (uint8_t*)realloc(mod->active, n))) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        memset(tmp + mod->active_size, 0, n - mod->active_size);
+        mod->active = tmp;
+        mod->active_size = n;
+    }
+    mod->active[key_id] = active ? 1 : 0;
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_threshold_state_t* get_state(mca_analytics_threshold_module_t *mod,
+                                                   orcm_analytics_value_t *value,
+                                                   bool create)
+{
+    orcm_analytics_threshold_state_t *st;
+
+    st = (orcm_analytics_threshold_state_t*)opal_pointer_array_get_item(&mod->states,
+                                                                        (int)value->key_id);
+    if (NULL != st || !create) {
+        return st;
+    }
+
+    st = OBJ_NEW(orcm_analytics_threshold_state_t);
+    st->key_id = value->key_id;
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&mod->states, (int)value->key_id, st)) {
+        OBJ_RELEASE(st);
+        return NULL;
+    }
+    return st;
+}
+
+static void generate_event(mca_analytics_threshold_module_t *mod,
+                           orcm_analytics_threshold_state_t *st,
+                           float x, float limit, time_t t)
+{
+    orcm_analytics_key_t *key = orcm_analytics_base_key_get(st->key_id);
+    orcm_ras_event_t *ev;
+
+    if (ORCM_ANALYTICS_THRESHOLD_NORMAL == st->level) {
+        mod->cleared++;
+    } else {
+        mod->raised++;
+    }
+    opal_output_verbose(1, orcm_analytics_base_framework.framework_output,
+                        "%s analytics:threshold: %s:%s:%s %s at %g (limit %g)",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        key->node_regex, key->sensor_name, key->label,
+                        (ORCM_ANALYTICS_THRESHOLD_HIGH == st->level) ? "high" :
+                        (ORCM_ANALYTICS_THRESHOLD_LOW == st->level) ? "low" : "cleared",
+                        x, limit);
+    if (NULL == orcm_evgen_evbase) {
+        /* no event generator in this process */
+        return;
+    }
+
+    ev = OBJ_NEW(orcm_ras_event_t);
+    ev->type = ORCM_RAS_EVENT_SENSOR;
+    ev->timestamp = t;
+    ORCM_RAS_REPORTER(ev, ORCM_LOC_NODE, key->node_regex, OPAL_STRING);
+    ORCM_RAS_REPORTER(ev, ORCM_COMPONENT_MON, key->sensor_name, OPAL_STRING);
+    switch (st->level) {
+    case ORCM_ANALYTICS_THRESHOLD_HIGH:
+        ev->severity = mod->severity;
+        ORCM_RAS_DESCRIPTION(ev, ORCM_DESC_LIMIT_HI, &limit, OPAL_FLOAT);
+        break;
+    case ORCM_ANALYTICS_THRESHOLD_LOW:
+        ev->severity = mod->severity;
+        ORCM_RAS_DESCRIPTION(ev, ORCM_DESC_LIMIT_LO, &limit, OPAL_FLOAT);
+        break;
+    default:
+        ev->severity = ORCM_RAS_SEVERITY_INFO;
+        ORCM_RAS_DESCRIPTION(ev, ORCM_DESC_LIMIT_CLEAR, &limit, OPAL_FLOAT);
+        break;
+    }
+    ORCM_RAS_DATA(ev, key->label, &x, OPAL_FLOAT);
+    ORCM_RAS_EVENT(ev);
+}
+
+/* run the state machine of a key on one sample of the batch */
+static void update_state(mca_analytics_threshold_module_t *mod,
+                         orcm_analytics_threshold_state_t *st,
+                         int j, time_t t)
+{
+    orcm_analytics_threshold_level_t side;
+    uint8_t flags = mod->flags[j];
+    int rc;
+
+    /* a raised key only looks at its clear level */
+    if (ORCM_ANALYTICS_THRESHOLD_HIGH == st->level) {
+        if (flags & THRESHOLD_ABOVE_CLEAR) {
+            return;
+        }
+        st->level = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+        generate_event(mod, st, mod->x[j], mod->bclear_hi[j], t);
+    } else if (ORCM_ANALYTICS_THRESHOLD_LOW == st->level) {
+        if (flags & THRESHOLD_BELOW_CLEAR) {
+            return;
+        }
+        st->level = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+        generate_event(mod, st, mod->x[j], mod->bclear_lo[j], t);
+    }
+
+    if (flags & THRESHOLD_PAST_HI) {
+        side = ORCM_ANALYTICS_THRESHOLD_HIGH;
+    } else if (flags & THRESHOLD_PAST_LO) {
+        side = ORCM_ANALYTICS_THRESHOLD_LOW;
+    } else {
+        side = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+    }
+    if (ORCM_ANALYTICS_THRESHOLD_NORMAL == side) {
+        st->count = 0;
+    } else if (side != st->pending) {
+        st->count = 1;
+    } else {
+        st->count++;
+    }
+    st->pending = side;
+    if (ORCM_ANALYTICS_THRESHOLD_NORMAL != side && mod->count <= st->count) {
+        st->level = side;
+        st->count = 0;
+        st->pending = ORCM_ANALYTICS_THRESHOLD_NORMAL;
+        generate_event(mod, st, mod->x[j],
+                       (ORCM_ANALYTICS_THRESHOLD_HIGH == side) ? mod->bhi[j] : mod->blo[j], t);
+    }
+
+    if (ORCM_SUCCESS != (rc = set_active(mod, st->key_id,
+                                         ORCM_ANALYTICS_THRESHOLD_NORMAL != st->level ||
+                                         0 < st->count))) {
+        ORTE_ERROR_LOG(rc);
+    }
 }
 
 static int analyze(int sd, short args, void *cbdata)
 {
     orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t *)cbdata;
-#if 0
     mca_analytics_threshold_module_t *mod;
-    mod = (mca_analytics_threshold_module_t *)caddy->imod;
-#endif
+    orcm_analytics_threshold_state_t *st;
+    orcm_analytics_value_t *value;
+    opal_value_array_t *data;
+    const char *last_sensor = NULL;
+    uintptr_t id = 0;
+    struct timeval now;
+    time_t t;
+    double x;
+    size_t index, size;
+    int n, j, rc;
+
+    if (NULL == caddy) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:threshold:NULL caddy data passed by the previous workflow step",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+        return ORCM_ERROR;
+    }
+    mod = (mca_analytics_threshold_module_t*)caddy->imod;
+
+    if (!mod->configured && ORCM_SUCCESS != (rc = configure(mod, caddy->wf_step))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    size = opal_value_array_get_size(caddy->data);
+    if (ORCM_SUCCESS != (rc = grow_batch(mod, (int)size))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    /* gather the values and the limits of their sensor - samples of
+     * the same sensor come together, so the id is only looked up when
+     * the sensor changes */
+    n = 0;
+    for (index=0; index < size; index++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, index);
+        if (NULL == value || ORCM_ANALYTICS_KEY_INVALID == value->key_id ||
+            !orcm_analytics_base_value_to_double(&value->data.value, &x)) {
+            continue;
+        }
+        if (NULL == last_sensor || 0 != strcmp(last_sensor, value->sensor_name)) {
+            last_sensor = value->sensor_name;
+            if (OPAL_SUCCESS != opal_hash_table_get_value_ptr(&mod->sensor_ids,
+                                                              last_sensor, strlen(last_sensor),
+                                                              (void**)&id)) {
+                id = 0;
+            }
+        }
+        mod->index[n] = (int)index;
+        mod->x[n] = (float)x;
+        mod->bhi[n] = mod->hi[id];
+        mod->blo[n] = mod->lo[id];
+        mod->bclear_hi[n] = mod->clear_hi[id];
+        mod->bclear_lo[n] = mod->clear_lo[id];
+        n++;
+    }
+
+    /* compare the whole batch against its limits */
+    for (j=0; j < n; j++) {
+        mod->flags[j] = (uint8_t)((mod->x[j] > mod->bhi[j]) |
+                                  ((mod->x[j] < mod->blo[j]) << 1) |
+                                  ((mod->x[j] > mod->bclear_hi[j]) << 2) |
+                                  ((mod->x[j] < mod->bclear_lo[j]) << 3));
+    }
+
+    /* only keys past a limit, or not at rest, need their state */
+    now.tv_sec = 0;
+    for (j=0; j < n; j++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data,
+                                                                   mod->index[j]);
+        if (0 == (mod->flags[j] & (THRESHOLD_PAST_HI | THRESHOLD_PAST_LO)) &&
+            (value->key_id >= mod->active_size || 0 == mod->active[value->key_id])) {
+            continue;
+        }
+        if (NULL == (st = get_state(mod, value, 0 != (mod->flags[j] &
+                                                      (THRESHOLD_PAST_HI | THRESHOLD_PAST_LO))))) {
+            continue;
+        }
+        if (0 != value->end_time.tv_sec) {
+            t = value->end_time.tv_sec;
+        } else {
+            if (0 == now.tv_sec) {
+                gettimeofday(&now, NULL);
+            }
+            t = now.tv_sec;
+        }
+        update_state(mod, st, j, t);
+    }
+
+    /* pass the samples on */
+    data = caddy->data;
+    OBJ_RETAIN(data);
+    orcm_analytics_base_store(caddy->wf, caddy->wf_step, data);
+    ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(caddy->wf, caddy->wf_step, data);
     OBJ_RELEASE(caddy);
 
     return ORCM_SUCCESS;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014      Intel, Inc. All rights reserved.
+ * Copyright (c) 2014-2015 Intel, Inc. All rights reserved.
  *
  * $COPYRIGHT$
  * 
@@ -18,6 +18,8 @@
 
 #include "orcm_config.h"
 
+#include "opal/class/opal_pointer_array.h"
+
 #include "orcm/mca/analytics/analytics.h"
 
 BEGIN_C_DECLS
@@ -28,8 +30,57 @@ BEGIN_C_DECLS
 
 ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_threshold_component;
 
+/* where a (node, sensor, label) stands with respect to its limits */
+typedef enum {
+    ORCM_ANALYTICS_THRESHOLD_NORMAL,
+    ORCM_ANALYTICS_THRESHOLD_HIGH,
+    ORCM_ANALYTICS_THRESHOLD_LOW
+} orcm_analytics_threshold_level_t;
+
+/* state of one (node, sensor, label) - count is the number of
+ * consecutive samples past the limit on the side given by pending */
+typedef struct {
+    opal_object_t super;
+    uint32_t key_id;
+    orcm_analytics_threshold_level_t level;
+    orcm_analytics_threshold_level_t pending;
+    int count;
+} orcm_analytics_threshold_state_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_threshold_state_t);
+
 typedef struct {
     orcm_analytics_base_module_t api;
+    bool configured;
+    /* limits of every sensor, packed by sensor id - id 0 holds the
+     * limits of the sensors not given their own. A missing limit is
+     * +/-INFINITY so that it is never crossed */
+    opal_hash_table_t sensor_ids;
+    int nsensors;
+    char **sensor_names;
+    float *hi;
+    float *lo;
+    float *clear_hi;
+    float *clear_lo;
+    float hysteresis;
+    int count;
+    int severity;
+    /* states, indexed by interned key id, and whether each key is not
+     * at rest - so that the samples of the keys at rest need no state */
+    opal_pointer_array_t states;
+    uint8_t *active;
+    uint32_t active_size;
+    /* per batch scratch space */
+    int batch_size;
+    int *index;
+    float *x;
+    float *bhi;
+    float *blo;
+    float *bclear_hi;
+    float *bclear_lo;
+    uint8_t *flags;
+    /* number of events raised and cleared */
+    uint64_t raised;
+    uint64_t cleared;
 } mca_analytics_threshold_module_t;
 ORCM_DECLSPEC extern mca_analytics_threshold_module_t orcm_analytics_threshold_module;
 
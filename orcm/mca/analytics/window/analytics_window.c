@@ -1,9 +1,9 @@
 /*
- * Copyright (c) 2014      Intel, Inc. All rights reserved.
+ * Copyright (c) 2014-2015 Intel, Inc. All rights reserved.
  * $COPYRIGHT$
- * 
+ *
  * Additional copyrights may follow
- * 
+ *
  * $HEADER$
  */
 
@@ -12,15 +12,58 @@
 
 #include <stdio.h>
 #include <ctype.h>
+#include <math.h>
+#include <sys/time.h>
 
+#include "opal/util/argv.h"
 #include "opal/util/output.h"
 
 #include "orte/util/name_fns.h"
 #include "orte/runtime/orte_globals.h"
 
-#include "orcm/mca/analytics/base/base.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
 #include "analytics_window.h"
 
+/*
+ * Window operator
+ *
+ * Each (node, sensor, label) seen by the step gets its own window
+ * state, indexed by the interned key id of the samples. The samples of a window
+ * are kept in a ring of fixed-size slots allocated with the state: a
+ * count window has exactly win_size slots, a time window win_slots.
+ * Mean and standard deviation are kept up to date as samples enter and
+ * leave the window (Welford), min and max through monotonic deques of
+ * the ring, so all of them cost O(1) per sample. Percentiles are
+ * selected from a copy of the window when it is emitted.
+ *
+ * The window is defined by the step attributes:
+ *
+ *    win_type=tumbling|sliding    default tumbling
+ *    win_size=<n>[ms|s|m|h]       samples without a unit, time otherwise;
+ *                                 default 60s
+ *    win_slide=<n>[ms|s|m|h]      how often a sliding window is emitted,
+ *                                 in the unit of win_size; default every
+ *                                 sample
+ *    win_slots=<n>                ring size of time windows, default 128
+ *    compute=<stat>[;<stat>...]   mean, min, max, stddev or pNN (e.g. p95);
+ *                                 default mean
+ *
+ * Tumbling time windows are aligned on multiples of their size, and are
+ * emitted when the first sample of the next window arrives. Each emitted
+ * statistic becomes one orcm_analytics_value_t covering the window from
+ * start_time to end_time; the key gets the name of the statistic appended
+ * when more than one is computed.
+ */
+
+#define WINDOW_DEFAULT_SIZE   60.0
+#define WINDOW_DEFAULT_SLOTS  128
+#define WINDOW_MAX_SLOTS      (1 << 20)
+#define WINDOW_KEY_MAX        512
+#define WINDOW_STATES_INIT    1024
+
+#define WINDOW_SLOT(st, seq) (&(st)->slots[(seq) % (uint64_t)(st)->nslots])
+#define WINDOW_COUNT(st)     ((st)->next - (st)->first)
+
 static int init(orcm_analytics_base_module_t *imod);
 static void finalize(orcm_analytics_base_module_t *imod);
 static int analyze(int sd, short args, void *cbdata);
@@ -29,37 +72,596 @@ mca_analytics_window_module_t orcm_analytics_window_module = {
     {
         init,
         finalize,
-        analyze
+        analyze,
+        NULL
     }
 };
 
+static void state_con(orcm_analytics_window_state_t *p)
+{
+    int i;
+
+    p->key_id = ORCM_ANALYTICS_KEY_INVALID;
+    for (i=0; i < ORCM_ANALYTICS_WINDOW_MAX_STATS; i++) {
+        p->out_ids[i] = ORCM_ANALYTICS_KEY_INVALID;
+    }
+    p->nslots = 0;
+    p->slots = NULL;
+    p->first = 0;
+    p->next = 0;
+    p->mean = 0.0;
+    p->m2 = 0.0;
+    p->mins = NULL;
+    p->min_head = 0;
+    p->min_count = 0;
+    p->maxs = NULL;
+    p->max_head = 0;
+    p->max_count = 0;
+    p->start = 0.0;
+    p->next_emit = 0.0;
+    p->since_emit = 0;
+    p->dropped = false;
+}
+static void state_des(orcm_analytics_window_state_t *p)
+{
+    free(p->slots);
+    free(p->mins);
+    free(p->maxs);
+}
+OBJ_CLASS_INSTANCE(orcm_analytics_window_state_t,
+                   opal_object_t,
+                   state_con, state_des);
+
 static int init(orcm_analytics_base_module_t *imod)
 {
-#if 0
     mca_analytics_window_module_t *mod;
+
+    if (NULL == imod) {
+        return ORCM_ERROR;
+    }
     mod = (mca_analytics_window_module_t*)imod;
-#endif
+    mod->api.orcm_mca_analytics_hash_table = NULL;
+    mod->configured = false;
+    mod->sliding = false;
+    mod->by_time = true;
+    mod->size = WINDOW_DEFAULT_SIZE;
+    mod->slide = 0.0;
+    mod->nslots = WINDOW_DEFAULT_SLOTS;
+    mod->ncompute = 0;
+    mod->need_minmax = false;
+    OBJ_CONSTRUCT(&mod->states, opal_pointer_array_t);
+    opal_pointer_array_init(&mod->states, WINDOW_STATES_INIT, INT32_MAX, WINDOW_STATES_INIT);
+    mod->scratch = NULL;
     return ORCM_SUCCESS;
 }
 
 static void finalize(orcm_analytics_base_module_t *imod)
 {
-#if 0
     mca_analytics_window_module_t *mod;
-    mod = (mca_analytics_window_module_t*)imod;
-#endif
+    orcm_analytics_window_state_t *st;
+    int i;
+
     OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
                          "%s analytics:window:finalize",
                          ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+    if (NULL == imod) {
+        return;
+    }
+    mod = (mca_analytics_window_module_t*)imod;
+    for (i=0; i < mod->states.size; i++) {
+        st = (orcm_analytics_window_state_t*)opal_pointer_array_get_item(&mod->states, i);
+        if (NULL != st) {
+            OBJ_RELEASE(st);
+        }
+    }
+    OBJ_DESTRUCT(&mod->states);
+    for (i=0; i < mod->ncompute; i++) {
+        free(mod->compute[i].name);
+    }
+    free(mod->scratch);
+    free(mod);
+}
+
+/* parse a window length: a number of samples, or a time with a unit */
+static int parse_length(const char *str, double *length, bool *by_time)
+{
+    char *end;
+    double val;
+
+    val = strtod(str, &end);
+    if (end != str && '\0' == *end) {
+        if (0 >= val || (double)(uint64_t)val != val) {
+            return ORCM_ERR_BAD_PARAM;
+        }
+        *by_time = false;
+        *length = val;
+        return ORCM_SUCCESS;
+    }
+    *by_time = true;
+    return orcm_analytics_base_parse_period(str, false, length);
+}
+
+static const orcm_analytics_base_stat_name_t stat_names[] = {
+    {"mean", ORCM_ANALYTICS_WINDOW_MEAN},
+    {"average", ORCM_ANALYTICS_WINDOW_MEAN},
+    {"min", ORCM_ANALYTICS_WINDOW_MIN},
+    {"max", ORCM_ANALYTICS_WINDOW_MAX},
+    {"stddev", ORCM_ANALYTICS_WINDOW_STDDEV},
+    {"sd", ORCM_ANALYTICS_WINDOW_STDDEV},
+    {NULL, 0}
+};
+
+static int parse_compute(mca_analytics_window_module_t *mod, const char *str)
+{
+    orcm_analytics_window_compute_t *c;
+    char **stats;
+    int i, stat, rc = ORCM_SUCCESS;
+
+    stats = opal_argv_split(str, ';');
+    for (i=0; NULL != stats && NULL != stats[i]; i++) {
+        if (ORCM_ANALYTICS_WINDOW_MAX_STATS == mod->ncompute) {
+            rc = ORCM_ERR_BAD_PARAM;
+            break;
+        }
+        c = &mod->compute[mod->ncompute];
+        if (ORCM_SUCCESS != (rc = orcm_analytics_base_parse_stat(stats[i], stat_names,
+                                                                 ORCM_ANALYTICS_WINDOW_PERCENTILE,
+                                                                 &stat, &c->percentile))) {
+            break;
+        }
+        c->stat = (orcm_analytics_window_stat_t)stat;
+        if (ORCM_ANALYTICS_WINDOW_MIN == c->stat || ORCM_ANALYTICS_WINDOW_MAX == c->stat) {
+            mod->need_minmax = true;
+        }
+        c->name = strdup(stats[i]);
+        mod->ncompute++;
+    }
+    opal_argv_free(stats);
+    return rc;
+}
+
+static int configure(mca_analytics_window_module_t *mod, orcm_workflow_step_t *wf_step)
+{
+    opal_value_t *attr;
+    bool slide_by_time = false, have_slide = false, have_slots = false;
+    int i, rc;
+
+    OPAL_LIST_FOREACH(attr, &wf_step->attributes, opal_value_t) {
+        if (NULL == attr->key || NULL == attr->data.string) {
+            continue;
+        }
+        rc = ORCM_SUCCESS;
+        if (0 == strcmp(attr->key, "win_type")) {
+            if (0 == strcmp(attr->data.string, "sliding")) {
+                mod->sliding = true;
+            } else if (0 != strcmp(attr->data.string, "tumbling")) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+        } else if (0 == strcmp(attr->key, "win_size")) {
+            rc = parse_length(attr->data.string, &mod->size, &mod->by_time);
+        } else if (0 == strcmp(attr->key, "win_slide")) {
+            rc = parse_length(attr->data.string, &mod->slide, &slide_by_time);
+            have_slide = true;
+        } else if (0 == strcmp(attr->key, "win_slots")) {
+            mod->nslots = (int)strtol(attr->data.string, NULL, 10);
+            if (0 >= mod->nslots || WINDOW_MAX_SLOTS < mod->nslots) {
+                rc = ORCM_ERR_BAD_PARAM;
+            }
+            have_slots = true;
+        } else if (0 == strcmp(attr->key, "compute")) {
+            rc = parse_compute(mod, attr->data.string);
+        }
+        if (ORCM_SUCCESS != rc) {
+            opal_output(0, "%s analytics:window: bad value %s for attribute %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        attr->data.string, attr->key);
+            return rc;
+        }
+    }
+
+    if (have_slide && slide_by_time != mod->by_time) {
+        opal_output(0, "%s analytics:window: win_slide and win_size must both be "
+                    "times or both be sample counts",
+                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME));
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (!mod->by_time) {
+        if (WINDOW_MAX_SLOTS < mod->size) {
+            return ORCM_ERR_BAD_PARAM;
+        }
+        mod->nslots = (int)mod->size;
+        if (!have_slide) {
+            mod->slide = 1.0;
+        }
+    } else if (!have_slots) {
+        mod->nslots = WINDOW_DEFAULT_SLOTS;
+    }
+    if (0 == mod->ncompute) {
+        mod->compute[0].stat = ORCM_ANALYTICS_WINDOW_MEAN;
+        mod->compute[0].percentile = 0.0;
+        mod->compute[0].name = strdup("mean");
+        mod->ncompute = 1;
+    }
+    for (i=0; i < mod->ncompute; i++) {
+        if (ORCM_ANALYTICS_WINDOW_PERCENTILE == mod->compute[i].stat) {
+            mod->scratch = (double*)malloc(mod->nslots * sizeof(double));
+            if (NULL == mod->scratch) {
+                return ORCM_ERR_OUT_OF_RESOURCE;
+            }
+            break;
+        }
+    }
+
+    OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                         "%s analytics:window: %s window of %g %s, %d slots, %d statistics",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                         mod->sliding ? "sliding" : "tumbling", mod->size,
+                         mod->by_time ? "sec" : "samples", mod->nslots, mod->ncompute));
+    mod->configured = true;
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_window_state_t* get_state(mca_analytics_window_module_t *mod,
+                                                orcm_analytics_value_t *value)
+{
+    orcm_analytics_window_state_t *st;
+    orcm_analytics_key_t *key;
+    char label[WINDOW_KEY_MAX];
+    int i;
+
+    st = (orcm_analytics_window_state_t*)opal_pointer_array_get_item(&mod->states,
+                                                                     (int)value->key_id);
+    if (NULL != st) {
+        return st;
+    }
+
+    if (NULL == (key = orcm_analytics_base_key_get(value->key_id))) {
+        return NULL;
+    }
+    st = OBJ_NEW(orcm_analytics_window_state_t);
+    st->key_id = value->key_id;
+    /* intern the keys of the emitted statistics once, here */
+    for (i=0; i < mod->ncompute; i++) {
+        if (1 == mod->ncompute) {
+            st->out_ids[i] = value->key_id;
+            continue;
+        }
+        snprintf(label, sizeof(label), "%s %s", key->label, mod->compute[i].name);
+        st->out_ids[i] = orcm_analytics_base_key_intern(key->node_regex, key->sensor_name,
+                                                        key->index, label, key->units);
+    }
+    st->nslots = mod->nslots;
+    st->slots = (orcm_analytics_window_slot_t*)malloc(st->nslots *
+                                                      sizeof(orcm_analytics_window_slot_t));
+    if (mod->need_minmax) {
+        st->mins = (uint64_t*)malloc(st->nslots * sizeof(uint64_t));
+        st->maxs = (uint64_t*)malloc(st->nslots * sizeof(uint64_t));
+    }
+    if (NULL == st->slots || (mod->need_minmax && (NULL == st->mins || NULL == st->maxs)) ||
+        OPAL_SUCCESS != opal_pointer_array_set_item(&mod->states, (int)value->key_id, st)) {
+        OBJ_RELEASE(st);
+        return NULL;
+    }
+    return st;
+}
+
+/* drop the deque entries that left the window, then push seq after
+ * dropping the entries it dominates */
+static void deque_push(orcm_analytics_window_state_t *st, uint64_t *dq,
+                       int *head, int *count, uint64_t seq, bool max)
+{
+    double v = WINDOW_SLOT(st, seq)->value, t;
+
+    while (0 < *count && dq[*head] < st->first) {
+        *head = (*head + 1) % st->nslots;
+        (*count)--;
+    }
+    while (0 < *count) {
+        t = WINDOW_SLOT(st, dq[(*head + *count - 1) % st->nslots])->value;
+        if (max ? t > v : t < v) {
+            break;
+        }
+        (*count)--;
+    }
+    dq[(*head + *count) % st->nslots] = seq;
+    (*count)++;
+}
+
+static double deque_front(orcm_analytics_window_state_t *st, uint64_t *dq,
+                          int *head, int *count)
+{
+    while (0 < *count && dq[*head] < st->first) {
+        *head = (*head + 1) % st->nslots;
+        (*count)--;
+    }
+    return WINDOW_SLOT(st, dq[*head])->value;
+}
+
+static void evict_oldest(orcm_analytics_window_state_t *st)
+{
+    double x, d;
+    uint64_t n;
+
+    x = WINDOW_SLOT(st, st->first)->value;
+    st->first++;
+    if (0 == (n = WINDOW_COUNT(st))) {
+        st->mean = 0.0;
+        st->m2 = 0.0;
+        return;
+    }
+    d = x - st->mean;
+    st->mean -= d / n;
+    st->m2 -= d * (x - st->mean);
+    if (0.0 > st->m2) {
+        st->m2 = 0.0;
+    }
+}
+
+static void add_sample(mca_analytics_window_module_t *mod,
+                       orcm_analytics_window_state_t *st, double x, double t)
+{
+    orcm_analytics_window_slot_t *slot;
+    orcm_analytics_key_t *key;
+    uint64_t seq;
+    double d;
+
+    if ((uint64_t)st->nslots == WINDOW_COUNT(st)) {
+        if (mod->by_time && !st->dropped) {
+            key = orcm_analytics_base_key_get(st->key_id);
+            opal_output_verbose(1, orcm_analytics_base_framework.framework_output,
+                                "%s analytics:window: more than %d samples of %s:%s:%s "
+                                "in a window, raise win_slots",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), st->nslots,
+                                key->node_regex, key->sensor_name, key->label);
+            st->dropped = true;
+        }
+        evict_oldest(st);
+    }
+    seq = st->next++;
+    slot = WINDOW_SLOT(st, seq);
+    slot->value = x;
+    slot->time = t;
+
+    d = x - st->mean;
+    st->mean += d / WINDOW_COUNT(st);
+    st->m2 += d * (x - st->mean);
+
+    if (mod->need_minmax) {
+        deque_push(st, st->mins, &st->min_head, &st->min_count, seq, false);
+        deque_push(st, st->maxs, &st->max_head, &st->max_count, seq, true);
+    }
+}
+
+static void reset_window(orcm_analytics_window_state_t *st)
+{
+    st->first = st->next;
+    st->mean = 0.0;
+    st->m2 = 0.0;
+    st->min_count = 0;
+    st->max_count = 0;
+}
+
+/* k-th smallest of v[0..n-1], reordering v */
+static double select_kth(double *v, int n, int k)
+{
+    int lo = 0, hi = n - 1, i, j;
+    double pivot, tmp;
+
+    while (lo < hi) {
+        pivot = v[lo + (hi - lo) / 2];
+        i = lo;
+        j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) {
+                i++;
+            }
+            while (v[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                tmp = v[i];
+                v[i] = v[j];
+                v[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return v[k];
+}
+
+static double percentile(mca_analytics_window_module_t *mod,
+                         orcm_analytics_window_state_t *st, double pct)
+{
+    int n = (int)WINDOW_COUNT(st), i, k;
+    double rank, lo, hi;
+    uint64_t seq;
+
+    for (i=0, seq=st->first; seq < st->next; i++, seq++) {
+        mod->scratch[i] = WINDOW_SLOT(st, seq)->value;
+    }
+    /* linear interpolation between the closest ranks */
+    rank = pct / 100.0 * (n - 1);
+    k = (int)rank;
+    lo = select_kth(mod->scratch, n, k);
+    if (k + 1 >= n || rank == (double)k) {
+        return lo;
+    }
+    /* after the selection everything above k is >= lo */
+    hi = mod->scratch[k + 1];
+    for (i=k + 2; i < n; i++) {
+        if (mod->scratch[i] < hi) {
+            hi = mod->scratch[i];
+        }
+    }
+    return lo + (rank - k) * (hi - lo);
+}
+
+static void emit(mca_analytics_window_module_t *mod, orcm_analytics_window_state_t *st,
+                 opal_value_array_t *results, double start, double end)
+{
+    orcm_analytics_value_t out;
+    orcm_analytics_window_compute_t *c;
+    double x = 0.0;
+    uint64_t n = WINDOW_COUNT(st);
+    int i;
+
+    if (0 == n) {
+        return;
+    }
+    for (i=0; i < mod->ncompute; i++) {
+        c = &mod->compute[i];
+        switch (c->stat) {
+        case ORCM_ANALYTICS_WINDOW_MEAN:
+            x = st->mean;
+            break;
+        case ORCM_ANALYTICS_WINDOW_MIN:
+            x = deque_front(st, st->mins, &st->min_head, &st->min_count);
+            break;
+        case ORCM_ANALYTICS_WINDOW_MAX:
+            x = deque_front(st, st->maxs, &st->max_head, &st->max_count);
+            break;
+        case ORCM_ANALYTICS_WINDOW_STDDEV:
+            x = (1 < n) ? sqrt(st->m2 / (n - 1)) : 0.0;
+            break;
+        case ORCM_ANALYTICS_WINDOW_PERCENTILE:
+            x = percentile(mod, st, c->percentile);
+            break;
+        }
+
+        memset(&out, 0, sizeof(out));
+        if (ORCM_SUCCESS != orcm_analytics_base_value_set_key(&out, st->out_ids[i])) {
+            continue;
+        }
+        out.comma_sep_plugin_list = "window";
+        out.data.value.type = OPAL_FLOAT;
+        out.data.value.data.fval = (float)x;
+        orcm_analytics_base_to_timeval(start, &out.start_time);
+        orcm_analytics_base_to_timeval(end, &out.end_time);
+        out.measured = false;
+        opal_value_array_append_item(results, &out);
+    }
+}
+
+static void window_sample(mca_analytics_window_module_t *mod,
+                          orcm_analytics_window_state_t *st,
+                          opal_value_array_t *results, double x, double t)
+{
+    if (!mod->sliding) {
+        if (mod->by_time) {
+            /* close the window this sample is past */
+            if (0 < WINDOW_COUNT(st) && t >= st->start + mod->size) {
+                emit(mod, st, results, st->start, st->start + mod->size);
+                reset_window(st);
+            }
+            if (0 == WINDOW_COUNT(st)) {
+                st->start = floor(t / mod->size) * mod->size;
+            }
+            add_sample(mod, st, x, t);
+        } else {
+            add_sample(mod, st, x, t);
+            if ((uint64_t)mod->size == WINDOW_COUNT(st)) {
+                emit(mod, st, results, WINDOW_SLOT(st, st->first)->time, t);
+                reset_window(st);
+            }
+        }
+        return;
+    }
+
+    if (mod->by_time) {
+        /* the window covers (t - size, t] */
+        while (0 < WINDOW_COUNT(st) &&
+               WINDOW_SLOT(st, st->first)->time <= t - mod->size) {
+            evict_oldest(st);
+        }
+        add_sample(mod, st, x, t);
+        if (t >= st->next_emit) {
+            emit(mod, st, results, t - mod->size, t);
+            st->next_emit = t + mod->slide;
+        }
+    } else {
+        /* the ring holds exactly one window, so adding evicts */
+        add_sample(mod, st, x, t);
+        st->since_emit++;
+        if ((uint64_t)mod->size == WINDOW_COUNT(st) &&
+            (double)st->since_emit >= mod->slide) {
+            emit(mod, st, results, WINDOW_SLOT(st, st->first)->time, t);
+            st->since_emit = 0;
+        }
+    }
 }
 
 static int analyze(int sd, short args, void *cbdata)
 {
     orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t *)cbdata;
-#if 0
     mca_analytics_window_module_t *mod;
+    orcm_analytics_window_state_t *st;
+    orcm_analytics_value_t *value;
+    opal_value_array_t *results = NULL;
+    struct timeval now;
+    double x, t;
+    size_t index, size;
+    int rc;
+
+    if (NULL == caddy) {
+        OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                             "%s analytics:window:NULL caddy data passed by the previous workflow step",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
+        return ORCM_ERROR;
+    }
     mod = (mca_analytics_window_module_t*)caddy->imod;
-#endif
+
+    if (!mod->configured && ORCM_SUCCESS != (rc = configure(mod, caddy->wf_step))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    size = opal_value_array_get_size(caddy->data);
+    if (ORCM_SUCCESS != (rc = orcm_analytics_base_step_array(caddy->wf_step, &results, 0))) {
+        OBJ_RELEASE(caddy);
+        return rc;
+    }
+
+    now.tv_sec = 0;
+    for (index=0; index < size; index++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, index);
+        if (NULL == value || ORCM_ANALYTICS_KEY_INVALID == value->key_id ||
+            !orcm_analytics_base_value_to_double(&value->data.value, &x)) {
+            continue;
+        }
+        /* samples are placed at the end of the time they cover */
+        if (0 != value->end_time.tv_sec) {
+            t = value->end_time.tv_sec + value->end_time.tv_usec / 1000000.0;
+        } else {
+            if (0 == now.tv_sec) {
+                gettimeofday(&now, NULL);
+            }
+            t = now.tv_sec + now.tv_usec / 1000000.0;
+        }
+        if (NULL == (st = get_state(mod, value))) {
+            OPAL_OUTPUT_VERBOSE((5, orcm_analytics_base_framework.framework_output,
+                                 "%s analytics:window:no window for %s:%s",
+                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                 value->node_regex, value->sensor_name));
+            continue;
+        }
+        window_sample(mod, st, results, x, t);
+    }
+
+    if (0 < opal_value_array_get_size(results)) {
+        /* load data to database if needed */
+        orcm_analytics_base_store(caddy->wf, caddy->wf_step, results);
+        ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(caddy->wf, caddy->wf_step, results);
+    } else {
+        OBJ_RELEASE(results);
+    }
     OBJ_RELEASE(caddy);
 
     return ORCM_SUCCESS;
@@ -1,16 +1,16 @@
 /*
- * Copyright (c) 2014      Intel, Inc. All rights reserved.
+ * Copyright (c) 2014-2015 Intel, Inc. All rights reserved.
  *
  * $COPYRIGHT$
- * 
+ *
  * Additional copyrights may follow
- * 
+ *
  * $HEADER$
  */
 
 /**
  * @file
- * 
+ *
  */
 
 #ifndef MCA_analytics_window_EXPORT_H
@@ -18,6 +18,8 @@
 
 #include "orcm_config.h"
 
+#include "opal/class/opal_pointer_array.h"
+
 #include "orcm/mca/analytics/analytics.h"
 
 BEGIN_C_DECLS
@@ -28,11 +30,78 @@ BEGIN_C_DECLS
 
 ORCM_MODULE_DECLSPEC extern orcm_analytics_base_component_t mca_analytics_window_component;
 
+/* statistics a window can compute */
+typedef enum {
+    ORCM_ANALYTICS_WINDOW_MEAN,
+    ORCM_ANALYTICS_WINDOW_MIN,
+    ORCM_ANALYTICS_WINDOW_MAX,
+    ORCM_ANALYTICS_WINDOW_STDDEV,
+    ORCM_ANALYTICS_WINDOW_PERCENTILE
+} orcm_analytics_window_stat_t;
+
+#define ORCM_ANALYTICS_WINDOW_MAX_STATS 8
+
+typedef struct {
+    orcm_analytics_window_stat_t stat;
+    double percentile;
+    char *name;
+} orcm_analytics_window_compute_t;
+
+/* one sample kept in a window */
+typedef struct {
+    double value;
+    double time;
+} orcm_analytics_window_slot_t;
+
+/* state of the window of one (node, sensor, label) - the samples are
+ * kept in a ring of nslots slots allocated with the state, and sample
+ * number seq lives in slot seq % nslots */
+typedef struct {
+    opal_object_t super;
+    /* interned key of the samples, and of each statistic emitted */
+    uint32_t key_id;
+    uint32_t out_ids[ORCM_ANALYTICS_WINDOW_MAX_STATS];
+    int nslots;
+    orcm_analytics_window_slot_t *slots;
+    /* sequence numbers of the oldest sample and of the next one */
+    uint64_t first;
+    uint64_t next;
+    /* running mean and sum of squared differences (Welford) */
+    double mean;
+    double m2;
+    /* monotonic deques of sequence numbers for min and max */
+    uint64_t *mins;
+    int min_head, min_count;
+    uint64_t *maxs;
+    int max_head, max_count;
+    /* start of the current tumbling window, time of the next emission
+     * of a sliding one, and samples since the last emission */
+    double start;
+    double next_emit;
+    uint64_t since_emit;
+    bool dropped;
+} orcm_analytics_window_state_t;
+OBJ_CLASS_DECLARATION(orcm_analytics_window_state_t);
+
 typedef struct {
     orcm_analytics_base_module_t api;
+    /* window definition, taken from the workflow step attributes */
+    bool configured;
+    bool sliding;
+    bool by_time;
+    double size;
+    double slide;
+    int nslots;
+    int ncompute;
+    orcm_analytics_window_compute_t compute[ORCM_ANALYTICS_WINDOW_MAX_STATS];
+    bool need_minmax;
+    /* window states, indexed by interned key id */
+    opal_pointer_array_t states;
+    /* scratch space for percentiles */
+    double *scratch;
 } mca_analytics_window_module_t;
 ORCM_DECLSPEC extern mca_analytics_window_module_t orcm_analytics_window_module;
 
 END_C_DECLS
 
-#endif /* MCA_analytics_threshold_EXPORT_H */
+#endif /* MCA_analytics_window_EXPORT_H */
@@ -38,6 +38,11 @@ typedef struct {
     char *config_file;
     int ping_rate;
     bool validate;
+    bool use_cache;
+    char *cache_file;
+    int tree_port;
+    char *tree_if;
+    bool tree_check_peer;
 } orcm_cfgi_base_t;
 ORCM_DECLSPEC extern orcm_cfgi_base_t orcm_cfgi_base;
 
@@ -73,6 +78,25 @@ ORCM_DECLSPEC int orcm_cfgi_base_identify_emulator_targets(opal_list_t *targets)
 ORCM_DECLSPEC int orcm_cfgi_base_get_proc_hostname(orte_process_name_t *proc, char **hostname);
 ORCM_DECLSPEC int orcm_cfgi_base_get_hostname_proc(char *hostname, orte_process_name_t *proc);
 
+/* compiled config cache */
+ORCM_DECLSPEC char* orcm_cfgi_base_cache_path(void);
+ORCM_DECLSPEC int orcm_cfgi_base_cache_write(char *file);
+ORCM_DECLSPEC int orcm_cfgi_base_cache_open(void);
+ORCM_DECLSPEC bool orcm_cfgi_base_cache_is_open(void);
+ORCM_DECLSPEC void orcm_cfgi_base_cache_close(void);
+ORCM_DECLSPEC int orcm_cfgi_base_cache_load(void);
+ORCM_DECLSPEC orcm_node_t* orcm_cfgi_base_cache_lookup(char *host, bool scheduler,
+                                                       orte_vpid_t *vpid,
+                                                       orte_vpid_t *parent);
+
+/* tree distribution of the system */
+ORCM_DECLSPEC int orcm_cfgi_base_tree_pack(opal_buffer_t *buf, char *host, char *ip);
+ORCM_DECLSPEC int orcm_cfgi_base_tree_unpack(opal_buffer_t *buf, orte_vpid_t *num_procs);
+ORCM_DECLSPEC int orcm_cfgi_base_tree_serve(void);
+ORCM_DECLSPEC void orcm_cfgi_base_tree_stop(void);
+ORCM_DECLSPEC int orcm_cfgi_base_tree_fetch(char *parent, char *host, char *ip,
+                                            int timeout, opal_buffer_t *slice);
+
 /* datatype support */
 ORCM_DECLSPEC int orcm_pack_node(opal_buffer_t *buffer, const void *src,
                                  int32_t num_vals, opal_data_type_t type);
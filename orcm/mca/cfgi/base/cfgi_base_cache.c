@@ -0,0 +1,691 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/types.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "opal_stdint.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/cfgi/base/base.h"
+
+/*
+ * Compiled config cache
+ *
+ * Lexing, checking and expanding the site file takes longer the larger
+ * the system, and every daemon, aggregator and scheduler does it at
+ * startup. orcm-cfgc does it once and writes the system it defines to a
+ * flat file: a header, one record per scheduler, cluster, row, rack and
+ * node in the order they are defined, a hash index of the records by
+ * daemon host and the strings they use. Each record carries the vpid of
+ * its daemon and of the daemon it reports to, so a daemon finds both for
+ * itself with a single lookup.
+ *
+ * The cfgi components mmap the file in place of reading the site file
+ * when it is there, its checksum is right and it was compiled from the
+ * site file as it is now - same size, same checksum. The file
+ * is written in host byte order: a file from another architecture fails
+ * the version check and the site file is read instead.
+ */
+
+#define ORCM_CFGI_CACHE_MAGIC      "ORCMCFGC"
+#define ORCM_CFGI_CACHE_VERSION    1
+
+typedef enum {
+    ORCM_CFGI_CACHE_SCHEDULER = 1,
+    ORCM_CFGI_CACHE_CLUSTER,
+    ORCM_CFGI_CACHE_ROW,
+    ORCM_CFGI_CACHE_RACK,
+    ORCM_CFGI_CACHE_NODE
+} orcm_cfgi_cache_kind_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t nrecords;
+    uint64_t checksum;          /* of everything after the header */
+    uint64_t size;              /* of the whole file */
+    uint64_t source_size;       /* of the site file it was compiled from */
+    uint64_t source_sum;
+    uint32_t nslots;            /* of the index, a power of two */
+    uint32_t nstrings;          /* bytes of strings */
+} orcm_cfgi_cache_header_t;
+
+/* strings are offsets into the string table, 0 for none. Lists of
+ * strings are one after the other, ending with an empty one */
+typedef struct {
+    uint32_t kind;
+    uint32_t name;              /* of the cluster, row or rack */
+    uint32_t host;              /* of the daemon */
+    int32_t state;
+    uint32_t vpid;
+    uint32_t parent;            /* ORTE_VPID_INVALID when its own */
+    uint32_t port;
+    uint32_t mca_params;
+    uint32_t env;
+    uint32_t queues;
+    uint32_t aggregator;
+    uint32_t pad;
+} orcm_cfgi_cache_record_t;
+
+static struct {
+    char *map;
+    size_t size;
+    orcm_cfgi_cache_header_t *hdr;
+    orcm_cfgi_cache_record_t *records;
+    uint32_t *slots;
+    char *strings;
+    /* the nodes rebuilt from the records */
+    orcm_node_t **nodes;
+} cache = {NULL, 0, NULL, NULL, NULL, NULL, NULL};
+
+#define CHECKSUM_INIT 14695981039346656037ull
+
+/* FNV-1a over 64-bit words, then over the bytes left */
+static uint64_t checksum(const unsigned char *data, size_t len, uint64_t h)
+{
+    uint64_t w;
+    size_t i;
+
+    for (i=0; i + sizeof(w) <= len; i += sizeof(w)) {
+        memcpy(&w, data + i, sizeof(w));
+        h = (h ^ w) * 1099511628211ull;
+    }
+    for (; i < len; i++) {
+        h = (h ^ data[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+/* FNV-1a */
+static uint32_t hash_str(const char *s)
+{
+    uint32_t h = 2166136261u;
+
+    for (; '\0' != *s; s++) {
+        h = (h ^ (unsigned char)*s) * 16777619u;
+    }
+    return h;
+}
+
+static int checksum_file(char *path, uint64_t *size, uint64_t *h)
+{
+    unsigned char data[65536];
+    size_t n;
+    FILE *fp;
+
+    if (NULL == (fp = fopen(path, "r"))) {
+        return ORCM_ERR_FILE_OPEN_FAILURE;
+    }
+    *size = 0;
+    *h = CHECKSUM_INIT;
+    /* every read but the last is a whole number of words */
+    while (0 < (n = fread(data, 1, sizeof(data), fp))) {
+        *h = checksum(data, n, *h);
+        *size += n;
+    }
+    if (ferror(fp)) {
+        fclose(fp);
+        return ORCM_ERR_FILE_READ_FAILURE;
+    }
+    fclose(fp);
+    return ORCM_SUCCESS;
+}
+
+char* orcm_cfgi_base_cache_path(void)
+{
+    char *path;
+
+    if (NULL != orcm_cfgi_base.cache_file && '\0' != orcm_cfgi_base.cache_file[0]) {
+        return strdup(orcm_cfgi_base.cache_file);
+    }
+    if (NULL == orcm_cfgi_base.config_file) {
+        return NULL;
+    }
+    if (0 > asprintf(&path, "%s.cache", orcm_cfgi_base.config_file)) {
+        return NULL;
+    }
+    return path;
+}
+
+/****    WRITING    ****/
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t used;
+} growbuf_t;
+
+static int grow(growbuf_t *b, size_t len)
+{
+    char *tmp;
+    size_t size;
+
+    if (b->used + len <= b->size) {
+        return ORCM_SUCCESS;
+    }
+    size = (0 == b->size) ? 4096 : b->size;
+    while (size < b->used + len) {
+        size *= 2;
+    }
+    if (NULL == (tmp = (char*)realloc(b->data, size))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    b->data = tmp;
+    b->size = size;
+    return ORCM_SUCCESS;
+}
+
+static uint32_t add_string(growbuf_t *s, const char *str)
+{
+    size_t len, off;
+
+    if (NULL == str) {
+        return 0;
+    }
+    len = strlen(str) + 1;
+    if (ORCM_SUCCESS != grow(s, len)) {
+        return UINT32_MAX;
+    }
+    off = s->used;
+    memcpy(s->data + off, str, len);
+    s->used += len;
+    return (uint32_t)off;
+}
+
+static uint32_t add_argv(growbuf_t *s, char **argv)
+{
+    uint32_t off;
+    int i;
+
+    if (NULL == argv) {
+        return 0;
+    }
+    off = (uint32_t)s->used;
+    for (i=0; NULL != argv[i]; i++) {
+        if (UINT32_MAX == add_string(s, argv[i])) {
+            return UINT32_MAX;
+        }
+    }
+    if (UINT32_MAX == add_string(s, "")) {
+        return UINT32_MAX;
+    }
+    return off;
+}
+
+static int add_record(growbuf_t *r, growbuf_t *s, orcm_cfgi_cache_kind_t kind,
+                      char *name, orcm_node_t *node, orte_vpid_t parent,
+                      char **queues)
+{
+    orcm_cfgi_cache_record_t *rec;
+
+    if (ORCM_SUCCESS != grow(r, sizeof(orcm_cfgi_cache_record_t))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    rec = (orcm_cfgi_cache_record_t*)(r->data + r->used);
+    memset(rec, 0, sizeof(orcm_cfgi_cache_record_t));
+    rec->kind = kind;
+    rec->name = add_string(s, name);
+    rec->host = add_string(s, node->name);
+    rec->state = node->state;
+    rec->vpid = node->daemon.vpid;
+    rec->parent = parent;
+    rec->port = add_string(s, node->config.port);
+    rec->mca_params = add_argv(s, node->config.mca_params);
+    rec->env = add_argv(s, node->config.env);
+    rec->queues = add_argv(s, queues);
+    rec->aggregator = node->config.aggregator;
+    if (UINT32_MAX == rec->name || UINT32_MAX == rec->host ||
+        UINT32_MAX == rec->port || UINT32_MAX == rec->mca_params ||
+        UINT32_MAX == rec->env || UINT32_MAX == rec->queues) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    r->used += sizeof(orcm_cfgi_cache_record_t);
+    return ORCM_SUCCESS;
+}
+
+/* the daemon a daemon reports to: the controller of the nearest
+ * level above that has one */
+static orte_vpid_t parent_of(orcm_node_t **levels, int n)
+{
+    int i;
+
+    for (i=n-1; 0 <= i; i--) {
+        if (ORCM_NODE_STATE_UNDEF != levels[i]->state) {
+            return levels[i]->daemon.vpid;
+        }
+    }
+    return ORTE_VPID_INVALID;
+}
+
+static int build_records(growbuf_t *r, growbuf_t *s)
+{
+    orcm_scheduler_t *scheduler;
+    orcm_cluster_t *cluster;
+    orcm_row_t *row;
+    orcm_rack_t *rack;
+    orcm_node_t *node, *levels[3];
+    int rc;
+
+    OPAL_LIST_FOREACH(scheduler, orcm_schedulers, orcm_scheduler_t) {
+        if (ORCM_SUCCESS != (rc = add_record(r, s, ORCM_CFGI_CACHE_SCHEDULER, NULL,
+                                             &scheduler->controller, ORTE_VPID_INVALID,
+                                             scheduler->queues))) {
+            return rc;
+        }
+    }
+    OPAL_LIST_FOREACH(cluster, orcm_clusters, orcm_cluster_t) {
+        levels[0] = &cluster->controller;
+        if (ORCM_SUCCESS != (rc = add_record(r, s, ORCM_CFGI_CACHE_CLUSTER, cluster->name,
+                                             &cluster->controller, ORTE_VPID_INVALID, NULL))) {
+            return rc;
+        }
+        OPAL_LIST_FOREACH(row, &cluster->rows, orcm_row_t) {
+            levels[1] = &row->controller;
+            if (ORCM_SUCCESS != (rc = add_record(r, s, ORCM_CFGI_CACHE_ROW, row->name,
+                                                 &row->controller, parent_of(levels, 1),
+                                                 NULL))) {
+                return rc;
+            }
+            OPAL_LIST_FOREACH(rack, &row->racks, orcm_rack_t) {
+                levels[2] = &rack->controller;
+                if (ORCM_SUCCESS != (rc = add_record(r, s, ORCM_CFGI_CACHE_RACK, rack->name,
+                                                     &rack->controller, parent_of(levels, 2),
+                                                     NULL))) {
+                    return rc;
+                }
+                OPAL_LIST_FOREACH(node, &rack->nodes, orcm_node_t) {
+                    if (ORCM_SUCCESS != (rc = add_record(r, s, ORCM_CFGI_CACHE_NODE, NULL,
+                                                         node, parent_of(levels, 3), NULL))) {
+                        return rc;
+                    }
+                }
+            }
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/* a record has a daemon when it has a host: the controllers that are
+ * not defined have none */
+static bool has_daemon(orcm_cfgi_cache_record_t *rec)
+{
+    return 0 != rec->host && (ORCM_CFGI_CACHE_SCHEDULER == rec->kind ||
+                              ORCM_CFGI_CACHE_NODE == rec->kind ||
+                              ORCM_NODE_STATE_UNDEF != rec->state);
+}
+
+int orcm_cfgi_base_cache_write(char *file)
+{
+    orcm_cfgi_cache_header_t hdr;
+    orcm_cfgi_cache_record_t *recs;
+    growbuf_t r, s;
+    uint32_t *slots = NULL, ndaemons, nrecs, i, h;
+    char *tmp = NULL;
+    FILE *fp;
+    int rc;
+
+    memset(&r, 0, sizeof(r));
+    memset(&s, 0, sizeof(s));
+    memset(&hdr, 0, sizeof(hdr));
+
+    if (ORCM_SUCCESS != (rc = checksum_file(orcm_cfgi_base.config_file,
+                                            &hdr.source_size, &hdr.source_sum))) {
+        return rc;
+    }
+
+    /* offset 0 of the strings is no string */
+    if (UINT32_MAX == add_string(&s, "") ||
+        ORCM_SUCCESS != (rc = build_records(&r, &s))) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto cleanup;
+    }
+    nrecs = r.used / sizeof(orcm_cfgi_cache_record_t);
+    recs = (orcm_cfgi_cache_record_t*)r.data;
+
+    /* index the daemons by host, keeping them in the order they are
+     * defined along each probe sequence */
+    for (hdr.nslots = 16; hdr.nslots < 2 * nrecs; hdr.nslots *= 2);
+    if (NULL == (slots = (uint32_t*)calloc(hdr.nslots, sizeof(uint32_t)))) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto cleanup;
+    }
+    ndaemons = 0;
+    for (i=0; i < nrecs; i++) {
+        if (!has_daemon(&recs[i])) {
+            continue;
+        }
+        ndaemons++;
+        h = hash_str(s.data + recs[i].host) & (hdr.nslots - 1);
+        while (0 != slots[h]) {
+            h = (h + 1) & (hdr.nslots - 1);
+        }
+        slots[h] = i + 1;
+    }
+
+    /* the records are followed by the index and the strings */
+    if (ORCM_SUCCESS != grow(&r, hdr.nslots * sizeof(uint32_t) + s.used)) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto cleanup;
+    }
+    memcpy(r.data + r.used, slots, hdr.nslots * sizeof(uint32_t));
+    r.used += hdr.nslots * sizeof(uint32_t);
+    memcpy(r.data + r.used, s.data, s.used);
+    r.used += s.used;
+
+    memcpy(hdr.magic, ORCM_CFGI_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = ORCM_CFGI_CACHE_VERSION;
+    hdr.nrecords = nrecs;
+    hdr.nstrings = s.used;
+    hdr.size = sizeof(hdr) + r.used;
+    hdr.checksum = checksum((unsigned char*)r.data, r.used, CHECKSUM_INIT);
+
+    /* write it aside and move it in place, so a daemon starting
+     * meanwhile never sees it half written */
+    if (0 > asprintf(&tmp, "%s.%lu", file, (unsigned long)getpid())) {
+        tmp = NULL;
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto cleanup;
+    }
+    if (NULL == (fp = fopen(tmp, "w"))) {
+        rc = ORCM_ERR_FILE_OPEN_FAILURE;
+        goto cleanup;
+    }
+    if (1 != fwrite(&hdr, sizeof(hdr), 1, fp) ||
+        1 != fwrite(r.data, r.used, 1, fp)) {
+        fclose(fp);
+        unlink(tmp);
+        rc = ORCM_ERR_FILE_WRITE_FAILURE;
+        goto cleanup;
+    }
+    if (0 != fclose(fp) || 0 != rename(tmp, file)) {
+        unlink(tmp);
+        rc = ORCM_ERR_FILE_WRITE_FAILURE;
+        goto cleanup;
+    }
+    opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                        "cfgi:base:cache wrote %s: %u records, %u daemons, %lu bytes",
+                        file, nrecs, ndaemons, (unsigned long)hdr.size);
+    rc = ORCM_SUCCESS;
+
+ cleanup:
+    free(tmp);
+    free(slots);
+    free(r.data);
+    free(s.data);
+    return rc;
+}
+
+/****    READING    ****/
+
+static int cache_stale(char *path, char *why)
+{
+    opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                        "cfgi:base:cache not using %s: %s", path, why);
+    orcm_cfgi_base_cache_close();
+    free(path);
+    return ORCM_ERR_NOT_FOUND;
+}
+
+int orcm_cfgi_base_cache_open(void)
+{
+    orcm_cfgi_cache_header_t *hdr;
+    struct stat st;
+    uint64_t size, sum;
+    uint32_t i;
+    char *path;
+    int fd;
+
+    if (NULL != cache.map) {
+        return ORCM_SUCCESS;
+    }
+    if (!orcm_cfgi_base.use_cache || NULL == orcm_cfgi_base.config_file ||
+        NULL == (path = orcm_cfgi_base_cache_path())) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    if (0 > (fd = open(path, O_RDONLY))) {
+        free(path);
+        return ORCM_ERR_NOT_FOUND;
+    }
+    if (0 != fstat(fd, &st) || st.st_size < (off_t)sizeof(orcm_cfgi_cache_header_t)) {
+        close(fd);
+        return cache_stale(path, "truncated");
+    }
+    cache.map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == cache.map) {
+        cache.map = NULL;
+        return cache_stale(path, strerror(errno));
+    }
+    cache.size = st.st_size;
+    hdr = (orcm_cfgi_cache_header_t*)cache.map;
+
+    if (0 != memcmp(hdr->magic, ORCM_CFGI_CACHE_MAGIC, sizeof(hdr->magic)) ||
+        ORCM_CFGI_CACHE_VERSION != hdr->version) {
+        return cache_stale(path, "not a config cache of this version");
+    }
+    if (hdr->size != cache.size || 0 == hdr->nslots ||
+        0 != (hdr->nslots & (hdr->nslots - 1)) || 0 == hdr->nstrings ||
+        hdr->size != sizeof(*hdr) + (uint64_t)hdr->nrecords * sizeof(orcm_cfgi_cache_record_t) +
+                     (uint64_t)hdr->nslots * sizeof(uint32_t) + hdr->nstrings) {
+        return cache_stale(path, "truncated");
+    }
+    /* the site file changed since it was compiled */
+    if (ORCM_SUCCESS != checksum_file(orcm_cfgi_base.config_file, &size, &sum) ||
+        size != hdr->source_size || sum != hdr->source_sum) {
+        return cache_stale(path, "out of date");
+    }
+    sum = checksum((unsigned char*)cache.map + sizeof(*hdr), cache.size - sizeof(*hdr),
+                   CHECKSUM_INIT);
+    if (sum != hdr->checksum) {
+        return cache_stale(path, "bad checksum");
+    }
+
+    cache.hdr = hdr;
+    cache.records = (orcm_cfgi_cache_record_t*)(cache.map + sizeof(*hdr));
+    cache.slots = (uint32_t*)(cache.records + hdr->nrecords);
+    cache.strings = (char*)(cache.slots + hdr->nslots);
+    /* the strings must all end within the table */
+    if ('\0' != cache.strings[hdr->nstrings - 1]) {
+        return cache_stale(path, "bad strings");
+    }
+    for (i=0; i < hdr->nslots; i++) {
+        if (hdr->nrecords < cache.slots[i]) {
+            return cache_stale(path, "bad index");
+        }
+    }
+    for (i=0; i < hdr->nrecords; i++) {
+        if (hdr->nstrings <= cache.records[i].name ||
+            hdr->nstrings <= cache.records[i].host ||
+            hdr->nstrings <= cache.records[i].port ||
+            hdr->nstrings <= cache.records[i].mca_params ||
+            hdr->nstrings <= cache.records[i].env ||
+            hdr->nstrings <= cache.records[i].queues) {
+            return cache_stale(path, "bad record");
+        }
+    }
+    opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                        "cfgi:base:cache using %s: %u records",
+                        path, hdr->nrecords);
+    free(path);
+    return ORCM_SUCCESS;
+}
+
+bool orcm_cfgi_base_cache_is_open(void)
+{
+    return NULL != cache.hdr;
+}
+
+void orcm_cfgi_base_cache_close(void)
+{
+    if (NULL != cache.map) {
+        munmap(cache.map, cache.size);
+    }
+    free(cache.nodes);
+    memset(&cache, 0, sizeof(cache));
+}
+
+static char* get_string(uint32_t off)
+{
+    return (0 == off) ? NULL : cache.strings + off;
+}
+
+static char** get_argv(uint32_t off)
+{
+    char **argv = NULL, *s;
+
+    if (0 == off) {
+        return NULL;
+    }
+    for (s = cache.strings + off; '\0' != *s; s += strlen(s) + 1) {
+        opal_argv_append_nosize(&argv, s);
+    }
+    return argv;
+}
+
+static char* dup_string(uint32_t off)
+{
+    return (0 == off) ? NULL : strdup(cache.strings + off);
+}
+
+static void load_node(orcm_node_t *node, orcm_cfgi_cache_record_t *rec)
+{
+    node->name = dup_string(rec->host);
+    node->state = rec->state;
+    node->config.port = dup_string(rec->port);
+    node->config.mca_params = get_argv(rec->mca_params);
+    node->config.env = get_argv(rec->env);
+    node->config.aggregator = (0 != rec->aggregator);
+}
+
+int orcm_cfgi_base_cache_load(void)
+{
+    orcm_cfgi_cache_record_t *rec;
+    orcm_scheduler_t *scheduler;
+    orcm_cluster_t *cluster = NULL;
+    orcm_row_t *row = NULL;
+    orcm_rack_t *rack = NULL;
+    orcm_node_t *node;
+    uint32_t i;
+
+    if (NULL == cache.hdr) {
+        return ORCM_ERR_NOT_INITIALIZED;
+    }
+    free(cache.nodes);
+    cache.nodes = (orcm_node_t**)calloc(cache.hdr->nrecords + 1, sizeof(orcm_node_t*));
+    if (NULL == cache.nodes) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+
+    /* the records come in the order of the tree, so each row, rack
+     * and node belongs to the cluster, row and rack last seen */
+    for (i=0; i < cache.hdr->nrecords; i++) {
+        rec = &cache.records[i];
+        switch (rec->kind) {
+        case ORCM_CFGI_CACHE_SCHEDULER:
+            scheduler = OBJ_NEW(orcm_scheduler_t);
+            load_node(&scheduler->controller, rec);
+            scheduler->queues = get_argv(rec->queues);
+            opal_list_append(orcm_schedulers, &scheduler->super);
+            cache.nodes[i] = &scheduler->controller;
+            break;
+        case ORCM_CFGI_CACHE_CLUSTER:
+            cluster = OBJ_NEW(orcm_cluster_t);
+            cluster->name = dup_string(rec->name);
+            load_node(&cluster->controller, rec);
+            opal_list_append(orcm_clusters, &cluster->super);
+            cache.nodes[i] = &cluster->controller;
+            row = NULL;
+            rack = NULL;
+            break;
+        case ORCM_CFGI_CACHE_ROW:
+            if (NULL == cluster) {
+                ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+                return ORCM_ERR_BAD_PARAM;
+            }
+            row = OBJ_NEW(orcm_row_t);
+            row->name = dup_string(rec->name);
+            OBJ_RETAIN(cluster);
+            row->cluster = cluster;
+            load_node(&row->controller, rec);
+            opal_list_append(&cluster->rows, &row->super);
+            cache.nodes[i] = &row->controller;
+            rack = NULL;
+            break;
+        case ORCM_CFGI_CACHE_RACK:
+            if (NULL == row) {
+                ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+                return ORCM_ERR_BAD_PARAM;
+            }
+            rack = OBJ_NEW(orcm_rack_t);
+            rack->name = dup_string(rec->name);
+            OBJ_RETAIN(row);
+            rack->row = row;
+            load_node(&rack->controller, rec);
+            opal_list_append(&row->racks, &rack->super);
+            cache.nodes[i] = &rack->controller;
+            break;
+        case ORCM_CFGI_CACHE_NODE:
+            if (NULL == rack) {
+                ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+                return ORCM_ERR_BAD_PARAM;
+            }
+            node = OBJ_NEW(orcm_node_t);
+            load_node(node, rec);
+            OBJ_RETAIN(rack);
+            node->rack = (struct orcm_rack_t*)rack;
+            opal_list_append(&rack->nodes, &node->super);
+            cache.nodes[i] = node;
+            break;
+        default:
+            ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+            return ORCM_ERR_BAD_PARAM;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+orcm_node_t* orcm_cfgi_base_cache_lookup(char *host, bool scheduler,
+                                         orte_vpid_t *vpid, orte_vpid_t *parent)
+{
+    orcm_cfgi_cache_record_t *rec;
+    uint32_t h, n;
+
+    if (NULL == cache.hdr || NULL == cache.nodes || NULL == host) {
+        return NULL;
+    }
+    h = hash_str(host) & (cache.hdr->nslots - 1);
+    for (n=0; n < cache.hdr->nslots && 0 != cache.slots[h]; n++) {
+        rec = &cache.records[cache.slots[h] - 1];
+        if (scheduler == (ORCM_CFGI_CACHE_SCHEDULER == rec->kind) &&
+            0 == strcmp(get_string(rec->host), host)) {
+            *vpid = rec->vpid;
+            *parent = rec->parent;
+            return cache.nodes[cache.slots[h] - 1];
+        }
+        h = (h + 1) & (cache.hdr->nslots - 1);
+    }
+    return NULL;
+}
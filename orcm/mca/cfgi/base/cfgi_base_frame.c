@@ -74,6 +74,47 @@ static int orcm_cfgi_base_register(mca_base_register_flag_t flags)
                                  MCA_BASE_VAR_SCOPE_READONLY,
                                  &orcm_cfgi_base.validate);
 
+    /* do we want to use the compiled copy of the config file? */
+    orcm_cfgi_base.use_cache = true;
+    (void) mca_base_var_register("orcm", "cfgi", "base", "use_cache",
+                                 "Use the compiled copy of the ORCM configuration file when it is up to date",
+                                 MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &orcm_cfgi_base.use_cache);
+
+    orcm_cfgi_base.cache_file = NULL;
+    (void) mca_base_var_register("orcm", "cfgi", "base", "cache_file",
+                                 "Compiled copy of the ORCM configuration file [default: the config file with .cache appended]",
+                                 MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &orcm_cfgi_base.cache_file);
+
+    orcm_cfgi_base.tree_port = 0;
+    (void) mca_base_var_register("orcm", "cfgi", "base", "tree_port",
+                                 "Port on which aggregators serve their part of the system to the daemons below them, and on which those daemons ask for it [default: not served]",
+                                 MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &orcm_cfgi_base.tree_port);
+
+    orcm_cfgi_base.tree_if = NULL;
+    (void) mca_base_var_register("orcm", "cfgi", "base", "tree_if",
+                                 "Interface or address on which aggregators serve their part of the system [default: the address of their host]",
+                                 MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &orcm_cfgi_base.tree_if);
+
+    orcm_cfgi_base.tree_check_peer = true;
+    (void) mca_base_var_register("orcm", "cfgi", "base", "tree_check_peer",
+                                 "Serve a daemon its part of the system only when it asks from an address of its host",
+                                 MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &orcm_cfgi_base.tree_check_peer);
+
     return ORCM_SUCCESS;
 }
 
@@ -88,6 +129,8 @@ static int orcm_cfgi_base_close(void)
         }
     }
     OPAL_LIST_DESTRUCT(&orcm_cfgi_base.actives);
+    orcm_cfgi_base_cache_close();
+    orcm_cfgi_base_tree_stop();
 
     return mca_base_framework_components_close(&orcm_cfgi_base_framework, NULL);
 }
@@ -222,6 +265,7 @@ static void nd_con(orcm_node_t *p)
     OBJ_CONSTRUCT(&p->config, orcm_config_t);
     p->state = ORCM_NODE_STATE_UNDEF;
     p->scd_state = ORCM_SCD_NODE_STATE_UNDEF;
+    p->scd_index = -1;
     p->npes = 0;
 #if OPAL_HAVE_HWLOC
     p->topology = NULL;
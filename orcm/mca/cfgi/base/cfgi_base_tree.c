@@ -0,0 +1,985 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/types.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
+#ifdef HAVE_NETDB_H
+#include <netdb.h>
+#endif
+
+#include "opal_stdint.h"
+#include "opal/dss/dss.h"
+#include "opal/mca/event/event.h"
+#include "opal/util/argv.h"
+#include "opal/util/if.h"
+#include "opal/util/net.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/cfgi/base/base.h"
+
+/*
+ * Tree distribution of the system definition
+ *
+ * Instead of every daemon reading and expanding the site file, the
+ * daemons that did - or that were given their part of the system this
+ * way - serve it to the daemons below them. A daemon asks by host and
+ * gets back its slice of the system: the schedulers, the controllers on
+ * the path from its cluster down to it, and everything below it. An
+ * aggregator so holds what each of its children needs and serves them
+ * in turn, while a compute daemon gets just its node and the controllers
+ * above it.
+ *
+ * The exchange takes place before the daemon knows its name and can
+ * use the RML, so it is a length-prefixed request and reply over a
+ * plain TCP connection. A slice is packed as
+ *
+ *   ORTE_VPID  number of daemons in the whole system
+ *   INT32      number of schedulers, then for each: ORCM_NODE controller,
+ *              INT32 number of queues, STRING each queue
+ *   INT32      number of clusters, then for each: STRING name, ORCM_NODE
+ *              controller, INT32 number of rows, then for each row the
+ *              same down to the racks, whose nodes are each an ORCM_NODE
+ *
+ * with the daemon names as assigned by the daemon that read the site
+ * file, so they hold across the whole system.
+ *
+ * A slice carries the MCA params and environment of its daemons, which
+ * may hold credentials, so an aggregator serves only on its own address
+ * and only the daemons below it, each to a requester on the daemon's host.
+ */
+
+/* nobody has a site file this large */
+#define ORCM_CFGI_TREE_MAX_MSG  (256 * 1024 * 1024)
+
+typedef struct {
+    opal_object_t super;
+    opal_event_t ev;
+    int sd;
+    struct sockaddr_in addr;
+    uint32_t hdr;
+    char *data;
+    size_t size;
+    size_t pos;
+} orcm_cfgi_tree_conn_t;
+static void conn_con(orcm_cfgi_tree_conn_t *p)
+{
+    p->sd = -1;
+    p->hdr = 0;
+    p->data = NULL;
+    p->size = 0;
+    p->pos = 0;
+}
+static void conn_des(orcm_cfgi_tree_conn_t *p)
+{
+    if (0 <= p->sd) {
+        opal_event_del(&p->ev);
+        close(p->sd);
+    }
+    if (NULL != p->data) {
+        free(p->data);
+    }
+}
+static OBJ_CLASS_INSTANCE(orcm_cfgi_tree_conn_t,
+                          opal_object_t,
+                          conn_con, conn_des);
+
+static struct {
+    int sd;
+    opal_event_t ev;
+} server = {-1};
+
+/****    PACKING    ****/
+
+static int pack_node(opal_buffer_t *buf, orcm_node_t *node)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &node, 1, ORCM_NODE))) {
+        ORTE_ERROR_LOG(rc);
+    }
+    return rc;
+}
+
+static int pack_count(opal_buffer_t *buf, int32_t n)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &n, 1, OPAL_INT32))) {
+        ORTE_ERROR_LOG(rc);
+    }
+    return rc;
+}
+
+static int pack_name(opal_buffer_t *buf, char *name)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &name, 1, OPAL_STRING))) {
+        ORTE_ERROR_LOG(rc);
+    }
+    return rc;
+}
+
+/* pack a rack - all of it, or only the given node */
+static int pack_rack(opal_buffer_t *buf, orcm_rack_t *rack, orcm_node_t *only)
+{
+    orcm_node_t *node;
+    int rc;
+
+    if (ORCM_SUCCESS != (rc = pack_name(buf, rack->name)) ||
+        ORCM_SUCCESS != (rc = pack_node(buf, &rack->controller))) {
+        return rc;
+    }
+    if (NULL != only) {
+        if (ORCM_SUCCESS != (rc = pack_count(buf, 1))) {
+            return rc;
+        }
+        return pack_node(buf, only);
+    }
+    if (ORCM_SUCCESS != (rc = pack_count(buf, opal_list_get_size(&rack->nodes)))) {
+        return rc;
+    }
+    OPAL_LIST_FOREACH(node, &rack->nodes, orcm_node_t) {
+        if (ORCM_SUCCESS != (rc = pack_node(buf, node))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/* pack a row - all of it, or only the path to the given rack */
+static int pack_row(opal_buffer_t *buf, orcm_row_t *row,
+                    orcm_rack_t *only, orcm_node_t *node)
+{
+    orcm_rack_t *rack;
+    int rc;
+
+    if (ORCM_SUCCESS != (rc = pack_name(buf, row->name)) ||
+        ORCM_SUCCESS != (rc = pack_node(buf, &row->controller))) {
+        return rc;
+    }
+    if (NULL != only) {
+        if (ORCM_SUCCESS != (rc = pack_count(buf, 1))) {
+            return rc;
+        }
+        return pack_rack(buf, only, node);
+    }
+    if (ORCM_SUCCESS != (rc = pack_count(buf, opal_list_get_size(&row->racks)))) {
+        return rc;
+    }
+    OPAL_LIST_FOREACH(rack, &row->racks, orcm_rack_t) {
+        if (ORCM_SUCCESS != (rc = pack_rack(buf, rack, NULL))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/* pack a cluster - all of it, or only the path to the given row */
+static int pack_cluster(opal_buffer_t *buf, orcm_cluster_t *cluster,
+                        orcm_row_t *only, orcm_rack_t *rack, orcm_node_t *node)
+{
+    orcm_row_t *row;
+    int rc;
+
+    if (ORCM_SUCCESS != (rc = pack_name(buf, cluster->name)) ||
+        ORCM_SUCCESS != (rc = pack_node(buf, &cluster->controller))) {
+        return rc;
+    }
+    if (NULL != only) {
+        if (ORCM_SUCCESS != (rc = pack_count(buf, 1))) {
+            return rc;
+        }
+        return pack_row(buf, only, rack, node);
+    }
+    if (ORCM_SUCCESS != (rc = pack_count(buf, opal_list_get_size(&cluster->rows)))) {
+        return rc;
+    }
+    OPAL_LIST_FOREACH(row, &cluster->rows, orcm_row_t) {
+        if (ORCM_SUCCESS != (rc = pack_row(buf, row, NULL, NULL))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/* is this the daemon on the given host? Hosts given by address
+ * in the config are matched against the address of the host */
+static bool is_host(orcm_node_t *node, char *host, char *ip)
+{
+    if (ORTE_NODE_STATE_UNDEF == node->state || NULL == node->name) {
+        return false;
+    }
+    if (opal_net_isaddr(node->name)) {
+        return (NULL != ip && 0 == strcmp(node->name, ip));
+    }
+    return (0 == strcmp(node->name, host));
+}
+
+static bool is_me(orcm_node_t *node)
+{
+    return (ORTE_NODE_STATE_UNDEF != node->state &&
+            node->daemon.vpid == ORTE_PROC_MY_NAME->vpid);
+}
+
+/* is the daemon found in our part of the tree, below us? */
+static bool below_me(orcm_cluster_t *cluster, orcm_row_t *row,
+                     orcm_rack_t *rack, orcm_node_t *node)
+{
+    if (NULL == row) {
+        return false;
+    }
+    if (is_me(&cluster->controller)) {
+        return true;
+    }
+    if (NULL == rack) {
+        return false;
+    }
+    if (is_me(&row->controller)) {
+        return true;
+    }
+    return (NULL != node && is_me(&rack->controller));
+}
+
+int orcm_cfgi_base_tree_pack(opal_buffer_t *buf, char *host, char *ip)
+{
+    orcm_scheduler_t *scheduler;
+    orcm_cluster_t *cluster;
+    orcm_row_t *row;
+    orcm_rack_t *rack;
+    orcm_node_t *node;
+    int32_t i, n;
+    int rc;
+
+    if (NULL == host) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+
+    /* find the first daemon on the host, in the order the
+     * daemons look themselves up in the site file */
+    OPAL_LIST_FOREACH(cluster, orcm_clusters, orcm_cluster_t) {
+        if (is_host(&cluster->controller, host, ip)) {
+            row = NULL;
+            rack = NULL;
+            node = NULL;
+            goto found;
+        }
+        OPAL_LIST_FOREACH(row, &cluster->rows, orcm_row_t) {
+            if (is_host(&row->controller, host, ip)) {
+                rack = NULL;
+                node = NULL;
+                goto found;
+            }
+            OPAL_LIST_FOREACH(rack, &row->racks, orcm_rack_t) {
+                if (is_host(&rack->controller, host, ip)) {
+                    node = NULL;
+                    goto found;
+                }
+                OPAL_LIST_FOREACH(node, &rack->nodes, orcm_node_t) {
+                    if (is_host(node, host, ip)) {
+                        goto found;
+                    }
+                }
+            }
+        }
+    }
+    return ORCM_ERR_NOT_FOUND;
+
+ found:
+    /* we only hold the path above us, so what we have of
+     * anyone else is not theirs to have */
+    if (!below_me(cluster, row, rack, node)) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &orte_process_info.num_procs, 1, ORTE_VPID))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    if (ORCM_SUCCESS != (rc = pack_count(buf, opal_list_get_size(orcm_schedulers)))) {
+        return rc;
+    }
+    OPAL_LIST_FOREACH(scheduler, orcm_schedulers, orcm_scheduler_t) {
+        if (ORCM_SUCCESS != (rc = pack_node(buf, &scheduler->controller))) {
+            return rc;
+        }
+        n = opal_argv_count(scheduler->queues);
+        if (ORCM_SUCCESS != (rc = pack_count(buf, n))) {
+            return rc;
+        }
+        for (i=0; i < n; i++) {
+            if (ORCM_SUCCESS != (rc = pack_name(buf, scheduler->queues[i]))) {
+                return rc;
+            }
+        }
+    }
+    /* the other clusters have nothing to do with this daemon */
+    if (ORCM_SUCCESS != (rc = pack_count(buf, 1))) {
+        return rc;
+    }
+    return pack_cluster(buf, cluster, row, rack, node);
+}
+
+/****    UNPACKING    ****/
+
+/* move the node as packed into one held by a cluster, row, rack
+ * or scheduler */
+static int unpack_node(opal_buffer_t *buf, orcm_node_t *node)
+{
+    orcm_node_t *tmp;
+    char **argv, *port;
+    int32_t n = 1;
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buf, &tmp, &n, ORCM_NODE))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    if (NULL != node->name) {
+        free(node->name);
+    }
+    node->name = tmp->name;
+    tmp->name = NULL;
+    node->daemon = tmp->daemon;
+    node->state = tmp->state;
+    node->scd_state = tmp->scd_state;
+    /* swap the config so the old one goes with tmp */
+    argv = node->config.mca_params;
+    node->config.mca_params = tmp->config.mca_params;
+    tmp->config.mca_params = argv;
+    argv = node->config.env;
+    node->config.env = tmp->config.env;
+    tmp->config.env = argv;
+    port = node->config.port;
+    node->config.port = tmp->config.port;
+    tmp->config.port = port;
+    node->config.aggregator = tmp->config.aggregator;
+    OBJ_RELEASE(tmp);
+    return ORCM_SUCCESS;
+}
+
+static int unpack_count(opal_buffer_t *buf, int32_t *num)
+{
+    int32_t n = 1;
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buf, num, &n, OPAL_INT32))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    if (0 > *num) {
+        ORTE_ERROR_LOG(ORCM_ERR_UNPACK_FAILURE);
+        return ORCM_ERR_UNPACK_FAILURE;
+    }
+    return ORCM_SUCCESS;
+}
+
+static int unpack_name(opal_buffer_t *buf, char **name)
+{
+    int32_t n = 1;
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buf, name, &n, OPAL_STRING))) {
+        ORTE_ERROR_LOG(rc);
+    }
+    return rc;
+}
+
+static int unpack_rack(opal_buffer_t *buf, orcm_row_t *row)
+{
+    orcm_rack_t *rack;
+    orcm_node_t *node;
+    int32_t i, num;
+    int rc;
+
+    rack = OBJ_NEW(orcm_rack_t);
+    OBJ_RETAIN(row);
+    rack->row = row;
+    opal_list_append(&row->racks, &rack->super);
+    if (ORCM_SUCCESS != (rc = unpack_name(buf, &rack->name)) ||
+        ORCM_SUCCESS != (rc = unpack_node(buf, &rack->controller)) ||
+        ORCM_SUCCESS != (rc = unpack_count(buf, &num))) {
+        return rc;
+    }
+    for (i=0; i < num; i++) {
+        node = OBJ_NEW(orcm_node_t);
+        OBJ_RETAIN(rack);
+        node->rack = (struct orcm_rack_t*)rack;
+        opal_list_append(&rack->nodes, &node->super);
+        if (ORCM_SUCCESS != (rc = unpack_node(buf, node))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+static int unpack_row(opal_buffer_t *buf, orcm_cluster_t *cluster)
+{
+    orcm_row_t *row;
+    int32_t i, num;
+    int rc;
+
+    row = OBJ_NEW(orcm_row_t);
+    OBJ_RETAIN(cluster);
+    row->cluster = cluster;
+    opal_list_append(&cluster->rows, &row->super);
+    if (ORCM_SUCCESS != (rc = unpack_name(buf, &row->name)) ||
+        ORCM_SUCCESS != (rc = unpack_node(buf, &row->controller)) ||
+        ORCM_SUCCESS != (rc = unpack_count(buf, &num))) {
+        return rc;
+    }
+    for (i=0; i < num; i++) {
+        if (ORCM_SUCCESS != (rc = unpack_rack(buf, row))) {
+            return rc;
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+int orcm_cfgi_base_tree_unpack(opal_buffer_t *buf, orte_vpid_t *num_procs)
+{
+    orcm_scheduler_t *scheduler;
+    orcm_cluster_t *cluster;
+    int32_t i, j, n, num, nqueues;
+    char *queue;
+    int rc;
+
+    n = 1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buf, num_procs, &n, ORTE_VPID))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    if (ORCM_SUCCESS != (rc = unpack_count(buf, &num))) {
+        return rc;
+    }
+    for (i=0; i < num; i++) {
+        scheduler = OBJ_NEW(orcm_scheduler_t);
+        opal_list_append(orcm_schedulers, &scheduler->super);
+        if (ORCM_SUCCESS != (rc = unpack_node(buf, &scheduler->controller)) ||
+            ORCM_SUCCESS != (rc = unpack_count(buf, &nqueues))) {
+            return rc;
+        }
+        for (j=0; j < nqueues; j++) {
+            if (ORCM_SUCCESS != (rc = unpack_name(buf, &queue))) {
+                return rc;
+            }
+            opal_argv_append_nosize(&scheduler->queues, queue);
+            free(queue);
+        }
+    }
+    if (ORCM_SUCCESS != (rc = unpack_count(buf, &num))) {
+        return rc;
+    }
+    for (i=0; i < num; i++) {
+        cluster = OBJ_NEW(orcm_cluster_t);
+        opal_list_append(orcm_clusters, &cluster->super);
+        if (ORCM_SUCCESS != (rc = unpack_name(buf, &cluster->name)) ||
+            ORCM_SUCCESS != (rc = unpack_node(buf, &cluster->controller)) ||
+            ORCM_SUCCESS != (rc = unpack_count(buf, &n))) {
+            return rc;
+        }
+        for (j=0; j < n; j++) {
+            if (ORCM_SUCCESS != (rc = unpack_row(buf, cluster))) {
+                return rc;
+            }
+        }
+    }
+    return ORCM_SUCCESS;
+}
+
+/****    SERVING    ****/
+
+static void conn_recv(int sd, short flags, void *cbdata);
+static void conn_send(int sd, short flags, void *cbdata);
+
+static int set_nonblocking(int sd)
+{
+    int flags;
+
+    if (0 > (flags = fcntl(sd, F_GETFL, 0)) ||
+        0 > fcntl(sd, F_SETFL, flags | O_NONBLOCK)) {
+        return ORCM_ERR_IN_ERRNO;
+    }
+    return ORCM_SUCCESS;
+}
+
+/* did the request come from the given host? */
+static bool from_host(orcm_cfgi_tree_conn_t *conn, char *host)
+{
+    struct hostent *h;
+    int i;
+
+    if (NULL == host || NULL == (h = gethostbyname(host)) || AF_INET != h->h_addrtype) {
+        return false;
+    }
+    for (i=0; NULL != h->h_addr_list[i]; i++) {
+        if (0 == memcmp(h->h_addr_list[i], &conn->addr.sin_addr, sizeof(conn->addr.sin_addr))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* answer a request - an empty reply when we don't know the host,
+ * or it is not where the request came from */
+static void reply(orcm_cfgi_tree_conn_t *conn)
+{
+    opal_buffer_t req, slice;
+    char *host = NULL, *ip = NULL, *data = NULL;
+    char peer[INET_ADDRSTRLEN];
+    int32_t n, len = 0;
+    uint32_t hdr;
+    int rc;
+
+    OBJ_CONSTRUCT(&req, opal_buffer_t);
+    OBJ_CONSTRUCT(&slice, opal_buffer_t);
+    opal_dss.load(&req, conn->data, conn->size);
+    conn->data = NULL;
+    n = 1;
+    if (OPAL_SUCCESS == (rc = opal_dss.unpack(&req, &host, &n, OPAL_STRING))) {
+        n = 1;
+        rc = opal_dss.unpack(&req, &ip, &n, OPAL_STRING);
+    }
+    if (OPAL_SUCCESS == rc) {
+        inet_ntop(AF_INET, &conn->addr.sin_addr, peer, sizeof(peer));
+        if (!orcm_cfgi_base.tree_check_peer) {
+            rc = orcm_cfgi_base_tree_pack(&slice, host, ip);
+        } else {
+            /* daemons known by address are known by the one they ask
+             * from, not the one they claim - and those known by name
+             * must ask from their host */
+            rc = orcm_cfgi_base_tree_pack(&slice, "", peer);
+            if (ORCM_ERR_NOT_FOUND == rc && from_host(conn, host)) {
+                rc = orcm_cfgi_base_tree_pack(&slice, host, peer);
+            }
+        }
+        opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                            "%s cfgi:tree: %s the system to %s at %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            (ORCM_SUCCESS == rc) ? "serving" : "no part of",
+                            (NULL == host) ? "NULL" : host, peer);
+        if (ORCM_SUCCESS == rc) {
+            opal_dss.unload(&slice, (void**)&data, &len);
+        }
+    }
+    OBJ_DESTRUCT(&req);
+    OBJ_DESTRUCT(&slice);
+    free(host);
+    free(ip);
+
+    /* the reply goes out with its length up front */
+    conn->size = sizeof(hdr) + len;
+    conn->pos = 0;
+    if (NULL == (conn->data = (char*)malloc(conn->size))) {
+        free(data);
+        OBJ_RELEASE(conn);
+        return;
+    }
+    hdr = htonl((uint32_t)len);
+    memcpy(conn->data, &hdr, sizeof(hdr));
+    if (0 < len) {
+        memcpy(conn->data + sizeof(hdr), data, len);
+    }
+    free(data);
+    opal_event_del(&conn->ev);
+    opal_event_set(orte_event_base, &conn->ev, conn->sd,
+                   OPAL_EV_WRITE|OPAL_EV_PERSIST, conn_send, conn);
+    opal_event_add(&conn->ev, 0);
+}
+
+static void conn_recv(int sd, short flags, void *cbdata)
+{
+    orcm_cfgi_tree_conn_t *conn = (orcm_cfgi_tree_conn_t*)cbdata;
+    ssize_t rc;
+
+    /* the length first, then the request */
+    while (NULL == conn->data) {
+        rc = read(sd, (char*)&conn->hdr + conn->pos, sizeof(conn->hdr) - conn->pos);
+        if (0 > rc && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)) {
+            return;
+        }
+        if (0 >= rc) {
+            OBJ_RELEASE(conn);
+            return;
+        }
+        conn->pos += rc;
+        if (conn->pos < sizeof(conn->hdr)) {
+            return;
+        }
+        conn->size = ntohl(conn->hdr);
+        conn->pos = 0;
+        if (0 == conn->size || ORCM_CFGI_TREE_MAX_MSG < conn->size ||
+            NULL == (conn->data = (char*)malloc(conn->size))) {
+            OBJ_RELEASE(conn);
+            return;
+        }
+    }
+    while (conn->pos < conn->size) {
+        rc = read(sd, conn->data + conn->pos, conn->size - conn->pos);
+        if (0 > rc && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)) {
+            return;
+        }
+        if (0 >= rc) {
+            OBJ_RELEASE(conn);
+            return;
+        }
+        conn->pos += rc;
+    }
+    reply(conn);
+}
+
+static void conn_send(int sd, short flags, void *cbdata)
+{
+    orcm_cfgi_tree_conn_t *conn = (orcm_cfgi_tree_conn_t*)cbdata;
+    ssize_t rc;
+
+    while (conn->pos < conn->size) {
+        rc = write(sd, conn->data + conn->pos, conn->size - conn->pos);
+        if (0 > rc && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)) {
+            return;
+        }
+        if (0 > rc) {
+            break;
+        }
+        conn->pos += rc;
+    }
+    /* done - the daemon closes its end once it has the reply */
+    OBJ_RELEASE(conn);
+}
+
+static void accept_conn(int sd, short flags, void *cbdata)
+{
+    orcm_cfgi_tree_conn_t *conn;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int csd;
+
+    for (;;) {
+        addrlen = sizeof(addr);
+        if (0 > (csd = accept(sd, (struct sockaddr*)&addr, &addrlen))) {
+            if (EINTR == errno) {
+                continue;
+            }
+            /* EAGAIN once the backlog is drained */
+            return;
+        }
+        if (ORCM_SUCCESS != set_nonblocking(csd)) {
+            close(csd);
+            continue;
+        }
+        conn = OBJ_NEW(orcm_cfgi_tree_conn_t);
+        conn->sd = csd;
+        conn->addr = addr;
+        opal_event_set(orte_event_base, &conn->ev, csd,
+                       OPAL_EV_READ|OPAL_EV_PERSIST, conn_recv, conn);
+        opal_event_add(&conn->ev, 0);
+    }
+}
+
+/* the address to serve on - the given interface or address,
+ * else that of our host */
+static int serve_addr(struct in_addr *addr)
+{
+    struct sockaddr_storage ifaddr;
+    struct hostent *h;
+    char *name = orcm_cfgi_base.tree_if;
+
+    if (NULL != name && '\0' != name[0]) {
+        if (OPAL_SUCCESS == opal_ifnametoaddr(name, (struct sockaddr*)&ifaddr, sizeof(ifaddr))) {
+            if (AF_INET != ifaddr.ss_family) {
+                return ORCM_ERR_NOT_SUPPORTED;
+            }
+            *addr = ((struct sockaddr_in*)&ifaddr)->sin_addr;
+            return ORCM_SUCCESS;
+        }
+    } else {
+        name = orte_process_info.nodename;
+    }
+    if (0 != inet_aton(name, addr)) {
+        return ORCM_SUCCESS;
+    }
+    if (NULL == (h = gethostbyname(name)) || AF_INET != h->h_addrtype) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    memcpy(addr, h->h_addr_list[0], sizeof(*addr));
+    return ORCM_SUCCESS;
+}
+
+int orcm_cfgi_base_tree_serve(void)
+{
+    struct sockaddr_in addr;
+    int flag = 1;
+    int rc;
+
+    if (0 >= orcm_cfgi_base.tree_port || 0 <= server.sd) {
+        /* not asked to, or already are */
+        return ORCM_SUCCESS;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    if (ORCM_SUCCESS != (rc = serve_addr(&addr.sin_addr))) {
+        opal_output(0, "%s cfgi:tree: cannot find the address of %s to serve the system on",
+                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                    (NULL != orcm_cfgi_base.tree_if && '\0' != orcm_cfgi_base.tree_if[0]) ?
+                    orcm_cfgi_base.tree_if : orte_process_info.nodename);
+        return rc;
+    }
+    if (0 > (server.sd = socket(AF_INET, SOCK_STREAM, 0))) {
+        ORTE_ERROR_LOG(ORCM_ERR_IN_ERRNO);
+        return ORCM_ERR_IN_ERRNO;
+    }
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(orcm_cfgi_base.tree_port);
+    if (0 > setsockopt(server.sd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag)) ||
+        0 > bind(server.sd, (struct sockaddr*)&addr, sizeof(addr)) ||
+        0 > listen(server.sd, SOMAXCONN) ||
+        ORCM_SUCCESS != set_nonblocking(server.sd)) {
+        opal_output(0, "%s cfgi:tree: cannot serve the system on port %d: %s",
+                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                    orcm_cfgi_base.tree_port, strerror(errno));
+        close(server.sd);
+        server.sd = -1;
+        return ORCM_ERR_IN_ERRNO;
+    }
+    opal_event_set(orte_event_base, &server.ev, server.sd,
+                   OPAL_EV_READ|OPAL_EV_PERSIST, accept_conn, NULL);
+    opal_event_add(&server.ev, 0);
+    opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                        "%s cfgi:tree: serving the system on %s:%d",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        inet_ntoa(addr.sin_addr), orcm_cfgi_base.tree_port);
+    return ORCM_SUCCESS;
+}
+
+void orcm_cfgi_base_tree_stop(void)
+{
+    if (0 <= server.sd) {
+        opal_event_del(&server.ev);
+        close(server.sd);
+        server.sd = -1;
+    }
+}
+
+/****    FETCHING    ****/
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int wait_for(int sd, short events, double deadline)
+{
+    struct pollfd pfd;
+    int ms, rc;
+
+    for (;;) {
+        if (0 >= (ms = (int)((deadline - now()) * 1000.0))) {
+            return ORCM_ERR_TIMEOUT;
+        }
+        pfd.fd = sd;
+        pfd.events = events;
+        pfd.revents = 0;
+        if (0 < (rc = poll(&pfd, 1, ms))) {
+            return ORCM_SUCCESS;
+        }
+        if (0 == rc) {
+            return ORCM_ERR_TIMEOUT;
+        }
+        if (EINTR != errno) {
+            return ORCM_ERR_COMM_FAILURE;
+        }
+    }
+}
+
+static int send_all(int sd, char *data, size_t len, double deadline)
+{
+    ssize_t n;
+    int rc;
+
+    while (0 < len) {
+        if (ORCM_SUCCESS != (rc = wait_for(sd, POLLOUT, deadline))) {
+            return rc;
+        }
+        if (0 > (n = write(sd, data, len))) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno) {
+                continue;
+            }
+            return ORCM_ERR_COMM_FAILURE;
+        }
+        data += n;
+        len -= n;
+    }
+    return ORCM_SUCCESS;
+}
+
+static int recv_all(int sd, char *data, size_t len, double deadline)
+{
+    ssize_t n;
+    int rc;
+
+    while (0 < len) {
+        if (ORCM_SUCCESS != (rc = wait_for(sd, POLLIN, deadline))) {
+            return rc;
+        }
+        if (0 > (n = read(sd, data, len))) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno) {
+                continue;
+            }
+            return ORCM_ERR_COMM_FAILURE;
+        }
+        if (0 == n) {
+            return ORCM_ERR_CONNECTION_FAILED;
+        }
+        data += n;
+        len -= n;
+    }
+    return ORCM_SUCCESS;
+}
+
+/* connect to host[:port] */
+static int connect_to(char *parent, double deadline, int *sd)
+{
+    struct sockaddr_in addr;
+    struct hostent *h;
+    char *host, *p;
+    int port, err, rc;
+    socklen_t errlen;
+
+    host = strdup(parent);
+    port = orcm_cfgi_base.tree_port;
+    if (NULL != (p = strrchr(host, ':'))) {
+        *p = '\0';
+        port = strtol(p + 1, NULL, 10);
+    }
+    if (0 >= port) {
+        free(host);
+        return ORCM_ERR_BAD_PARAM;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (0 == inet_aton(host, &addr.sin_addr)) {
+        if (NULL == (h = gethostbyname(host))) {
+            free(host);
+            return ORCM_ERR_NOT_FOUND;
+        }
+        memcpy(&addr.sin_addr, h->h_addr_list[0], sizeof(addr.sin_addr));
+    }
+    free(host);
+
+    if (0 > (*sd = socket(AF_INET, SOCK_STREAM, 0))) {
+        return ORCM_ERR_IN_ERRNO;
+    }
+    if (ORCM_SUCCESS != (rc = set_nonblocking(*sd))) {
+        goto fail;
+    }
+    if (0 > connect(*sd, (struct sockaddr*)&addr, sizeof(addr))) {
+        if (EINPROGRESS != errno) {
+            rc = ORCM_ERR_CONNECTION_REFUSED;
+            goto fail;
+        }
+        if (ORCM_SUCCESS != (rc = wait_for(*sd, POLLOUT, deadline))) {
+            goto fail;
+        }
+        errlen = sizeof(err);
+        if (0 > getsockopt(*sd, SOL_SOCKET, SO_ERROR, &err, &errlen) || 0 != err) {
+            rc = ORCM_ERR_CONNECTION_REFUSED;
+            goto fail;
+        }
+    }
+    return ORCM_SUCCESS;
+
+ fail:
+    close(*sd);
+    *sd = -1;
+    return rc;
+}
+
+int orcm_cfgi_base_tree_fetch(char *parent, char *host, char *ip,
+                              int timeout, opal_buffer_t *slice)
+{
+    opal_buffer_t req;
+    char *data = NULL;
+    int32_t len;
+    uint32_t hdr;
+    double deadline = now() + timeout;
+    int sd, rc;
+
+    if (ORCM_SUCCESS != (rc = connect_to(parent, deadline, &sd))) {
+        return rc;
+    }
+
+    OBJ_CONSTRUCT(&req, opal_buffer_t);
+    opal_dss.pack(&req, &host, 1, OPAL_STRING);
+    opal_dss.pack(&req, &ip, 1, OPAL_STRING);
+    opal_dss.unload(&req, (void**)&data, &len);
+    OBJ_DESTRUCT(&req);
+    hdr = htonl((uint32_t)len);
+    if (ORCM_SUCCESS != (rc = send_all(sd, (char*)&hdr, sizeof(hdr), deadline)) ||
+        ORCM_SUCCESS != (rc = send_all(sd, data, len, deadline))) {
+        goto done;
+    }
+    free(data);
+    data = NULL;
+
+    if (ORCM_SUCCESS != (rc = recv_all(sd, (char*)&hdr, sizeof(hdr), deadline))) {
+        goto done;
+    }
+    if (0 == (hdr = ntohl(hdr))) {
+        /* the parent holds no daemon on our host */
+        rc = ORCM_ERR_NOT_FOUND;
+        goto done;
+    }
+    if (ORCM_CFGI_TREE_MAX_MSG < hdr) {
+        rc = ORCM_ERR_COMM_FAILURE;
+        goto done;
+    }
+    if (NULL == (data = (char*)malloc(hdr))) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto done;
+    }
+    if (ORCM_SUCCESS != (rc = recv_all(sd, data, hdr, deadline))) {
+        goto done;
+    }
+    opal_dss.load(slice, data, hdr);
+    data = NULL;
+
+ done:
+    free(data);
+    close(sd);
+    return rc;
+}
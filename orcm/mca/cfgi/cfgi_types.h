@@ -65,6 +65,7 @@ typedef struct {
     orcm_config_t config;
     orcm_node_state_t state;         //writable *only* by rm after init
     orcm_scd_node_state_t scd_state; //writable *only* by scd after init
+    int32_t scd_index;               //position in the scd node pool
     uint32_t npes;  // number of processing elements
     /* system topology for this node */
 #if OPAL_HAVE_HWLOC
@@ -307,6 +307,11 @@ static int file30_init(void)
 
     int erri = ORCM_SUCCESS;
 
+    /* an up to date compiled copy of the config file was already checked */
+    if (ORCM_SUCCESS == orcm_cfgi_base_cache_open()) {
+        return ORCM_SUCCESS;
+    }
+
     while (ORCM_SUCCESS == erri){
         erri = xml_tree_create(&xml_syntax);
         if (ORCM_SUCCESS != erri) {
@@ -387,6 +392,8 @@ static void file30_finalize(void)
 static int parse_config(xml_tree_t * io_xtree, opal_list_t *io_config);
 static bool check_me(orcm_config_t *config, char *node,
                      orte_vpid_t vpid, char *my_ip);
+static bool cache_me(orcm_node_t **mynode, char *my_ip,
+                     orcm_scheduler_t *scheduler);
 
 static int read_config(opal_list_t *config)
 {
@@ -398,6 +405,12 @@ static int read_config(opal_list_t *config)
 
     int erri = ORCM_SUCCESS;
 
+    /* the system is defined from the compiled copy of the config file
+     * when it is up to date, leaving the config empty */
+    if (ORCM_SUCCESS == orcm_cfgi_base_cache_open()) {
+        return ORCM_SUCCESS;
+    }
+
     /*Check if the file exist*/     /*TODO: Use something more robust than fopen */
     fp = fopen(orcm_cfgi_base.config_file, "r");
     if (NULL == fp) {
@@ -511,6 +524,8 @@ static int define_system(opal_list_t *config,    orcm_node_t **mynode,
     opal_buffer_t uribuf, schedbuf, clusterbuf, rowbuf, rackbuf;
     opal_buffer_t *bptr;
     orcm_scheduler_t *scheduler;
+    opal_list_item_t *item;
+    bool cached = orcm_cfgi_base_cache_is_open();
 
     /* set default */
     *mynode = NULL;
@@ -528,6 +543,27 @@ static int define_system(opal_list_t *config,    orcm_node_t **mynode,
         }
     }
 
+    if (cached && ORCM_SUCCESS != (rc = orcm_cfgi_base_cache_load())) {
+        /* drop whatever the compiled copy gave and define the system
+         * from the site file itself */
+        opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                            "%s cfgi:file30 cannot load the compiled config (%s) - parsing %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), ORTE_ERROR_NAME(rc),
+                            orcm_cfgi_base.config_file);
+        while (NULL != (item = opal_list_remove_first(orcm_clusters))) {
+            OBJ_RELEASE(item);
+        }
+        while (NULL != (item = opal_list_remove_first(orcm_schedulers))) {
+            OBJ_RELEASE(item);
+        }
+        orcm_cfgi_base_cache_close();
+        orcm_cfgi_base.use_cache = false;
+        cached = false;
+        if (ORCM_SUCCESS != (rc = read_config(config))) {
+            return rc;
+        }
+    }
+
     OPAL_LIST_FOREACH(xx, config, orcm_cfgi_xml_parser_t) {
         if (0 == strcmp(xx->name, TXconfig)) {
             OPAL_LIST_FOREACH(x, &xx->subvals, orcm_cfgi_xml_parser_t) {
@@ -566,9 +602,10 @@ static int define_system(opal_list_t *config,    orcm_node_t **mynode,
         }
     }
 
-    /* track the vpids for the daemons */
+    /* track the vpids for the daemons - when the system comes from
+     * the compiled config, we look ourselves up once it is named */
     vpid = 0;
-    found_me = false;
+    found_me = cached;
 
     /* cycle thru the list of schedulers - they will take the leading positions
      * in the assignment of process names
@@ -593,6 +630,11 @@ static int define_system(opal_list_t *config,    orcm_node_t **mynode,
         }
         ++vpid;
     }
+    /* the scheduler is our HNP, if available */
+    scheduler = (orcm_scheduler_t*)opal_list_get_first(orcm_schedulers);
+    if (opal_list_get_end(orcm_schedulers) == &scheduler->super) {
+        scheduler = NULL;
+    }
     /* transfer the scheduler section to the cluster definition */
     OBJ_CONSTRUCT(&clusterbuf, opal_buffer_t);
     bptr = &schedbuf;
@@ -778,6 +820,10 @@ static int define_system(opal_list_t *config,    orcm_node_t **mynode,
         }
     }
 
+    if (cached) {
+        found_me = cache_me(mynode, my_ip, scheduler);
+    }
+
     if (20 < opal_output_get_verbosity(orcm_cfgi_base_framework.framework_output)) {
         OPAL_LIST_FOREACH(scheduler, orcm_schedulers, orcm_scheduler_t) {
             opal_dss.dump(0, scheduler, ORCM_SCHEDULER);
@@ -1440,6 +1486,67 @@ static bool check_me(orcm_config_t *config, char *node,
     return false;
 }
 
+/* the first daemon of a kind defined on our host in the compiled
+ * config, by name or by address as check_me would match it */
+static orcm_node_t* cache_find(bool sched, char *my_ip,
+                               orte_vpid_t *vpid, orte_vpid_t *parent)
+{
+    orcm_node_t *node, *ipnode = NULL;
+    orte_vpid_t ipvpid, ipparent;
+
+    node = orcm_cfgi_base_cache_lookup(orte_process_info.nodename, sched, vpid, parent);
+    if (NULL != node && opal_net_isaddr(node->name)) {
+        node = NULL;
+    }
+    if (0 != strcmp(my_ip, orte_process_info.nodename)) {
+        ipnode = orcm_cfgi_base_cache_lookup(my_ip, sched, &ipvpid, &ipparent);
+    }
+    if (NULL != ipnode && (NULL == node || ipvpid < *vpid)) {
+        node = ipnode;
+        *vpid = ipvpid;
+        *parent = ipparent;
+    }
+    return node;
+}
+
+static bool cache_me(orcm_node_t **mynode, char *my_ip,
+                     orcm_scheduler_t *scheduler)
+{
+    orcm_node_t *node = NULL;
+    orte_vpid_t vpid, parent;
+
+    if (ORTE_PROC_IS_SCHEDULER &&
+        NULL != (node = cache_find(true, my_ip, &vpid, &parent))) {
+        if (!check_me(&node->config, node->name, vpid, my_ip)) {
+            return false;
+        }
+        *mynode = node;
+        return true;
+    }
+    if (!ORTE_PROC_IS_DAEMON ||
+        NULL == (node = cache_find(false, my_ip, &vpid, &parent)) ||
+        !check_me(&node->config, node->name, vpid, my_ip)) {
+        return false;
+    }
+
+    *mynode = node;
+    OBJ_RETAIN(*mynode);
+    if (NULL != scheduler) {
+        /* define my HNP to be the scheduler, if available */
+        ORTE_PROC_MY_HNP->jobid = scheduler->controller.daemon.jobid;
+        ORTE_PROC_MY_HNP->vpid = scheduler->controller.daemon.vpid;
+    } else {
+        /* otherwise, it is just myself */
+        ORTE_PROC_MY_HNP->jobid = ORTE_PROC_MY_NAME->jobid;
+        ORTE_PROC_MY_HNP->vpid = ORTE_PROC_MY_NAME->vpid;
+    }
+    /* my DAEMON is the nearest controller above me, if any */
+    ORTE_PROC_MY_DAEMON->jobid = ORTE_PROC_MY_NAME->jobid;
+    ORTE_PROC_MY_DAEMON->vpid = (ORTE_VPID_INVALID == parent) ?
+                                ORTE_PROC_MY_NAME->vpid : parent;
+    return true;
+}
+
 
 static int parse_orcm_config(orcm_config_t *cfg,
                              orcm_cfgi_xml_parser_t *xml)
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2015      Intel, Inc.  All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
+#ifdef HAVE_NETDB_H
+#include <netdb.h>
+#endif
+#include <sys/time.h>
+
+#include "opal/dss/dss.h"
+#include "opal/util/argv.h"
+#include "opal/util/net.h"
+#include "opal/util/opal_environ.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+#include "orte/util/proc_info.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/util/utils.h"
+#include "orcm/mca/cfgi/base/base.h"
+#include "orcm/mca/cfgi/tree/cfgi_tree.h"
+
+/*
+ * Get our part of the system from the aggregators above us, which serve
+ * it from the site file they read or from what they got the same way, so
+ * that only the top-level aggregators and the scheduler need to read the
+ * site file. See cfgi_base_tree.c for what we get.
+ */
+
+/* API functions */
+
+static int tree_init(void);
+static void tree_finalize(void);
+static int read_config(opal_list_t *config);
+static int define_system(opal_list_t *config,
+                         orcm_node_t **mynode,
+                         orte_vpid_t *num_procs,
+                         opal_buffer_t *buf);
+
+/* The module struct */
+
+orcm_cfgi_base_module_t orcm_cfgi_tree_module = {
+    tree_init,
+    tree_finalize,
+    read_config,
+    define_system
+};
+
+/* our part of the system, once we got it */
+static opal_buffer_t *slice = NULL;
+
+static int tree_init(void)
+{
+    return ORCM_SUCCESS;
+}
+
+static void tree_finalize(void)
+{
+    if (NULL != slice) {
+        OBJ_RELEASE(slice);
+    }
+}
+
+/* our hostname in its IP form, the way check_me wants it */
+static char* get_my_ip(void)
+{
+    struct hostent *h;
+
+    if (opal_net_isaddr(orte_process_info.nodename) ||
+        NULL == (h = gethostbyname(orte_process_info.nodename))) {
+        return orte_process_info.nodename;
+    }
+    return inet_ntoa(*(struct in_addr*)h->h_addr_list[0]);
+}
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int read_config(opal_list_t *config)
+{
+    char **parents, *my_ip;
+    double deadline;
+    int i, rc, left;
+
+    if (NULL == mca_cfgi_tree_component.parents ||
+        '\0' == mca_cfgi_tree_component.parents[0]) {
+        /* we were not told where to get it */
+        return ORCM_ERR_TAKE_NEXT_OPTION;
+    }
+    if (NULL != slice) {
+        OBJ_RELEASE(slice);
+    }
+    my_ip = strdup(get_my_ip());
+    parents = opal_argv_split(mca_cfgi_tree_component.parents, ',');
+
+    /* the parents may still be starting, so keep asking them in
+     * turn until one gives us our part of the system */
+    deadline = now() + mca_cfgi_tree_component.timeout;
+    rc = ORCM_ERR_NOT_FOUND;
+    while (NULL == slice) {
+        for (i=0; NULL != parents[i]; i++) {
+            if (0 >= (left = (int)(deadline - now()))) {
+                break;
+            }
+            slice = OBJ_NEW(opal_buffer_t);
+            rc = orcm_cfgi_base_tree_fetch(parents[i], orte_process_info.nodename,
+                                           my_ip, (left < 10) ? left : 10, slice);
+            opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                                "cfgi:tree: asking %s for the system: %s",
+                                parents[i], ORTE_ERROR_NAME(rc));
+            if (ORCM_SUCCESS == rc) {
+                break;
+            }
+            OBJ_RELEASE(slice);
+        }
+        if (NULL != slice || now() >= deadline) {
+            break;
+        }
+        sleep(1);
+    }
+    opal_argv_free(parents);
+    free(my_ip);
+
+    if (NULL == slice) {
+        opal_output_verbose(1, orcm_cfgi_base_framework.framework_output,
+                            "cfgi:tree: no parent gave us the system - reading the config file");
+        return ORCM_ERR_TAKE_NEXT_OPTION;
+    }
+    return ORCM_SUCCESS;
+}
+
+static void setup_environ(char **env)
+{
+    char **tmp, *t;
+    int i;
+
+    if (NULL == env) {
+        return;
+    }
+
+    /* go thru the provided environment and *only* set
+     * envars that were not previously set. This allows
+     * users to override the config file on the cmd line
+     */
+    tmp = opal_environ_merge(env, environ);
+    if (NULL == tmp) {
+        return;
+    }
+
+    /* now cycle thru the result and push MCA params back into our
+     * environment. We will overwrite some existing values,
+     * but no harm done
+     */
+    for (i=0; NULL != tmp[i]; i++) {
+        if (0 == strncmp(tmp[i], OPAL_MCA_PREFIX, strlen(OPAL_MCA_PREFIX))) {
+            t = strdup(tmp[i]);
+            opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                                "PUSHING %s TO ENVIRON", t);
+            putenv(t);
+        }
+    }
+    opal_argv_free(tmp);
+}
+
+static bool check_me(orcm_node_t *node, char *my_ip)
+{
+    char *uri;
+
+    if (ORTE_NODE_STATE_UNDEF == node->state || NULL == node->name) {
+        return false;
+    }
+    if (opal_net_isaddr(node->name)) {
+        if (0 != strcmp(node->name, my_ip)) {
+            return false;
+        }
+    } else if (0 != strcmp(node->name, orte_process_info.nodename)) {
+        return false;
+    }
+
+    ORTE_PROC_MY_NAME->vpid = node->daemon.vpid;
+    setup_environ(node->config.mca_params);
+    if (node->config.aggregator) {
+        orte_process_info.proc_type = ORCM_AGGREGATOR;
+    }
+    /* load our port */
+    asprintf(&uri, OPAL_MCA_PREFIX"oob_tcp_static_ipv4_ports=%s", node->config.port);
+    putenv(uri);  // cannot free this value
+    opal_output_verbose(2, orcm_cfgi_base_framework.framework_output,
+                        "push our port %s", uri);
+    return true;
+}
+
+/* we are this node - the HNP is the scheduler, if available, and our
+ * daemon is the controller above us, if any */
+static void set_me(orcm_node_t *node, orcm_node_t *parent,
+                   orcm_scheduler_t *scheduler, orcm_node_t **mynode)
+{
+    *mynode = node;
+    OBJ_RETAIN(*mynode);
+    if (NULL != scheduler) {
+        ORTE_PROC_MY_HNP->jobid = scheduler->controller.daemon.jobid;
+        ORTE_PROC_MY_HNP->vpid = scheduler->controller.daemon.vpid;
+    } else {
+        ORTE_PROC_MY_HNP->jobid = ORTE_PROC_MY_NAME->jobid;
+        ORTE_PROC_MY_HNP->vpid = ORTE_PROC_MY_NAME->vpid;
+    }
+    if (NULL != parent) {
+        ORTE_PROC_MY_DAEMON->jobid = parent->daemon.jobid;
+        ORTE_PROC_MY_DAEMON->vpid = parent->daemon.vpid;
+    } else {
+        ORTE_PROC_MY_DAEMON->jobid = ORTE_PROC_MY_NAME->jobid;
+        ORTE_PROC_MY_DAEMON->vpid = ORTE_PROC_MY_NAME->vpid;
+    }
+}
+
+static bool defined(orcm_node_t *node)
+{
+    return (ORTE_NODE_STATE_UNDEF != node->state);
+}
+
+static int define_system(opal_list_t *config, orcm_node_t **mynode,
+                         orte_vpid_t *num_procs, opal_buffer_t *buf)
+{
+    orcm_scheduler_t *scheduler;
+    orcm_cluster_t *cluster;
+    orcm_row_t *row;
+    orcm_rack_t *rack;
+    orcm_node_t *node, *above;
+    opal_buffer_t uribuf, schedbuf, clusterbuf, rowbuf, rackbuf;
+    opal_buffer_t *bptr;
+    char *my_ip;
+    bool found_me = false;
+    int32_t num;
+    int rc;
+
+    if (NULL == slice) {
+        /* we read the config file instead */
+        return ORCM_ERR_TAKE_NEXT_OPTION;
+    }
+
+    /* set default */
+    *mynode = NULL;
+
+    rc = orcm_cfgi_base_tree_unpack(slice, num_procs);
+    OBJ_RELEASE(slice);
+    if (ORCM_SUCCESS != rc) {
+        return rc;
+    }
+    /* keep our own copy - constructing the URIs reuses inet_ntoa's */
+    my_ip = strdup(get_my_ip());
+
+    /* the daemons already carry the names they have across the system,
+     * so all that is left is to find ourselves and to describe our part
+     * of the system to the routed and rml as the site file readers do */
+    OBJ_CONSTRUCT(&schedbuf, opal_buffer_t);
+    OBJ_CONSTRUCT(&uribuf, opal_buffer_t);
+    OPAL_LIST_FOREACH(scheduler, orcm_schedulers, orcm_scheduler_t) {
+        opal_dss.pack(&schedbuf, &scheduler->controller.daemon, 1, ORTE_NAME);
+        orcm_util_construct_uri(&uribuf, &scheduler->controller);
+    }
+    scheduler = (orcm_scheduler_t*)opal_list_get_first(orcm_schedulers);
+    if (opal_list_get_end(orcm_schedulers) == &scheduler->super) {
+        scheduler = NULL;
+    }
+    OBJ_CONSTRUCT(&clusterbuf, opal_buffer_t);
+    bptr = &schedbuf;
+    opal_dss.pack(&clusterbuf, &bptr, 1, OPAL_BUFFER);
+    OBJ_DESTRUCT(&schedbuf);
+
+    OPAL_LIST_FOREACH(cluster, orcm_clusters, orcm_cluster_t) {
+        if (defined(&cluster->controller)) {
+            if (cluster->controller.config.aggregator) {
+                orcm_util_construct_uri(&uribuf, &cluster->controller);
+            }
+            if (!found_me && check_me(&cluster->controller, my_ip)) {
+                found_me = true;
+                set_me(&cluster->controller, NULL, scheduler, mynode);
+            }
+        }
+        opal_dss.pack(&clusterbuf, &cluster->controller.daemon, 1, ORTE_NAME);
+        num = opal_list_get_size(&cluster->rows);
+        opal_dss.pack(&clusterbuf, &num, 1, OPAL_INT32);
+        OPAL_LIST_FOREACH(row, &cluster->rows, orcm_row_t) {
+            OBJ_CONSTRUCT(&rowbuf, opal_buffer_t);
+            num = opal_list_get_size(&row->racks);
+            opal_dss.pack(&rowbuf, &num, 1, OPAL_INT32);
+            if (defined(&row->controller)) {
+                if (row->controller.config.aggregator) {
+                    orcm_util_construct_uri(&uribuf, &row->controller);
+                }
+                if (!found_me && check_me(&row->controller, my_ip)) {
+                    found_me = true;
+                    above = defined(&cluster->controller) ? &cluster->controller : NULL;
+                    set_me(&row->controller, above, scheduler, mynode);
+                }
+            }
+            opal_dss.pack(&rowbuf, &row->controller.daemon, 1, ORTE_NAME);
+            OPAL_LIST_FOREACH(rack, &row->racks, orcm_rack_t) {
+                OBJ_CONSTRUCT(&rackbuf, opal_buffer_t);
+                if (defined(&rack->controller)) {
+                    if (rack->controller.config.aggregator) {
+                        orcm_util_construct_uri(&uribuf, &rack->controller);
+                    }
+                    if (!found_me && check_me(&rack->controller, my_ip)) {
+                        found_me = true;
+                        above = defined(&row->controller) ? &row->controller :
+                                (defined(&cluster->controller) ? &cluster->controller : NULL);
+                        set_me(&rack->controller, above, scheduler, mynode);
+                    }
+                }
+                opal_dss.pack(&rackbuf, &rack->controller.daemon, 1, ORTE_NAME);
+                OPAL_LIST_FOREACH(node, &rack->nodes, orcm_node_t) {
+                    if (!found_me && check_me(node, my_ip)) {
+                        found_me = true;
+                        above = defined(&rack->controller) ? &rack->controller :
+                                (defined(&row->controller) ? &row->controller :
+                                 (defined(&cluster->controller) ? &cluster->controller : NULL));
+                        set_me(node, above, scheduler, mynode);
+                    }
+                    opal_dss.pack(&rackbuf, &node->daemon, 1, ORTE_NAME);
+                }
+                bptr = &rackbuf;
+                opal_dss.pack(&rowbuf, &bptr, 1, OPAL_BUFFER);
+                OBJ_DESTRUCT(&rackbuf);
+            }
+            bptr = &rowbuf;
+            opal_dss.pack(&clusterbuf, &bptr, 1, OPAL_BUFFER);
+            OBJ_DESTRUCT(&rowbuf);
+        }
+    }
+
+    if (20 < opal_output_get_verbosity(orcm_cfgi_base_framework.framework_output)) {
+        OPAL_LIST_FOREACH(scheduler, orcm_schedulers, orcm_scheduler_t) {
+            opal_dss.dump(0, scheduler, ORCM_SCHEDULER);
+        }
+        OPAL_LIST_FOREACH(cluster, orcm_clusters, orcm_cluster_t) {
+            opal_dss.dump(0, cluster, ORCM_CLUSTER);
+        }
+    }
+
+    /* provide the cluster definition first */
+    bptr = &clusterbuf;
+    opal_dss.pack(buf, &bptr, 1, OPAL_BUFFER);
+    /* now add the URIs */
+    bptr = &uribuf;
+    opal_dss.pack(buf, &bptr, 1, OPAL_BUFFER);
+    /* cleanup */
+    OBJ_DESTRUCT(&uribuf);
+    OBJ_DESTRUCT(&clusterbuf);
+    free(my_ip);
+
+    if (!found_me) {
+        /* whoever served us got the wrong daemon */
+        opal_output(0, "cfgi:tree: %s is not in the part of the system we were given",
+                    orte_process_info.nodename);
+        return ORCM_ERR_NOT_FOUND;
+    }
+    return ORCM_SUCCESS;
+}
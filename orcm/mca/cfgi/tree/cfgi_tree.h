@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2015      Intel, Inc.  All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#ifndef CFGI_TREE_H
+#define CFGI_TREE_H
+
+#include "orcm/mca/cfgi/cfgi.h"
+
+BEGIN_C_DECLS
+
+typedef struct {
+    orcm_cfgi_base_component_t super;
+    char *parents;
+    int timeout;
+} orcm_cfgi_tree_component_t;
+
+ORCM_DECLSPEC extern orcm_cfgi_tree_component_t mca_cfgi_tree_component;
+ORCM_DECLSPEC extern orcm_cfgi_base_module_t orcm_cfgi_tree_module;
+
+END_C_DECLS
+
+#endif /* CFGI_TREE_H */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2015      Intel, Inc.  All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include "opal/util/output.h"
+#include "opal/mca/base/mca_base_var.h"
+
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/cfgi/cfgi.h"
+#include "orcm/mca/cfgi/tree/cfgi_tree.h"
+
+static int component_register(void);
+static int component_open(void);
+static int component_close(void);
+static int component_query(mca_base_module_t **module, int *priority);
+
+orcm_cfgi_tree_component_t mca_cfgi_tree_component = {
+    {
+        {
+            ORCM_CFGI_BASE_VERSION_1_0_0,
+            /* Component name and version */
+            .mca_component_name = "tree",
+            MCA_BASE_MAKE_VERSION(component, ORCM_MAJOR_VERSION, ORCM_MINOR_VERSION,
+                                  ORCM_RELEASE_VERSION),
+
+            /* Component open and close functions */
+            .mca_open_component = component_open,
+            .mca_close_component = component_close,
+            .mca_query_component = component_query,
+            .mca_register_component_params = component_register
+        },
+        .base_data = {
+            /* The component is checkpoint ready */
+            MCA_BASE_METADATA_PARAM_CHECKPOINT
+        },
+    }
+};
+
+static int component_register(void)
+{
+    mca_base_component_t *c = &mca_cfgi_tree_component.super.base_version;
+
+    mca_cfgi_tree_component.parents = NULL;
+    (void) mca_base_component_var_register(c, "parents",
+                                           "Comma-delimited list of host[:port] of the daemons to ask, in order, for our part of the system instead of reading the config file - typically our rack and row controllers and the master [default: read the config file]",
+                                           MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_cfgi_tree_component.parents);
+
+    mca_cfgi_tree_component.timeout = 60;
+    (void) mca_base_component_var_register(c, "timeout",
+                                           "How long to keep asking the parents while they start up before falling back to the config file, in seconds [default: 60]",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_cfgi_tree_component.timeout);
+    return ORCM_SUCCESS;
+}
+
+static int component_open(void)
+{
+     return ORCM_SUCCESS;
+}
+
+static int component_close(void)
+{
+    return ORCM_SUCCESS;
+}
+
+static int component_query(mca_base_module_t **module, int *priority)
+{
+    /* only daemons get their part of the system from above */
+    if (!ORTE_PROC_IS_DAEMON) {
+        *module = NULL;
+        *priority = 0;
+        return ORCM_ERROR;
+    }
+    /* ahead of the config file readers */
+    *module = (mca_base_module_t*)&orcm_cfgi_tree_module;
+    *priority = 50;
+    return ORCM_SUCCESS;
+}
@@ -26,6 +26,7 @@
 #include "opal/class/opal_pointer_array.h"
 #include "opal/class/opal_bitmap.h"
 #include "opal/dss/dss.h"
+#include "opal/threads/mutex.h"
 
 #include "orcm/mca/db/db.h"
 
@@ -38,11 +39,22 @@ ORCM_DECLSPEC extern mca_base_framework_t orcm_db_base_framework;
  */
 ORCM_DECLSPEC int orcm_db_base_select(void);
 
+/* number of values in orcm_db_data_type_t */
+#define ORCM_DB_NUM_DATA_TYPES (ORCM_DB_EVENT_DATA + 1)
+
 typedef struct {
     opal_list_t actives;
+    /* the handles are looked up by the callers and released by the
+     * workers, so they are only touched under the lock */
+    opal_mutex_t lock;
     opal_pointer_array_t handles;
     opal_event_base_t *ev_base;
     bool ev_base_active;
+    int num_workers;
+    opal_event_base_t **worker_bases;
+    int batch_size;
+    int batch_timeout;
+    int batch_queue_limit;
 } orcm_db_base_t;
 
 typedef struct {
@@ -51,11 +63,14 @@ typedef struct {
 } orcm_db_base_active_component_t;
 OBJ_CLASS_DECLARATION(orcm_db_base_active_component_t);
 
-typedef struct {
+typedef struct orcm_db_request_t {
     opal_object_t super;
     opal_event_t ev;
 
     int dbhandle;
+    /* held until the request is released, so that a close processed
+     * meanwhile cannot free it under the worker */
+    struct orcm_db_handle_t *hdl;
     orcm_db_data_type_t data_type;
     opal_list_t *input;
     opal_list_t *output;
@@ -78,13 +93,93 @@ typedef struct {
    const char *test_result;
 
     opal_list_t *kvs;
+
+    opal_list_t **inputs;
+    size_t num_inputs;
+
+    /* the handle worker processing this request. Requests that must be
+     * processed by every worker of the handle are split in one request
+     * per worker pointing to the original one, which tracks how many
+     * are still pending and their combined status */
+    int worker;
+    struct orcm_db_request_t *parent;
+    volatile int32_t pending;
+    int status;
 } orcm_db_request_t;
 OBJ_CLASS_DECLARATION(orcm_db_request_t);
 
+/* Statistics kept for each batch queue */
+typedef struct {
+    size_t depth;                   /* requests currently queued */
+    size_t max_depth;               /* high watermark of depth */
+    uint64_t enqueued;              /* requests accepted into the queue */
+    uint64_t dropped;               /* requests rejected because it was full */
+    uint64_t flushes;               /* batches passed to the module */
+    uint64_t flushed;               /* requests passed to the module */
+    double last_flush_latency;      /* secs from oldest enqueue to flush end */
+    double max_flush_latency;
+    double total_flush_latency;
+} orcm_db_batch_stats_t;
+
+typedef struct {
+    opal_list_t *input;
+    orcm_db_callback_fn_t cbfunc;
+    void *cbdata;
+    struct timeval queued;
+    int status;
+} orcm_db_batch_entry_t;
+
+/*
+ * Bounded ring of store_new requests waiting to be passed to a module as a
+ * single batch. There is one per dbhandle and data type, and it is only
+ * ever touched from the db event base.
+ */
 typedef struct {
     opal_object_t super;
-    orcm_db_base_component_t *component;
+    int dbhandle;
+    orcm_db_data_type_t data_type;
     orcm_db_base_module_t *module;
+    orcm_db_batch_entry_t *ring;
+    opal_list_t **inputs;
+    int *status;                    /* of each request of the last flush */
+    size_t size;
+    size_t head;
+    size_t count;
+    opal_event_t timer;
+    bool timer_active;
+    opal_event_t flush_ev;
+    bool flush_pending;
+    orcm_db_batch_stats_t stats;
+} orcm_db_batch_queue_t;
+OBJ_CLASS_DECLARATION(orcm_db_batch_queue_t);
+
+/*
+ * A db handle is served by one or more workers. Each worker owns its own
+ * module instance - and thus its own backend connection - and processes
+ * its requests on its own event base, so that a slow operation on one
+ * connection doesn't hold up the others. Requests carrying a hostname are
+ * always given to the same worker to preserve per-node ordering.
+ *
+ * A handle with more than one worker (see db_base_num_workers, off by
+ * default) only suits storing data:
+ *  - fetch and remove go to the first worker, so they may not see data
+ *    just stored through another worker's connection
+ *  - commit and rollback are passed to each connection in turn and so
+ *    are not atomic across the handle
+ *  - callbacks are executed by the worker threads and may thus run
+ *    concurrently
+ */
+typedef struct {
+    orcm_db_base_module_t *module;
+    opal_event_base_t *ev_base;
+    orcm_db_batch_queue_t *batches[ORCM_DB_NUM_DATA_TYPES];
+} orcm_db_worker_t;
+
+typedef struct orcm_db_handle_t {
+    opal_object_t super;
+    orcm_db_base_component_t *component;
+    int num_workers;
+    orcm_db_worker_t *workers;
 } orcm_db_handle_t;
 OBJ_CLASS_DECLARATION(orcm_db_handle_t);
 
@@ -106,6 +201,9 @@ typedef struct {
 
 ORCM_DECLSPEC extern orcm_db_base_t orcm_db_base;
 
+/* the handle, retained for the caller - or NULL if there is none */
+ORCM_DECLSPEC orcm_db_handle_t* orcm_db_base_get_handle(int dbhandle);
+
 ORCM_DECLSPEC void orcm_db_base_open(char *name,
                                      opal_list_t *properties,
                                      orcm_db_callback_fn_t cbfunc,
@@ -124,6 +222,12 @@ ORCM_DECLSPEC void orcm_db_base_store_new(int dbhandle,
                                           opal_list_t *ret,
                                           orcm_db_callback_fn_t cbfunc,
                                           void *cbdata);
+ORCM_DECLSPEC void orcm_db_base_store_batch(int dbhandle,
+                                            orcm_db_data_type_t data_type,
+                                            opal_list_t **inputs,
+                                            size_t num_inputs,
+                                            orcm_db_callback_fn_t cbfunc,
+                                            void *cbdata);
 ORCM_DECLSPEC void orcm_db_base_record_data_samples(
         int dbhandle,
         const char *hostname,
@@ -167,6 +271,28 @@ ORCM_DECLSPEC void orcm_db_base_remove_data(int dbhandle,
                                             orcm_db_callback_fn_t cbfunc,
                                             void *cbdata);
 
+/* batching support */
+ORCM_DECLSPEC void orcm_db_base_batch_enqueue(orcm_db_worker_t *wkr,
+                                              orcm_db_request_t *req);
+ORCM_DECLSPEC void orcm_db_base_batch_flush(orcm_db_batch_queue_t *q);
+ORCM_DECLSPEC void orcm_db_base_batch_flush_all(orcm_db_worker_t *wkr);
+/* store a batch of data sets through a module, giving the status of
+ * each in rcs (if not NULL) - returns the first error, if any */
+ORCM_DECLSPEC int orcm_db_base_batch_store(orcm_db_base_module_t *module,
+                                           orcm_db_data_type_t data_type,
+                                           opal_list_t **inputs,
+                                           size_t num_inputs,
+                                           int *rcs);
+
+/*
+ * Retrieve the statistics of the batch queues of the given handle and data
+ * type, summed across the workers of the handle. The values are only
+ * guaranteed to be consistent when the handle is idle.
+ */
+ORCM_DECLSPEC int orcm_db_base_get_batch_stats(int dbhandle,
+                                               orcm_db_data_type_t data_type,
+                                               orcm_db_batch_stats_t *stats);
+
 ORCM_DECLSPEC int opal_value_to_orcm_db_item(const opal_value_t *kv,
                                              orcm_db_item_t *item);
 ORCM_DECLSPEC int find_items(const char *keys[],
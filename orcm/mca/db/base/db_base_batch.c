@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+#include "opal_stdint.h"
+#include "opal/mca/event/event.h"
+#include "opal/util/output.h"
+
+#include "orcm/mca/db/base/base.h"
+
+/*
+ * Write-behind batching of store_new requests
+ *
+ * When batching is enabled, store_new requests without an output list are
+ * not passed to the module as they arrive. Instead they are queued in a
+ * bounded ring per handle worker and data type, and the whole ring is passed
+ * to the module when it reaches db_base_batch_size entries, when the oldest
+ * entry has been waiting for db_base_batch_timeout msecs, or when the
+ * handle is committed or closed. Requests arriving while the ring is full
+ * are dropped and their callback is given ORCM_ERR_OUT_OF_RESOURCE.
+ *
+ * The size-triggered flush is run at a lower priority than the store
+ * requests themselves so that requests already waiting on the event base
+ * are coalesced into the same batch.
+ */
+
+static void batch_flush_cb(int fd, short args, void *cbdata)
+{
+    orcm_db_batch_queue_t *q = (orcm_db_batch_queue_t*)cbdata;
+
+    q->flush_pending = false;
+    orcm_db_base_batch_flush(q);
+}
+
+static orcm_db_batch_queue_t *get_queue(orcm_db_worker_t *wkr,
+                                        int dbhandle,
+                                        orcm_db_data_type_t data_type)
+{
+    orcm_db_batch_queue_t *q;
+
+    if (NULL != (q = wkr->batches[data_type])) {
+        return q;
+    }
+
+    q = OBJ_NEW(orcm_db_batch_queue_t);
+    q->size = (size_t)orcm_db_base.batch_queue_limit;
+    q->ring = (orcm_db_batch_entry_t*)calloc(q->size,
+                                             sizeof(orcm_db_batch_entry_t));
+    q->inputs = (opal_list_t**)calloc(q->size, sizeof(opal_list_t*));
+    q->status = (int*)calloc(q->size, sizeof(int));
+    if (NULL == q->ring || NULL == q->inputs || NULL == q->status) {
+        OBJ_RELEASE(q);
+        return NULL;
+    }
+    q->dbhandle = dbhandle;
+    q->data_type = data_type;
+    q->module = wkr->module;
+    opal_event_evtimer_set(wkr->ev_base, &q->timer,
+                           batch_flush_cb, q);
+    opal_event_set(wkr->ev_base, &q->flush_ev, -1,
+                   OPAL_EV_WRITE, batch_flush_cb, q);
+    opal_event_set_priority(&q->flush_ev, OPAL_EV_SYS_LO_PRI);
+
+    wkr->batches[data_type] = q;
+
+    return q;
+}
+
+void orcm_db_base_batch_enqueue(orcm_db_worker_t *wkr,
+                                orcm_db_request_t *req)
+{
+    orcm_db_batch_queue_t *q;
+    orcm_db_batch_entry_t *entry;
+    struct timeval tv;
+
+    if (NULL == (q = get_queue(wkr, req->dbhandle, req->data_type))) {
+        if (NULL != req->cbfunc) {
+            req->cbfunc(req->dbhandle, ORCM_ERR_OUT_OF_RESOURCE,
+                        req->input, NULL, req->cbdata);
+        }
+        return;
+    }
+
+    if (q->count == q->size) {
+        q->stats.dropped++;
+        opal_output_verbose(1, orcm_db_base_framework.framework_output,
+                            "db:base: batch queue for handle %d is full - "
+                            "dropping data (%" PRIu64 " dropped so far)",
+                            q->dbhandle, q->stats.dropped);
+        if (NULL != req->cbfunc) {
+            req->cbfunc(req->dbhandle, ORCM_ERR_OUT_OF_RESOURCE,
+                        req->input, NULL, req->cbdata);
+        }
+        return;
+    }
+
+    entry = &q->ring[(q->head + q->count) % q->size];
+    entry->input = req->input;
+    entry->cbfunc = req->cbfunc;
+    entry->cbdata = req->cbdata;
+    gettimeofday(&entry->queued, NULL);
+    q->count++;
+
+    q->stats.enqueued++;
+    q->stats.depth = q->count;
+    if (q->count > q->stats.max_depth) {
+        q->stats.max_depth = q->count;
+    }
+
+    /* start the clock on the first request of a batch */
+    if (!q->timer_active) {
+        tv.tv_sec = orcm_db_base.batch_timeout / 1000;
+        tv.tv_usec = (orcm_db_base.batch_timeout % 1000) * 1000;
+        opal_event_evtimer_add(&q->timer, &tv);
+        q->timer_active = true;
+    }
+
+    if (q->count >= (size_t)orcm_db_base.batch_size && !q->flush_pending) {
+        q->flush_pending = true;
+        opal_event_active(&q->flush_ev, OPAL_EV_WRITE, 1);
+    }
+}
+
+void orcm_db_base_batch_flush(orcm_db_batch_queue_t *q)
+{
+    orcm_db_batch_entry_t *entry;
+    struct timeval oldest, now;
+    double latency;
+    size_t i, n, head;
+    int rc = ORCM_SUCCESS;
+
+    if (q->timer_active) {
+        opal_event_evtimer_del(&q->timer);
+        q->timer_active = false;
+    }
+
+    if (0 == q->count) {
+        return;
+    }
+
+    /* take the whole ring */
+    n = q->count;
+    head = q->head;
+    for (i=0; i < n; i++) {
+        q->inputs[i] = q->ring[(head + i) % q->size].input;
+    }
+    oldest = q->ring[head].queued;
+    q->head = (head + n) % q->size;
+    q->count = 0;
+    q->stats.depth = 0;
+
+    rc = orcm_db_base_batch_store(q->module, q->data_type, q->inputs, n,
+                                  q->status);
+    for (i=0; i < n; i++) {
+        entry = &q->ring[(head + i) % q->size];
+        if (NULL != entry->cbfunc) {
+            entry->cbfunc(q->dbhandle, q->status[i], entry->input, NULL,
+                          entry->cbdata);
+        }
+    }
+
+    gettimeofday(&now, NULL);
+    latency = (double)(now.tv_sec - oldest.tv_sec) +
+              (double)(now.tv_usec - oldest.tv_usec) / 1000000.0;
+    q->stats.flushes++;
+    q->stats.flushed += n;
+    q->stats.last_flush_latency = latency;
+    q->stats.total_flush_latency += latency;
+    if (latency > q->stats.max_flush_latency) {
+        q->stats.max_flush_latency = latency;
+    }
+
+    opal_output_verbose(5, orcm_db_base_framework.framework_output,
+                        "db:base: flushed batch of %lu requests for handle %d "
+                        "in %g secs (status %d)",
+                        (unsigned long)n, q->dbhandle, latency, rc);
+}
+
+int orcm_db_base_batch_store(orcm_db_base_module_t *module,
+                             orcm_db_data_type_t data_type,
+                             opal_list_t **inputs,
+                             size_t num_inputs,
+                             int *rcs)
+{
+    size_t i;
+    int rc, ret;
+
+    if (NULL != module->store_batch) {
+        rc = module->store_batch((struct orcm_db_base_module_t*)module,
+                                 data_type, inputs, num_inputs);
+        /* a single data set has nowhere else to go without store_new */
+        if (ORCM_SUCCESS == rc || (1 == num_inputs && NULL == module->store_new)) {
+            for (i=0; NULL != rcs && i < num_inputs; i++) {
+                rcs[i] = rc;
+            }
+            return rc;
+        }
+        /* nothing of the batch was stored, or the module cannot take
+         * this data as a batch - store the data sets one at a time so
+         * the bad ones only fail themselves */
+        opal_output_verbose(2, orcm_db_base_framework.framework_output,
+                            "db:base: batch of %lu data sets failed (status %d) - "
+                            "storing them one at a time",
+                            (unsigned long)num_inputs, rc);
+    }
+
+    rc = ORCM_SUCCESS;
+    for (i=0; i < num_inputs; i++) {
+        if (NULL != module->store_new) {
+            ret = module->store_new((struct orcm_db_base_module_t*)module,
+                                    data_type, inputs[i], NULL);
+        } else if (NULL != module->store_batch) {
+            ret = module->store_batch((struct orcm_db_base_module_t*)module,
+                                      data_type, &inputs[i], 1);
+        } else {
+            ret = ORCM_ERR_NOT_IMPLEMENTED;
+        }
+        if (NULL != rcs) {
+            rcs[i] = ret;
+        }
+        if (ORCM_SUCCESS == rc) {
+            rc = ret;
+        }
+    }
+    return rc;
+}
+
+void orcm_db_base_batch_flush_all(orcm_db_worker_t *wkr)
+{
+    int i;
+
+    for (i=0; i < ORCM_DB_NUM_DATA_TYPES; i++) {
+        if (NULL != wkr->batches[i]) {
+            orcm_db_base_batch_flush(wkr->batches[i]);
+        }
+    }
+}
+
+int orcm_db_base_get_batch_stats(int dbhandle,
+                                 orcm_db_data_type_t data_type,
+                                 orcm_db_batch_stats_t *stats)
+{
+    orcm_db_handle_t *hdl;
+    orcm_db_batch_stats_t *qs;
+    int i;
+
+    if (data_type < 0 || data_type >= ORCM_DB_NUM_DATA_TYPES) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (NULL == (hdl = orcm_db_base_get_handle(dbhandle))) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+
+    memset(stats, 0, sizeof(orcm_db_batch_stats_t));
+    for (i=0; i < hdl->num_workers; i++) {
+        if (NULL == hdl->workers[i].batches[data_type]) {
+            continue;
+        }
+        qs = &hdl->workers[i].batches[data_type]->stats;
+        stats->depth += qs->depth;
+        stats->enqueued += qs->enqueued;
+        stats->dropped += qs->dropped;
+        stats->flushes += qs->flushes;
+        stats->flushed += qs->flushed;
+        stats->total_flush_latency += qs->total_flush_latency;
+        if (qs->max_depth > stats->max_depth) {
+            stats->max_depth = qs->max_depth;
+        }
+        if (qs->max_flush_latency > stats->max_flush_latency) {
+            stats->max_flush_latency = qs->max_flush_latency;
+        }
+        if (qs->last_flush_latency > stats->last_flush_latency) {
+            stats->last_flush_latency = qs->last_flush_latency;
+        }
+    }
+    OBJ_RELEASE(hdl);
+
+    return ORCM_SUCCESS;
+}
+
+static void bq_con(orcm_db_batch_queue_t *p)
+{
+    p->dbhandle = -1;
+    p->module = NULL;
+    p->ring = NULL;
+    p->inputs = NULL;
+    p->status = NULL;
+    p->size = 0;
+    p->head = 0;
+    p->count = 0;
+    p->timer_active = false;
+    p->flush_pending = false;
+    memset(&p->stats, 0, sizeof(p->stats));
+}
+static void bq_des(orcm_db_batch_queue_t *p)
+{
+    if (NULL != p->ring) {
+        if (p->timer_active) {
+            opal_event_evtimer_del(&p->timer);
+        }
+        if (p->flush_pending) {
+            opal_event_del(&p->flush_ev);
+        }
+        free(p->ring);
+    }
+    if (NULL != p->inputs) {
+        free(p->inputs);
+    }
+    if (NULL != p->status) {
+        free(p->status);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_db_batch_queue_t,
+                   opal_object_t,
+                   bq_con, bq_des);
@@ -37,6 +37,7 @@ orcm_db_API_module_t orcm_db = {
     orcm_db_base_close,
     orcm_db_base_store,
     orcm_db_base_store_new,
+    orcm_db_base_store_batch,
     orcm_db_base_record_data_samples,
     orcm_db_base_update_node_features,
     orcm_db_base_record_diag_test,
@@ -58,6 +59,59 @@ static int orcm_db_base_register(mca_base_register_flag_t flags)
                           OPAL_INFO_LVL_9,
                           MCA_BASE_VAR_SCOPE_READONLY,
                           &orcm_db_base_create_evbase);
+
+    orcm_db_base.num_workers = 1;
+    mca_base_var_register("orcm", "db", "base", "num_workers",
+                          "Max number of worker threads serving a db handle, "
+                          "each with its own connection to the database "
+                          "(requires db_base_create_evbase). Only for handles "
+                          "used to store data: with more than one worker, "
+                          "fetches may miss data stored through another "
+                          "worker, commit/rollback are not atomic and "
+                          "callbacks may run concurrently",
+                          MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                          OPAL_INFO_LVL_9,
+                          MCA_BASE_VAR_SCOPE_READONLY,
+                          &orcm_db_base.num_workers);
+    if (orcm_db_base.num_workers < 1) {
+        orcm_db_base.num_workers = 1;
+    }
+
+    orcm_db_base.batch_size = 0;
+    mca_base_var_register("orcm", "db", "base", "batch_size",
+                          "Number of store requests to coalesce per db handle "
+                          "and data type before passing them to the db "
+                          "component as a single batch (0: no batching)",
+                          MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                          OPAL_INFO_LVL_9,
+                          MCA_BASE_VAR_SCOPE_READONLY,
+                          &orcm_db_base.batch_size);
+
+    orcm_db_base.batch_timeout = 1000;
+    mca_base_var_register("orcm", "db", "base", "batch_timeout",
+                          "Max time (in msecs) a store request can be queued "
+                          "before its batch is passed to the db component",
+                          MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                          OPAL_INFO_LVL_9,
+                          MCA_BASE_VAR_SCOPE_READONLY,
+                          &orcm_db_base.batch_timeout);
+
+    orcm_db_base.batch_queue_limit = 8192;
+    mca_base_var_register("orcm", "db", "base", "batch_queue_limit",
+                          "Max number of store requests queued per db handle "
+                          "and data type - requests beyond this limit are "
+                          "dropped",
+                          MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                          OPAL_INFO_LVL_9,
+                          MCA_BASE_VAR_SCOPE_READONLY,
+                          &orcm_db_base.batch_queue_limit);
+    if (orcm_db_base.batch_queue_limit < orcm_db_base.batch_size) {
+        orcm_db_base.batch_queue_limit = orcm_db_base.batch_size;
+    }
+    if (orcm_db_base.batch_timeout < 0) {
+        orcm_db_base.batch_timeout = 0;
+    }
+
     return ORCM_SUCCESS;
 }
 
@@ -66,15 +120,38 @@ static int orcm_db_base_frame_close(void)
     orcm_db_base_active_component_t *active;
     int i;
     orcm_db_handle_t *hdl;
+    char *name;
+    int j;
 
-    /* cleanup the globals */
+    /* stop the workers before touching their batches - their event
+     * bases stay around until the handles are gone */
+    if (orcm_db_base_create_evbase && orcm_db_base.ev_base_active) {
+        for (i=1; i < orcm_db_base.num_workers; i++) {
+            if (NULL != orcm_db_base.worker_bases[i]) {
+                asprintf(&name, "db%d", i);
+                opal_progress_thread_pause(name);
+                free(name);
+            }
+        }
+        opal_progress_thread_pause("db");
+    }
+
+    /* cleanup the globals - the workers are stopped, so nobody
+     * else can get at the handles */
     for (i=0; i < orcm_db_base.handles.size; i++) {
         if (NULL != (hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles, i))) {
+            /* don't lose any data still waiting to be stored */
+            for (j=0; j < hdl->num_workers; j++) {
+                if (NULL != hdl->workers[j].module) {
+                    orcm_db_base_batch_flush_all(&hdl->workers[j]);
+                }
+            }
             opal_pointer_array_set_item(&orcm_db_base.handles, i, NULL);
             OBJ_RELEASE(hdl);
         }
     }
     OBJ_DESTRUCT(&orcm_db_base.handles);
+    OBJ_DESTRUCT(&orcm_db_base.lock);
 
     /* cycle across all the active db components and let them cleanup - order
      * doesn't matter in this case
@@ -88,15 +165,30 @@ static int orcm_db_base_frame_close(void)
 
     if (orcm_db_base_create_evbase && orcm_db_base.ev_base_active) {
         orcm_db_base.ev_base_active = false;
+        for (i=1; i < orcm_db_base.num_workers; i++) {
+            if (NULL != orcm_db_base.worker_bases[i]) {
+                asprintf(&name, "db%d", i);
+                opal_progress_thread_finalize(name);
+                free(name);
+            }
+        }
         opal_progress_thread_finalize("db");
     }
+    if (NULL != orcm_db_base.worker_bases) {
+        free(orcm_db_base.worker_bases);
+        orcm_db_base.worker_bases = NULL;
+    }
 
     return mca_base_framework_components_close(&orcm_db_base_framework, NULL);
 }
 
 static int orcm_db_base_frame_open(mca_base_open_flag_t flags)
 {
+    char *name;
+    int i;
+
     OBJ_CONSTRUCT(&orcm_db_base.actives, opal_list_t);
+    OBJ_CONSTRUCT(&orcm_db_base.lock, opal_mutex_t);
     OBJ_CONSTRUCT(&orcm_db_base.handles, opal_pointer_array_t);
     opal_pointer_array_init(&orcm_db_base.handles, 3, INT_MAX, 1);
 
@@ -109,8 +201,32 @@ static int orcm_db_base_frame_open(mca_base_open_flag_t flags)
             return ORCM_ERROR;
         }
     } else {
-        /* tie us to the orte_event_base */
+        /* tie us to the orte_event_base - there is no point in
+         * having more than one worker then */
         orcm_db_base.ev_base = orte_event_base;
+        orcm_db_base.num_workers = 1;
+    }
+
+    /* the first worker of each handle runs on the db event base,
+     * the others get a progress thread of their own */
+    orcm_db_base.worker_bases = (opal_event_base_t**)calloc(orcm_db_base.num_workers,
+                                                            sizeof(opal_event_base_t*));
+    if (NULL == orcm_db_base.worker_bases) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    orcm_db_base.worker_bases[0] = orcm_db_base.ev_base;
+    for (i=1; i < orcm_db_base.num_workers; i++) {
+        asprintf(&name, "db%d", i);
+        orcm_db_base.worker_bases[i] = opal_progress_thread_init(name);
+        free(name);
+        if (NULL == orcm_db_base.worker_bases[i]) {
+            /* make do with what we have */
+            opal_output_verbose(1, orcm_db_base_framework.framework_output,
+                                "db:base: could only start %d of %d workers",
+                                i, orcm_db_base.num_workers);
+            orcm_db_base.num_workers = i;
+            break;
+        }
     }
 
     /* Open up all available components */
@@ -143,14 +259,50 @@ static void req_con(orcm_db_request_t *p)
     p->test_result = NULL;
 
     p->kvs = NULL;
+
+    p->inputs = NULL;
+    p->num_inputs = 0;
+
+    p->hdl = NULL;
+    p->worker = 0;
+    p->parent = NULL;
+    p->pending = 0;
+    p->status = ORCM_SUCCESS;
+}
+static void req_des(orcm_db_request_t *p)
+{
+    if (NULL != p->hdl) {
+        OBJ_RELEASE(p->hdl);
+    }
 }
 OBJ_CLASS_INSTANCE(orcm_db_request_t,
                    opal_object_t,
-                   req_con, NULL);
+                   req_con, req_des);
+
+static void hdl_con(orcm_db_handle_t *p)
+{
+    p->component = NULL;
+    p->num_workers = 0;
+    p->workers = NULL;
+}
+static void hdl_des(orcm_db_handle_t *p)
+{
+    int i, j;
 
+    for (i=0; i < p->num_workers; i++) {
+        for (j=0; j < ORCM_DB_NUM_DATA_TYPES; j++) {
+            if (NULL != p->workers[i].batches[j]) {
+                OBJ_RELEASE(p->workers[i].batches[j]);
+            }
+        }
+    }
+    if (NULL != p->workers) {
+        free(p->workers);
+    }
+}
 OBJ_CLASS_INSTANCE(orcm_db_handle_t,
                    opal_object_t,
-                   NULL, NULL);
+                   hdl_con, hdl_des);
 
 OBJ_CLASS_INSTANCE(orcm_db_base_active_component_t,
                    opal_list_item_t,
@@ -13,14 +13,157 @@
 
 #include "opal_stdint.h"
 #include "opal/mca/mca.h"
+#include "opal/sys/atomic.h"
 #include "opal/util/error.h"
 #include "opal/util/output.h"
 #include "opal/mca/base/base.h"
 #include "opal/dss/dss_types.h"
 
+#include "orte/mca/errmgr/errmgr.h"
+
 #include "orcm/mca/db/base/base.h"
 
 
+/*
+ * Requests carrying a hostname are always given to the same worker of
+ * the handle so that the data of a node is stored in order. Requests
+ * without one go to the first worker.
+ */
+static int worker_for_host(orcm_db_handle_t *hdl, const char *hostname)
+{
+    unsigned long hash = 5381;
+    const unsigned char *p;
+
+    if (NULL == hostname || 1 >= hdl->num_workers) {
+        return 0;
+    }
+    for (p = (const unsigned char*)hostname; '\0' != *p; p++) {
+        hash = ((hash << 5) + hash) + *p;
+    }
+    return (int)(hash % (unsigned long)hdl->num_workers);
+}
+
+static const char *find_hostname(opal_list_t *kvs)
+{
+    opal_value_t *kv;
+
+    if (NULL == kvs) {
+        return NULL;
+    }
+    OPAL_LIST_FOREACH(kv, kvs, opal_value_t) {
+        if (NULL != kv->key && 0 == strcmp(kv->key, "hostname") &&
+            OPAL_STRING == kv->type) {
+            return kv->data.string;
+        }
+    }
+    return NULL;
+}
+
+orcm_db_handle_t* orcm_db_base_get_handle(int dbhandle)
+{
+    orcm_db_handle_t *hdl;
+
+    OPAL_THREAD_LOCK(&orcm_db_base.lock);
+    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
+                                                         dbhandle);
+    if (NULL != hdl) {
+        OBJ_RETAIN(hdl);
+    }
+    OPAL_THREAD_UNLOCK(&orcm_db_base.lock);
+    return hdl;
+}
+
+/* push a request into the event base of the worker serving the
+ * given hostname to ensure nobody else is using its connection */
+static void post_request(orcm_db_request_t *req, const char *hostname,
+                         opal_event_cbfunc_t cbfunc)
+{
+    orcm_db_handle_t *hdl;
+    opal_event_base_t *ev_base = orcm_db_base.ev_base;
+
+    req->worker = 0;
+    if (NULL == req->hdl) {
+        req->hdl = orcm_db_base_get_handle(req->dbhandle);
+    }
+    hdl = req->hdl;
+    if (NULL != hdl && 0 < hdl->num_workers) {
+        req->worker = worker_for_host(hdl, hostname);
+        ev_base = hdl->workers[req->worker].ev_base;
+    }
+    opal_event_set(ev_base, &req->ev, -1,
+                   OPAL_EV_WRITE,
+                   cbfunc, req);
+    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
+    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+}
+
+/* push a copy of a request into the event base of each worker of the
+ * handle - the callback of the request is executed by the last one */
+static void post_request_to_all(orcm_db_request_t *req,
+                                opal_event_cbfunc_t cbfunc)
+{
+    orcm_db_handle_t *hdl;
+    orcm_db_request_t *wreq;
+    int i;
+
+    hdl = req->hdl = orcm_db_base_get_handle(req->dbhandle);
+    if (NULL == hdl || 0 == hdl->num_workers) {
+        /* let the request report the error */
+        post_request(req, NULL, cbfunc);
+        return;
+    }
+
+    req->pending = hdl->num_workers;
+    req->status = ORCM_SUCCESS;
+    for (i=0; i < hdl->num_workers; i++) {
+        wreq = OBJ_NEW(orcm_db_request_t);
+        wreq->dbhandle = req->dbhandle;
+        OBJ_RETAIN(hdl);
+        wreq->hdl = hdl;
+        wreq->worker = i;
+        wreq->parent = req;
+        opal_event_set(hdl->workers[i].ev_base, &wreq->ev, -1,
+                       OPAL_EV_WRITE,
+                       cbfunc, wreq);
+        opal_event_set_priority(&wreq->ev, OPAL_EV_SYS_HI_PRI);
+        opal_event_active(&wreq->ev, OPAL_EV_WRITE, 1);
+    }
+}
+
+static orcm_db_worker_t *get_worker(orcm_db_request_t *req)
+{
+    orcm_db_handle_t *hdl = req->hdl;
+
+    if (NULL == hdl || req->worker >= hdl->num_workers) {
+        return NULL;
+    }
+    if (NULL == hdl->workers[req->worker].module) {
+        return NULL;
+    }
+    return &hdl->workers[req->worker];
+}
+
+/* complete the share of a request processed by one worker, returning
+ * the original request if this was the last share of it or NULL if
+ * other workers still have to process theirs */
+static orcm_db_request_t *complete_request(orcm_db_request_t *req, int rc)
+{
+    orcm_db_request_t *parent = req->parent;
+
+    if (NULL == parent) {
+        req->status = rc;
+        return req;
+    }
+    if (ORCM_SUCCESS != rc) {
+        parent->status = rc;
+    }
+    OBJ_RELEASE(req);
+    if (0 == opal_atomic_add_32(&parent->pending, -1)) {
+        return parent;
+    }
+    return NULL;
+}
+
 static void process_open(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
@@ -32,16 +175,25 @@ static void process_open(int fd, short args, void *cbdata)
     char **cmps = NULL;
     opal_value_t *kv;
     bool found;
+    int pool_size = orcm_db_base.num_workers;
 
-    /* see if the caller provided the magic "components" property */
+    /* see if the caller provided the magic "components" property
+     * or asked for a specific number of workers */
     if (NULL != req->input) {
         OPAL_LIST_FOREACH(kv, req->input, opal_value_t) {
             if (0 == strcmp(kv->key, "components")) {
                 cmps = opal_argv_split(kv->data.string, ',');
-                break;
+            } else if (0 == strcmp(kv->key, "pool_size") &&
+                       OPAL_INT == kv->type) {
+                pool_size = kv->data.integer;
             }
         }
     }
+    if (pool_size < 1) {
+        pool_size = 1;
+    } else if (pool_size > orcm_db_base.num_workers) {
+        pool_size = orcm_db_base.num_workers;
+    }
 
     /* cycle thru the available components until one saids
      * it can create a handle for these properties
@@ -64,8 +216,41 @@ static void process_open(int fd, short args, void *cbdata)
                 /* create the handle */
                 hdl = OBJ_NEW(orcm_db_handle_t);
                 hdl->component = component;
-                hdl->module = mod;
+                hdl->workers = (orcm_db_worker_t*)calloc(pool_size,
+                                                         sizeof(orcm_db_worker_t));
+                if (NULL == hdl->workers) {
+                    ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+                    OBJ_RELEASE(hdl);
+                    if (NULL != mod->finalize) {
+                        mod->finalize((struct orcm_db_base_module_t*)mod);
+                    }
+                    if (NULL != req->cbfunc) {
+                        req->cbfunc(-1, ORCM_ERR_OUT_OF_RESOURCE, req->input,
+                                    NULL, req->cbdata);
+                    }
+                    opal_argv_free(cmps);
+                    OBJ_RELEASE(req);
+                    return;
+                }
+                hdl->workers[0].module = mod;
+                hdl->workers[0].ev_base = orcm_db_base.worker_bases[0];
+                hdl->num_workers = 1;
+                /* give each additional worker its own connection */
+                for (i=1; i < pool_size; i++) {
+                    if (NULL == (mod = component->create_handle(req->input))) {
+                        opal_output_verbose(1, orcm_db_base_framework.framework_output,
+                                            "db:base: only %d of %d workers could "
+                                            "connect to %s", i, pool_size,
+                                            component->base_version.mca_component_name);
+                        break;
+                    }
+                    hdl->workers[i].module = mod;
+                    hdl->workers[i].ev_base = orcm_db_base.worker_bases[i];
+                    hdl->num_workers++;
+                }
+                OPAL_THREAD_LOCK(&orcm_db_base.lock);
                 index = opal_pointer_array_add(&orcm_db_base.handles, hdl);
+                OPAL_THREAD_UNLOCK(&orcm_db_base.lock);
                 if (NULL != req->cbfunc) {
                     req->cbfunc(index, ORCM_SUCCESS, req->input, NULL,
                                 req->cbdata);
@@ -113,32 +298,63 @@ static void process_close(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
     orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
+    orcm_db_batch_queue_t *q;
     int rc = ORCM_SUCCESS;
+    int i;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
-    if (NULL ==  hdl->module) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
+    orcm_db_base_batch_flush_all(wkr);
+    for (i=0; i < ORCM_DB_NUM_DATA_TYPES; i++) {
+        if (NULL != (q = wkr->batches[i])) {
+            opal_output_verbose(2, orcm_db_base_framework.framework_output,
+                                "db:base: handle %d worker %d data type %d batching: "
+                                "%" PRIu64 " requests in %" PRIu64 " batches, "
+                                "%" PRIu64 " dropped, max depth %lu, "
+                                "max latency %g secs, avg latency %g secs",
+                                req->dbhandle, req->worker, i, q->stats.flushed,
+                                q->stats.flushes, q->stats.dropped,
+                                (unsigned long)q->stats.max_depth,
+                                q->stats.max_flush_latency,
+                                (0 == q->stats.flushes) ? 0.0 :
+                                q->stats.total_flush_latency / q->stats.flushes);
+            /* the queue events belong to this worker */
+            wkr->batches[i] = NULL;
+            OBJ_RELEASE(q);
+        }
     }
-    if (NULL != hdl->module->finalize) {
-        hdl->module->finalize((struct orcm_db_base_module_t*)hdl->module);
+    if (NULL != wkr->module->finalize) {
+        wkr->module->finalize((struct orcm_db_base_module_t*)wkr->module);
     }
+    wkr->module = NULL;
 
 callback_and_cleanup:
-    /* release the handle */
-    opal_pointer_array_set_item(&orcm_db_base.handles, req->dbhandle, NULL);
+    if (NULL == (req = complete_request(req, rc))) {
+        return;
+    }
+
+    /* release the handle - it goes once the requests still holding
+     * it are done */
+    OPAL_THREAD_LOCK(&orcm_db_base.lock);
+    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
+                                                         req->dbhandle);
+    if (hdl == req->hdl) {
+        opal_pointer_array_set_item(&orcm_db_base.handles, req->dbhandle, NULL);
+    } else {
+        /* closed already */
+        hdl = NULL;
+    }
+    OPAL_THREAD_UNLOCK(&orcm_db_base.lock);
     if (NULL != hdl) {
         OBJ_RELEASE(hdl);
     }
 
     if (NULL != req->cbfunc) {
-        req->cbfunc(req->dbhandle, rc, NULL, NULL, req->cbdata);
+        req->cbfunc(req->dbhandle, req->status, NULL, NULL, req->cbdata);
     }
 
     OBJ_RELEASE(req);
@@ -150,41 +366,28 @@ void orcm_db_base_close(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
-     */
+    /* each worker of the handle has to process this request */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_close, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request_to_all(req, process_close);
 }
 
 
 static void process_store(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc=ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-    if (NULL ==  hdl->module) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
-    if (NULL != hdl->module->store) {
-        rc = hdl->module->store((struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->store) {
+        rc = wkr->module->store((struct orcm_db_base_module_t*)wkr->module,
                                 req->primary_key, req->kvs);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -205,9 +408,9 @@ void orcm_db_base_store(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -215,33 +418,29 @@ void orcm_db_base_store(int dbhandle,
     req->kvs = kvs;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_store, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, find_hostname(kvs), process_store);
 }
 
 static void process_store_new(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
-    if (NULL ==  hdl->module) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
+    /* requests that don't expect any output can be batched */
+    if (0 < orcm_db_base.batch_size && NULL == req->output &&
+        req->data_type < ORCM_DB_NUM_DATA_TYPES) {
+        orcm_db_base_batch_enqueue(wkr, req);
+        OBJ_RELEASE(req);
+        return;
     }
-    if (NULL != hdl->module->store) {
-        rc = hdl->module->store_new((struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->store_new) {
+        rc = wkr->module->store_new((struct orcm_db_base_module_t*)wkr->module,
                                     req->data_type, req->input, req->output);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -263,9 +462,9 @@ void orcm_db_base_store_new(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -274,35 +473,71 @@ void orcm_db_base_store_new(int dbhandle,
     req->output = ret;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_store_new, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, find_hostname(input), process_store_new);
 }
 
-static void process_record_data_samples(int fd, short args, void *cbdata)
+static void process_store_batch(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
+    /* whatever the worker has queued of this type goes first */
+    if (req->data_type < ORCM_DB_NUM_DATA_TYPES &&
+        NULL != wkr->batches[req->data_type]) {
+        orcm_db_base_batch_flush(wkr->batches[req->data_type]);
+    }
+    rc = orcm_db_base_batch_store(wkr->module, req->data_type, req->inputs,
+                                  req->num_inputs, NULL);
 
-    if (NULL ==  hdl->module) {
+callback_and_cleanup:
+    if (NULL != req->cbfunc) {
+        req->cbfunc(req->dbhandle, rc, NULL, NULL, req->cbdata);
+    }
+    OBJ_RELEASE(req);
+}
+
+void orcm_db_base_store_batch(int dbhandle,
+                              orcm_db_data_type_t data_type,
+                              opal_list_t **inputs,
+                              size_t num_inputs,
+                              orcm_db_callback_fn_t cbfunc,
+                              void *cbdata)
+{
+    orcm_db_request_t *req;
+
+    /* the whole batch goes to the worker of its first data set */
+    req = OBJ_NEW(orcm_db_request_t);
+    req->dbhandle = dbhandle;
+    req->data_type = data_type;
+    req->inputs = inputs;
+    req->num_inputs = num_inputs;
+    req->cbfunc = cbfunc;
+    req->cbdata = cbdata;
+    post_request(req, (0 < num_inputs) ? find_hostname(inputs[0]) : NULL,
+                 process_store_batch);
+}
+
+static void process_record_data_samples(int fd, short args, void *cbdata)
+{
+    orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
+    orcm_db_worker_t *wkr;
+    int rc = ORCM_SUCCESS;
+
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
 
-    if (NULL != hdl->module->record_data_samples) {
-        rc = hdl->module->record_data_samples(
-                (struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->record_data_samples) {
+        rc = wkr->module->record_data_samples(
+                (struct orcm_db_base_module_t*)wkr->module,
                 req->hostname, req->time_stamp, req->data_group, req->input);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -325,9 +560,9 @@ void orcm_db_base_record_data_samples(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -337,35 +572,24 @@ void orcm_db_base_record_data_samples(int dbhandle,
     req->input = samples;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_record_data_samples, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, hostname, process_record_data_samples);
 }
 
 static void process_update_node_features(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
 
-    if (NULL ==  hdl->module) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-
-    if (NULL != hdl->module->update_node_features) {
-        rc = hdl->module->update_node_features(
-                (struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->update_node_features) {
+        rc = wkr->module->update_node_features(
+                (struct orcm_db_base_module_t*)wkr->module,
                 req->hostname, req->input);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -386,9 +610,9 @@ void orcm_db_base_update_node_features(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -396,35 +620,24 @@ void orcm_db_base_update_node_features(int dbhandle,
     req->input = features;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_update_node_features, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, hostname, process_update_node_features);
 }
 
 static void process_record_diag_test(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-
-    if (NULL ==  hdl->module) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
 
-    if (NULL != hdl->module->record_diag_test) {
-        rc = hdl->module->record_diag_test(
-                (struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->record_diag_test) {
+        rc = wkr->module->record_diag_test(
+                (struct orcm_db_base_module_t*)wkr->module,
                 req->hostname,
                 req->diag_type,
                 req->diag_subtype,
@@ -458,9 +671,9 @@ void orcm_db_base_record_diag_test(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -474,39 +687,34 @@ void orcm_db_base_record_diag_test(int dbhandle,
     req->input = test_params;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_record_diag_test, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, hostname, process_record_diag_test);
 }
 
 static void process_commit(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
-    int rc=ORCM_SUCCESS;
+    orcm_db_worker_t *wkr;
+    int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-    if (NULL ==  hdl->module) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
-    if (NULL != hdl->module->commit) {
-        hdl->module->commit((struct orcm_db_base_module_t*)hdl->module);
+    /* anything queued before the commit belongs to this transaction */
+    orcm_db_base_batch_flush_all(wkr);
+    if (NULL != wkr->module->commit) {
+        wkr->module->commit((struct orcm_db_base_module_t*)wkr->module);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
     }
 
 callback_and_cleanup:
+    if (NULL == (req = complete_request(req, rc))) {
+        return;
+    }
     if (NULL != req->cbfunc) {
-        req->cbfunc(req->dbhandle, rc, NULL, NULL, req->cbdata);
+        req->cbfunc(req->dbhandle, req->status, NULL, NULL, req->cbdata);
     }
     OBJ_RELEASE(req);
 }
@@ -517,47 +725,38 @@ void orcm_db_base_commit(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
-     */
+    /* each worker of the handle has to process this request */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_commit, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request_to_all(req, process_commit);
 }
 
 static void process_rollback(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc = ORCM_SUCCESS;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
-    if (NULL ==  hdl->module) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-    if (NULL != hdl->module->rollback) {
-        hdl->module->rollback((struct orcm_db_base_module_t*)hdl->module);
+    orcm_db_base_batch_flush_all(wkr);
+    if (NULL != wkr->module->rollback) {
+        wkr->module->rollback((struct orcm_db_base_module_t*)wkr->module);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
     }
 
 callback_and_cleanup:
+    if (NULL == (req = complete_request(req, rc))) {
+        return;
+    }
     if (NULL != req->cbfunc) {
-        req->cbfunc(req->dbhandle, rc, NULL, NULL, req->cbdata);
+        req->cbfunc(req->dbhandle, req->status, NULL, NULL, req->cbdata);
     }
     OBJ_RELEASE(req);
 }
@@ -568,41 +767,28 @@ void orcm_db_base_rollback(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
-     */
+    /* each worker of the handle has to process this request */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_rollback, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request_to_all(req, process_rollback);
 }
 
 static void process_fetch(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-    if (NULL ==  hdl->module) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
 
-    if (NULL != hdl->module->fetch) {
-        rc = hdl->module->fetch((struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->fetch) {
+        rc = wkr->module->fetch((struct orcm_db_base_module_t*)wkr->module,
                                 req->primary_key, req->key, req->output);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -624,9 +810,9 @@ void orcm_db_base_fetch(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -635,33 +821,23 @@ void orcm_db_base_fetch(int dbhandle,
     req->output = kvs;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_fetch, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, NULL, process_fetch);
 }
 
 static void process_remove(int fd, short args, void *cbdata)
 {
     orcm_db_request_t *req = (orcm_db_request_t*)cbdata;
-    orcm_db_handle_t *hdl;
+    orcm_db_worker_t *wkr;
     int rc;
 
-    /* get the handle object */
-    hdl = (orcm_db_handle_t*)opal_pointer_array_get_item(&orcm_db_base.handles,
-                                                         req->dbhandle);
-    if (NULL == hdl) {
-        rc = ORCM_ERR_NOT_FOUND;
-        goto callback_and_cleanup;
-    }
-    if (NULL ==  hdl->module) {
+    /* get the worker */
+    if (NULL == (wkr = get_worker(req))) {
         rc = ORCM_ERR_NOT_FOUND;
         goto callback_and_cleanup;
     }
 
-    if (NULL != hdl->module->remove) {
-        rc = hdl->module->remove((struct orcm_db_base_module_t*)hdl->module,
+    if (NULL != wkr->module->remove) {
+        rc = wkr->module->remove((struct orcm_db_base_module_t*)wkr->module,
                                  req->primary_key, req->key);
     } else {
         rc = ORCM_ERR_NOT_IMPLEMENTED;
@@ -682,9 +858,9 @@ void orcm_db_base_remove_data(int dbhandle,
 {
     orcm_db_request_t *req;
 
-    /* push this request into our event_base
-     * for processing to ensure nobody else is
-     * using that dbhandle
+    /* push this request into the event_base of the
+     * worker in charge of this data to ensure nobody
+     * else is using its connection
      */
     req = OBJ_NEW(orcm_db_request_t);
     req->dbhandle = dbhandle;
@@ -692,9 +868,5 @@ void orcm_db_base_remove_data(int dbhandle,
     req->key = (char*)key;
     req->cbfunc = cbfunc;
     req->cbdata = cbdata;
-    opal_event_set(orcm_db_base.ev_base, &req->ev, -1,
-                   OPAL_EV_WRITE,
-                   process_remove, req);
-    opal_event_set_priority(&req->ev, OPAL_EV_SYS_HI_PRI);
-    opal_event_active(&req->ev, OPAL_EV_WRITE, 1);
+    post_request(req, NULL, process_remove);
 }
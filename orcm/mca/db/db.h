@@ -146,6 +146,39 @@ typedef int (*orcm_db_base_module_store_new_fn_t)(
         opal_list_t *input,
         opal_list_t *ret);
 
+/*
+ * Store a batch of data sets of the same type in a single operation. Each
+ * element of the inputs array is a list of the same form that store_new
+ * receives. This entry point is optional: the db base uses it to pass
+ * along the requests it has coalesced for a handle when batching is
+ * enabled (see the db_base_batch_* MCA params), falling back to one
+ * store_new call per data set when a module doesn't provide it.
+ *
+ * A batch is stored whole or not at all: a module that cannot store
+ * the batch as a single operation must return an error without storing
+ * any of it (e.g. ORCM_ERR_NOT_SUPPORTED). The db base then stores the
+ * data sets one at a time so that one bad data set doesn't take the
+ * others down with it, and reports the status of each.
+ */
+typedef int (*orcm_db_base_module_store_batch_fn_t)(
+        struct orcm_db_base_module_t *imod,
+        orcm_db_data_type_t data_type,
+        opal_list_t **inputs,
+        size_t num_inputs);
+
+/*
+ * Store a batch of data sets of the same type as a single request, e.g.
+ * the results a producer has accumulated over an interval. The inputs
+ * array and the lists in it belong to the caller until the callback,
+ * which is called once for the whole batch with a NULL input.
+ */
+typedef void (*orcm_db_base_API_store_batch_fn_t)(int dbhandle,
+                                                  orcm_db_data_type_t data_type,
+                                                  opal_list_t **inputs,
+                                                  size_t num_inputs,
+                                                  orcm_db_callback_fn_t cbfunc,
+                                                  void *cbdata);
+
 /*
  * Specialized API function for storing data samples from components from the
  * sensor framework.  The samples are provided as a list of type
@@ -277,6 +310,7 @@ struct orcm_db_base_module_t{
     orcm_db_base_module_rollback_fn_t             rollback;
     orcm_db_base_module_fetch_fn_t                fetch;
     orcm_db_base_module_remove_fn_t               remove;
+    orcm_db_base_module_store_batch_fn_t          store_batch;
 };
 
 typedef struct orcm_db_base_module_t orcm_db_base_module_t;
@@ -286,6 +320,7 @@ typedef struct {
     orcm_db_base_API_close_fn_t                close;
     orcm_db_base_API_store_fn_t                store;
     orcm_db_base_API_store_new_fn_t            store_new;
+    orcm_db_base_API_store_batch_fn_t          store_batch;
     orcm_db_base_API_record_data_samples_fn_t  record_data_samples;
     orcm_db_base_API_update_node_features_fn_t update_node_features;
     orcm_db_base_API_record_diag_test_fn_t     record_diag_test;
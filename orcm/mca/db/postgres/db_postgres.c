@@ -24,6 +24,9 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
 
 #include <sys/time.h>
 #include <time.h>
@@ -51,6 +54,10 @@ static int postgres_store(struct orcm_db_base_module_t *imod,
                           orcm_db_data_type_t data_type,
                           opal_list_t *input,
                           opal_list_t *ret);
+static int postgres_store_batch(struct orcm_db_base_module_t *imod,
+                                orcm_db_data_type_t data_type,
+                                opal_list_t **inputs,
+                                size_t num_inputs);
 static int postgres_update_node_features(struct orcm_db_base_module_t *imod,
                                          const char *hostname,
                                          opal_list_t *features);
@@ -70,6 +77,9 @@ static int postgres_rollback(struct orcm_db_base_module_t *imod);
 static int postgres_store_data_sample(mca_db_postgres_module_t *mod,
                                       opal_list_t *input,
                                       opal_list_t *ret);
+static int postgres_copy_data_samples(mca_db_postgres_module_t *mod,
+                                      opal_list_t **inputs,
+                                      size_t num_inputs);
 static int postgres_store_node_features(mca_db_postgres_module_t *mod,
                                         opal_list_t *input,
                                         opal_list_t *ret);
@@ -79,6 +89,8 @@ static int postgres_store_diag_test(mca_db_postgres_module_t *mod,
 
 static bool tv_to_str_time_stamp(const struct timeval *time, char *tbuf,
                                  size_t size);
+static bool tv_to_pg_time_stamp(const struct timeval *time, int64_t *usecs);
+static bool str_to_pg_time_stamp(const char *time, int64_t *usecs);
 static void tm_to_str_time_stamp(const struct tm *time, char *tbuf,
                                  size_t size);
 static inline bool status_ok(PGresult *res);
@@ -95,7 +107,8 @@ mca_db_postgres_module_t mca_db_postgres_module = {
         postgres_commit,
         postgres_rollback,
         NULL,
-        NULL
+        NULL,
+        postgres_store_batch
     },
 };
 
@@ -196,6 +209,9 @@ static void postgres_finalize(struct orcm_db_base_module_t *imod)
     if (NULL != mod->conn) {
         PQfinish(mod->conn);
     }
+    if (NULL != mod->copy_buf) {
+        free(mod->copy_buf);
+    }
 
     free(mod);
 }
@@ -237,6 +253,23 @@ static int postgres_store(struct orcm_db_base_module_t *imod,
     return rc;
 }
 
+static int postgres_store_batch(struct orcm_db_base_module_t *imod,
+                                orcm_db_data_type_t data_type,
+                                opal_list_t **inputs,
+                                size_t num_inputs)
+{
+    mca_db_postgres_module_t *mod = (mca_db_postgres_module_t*)imod;
+
+    /* All the samples in the batch go out in a single COPY, which
+     * stores all of them or none */
+    if (ORCM_DB_ENV_DATA == data_type && mod->copy) {
+        return postgres_copy_data_samples(mod, inputs, num_inputs);
+    }
+
+    /* anything else is stored one data set at a time by the base */
+    return ORCM_ERR_NOT_SUPPORTED;
+}
+
 static int postgres_store_sample(struct orcm_db_base_module_t *imod,
                                  const char *data_group,
                                  opal_list_t *kvs)
@@ -511,6 +544,10 @@ static int postgres_store_data_sample(mca_db_postgres_module_t *mod,
         return ORCM_ERR_BAD_PARAM;
     }
 
+    if (mod->copy) {
+        return postgres_copy_data_samples(mod, &input, 1);
+    }
+
     num_items = opal_list_get_size(input);
     OBJ_CONSTRUCT(&item_bm, opal_bitmap_t);
     opal_bitmap_init(&item_bm, (int)num_items);
@@ -722,6 +759,418 @@ cleanup_and_exit:
     return rc;
 }
 
+/*
+ * Binary COPY support
+ *
+ * The rows are encoded directly in the PostgreSQL binary COPY format into a
+ * buffer owned by the module, which is reused across calls. The format is:
+ *   header:  11-byte signature, int32 flags, int32 header extension length
+ *   tuple:   int16 field count, then for each field an int32 length (-1 for
+ *            NULL) followed by the field data in network byte order
+ *   trailer: int16 -1
+ */
+#define ORCM_PG_COPY_NUM_FIELDS 8
+#define ORCM_PG_COPY_INITIAL_BUF_SIZE 65536
+
+/* Seconds between the Unix epoch and the PostgreSQL epoch (2000-01-01) */
+#define ORCM_PG_EPOCH_OFFSET 946684800LL
+
+static const char pg_copy_signature[11] = "PGCOPY\n\377\r\n\0";
+
+static bool copy_buf_reserve(mca_db_postgres_module_t *mod, size_t len)
+{
+    size_t size;
+    char *buf;
+
+    if (mod->copy_buf_used + len <= mod->copy_buf_size) {
+        return true;
+    }
+
+    size = (0 == mod->copy_buf_size) ?
+           ORCM_PG_COPY_INITIAL_BUF_SIZE : mod->copy_buf_size;
+    while (size < mod->copy_buf_used + len) {
+        size *= 2;
+    }
+    if (NULL == (buf = (char *)realloc(mod->copy_buf, size))) {
+        return false;
+    }
+    mod->copy_buf = buf;
+    mod->copy_buf_size = size;
+
+    return true;
+}
+
+static inline void copy_put_bytes(mca_db_postgres_module_t *mod,
+                                  const void *data, size_t len)
+{
+    memcpy(mod->copy_buf + mod->copy_buf_used, data, len);
+    mod->copy_buf_used += len;
+}
+
+static inline void copy_put_int16(mca_db_postgres_module_t *mod, int16_t val)
+{
+    uint16_t nval = htons((uint16_t)val);
+    copy_put_bytes(mod, &nval, sizeof(nval));
+}
+
+static inline void copy_put_int32(mca_db_postgres_module_t *mod, int32_t val)
+{
+    uint32_t nval = htonl((uint32_t)val);
+    copy_put_bytes(mod, &nval, sizeof(nval));
+}
+
+static inline void copy_put_int64(mca_db_postgres_module_t *mod, int64_t val)
+{
+    uint32_t nval[2];
+
+    nval[0] = htonl((uint32_t)((uint64_t)val >> 32));
+    nval[1] = htonl((uint32_t)((uint64_t)val & 0xffffffff));
+    copy_put_bytes(mod, nval, sizeof(nval));
+}
+
+static inline void copy_put_null(mca_db_postgres_module_t *mod)
+{
+    copy_put_int32(mod, -1);
+}
+
+static inline void copy_put_text(mca_db_postgres_module_t *mod,
+                                 const char *str, size_t len)
+{
+    copy_put_int32(mod, (int32_t)len);
+    copy_put_bytes(mod, str, len);
+}
+
+static bool copy_add_row(mca_db_postgres_module_t *mod,
+                         const char *hostname, size_t hostname_len,
+                         const char *data_group, size_t data_group_len,
+                         int64_t time_stamp, orcm_metric_value_t *mv,
+                         orcm_db_item_t *item)
+{
+    size_t data_item_len = strlen(mv->value.key);
+    size_t units_len = (NULL != mv->units) ? strlen(mv->units) : 0;
+    size_t str_len = (ORCM_DB_ITEM_STRING == item->item_type) ?
+                     strlen(item->value.value_str) : 0;
+    int64_t ival;
+
+    /* field count + 8 lengths + fixed size values + strings */
+    if (!copy_buf_reserve(mod, sizeof(int16_t) +
+                               ORCM_PG_COPY_NUM_FIELDS * sizeof(int32_t) +
+                               4 * sizeof(int64_t) + hostname_len +
+                               data_group_len + 1 + data_item_len +
+                               str_len + units_len)) {
+        return false;
+    }
+
+    copy_put_int16(mod, ORCM_PG_COPY_NUM_FIELDS);
+
+    /* hostname */
+    copy_put_text(mod, hostname, hostname_len);
+
+    /* data_item: <data_group>_<data_item> */
+    copy_put_int32(mod, (int32_t)(data_group_len + 1 + data_item_len));
+    copy_put_bytes(mod, data_group, data_group_len);
+    copy_put_bytes(mod, "_", 1);
+    copy_put_bytes(mod, mv->value.key, data_item_len);
+
+    /* time_stamp */
+    copy_put_int32(mod, sizeof(int64_t));
+    copy_put_int64(mod, time_stamp);
+
+    /* value_int, value_real, value_str */
+    switch (item->item_type) {
+    case ORCM_DB_ITEM_STRING:
+        copy_put_null(mod);
+        copy_put_null(mod);
+        copy_put_text(mod, item->value.value_str, str_len);
+        break;
+    case ORCM_DB_ITEM_REAL:
+        copy_put_null(mod);
+        copy_put_int32(mod, sizeof(double));
+        memcpy(&ival, &item->value.value_real, sizeof(ival));
+        copy_put_int64(mod, ival);
+        copy_put_null(mod);
+        break;
+    default: /* ORCM_DB_ITEM_INTEGER */
+        copy_put_int32(mod, sizeof(int64_t));
+        copy_put_int64(mod, (int64_t)item->value.value_int);
+        copy_put_null(mod);
+        copy_put_null(mod);
+    }
+
+    /* units */
+    if (NULL != mv->units) {
+        copy_put_text(mod, mv->units, units_len);
+    } else {
+        copy_put_null(mod);
+    }
+
+    /* data_type_id */
+    copy_put_int32(mod, sizeof(int32_t));
+    copy_put_int32(mod, (int32_t)mv->value.type);
+
+    return true;
+}
+
+static int copy_encode_data_sample(mca_db_postgres_module_t *mod,
+                                   opal_list_t *input)
+{
+    int rc = ORCM_SUCCESS;
+
+    const int NUM_PARAMS = 3;
+    const char *params[] = {
+        "data_group",
+        "ctime",
+        "hostname"
+    };
+    opal_value_t *param_items[] = {NULL, NULL, NULL};
+    opal_bitmap_t item_bm;
+
+    char *hostname;
+    char *data_group;
+    size_t hostname_len;
+    size_t data_group_len;
+    int64_t time_stamp;
+    orcm_db_item_t item;
+
+    size_t num_items;
+    size_t i;
+
+    opal_value_t *kv;
+    orcm_metric_value_t *mv;
+
+    if (NULL == input) {
+        ERR_MSG_STORE("No parameters provided");
+        return ORCM_ERR_BAD_PARAM;
+    }
+
+    num_items = opal_list_get_size(input);
+    OBJ_CONSTRUCT(&item_bm, opal_bitmap_t);
+    opal_bitmap_init(&item_bm, (int)num_items);
+
+    /* Get the main parameters form the list */
+    find_items(params, NUM_PARAMS, input, param_items, &item_bm);
+
+    /* Check the parameters */
+    if (NULL == param_items[0]) {
+        ERR_MSG_STORE("No data group provided");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+    if (NULL == param_items[1]) {
+        ERR_MSG_STORE("No time stamp provided");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+    if (NULL == param_items[2]) {
+        ERR_MSG_STORE("No hostname provided");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+
+    kv = param_items[0];
+    if (OPAL_STRING != kv->type) {
+        ERR_MSG_STORE("Invalid value type specified for data group");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+    data_group = kv->data.string;
+
+    kv = param_items[1];
+    switch (kv->type) {
+    case OPAL_TIMEVAL:
+    case OPAL_TIME:
+        if (!tv_to_pg_time_stamp(&kv->data.tv, &time_stamp)) {
+            ERR_MSG_STORE("Failed to convert time stamp value");
+            rc = ORCM_ERR_BAD_PARAM;
+            goto cleanup_and_exit;
+        }
+        break;
+    case OPAL_STRING:
+        if (!str_to_pg_time_stamp(kv->data.string, &time_stamp)) {
+            ERR_MSG_STORE("Failed to convert time stamp value");
+            rc = ORCM_ERR_BAD_PARAM;
+            goto cleanup_and_exit;
+        }
+        break;
+    default:
+        ERR_MSG_STORE("Invalid value type specified for time stamp");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+
+    kv = param_items[2];
+    if (OPAL_STRING != kv->type) {
+        ERR_MSG_STORE("Invalid value type specified for hostname");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+    hostname = kv->data.string;
+
+    if (num_items <= (size_t)NUM_PARAMS) {
+        ERR_MSG_STORE("No data samples provided");
+        rc = ORCM_ERR_BAD_PARAM;
+        goto cleanup_and_exit;
+    }
+
+    hostname_len = strlen(hostname);
+    data_group_len = strlen(data_group);
+
+    i = 0;
+    OPAL_LIST_FOREACH(mv, input, orcm_metric_value_t) {
+        /* Ignore the items that have already been processed */
+        if (opal_bitmap_is_set_bit(&item_bm, i)) {
+            i++;
+            continue;
+        }
+        i++;
+
+        if (NULL == mv->value.key) {
+            rc = ORCM_ERR_BAD_PARAM;
+            ERR_MSG_STORE("No data item specified");
+            goto cleanup_and_exit;
+        }
+
+        if (ORCM_SUCCESS != opal_value_to_orcm_db_item(&mv->value, &item)) {
+            rc = ORCM_ERR_NOT_SUPPORTED;
+            ERR_MSG_FMT_STORE("Unsupported data type: %s",
+                              opal_dss.lookup_data_type(mv->value.type));
+            goto cleanup_and_exit;
+        }
+
+        if (!copy_add_row(mod, hostname, hostname_len, data_group,
+                          data_group_len, time_stamp, mv, &item)) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            ERR_MSG_STORE("Unable to allocate memory");
+            goto cleanup_and_exit;
+        }
+    }
+
+cleanup_and_exit:
+    OBJ_DESTRUCT(&item_bm);
+
+    return rc;
+}
+
+/* a failed COPY aborts the transaction it runs in, so it runs in a
+ * savepoint of its own that is rolled back before the rows are tried
+ * again one at a time */
+static bool copy_savepoint(mca_db_postgres_module_t *mod, const char *cmd)
+{
+    PGresult *res;
+    bool ok;
+
+    res = PQexec(mod->conn, cmd);
+    if (!(ok = status_ok(res))) {
+        ERR_MSG_FMT_STORE("Unable to %s: %s", cmd, PQresultErrorMessage(res));
+    }
+    PQclear(res);
+    return ok;
+}
+
+static int postgres_copy_data_samples(mca_db_postgres_module_t *mod,
+                                      opal_list_t **inputs,
+                                      size_t num_inputs)
+{
+    int rc = ORCM_SUCCESS;
+    bool savepoint = false;
+    size_t i;
+
+    PGresult *res = NULL;
+
+    /* Encode all the rows before talking to the server */
+    mod->copy_buf_used = 0;
+    if (!copy_buf_reserve(mod, sizeof(pg_copy_signature) +
+                               2 * sizeof(int32_t))) {
+        ERR_MSG_STORE("Unable to allocate memory");
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    copy_put_bytes(mod, pg_copy_signature, sizeof(pg_copy_signature));
+    copy_put_int32(mod, 0);
+    copy_put_int32(mod, 0);
+
+    for (i = 0; i < num_inputs; i++) {
+        if (ORCM_SUCCESS != (rc = copy_encode_data_sample(mod, inputs[i]))) {
+            return rc;
+        }
+    }
+
+    if (!copy_buf_reserve(mod, sizeof(int16_t))) {
+        ERR_MSG_STORE("Unable to allocate memory");
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    copy_put_int16(mod, -1);
+
+    /* If we're not in auto commit mode, let's start a new transaction (if
+     * one hasn't already been started) */
+    if (!mod->tran_started && !mod->autocommit) {
+        res = PQexec(mod->conn, "begin");
+        if (!status_ok(res)) {
+            rc = ORCM_ERROR;
+            ERR_MSG_FMT_STORE("Unable to start transaction: %s",
+                              PQresultErrorMessage(res));
+            goto cleanup_and_exit;
+        }
+        PQclear(res);
+        res = NULL;
+        mod->tran_started = true;
+    }
+    if (mod->tran_started) {
+        if (!copy_savepoint(mod, "savepoint orcm_copy")) {
+            return ORCM_ERROR;
+        }
+        savepoint = true;
+    }
+
+    res = PQexec(mod->conn, "copy data_sample_raw(hostname,data_item,"
+                 "time_stamp,value_int,value_real,value_str,units,"
+                 "data_type_id) from stdin with (format binary)");
+    if (PGRES_COPY_IN != PQresultStatus(res)) {
+        rc = ORCM_ERROR;
+        ERR_MSG_STORE(PQresultErrorMessage(res));
+        goto cleanup_and_exit;
+    }
+    PQclear(res);
+    res = NULL;
+
+    if (1 != PQputCopyData(mod->conn, mod->copy_buf,
+                           (int)mod->copy_buf_used)) {
+        rc = ORCM_ERROR;
+        ERR_MSG_STORE(PQerrorMessage(mod->conn));
+        PQputCopyEnd(mod->conn, "unable to send data");
+    } else if (1 != PQputCopyEnd(mod->conn, NULL)) {
+        rc = ORCM_ERROR;
+        ERR_MSG_STORE(PQerrorMessage(mod->conn));
+    }
+
+    /* Collect the result of the COPY command */
+    while (NULL != (res = PQgetResult(mod->conn))) {
+        if (ORCM_SUCCESS == rc && !status_ok(res)) {
+            rc = ORCM_ERROR;
+            ERR_MSG_STORE(PQresultErrorMessage(res));
+        }
+        PQclear(res);
+    }
+
+    if (ORCM_SUCCESS == rc) {
+        opal_output_verbose(2, orcm_db_base_framework.framework_output,
+                            "postgres_copy_data_samples succeeded");
+    }
+
+cleanup_and_exit:
+    if (NULL != res) {
+        PQclear(res);
+    }
+    if (savepoint) {
+        if (ORCM_SUCCESS != rc) {
+            copy_savepoint(mod, "rollback to savepoint orcm_copy");
+        } else if (!copy_savepoint(mod, "release savepoint orcm_copy")) {
+            rc = ORCM_ERROR;
+        }
+    }
+
+    return rc;
+}
+
 #define ERR_MSG_UNF(msg) \
     opal_output(0, "***********************************************"); \
     opal_output(0, "db:postgres: Unable to update node features"); \
@@ -1882,6 +2331,80 @@ static bool tv_to_str_time_stamp(const struct timeval *time, char *tbuf,
     }
 }
 
+/*
+ * Binary representation of a PostgreSQL "timestamp without time zone":
+ * microseconds since 2000-01-01 00:00:00 in the stored wall clock time.
+ */
+static int64_t civil_to_pg_time_stamp(int64_t year, int64_t month,
+                                      int64_t day, int64_t hour,
+                                      int64_t min, int64_t sec,
+                                      int64_t usec)
+{
+    int64_t era, yoe, doy, doe, days;
+
+    /* Days since the Unix epoch for the civil date */
+    if (month <= 2) {
+        year--;
+    }
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+
+    return ((days * 86400 + hour * 3600 + min * 60 + sec) -
+            ORCM_PG_EPOCH_OFFSET) * 1000000 + usec;
+}
+
+/* Like the text representation, the local wall clock time is stored */
+static bool tv_to_pg_time_stamp(const struct timeval *time, int64_t *usecs)
+{
+    struct timeval nrm_time = *time;
+    struct tm tm_info;
+
+    /* Normalize */
+    while (nrm_time.tv_usec < 0) {
+        nrm_time.tv_usec += 1000000;
+        nrm_time.tv_sec--;
+    }
+    while (nrm_time.tv_usec >= 1000000) {
+        nrm_time.tv_usec -= 1000000;
+        nrm_time.tv_sec++;
+    }
+
+    if (NULL == localtime_r(&nrm_time.tv_sec, &tm_info)) {
+        return false;
+    }
+
+    *usecs = civil_to_pg_time_stamp((int64_t)tm_info.tm_year + 1900,
+                                    (int64_t)tm_info.tm_mon + 1,
+                                    tm_info.tm_mday, tm_info.tm_hour,
+                                    tm_info.tm_min, tm_info.tm_sec,
+                                    nrm_time.tv_usec);
+
+    return true;
+}
+
+/* Accepts the format produced by tv_to_str_time_stamp:
+ * YYYY-MM-DD HH:MM:SS[.fraction] */
+static bool str_to_pg_time_stamp(const char *time, int64_t *usecs)
+{
+    int year, month, day, hour, min, sec;
+    double fraction = 0.0;
+    int n;
+
+    n = sscanf(time, "%d-%d-%d %d:%d:%d%lf", &year, &month, &day,
+               &hour, &min, &sec, &fraction);
+    if (n < 6 || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    *usecs = civil_to_pg_time_stamp(year, month, day, hour, min, sec,
+                                    (int64_t)(fraction * 1000000.0 + 0.5));
+
+    return true;
+}
+
 static void tm_to_str_time_stamp(const struct tm *time, char *tbuf,
                                  size_t size)
 {
@@ -37,6 +37,10 @@ typedef struct {
     bool autocommit;
     bool tran_started;
     bool prepared[ORCM_DB_PG_STMT_NUM_STMTS];
+    bool copy;
+    char *copy_buf;
+    size_t copy_buf_size;
+    size_t copy_buf_used;
 } mca_db_postgres_module_t;
 ORCM_MODULE_DECLSPEC extern mca_db_postgres_module_t mca_db_postgres_module;
 
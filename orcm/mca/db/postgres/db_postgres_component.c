@@ -65,6 +65,7 @@ static char *pgtty;
 static char *dbname;
 static char *user;
 static bool autocommit;
+static bool copy;
 
 static int component_register(void) {
     mca_base_component_t *c = &mca_db_postgres_component.base_version;
@@ -123,6 +124,17 @@ static int component_register(void) {
                                           MCA_BASE_VAR_SCOPE_READONLY,
                                           &autocommit);
 
+    /* retrieve the bulk ingest setting */
+    copy = false;
+    (void)mca_base_component_var_register(c, "copy",
+                                          "Use binary COPY FROM STDIN instead "
+                                          "of INSERT statements to store "
+                                          "environmental data samples",
+                                          MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                          OPAL_INFO_LVL_9,
+                                          MCA_BASE_VAR_SCOPE_READONLY,
+                                          &copy);
+
     return ORCM_SUCCESS;
 }
 
@@ -150,6 +162,7 @@ static orcm_db_base_module_t *component_create(opal_list_t *props)
     /* assume default value first, then check for provided properties */
     mod->autocommit = autocommit;
     mod->tran_started = false;
+    mod->copy = copy;
 
     /* if the props include db info, then use it */
     if (NULL != props) {
@@ -166,6 +179,8 @@ static orcm_db_base_module_t *component_create(opal_list_t *props)
                 mod->user = strdup(kv->data.string);
             } else if (0 == strcmp(kv->key, "autocommit")) {
                 mod->autocommit = kv->data.flag;
+            } else if (0 == strcmp(kv->key, "copy")) {
+                mod->copy = kv->data.flag;
             }
         }
     }
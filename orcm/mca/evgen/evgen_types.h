@@ -235,6 +235,11 @@ OBJ_CLASS_DECLARATION(orcm_ras_event_t);
 #define ORCM_DESC_FLOW_LO           "orcm.desc.flo"     // low coolant flow rate (air or liquid)
 #define ORCM_DESC_PRESSURE_HI       "orcm.desc.phi"     // high coolant pressure (air or liquid)
 #define ORCM_DESC_PRESSURE_LO       "orcm.desc.plo"     // low coolant pressure (air or liquid)
+#define ORCM_DESC_LIMIT_HI          "orcm.desc.lhi"     // high limit crossed by a sensor reading
+#define ORCM_DESC_LIMIT_LO          "orcm.desc.llo"     // low limit crossed by a sensor reading
+#define ORCM_DESC_LIMIT_CLEAR       "orcm.desc.lclr"    // level a sensor reading returned within
+#define ORCM_DESC_ZSCORE            "orcm.desc.zscore"  // deviations of a sensor reading from its baseline
+#define ORCM_DESC_EXPECTED          "orcm.desc.expect"  // baseline a sensor reading was compared with
 
 END_C_DECLS
 
@@ -18,6 +18,8 @@
 #include "orcm_config.h"
 
 #include "opal/mca/mca.h"
+#include "opal/class/opal_bitmap.h"
+#include "opal/class/opal_hash_table.h"
 #include "opal/mca/event/event.h"
 #include "opal/dss/dss_types.h"
 #include "opal/util/output.h"
@@ -104,6 +106,17 @@ typedef struct {
     opal_list_t queues;
     /* node tracking */
     opal_pointer_array_t nodes;
+    /* index of the nodes by name and by daemon vpid */
+    opal_hash_table_t node_names;
+    opal_hash_table_t node_vpids;
+    /* nodes that are up, allocated, and free (up and unallocated),
+     * by position in the pool, with their counts */
+    opal_bitmap_t up_nodes;
+    opal_bitmap_t alloc_nodes;
+    opal_bitmap_t free_nodes;
+    int num_up_nodes;
+    int num_alloc_nodes;
+    int num_free_nodes;
     /* unique node topologies */
     opal_pointer_array_t topologies;
     /* track running allocations and number of nodes completed */
@@ -171,5 +184,30 @@ ORCM_DECLSPEC int orcm_scd_base_set_cluster_power_frequency(float frequency);
 ORCM_DECLSPEC bool orcm_scd_base_get_cluster_power_strict(void);
 ORCM_DECLSPEC int orcm_scd_base_set_cluster_power_strict(bool strict);
 
+/* node tracking - add a node to the pool and find nodes by name or by
+ * daemon vpid without walking the pool */
+ORCM_DECLSPEC int orcm_scd_base_add_node(orcm_node_t *node);
+ORCM_DECLSPEC orcm_node_t* orcm_scd_base_get_node_by_name(const char *name);
+ORCM_DECLSPEC orcm_node_t* orcm_scd_base_get_node_by_vpid(orte_vpid_t vpid);
+
+/* change the state or scheduling state of a node of the pool, keeping
+ * the node bitmaps and counts up to date */
+ORCM_DECLSPEC void orcm_scd_base_set_node_state(orcm_node_t *node,
+                                                orcm_node_state_t state);
+ORCM_DECLSPEC void orcm_scd_base_set_node_scd_state(orcm_node_t *node,
+                                                    orcm_scd_node_state_t state);
+
+/* pick num_nodes free nodes, preferring a contiguous run of the pool,
+ * and return them as a node regex */
+ORCM_DECLSPEC int orcm_scd_base_select_nodes(int num_nodes, char **regexp);
+
+/* call fn for each node name of a regex, in the order
+ * orte_regex_extract_node_names lists them, without building the
+ * list. The walk stops at the first error returned by fn */
+typedef int (*orcm_scd_base_node_fn_t)(const char *name, void *cbdata);
+ORCM_DECLSPEC int orcm_scd_base_walk_node_regex(const char *regexp,
+                                                orcm_scd_base_node_fn_t fn,
+                                                void *cbdata);
+
 END_C_DECLS
 #endif
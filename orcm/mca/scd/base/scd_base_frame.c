@@ -249,6 +249,11 @@ static int orcm_scd_base_close(void)
         }
     }
     OBJ_DESTRUCT(&orcm_scd_base.nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.node_names);
+    OBJ_DESTRUCT(&orcm_scd_base.node_vpids);
+    OBJ_DESTRUCT(&orcm_scd_base.up_nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.alloc_nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.free_nodes);
 
     /* give the selected plugin a chance to finalize */
     if (NULL != orcm_scd_base.module->finalize) {
@@ -275,6 +280,19 @@ static int orcm_scd_base_open(mca_base_open_flag_t flags)
     OBJ_CONSTRUCT(&orcm_scd_base.queues, opal_list_t);
     OBJ_CONSTRUCT(&orcm_scd_base.nodes, opal_pointer_array_t);
     opal_pointer_array_init(&orcm_scd_base.nodes, 8, INT_MAX, 8);
+    OBJ_CONSTRUCT(&orcm_scd_base.node_names, opal_hash_table_t);
+    opal_hash_table_init(&orcm_scd_base.node_names, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.node_vpids, opal_hash_table_t);
+    opal_hash_table_init(&orcm_scd_base.node_vpids, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.up_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.up_nodes, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.alloc_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.alloc_nodes, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.free_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.free_nodes, 1024);
+    orcm_scd_base.num_up_nodes = 0;
+    orcm_scd_base.num_alloc_nodes = 0;
+    orcm_scd_base.num_free_nodes = 0;
     OBJ_CONSTRUCT(&orcm_scd_base.topologies, opal_pointer_array_t);
     opal_pointer_array_init(&orcm_scd_base.topologies, 1, INT_MAX, 1);
     OBJ_CONSTRUCT(&orcm_scd_base.tracking, opal_list_t);
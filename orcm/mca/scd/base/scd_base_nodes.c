@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+#include "orcm/types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif  /* HAVE_STRING_H */
+
+#include "opal/class/opal_bitmap.h"
+#include "opal/class/opal_hash_table.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/util/name_fns.h"
+#include "orte/util/regex.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/scd/base/base.h"
+
+/*
+ * Node index
+ *
+ * The scheduler pool is kept in orcm_scd_base.nodes, and every node added
+ * through orcm_scd_base_add_node is also indexed by name and by daemon
+ * vpid so that the scheduler and the RM state machine can update the
+ * nodes of an allocation without comparing every name of the allocation
+ * against every node of the pool.
+ *
+ * The pool also keeps bitmaps of the nodes that are up, allocated and
+ * free, indexed by position in the pool, along with their counts. They
+ * are updated on every state change made through
+ * orcm_scd_base_set_node_state and orcm_scd_base_set_node_scd_state, so
+ * the scheduler knows how many nodes are free without walking the pool,
+ * and picks nodes by scanning the free bitmap a word at a time.
+ */
+
+/* longest node name the regex walk will generate */
+#define ORCM_SCD_NODE_NAME_MAX  1024
+
+#define ORCM_SCD_BITS_PER_WORD  64
+
+static void set_bit(opal_bitmap_t *bm, int *count, int bit, bool on)
+{
+    if (on == opal_bitmap_is_set_bit(bm, bit)) {
+        return;
+    }
+    if (on) {
+        opal_bitmap_set_bit(bm, bit);
+        (*count)++;
+    } else {
+        opal_bitmap_clear_bit(bm, bit);
+        (*count)--;
+    }
+}
+
+static void update_node_bits(orcm_node_t *node)
+{
+    bool up, alloc;
+
+    if (0 > node->scd_index) {
+        return;
+    }
+    /* TODO need to add logic for partially allocated nodes */
+    up = (ORCM_NODE_STATE_UP == node->state);
+    alloc = (ORCM_SCD_NODE_STATE_ALLOC == node->scd_state);
+    set_bit(&orcm_scd_base.up_nodes, &orcm_scd_base.num_up_nodes,
+            node->scd_index, up);
+    set_bit(&orcm_scd_base.alloc_nodes, &orcm_scd_base.num_alloc_nodes,
+            node->scd_index, alloc);
+    set_bit(&orcm_scd_base.free_nodes, &orcm_scd_base.num_free_nodes,
+            node->scd_index,
+            up && ORCM_SCD_NODE_STATE_UNALLOC == node->scd_state);
+}
+
+int orcm_scd_base_add_node(orcm_node_t *node)
+{
+    int rc;
+
+    if (0 > (node->scd_index = opal_pointer_array_add(&orcm_scd_base.nodes, node))) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    update_node_bits(node);
+    if (NULL != node->name &&
+        OPAL_SUCCESS != (rc = opal_hash_table_set_value_ptr(&orcm_scd_base.node_names,
+                                                            node->name, strlen(node->name),
+                                                            node))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    if (ORTE_VPID_INVALID != node->daemon.vpid &&
+        OPAL_SUCCESS != (rc = opal_hash_table_set_value_uint32(&orcm_scd_base.node_vpids,
+                                                               node->daemon.vpid, node))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    return ORCM_SUCCESS;
+}
+
+orcm_node_t* orcm_scd_base_get_node_by_name(const char *name)
+{
+    orcm_node_t *node;
+
+    if (NULL == name ||
+        OPAL_SUCCESS != opal_hash_table_get_value_ptr(&orcm_scd_base.node_names,
+                                                      name, strlen(name),
+                                                      (void**)&node)) {
+        return NULL;
+    }
+    return node;
+}
+
+orcm_node_t* orcm_scd_base_get_node_by_vpid(orte_vpid_t vpid)
+{
+    orcm_node_t *node;
+
+    if (OPAL_SUCCESS != opal_hash_table_get_value_uint32(&orcm_scd_base.node_vpids,
+                                                         vpid, (void**)&node)) {
+        return NULL;
+    }
+    return node;
+}
+
+void orcm_scd_base_set_node_state(orcm_node_t *node, orcm_node_state_t state)
+{
+    node->state = state;
+    update_node_bits(node);
+}
+
+void orcm_scd_base_set_node_scd_state(orcm_node_t *node,
+                                      orcm_scd_node_state_t state)
+{
+    node->scd_state = state;
+    update_node_bits(node);
+}
+
+static int add_node_name(char ***names, int index)
+{
+    orcm_node_t *node;
+
+    if (NULL == (node = (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
+                                                                  index)) ||
+        NULL == node->name) {
+        return ORCM_ERR_NOT_FOUND;
+    }
+    return opal_argv_append_nosize(names, node->name);
+}
+
+int orcm_scd_base_select_nodes(int num_nodes, char **regexp)
+{
+    opal_bitmap_t *bm = &orcm_scd_base.free_nodes;
+    uint64_t word;
+    char **names = NULL, *nodelist;
+    int w, b, bit, start = 0, run = 0, found = 0, rc;
+
+    *regexp = NULL;
+    if (0 >= num_nodes || orcm_scd_base.num_free_nodes < num_nodes) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+
+    /* look for a run of free nodes long enough for the whole
+     * allocation, skipping full and empty words */
+    for (w = 0; w < bm->array_size && run < num_nodes; w++) {
+        word = bm->bitmap[w];
+        if (0 == word) {
+            run = 0;
+            continue;
+        }
+        if (~((uint64_t)0) == word) {
+            if (0 == run) {
+                start = w * ORCM_SCD_BITS_PER_WORD;
+            }
+            run += ORCM_SCD_BITS_PER_WORD;
+            continue;
+        }
+        for (b = 0; b < ORCM_SCD_BITS_PER_WORD && run < num_nodes; b++) {
+            if (word & ((uint64_t)1 << b)) {
+                if (0 == run) {
+                    start = w * ORCM_SCD_BITS_PER_WORD + b;
+                }
+                run++;
+            } else {
+                run = 0;
+            }
+        }
+    }
+
+    if (num_nodes <= run) {
+        for (bit = start; bit < start + num_nodes; bit++) {
+            if (ORCM_SUCCESS != (rc = add_node_name(&names, bit))) {
+                goto cleanup;
+            }
+        }
+    } else {
+        /* no such run - take the first free nodes of the pool,
+         * which still keeps whatever runs there are together */
+        for (w = 0; w < bm->array_size && found < num_nodes; w++) {
+            if (0 == (word = bm->bitmap[w])) {
+                continue;
+            }
+            for (b = 0; b < ORCM_SCD_BITS_PER_WORD && found < num_nodes; b++) {
+                if (word & ((uint64_t)1 << b)) {
+                    if (ORCM_SUCCESS !=
+                        (rc = add_node_name(&names, w * ORCM_SCD_BITS_PER_WORD + b))) {
+                        goto cleanup;
+                    }
+                    found++;
+                }
+            }
+        }
+    }
+
+    nodelist = opal_argv_join(names, ',');
+    rc = orte_regex_create(nodelist, regexp);
+    free(nodelist);
+
+cleanup:
+    opal_argv_free(names);
+    return rc;
+}
+
+/* the regex grammar is the one of orte_regex_create:
+ *
+ *    name[,name...]
+ *
+ * where each name is either a plain node name or
+ *
+ *    prefix[ndigits:range[,range...]]suffix
+ *
+ * and each range is either a number or first-last. Numbers are
+ * zero-padded to ndigits */
+int orcm_scd_base_walk_node_regex(const char *regexp,
+                                  orcm_scd_base_node_fn_t fn,
+                                  void *cbdata)
+{
+    char name[ORCM_SCD_NODE_NAME_MAX];
+    const char *p, *base, *ranges, *rend, *suffix, *r;
+    char *end;
+    size_t blen, slen;
+    unsigned long first, last, n;
+    int ndigits, len, rc;
+
+    if (NULL == regexp) {
+        return ORCM_SUCCESS;
+    }
+
+    p = regexp;
+    while ('\0' != *p) {
+        /* find the end of the prefix */
+        base = p;
+        while ('\0' != *p && '[' != *p && ',' != *p) {
+            p++;
+        }
+        blen = p - base;
+        /* numeric names have no prefix, as in [3:1-10] */
+        if ((0 == blen && '[' != *p) || ORCM_SCD_NODE_NAME_MAX <= blen) {
+            return ORCM_ERR_BAD_PARAM;
+        }
+        memcpy(name, base, blen);
+
+        if ('[' != *p) {
+            /* a single node */
+            name[blen] = '\0';
+            if (ORCM_SUCCESS != (rc = fn(name, cbdata))) {
+                return rc;
+            }
+            if (',' == *p) {
+                p++;
+            }
+            continue;
+        }
+
+        /* number of digits */
+        p++;
+        ndigits = (int)strtol(p, &end, 10);
+        if (end == p || ':' != *end) {
+            return ORCM_ERR_BAD_PARAM;
+        }
+        ranges = end + 1;
+        if (NULL == (rend = strchr(ranges, ']'))) {
+            return ORCM_ERR_BAD_PARAM;
+        }
+        /* suffix, up to the next node */
+        suffix = rend + 1;
+        for (p = suffix; '\0' != *p && ',' != *p; p++);
+        slen = p - suffix;
+        if (',' == *p) {
+            p++;
+        }
+
+        for (r = ranges; r < rend; ) {
+            first = strtoul(r, &end, 10);
+            if (end == r) {
+                return ORCM_ERR_BAD_PARAM;
+            }
+            last = first;
+            if ('-' == *end) {
+                r = end + 1;
+                last = strtoul(r, &end, 10);
+                if (end == r) {
+                    return ORCM_ERR_BAD_PARAM;
+                }
+            }
+            for (n = first; n <= last; n++) {
+                len = snprintf(name + blen, sizeof(name) - blen, "%0*lu", ndigits, n);
+                if (len < 0 || sizeof(name) <= blen + len + slen) {
+                    return ORCM_ERR_BAD_PARAM;
+                }
+                memcpy(name + blen + len, suffix, slen);
+                name[blen + len + slen] = '\0';
+                if (ORCM_SUCCESS != (rc = fn(name, cbdata))) {
+                    return rc;
+                }
+            }
+            r = end;
+            if (',' == *r) {
+                r++;
+            } else if (r != rend) {
+                return ORCM_ERR_BAD_PARAM;
+            }
+        }
+    }
+    return ORCM_SUCCESS;
+}
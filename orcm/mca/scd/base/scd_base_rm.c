@@ -80,234 +80,164 @@ static void scd_base_rm_undef(int sd, short args, void *cbdata)
 
 static void scd_base_rm_request(int sd, short args, void *cbdata)
 {
-    orcm_node_t *nodeptr;
     orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
-    int i, rc, num_nodes;
-    char *nodelist = NULL;
+    int rc, num_nodes;
     char *noderegex = NULL;
 
     num_nodes = caddy->session->alloc->min_nodes;
 
     if (0 < num_nodes) {
-        for (i = 0; i < orcm_scd_base.nodes.size; i++) {
-            if (NULL ==
-                (nodeptr =
-                 (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
-                                                           i))) {
-                continue;
-            }
-            if (ORCM_SCD_NODE_STATE_UNALLOC == nodeptr->scd_state
-                && ORCM_NODE_STATE_UP == nodeptr->state) {
-                OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
-                                     "%s scd:rm:request adding node %s to list",
-                                     ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                     nodeptr->name));
-                if (NULL != nodelist) {
-                    asprintf(&nodelist, "%s,%s", nodelist, nodeptr->name);
-                } else {
-                    asprintf(&nodelist, "%s", nodeptr->name);
-                }
-                num_nodes--;
-                if (0 == num_nodes) {
-                    break;
-                }
-            }
+        if (ORCM_SUCCESS != (rc = orcm_scd_base_select_nodes(num_nodes, &noderegex))) {
+            /* not enough nodes found, or the regex could not be built */
+            ORTE_ERROR_LOG(rc);
+            caddy->session->alloc->nodes = strdup("ERROR");
+        } else {
+            caddy->session->alloc->nodes = noderegex;
         }
 
-        OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
-                             "%s scd:rm:request giving allocation %i nodelist %s",
-                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                             (int)caddy->session->alloc->id,
-                             nodelist));
-
-        if (0 == num_nodes) {
-            if (ORTE_SUCCESS != (rc = orte_regex_create(nodelist, &noderegex))) {
-                ORTE_ERROR_LOG(rc);
-                caddy->session->alloc->nodes = strdup("ERROR");
-            } else {
-                caddy->session->alloc->nodes = noderegex;
-            }
-        } /* else, error? not enough nodes found? */
-
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
                              "%s scd:rm:request giving allocation %i noderegex %s",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              (int)caddy->session->alloc->id,
-                             noderegex));
+                             caddy->session->alloc->nodes));
 
         ORCM_ACTIVATE_SCD_STATE(caddy->session, ORCM_SESSION_STATE_ALLOCD);
-
-        if(nodelist != NULL) {
-            free(nodelist);
-        }
     } /* else, error? no nodes requested */
 
     OBJ_RELEASE(caddy);
 }
 
-static void scd_base_rm_active(int sd, short args, void *cbdata)
+/* send an RM command for the allocation of a session to each of its
+ * nodes, up to the number of nodes requested */
+typedef struct {
+    orcm_session_caddy_t *caddy;
+    orcm_rm_cmd_flag_t command;
+    int nnodes;
+} rm_send_t;
+
+static int send_to_node(const char *name, void *cbdata)
 {
-    orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
-    char **nodenames = NULL;
-    int rc, i, j;
+    rm_send_t *req = (rm_send_t*)cbdata;
     orcm_node_t *nodeptr;
     opal_buffer_t *buf;
-    orcm_rm_cmd_flag_t command = ORCM_LAUNCH_STEPD_COMMAND;
-    orcm_alloc_tracker_t *trk;
+    int rc;
+
+    if (req->caddy->session->alloc->min_nodes <= req->nnodes) {
+        return ORCM_SUCCESS;
+    }
+    if (ORCM_LAUNCH_STEPD_COMMAND == req->command && 0 == req->nnodes) {
+        /* set hnp name to first in the list */
+        req->caddy->session->alloc->hnpname = strdup(name);
+    }
+    req->nnodes++;
 
+    if (NULL == (nodeptr = orcm_scd_base_get_node_by_name(name))) {
+        return ORCM_SUCCESS;
+    }
+    if (ORCM_LAUNCH_STEPD_COMMAND == req->command && 1 == req->nnodes) {
+        /* if this is the first node in the list,
+         * then set the hnp daemon info */
+        req->caddy->session->alloc->hnp.jobid = nodeptr->daemon.jobid;
+        req->caddy->session->alloc->hnp.vpid = nodeptr->daemon.vpid;
+    }
+    buf = OBJ_NEW(opal_buffer_t);
+    /* pack the command */
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &req->command,
+                                            1, ORCM_RM_CMD_T))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buf);
+        return rc;
+    }
+    /* pack the allocation info */
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf,
+                                            &req->caddy->session->alloc,
+                                            1, ORCM_ALLOC))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buf);
+        return rc;
+    }
+    /* SEND ALLOC TO NODE */
     if (ORTE_SUCCESS !=
-        (rc = orte_regex_extract_node_names(caddy->session->alloc->nodes,
-                                            &nodenames))) {
+        (rc = orte_rml.send_buffer_nb(&nodeptr->daemon, buf,
+                                      ORCM_RML_TAG_RM,
+                                      orte_rml_send_callback,
+                                      NULL))) {
+        ORTE_ERROR_LOG(rc);
+        OBJ_RELEASE(buf);
+        return rc;
+    }
+    return ORCM_SUCCESS;
+}
+
+static void scd_base_rm_active(int sd, short args, void *cbdata)
+{
+    orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
+    orcm_alloc_tracker_t *trk;
+    rm_send_t req;
+    int rc;
+
+    trk = OBJ_NEW(orcm_alloc_tracker_t);
+    trk->alloc_id = caddy->session->id;
+    opal_list_append(&orcm_scd_base.tracking, &trk->super);
+
+    req.caddy = caddy;
+    req.command = ORCM_LAUNCH_STEPD_COMMAND;
+    req.nnodes = 0;
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(caddy->session->alloc->nodes,
+                                            send_to_node, &req))) {
         ORTE_ERROR_LOG(rc);
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
-                             "%s scd:rm:active - (session: %d) could not extract nodelist\n",
+                             "%s scd:rm:active - (session: %d) could not launch on nodelist\n",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              caddy->session->id));
-        if (NULL != nodenames) {
-            opal_argv_free(nodenames);
-        }
+        opal_list_remove_item(&orcm_scd_base.tracking, &trk->super);
+        OBJ_RELEASE(trk);
+        OBJ_RELEASE(caddy);
         return;
     }
-
-    /* set hnp name to first in the list */
-    if (NULL != nodenames) {
-        caddy->session->alloc->hnpname = strdup(nodenames[0]);
-    } else {
+    if (0 == req.nnodes) {
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
                              "%s scd:rm:active - (session: %d) got NULL nodelist\n",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              caddy->session->id));
+        opal_list_remove_item(&orcm_scd_base.tracking, &trk->super);
+        OBJ_RELEASE(trk);
+        OBJ_RELEASE(caddy);
         return;
     }
-    
-    trk = OBJ_NEW(orcm_alloc_tracker_t);
-    trk->alloc_id = caddy->session->id;
-    opal_list_append(&orcm_scd_base.tracking, &trk->super);
 
-    /* node array should be indexed by node num,
-     * if we change to lookup by index that would be faster */
-    for (i = 0; i < caddy->session->alloc->min_nodes; i++) {
-        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
-            if (NULL ==
-                (nodeptr =
-                 (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
-                                                           j))) {
-                continue;
-            }
-            if (0 == strcmp(nodeptr->name, nodenames[i])) {
-                if (0 == i) {
-                    /* if this is the first node in the list, 
-                     * then set the hnp daemon info */
-                    caddy->session->alloc->hnp.jobid = nodeptr->daemon.jobid;
-                    caddy->session->alloc->hnp.vpid = nodeptr->daemon.vpid;
-                }
-                buf = OBJ_NEW(opal_buffer_t);
-                /* pack the command */
-                if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &command,
-                                                        1, ORCM_RM_CMD_T))) {
-                    ORTE_ERROR_LOG(rc);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-                /* pack the allocation info */
-                if (OPAL_SUCCESS != (rc = opal_dss.pack(buf,
-                                                        &caddy->session->alloc,
-                                                        1, ORCM_ALLOC))) {
-                    ORTE_ERROR_LOG(rc);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-                /* SEND ALLOC TO NODE */
-                if (ORTE_SUCCESS !=
-                    (rc = orte_rml.send_buffer_nb(&nodeptr->daemon, buf,
-                                                  ORCM_RML_TAG_RM,
-                                                  orte_rml_send_callback,
-                                                  NULL))) {
-                    ORTE_ERROR_LOG(rc);
-                    OBJ_RELEASE(buf);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-            }
-        }
-    }
-
-    opal_argv_free(nodenames);
     OBJ_RELEASE(caddy);
 }
 
 static void scd_base_rm_kill(int sd, short args, void *cbdata)
 {
     orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
-    char **nodenames = NULL;
-    int rc, i, j;
-    orcm_node_t *nodeptr;
-    opal_buffer_t *buf;
-    orcm_rm_cmd_flag_t command = ORCM_CANCEL_STEPD_COMMAND;
-
-    if (ORTE_SUCCESS !=
-        (rc = orte_regex_extract_node_names(caddy->session->alloc->nodes,
-                                            &nodenames))) {
+    rm_send_t req;
+    int rc;
+
+    req.caddy = caddy;
+    req.command = ORCM_CANCEL_STEPD_COMMAND;
+    req.nnodes = 0;
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(caddy->session->alloc->nodes,
+                                            send_to_node, &req))) {
         ORTE_ERROR_LOG(rc);
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
-                             "%s scd:rm:kill - (session: %d) could not extract nodelist\n",
+                             "%s scd:rm:kill - (session: %d) could not cancel on nodelist\n",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              caddy->session->id));
-        if (NULL != nodenames) {
-            opal_argv_free(nodenames);
-        }
+        OBJ_RELEASE(caddy);
         return;
     }
-    if (NULL == nodenames) {
+    if (0 == req.nnodes) {
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
                              "%s scd:rm:kill - (session: %d) got NULL nodelist\n",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              caddy->session->id));
+        OBJ_RELEASE(caddy);
         return;
     }
 
-    /* node array should be indexed by node num,
-     * if we change to lookup by index that would be faster */
-    for (i = 0; i < caddy->session->alloc->min_nodes; i++) {
-        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
-            if (NULL ==
-                (nodeptr =
-                 (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
-                                                           j))) {
-                continue;
-            }
-            if (0 == strcmp(nodeptr->name, nodenames[i])) {
-                buf = OBJ_NEW(opal_buffer_t);
-                /* pack the command */
-                if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &command,
-                                                        1, ORCM_RM_CMD_T))) {
-                    ORTE_ERROR_LOG(rc);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-                /* pack the alloc so that nodes know which session to kill */
-                if (OPAL_SUCCESS != (rc = opal_dss.pack(buf,
-                                                        &caddy->session->alloc,
-                                                        1, ORCM_ALLOC))) {
-                    ORTE_ERROR_LOG(rc);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-                /* SEND ALLOC TO NODE */
-                if (ORTE_SUCCESS !=
-                    (rc = orte_rml.send_buffer_nb(&nodeptr->daemon, buf,
-                                                  ORCM_RML_TAG_RM,
-                                                  orte_rml_send_callback,
-                                                  NULL))) {
-                    ORTE_ERROR_LOG(rc);
-                    OBJ_RELEASE(buf);
-                    opal_argv_free(nodenames);
-                    return;
-                }
-            }
-        }
-    }
-
-    opal_argv_free(nodenames);
     OBJ_RELEASE(caddy);
 }
@@ -353,9 +353,27 @@ static void orcm_scd_base_rm_recv(int status, orte_process_name_t* sender,
     return;
 }
 
+static void set_nodestate(orcm_node_t *nodeptr, orcm_node_state_t state,
+                          orcm_node_state_t newstate, hwloc_topology_t topo)
+{
+    /* associate node topology with node */
+    if (ORCM_NODE_STATE_UP == state) {
+        nodeptr->topology = topo;
+    }
+
+    /* if the node is coming online, reset the scheduling state
+     only if its either undefined or unknown */
+    if ((ORCM_NODE_STATE_UP == state) &&
+        ((ORCM_SCD_NODE_STATE_UNDEF == nodeptr->scd_state) ||
+         (ORCM_SCD_NODE_STATE_UNKNOWN == nodeptr->scd_state))) {
+            nodeptr->scd_state = ORCM_SCD_NODE_STATE_UNALLOC;
+        }
+
+    orcm_scd_base_set_node_state(nodeptr, newstate);
+}
+
 static int update_nodestate_byproc(orcm_node_state_t state, opal_list_t *nodelist, hwloc_topology_t topo)
 {
-    int i;
     orcm_node_t *nodeptr;
     orte_namelist_t *n;
     bool found;
@@ -363,38 +381,20 @@ static int update_nodestate_byproc(orcm_node_state_t state, opal_list_t *nodelis
     /* set each node to state */
     found = false;
     OPAL_LIST_FOREACH(n, nodelist, orte_namelist_t) {
-        for (i = 0; i < orcm_scd_base.nodes.size; i++) {
-            if (NULL == (nodeptr =
-                         (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
-                                                                   i))) {
-                             continue;
-                         }
-            if (OPAL_EQUAL == orte_util_compare_name_fields(ORTE_NS_CMP_ALL,
-                                                            &nodeptr->daemon,
-                                                            &n->name)) {
-                OPAL_OUTPUT_VERBOSE((1, orcm_scd_base_framework.framework_output,
-                                     "%s scd:base:rm:update_nodestate_byproc Setting node %s to state %i (%s)",
-                                     ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                     ORTE_NAME_PRINT(&n->name),
-                                     (int)state,
-                                     orcm_node_state_to_str(state)));
-                found = true;
-                nodeptr->state = state;
-                
-                /* associate node topology with node */
-                if (ORCM_NODE_STATE_UP == state) {
-                    nodeptr->topology = topo;
-                }
-                
-                /* if the node is coming online, reset the scheduling state
-                 only if its either undefined or unknown */
-                if ((ORCM_NODE_STATE_UP == state) &&
-                    ((ORCM_SCD_NODE_STATE_UNDEF == nodeptr->scd_state) ||
-                     (ORCM_SCD_NODE_STATE_UNKNOWN == nodeptr->scd_state))) {
-                        nodeptr->scd_state = ORCM_SCD_NODE_STATE_UNALLOC;
-                    }
-                break;
-            }
+        if (NULL == (nodeptr = orcm_scd_base_get_node_by_vpid(n->name.vpid))) {
+            continue;
+        }
+        if (OPAL_EQUAL == orte_util_compare_name_fields(ORTE_NS_CMP_ALL,
+                                                        &nodeptr->daemon,
+                                                        &n->name)) {
+            OPAL_OUTPUT_VERBOSE((1, orcm_scd_base_framework.framework_output,
+                                 "%s scd:base:rm:update_nodestate_byproc Setting node %s to state %i (%s)",
+                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                 ORTE_NAME_PRINT(&n->name),
+                                 (int)state,
+                                 orcm_node_state_to_str(state)));
+            found = true;
+            set_nodestate(nodeptr, state, state, topo);
         }
     }
     
@@ -410,62 +410,52 @@ static int update_nodestate_byproc(orcm_node_state_t state, opal_list_t *nodelis
     return ORCM_SUCCESS;
 }
 
-static int update_nodestate_byname(orcm_node_state_t state, char *regexp, hwloc_topology_t topo)
+typedef struct {
+    orcm_node_state_t state;
+    orcm_node_state_t newstate;
+    hwloc_topology_t topo;
+    bool found;
+} nodestate_update_t;
+
+static int update_nodestate(const char *name, void *cbdata)
 {
-    int cnt, i, j, rc;
+    nodestate_update_t *upd = (nodestate_update_t*)cbdata;
     orcm_node_t *nodeptr;
-    char **nodenames = NULL;
-    bool found = false;
-    orcm_node_state_t newstate;
-    
+
+    if (NULL == (nodeptr = orcm_scd_base_get_node_by_name(name))) {
+        return ORCM_SUCCESS;
+    }
+    OPAL_OUTPUT_VERBOSE((1, orcm_scd_base_framework.framework_output,
+                         "%s scd:base:rm:update_nodestate_byname Setting node %s to state %i (%s)",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                         ORTE_NAME_PRINT(&nodeptr->daemon),
+                         (int)upd->state,
+                         orcm_node_state_to_str(upd->state)));
+    upd->found = true;
+    set_nodestate(nodeptr, upd->state, upd->newstate, upd->topo);
+    return ORCM_SUCCESS;
+}
+
+static int update_nodestate_byname(orcm_node_state_t state, char *regexp, hwloc_topology_t topo)
+{
+    nodestate_update_t upd;
+    int rc;
+
+    upd.state = state;
     if (ORCM_NODE_STATE_RESUME == state) {
-        newstate = ORCM_NODE_STATE_UP;
+        upd.newstate = ORCM_NODE_STATE_UP;
     } else {
-        newstate = state;
+        upd.newstate = state;
     }
-    
-    if (ORTE_SUCCESS !=
-        (rc = orte_regex_extract_node_names(regexp, &nodenames))) {
+    upd.topo = topo;
+    upd.found = false;
+
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(regexp, update_nodestate, &upd))) {
         ORTE_ERROR_LOG(rc);
-        opal_argv_free(nodenames);
         return rc;
     }
-    cnt = opal_argv_count(nodenames);
-    for (i = 0; i < cnt; i++) {
-        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
-            if (NULL == (nodeptr =
-                         (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes,
-                                                                   j))) {
-                             continue;
-                         }
-            if (0 == strcmp(nodeptr->name, nodenames[i])) {
-                OPAL_OUTPUT_VERBOSE((1, orcm_scd_base_framework.framework_output,
-                                     "%s scd:base:rm:update_nodestate_byname Setting node %s to state %i (%s)",
-                                     ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                     ORTE_NAME_PRINT(&nodeptr->daemon),
-                                     (int)state,
-                                     orcm_node_state_to_str(state)));
-                found = true;
-                nodeptr->state = newstate;
-                
-                /* associate node topology with node */
-                if (ORCM_NODE_STATE_UP == state) {
-                    nodeptr->topology = topo;
-                }
-                
-                /* if the node is coming online, reset the scheduling state
-                 only if its either undefined or unknown */
-                if ((ORCM_NODE_STATE_UP == state) &&
-                    ((ORCM_SCD_NODE_STATE_UNDEF == nodeptr->scd_state) ||
-                     (ORCM_SCD_NODE_STATE_UNKNOWN == nodeptr->scd_state))) {
-                        nodeptr->scd_state = ORCM_SCD_NODE_STATE_UNALLOC;
-                    }
-                break;
-            }
-        }
-    }
-    opal_argv_free(nodenames);
-    if (!found) {
+    if (!upd.found) {
         OPAL_OUTPUT_VERBOSE((1, orcm_scd_base_framework.framework_output,
                              "%s scd:base:rm:update_nodestate_byname Couldn't find node(s) to update state %i (%s)",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
@@ -34,6 +34,8 @@ static void pmf_schedule(int sd, short args, void *cbdata);
 static void pmf_allocated(int sd, short args, void *cbdata);
 static void pmf_terminated(int sd, short args, void *cbdata);
 static void pmf_cancel(int sd, short args, void *cbdata);
+static int count_node(const char *name, void *cbdata);
+static int set_node_state(const char *name, void *cbdata);
 
 static orcm_scd_session_state_t states[] = {
     ORCM_SESSION_STATE_UNDEF,
@@ -174,8 +176,7 @@ static void pmf_schedule(int sd, short args, void *cbdata)
 {
     orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
     orcm_session_t *sessionptr;
-    orcm_node_t* nodeptr;
-    int i, free_nodes;
+    int free_nodes;
 
     orcm_queue_t *q;
 
@@ -205,20 +206,8 @@ static void pmf_schedule(int sd, short args, void *cbdata)
             }
 
             /* find out how many nodes are available */
-            free_nodes = 0;
-            for (i = 0; i < orcm_scd_base.nodes.size; i++) {
-                if (NULL ==
-                    (nodeptr =
-                     (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, i))) {
-                    continue;
-                }
-                /* TODO need to add logic for partially allocated nodes */
-                /* TODO check for other constraints, but how? */
-                if (ORCM_SCD_NODE_STATE_UNALLOC == nodeptr->scd_state
-                    && ORCM_NODE_STATE_UP == nodeptr->state) {
-                    free_nodes++;
-                }
-            }
+            /* TODO check for other constraints, but how? */
+            free_nodes = orcm_scd_base.num_free_nodes;
 
             /* if there are enough nodes to meet job requirement, allocate them */
             if (sessionptr->alloc->min_nodes <= free_nodes) {
@@ -244,9 +233,8 @@ static void pmf_schedule(int sd, short args, void *cbdata)
 static void pmf_allocated(int sd, short args, void *cbdata)
 {
     orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
-    char **nodenames = NULL;
-    int rc, num_nodes, i, j;
-    orcm_node_t *nodeptr;
+    int rc, num_nodes = 0;
+    orcm_scd_node_state_t state = ORCM_SCD_NODE_STATE_ALLOC;
     orcm_queue_t *q;
 
     OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
@@ -276,9 +264,9 @@ static void pmf_allocated(int sd, short args, void *cbdata)
 
     /* set nodes to ALLOC
     */
-    if (ORTE_SUCCESS !=
-        (rc = orte_regex_extract_node_names(caddy->session->alloc->nodes,
-                                            &nodenames))) {
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(caddy->session->alloc->nodes,
+                                            count_node, &num_nodes))) {
         ORTE_ERROR_LOG(rc);
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
                              "%s scd:pmf:allocated - (session: %d) could not extract nodelist\n",
@@ -287,7 +275,6 @@ static void pmf_allocated(int sd, short args, void *cbdata)
         goto ERROR;
     }
 
-    num_nodes = opal_argv_count(nodenames);
     if (num_nodes != caddy->session->alloc->min_nodes) {
         /* what happened? we didn't get all of the nodes we needed? */
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
@@ -299,32 +286,21 @@ static void pmf_allocated(int sd, short args, void *cbdata)
         goto ERROR;
     }
 
-    /* node array should be indexed by node num,
-     * if we change to lookup by index that would be faster
-     */
-    for (i = 0; i < num_nodes; i++) {
-        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
-            if (NULL == (nodeptr =
-                         (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, j))) {
-                continue;
-            }
-            if (0 == strcmp(nodeptr->name, nodenames[i])) {
-                nodeptr->scd_state = ORCM_SCD_NODE_STATE_ALLOC;
-            }
-        }
-    }
-
-    if (NULL != nodenames) {
-        opal_argv_free(nodenames);
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(caddy->session->alloc->nodes,
+                                            set_node_state, &state))) {
+        ORTE_ERROR_LOG(rc);
+        OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
+                             "%s scd:pmf:allocated - (session: %d) could not set the state of the nodes\n",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                             caddy->session->id));
+        goto ERROR;
     }
 
     OBJ_RELEASE(caddy);
     return;
 
 ERROR:
-    if (NULL != nodenames) {
-        opal_argv_free(nodenames);
-    }
     /* remove session from running queue
      */
     OPAL_LIST_FOREACH(q, &orcm_scd_base.queues, orcm_queue_t) {
@@ -347,47 +323,24 @@ ERROR:
 static void pmf_terminated(int sd, short args, void *cbdata)
 {
     orcm_session_caddy_t *caddy = (orcm_session_caddy_t*)cbdata;
-    int rc, i, j, num_nodes;
-    orcm_node_t* nodeptr;
-    char **nodenames = NULL;
+    int rc;
+    orcm_scd_node_state_t state = ORCM_SCD_NODE_STATE_UNALLOC;
     orcm_queue_t *q;
     orcm_session_t *session;
 
     /* set nodes to UNALLOC
     */
-    if (ORTE_SUCCESS !=
-        (rc = orte_regex_extract_node_names(caddy->session->alloc->nodes,
-                                            &nodenames))) {
+    if (ORCM_SUCCESS !=
+        (rc = orcm_scd_base_walk_node_regex(caddy->session->alloc->nodes,
+                                            set_node_state, &state))) {
         ORTE_ERROR_LOG(rc);
         OPAL_OUTPUT_VERBOSE((5, orcm_scd_base_framework.framework_output,
                              "%s scd:pmf:terminated - (session: %d) could not extract nodelist\n",
                              ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                              caddy->session->id));
-
-        if (NULL != nodenames) {
-            opal_argv_free(nodenames);
-        }
-
         return;
     }
 
-    num_nodes = opal_argv_count(nodenames);
-
-    /* node array should be indexed by node num,
-     * if we change to lookup by index that would be faster
-     */
-    for (i = 0; i < num_nodes; i++) {
-        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
-            if (NULL == (nodeptr =
-                         (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, j))) {
-                continue;
-            }
-            if (0 == strcmp(nodeptr->name, nodenames[i])) {
-                nodeptr->scd_state = ORCM_SCD_NODE_STATE_UNALLOC;
-            }
-        }
-    }
-
     OPAL_LIST_FOREACH(q, &orcm_scd_base.queues, orcm_queue_t) {
         if (0 == strcmp(q->name, "running")) {
             OPAL_LIST_FOREACH(session, &q->sessions, orcm_session_t) {
@@ -402,9 +355,6 @@ static void pmf_terminated(int sd, short args, void *cbdata)
     ORCM_ACTIVATE_SCD_STATE(caddy->session, ORCM_SESSION_STATE_SCHEDULE);
 
     OBJ_RELEASE(caddy);
-    if (NULL != nodenames) {
-        opal_argv_free(nodenames);
-    }
 }
 
 static void pmf_cancel(int sd, short args, void *cbdata)
@@ -431,3 +381,22 @@ static void pmf_cancel(int sd, short args, void *cbdata)
 
     OBJ_RELEASE(caddy);
 }
+
+static int count_node(const char *name, void *cbdata)
+{
+    int *count = (int*)cbdata;
+
+    (*count)++;
+    return ORCM_SUCCESS;
+}
+
+static int set_node_state(const char *name, void *cbdata)
+{
+    orcm_scd_node_state_t *state = (orcm_scd_node_state_t*)cbdata;
+    orcm_node_t *nodeptr;
+
+    if (NULL != (nodeptr = orcm_scd_base_get_node_by_name(name))) {
+        orcm_scd_base_set_node_scd_state(nodeptr, *state);
+    }
+    return ORCM_SUCCESS;
+}
@@ -0,0 +1,976 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#include <math.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif  /* HAVE_STRING_H */
+
+#include "opal_stdint.h"
+#include "opal/class/opal_list.h"
+#include "opal/dss/dss.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/mca/db/db.h"
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+/*
+ * Compact sample encoding
+ *
+ * Most samplers report the same set of labelled values every interval,
+ * so packing the component name, hostname and labels with each sample
+ * wastes most of the heartbeat and most of the unpack time at the
+ * aggregator. A component supporting it instead registers the schema of
+ * its samples once, and packs each sample as:
+ *
+ *    ORCM_SENSOR_BASE_COMPACT   (string)
+ *    schema id                  (uint16)
+ *    flags                      (uint8)
+ *    [schema]                   (only if flags has COMPACT_HAS_SCHEMA)
+ *    sample time                (timeval)
+ *    values                     (nitems values of the schema type)
+ *
+ * Floating point values are sent as the integer of the same width holding
+ * their IEEE-754 representation since the DSS packs floats as strings.
+ *
+ * The schema is included with the first sample and then every
+ * sensor_base_schema_refresh samples so that a restarted aggregator can
+ * pick up the dictionary again. Receivers key the schemas by the vpid of
+ * the sender and the schema id. Ids are never reused by a process, so a
+ * receiver that missed the announcement of a new schema drops its samples
+ * instead of decoding them with the layout of a deregistered one. A
+ * schema announced with a different layout than the one held for its id
+ * means the sender restarted, and all its schemas are then forgotten.
+ *
+ * Sensors listed in sensor_base_change_only only report the values that
+ * changed by more than their epsilon since they were last reported:
+ * the values are then preceded by a bitmap of the reported values and
+ * flags has COMPACT_DELTA. Nothing is sent if no value changed. All
+ * values are still reported every interval samples and with the schema,
+ * and the receiver carries the values it last received forward so that
+ * the loggers always see a complete sample.
+ *
+ * A value the sensor could not read is sent as NaN, keeping its place in
+ * the schema, so the schema only changes when the set of items does.
+ * Going from or to NaN always counts as a change.
+ *
+ * The samples of sensors listed in sensor_base_ring are kept in a ring
+ * on the node instead (see sensor_base_ring.c), and each heartbeat only
+ * carries a summary of the samples taken since the previous one: flags
+ * has COMPACT_SUMMARY, and the sample time is followed by the number of
+ * samples and the min, max and average of each value. The average is
+ * passed to the sensor for logging and the base stores the min and max.
+ */
+
+#define COMPACT_HAS_SCHEMA  0x01
+#define COMPACT_DELTA       0x02
+#define COMPACT_SUMMARY     0x04
+
+/* scratch space for the values being unpacked - only accessed from the
+ * event base receiving the heartbeats */
+static void *values_buf = NULL;
+static size_t values_buf_size = 0;
+
+size_t orcm_sensor_base_type_size(opal_data_type_t type)
+{
+    switch (type) {
+    case OPAL_FLOAT:
+        return sizeof(float);
+    case OPAL_DOUBLE:
+        return sizeof(double);
+    case OPAL_INT16:
+    case OPAL_UINT16:
+        return sizeof(int16_t);
+    case OPAL_INT32:
+    case OPAL_UINT32:
+        return sizeof(int32_t);
+    case OPAL_INT64:
+    case OPAL_UINT64:
+        return sizeof(int64_t);
+    default:
+        return 0;
+    }
+}
+
+/* type the values are packed as */
+static opal_data_type_t wire_type(opal_data_type_t type)
+{
+    switch (type) {
+    case OPAL_FLOAT:
+        return OPAL_UINT32;
+    case OPAL_DOUBLE:
+        return OPAL_UINT64;
+    default:
+        return type;
+    }
+}
+
+double orcm_sensor_base_value_at(opal_data_type_t type, void *values, int32_t i)
+{
+    switch (type) {
+    case OPAL_FLOAT:
+        return ((float*)values)[i];
+    case OPAL_DOUBLE:
+        return ((double*)values)[i];
+    case OPAL_INT16:
+        return ((int16_t*)values)[i];
+    case OPAL_UINT16:
+        return ((uint16_t*)values)[i];
+    case OPAL_INT32:
+        return ((int32_t*)values)[i];
+    case OPAL_UINT32:
+        return ((uint32_t*)values)[i];
+    case OPAL_INT64:
+        return (double)((int64_t*)values)[i];
+    case OPAL_UINT64:
+        return (double)((uint64_t*)values)[i];
+    default:
+        return 0.0;
+    }
+}
+
+void orcm_sensor_base_set_value(opal_data_type_t type, void *values, int32_t i, double val)
+{
+    switch (type) {
+    case OPAL_FLOAT:
+        ((float*)values)[i] = (float)val;
+        break;
+    case OPAL_DOUBLE:
+        ((double*)values)[i] = val;
+        break;
+    case OPAL_INT16:
+        ((int16_t*)values)[i] = (int16_t)val;
+        break;
+    case OPAL_UINT16:
+        ((uint16_t*)values)[i] = (uint16_t)val;
+        break;
+    case OPAL_INT32:
+        ((int32_t*)values)[i] = (int32_t)val;
+        break;
+    case OPAL_UINT32:
+        ((uint32_t*)values)[i] = (uint32_t)val;
+        break;
+    case OPAL_INT64:
+        ((int64_t*)values)[i] = (int64_t)val;
+        break;
+    case OPAL_UINT64:
+        ((uint64_t*)values)[i] = (uint64_t)val;
+        break;
+    default:
+        break;
+    }
+}
+
+/* allocate the storage for change-only reporting on either side */
+static int alloc_last(orcm_sensor_schema_t *schema)
+{
+    size_t sz = (size_t)schema->nitems * orcm_sensor_base_type_size(schema->type);
+
+    if (NULL != schema->last) {
+        return ORCM_SUCCESS;
+    }
+    schema->last = malloc(sz);
+    schema->scratch = malloc(sz);
+    schema->changed = (uint8_t*)calloc((schema->nitems + 7) / 8, sizeof(uint8_t));
+    if (NULL == schema->last || NULL == schema->scratch || NULL == schema->changed) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    return ORCM_SUCCESS;
+}
+
+/* look for the component in the sensor_base_change_only list */
+static void set_change_only(orcm_sensor_schema_t *schema)
+{
+    char **entries, **fields;
+    int i;
+
+    if (NULL == orcm_sensor_base.change_only) {
+        return;
+    }
+    entries = opal_argv_split(orcm_sensor_base.change_only, ',');
+    for (i=0; NULL != entries && NULL != entries[i]; i++) {
+        fields = opal_argv_split(entries[i], ':');
+        if (NULL != fields && 0 == strcmp(fields[0], schema->component)) {
+            schema->epsilon = 0.0;
+            schema->interval = 10;
+            if (NULL != fields[1]) {
+                schema->epsilon = strtod(fields[1], NULL);
+                if (NULL != fields[2]) {
+                    schema->interval = (uint32_t)strtoul(fields[2], NULL, 10);
+                }
+            }
+            /* an interval of 1 reports everything anyway */
+            if (1 == schema->interval) {
+                schema->interval = 0;
+            } else if (0 == schema->interval) {
+                schema->interval = UINT32_MAX;
+            }
+        }
+        opal_argv_free(fields);
+    }
+    opal_argv_free(entries);
+}
+
+orcm_sensor_schema_t* orcm_sensor_base_schema_register(const char *component,
+                                                       opal_data_type_t type,
+                                                       int32_t nitems,
+                                                       char **labels,
+                                                       char **units)
+{
+    orcm_sensor_schema_t *schema;
+    int32_t i;
+    int index;
+
+    if (NULL == component || 0 >= nitems || 0 == orcm_sensor_base_type_size(type)) {
+        return NULL;
+    }
+
+    schema = OBJ_NEW(orcm_sensor_schema_t);
+    schema->component = strdup(component);
+    schema->hostname = strdup(orte_process_info.nodename);
+    schema->type = type;
+    schema->nitems = nitems;
+    schema->labels = (char**)calloc(nitems + 1, sizeof(char*));
+    schema->units = (char**)calloc(nitems + 1, sizeof(char*));
+    for (i=0; i < nitems; i++) {
+        schema->labels[i] = strdup((NULL == labels || NULL == labels[i]) ? "" : labels[i]);
+        schema->units[i] = strdup((NULL == units || NULL == units[i]) ? "" : units[i]);
+    }
+
+    /* ids must fit in the wire format and are never reused */
+    if (UINT16_MAX < orcm_sensor_base.next_schema_id) {
+        opal_output_verbose(1, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:base: out of schema ids for %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), component);
+        OBJ_RELEASE(schema);
+        return NULL;
+    }
+    opal_mutex_lock(&orcm_sensor_base.schema_lock);
+    index = (int)orcm_sensor_base.next_schema_id;
+    if (OPAL_SUCCESS != opal_pointer_array_set_item(&orcm_sensor_base.schemas, index, schema)) {
+        opal_mutex_unlock(&orcm_sensor_base.schema_lock);
+        OBJ_RELEASE(schema);
+        return NULL;
+    }
+    orcm_sensor_base.next_schema_id++;
+    schema->id = (uint16_t)index;
+    opal_mutex_unlock(&orcm_sensor_base.schema_lock);
+
+    set_change_only(schema);
+    if (0 < schema->interval && ORCM_SUCCESS != alloc_last(schema)) {
+        orcm_sensor_base_schema_deregister(schema);
+        return NULL;
+    }
+    orcm_sensor_base_ring_setup(schema);
+
+    opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                        "%s sensor:base: registered schema %u for %s with %d values",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                        (unsigned)schema->id, component, (int)nitems);
+
+    return schema;
+}
+
+void orcm_sensor_base_schema_deregister(orcm_sensor_schema_t *schema)
+{
+    if (NULL == schema) {
+        return;
+    }
+    /* a ring upload may still hold it */
+    opal_mutex_lock(&orcm_sensor_base.schema_lock);
+    opal_pointer_array_set_item(&orcm_sensor_base.schemas, schema->id, NULL);
+    OBJ_RELEASE(schema);
+    opal_mutex_unlock(&orcm_sensor_base.schema_lock);
+}
+
+/* pack the name, id, flags and, if flagged, the schema of a sample */
+static int pack_header(opal_buffer_t *data, orcm_sensor_schema_t *schema, uint8_t flags)
+{
+    char *name = ORCM_SENSOR_BASE_COMPACT;
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &name, 1, OPAL_STRING))) {
+        return rc;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &schema->id, 1, OPAL_UINT16))) {
+        return rc;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &flags, 1, OPAL_UINT8))) {
+        return rc;
+    }
+    if (flags & COMPACT_HAS_SCHEMA) {
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &schema->component, 1, OPAL_STRING))) {
+            return rc;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &schema->hostname, 1, OPAL_STRING))) {
+            return rc;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &schema->type, 1, OPAL_DATA_TYPE))) {
+            return rc;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, &schema->nitems, 1, OPAL_INT32))) {
+            return rc;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, schema->labels, schema->nitems, OPAL_STRING))) {
+            return rc;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(data, schema->units, schema->nitems, OPAL_STRING))) {
+            return rc;
+        }
+    }
+    return OPAL_SUCCESS;
+}
+
+/* add a packed sample to the bucket */
+static int pack_sample(opal_buffer_t *bucket, orcm_sensor_schema_t *schema,
+                       opal_buffer_t *data)
+{
+    int rc;
+
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(bucket, &data, 1, OPAL_BUFFER))) {
+        return rc;
+    }
+
+    /* resend the schema every now and then */
+    schema->nsent++;
+    if (0 < orcm_sensor_base.schema_refresh &&
+        (uint32_t)orcm_sensor_base.schema_refresh <= schema->nsent) {
+        schema->nsent = 0;
+    }
+    return OPAL_SUCCESS;
+}
+
+int orcm_sensor_base_pack_compact(opal_buffer_t *bucket,
+                                  orcm_sensor_schema_t *schema,
+                                  struct timeval *sampletime,
+                                  void *values)
+{
+    opal_buffer_t data;
+    uint8_t flags = 0;
+    void *vptr = values;
+    size_t sz = orcm_sensor_base_type_size(schema->type);
+    int32_t i, nvals = schema->nitems;
+    double delta;
+    int rc;
+
+    if (NULL != schema->ring) {
+        /* kept on the node - the next heartbeat carries a summary */
+        orcm_sensor_base_ring_store((orcm_sensor_ring_t*)schema->ring, sampletime, values);
+        return ORCM_SUCCESS;
+    }
+
+    if (0 == schema->nsent) {
+        flags |= COMPACT_HAS_SCHEMA;
+    }
+
+    if (0 < schema->interval) {
+        if (!(flags & COMPACT_HAS_SCHEMA) && schema->have_last &&
+            schema->nsince_full < schema->interval) {
+            /* only report the values that moved since they were last reported */
+            memset(schema->changed, 0, (schema->nitems + 7) / 8);
+            nvals = 0;
+            for (i=0; i < schema->nitems; i++) {
+                delta = orcm_sensor_base_value_at(schema->type, values, i) -
+                        orcm_sensor_base_value_at(schema->type, schema->last, i);
+                if (isnan(delta) ?
+                    (isnan(orcm_sensor_base_value_at(schema->type, values, i)) !=
+                     isnan(orcm_sensor_base_value_at(schema->type, schema->last, i))) :
+                    (delta > schema->epsilon || -delta > schema->epsilon)) {
+                    schema->changed[i >> 3] |= 1 << (i & 7);
+                    memcpy((char*)schema->scratch + nvals * sz, (char*)values + i * sz, sz);
+                    memcpy((char*)schema->last + i * sz, (char*)values + i * sz, sz);
+                    nvals++;
+                }
+            }
+            schema->nsince_full++;
+            if (0 == nvals) {
+                return ORCM_SUCCESS;
+            }
+            if (nvals < schema->nitems) {
+                flags |= COMPACT_DELTA;
+                vptr = schema->scratch;
+            }
+        } else {
+            memcpy(schema->last, values, schema->nitems * sz);
+            schema->have_last = true;
+            schema->nsince_full = 1;
+        }
+    }
+
+    OBJ_CONSTRUCT(&data, opal_buffer_t);
+    if (OPAL_SUCCESS != (rc = pack_header(&data, schema, flags))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, sampletime, 1, OPAL_TIMEVAL))) {
+        goto cleanup;
+    }
+    if (flags & COMPACT_DELTA) {
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, schema->changed,
+                                                (schema->nitems + 7) / 8, OPAL_BYTE))) {
+            goto cleanup;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, &nvals, 1, OPAL_INT32))) {
+            goto cleanup;
+        }
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, vptr, nvals,
+                                            wire_type(schema->type)))) {
+        goto cleanup;
+    }
+    rc = pack_sample(bucket, schema, &data);
+
+cleanup:
+    if (OPAL_SUCCESS != rc) {
+        ORTE_ERROR_LOG(rc);
+    }
+    OBJ_DESTRUCT(&data);
+    return rc;
+}
+
+int orcm_sensor_base_pack_summary(opal_buffer_t *bucket,
+                                  orcm_sensor_schema_t *schema,
+                                  struct timeval *sampletime,
+                                  int32_t nsamples,
+                                  void *min, void *max, void *avg)
+{
+    opal_buffer_t data;
+    uint8_t flags = COMPACT_SUMMARY;
+    int rc;
+
+    if (0 == schema->nsent) {
+        flags |= COMPACT_HAS_SCHEMA;
+    }
+
+    OBJ_CONSTRUCT(&data, opal_buffer_t);
+    if (OPAL_SUCCESS != (rc = pack_header(&data, schema, flags))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, sampletime, 1, OPAL_TIMEVAL))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, &nsamples, 1, OPAL_INT32))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, min, schema->nitems,
+                                            wire_type(schema->type)))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, max, schema->nitems,
+                                            wire_type(schema->type)))) {
+        goto cleanup;
+    }
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, avg, schema->nitems,
+                                            wire_type(schema->type)))) {
+        goto cleanup;
+    }
+    rc = pack_sample(bucket, schema, &data);
+
+cleanup:
+    if (OPAL_SUCCESS != rc) {
+        ORTE_ERROR_LOG(rc);
+    }
+    OBJ_DESTRUCT(&data);
+    return rc;
+}
+
+static int unpack_schema(opal_buffer_t *data, uint16_t id,
+                         orcm_sensor_schema_t **schema)
+{
+    orcm_sensor_schema_t *sch;
+    int32_t n;
+    int rc;
+
+    sch = OBJ_NEW(orcm_sensor_schema_t);
+    sch->id = id;
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &sch->component, &n, OPAL_STRING))) {
+        goto error;
+    }
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &sch->hostname, &n, OPAL_STRING))) {
+        goto error;
+    }
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &sch->type, &n, OPAL_DATA_TYPE))) {
+        goto error;
+    }
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &sch->nitems, &n, OPAL_INT32))) {
+        goto error;
+    }
+    if (0 >= sch->nitems || 0 == orcm_sensor_base_type_size(sch->type)) {
+        rc = ORCM_ERR_BAD_PARAM;
+        goto error;
+    }
+    sch->labels = (char**)calloc(sch->nitems + 1, sizeof(char*));
+    sch->units = (char**)calloc(sch->nitems + 1, sizeof(char*));
+    if (NULL == sch->labels || NULL == sch->units) {
+        rc = ORCM_ERR_OUT_OF_RESOURCE;
+        goto error;
+    }
+    n = sch->nitems;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->labels, &n, OPAL_STRING))) {
+        goto error;
+    }
+    n = sch->nitems;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->units, &n, OPAL_STRING))) {
+        goto error;
+    }
+
+    *schema = sch;
+    return ORCM_SUCCESS;
+
+error:
+    OBJ_RELEASE(sch);
+    return rc;
+}
+
+static bool same_string(const char *a, const char *b)
+{
+    if (NULL == a || NULL == b) {
+        return a == b;
+    }
+    return 0 == strcmp(a, b);
+}
+
+/* does a newly announced schema describe the same samples as the one
+ * held for its id */
+static bool same_layout(orcm_sensor_schema_t *a, orcm_sensor_schema_t *b)
+{
+    int32_t i;
+
+    if (a->type != b->type || a->nitems != b->nitems ||
+        !same_string(a->component, b->component) ||
+        !same_string(a->hostname, b->hostname)) {
+        return false;
+    }
+    for (i=0; i < a->nitems; i++) {
+        if (!same_string(a->labels[i], b->labels[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* forget all the schemas received from a sender */
+static void drop_peer_schemas(orte_vpid_t vpid)
+{
+    orcm_sensor_schema_t *sch;
+    uint64_t key, *keys = NULL, *tmp;
+    size_t nkeys = 0, size = 0, i;
+    void *node;
+
+    if (OPAL_SUCCESS == opal_hash_table_get_first_key_uint64(&orcm_sensor_base.peer_schemas,
+                                                             &key, (void**)&sch, &node)) {
+        do {
+            if ((key >> 16) != (uint64_t)vpid) {
+                continue;
+            }
+            if (nkeys == size) {
+                size = (0 == size) ? 8 : 2 * size;
+                if (NULL == (tmp = (uint64_t*)realloc(keys, size * sizeof(uint64_t)))) {
+                    break;
+                }
+                keys = tmp;
+            }
+            keys[nkeys++] = key;
+        } while (OPAL_SUCCESS == opal_hash_table_get_next_key_uint64(&orcm_sensor_base.peer_schemas,
+                                                                    &key, (void**)&sch,
+                                                                    node, &node));
+    }
+    for (i=0; i < nkeys; i++) {
+        if (OPAL_SUCCESS == opal_hash_table_get_value_uint64(&orcm_sensor_base.peer_schemas,
+                                                             keys[i], (void**)&sch) &&
+            NULL != sch) {
+            OBJ_RELEASE(sch);
+        }
+        opal_hash_table_remove_value_uint64(&orcm_sensor_base.peer_schemas, keys[i]);
+    }
+    if (NULL != keys) {
+        free(keys);
+    }
+}
+
+int orcm_sensor_base_unpack_compact(orte_process_name_t *sender,
+                                    opal_buffer_t *data,
+                                    orcm_sensor_schema_t **schema,
+                                    struct timeval *sampletime,
+                                    void **values,
+                                    uint8_t **changed)
+{
+    orcm_sensor_schema_t *sch = NULL, *old;
+    uint64_t key;
+    uint16_t id;
+    uint8_t flags;
+    size_t sz;
+    int32_t n, i, nvals;
+    int rc;
+
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &id, &n, OPAL_UINT16))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &flags, &n, OPAL_UINT8))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+
+    key = ((uint64_t)sender->vpid << 16) | id;
+    if (flags & COMPACT_HAS_SCHEMA) {
+        if (ORCM_SUCCESS != (rc = unpack_schema(data, id, &sch))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        /* replace any previous definition - if it was a different
+         * one, the sender restarted and none of its ids hold */
+        if (OPAL_SUCCESS == opal_hash_table_get_value_uint64(&orcm_sensor_base.peer_schemas,
+                                                             key, (void**)&old) &&
+            NULL != old) {
+            if (same_layout(old, sch)) {
+                OBJ_RELEASE(old);
+            } else {
+                opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                    "%s sensor:base: schema %u of %s changed - "
+                                    "dropping all its schemas",
+                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), (unsigned)id,
+                                    ORTE_NAME_PRINT(sender));
+                drop_peer_schemas(sender->vpid);
+            }
+        }
+        opal_hash_table_set_value_uint64(&orcm_sensor_base.peer_schemas, key, sch);
+    } else if (OPAL_SUCCESS != opal_hash_table_get_value_uint64(&orcm_sensor_base.peer_schemas,
+                                                                key, (void**)&sch) ||
+               NULL == sch) {
+        /* we joined after the schema was sent - the sample is lost
+         * until the sender includes the schema again */
+        opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:base: dropping compact sample with unknown "
+                            "schema %u from %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), (unsigned)id,
+                            ORTE_NAME_PRINT(sender));
+        return ORCM_ERR_NOT_FOUND;
+    }
+
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sampletime, &n, OPAL_TIMEVAL))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+
+    sch->nsummary = 0;
+    if (flags & COMPACT_SUMMARY) {
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &sch->nsummary, &n, OPAL_INT32))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        sz = (size_t)sch->nitems * orcm_sensor_base_type_size(sch->type);
+        if (NULL == sch->min) {
+            sch->min = malloc(sz);
+            sch->max = malloc(sz);
+            if (NULL == sch->min || NULL == sch->max) {
+                sch->nsummary = 0;
+                ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+                return ORCM_ERR_OUT_OF_RESOURCE;
+            }
+        }
+        n = sch->nitems;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->min, &n,
+                                                  wire_type(sch->type)))) {
+            sch->nsummary = 0;
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        n = sch->nitems;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->max, &n,
+                                                  wire_type(sch->type)))) {
+            sch->nsummary = 0;
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        /* the average follows as a plain sample */
+    }
+
+    if (flags & COMPACT_DELTA) {
+        if (!sch->have_last) {
+            /* nothing to carry forward yet */
+            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:base: dropping partial sample of schema %u "
+                                "from %s received before a full one",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), (unsigned)id,
+                                ORTE_NAME_PRINT(sender));
+            return ORCM_ERR_NOT_FOUND;
+        }
+        n = (sch->nitems + 7) / 8;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->changed, &n, OPAL_BYTE))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, &nvals, &n, OPAL_INT32))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        if (0 >= nvals || sch->nitems < nvals) {
+            ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+            return ORCM_ERR_BAD_PARAM;
+        }
+        n = nvals;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, sch->scratch, &n,
+                                                  wire_type(sch->type)))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        /* carry the unreported values forward */
+        sz = orcm_sensor_base_type_size(sch->type);
+        for (i=0, n=0; i < sch->nitems && n < nvals; i++) {
+            if (sch->changed[i >> 3] & (1 << (i & 7))) {
+                memcpy((char*)sch->last + i * sz, (char*)sch->scratch + n * sz, sz);
+                n++;
+            }
+        }
+        *schema = sch;
+        *values = sch->last;
+        *changed = sch->changed;
+        return ORCM_SUCCESS;
+    }
+
+    sz = (size_t)sch->nitems * orcm_sensor_base_type_size(sch->type);
+    if (values_buf_size < sz) {
+        free(values_buf);
+        if (NULL == (values_buf = malloc(sz))) {
+            values_buf_size = 0;
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        values_buf_size = sz;
+    }
+    n = sch->nitems;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(data, values_buf, &n,
+                                              wire_type(sch->type)))) {
+        ORTE_ERROR_LOG(rc);
+        return rc;
+    }
+
+    /* remember the sample in case the sender only reports changes */
+    if (ORCM_SUCCESS == alloc_last(sch)) {
+        memcpy(sch->last, values_buf, sz);
+        sch->have_last = true;
+    }
+
+    *schema = sch;
+    *values = values_buf;
+    *changed = NULL;
+    return ORCM_SUCCESS;
+}
+
+static void extremes_cleanup(int dbhandle, int status, opal_list_t *kvs,
+                             opal_list_t *ret, void *cbdata)
+{
+    OPAL_LIST_RELEASE(kvs);
+}
+
+/* store the min and max of the values of a summary next to the
+ * average stored by the sensor */
+static void store_extremes(orcm_sensor_schema_t *schema, struct timeval *sampletime)
+{
+    opal_list_t *vals;
+    opal_value_t *kv;
+    orcm_metric_value_t *metric;
+    double vmin, vmax;
+    int32_t i;
+
+    vals = OBJ_NEW(opal_list_t);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("ctime");
+    kv->type = OPAL_TIMEVAL;
+    kv->data.tv = *sampletime;
+    opal_list_append(vals, &kv->super);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("hostname");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup(schema->hostname);
+    opal_list_append(vals, &kv->super);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("data_group");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup(schema->component);
+    opal_list_append(vals, &kv->super);
+
+    for (i=0; i < schema->nitems; i++) {
+        vmin = orcm_sensor_base_value_at(schema->type, schema->min, i);
+        vmax = orcm_sensor_base_value_at(schema->type, schema->max, i);
+        if (isnan(vmin) || isnan(vmax)) {
+            /* never read in the period */
+            continue;
+        }
+        metric = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&metric->value.key, "%s min", schema->labels[i]);
+        metric->units = strdup(schema->units[i]);
+        metric->value.type = OPAL_DOUBLE;
+        metric->value.data.dval = vmin;
+        opal_list_append(vals, &metric->value.super);
+
+        metric = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&metric->value.key, "%s max", schema->labels[i]);
+        metric->units = strdup(schema->units[i]);
+        metric->value.type = OPAL_DOUBLE;
+        metric->value.data.dval = vmax;
+        opal_list_append(vals, &metric->value.super);
+    }
+
+    orcm_db.store_new(orcm_sensor_base.dbhandle, ORCM_DB_ENV_DATA, vals, NULL,
+                      extremes_cleanup, NULL);
+}
+
+void orcm_sensor_base_log_compact(orte_process_name_t *sender,
+                                  opal_buffer_t *data)
+{
+    orcm_sensor_schema_t *schema;
+    orcm_sensor_active_module_t *i_module;
+    struct timeval sampletime;
+    void *values;
+    uint8_t *changed;
+
+    if (ORCM_SUCCESS != orcm_sensor_base_unpack_compact(sender, data, &schema,
+                                                        &sampletime, &values,
+                                                        &changed)) {
+        return;
+    }
+
+    if (orcm_sensor_base.dbhandle < 0) {
+        /* nothing we can do */
+        return;
+    }
+
+    opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                        "%s sensor:base: logging compact sample of sensor %s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), schema->component);
+
+    /* find the specified module  */
+    if (OPAL_SUCCESS != opal_hash_table_get_value_ptr(&orcm_sensor_base.log_modules,
+                                                      schema->component, strlen(schema->component),
+                                                      (void**)&i_module)) {
+        return;
+    }
+    if (NULL != i_module->module->log_compact) {
+        i_module->module->log_compact(schema, &sampletime, values, changed);
+    }
+    if (0 < schema->nsummary) {
+        store_extremes(schema, &sampletime);
+    }
+}
+
+void orcm_sensor_base_compact_finalize(void)
+{
+    orcm_sensor_schema_t *schema;
+    uint64_t key;
+    void *node;
+    int i;
+
+    for (i=0; i < orcm_sensor_base.schemas.size; i++) {
+        if (NULL != (schema = (orcm_sensor_schema_t*)opal_pointer_array_get_item(&orcm_sensor_base.schemas, i))) {
+            OBJ_RELEASE(schema);
+        }
+    }
+    OBJ_DESTRUCT(&orcm_sensor_base.schemas);
+
+    if (OPAL_SUCCESS == opal_hash_table_get_first_key_uint64(&orcm_sensor_base.peer_schemas,
+                                                             &key, (void**)&schema, &node)) {
+        do {
+            if (NULL != schema) {
+                OBJ_RELEASE(schema);
+            }
+        } while (OPAL_SUCCESS == opal_hash_table_get_next_key_uint64(&orcm_sensor_base.peer_schemas,
+                                                                    &key, (void**)&schema,
+                                                                    node, &node));
+    }
+    OBJ_DESTRUCT(&orcm_sensor_base.peer_schemas);
+
+    if (NULL != values_buf) {
+        free(values_buf);
+        values_buf = NULL;
+        values_buf_size = 0;
+    }
+}
+
+static void sch_con(orcm_sensor_schema_t *p)
+{
+    p->id = 0;
+    p->component = NULL;
+    p->hostname = NULL;
+    p->type = OPAL_UNDEF;
+    p->nitems = 0;
+    p->labels = NULL;
+    p->units = NULL;
+    p->nsent = 0;
+    p->epsilon = 0.0;
+    p->interval = 0;
+    p->nsince_full = 0;
+    p->last = NULL;
+    p->have_last = false;
+    p->changed = NULL;
+    p->scratch = NULL;
+    p->ring = NULL;
+    p->nsummary = 0;
+    p->min = NULL;
+    p->max = NULL;
+}
+static void sch_des(orcm_sensor_schema_t *p)
+{
+    if (NULL != p->component) {
+        free(p->component);
+    }
+    if (NULL != p->hostname) {
+        free(p->hostname);
+    }
+    if (NULL != p->labels) {
+        opal_argv_free(p->labels);
+    }
+    if (NULL != p->units) {
+        opal_argv_free(p->units);
+    }
+    if (NULL != p->last) {
+        free(p->last);
+    }
+    if (NULL != p->changed) {
+        free(p->changed);
+    }
+    if (NULL != p->scratch) {
+        free(p->scratch);
+    }
+    if (NULL != p->ring) {
+        OBJ_RELEASE(p->ring);
+    }
+    if (NULL != p->min) {
+        free(p->min);
+    }
+    if (NULL != p->max) {
+        free(p->max);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_sensor_schema_t,
+                   opal_object_t,
+                   sch_con, sch_des);
@@ -185,6 +185,13 @@ void orcm_sensor_base_start(orte_jobid_t job)
             opal_event_evtimer_set(orcm_sensor_base.ev_base, &sampler->ev,
                                    take_sample, sampler);
             opal_event_evtimer_add(&sampler->ev, &sampler->rate);
+            orcm_sensor_base.base_sampling = true;
+        }
+
+        /* sample the sensors having their own rate, whether or not
+         * the others are sampled */
+        if (mods_active && orcm_sensor_base.collect_metrics) {
+            orcm_sensor_base_sched_start();
         }
     } else if (!orcm_sensor_base.ev_active) {
         orcm_sensor_base.ev_active = true;
@@ -372,6 +379,11 @@ static void take_sample(int fd, short args, void *cbdata)
         OBJ_CONSTRUCT(&orcm_sensor_base.cache, opal_buffer_t);
     }
 
+    /* summarize the samples kept on the node since the last update */
+    if (NULL == sampler->sensors) {
+        orcm_sensor_base_ring_summarize(&sampler->bucket);
+    }
+
     /* call the sample function of all modules in priority order from
      * highest to lowest - the heartbeat should always be the lowest
      * priority, so it will send any collected data
@@ -385,6 +397,10 @@ static void take_sample(int fd, short args, void *cbdata)
             NULL == strcasestr(sampler->sensors, i_module->component->base_version.mca_component_name)) {
             continue;
         }
+        /* sensors with their own rate are sampled by the scheduler */
+        if (NULL == sampler->sensors && 0 < i_module->rate) {
+            continue;
+        }
         if (NULL != i_module->module->sample) {
             opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
                                 "%s sensor:base: sampling component %s",
@@ -416,7 +432,6 @@ static void take_sample(int fd, short args, void *cbdata)
 
 void orcm_sensor_base_log(char *comp, opal_buffer_t *data)
 {
-    int i;
     orcm_sensor_active_module_t *i_module;
 
     /* if no modules are available, then there is nothing to do */
@@ -434,19 +449,65 @@ void orcm_sensor_base_log(char *comp, opal_buffer_t *data)
                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), comp);
 
     /* find the specified module  */
-    for (i=0; i < orcm_sensor_base.modules.size; i++) {
-        if (NULL == (i_module = (orcm_sensor_active_module_t*)opal_pointer_array_get_item(&orcm_sensor_base.modules, i))) {
-            continue;
-        }
-        if (0 == strcmp(comp, i_module->component->base_version.mca_component_name)) {
-            if (NULL != i_module->module->log) {
-                i_module->module->log(data);
-            }
-            return;
-        }
+    if (OPAL_SUCCESS == opal_hash_table_get_value_ptr(&orcm_sensor_base.log_modules,
+                                                      comp, strlen(comp), (void**)&i_module) &&
+        NULL != i_module->module->log) {
+        i_module->module->log(data);
     }
 }
 
+int orcm_sensor_base_unpack_view(opal_buffer_t *buffer, opal_buffer_t *view)
+{
+    opal_buffer_t *tmp;
+    size_t nbytes;
+    int32_t n = 1;
+    int rc;
+
+    if (OPAL_DSS_BUFFER_FULLY_DESC == buffer->type) {
+        /* the bytes are wrapped in type descriptions - take a copy */
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &tmp, &n, OPAL_BUFFER))) {
+            return rc;
+        }
+        view->base_ptr = tmp->base_ptr;
+        view->pack_ptr = tmp->pack_ptr;
+        view->unpack_ptr = tmp->unpack_ptr;
+        view->bytes_allocated = tmp->bytes_allocated;
+        view->bytes_used = tmp->bytes_used;
+        tmp->base_ptr = NULL;
+        OBJ_RELEASE(tmp);
+        return OPAL_SUCCESS;
+    }
+
+    /* otherwise a packed buffer is its size followed by its bytes,
+     * which we point at where they are */
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &nbytes, &n, OPAL_SIZE))) {
+        return rc;
+    }
+    if (nbytes > buffer->bytes_used - (size_t)(buffer->unpack_ptr - buffer->base_ptr)) {
+        return OPAL_ERR_UNPACK_READ_PAST_END_OF_BUFFER;
+    }
+    view->base_ptr = buffer->unpack_ptr;
+    view->unpack_ptr = view->base_ptr;
+    view->pack_ptr = view->base_ptr + nbytes;
+    view->bytes_used = nbytes;
+    /* nothing of it is ours */
+    view->bytes_allocated = 0;
+    buffer->unpack_ptr += nbytes;
+    return OPAL_SUCCESS;
+}
+
+void orcm_sensor_base_drop_view(opal_buffer_t *view)
+{
+    if (0 < view->bytes_allocated && NULL != view->base_ptr) {
+        free(view->base_ptr);
+    }
+    view->base_ptr = NULL;
+    view->pack_ptr = NULL;
+    view->unpack_ptr = NULL;
+    view->bytes_allocated = 0;
+    view->bytes_used = 0;
+}
+
 void orcm_sensor_base_manually_sample(char *sensors,
                                       orcm_sensor_sample_cb_fn_t cbfunc,
                                       void *cbdata)
@@ -661,6 +722,7 @@ static void orcm_sensor_base_recv(int status, orte_process_name_t *sender,
                     break;
                 }
             }
+            orcm_sensor_base.policy_gen++;
 
             if ( !found_me ) {
                 /* matched policy not found, insert into policy list */
@@ -840,6 +902,35 @@ static void orcm_sensor_base_recv(int status, orte_process_name_t *sender,
             goto RESPONSE;
             break;
 
+        case ORCM_GET_SENSOR_RING_COMMAND:
+            /* unpack the sensor name */
+            cnt = 1;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(buffer, &sensor_name,
+                                                      &cnt, OPAL_STRING))) {
+                ORTE_ERROR_LOG(rc);
+                goto ERROR;
+            }
+
+            response = ORCM_SUCCESS;
+            if (OPAL_SUCCESS != (rc = opal_dss.pack(ans, &response, 1, OPAL_INT))) {
+                ORTE_ERROR_LOG(rc);
+                OBJ_RELEASE(ans);
+                free(sensor_name);
+                return;
+            }
+            /* send back everything the rings of the sensor hold */
+            rc = orcm_sensor_base_ring_upload(ans, sensor_name);
+            free(sensor_name);
+            if (ORCM_SUCCESS != rc) {
+                /* start over with just the error */
+                OBJ_RELEASE(ans);
+                ans = OBJ_NEW(opal_buffer_t);
+                response = rc;
+                goto ERROR;
+            }
+            goto RESPONSE;
+            break;
+
         default:
             goto ERROR;
         }
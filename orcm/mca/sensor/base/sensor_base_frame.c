@@ -102,6 +102,83 @@ static int orcm_sensor_base_register(mca_base_register_flag_t flags)
                                 MCA_BASE_VAR_SCOPE_READONLY,
                                 &orcm_sensor_base.enable_group_commits);
 
+    orcm_sensor_base.compact_samples = true;
+    (void)mca_base_var_register("orcm", "sensor", "base", "compact_samples",
+                                "Send the samples of sensors supporting it as arrays of values "
+                                "described by a schema sent once, instead of labelling each value",
+                                MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.compact_samples);
+
+    orcm_sensor_base.schema_refresh = 100;
+    (void)mca_base_var_register("orcm", "sensor", "base", "schema_refresh",
+                                "Number of compact samples after which their schema is sent again "
+                                "(0: send it only once)",
+                                MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.schema_refresh);
+
+    orcm_sensor_base.change_only = NULL;
+    (void)mca_base_var_register("orcm", "sensor", "base", "change_only",
+                                "Comma-separated list of sensor[:epsilon[:interval]] only reporting "
+                                "the values that changed by more than epsilon (default: 0) since they "
+                                "were last reported, and all values every interval samples (default: 10). "
+                                "Only applies to sensors sending compact samples",
+                                MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.change_only);
+
+    orcm_sensor_base.sample_rates = NULL;
+    (void)mca_base_var_register("orcm", "sensor", "base", "sample_rates",
+                                "Comma-separated list of sensor:usecs sampled at their own rate "
+                                "instead of the base sample rate - their samples are sent with "
+                                "the next heartbeat. With a base sample rate of 0, list the "
+                                "heartbeat as well",
+                                MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.sample_rates);
+
+    orcm_sensor_base.wheel_tick = 1000;
+    (void)mca_base_var_register("orcm", "sensor", "base", "wheel_tick",
+                                "Resolution in usecs of the scheduling of sensors sampled at their own rate",
+                                MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.wheel_tick);
+
+    orcm_sensor_base.ring = NULL;
+    (void)mca_base_var_register("orcm", "sensor", "base", "ring",
+                                "Comma-separated list of sensor[:nsamples] keeping their last nsamples "
+                                "samples (default: 3600) on the node and only sending a summary "
+                                "(min/max/avg) with each heartbeat. Only applies to sensors sending "
+                                "compact samples",
+                                MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.ring);
+
+    orcm_sensor_base.ring_mmap = false;
+    (void)mca_base_var_register("orcm", "sensor", "base", "ring_mmap",
+                                "Keep the sample rings in files of the session directory",
+                                MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.ring_mmap);
+
+    orcm_sensor_base.ring_summary_rate = 0;
+    (void)mca_base_var_register("orcm", "sensor", "base", "ring_summary_rate",
+                                "Usecs between the summaries of the sample rings when the base "
+                                "sample rate is 0 (default: the rate of the lowest priority "
+                                "sensor, normally the heartbeat)",
+                                MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                OPAL_INFO_LVL_9,
+                                MCA_BASE_VAR_SCOPE_READONLY,
+                                &orcm_sensor_base.ring_summary_rate);
+
     return ORCM_SUCCESS;
 }
 
@@ -109,7 +186,10 @@ static int orcm_sensor_base_close(void)
 {
     orcm_sensor_active_module_t *i_module;
     int i;
-    
+
+    /* stop the per-sensor sampling while the event base is still around */
+    orcm_sensor_base_sched_finalize();
+
     if (orcm_sensor_base.ev_active) {
         orcm_sensor_base.ev_active = false;
         /* stop the thread */
@@ -126,9 +206,14 @@ static int orcm_sensor_base_close(void)
         }
     }
     OBJ_DESTRUCT(&orcm_sensor_base.modules);
+    OBJ_DESTRUCT(&orcm_sensor_base.log_modules);
 
     /* clear the per-component-thread collection cache */
     OBJ_DESTRUCT(&orcm_sensor_base.cache);
+
+    /* release the compact sample schemas */
+    orcm_sensor_base_compact_finalize();
+    OBJ_DESTRUCT(&orcm_sensor_base.schema_lock);
     
     /* Close all remaining available components */
     return mca_base_framework_components_close(&orcm_sensor_base_framework, NULL);
@@ -148,9 +233,20 @@ static int orcm_sensor_base_open(mca_base_open_flag_t flags)
     orcm_sensor_base.ev_active = false;
     OBJ_CONSTRUCT(&orcm_sensor_base.cache, opal_buffer_t);
     OBJ_CONSTRUCT(&orcm_sensor_base.policy, opal_list_t);
+    orcm_sensor_base.policy_gen = 0;
+    orcm_sensor_base.base_sampling = false;
     /* construct the array of modules */
     OBJ_CONSTRUCT(&orcm_sensor_base.modules, opal_pointer_array_t);
     opal_pointer_array_init(&orcm_sensor_base.modules, 3, INT_MAX, 1);
+    /* construct the compact sample schema dictionaries */
+    OBJ_CONSTRUCT(&orcm_sensor_base.schemas, opal_pointer_array_t);
+    opal_pointer_array_init(&orcm_sensor_base.schemas, 4, UINT16_MAX + 1, 4);
+    orcm_sensor_base.next_schema_id = 0;
+    OBJ_CONSTRUCT(&orcm_sensor_base.schema_lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&orcm_sensor_base.peer_schemas, opal_hash_table_t);
+    opal_hash_table_init(&orcm_sensor_base.peer_schemas, 1024);
+    OBJ_CONSTRUCT(&orcm_sensor_base.log_modules, opal_hash_table_t);
+    opal_hash_table_init(&orcm_sensor_base.log_modules, 32);
     
     /* Open up all available components */
     if (OPAL_SUCCESS != (rc = mca_base_framework_components_open(&orcm_sensor_base_framework, flags))) {
@@ -168,6 +264,7 @@ MCA_BASE_FRAMEWORK_DECLARE(orcm, sensor, "ORCM Monitoring Sensors",
 static void cons(orcm_sensor_active_module_t *t)
 {
     t->sampling = true;
+    t->rate = 0;
 }
 OBJ_CLASS_INSTANCE(orcm_sensor_active_module_t,
                    opal_object_t,
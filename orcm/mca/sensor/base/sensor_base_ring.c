@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif  /* HAVE_UNISTD_H */
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif  /* HAVE_STRING_H */
+#include <sys/mman.h>
+
+#include "opal_stdint.h"
+#include "opal/dss/dss.h"
+#include "opal/sys/atomic.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/util/proc_info.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+/*
+ * On-node sample rings
+ *
+ * The compact samples of sensors listed in sensor_base_ring are stored
+ * in a fixed-size ring per schema instead of being sent. Each heartbeat
+ * carries a summary (count, min, max, average) of the samples stored
+ * since the previous one, and the full-resolution window can be pulled
+ * with the ORCM_GET_SENSOR_RING_COMMAND (octl "sensor get history").
+ *
+ * If sensor_base_ring_mmap is set, the ring lives in a file of the
+ * process session dir, starting with a ring_header_t, so that the last
+ * samples can still be read after the daemon died.
+ */
+
+#define RING_DEFAULT_SAMPLES  3600
+#define RING_MAGIC            "ORCMRING"
+
+typedef struct {
+    char magic[8];
+    uint32_t nslots;
+    uint32_t slot_size;
+    int32_t nitems;
+    uint32_t type;
+    volatile uint64_t head;
+    char pad[32];
+} ring_header_t;
+
+static int ring_map(orcm_sensor_ring_t *ring, orcm_sensor_schema_t *schema)
+{
+    ring_header_t *hdr;
+    int fd;
+
+    if (NULL == orte_process_info.proc_session_dir) {
+        return ORCM_ERR_NOT_AVAILABLE;
+    }
+    asprintf(&ring->path, "%s/sensor-%s-%u.ring", orte_process_info.proc_session_dir,
+             schema->component, (unsigned)schema->id);
+    ring->maplen = sizeof(ring_header_t) + (size_t)ring->nslots * ring->slot_size;
+
+    if (0 > (fd = open(ring->path, O_RDWR | O_CREAT | O_TRUNC, 0600))) {
+        return ORCM_ERR_FILE_OPEN_FAILURE;
+    }
+    if (0 != ftruncate(fd, ring->maplen)) {
+        close(fd);
+        unlink(ring->path);
+        return ORCM_ERR_FILE_WRITE_FAILURE;
+    }
+    ring->map = mmap(NULL, ring->maplen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == ring->map) {
+        ring->map = NULL;
+        unlink(ring->path);
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+
+    hdr = (ring_header_t*)ring->map;
+    memcpy(hdr->magic, RING_MAGIC, sizeof(hdr->magic));
+    hdr->nslots = ring->nslots;
+    hdr->slot_size = (uint32_t)ring->slot_size;
+    hdr->nitems = ring->nitems;
+    hdr->type = ring->type;
+    hdr->head = 0;
+    ring->head = &hdr->head;
+    ring->slots = (char*)ring->map + sizeof(ring_header_t);
+    return ORCM_SUCCESS;
+}
+
+void orcm_sensor_base_ring_setup(orcm_sensor_schema_t *schema)
+{
+    orcm_sensor_ring_t *ring;
+    char **entries, **fields;
+    uint32_t nslots = 0;
+    int i;
+
+    if (NULL == orcm_sensor_base.ring) {
+        return;
+    }
+    entries = opal_argv_split(orcm_sensor_base.ring, ',');
+    for (i=0; NULL != entries && NULL != entries[i]; i++) {
+        fields = opal_argv_split(entries[i], ':');
+        if (NULL != fields && 0 == strcmp(fields[0], schema->component)) {
+            nslots = RING_DEFAULT_SAMPLES;
+            if (NULL != fields[1]) {
+                nslots = (uint32_t)strtoul(fields[1], NULL, 10);
+            }
+        }
+        opal_argv_free(fields);
+    }
+    opal_argv_free(entries);
+    if (0 == nslots) {
+        return;
+    }
+
+    ring = OBJ_NEW(orcm_sensor_ring_t);
+    ring->type = schema->type;
+    ring->nitems = schema->nitems;
+    ring->nslots = nslots;
+    ring->value_size = (size_t)schema->nitems * orcm_sensor_base_type_size(schema->type);
+    ring->slot_size = (sizeof(struct timeval) + ring->value_size + 7) & ~(size_t)7;
+
+    if (!orcm_sensor_base.ring_mmap || ORCM_SUCCESS != ring_map(ring, schema)) {
+        if (orcm_sensor_base.ring_mmap) {
+            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:base: cannot map a ring file for %s - "
+                                "keeping its samples in memory",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), schema->component);
+        }
+        if (NULL != ring->path) {
+            free(ring->path);
+            ring->path = NULL;
+        }
+        ring->slots = (char*)malloc((size_t)ring->nslots * ring->slot_size);
+        ring->head = (volatile uint64_t*)malloc(sizeof(uint64_t));
+        if (NULL == ring->slots || NULL == (void*)ring->head) {
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            OBJ_RELEASE(ring);
+            return;
+        }
+        *ring->head = 0;
+    }
+
+    opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                        "%s sensor:base: keeping the last %u samples of %s on the node%s%s",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), (unsigned)nslots,
+                        schema->component, (NULL == ring->path) ? "" : " in ",
+                        (NULL == ring->path) ? "" : ring->path);
+    schema->ring = ring;
+}
+
+void orcm_sensor_base_ring_store(orcm_sensor_ring_t *ring,
+                                 struct timeval *sampletime,
+                                 void *values)
+{
+    uint64_t head = *ring->head;
+    char *slot = ring->slots + (head % ring->nslots) * ring->slot_size;
+
+    memcpy(slot, sampletime, sizeof(struct timeval));
+    memcpy(slot + sizeof(struct timeval), values, ring->value_size);
+    /* publish the sample only once it is complete */
+    opal_atomic_wmb();
+    *ring->head = head + 1;
+}
+
+uint32_t orcm_sensor_base_ring_read(orcm_sensor_ring_t *ring,
+                                    uint64_t *from, uint32_t max,
+                                    struct timeval *sampletimes,
+                                    void *values)
+{
+    uint64_t head, start, first, i;
+    uint32_t n, skip;
+    char *slot;
+
+    head = *ring->head;
+    opal_atomic_rmb();
+
+    start = *from;
+    if (head - start > ring->nslots) {
+        start = head - ring->nslots;
+    }
+    if (head - start > max) {
+        start = head - max;
+    }
+    for (i = start, n = 0; i < head; i++, n++) {
+        slot = ring->slots + (i % ring->nslots) * ring->slot_size;
+        memcpy(&sampletimes[n], slot, sizeof(struct timeval));
+        memcpy((char*)values + n * ring->value_size, slot + sizeof(struct timeval),
+               ring->value_size);
+    }
+
+    /* drop the samples whose slot the writer reused while we copied */
+    opal_atomic_rmb();
+    i = *ring->head;
+    first = (i >= ring->nslots) ? i - ring->nslots + 1 : 0;
+    if (start < first) {
+        skip = (first - start >= n) ? n : (uint32_t)(first - start);
+        n -= skip;
+        memmove(sampletimes, &sampletimes[skip], n * sizeof(struct timeval));
+        memmove(values, (char*)values + skip * ring->value_size, n * ring->value_size);
+    }
+
+    *from = head;
+    return n;
+}
+
+void orcm_sensor_base_ring_summarize(opal_buffer_t *bucket)
+{
+    orcm_sensor_schema_t *schema;
+    orcm_sensor_ring_t *ring;
+    char *min, *max, *avg, *vals;
+    double v, *sum = NULL, *tmp;
+    uint32_t n, s, *cnt = NULL, *ctmp;
+    int32_t i;
+    int j;
+
+    for (j=0; j < orcm_sensor_base.schemas.size; j++) {
+        if (NULL == (schema = (orcm_sensor_schema_t*)opal_pointer_array_get_item(&orcm_sensor_base.schemas, j)) ||
+            NULL == (ring = (orcm_sensor_ring_t*)schema->ring)) {
+            continue;
+        }
+        if (NULL == ring->times) {
+            ring->times = (struct timeval*)malloc(ring->nslots * sizeof(struct timeval));
+            ring->values = (char*)malloc(ring->nslots * ring->value_size);
+            ring->stats = (char*)malloc(3 * ring->value_size);
+            if (NULL == ring->times || NULL == ring->values || NULL == ring->stats) {
+                ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+                continue;
+            }
+        }
+        n = orcm_sensor_base_ring_read(ring, &ring->summarized, ring->nslots,
+                                       ring->times, ring->values);
+        if (0 == n) {
+            continue;
+        }
+
+        min = ring->stats;
+        max = min + ring->value_size;
+        avg = max + ring->value_size;
+        if (NULL == (tmp = (double*)realloc(sum, schema->nitems * sizeof(double)))) {
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            continue;
+        }
+        sum = tmp;
+        if (NULL == (ctmp = (uint32_t*)realloc(cnt, schema->nitems * sizeof(uint32_t)))) {
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            continue;
+        }
+        cnt = ctmp;
+        for (i=0; i < schema->nitems; i++) {
+            sum[i] = 0.0;
+            cnt[i] = 0;
+        }
+        /* values that could not be read (NaN) are left out, and an
+         * item never read in the period is summarized as NaN */
+        for (s=0; s < n; s++) {
+            vals = ring->values + s * ring->value_size;
+            for (i=0; i < schema->nitems; i++) {
+                v = orcm_sensor_base_value_at(schema->type, vals, i);
+                if (isnan(v)) {
+                    continue;
+                }
+                sum[i] += v;
+                if (0 == cnt[i]++ || v < orcm_sensor_base_value_at(schema->type, min, i)) {
+                    orcm_sensor_base_set_value(schema->type, min, i, v);
+                }
+                if (1 == cnt[i] || v > orcm_sensor_base_value_at(schema->type, max, i)) {
+                    orcm_sensor_base_set_value(schema->type, max, i, v);
+                }
+            }
+        }
+        for (i=0; i < schema->nitems; i++) {
+            if (0 == cnt[i]) {
+                orcm_sensor_base_set_value(schema->type, min, i, NAN);
+                orcm_sensor_base_set_value(schema->type, max, i, NAN);
+                orcm_sensor_base_set_value(schema->type, avg, i, NAN);
+            } else {
+                orcm_sensor_base_set_value(schema->type, avg, i, sum[i] / cnt[i]);
+            }
+        }
+
+        orcm_sensor_base_pack_summary(bucket, schema, &ring->times[n - 1],
+                                      (int32_t)n, min, max, avg);
+    }
+    if (NULL != sum) {
+        free(sum);
+    }
+    if (NULL != cnt) {
+        free(cnt);
+    }
+}
+
+/*
+ * Response to an upload request, for each ring of the sensor:
+ *
+ *    hostname                       (string)
+ *    number of values               (int32)
+ *    labels and units               (nitems strings each)
+ *    number of samples              (int32)
+ *    sample times                   (nsamples timevals)
+ *    values                         (nsamples x nitems doubles sent as
+ *                                    the uint64 holding their bits)
+ *
+ * preceded by the number of rings
+ */
+int orcm_sensor_base_ring_upload(opal_buffer_t *buf, char *component)
+{
+    orcm_sensor_schema_t *schema;
+    orcm_sensor_ring_t *ring;
+    opal_pointer_array_t found;
+    struct timeval *times = NULL, *ttmp;
+    char *values = NULL, *vtmp;
+    double *dvals = NULL, *dtmp;
+    uint64_t from;
+    int32_t nrings = 0, n, i;
+    uint32_t nsamples, s;
+    int j, rc = ORCM_SUCCESS;
+
+    /* this runs on the RML thread - hold the schemas found so the
+     * sensors can't release them and their ring under us */
+    OBJ_CONSTRUCT(&found, opal_pointer_array_t);
+    opal_pointer_array_init(&found, 4, INT_MAX, 4);
+    opal_mutex_lock(&orcm_sensor_base.schema_lock);
+    for (j=0; j < orcm_sensor_base.schemas.size; j++) {
+        if (NULL != (schema = (orcm_sensor_schema_t*)opal_pointer_array_get_item(&orcm_sensor_base.schemas, j)) &&
+            NULL != schema->ring && 0 == strcmp(schema->component, component)) {
+            OBJ_RETAIN(schema);
+            opal_pointer_array_add(&found, schema);
+            nrings++;
+        }
+    }
+    opal_mutex_unlock(&orcm_sensor_base.schema_lock);
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &nrings, 1, OPAL_INT32))) {
+        goto cleanup;
+    }
+
+    for (j=0; j < found.size; j++) {
+        if (NULL == (schema = (orcm_sensor_schema_t*)opal_pointer_array_get_item(&found, j))) {
+            continue;
+        }
+        ring = (orcm_sensor_ring_t*)schema->ring;
+        if (NULL == (ttmp = (struct timeval*)realloc(times, ring->nslots * sizeof(struct timeval)))) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            goto cleanup;
+        }
+        times = ttmp;
+        if (NULL == (vtmp = (char*)realloc(values, ring->nslots * ring->value_size))) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            goto cleanup;
+        }
+        values = vtmp;
+        if (NULL == (dtmp = (double*)realloc(dvals, (size_t)ring->nslots * schema->nitems * sizeof(double)))) {
+            rc = ORCM_ERR_OUT_OF_RESOURCE;
+            goto cleanup;
+        }
+        dvals = dtmp;
+        from = 0;
+        nsamples = orcm_sensor_base_ring_read(ring, &from, ring->nslots, times, values);
+        for (s=0; s < nsamples; s++) {
+            for (i=0; i < schema->nitems; i++) {
+                dvals[s * schema->nitems + i] =
+                    orcm_sensor_base_value_at(schema->type,
+                                              values + s * ring->value_size, i);
+            }
+        }
+
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &schema->hostname, 1, OPAL_STRING))) {
+            goto cleanup;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &schema->nitems, 1, OPAL_INT32))) {
+            goto cleanup;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, schema->labels, schema->nitems, OPAL_STRING))) {
+            goto cleanup;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, schema->units, schema->nitems, OPAL_STRING))) {
+            goto cleanup;
+        }
+        n = (int32_t)nsamples;
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &n, 1, OPAL_INT32))) {
+            goto cleanup;
+        }
+        if (0 == n) {
+            continue;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, times, n, OPAL_TIMEVAL))) {
+            goto cleanup;
+        }
+        if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, dvals, n * schema->nitems, OPAL_UINT64))) {
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    if (OPAL_SUCCESS != rc) {
+        ORTE_ERROR_LOG(rc);
+    }
+    opal_mutex_lock(&orcm_sensor_base.schema_lock);
+    for (j=0; j < found.size; j++) {
+        if (NULL != (schema = (orcm_sensor_schema_t*)opal_pointer_array_get_item(&found, j))) {
+            OBJ_RELEASE(schema);
+        }
+    }
+    opal_mutex_unlock(&orcm_sensor_base.schema_lock);
+    OBJ_DESTRUCT(&found);
+    if (NULL != times) {
+        free(times);
+    }
+    if (NULL != values) {
+        free(values);
+    }
+    if (NULL != dvals) {
+        free(dvals);
+    }
+    return rc;
+}
+
+static void ring_con(orcm_sensor_ring_t *p)
+{
+    p->type = OPAL_UNDEF;
+    p->nitems = 0;
+    p->nslots = 0;
+    p->value_size = 0;
+    p->slot_size = 0;
+    p->head = NULL;
+    p->summarized = 0;
+    p->slots = NULL;
+    p->map = NULL;
+    p->maplen = 0;
+    p->path = NULL;
+    p->times = NULL;
+    p->values = NULL;
+    p->stats = NULL;
+}
+static void ring_des(orcm_sensor_ring_t *p)
+{
+    if (NULL != p->map) {
+        munmap(p->map, p->maplen);
+    } else {
+        if (NULL != p->slots) {
+            free(p->slots);
+        }
+        if (NULL != p->head) {
+            free((void*)p->head);
+        }
+    }
+    if (NULL != p->path) {
+        /* nothing to look at after a clean shutdown */
+        unlink(p->path);
+        free(p->path);
+    }
+    if (NULL != p->times) {
+        free(p->times);
+    }
+    if (NULL != p->values) {
+        free(p->values);
+    }
+    if (NULL != p->stats) {
+        free(p->stats);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_sensor_ring_t,
+                   opal_object_t,
+                   ring_con, ring_des);
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif  /* HAVE_STRING_H */
+#include <sys/time.h>
+#include <time.h>
+
+#include "opal_stdint.h"
+#include "opal/dss/dss.h"
+#include "opal/mca/event/event.h"
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+/*
+ * Per-module sample scheduling
+ *
+ * Modules given their own rate (in usecs) through sensor_base_sample_rates
+ * or orcm_sensor_base_sched_set_rate are not sampled by the base sampler
+ * but from a hashed timer wheel run on the sensor event base. The wheel
+ * has ORCM_SENSOR_WHEEL_SLOTS slots of sensor_base_wheel_tick usecs, and
+ * a single timer is armed for the next tick holding a due module.
+ *
+ * Deadlines are absolute on the monotonic clock, so setting the date
+ * doesn't move them, and aligned on a multiple of the rate, so the
+ * schedule doesn't drift, modules with the same or harmonic rates are
+ * woken together, and a late wakeup skips the missed periods instead of
+ * firing a burst. Modules due in the same tick are sampled fastest rate
+ * first, as they are the most sensitive to jitter. Their samples go to
+ * the base cache, which the base sampler adds to the next heartbeat.
+ *
+ * The wheel runs even if the base sampler doesn't (sensor_base_sample_rate
+ * of 0). The cache is then handed to each module it samples, the way the
+ * base sampler does, so the heartbeat has to be given its own rate to
+ * send the samples. The sample rings are then summarized into the cache
+ * by an entry of their own, at sensor_base_ring_summary_rate or else at
+ * the rate of the lowest priority module, and ahead of the modules due
+ * in the same tick so that the summary goes with that heartbeat.
+ */
+
+#define ORCM_SENSOR_WHEEL_SLOTS  256
+
+typedef struct {
+    opal_list_item_t super;
+    orcm_sensor_active_module_t *module;    // NULL for the ring summaries
+    uint64_t rate;          // usecs
+    uint64_t deadline;      // usecs on the monotonic clock
+    orcm_sensor_sampler_t *sampler;
+} orcm_sensor_sched_entry_t;
+static void ent_con(orcm_sensor_sched_entry_t *p)
+{
+    p->module = NULL;
+    p->rate = 0;
+    p->deadline = 0;
+    p->sampler = OBJ_NEW(orcm_sensor_sampler_t);
+}
+static void ent_des(orcm_sensor_sched_entry_t *p)
+{
+    OBJ_RELEASE(p->sampler);
+}
+static OBJ_CLASS_INSTANCE(orcm_sensor_sched_entry_t,
+                          opal_list_item_t,
+                          ent_con, ent_des);
+
+static opal_list_t wheel[ORCM_SENSOR_WHEEL_SLOTS];
+static bool wheel_constructed = false;
+static bool wheel_armed = false;
+static opal_event_t wheel_ev;
+static uint64_t tick_usec = 1000;
+static uint64_t last_tick = 0;
+static int nentries = 0;
+
+static uint64_t now_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* keep the fastest modules first in each slot */
+static void insert_ordered(opal_list_t *list, orcm_sensor_sched_entry_t *entry)
+{
+    orcm_sensor_sched_entry_t *e;
+
+    OPAL_LIST_FOREACH(e, list, orcm_sensor_sched_entry_t) {
+        if (NULL == entry->module || entry->rate < e->rate) {
+            opal_list_insert_pos(list, &e->super, &entry->super);
+            return;
+        }
+    }
+    opal_list_append(list, &entry->super);
+}
+
+static void wheel_insert(orcm_sensor_sched_entry_t *entry)
+{
+    insert_ordered(&wheel[(entry->deadline / tick_usec) % ORCM_SENSOR_WHEEL_SLOTS], entry);
+}
+
+static void wheel_arm(uint64_t now)
+{
+    orcm_sensor_sched_entry_t *e;
+    uint64_t t, next = UINT64_MAX;
+    struct timeval tv;
+    int i;
+
+    if (0 == nentries) {
+        return;
+    }
+
+    /* look for the next tick holding a due entry within one turn */
+    for (t = last_tick + 1; t <= last_tick + ORCM_SENSOR_WHEEL_SLOTS && UINT64_MAX == next; t++) {
+        OPAL_LIST_FOREACH(e, &wheel[t % ORCM_SENSOR_WHEEL_SLOTS], orcm_sensor_sched_entry_t) {
+            if (e->deadline / tick_usec == t && e->deadline < next) {
+                next = e->deadline;
+            }
+        }
+    }
+    /* everyone is further away - take the earliest deadline */
+    if (UINT64_MAX == next) {
+        for (i=0; i < ORCM_SENSOR_WHEEL_SLOTS; i++) {
+            OPAL_LIST_FOREACH(e, &wheel[i], orcm_sensor_sched_entry_t) {
+                if (e->deadline < next) {
+                    next = e->deadline;
+                }
+            }
+        }
+    }
+
+    next = (next > now) ? next - now : 0;
+    tv.tv_sec = next / 1000000;
+    tv.tv_usec = next % 1000000;
+    opal_event_evtimer_add(&wheel_ev, &tv);
+    wheel_armed = true;
+}
+
+static void wheel_fire(int fd, short args, void *cbdata)
+{
+    orcm_sensor_sched_entry_t *e, *next;
+    opal_list_t due;
+    uint64_t now, cur, t, start;
+
+    wheel_armed = false;
+    now = now_usec();
+    cur = now / tick_usec;
+
+    /* collect everything due since the last run, visiting each
+     * slot at most once */
+    OBJ_CONSTRUCT(&due, opal_list_t);
+    start = (cur - last_tick >= ORCM_SENSOR_WHEEL_SLOTS) ?
+        cur - ORCM_SENSOR_WHEEL_SLOTS + 1 : last_tick + 1;
+    for (t = start; t <= cur; t++) {
+        OPAL_LIST_FOREACH_SAFE(e, next, &wheel[t % ORCM_SENSOR_WHEEL_SLOTS], orcm_sensor_sched_entry_t) {
+            if (e->deadline / tick_usec <= cur) {
+                opal_list_remove_item(&wheel[t % ORCM_SENSOR_WHEEL_SLOTS], &e->super);
+                insert_ordered(&due, e);
+            }
+        }
+    }
+    last_tick = cur;
+
+    while (NULL != (e = (orcm_sensor_sched_entry_t*)opal_list_remove_first(&due))) {
+        if (NULL == e->module) {
+            orcm_sensor_base_ring_summarize(&orcm_sensor_base.cache);
+        } else if (e->module->sampling && NULL != e->module->module->sample) {
+            opal_output_verbose(10, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:base: sampling component %s %"PRId64" usecs late",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                e->module->component->base_version.mca_component_name,
+                                (int64_t)(now_usec() - e->deadline));
+            if (!orcm_sensor_base.base_sampling &&
+                0 < orcm_sensor_base.cache.bytes_used) {
+                opal_dss.copy_payload(&e->sampler->bucket, &orcm_sensor_base.cache);
+                OBJ_DESTRUCT(&orcm_sensor_base.cache);
+                OBJ_CONSTRUCT(&orcm_sensor_base.cache, opal_buffer_t);
+            }
+            e->module->module->sample(e->sampler);
+            /* hold the sample for the next heartbeat - the cache is
+             * only accessed from this event base */
+            if (0 < e->sampler->bucket.bytes_used) {
+                opal_dss.copy_payload(&orcm_sensor_base.cache, &e->sampler->bucket);
+                OBJ_DESTRUCT(&e->sampler->bucket);
+                OBJ_CONSTRUCT(&e->sampler->bucket, opal_buffer_t);
+            }
+        }
+        /* move to the next period that hasn't passed yet */
+        e->deadline += e->rate;
+        if (e->deadline <= now) {
+            e->deadline += ((now - e->deadline) / e->rate + 1) * e->rate;
+        }
+        wheel_insert(e);
+    }
+    OBJ_DESTRUCT(&due);
+
+    wheel_arm(now_usec());
+}
+
+int orcm_sensor_base_sched_set_rate(const char *component, uint64_t usecs)
+{
+    orcm_sensor_active_module_t *i_module;
+    int i;
+
+    for (i=0; i < orcm_sensor_base.modules.size; i++) {
+        if (NULL == (i_module = (orcm_sensor_active_module_t*)opal_pointer_array_get_item(&orcm_sensor_base.modules, i))) {
+            continue;
+        }
+        if (0 == strcmp(component, i_module->component->base_version.mca_component_name)) {
+            i_module->rate = usecs;
+            return ORCM_SUCCESS;
+        }
+    }
+    return ORCM_ERR_NOT_FOUND;
+}
+
+void orcm_sensor_base_sched_start(void)
+{
+    orcm_sensor_active_module_t *i_module, *last = NULL;
+    orcm_sensor_sched_entry_t *entry;
+    char **rates, *ptr;
+    uint64_t now, usecs;
+    int i;
+
+    if (wheel_constructed) {
+        /* already running */
+        return;
+    }
+
+    /* apply the rates requested by the user */
+    if (NULL != orcm_sensor_base.sample_rates) {
+        rates = opal_argv_split(orcm_sensor_base.sample_rates, ',');
+        for (i=0; NULL != rates && NULL != rates[i]; i++) {
+            if (NULL == (ptr = strchr(rates[i], ':'))) {
+                opal_output(0, "%s sensor:base: ignoring sample rate %s - expected sensor:usecs",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), rates[i]);
+                continue;
+            }
+            *ptr++ = '\0';
+            usecs = strtoull(ptr, NULL, 10);
+            if (ORCM_SUCCESS != orcm_sensor_base_sched_set_rate(rates[i], usecs)) {
+                opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                    "%s sensor:base: sensor %s is not active - ignoring its sample rate",
+                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), rates[i]);
+            }
+        }
+        opal_argv_free(rates);
+    }
+
+    if (0 < orcm_sensor_base.wheel_tick) {
+        tick_usec = (uint64_t)orcm_sensor_base.wheel_tick;
+    }
+    for (i=0; i < ORCM_SENSOR_WHEEL_SLOTS; i++) {
+        OBJ_CONSTRUCT(&wheel[i], opal_list_t);
+    }
+    opal_event_evtimer_set(orcm_sensor_base.ev_base, &wheel_ev, wheel_fire, NULL);
+    wheel_constructed = true;
+
+    now = now_usec();
+    last_tick = now / tick_usec;
+    for (i=0; i < orcm_sensor_base.modules.size; i++) {
+        if (NULL == (i_module = (orcm_sensor_active_module_t*)opal_pointer_array_get_item(&orcm_sensor_base.modules, i))) {
+            continue;
+        }
+        last = i_module;
+        if (0 == i_module->rate) {
+            continue;
+        }
+        entry = OBJ_NEW(orcm_sensor_sched_entry_t);
+        entry->module = i_module;
+        entry->rate = i_module->rate;
+        entry->deadline = (now / entry->rate + 1) * entry->rate;
+        entry->sampler->log_data = orcm_sensor_base.log_samples;
+        entry->sampler->rate.tv_sec = entry->rate / 1000000;
+        entry->sampler->rate.tv_usec = entry->rate % 1000000;
+        wheel_insert(entry);
+        nentries++;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:base: sampling %s every %"PRIu64" usecs",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            i_module->component->base_version.mca_component_name,
+                            entry->rate);
+    }
+
+    /* without the base sampler, nothing else summarizes the rings */
+    if (!orcm_sensor_base.base_sampling && NULL != orcm_sensor_base.ring) {
+        usecs = (0 < orcm_sensor_base.ring_summary_rate) ?
+            (uint64_t)orcm_sensor_base.ring_summary_rate : ((NULL != last) ? last->rate : 0);
+        if (0 == usecs) {
+            opal_output(0, "%s sensor:base: no rate to summarize the sample rings at - "
+                        "set sensor_base_ring_summary_rate",
+                        ORTE_NAME_PRINT(ORTE_PROC_MY_NAME));
+        } else {
+            entry = OBJ_NEW(orcm_sensor_sched_entry_t);
+            entry->rate = usecs;
+            entry->deadline = (now / entry->rate + 1) * entry->rate;
+            wheel_insert(entry);
+            nentries++;
+            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:base: summarizing the sample rings every %"PRIu64" usecs",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), entry->rate);
+        }
+    }
+
+    wheel_arm(now);
+}
+
+void orcm_sensor_base_sched_finalize(void)
+{
+    int i;
+
+    if (!wheel_constructed) {
+        return;
+    }
+    if (wheel_armed) {
+        opal_event_evtimer_del(&wheel_ev);
+        wheel_armed = false;
+    }
+    for (i=0; i < ORCM_SENSOR_WHEEL_SLOTS; i++) {
+        OPAL_LIST_DESTRUCT(&wheel[i]);
+    }
+    nentries = 0;
+    wheel_constructed = false;
+}
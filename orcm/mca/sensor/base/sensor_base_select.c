@@ -220,5 +220,17 @@ int orcm_sensor_base_select(void)
         }
     }
 
+    /* index the survivors by name for logging the samples we receive */
+    for(i = 0; i < orcm_sensor_base.modules.size; ++i) {
+        i_module = (orcm_sensor_active_module_t*)opal_pointer_array_get_item(&orcm_sensor_base.modules, i);
+        if( NULL == i_module ) {
+            continue;
+        }
+        opal_hash_table_set_value_ptr(&orcm_sensor_base.log_modules,
+                                      i_module->component->base_version.mca_component_name,
+                                      strlen(i_module->component->base_version.mca_component_name),
+                                      i_module);
+    }
+
     return ORCM_SUCCESS;
 }
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif  /* HAVE_UNISTD_H */
+
+#include "opal_stdint.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+/*
+ * Persistent sysfs readers
+ *
+ * Opening a sysfs attribute, reading it through stdio and closing it
+ * again costs several syscalls and a couple of allocations per file and
+ * per sample. The files of a set are instead opened once and read with
+ * pread at offset 0, which makes sysfs regenerate the attribute, into a
+ * small stack buffer parsed in place. read_all reads the whole set in
+ * one pass so sensors with one file per core fetch them back to back.
+ */
+
+#define SYSFS_VALUE_MAX  32
+
+static void sysfs_con(orcm_sensor_sysfs_t *p)
+{
+    p->nfiles = 0;
+    p->size = 0;
+    p->fds = NULL;
+    p->values = NULL;
+    p->errs = NULL;
+}
+static void sysfs_des(orcm_sensor_sysfs_t *p)
+{
+    int i;
+
+    for (i=0; i < p->nfiles; i++) {
+        if (0 <= p->fds[i]) {
+            close(p->fds[i]);
+        }
+    }
+    if (NULL != p->fds) {
+        free(p->fds);
+    }
+    if (NULL != p->values) {
+        free(p->values);
+    }
+    if (NULL != p->errs) {
+        free(p->errs);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_sensor_sysfs_t,
+                   opal_object_t,
+                   sysfs_con, sysfs_des);
+
+int orcm_sensor_base_sysfs_parse(const char *buf, size_t len, int64_t *value)
+{
+    const char *end = buf + len;
+    int64_t val = 0;
+    bool neg = false, digits = false;
+
+    while (buf < end && (' ' == *buf || '\t' == *buf)) {
+        buf++;
+    }
+    if (buf < end && ('-' == *buf || '+' == *buf)) {
+        neg = ('-' == *buf);
+        buf++;
+    }
+    while (buf < end && '0' <= *buf && *buf <= '9') {
+        val = val * 10 + (*buf - '0');
+        digits = true;
+        buf++;
+    }
+    if (!digits) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    *value = neg ? -val : val;
+    return ORCM_SUCCESS;
+}
+
+int orcm_sensor_base_sysfs_add(orcm_sensor_sysfs_t *set, const char *path)
+{
+    int fd, idx, size;
+    int *fds, *errs;
+    int64_t *values;
+
+    if (0 > (fd = open(path, O_RDONLY))) {
+        return ORCM_ERR_FILE_OPEN_FAILURE;
+    }
+
+    /* reuse a free slot if there is one */
+    for (idx=0; idx < set->nfiles; idx++) {
+        if (0 > set->fds[idx]) {
+            break;
+        }
+    }
+    if (idx == set->size) {
+        /* an array that grew is kept even if another one can't, but
+         * the size only changes once all of them have */
+        size = (0 == set->size) ? 16 : 2 * set->size;
+        if (NULL == (fds = (int*)realloc(set->fds, size * sizeof(int)))) {
+            close(fd);
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        set->fds = fds;
+        if (NULL == (values = (int64_t*)realloc(set->values, size * sizeof(int64_t)))) {
+            close(fd);
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        set->values = values;
+        if (NULL == (errs = (int*)realloc(set->errs, size * sizeof(int)))) {
+            close(fd);
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        set->errs = errs;
+        set->size = size;
+    }
+    if (idx == set->nfiles) {
+        set->nfiles++;
+    }
+    set->fds[idx] = fd;
+    set->values[idx] = 0;
+    set->errs[idx] = 0;
+    return idx;
+}
+
+void orcm_sensor_base_sysfs_remove(orcm_sensor_sysfs_t *set, int idx)
+{
+    if (idx < 0 || set->nfiles <= idx || 0 > set->fds[idx]) {
+        return;
+    }
+    close(set->fds[idx]);
+    set->fds[idx] = -1;
+}
+
+int orcm_sensor_base_sysfs_read(orcm_sensor_sysfs_t *set, int idx, int64_t *value)
+{
+    char buf[SYSFS_VALUE_MAX];
+    ssize_t n;
+
+    if (idx < 0 || set->nfiles <= idx || 0 > set->fds[idx]) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 >= (n = pread(set->fds[idx], buf, sizeof(buf), 0))) {
+        set->errs[idx] = (0 == n) ? ENODATA : errno;
+        return ORCM_ERR_FILE_READ_FAILURE;
+    }
+    if (ORCM_SUCCESS != orcm_sensor_base_sysfs_parse(buf, n, &set->values[idx])) {
+        set->errs[idx] = EINVAL;
+        return ORCM_ERR_FILE_READ_FAILURE;
+    }
+    set->errs[idx] = 0;
+    *value = set->values[idx];
+    return ORCM_SUCCESS;
+}
+
+int orcm_sensor_base_sysfs_read_all(orcm_sensor_sysfs_t *set)
+{
+    int64_t value;
+    int i, nerrs = 0;
+
+    for (i=0; i < set->nfiles; i++) {
+        if (0 > set->fds[i]) {
+            continue;
+        }
+        if (ORCM_SUCCESS != orcm_sensor_base_sysfs_read(set, i, &value)) {
+            nerrs++;
+        }
+    }
+    return nerrs;
+}
@@ -24,6 +24,7 @@
 #include <unistd.h>
 #endif  /* HAVE_UNISTD_H */
 
+#include "opal/class/opal_hash_table.h"
 #include "opal/class/opal_pointer_array.h"
 #include "opal/mca/event/event.h"
 #include "opal/threads/threads.h"
@@ -73,12 +74,27 @@ typedef struct {
     int sample_rate;    /* Holds the rate at which the sensors need to be sampled in seconds */
     opal_buffer_t cache;  // caches any data collected by per-component threads
     opal_list_t policy; /* Holds user configured RAS event policy */
+    int policy_gen;     /* Bumped on every change to the policy list */
     int dbhandle;       /* Stores the unique database handle assigned for sensor framework after calling db_open */
     bool dbhandle_acquired;
     bool collect_metrics;       /* Holds the user configured variable indicating whether sensor metric sampling is enabled or not */
     bool collect_inventory;     /* Holds the user configured variable indicating whether inventory collection is enabled or not */
     bool set_dynamic_inventory; /* Holds the user configured variable indicating whether dynamic inventory collection is enabled or not */
     bool enable_group_commits; /* Enable per-buffer grouped commits(TRUE) or Enable per-component autocommits (FALSE)*/
+    bool compact_samples;       /* Send samples of components supporting it in compact form */
+    int schema_refresh;         /* Number of compact samples after which their schema is sent again */
+    char *change_only;          /* Sensors only reporting the values that changed since the last report */
+    char *sample_rates;         /* Sensors sampled at their own rate, in usecs */
+    int wheel_tick;             /* Resolution of the per-sensor sample scheduling, in usecs */
+    bool base_sampling;         /* The base sampler is running, and sends the samples in the cache */
+    char *ring;                 /* Sensors keeping their samples on the node and only sending summaries */
+    bool ring_mmap;             /* Back the sample rings with a file in the session dir */
+    int ring_summary_rate;      /* Usecs between ring summaries without the base sampler */
+    opal_pointer_array_t schemas;   /* Schemas of the compact samples sent by this process, by id */
+    uint32_t next_schema_id;        /* Id of the next schema - ids are never reused */
+    opal_mutex_t schema_lock;       /* Protects the schemas against the ring uploads */
+    opal_hash_table_t peer_schemas; /* Schemas of the compact samples received, by sender vpid and id */
+    opal_hash_table_t log_modules;  /* Active modules, by component name, to log the samples received */
 } orcm_sensor_base_t;
 
 typedef struct {
@@ -87,6 +103,7 @@ typedef struct {
     orcm_sensor_base_module_t *module;
     int priority;
     bool sampling;
+    uint64_t rate;      /* usecs between samples - 0 if sampled at the base rate */
 } orcm_sensor_active_module_t;
 OBJ_CLASS_DECLARATION(orcm_sensor_active_module_t);
 
@@ -115,13 +132,130 @@ ORCM_DECLSPEC extern orcm_sensor_base_t orcm_sensor_base;
 ORCM_DECLSPEC void orcm_sensor_base_start(orte_jobid_t job);
 ORCM_DECLSPEC void orcm_sensor_base_stop(orte_jobid_t job);
 ORCM_DECLSPEC void orcm_sensor_base_log(char *comp, opal_buffer_t *data);
+/* unpack a buffer packed in the given one as a view of its bytes
+ * rather than a copy - the view must be an empty constructed buffer,
+ * and must be dropped before the buffer it looks into is released.
+ * The view may only be unpacked */
+ORCM_DECLSPEC int orcm_sensor_base_unpack_view(opal_buffer_t *buffer, opal_buffer_t *view);
+ORCM_DECLSPEC void orcm_sensor_base_drop_view(opal_buffer_t *view);
 /* manually sample one or more sensors */
 ORCM_DECLSPEC void orcm_sensor_base_manually_sample(char *sensors,
                                                     orcm_sensor_sample_cb_fn_t cbfunc,
                                                     void *cbdata);
 ORCM_DECLSPEC void orcm_sensor_base_collect(int fd, short args, void *cbdata);
 ORCM_DECLSPEC void orcm_sensor_base_set_sample_rate(int sample_rate);
+
+/* name under which compact samples are packed in a sample bucket */
+#define ORCM_SENSOR_BASE_COMPACT    "compact"
+
+/* register the schema of the compact samples of a component. The
+ * labels and units are copied. Returns NULL if the type isn't supported */
+ORCM_DECLSPEC orcm_sensor_schema_t* orcm_sensor_base_schema_register(const char *component,
+                                                                     opal_data_type_t type,
+                                                                     int32_t nitems,
+                                                                     char **labels,
+                                                                     char **units);
+ORCM_DECLSPEC void orcm_sensor_base_schema_deregister(orcm_sensor_schema_t *schema);
+/* pack a sample of schema->nitems values into a bucket - nothing is
+ * packed if the schema only reports changes and none was detected */
+ORCM_DECLSPEC int orcm_sensor_base_pack_compact(opal_buffer_t *bucket,
+                                                orcm_sensor_schema_t *schema,
+                                                struct timeval *sampletime,
+                                                void *values);
+/* unpack a compact sample sent by the given process, following the
+ * ORCM_SENSOR_BASE_COMPACT name. The returned values and changed bitmap
+ * (NULL if all values were reported) are only valid until the next call */
+ORCM_DECLSPEC int orcm_sensor_base_unpack_compact(orte_process_name_t *sender,
+                                                  opal_buffer_t *data,
+                                                  orcm_sensor_schema_t **schema,
+                                                  struct timeval *sampletime,
+                                                  void **values,
+                                                  uint8_t **changed);
+#define ORCM_SENSOR_BASE_CHANGED(c, i)  (NULL == (c) || ((c)[(i) >> 3] & (1 << ((i) & 7))))
+/* unpack a compact sample and pass it to its component for logging */
+ORCM_DECLSPEC void orcm_sensor_base_log_compact(orte_process_name_t *sender,
+                                                opal_buffer_t *data);
+ORCM_DECLSPEC void orcm_sensor_base_compact_finalize(void);
+/* pack a summary of nsamples samples, given the min, max and average
+ * of each value */
+ORCM_DECLSPEC int orcm_sensor_base_pack_summary(opal_buffer_t *bucket,
+                                                orcm_sensor_schema_t *schema,
+                                                struct timeval *sampletime,
+                                                int32_t nsamples,
+                                                void *min, void *max, void *avg);
+/* access the values of compact samples */
+ORCM_DECLSPEC size_t orcm_sensor_base_type_size(opal_data_type_t type);
+ORCM_DECLSPEC double orcm_sensor_base_value_at(opal_data_type_t type, void *values, int32_t i);
+ORCM_DECLSPEC void orcm_sensor_base_set_value(opal_data_type_t type, void *values, int32_t i, double val);
+
+/* ring of the samples of a schema kept on the node. There is a single
+ * writer - the thread sampling the sensor - and readers copy the samples
+ * out without locking, discarding the ones overwritten meanwhile */
+typedef struct {
+    opal_object_t super;
+    opal_data_type_t type;
+    int32_t nitems;
+    uint32_t nslots;
+    size_t value_size;          /* nitems values */
+    size_t slot_size;           /* sample time and values */
+    volatile uint64_t *head;    /* number of samples ever stored */
+    uint64_t summarized;        /* head at the last summary - only accessed by the base thread */
+    char *slots;
+    void *map;                  /* mapping of the backing file, if any */
+    size_t maplen;
+    char *path;
+    /* summary scratch space - only accessed by the base thread */
+    struct timeval *times;
+    char *values;
+    char *stats;                /* min, max and average */
+} orcm_sensor_ring_t;
+OBJ_CLASS_DECLARATION(orcm_sensor_ring_t);
+
+/* give the schema a ring if its sensor is listed in sensor_base_ring */
+ORCM_DECLSPEC void orcm_sensor_base_ring_setup(orcm_sensor_schema_t *schema);
+ORCM_DECLSPEC void orcm_sensor_base_ring_store(orcm_sensor_ring_t *ring,
+                                               struct timeval *sampletime,
+                                               void *values);
+/* copy the samples stored since *from, up to max of them, and return
+ * their number - *from is moved past the samples copied, skipping
+ * those that were overwritten */
+ORCM_DECLSPEC uint32_t orcm_sensor_base_ring_read(orcm_sensor_ring_t *ring,
+                                                  uint64_t *from, uint32_t max,
+                                                  struct timeval *sampletimes,
+                                                  void *values);
+/* pack a summary of the samples stored in each ring since the last one */
+ORCM_DECLSPEC void orcm_sensor_base_ring_summarize(opal_buffer_t *bucket);
+/* pack the samples held for a sensor in response to an upload request */
+ORCM_DECLSPEC int orcm_sensor_base_ring_upload(opal_buffer_t *buf, char *component);
+
+/* set of sysfs files holding a single integer. The files are kept open
+ * and read with pread into a stack buffer, so a sample costs a single
+ * syscall per file and no allocation */
+typedef struct {
+    opal_object_t super;
+    int nfiles;                 /* slots in use or free */
+    int size;                   /* slots allocated */
+    int *fds;                   /* -1 for a free slot */
+    int64_t *values;            /* last value read */
+    int *errs;                  /* 0, or the errno of the last read */
+} orcm_sensor_sysfs_t;
+OBJ_CLASS_DECLARATION(orcm_sensor_sysfs_t);
+
+/* open a file and return its index in the set, or an ORCM error code */
+ORCM_DECLSPEC int orcm_sensor_base_sysfs_add(orcm_sensor_sysfs_t *set, const char *path);
+ORCM_DECLSPEC void orcm_sensor_base_sysfs_remove(orcm_sensor_sysfs_t *set, int idx);
+ORCM_DECLSPEC int orcm_sensor_base_sysfs_read(orcm_sensor_sysfs_t *set, int idx, int64_t *value);
+/* read every file of the set into set->values and return the number
+ * of files that could not be read - see set->errs */
+ORCM_DECLSPEC int orcm_sensor_base_sysfs_read_all(orcm_sensor_sysfs_t *set);
+ORCM_DECLSPEC int orcm_sensor_base_sysfs_parse(const char *buf, size_t len, int64_t *value);
 ORCM_DECLSPEC void orcm_sensor_base_get_sample_rate(int *sample_rate);
 
+/* sample a module every usecs instead of at the base rate - to be
+ * called before the sensors are started, e.g., from the module init */
+ORCM_DECLSPEC int orcm_sensor_base_sched_set_rate(const char *component, uint64_t usecs);
+ORCM_DECLSPEC void orcm_sensor_base_sched_start(void);
+ORCM_DECLSPEC void orcm_sensor_base_sched_finalize(void);
+
 END_C_DECLS
 #endif
@@ -26,9 +26,11 @@
 #include <dirent.h>
 #endif  /* HAVE_DIRENT_H */
 #include <ctype.h>
+#include <math.h>
 
 #include "opal_stdint.h"
 #include "opal/class/opal_list.h"
+#include "opal/class/opal_hash_table.h"
 #include "opal/dss/dss.h"
 #include "opal/util/os_path.h"
 #include "opal/util/output.h"
@@ -60,6 +62,10 @@ static void coretemp_sample(orcm_sensor_sampler_t *sampler);
 static void perthread_coretemp_sample(int fd, short args, void *cbdata);
 static void collect_sample(orcm_sensor_sampler_t *sampler);
 static void coretemp_log(opal_buffer_t *buf);
+static void coretemp_log_compact(orcm_sensor_schema_t *schema,
+                                 struct timeval *sampletime,
+                                 void *values,
+                                 uint8_t *changed);
 static void coretemp_set_sample_rate(int sample_rate);
 static void coretemp_get_sample_rate(int *sample_rate);
 
@@ -74,45 +80,44 @@ orcm_sensor_base_module_t orcm_sensor_coretemp_module = {
     NULL,
     NULL,
     coretemp_set_sample_rate,
-    coretemp_get_sample_rate
+    coretemp_get_sample_rate,
+    coretemp_log_compact
 };
 
 /****    CORETEMP EVENT HISTORY TYPE    ****/
-/* To reduce memory footprint, we don't store the count for all nodes and cores.
- * we only keep the count of the specific core of specific node that ever cross
- * threshold.
+/* To reduce memory footprint, we don't store the count for all nodes.
+ * we only keep the counts of the nodes that ever crossed a threshold.
  * An event history consists of:
  * hostname: host name of the compute node that we see coretemp cross threshold
- * core_no: the core number of the compute node that we see coretemp cross threshold
- * hi_thres: high or low threshold
- * severity: severity level assigned to this event
- * count: the number of samples that we see coretemp cross threshold
- * tstamp: timestamp of the cross threshold sample last seen
+ * gen: generation of the policy list the counts refer to
+ * ncores: number of cores of the node
+ * count: the number of samples that we see coretemp cross threshold, for
+ *        each (policy, core) as policy * ncores + core
+ * tstamp: timestamp of the first sample of the time window, 0 if none
  */
 typedef struct {
     opal_list_item_t super;
     char   *hostname;
-    int    core_no;
-    bool   hi_thres;
-    orte_notifier_severity_t severity;
-    int    count;
-    time_t tstamp;
+    int    gen;
+    int    ncores;
+    int    *count;
+    time_t *tstamp;
 } coretemp_history_t;
 static void hst_con(coretemp_history_t *hst)
 {
     hst->hostname = NULL;
-    hst->core_no  = 0;
-    hst->hi_thres = true;
-    hst->severity = ORTE_NOTIFIER_INFO;
-    hst->count    = 0;
-    hst->tstamp   = 0;
+    hst->gen      = -1;
+    hst->ncores   = 0;
+    hst->count    = NULL;
+    hst->tstamp   = NULL;
 }
 static void hst_des(coretemp_history_t *hst)
 {
     if (NULL != hst->hostname) {
         free(hst->hostname);
     }
-
+    free(hst->count);
+    free(hst->tstamp);
 }
 OBJ_CLASS_INSTANCE(coretemp_history_t,
                    opal_list_item_t,
@@ -121,6 +126,7 @@ OBJ_CLASS_INSTANCE(coretemp_history_t,
 typedef struct {
     opal_list_item_t super;
     char *file;
+    int sysfs;      /* index of the file in coretemp_files */
     int socket;
     int core;
     char *label;
@@ -130,6 +136,7 @@ typedef struct {
 static void ctr_con(coretemp_tracker_t *trk)
 {
     trk->file = NULL;
+    trk->sysfs = -1;
     trk->label = NULL;
     trk->socket = -1;
     trk->core = -1;
@@ -149,9 +156,21 @@ OBJ_CLASS_INSTANCE(coretemp_tracker_t,
 
 static bool log_enabled = true;
 static opal_list_t tracking;
+static orcm_sensor_sysfs_t coretemp_files;
 static opal_list_t event_history;
+static opal_hash_table_t event_history_hosts;
+/* the coretemp policies, compiled when the policy list changes: a core
+ * crosses policy p when policy_sign[p] * temp >= policy_limit[p] */
+static int policy_gen = -1;
+static int npolicies = 0;
+static orcm_sensor_policy_t **policies = NULL;
+static float *policy_sign = NULL;
+static float *policy_limit = NULL;
+static uint8_t *policy_crossed = NULL;
+static int policy_ncores = 0;
 static orcm_sensor_sampler_t *coretemp_sampler = NULL;
 static orcm_sensor_coretemp_t orcm_sensor_coretemp;
+static orcm_sensor_schema_t *coretemp_schema = NULL;
 
 static void generate_test_vector(opal_buffer_t *v);
 char **coretemp_policy_list; /* store coretemp policies from MCA parameter */
@@ -249,6 +268,7 @@ static int coretemp_load_policy(char *policy)
                 break;
             }
         }
+        orcm_sensor_base.policy_gen++;
 
         if ( !found_me ) {
             /* matched policy not found, insert into policy list */
@@ -285,128 +305,174 @@ done:
     return ret;
 }
 
-static int coretemp_policy_filter(char *hostname, int core_no, float ct, time_t ts)
+static int coretemp_compile_policies(void)
 {
     orcm_sensor_policy_t *plc;
-    coretemp_history_t *hst, *newhst;
-    bool found_me;
-    char *sev;
+    int n = 0;
+
+    free(policies);
+    free(policy_sign);
+    free(policy_limit);
+    policies = NULL;
+    policy_sign = NULL;
+    policy_limit = NULL;
+    npolicies = 0;
+
+    OPAL_LIST_FOREACH(plc, &orcm_sensor_base.policy, orcm_sensor_policy_t) {
+        if (0 == strcmp(plc->sensor_name, "coretemp")) {
+            n++;
+        }
+    }
+    if (0 < n) {
+        policies = (orcm_sensor_policy_t**)malloc(n * sizeof(orcm_sensor_policy_t*));
+        policy_sign = (float*)malloc(n * sizeof(float));
+        policy_limit = (float*)malloc(n * sizeof(float));
+        if (NULL == policies || NULL == policy_sign || NULL == policy_limit) {
+            return ORCM_ERR_OUT_OF_RESOURCE;
+        }
+        OPAL_LIST_FOREACH(plc, &orcm_sensor_base.policy, orcm_sensor_policy_t) {
+            /* check for coretemp sensor type */
+            if (0 != strcmp(plc->sensor_name, "coretemp")) {
+                continue;
+            }
+            policies[npolicies] = plc;
+            policy_sign[npolicies] = plc->hi_thres ? 1.0 : -1.0;
+            policy_limit[npolicies] = policy_sign[npolicies] * plc->threshold;
+            npolicies++;
+        }
+    }
+    policy_gen = orcm_sensor_base.policy_gen;
+    return ORCM_SUCCESS;
+}
+
+static const char *coretemp_severity(orte_notifier_severity_t severity)
+{
+    switch (severity) {
+    case ORTE_NOTIFIER_EMERG:
+        return "EMERG";
+    case ORTE_NOTIFIER_ALERT:
+        return "ALERT";
+    case ORTE_NOTIFIER_CRIT:
+        return "CRIT";
+    case ORTE_NOTIFIER_ERROR:
+        return "ERROR";
+    case ORTE_NOTIFIER_WARN:
+        return "WARN";
+    case ORTE_NOTIFIER_NOTICE:
+        return "NOTICE";
+    case ORTE_NOTIFIER_INFO:
+        return "INFO";
+    case ORTE_NOTIFIER_DEBUG:
+        return "DEBUG";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+static coretemp_history_t *coretemp_get_history(char *hostname, int ncores)
+{
+    coretemp_history_t *hst = NULL;
+    int n = npolicies * ncores;
+
+    if (OPAL_SUCCESS != opal_hash_table_get_value_ptr(&event_history_hosts, hostname,
+                                                      strlen(hostname), (void**)&hst)) {
+        hst = OBJ_NEW(coretemp_history_t);
+        hst->hostname = strdup(hostname);
+        opal_hash_table_set_value_ptr(&event_history_hosts, hostname,
+                                      strlen(hostname), hst);
+        opal_list_append(&event_history, &hst->super);
+    }
+    if (hst->gen != policy_gen || hst->ncores != ncores) {
+        /* the policies changed - start counting over */
+        free(hst->count);
+        free(hst->tstamp);
+        hst->count = (int*)calloc(n, sizeof(int));
+        hst->tstamp = (time_t*)calloc(n, sizeof(time_t));
+        if (NULL == hst->count || NULL == hst->tstamp) {
+            hst->gen = -1;
+            return NULL;
+        }
+        hst->gen = policy_gen;
+        hst->ncores = ncores;
+    }
+    return hst;
+}
+
+static int coretemp_policy_filter(char *hostname, int32_t ncores, float *ct, time_t ts)
+{
+    orcm_sensor_policy_t *plc;
+    coretemp_history_t *hst = NULL;
+    int p, i, k;
     char *msg;
 
-    /* Check if this sample may be filtered
+    if (policy_gen != orcm_sensor_base.policy_gen &&
+        ORCM_SUCCESS != coretemp_compile_policies()) {
+        return 0;
+    }
+    if (0 == npolicies || 0 >= ncores) {
+        return 1;
+    }
+    if (policy_ncores < ncores) {
+        free(policy_crossed);
+        if (NULL == (policy_crossed = (uint8_t*)malloc(ncores))) {
+            policy_ncores = 0;
+            return 0;
+        }
+        policy_ncores = ncores;
+    }
+
+    /* Check if these samples may be filtered
      * We have to check for all policies, one single sample might trigger
      * multiple events with different severity levels
      */
-    OPAL_LIST_FOREACH(plc, &orcm_sensor_base.policy, orcm_sensor_policy_t) {
-        /* check for coretemp sensor type */
-        if ( 0 != strcmp(plc->sensor_name, "coretemp") ) {
-            continue;
+    for (p = 0; p < npolicies; p++) {
+        plc = policies[p];
+        /* compare all the cores against this policy at once */
+        k = 0;
+        for (i = 0; i < ncores; i++) {
+            policy_crossed[i] = (policy_sign[p] * ct[i] >= policy_limit[p]);
+            k += policy_crossed[i];
         }
-
-        if ( (plc->hi_thres && (ct < plc->threshold) ) ||
-             (!plc->hi_thres && (ct > plc->threshold) ) ) {
+        if (0 == k) {
             continue;
         }
-
-        switch ( plc->severity ) {
-        case ORTE_NOTIFIER_EMERG:
-            sev = strdup("EMERG");
-            break;
-        case ORTE_NOTIFIER_ALERT:
-            sev = strdup("ALERT");
-            break;
-        case ORTE_NOTIFIER_CRIT:
-            sev = strdup("CRIT");
-            break;
-        case ORTE_NOTIFIER_ERROR:
-            sev = strdup("ERROR");
-            break;
-        case ORTE_NOTIFIER_WARN:
-            sev = strdup("WARN");
-            break;
-        case ORTE_NOTIFIER_NOTICE:
-            sev = strdup("NOTICE");
-            break;
-        case ORTE_NOTIFIER_INFO:
-            sev = strdup("INFO");
-            break;
-        case ORTE_NOTIFIER_DEBUG:
-            sev = strdup("DEBUG");
-            break;
-        default:
-            sev = strdup("UNKNOWN");
-            break;
+        if (NULL == hst && NULL == (hst = coretemp_get_history(hostname, ncores))) {
+            return 0;
         }
 
-        /* this sample should be accounted for this policy
-         * we have a candidate, let's check there is similar sample accounted in history or not
-         */
-        found_me = false;
-        OPAL_LIST_FOREACH(hst, &event_history, coretemp_history_t) {
-            /* check for any matching record in history list */
-            /* match by host name and core number */
-            if (   hst->tstamp &&
-                 ( 0 == strcmp(hostname, hst->hostname) ) &&
-                 ( core_no == hst->core_no ) &&
-                 ( plc->hi_thres == hst->hi_thres ) &&
-                 ( plc->severity == hst->severity) ) {
-                found_me = true;
-                /* this sample pattern has been captured in history
-                 * let's test the time windows expiration
-                 */
-                if ( (hst->tstamp + plc->time_window) < ts ) {
-                    /* Matching history record had expired, just overwrite it */
-                    hst->count = 1;
-                    hst->tstamp = ts;
-                } else {
-                    hst->count++;
-                }
-
-                /* filter policy threshold reached */
-                if ( hst->count >= plc->max_count ) {
-                    /* fire an event */
-                    asprintf(&msg, "host: %s core %d temperature %f °C, %s than or equal to threshold %f °C for %d times in %d seconds",
-                                    hostname, core_no, ct, plc->hi_thres ? "higher" : "lower",
-                                    plc->threshold, plc->max_count, plc->time_window);
-                    ORTE_NOTIFIER_SYSTEM_EVENT(plc->severity, msg, plc->action);
-                    opal_output(0, "host: %s core %d temperature %f °C, %s than or equal to threshold %f °C for %d times in %d seconds, trigger %s event!",
-                                    hostname, core_no, ct, plc->hi_thres ? "higher" : "lower",
-                                    plc->threshold, plc->max_count, plc->time_window, sev);
-                    /* stop watching for this history record, remove from list */
-                    opal_list_remove_item(&event_history, &hst->super);
-                }
-
-                break;
+        for (i = 0; i < ncores; i++) {
+            if (!policy_crossed[i]) {
+                continue;
+            }
+            /* this sample should be accounted for this policy - start a
+             * new time window if there is none or it expired */
+            k = p * ncores + i;
+            if (0 == hst->tstamp[k] || (hst->tstamp[k] + plc->time_window) < ts) {
+                hst->count[k] = 1;
+                hst->tstamp[k] = ts;
+            } else {
+                hst->count[k]++;
             }
-        }
 
-        if ( !found_me ) {
-            /* matched sample not seen before, insert into history list */
-            if ( 1 == plc->max_count ) {
-                /* fire an event right away, no need to store in history list */
+            /* filter policy threshold reached */
+            if (hst->count[k] >= plc->max_count) {
+                /* fire an event */
                 asprintf(&msg, "host: %s core %d temperature %f °C, %s than or equal to threshold %f °C for %d times in %d seconds",
-                                    hostname, core_no, ct, plc->hi_thres ? "higher" : "lower",
-                                    plc->threshold, plc->max_count, plc->time_window);
+                                hostname, i, ct[i], plc->hi_thres ? "higher" : "lower",
+                                plc->threshold, plc->max_count, plc->time_window);
                 ORTE_NOTIFIER_SYSTEM_EVENT(plc->severity, msg, plc->action);
-                opal_output(0, "host: %s Core %d temperature %f °C, %s than or equal to threshold %f °C for %d times in %d seconds, trigger %s event!",
-                                    hostname, core_no, ct, plc->hi_thres ? "higher" : "lower",
-                                    plc->threshold, plc->max_count, plc->time_window, sev);
-            } else {
-                newhst = OBJ_NEW(coretemp_history_t);
-                newhst->hostname = strdup(hostname);
-                newhst->core_no = core_no;
-                newhst->hi_thres = plc->hi_thres;
-                newhst->severity = plc->severity;
-                newhst->count = 1;
-                newhst->tstamp = ts;
-                opal_list_append(&event_history, &newhst->super);
+                opal_output(0, "host: %s core %d temperature %f °C, %s than or equal to threshold %f °C for %d times in %d seconds, trigger %s event!",
+                                hostname, i, ct[i], plc->hi_thres ? "higher" : "lower",
+                                plc->threshold, plc->max_count, plc->time_window,
+                                coretemp_severity(plc->severity));
+                /* stop watching for this core */
+                hst->count[k] = 0;
+                hst->tstamp[k] = 0;
             }
         }
-        free(sev);
     }
 
-
-  return 1;
+    return 1;
 }
 
 /* FOR FUTURE: extend to read cooling device speeds in
@@ -433,7 +499,10 @@ static int init(void)
 
     /* always construct this so we don't segfault in finalize */
     OBJ_CONSTRUCT(&tracking, opal_list_t);
+    OBJ_CONSTRUCT(&coretemp_files, orcm_sensor_sysfs_t);
     OBJ_CONSTRUCT(&event_history, opal_list_t);
+    OBJ_CONSTRUCT(&event_history_hosts, opal_hash_table_t);
+    opal_hash_table_init(&event_history_hosts, 64);
 
     /* get policy from MCA parameters */
     if( NULL != mca_sensor_coretemp_component.policy ) {
@@ -659,8 +728,25 @@ static int init(void)
 
 static void finalize(void)
 {
+    if (NULL != coretemp_schema) {
+        orcm_sensor_base_schema_deregister(coretemp_schema);
+        coretemp_schema = NULL;
+    }
     OPAL_LIST_DESTRUCT(&tracking);
+    OBJ_DESTRUCT(&coretemp_files);
+    OBJ_DESTRUCT(&event_history_hosts);
     OPAL_LIST_DESTRUCT(&event_history);
+    free(policies);
+    free(policy_sign);
+    free(policy_limit);
+    free(policy_crossed);
+    policies = NULL;
+    policy_sign = NULL;
+    policy_limit = NULL;
+    policy_crossed = NULL;
+    npolicies = 0;
+    policy_ncores = 0;
+    policy_gen = -1;
 }
 
 /*
@@ -745,11 +831,128 @@ static void perthread_coretemp_sample(int fd, short args, void *cbdata)
     opal_event_evtimer_add(&sampler->ev, &sampler->rate);
 }
 
+/* open the temp file of the cores we haven't read yet, dropping those
+ * we can't open, and read the temps of all the cores in one pass */
+static void read_temps(void)
+{
+    coretemp_tracker_t *trk, *nxt;
+
+    OPAL_LIST_FOREACH_SAFE(trk, nxt, &tracking, coretemp_tracker_t) {
+        if (0 <= trk->sysfs) {
+            continue;
+        }
+        if (0 > (trk->sysfs = orcm_sensor_base_sysfs_add(&coretemp_files, trk->file))) {
+            /* we can't be read, so remove it from the list */
+            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                "%s access denied to coretemp file %s - removing it",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                trk->file);
+            opal_list_remove_item(&tracking, &trk->super);
+            OBJ_RELEASE(trk);
+        }
+    }
+    orcm_sensor_base_sysfs_read_all(&coretemp_files);
+}
+
+/* read each core temp into an array of floats and pack them as a
+ * compact sample. Every tracked core has its place in the schema and
+ * one that can't be read this time is sent as NaN, so a new schema is
+ * only registered when the set of tracked cores has changed */
+static void collect_compact_sample(orcm_sensor_sampler_t *sampler)
+{
+    coretemp_tracker_t *trk;
+    float *degc;
+    char **labels, **units;
+    int32_t ncores = 0, nread = 0;
+    size_t max;
+    struct timeval current_time;
+    bool same;
+    int i;
+
+    max = opal_list_get_size(&tracking);
+    degc = (float*)malloc(max * sizeof(float));
+    labels = (char**)calloc(max + 1, sizeof(char*));
+    if (NULL == degc || NULL == labels) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        goto cleanup;
+    }
+
+    /* get the sample time */
+    gettimeofday(&current_time, NULL);
+
+    OPAL_LIST_FOREACH(trk, &tracking, coretemp_tracker_t) {
+        labels[ncores] = trk->label;
+        if (0 != coretemp_files.errs[trk->sysfs]) {
+            degc[ncores++] = NAN;
+            continue;
+        }
+        nread++;
+        degc[ncores] = coretemp_files.values[trk->sysfs] / 1000.0;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:coretemp: Core %d in Socket %d temp %f max %f critical %f",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            trk->core, trk->socket, degc[ncores], trk->max_temp, trk->critical_temp);
+        if (trk->critical_temp < degc[ncores]) {
+            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:coretemp: Core %d (socket %d) CRITICAL",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                trk->core, trk->socket);
+        } else if (trk->max_temp < degc[ncores]) {
+            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:coretemp: Core %d (socket %d) MAX",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                trk->core, trk->socket);
+        }
+        ncores++;
+    }
+
+    if (0 == nread) {
+        goto cleanup;
+    }
+
+    same = (NULL != coretemp_schema && ncores == coretemp_schema->nitems);
+    for (i=0; same && i < ncores; i++) {
+        same = (0 == strcmp(labels[i], coretemp_schema->labels[i]));
+    }
+    if (!same) {
+        if (NULL != coretemp_schema) {
+            orcm_sensor_base_schema_deregister(coretemp_schema);
+        }
+        units = (char**)calloc(ncores + 1, sizeof(char*));
+        if (NULL == units) {
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            coretemp_schema = NULL;
+            goto cleanup;
+        }
+        for (i=0; i < ncores; i++) {
+            units[i] = "degrees C";
+        }
+        coretemp_schema = orcm_sensor_base_schema_register("coretemp", OPAL_FLOAT,
+                                                           ncores, labels, units);
+        free(units);
+        if (NULL == coretemp_schema) {
+            ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+            goto cleanup;
+        }
+    }
+
+    orcm_sensor_base_pack_compact(&sampler->bucket, coretemp_schema,
+                                  &current_time, degc);
+
+cleanup:
+    if (NULL != degc) {
+        free(degc);
+    }
+    if (NULL != labels) {
+        /* the labels belong to the trackers */
+        free(labels);
+    }
+}
+
 static void collect_sample(orcm_sensor_sampler_t *sampler)
 {
     int ret;
-    coretemp_tracker_t *trk, *nxt;
-    FILE *fp;
+    coretemp_tracker_t *trk;
     char *temp;
     float degc;
     opal_buffer_t data, *bptr;
@@ -771,6 +974,13 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
+    read_temps();
+
+    if (orcm_sensor_base.compact_samples) {
+        collect_compact_sample(sampler);
+        return;
+    }
+
     /* prep to store the results */
     OBJ_CONSTRUCT(&data, opal_buffer_t);
     packed = false;
@@ -791,8 +1001,13 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
-    /* store the number of cores */
-    ncores = (int32_t)opal_list_get_size(&tracking);
+    /* store the number of cores we could read */
+    ncores = 0;
+    OPAL_LIST_FOREACH(trk, &tracking, coretemp_tracker_t) {
+        if (0 == coretemp_files.errs[trk->sysfs]) {
+            ncores++;
+        }
+    }
     if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ncores, 1, OPAL_INT32))) {
         ORTE_ERROR_LOG(ret);
         OBJ_DESTRUCT(&data);
@@ -808,55 +1023,40 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
-    OPAL_LIST_FOREACH_SAFE(trk, nxt, &tracking, coretemp_tracker_t) {
-        /* read the temp */
-        if (NULL == (fp = fopen(trk->file, "r"))) {
-            /* we can't be read, so remove it from the list */
-            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
-                                "%s access denied to coretemp file %s - removing it",
-                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                trk->file);
-            opal_list_remove_item(&tracking, &trk->super);
-            OBJ_RELEASE(trk);
+    OPAL_LIST_FOREACH(trk, &tracking, coretemp_tracker_t) {
+        if (0 != coretemp_files.errs[trk->sysfs]) {
             continue;
         }
         if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &trk->label, 1, OPAL_STRING))) {
             ORTE_ERROR_LOG(ret);
-            fclose(fp);
             OBJ_DESTRUCT(&data);
             return;
         }
-        while (NULL != (temp = orte_getline(fp))) {
-            degc = strtoul(temp, NULL, 10) / 1000.0;
+        degc = coretemp_files.values[trk->sysfs] / 1000.0;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:coretemp: Core %d in Socket %d temp %f max %f critical %f",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            trk->core, trk->socket, degc, trk->max_temp, trk->critical_temp);
+        if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &degc, 1, OPAL_FLOAT))) {
+            ORTE_ERROR_LOG(ret);
+            OBJ_DESTRUCT(&data);
+            return;
+        }
+        packed = true;
+        /* check for exceed critical temp */
+        if (trk->critical_temp < degc) {
+            /* alert the errmgr - this is a critical problem */
             opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
-                                "%s sensor:coretemp: Core %d in Socket %d temp %f max %f critical %f",
+                                "%s sensor:coretemp: Core %d (socket %d) CRITICAL",
                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                trk->core, trk->socket, degc, trk->max_temp, trk->critical_temp);
-            if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &degc, 1, OPAL_FLOAT))) {
-                ORTE_ERROR_LOG(ret);
-                free(temp);
-                fclose(fp);
-                OBJ_DESTRUCT(&data);
-                return;
-            }
-            free(temp);
-            packed = true;
-            /* check for exceed critical temp */
-            if (trk->critical_temp < degc) {
-                /* alert the errmgr - this is a critical problem */
-                opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
-                                    "%s sensor:coretemp: Core %d (socket %d) CRITICAL",
-                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                    trk->core, trk->socket);
-             } else if (trk->max_temp < degc) {
-                /* alert the errmgr */
-                opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
-                                    "%s sensor:coretemp: Core %d (socket %d) MAX",
-                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                    trk->core, trk->socket);
-             }
+                                trk->core, trk->socket);
+        } else if (trk->max_temp < degc) {
+            /* alert the errmgr */
+            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:coretemp: Core %d (socket %d) MAX",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                trk->core, trk->socket);
         }
-        fclose(fp);
     }
 
     /* xfer the data for transmission */
@@ -880,49 +1080,24 @@ static void mycleanup(int dbhandle, int status, opal_list_t *kvs,
     }
 }
 
-static void coretemp_log(opal_buffer_t *sample)
+/* only the values flagged in changed (all if NULL) are stored - the
+ * others are the last values reported and only go to the event policy
+ * and analytics. Cores that could not be read (NaN) are left out */
+static void coretemp_log_values(char *hostname, struct timeval *sampletime,
+                                int32_t ncores, char **labels, float *fvals,
+                                uint8_t *changed)
 {
-    char *hostname=NULL;
-    struct timeval sampletime;
-    int rc;
-    int32_t n, ncores;
     opal_list_t *vals;
     opal_value_t *kv;
-    float fval;
-    int i;
-    char *core_label;
+    int i, nstored = 0, nanalyzed = 0;
     opal_value_array_t *analytics_sample_array = NULL;
     int analytics_rc;
     orcm_metric_value_t *sensor_metric;
 
-    if (!log_enabled) {
-        return;
-    }
-
-    /* unpack the host this came from */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &hostname, &n, OPAL_STRING))) {
-        ORTE_ERROR_LOG(rc);
-        return;
-    }
-    /* and the number of cores on that host */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &ncores, &n, OPAL_INT32))) {
-        ORTE_ERROR_LOG(rc);
-        goto cleanup;
-    }
-
-    /* sample time */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &sampletime, &n, OPAL_TIMEVAL))) {
-        ORTE_ERROR_LOG(rc);
-        goto cleanup;
-    }
-
     opal_output_verbose(3, orcm_sensor_base_framework.framework_output,
                         "%s Received log from host %s with %d cores",
                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                        (NULL == hostname) ? "NULL" : hostname, ncores);
+                        hostname, ncores);
 
     /* xfr to storage */
     vals = OBJ_NEW(opal_list_t);
@@ -930,14 +1105,10 @@ static void coretemp_log(opal_buffer_t *sample)
     kv = OBJ_NEW(opal_value_t);
     kv->key = strdup("ctime");
     kv->type = OPAL_TIMEVAL;
-    kv->data.tv = sampletime;
+    kv->data.tv = *sampletime;
     opal_list_append(vals, &kv->super);
 
     /* load the hostname */
-    if (NULL == hostname) {
-        ORTE_ERROR_LOG(OPAL_ERR_BAD_PARAM);
-        goto cleanup;
-    }
     kv = OBJ_NEW(opal_value_t);
     kv->key = strdup("hostname");
     kv->type = OPAL_STRING;
@@ -954,43 +1125,40 @@ static void coretemp_log(opal_buffer_t *sample)
     kv->data.string = strdup("coretemp");
     opal_list_append(vals, &kv->super);
 
+    /* check coretemp event policy */
+    coretemp_policy_filter(hostname, ncores, fvals, sampletime->tv_sec);
+
     /*If analytics_rc returns error, rest of the analytics API's will not be called */
     analytics_rc = orcm_analytics.array_create(&analytics_sample_array, ncores);
 
     for (i=0; i < ncores; i++) {
+        if (isnan(fvals[i])) {
+            continue;
+        }
         sensor_metric = OBJ_NEW(orcm_metric_value_t);
         if (NULL == sensor_metric) {
             ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
             goto cleanup;
         }
-        n=1;
-        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &core_label, &n, OPAL_STRING))) {
-            ORTE_ERROR_LOG(rc);
-            goto cleanup;
-        }
-        sensor_metric->value.key = strdup(core_label);
+        sensor_metric->value.key = strdup(labels[i]);
         sensor_metric->units = strdup("degrees C");
-        free(core_label);
         sensor_metric->value.type = OPAL_FLOAT;
-        n=1;
-        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &fval, &n, OPAL_FLOAT))) {
-            ORTE_ERROR_LOG(rc);
-            goto cleanup;
-        }
-
-        /* check coretemp event policy */
-        coretemp_policy_filter(hostname, i, fval, sampletime.tv_sec);
 
-        sensor_metric->value.data.fval = fval;
-        opal_list_append(vals, (opal_list_item_t *)sensor_metric);
+        sensor_metric->value.data.fval = fvals[i];
         if (ORCM_SUCCESS == analytics_rc) {
-            analytics_rc = orcm_analytics.array_append(analytics_sample_array, i, "coretemp",
+            analytics_rc = orcm_analytics.array_append(analytics_sample_array, nanalyzed++, "coretemp",
                                                        hostname, sensor_metric);
         }
+        if (ORCM_SENSOR_BASE_CHANGED(changed, i)) {
+            opal_list_append(vals, (opal_list_item_t *)sensor_metric);
+            nstored++;
+        } else {
+            OBJ_RELEASE(sensor_metric);
+        }
     }
 
     /* store it */
-    if (0 <= orcm_sensor_base.dbhandle) {
+    if (0 <= orcm_sensor_base.dbhandle && 0 < nstored) {
         orcm_db.store_new(orcm_sensor_base.dbhandle, ORCM_DB_ENV_DATA, vals, NULL, mycleanup, NULL);
     } else {
         OPAL_LIST_RELEASE(vals);
@@ -1005,11 +1173,97 @@ static void coretemp_log(opal_buffer_t *sample)
     if (NULL != analytics_sample_array) {
         orcm_analytics.array_cleanup(analytics_sample_array);
     }
+}
+
+static void coretemp_log(opal_buffer_t *sample)
+{
+    char *hostname=NULL;
+    struct timeval sampletime;
+    int rc;
+    int32_t n, ncores;
+    int i;
+    char **labels = NULL;
+    float *fvals = NULL;
+
+    if (!log_enabled) {
+        return;
+    }
+
+    /* unpack the host this came from */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &hostname, &n, OPAL_STRING))) {
+        ORTE_ERROR_LOG(rc);
+        return;
+    }
+    /* and the number of cores on that host */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &ncores, &n, OPAL_INT32))) {
+        ORTE_ERROR_LOG(rc);
+        goto cleanup;
+    }
+
+    /* sample time */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &sampletime, &n, OPAL_TIMEVAL))) {
+        ORTE_ERROR_LOG(rc);
+        goto cleanup;
+    }
+
+    /* load the hostname */
+    if (NULL == hostname || 0 > ncores) {
+        ORTE_ERROR_LOG(OPAL_ERR_BAD_PARAM);
+        goto cleanup;
+    }
+
+    labels = (char**)calloc(ncores + 1, sizeof(char*));
+    fvals = (float*)malloc((ncores + 1) * sizeof(float));
+    if (NULL == labels || NULL == fvals) {
+        ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+        goto cleanup;
+    }
+    for (i=0; i < ncores; i++) {
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &labels[i], &n, OPAL_STRING))) {
+            ORTE_ERROR_LOG(rc);
+            goto cleanup;
+        }
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &fvals[i], &n, OPAL_FLOAT))) {
+            ORTE_ERROR_LOG(rc);
+            goto cleanup;
+        }
+    }
+
+    coretemp_log_values(hostname, &sampletime, ncores, labels, fvals, NULL);
+
+ cleanup:
+    if (NULL != labels) {
+        opal_argv_free(labels);
+    }
+    if (NULL != fvals) {
+        free(fvals);
+    }
     if (NULL != hostname) {
         free(hostname);
     }
 }
 
+static void coretemp_log_compact(orcm_sensor_schema_t *schema,
+                                 struct timeval *sampletime,
+                                 void *values,
+                                 uint8_t *changed)
+{
+    if (!log_enabled) {
+        return;
+    }
+    if (OPAL_FLOAT != schema->type) {
+        ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+        return;
+    }
+    coretemp_log_values(schema->hostname, sampletime, schema->nitems,
+                        schema->labels, (float*)values, changed);
+}
+
 static void coretemp_set_sample_rate(int sample_rate)
 {
     /* set the coretemp sample rate if seperate thread is enabled */
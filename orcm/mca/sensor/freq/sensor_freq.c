@@ -30,6 +30,7 @@
 #include "opal_stdint.h"
 #include "opal/class/opal_list.h"
 #include "opal/dss/dss.h"
+#include "opal/util/argv.h"
 #include "opal/util/os_path.h"
 #include "opal/util/output.h"
 #include "opal/util/os_dirpath.h"
@@ -60,6 +61,10 @@ static void freq_sample(orcm_sensor_sampler_t *sampler);
 static void perthread_freq_sample(int fd, short args, void *cbdata);
 static void collect_sample(orcm_sensor_sampler_t *sampler);
 static void freq_log(opal_buffer_t *buf);
+static void freq_log_compact(orcm_sensor_schema_t *schema,
+                             struct timeval *sampletime,
+                             void *values,
+                             uint8_t *changed);
 static void freq_set_sample_rate(int sample_rate);
 static void freq_get_sample_rate(int *sample_rate);
 
@@ -74,7 +79,8 @@ orcm_sensor_base_module_t orcm_sensor_freq_module = {
     NULL,
     NULL,
     freq_set_sample_rate,
-    freq_get_sample_rate
+    freq_get_sample_rate,
+    freq_log_compact
 };
 
 /****    COREFREQ EVENT HISTORY TYPE    ****/
@@ -121,6 +127,7 @@ OBJ_CLASS_INSTANCE(corefreq_history_t,
 typedef struct {
     opal_list_item_t super;
     char *file;
+    int sysfs;      /* index of the file in freq_files */
     int core;
     float max_freq;
     float min_freq;
@@ -128,6 +135,7 @@ typedef struct {
 static void ctr_con(corefreq_tracker_t *trk)
 {
     trk->file = NULL;
+    trk->sysfs = -1;
 }
 static void ctr_des(corefreq_tracker_t *trk)
 {
@@ -143,11 +151,13 @@ typedef struct {
     opal_list_item_t super;
     char *file;     /* sysfs entry file location */
     char *sysname;  /* sysfs entry name */
+    int sysfs;      /* index of the file in freq_files */
     unsigned int value;
 } pstate_tracker_t;
 static void ptrk_con(pstate_tracker_t *trk)
 {
     trk->file = NULL;
+    trk->sysfs = -1;
 }
 static void ptrk_des(pstate_tracker_t *trk)
 {
@@ -166,9 +176,15 @@ static bool log_enabled = true;
 static bool intel_pstate_avail = false;
 static opal_list_t tracking;
 static opal_list_t pstate_list;
+static orcm_sensor_sysfs_t freq_files;
 static opal_list_t event_history;
 static orcm_sensor_sampler_t *freq_sampler = NULL;
 static orcm_sensor_freq_t orcm_sensor_freq;
+/* schemas of the compact core freq and pstate samples - told apart
+ * by their value type */
+static orcm_sensor_schema_t *freq_schema = NULL;
+static orcm_sensor_schema_t *pstate_schema = NULL;
+static bool freq_schema_stale = false;
 
 static void generate_test_vector(opal_buffer_t *v);
 char **corefreq_policy_list; /* store corefreq policies from MCA parameter */
@@ -446,6 +462,7 @@ static int init(void)
     /* always construct this so we don't segfault in finalize */
     OBJ_CONSTRUCT(&tracking, opal_list_t);
     OBJ_CONSTRUCT(&pstate_list, opal_list_t);
+    OBJ_CONSTRUCT(&freq_files, orcm_sensor_sysfs_t);
     OBJ_CONSTRUCT(&event_history, opal_list_t);
 
     /* get policy from MCA parameters */
@@ -643,8 +660,17 @@ static int init(void)
 
 static void finalize(void)
 {
+    if (NULL != freq_schema) {
+        orcm_sensor_base_schema_deregister(freq_schema);
+        freq_schema = NULL;
+    }
+    if (NULL != pstate_schema) {
+        orcm_sensor_base_schema_deregister(pstate_schema);
+        pstate_schema = NULL;
+    }
     OPAL_LIST_DESTRUCT(&tracking);
     OPAL_LIST_DESTRUCT(&pstate_list);
+    OBJ_DESTRUCT(&freq_files);
     OPAL_LIST_DESTRUCT(&event_history);
 }
 
@@ -729,13 +755,171 @@ static void perthread_freq_sample(int fd, short args, void *cbdata)
     opal_event_evtimer_add(&sampler->ev, &sampler->rate);
 }
 
-static void collect_sample(orcm_sensor_sampler_t *sampler)
+/* open the files we haven't read yet, dropping those we can't open,
+ * and read the freqs and pstate values in one pass */
+static void read_files(void)
 {
-    int ret;
     corefreq_tracker_t *trk, *nxt;
     pstate_tracker_t *ptrk, *pnxt;
 
-    FILE *fp;
+    OPAL_LIST_FOREACH_SAFE(trk, nxt, &tracking, corefreq_tracker_t) {
+        if (0 <= trk->sysfs) {
+            continue;
+        }
+        if (0 > (trk->sysfs = orcm_sensor_base_sysfs_add(&freq_files, trk->file))) {
+            /* we can't be read, so remove it from the list */
+            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                "%s access denied to freq file %s - removing it",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                trk->file);
+            opal_list_remove_item(&tracking, &trk->super);
+            OBJ_RELEASE(trk);
+            freq_schema_stale = true;
+        }
+    }
+    if (intel_pstate_avail) {
+        OPAL_LIST_FOREACH_SAFE(ptrk, pnxt, &pstate_list, pstate_tracker_t) {
+            if (0 <= ptrk->sysfs) {
+                continue;
+            }
+            if (0 > (ptrk->sysfs = orcm_sensor_base_sysfs_add(&freq_files, ptrk->file))) {
+                opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                                    "%s access denied to freq file %s - removing it",
+                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                    ptrk->file);
+                opal_list_remove_item(&pstate_list, &ptrk->super);
+                OBJ_RELEASE(ptrk);
+                freq_schema_stale = true;
+            }
+        }
+    }
+    orcm_sensor_base_sysfs_read_all(&freq_files);
+}
+
+/* (re)register a schema unless it still describes the given values */
+static orcm_sensor_schema_t *refresh_schema(orcm_sensor_schema_t *schema,
+                                            opal_data_type_t type,
+                                            int32_t nitems, char **labels,
+                                            char *unit)
+{
+    char **units;
+    int32_t i;
+
+    if (NULL != schema && !freq_schema_stale && nitems == schema->nitems) {
+        return schema;
+    }
+    if (NULL != schema) {
+        orcm_sensor_base_schema_deregister(schema);
+    }
+    if (NULL == (units = (char**)calloc(nitems + 1, sizeof(char*)))) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        return NULL;
+    }
+    for (i=0; i < nitems; i++) {
+        units[i] = unit;
+    }
+    if (NULL == (schema = orcm_sensor_base_schema_register("freq", type, nitems,
+                                                           labels, units))) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+    }
+    free(units);
+    return schema;
+}
+
+/* read the core freqs into an array of floats and the pstate values
+ * into an array of uint32s and pack each as a compact sample,
+ * registering new schemas whenever the set of files we are able to
+ * read has changed */
+static void collect_compact_sample(orcm_sensor_sampler_t *sampler)
+{
+    corefreq_tracker_t *trk;
+    pstate_tracker_t *ptrk;
+    float *ghz = NULL;
+    uint32_t *pvals = NULL;
+    char **labels = NULL;
+    int32_t ncores = 0, npstates = 0, i;
+    size_t max;
+    struct timeval current_time;
+
+    max = opal_list_get_size(&tracking);
+    if (opal_list_get_size(&pstate_list) > max) {
+        max = opal_list_get_size(&pstate_list);
+    }
+    ghz = (float*)malloc(max * sizeof(float));
+    pvals = (uint32_t*)malloc(max * sizeof(uint32_t));
+    labels = (char**)calloc(max + 1, sizeof(char*));
+    if (NULL == ghz || NULL == pvals || NULL == labels) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        goto cleanup;
+    }
+
+    /* get the sample time */
+    gettimeofday(&current_time, NULL);
+
+    OPAL_LIST_FOREACH(trk, &tracking, corefreq_tracker_t) {
+        if (0 != freq_files.errs[trk->sysfs]) {
+            continue;
+        }
+        ghz[ncores] = freq_files.values[trk->sysfs] / 1000000.0;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:freq: Core %d freq %f max %f min %f",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            trk->core, ghz[ncores], trk->max_freq, trk->min_freq);
+        /* same labels as the samples of the labelled encoding */
+        asprintf(&labels[ncores], "core%d", ncores);
+        ncores++;
+    }
+    if (0 < ncores) {
+        freq_schema = refresh_schema(freq_schema, OPAL_FLOAT, ncores, labels, "GHz");
+        if (NULL != freq_schema) {
+            orcm_sensor_base_pack_compact(&sampler->bucket, freq_schema,
+                                          &current_time, ghz);
+        }
+    }
+    for (i=0; i < ncores; i++) {
+        free(labels[i]);
+        labels[i] = NULL;
+    }
+
+    if (intel_pstate_avail) {
+        OPAL_LIST_FOREACH(ptrk, &pstate_list, pstate_tracker_t) {
+            if (0 != freq_files.errs[ptrk->sysfs]) {
+                continue;
+            }
+            ptrk->value = (unsigned int)freq_files.values[ptrk->sysfs];
+            pvals[npstates] = ptrk->value;
+            /* the labels belong to the trackers */
+            labels[npstates++] = ptrk->sysname;
+        }
+        if (0 < npstates) {
+            pstate_schema = refresh_schema(pstate_schema, OPAL_UINT32, npstates,
+                                           labels, "");
+            if (NULL != pstate_schema) {
+                orcm_sensor_base_pack_compact(&sampler->bucket, pstate_schema,
+                                              &current_time, pvals);
+            }
+        }
+    }
+    freq_schema_stale = false;
+
+cleanup:
+    if (NULL != ghz) {
+        free(ghz);
+    }
+    if (NULL != pvals) {
+        free(pvals);
+    }
+    if (NULL != labels) {
+        free(labels);
+    }
+}
+
+static void collect_sample(orcm_sensor_sampler_t *sampler)
+{
+    int ret;
+    corefreq_tracker_t *trk;
+    pstate_tracker_t *ptrk;
+
     char *freq;
     float ghz;
     opal_buffer_t data, *bptr;
@@ -761,6 +945,13 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         goto cleanup;
     }
 
+    read_files();
+
+    if (orcm_sensor_base.compact_samples) {
+        collect_compact_sample(sampler);
+        return;
+    }
+
     /* prep to store the results */
     OBJ_CONSTRUCT(&data, opal_buffer_t);
     packed = false;
@@ -782,8 +973,13 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
-    /* store the number of cores */
-    ncores = (int32_t)opal_list_get_size(&tracking);
+    /* store the number of cores we could read */
+    ncores = 0;
+    OPAL_LIST_FOREACH(trk, &tracking, corefreq_tracker_t) {
+        if (0 == freq_files.errs[trk->sysfs]) {
+            ncores++;
+        }
+    }
     if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ncores, 1, OPAL_INT32))) {
         ORTE_ERROR_LOG(ret);
         OBJ_DESTRUCT(&data);
@@ -800,88 +996,64 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
-    OPAL_LIST_FOREACH_SAFE(trk, nxt, &tracking, corefreq_tracker_t) {
+    OPAL_LIST_FOREACH(trk, &tracking, corefreq_tracker_t) {
         opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
                             "%s processing freq file %s",
                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                             trk->file);
-        /* read the freq */
-        if (NULL == (fp = fopen(trk->file, "r"))) {
-            /* we can't be read, so remove it from the list */
-            opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
-                                "%s access denied to freq file %s - removing it",
-                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                trk->file);
-            opal_list_remove_item(&tracking, &trk->super);
-            OBJ_RELEASE(trk);
+        if (0 != freq_files.errs[trk->sysfs]) {
             continue;
         }
-        while (NULL != (freq = orte_getline(fp))) {
-            ghz = strtoul(freq, NULL, 10) / 1000000.0;
-            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
-                                "%s sensor:freq: Core %d freq %f max %f min %f",
-                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                trk->core, ghz, trk->max_freq, trk->min_freq);
-            if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ghz, 1, OPAL_FLOAT))) {
-                ORTE_ERROR_LOG(ret);
-                free(freq);
-                fclose(fp);
-                OBJ_DESTRUCT(&data);
-                return;
-            }
-            packed = true;
-            free(freq);
+        ghz = freq_files.values[trk->sysfs] / 1000000.0;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:freq: Core %d freq %f max %f min %f",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                            trk->core, ghz, trk->max_freq, trk->min_freq);
+        if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ghz, 1, OPAL_FLOAT))) {
+            ORTE_ERROR_LOG(ret);
+            OBJ_DESTRUCT(&data);
+            return;
         }
-        fclose(fp);
+        packed = true;
     }
 
     if(true == intel_pstate_avail) {
-        item_count = opal_list_get_size(&pstate_list);
+        item_count = 0;
+        OPAL_LIST_FOREACH(ptrk, &pstate_list, pstate_tracker_t) {
+            if (0 == freq_files.errs[ptrk->sysfs]) {
+                item_count++;
+            }
+        }
         if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &item_count, 1, OPAL_UINT))) {
             ORTE_ERROR_LOG(ret);
             OBJ_DESTRUCT(&data);
             return;
         }
 
-        OPAL_LIST_FOREACH_SAFE(ptrk, pnxt, &pstate_list, pstate_tracker_t) {
+        OPAL_LIST_FOREACH(ptrk, &pstate_list, pstate_tracker_t) {
             opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
                                 "%s processing freq file %s",
                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                                 ptrk->file);
-            /* read the value */
-            if (NULL == (fp = fopen(ptrk->file, "r"))) {
-                /* we can't be read, so remove it from the list */
-                opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
-                                    "%s access denied to freq file %s - removing it",
-                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                    ptrk->file);
-                opal_list_remove_item(&pstate_list, &ptrk->super);
-                OBJ_RELEASE(ptrk);
+            if (0 != freq_files.errs[ptrk->sysfs]) {
                 continue;
             }
             if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ptrk->sysname, 1, OPAL_STRING))) {
                     ORTE_ERROR_LOG(ret);
-                    fclose(fp);
                     OBJ_DESTRUCT(&data);
                     return;
             }
-            while (NULL != (freq = orte_getline(fp))) {
-                ptrk->value = strtoul(freq, NULL, 10);
-                opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
-                                    "%s sensor:pstate: file %s : %d",
-                                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                    ptrk->file, ptrk->value);
-                if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ptrk->value, 1, OPAL_UINT))) {
-                    ORTE_ERROR_LOG(ret);
-                    free(freq);
-                    fclose(fp);
-                    OBJ_DESTRUCT(&data);
-                    return;
-                }
-                packed = true;
-                free(freq);
+            ptrk->value = (unsigned int)freq_files.values[ptrk->sysfs];
+            opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                                "%s sensor:pstate: file %s : %d",
+                                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                                ptrk->file, ptrk->value);
+            if (OPAL_SUCCESS != (ret = opal_dss.pack(&data, &ptrk->value, 1, OPAL_UINT))) {
+                ORTE_ERROR_LOG(ret);
+                OBJ_DESTRUCT(&data);
+                return;
             }
-            fclose(fp);
+            packed = true;
         }
     } else {
         /* Pack 0 pstate values available */
@@ -916,49 +1088,24 @@ static void mycleanup(int dbhandle, int status, opal_list_t *kvs,
     }
 }
 
-static void freq_log(opal_buffer_t *sample)
+/* only the values flagged in changed (all if NULL) are stored - the
+ * others are the last values reported and only go to the event policy
+ * and analytics */
+static void freq_log_cores(char *hostname, struct timeval *sampletime,
+                           int32_t ncores, char **labels, float *fvals,
+                           uint8_t *changed)
 {
-    char *hostname=NULL;
-    struct timeval sampletime;
-    int rc;
-    int analytics_rc;
-    int32_t n, ncores;
-    opal_list_t *vals, *pstate_vals=NULL;
+    opal_list_t *vals;
     opal_value_t *kv;
-    float fval;
-    int i;
-    unsigned int pstate_count = 0, pstate_value = 0;
-    char *pstate_name;
+    int i, nstored = 0;
+    int analytics_rc;
     opal_value_array_t *analytics_sample_array = NULL;
     orcm_metric_value_t *sensor_metric;
 
-    if (!log_enabled) {
-        return;
-    }
-    /* unpack the host this came from */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &hostname, &n, OPAL_STRING))) {
-        ORTE_ERROR_LOG(rc);
-        return;
-    }
-    /* and the number of cores on that host */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &ncores, &n, OPAL_INT32))) {
-        ORTE_ERROR_LOG(rc);
-        return;
-    }
-
-    /* sample time */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &sampletime, &n, OPAL_TIMEVAL))) {
-        ORTE_ERROR_LOG(rc);
-        goto cleanup;
-    }
-
     opal_output_verbose(3, orcm_sensor_base_framework.framework_output,
                         "%s Received freq log from host %s with %d cores",
                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                        (NULL == hostname) ? "NULL" : hostname, ncores);
+                        hostname, ncores);
 
     /* xfr to storage */
     vals = OBJ_NEW(opal_list_t);
@@ -966,14 +1113,10 @@ static void freq_log(opal_buffer_t *sample)
     kv = OBJ_NEW(opal_value_t);
     kv->key = strdup("ctime");
     kv->type = OPAL_TIMEVAL;
-    kv->data.tv = sampletime;
+    kv->data.tv = *sampletime;
     opal_list_append(vals, &kv->super);
 
     /* load the hostname */
-    if (NULL == hostname) {
-        ORTE_ERROR_LOG(OPAL_ERR_BAD_PARAM);
-        return;
-    }
     kv = OBJ_NEW(opal_value_t);
     kv->key = strdup("hostname");
     kv->type = OPAL_STRING;
@@ -986,6 +1129,7 @@ static void freq_log(opal_buffer_t *sample)
     kv = OBJ_NEW(opal_value_t);
     if (NULL == kv) {
         ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+        OPAL_LIST_RELEASE(vals);
         goto cleanup;
     }
     kv->key = strdup("data_group");
@@ -997,33 +1141,36 @@ static void freq_log(opal_buffer_t *sample)
         sensor_metric = OBJ_NEW(orcm_metric_value_t);
         if (NULL == sensor_metric) {
             ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+            OPAL_LIST_RELEASE(vals);
             goto cleanup;
         }
 
-        asprintf(&(sensor_metric->value.key), "core%d", i);
+        if (NULL != labels) {
+            sensor_metric->value.key = strdup(labels[i]);
+        } else {
+            asprintf(&(sensor_metric->value.key), "core%d", i);
+        }
         sensor_metric->units = strdup("GHz");
         sensor_metric->value.type = OPAL_FLOAT;
 
-        n=1;
-        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &fval, &n, OPAL_FLOAT))) {
-            ORTE_ERROR_LOG(rc);
-            goto cleanup;
-        }
-
         /* check corefreq event policy */
-        corefreq_policy_filter(hostname, i, fval, sampletime.tv_sec);
-
-        sensor_metric->value.data.fval = fval;
-        opal_list_append(vals, (opal_list_item_t *)sensor_metric);
+        corefreq_policy_filter(hostname, i, fvals[i], sampletime->tv_sec);
 
+        sensor_metric->value.data.fval = fvals[i];
         if (ORCM_SUCCESS == analytics_rc) {
             analytics_rc = orcm_analytics.array_append(analytics_sample_array, i,
                                                        "freq", hostname, sensor_metric);
         }
+        if (ORCM_SENSOR_BASE_CHANGED(changed, i)) {
+            opal_list_append(vals, (opal_list_item_t *)sensor_metric);
+            nstored++;
+        } else {
+            OBJ_RELEASE(sensor_metric);
+        }
     }
 
     /* store it */
-    if (0 <= orcm_sensor_base.dbhandle) {
+    if (0 <= orcm_sensor_base.dbhandle && 0 < nstored) {
         orcm_db.store_new(orcm_sensor_base.dbhandle, ORCM_DB_ENV_DATA, vals, NULL, mycleanup, NULL);
     } else {
         OPAL_LIST_RELEASE(vals);
@@ -1034,103 +1181,212 @@ static void freq_log(opal_buffer_t *sample)
         orcm_analytics.array_send(analytics_sample_array);
     }
 
-    /* unpack the pstate entry count */
-    n=1;
-    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_count, &n, OPAL_UINT))) {
-        ORTE_ERROR_LOG(rc);
-        goto cleanup;
+ cleanup:
+    if (NULL != analytics_sample_array) {
+        orcm_analytics.array_cleanup(analytics_sample_array);
     }
+}
+
+/* as for the cores, only the values flagged in changed are stored */
+static void freq_log_pstates(char *hostname, struct timeval *sampletime,
+                             int32_t count, char **names, uint32_t *values,
+                             uint8_t *changed)
+{
+    opal_list_t *pstate_vals;
+    opal_value_t *kv;
+    orcm_metric_value_t *sensor_metric;
+    int i, nstored = 0;
+
     opal_output_verbose(3, orcm_sensor_base_framework.framework_output,
-                "Total pstate count: %d", pstate_count);
+                "Total pstate count: %d", count);
 
-    if (pstate_count > 0) {
-        /* xfr to storage */
-        pstate_vals = OBJ_NEW(opal_list_t);
+    if (0 >= count) {
+        return;
+    }
 
-        kv = OBJ_NEW(opal_value_t);
-        kv->key = strdup("ctime");
-        kv->type = OPAL_TIMEVAL;
-        kv->data.tv = sampletime;
-        opal_list_append(pstate_vals, &kv->super);
+    /* xfr to storage */
+    pstate_vals = OBJ_NEW(opal_list_t);
 
-        /* load the hostname */
-        if (NULL == hostname) {
-            ORTE_ERROR_LOG(OPAL_ERR_BAD_PARAM);
-            goto cleanup;
-        }
-        kv = OBJ_NEW(opal_value_t);
-        kv->key = strdup("hostname");
-        kv->type = OPAL_STRING;
-        kv->data.string = strdup(hostname);
-        opal_list_append(pstate_vals, &kv->super);
-
-        kv = OBJ_NEW(opal_value_t);
-        if (NULL == kv) {
-            ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
-            goto cleanup;
-        }
-        kv->key = strdup("data_group");
-        kv->type = OPAL_STRING;
-        kv->data.string = strdup("pstate");
-        opal_list_append(pstate_vals, &kv->super);
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("ctime");
+    kv->type = OPAL_TIMEVAL;
+    kv->data.tv = *sampletime;
+    opal_list_append(pstate_vals, &kv->super);
+
+    /* load the hostname */
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("hostname");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup(hostname);
+    opal_list_append(pstate_vals, &kv->super);
+
+    kv = OBJ_NEW(opal_value_t);
+    if (NULL == kv) {
+        ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+        OPAL_LIST_RELEASE(pstate_vals);
+        return;
     }
+    kv->key = strdup("data_group");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup("pstate");
+    opal_list_append(pstate_vals, &kv->super);
 
-    while(pstate_count > 0)
-    {
-        /* unpack the pstate entry name */
-        n=1;
-        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_name, &n, OPAL_STRING))) {
-            ORTE_ERROR_LOG(rc);
-            goto cleanup;
-        }
-        /* unpack the pstate entry value */
-        n=1;
-        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_value, &n, OPAL_UINT))) {
-            ORTE_ERROR_LOG(rc);
-            goto cleanup;
-        }
+    for (i=0; i < count; i++) {
         opal_output_verbose(3, orcm_sensor_base_framework.framework_output,
-                            "%s : %d",pstate_name, pstate_value);
+                            "%s : %d", names[i], values[i]);
+        if (!ORCM_SENSOR_BASE_CHANGED(changed, i)) {
+            continue;
+        }
 
         sensor_metric = OBJ_NEW(orcm_metric_value_t);
         if (NULL == sensor_metric) {
             ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
-            goto cleanup;
+            OPAL_LIST_RELEASE(pstate_vals);
+            return;
         }
-        if (0 != strcmp(pstate_name,"no_turbo")) {
-            sensor_metric->value.key = strdup(pstate_name);
+        if (0 != strcmp(names[i],"no_turbo")) {
+            sensor_metric->value.key = strdup(names[i]);
             sensor_metric->value.type = OPAL_UINT;
-            sensor_metric->value.data.uint = pstate_value;
+            sensor_metric->value.data.uint = values[i];
             sensor_metric->units = NULL;
         } else {
             sensor_metric->value.key = strdup("allow_turbo");
             sensor_metric->value.type = OPAL_BOOL;
-            sensor_metric->value.data.flag = ((0 == pstate_value) ? true: false);
+            sensor_metric->value.data.flag = ((0 == values[i]) ? true: false);
             sensor_metric->units = NULL;
         }
         opal_list_append(pstate_vals, (opal_list_item_t *)sensor_metric);
-        pstate_count--;
+        nstored++;
     }
 
-    if (pstate_vals != NULL)
-    {
-        /* store it */
-        if (0 <= orcm_sensor_base.dbhandle) {
-            orcm_db.store_new(orcm_sensor_base.dbhandle, ORCM_DB_ENV_DATA, pstate_vals, NULL, mycleanup, NULL);
-        } else {
-            OPAL_LIST_RELEASE(pstate_vals);
+    /* store it */
+    if (0 <= orcm_sensor_base.dbhandle && 0 < nstored) {
+        orcm_db.store_new(orcm_sensor_base.dbhandle, ORCM_DB_ENV_DATA, pstate_vals, NULL, mycleanup, NULL);
+    } else {
+        OPAL_LIST_RELEASE(pstate_vals);
+    }
+}
+
+static void freq_log(opal_buffer_t *sample)
+{
+    char *hostname=NULL;
+    struct timeval sampletime;
+    int rc;
+    int32_t n, ncores, i;
+    float *fvals = NULL;
+    unsigned int pstate_count = 0, pstate_value = 0, j;
+    char **pstate_names = NULL;
+    uint32_t *pstate_values = NULL;
+
+    if (!log_enabled) {
+        return;
+    }
+    /* unpack the host this came from */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &hostname, &n, OPAL_STRING))) {
+        ORTE_ERROR_LOG(rc);
+        return;
+    }
+    /* and the number of cores on that host */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &ncores, &n, OPAL_INT32))) {
+        ORTE_ERROR_LOG(rc);
+        goto cleanup;
+    }
+
+    /* sample time */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &sampletime, &n, OPAL_TIMEVAL))) {
+        ORTE_ERROR_LOG(rc);
+        goto cleanup;
+    }
+
+    if (NULL == hostname) {
+        ORTE_ERROR_LOG(OPAL_ERR_BAD_PARAM);
+        return;
+    }
+
+    if (0 < ncores) {
+        if (NULL == (fvals = (float*)malloc(ncores * sizeof(float)))) {
+            ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+            goto cleanup;
+        }
+        /* each freq was packed on its own */
+        for (i=0; i < ncores; i++) {
+            n=1;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &fvals[i], &n, OPAL_FLOAT))) {
+                ORTE_ERROR_LOG(rc);
+                goto cleanup;
+            }
         }
     }
+    freq_log_cores(hostname, &sampletime, ncores, NULL, fvals, NULL);
 
- cleanup:
-    if (NULL != analytics_sample_array) {
-        orcm_analytics.array_cleanup(analytics_sample_array);
+    /* unpack the pstate entry count */
+    n=1;
+    if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_count, &n, OPAL_UINT))) {
+        ORTE_ERROR_LOG(rc);
+        goto cleanup;
+    }
+    if (0 == pstate_count) {
+        goto cleanup;
+    }
+    pstate_names = (char**)calloc(pstate_count + 1, sizeof(char*));
+    pstate_values = (uint32_t*)malloc(pstate_count * sizeof(uint32_t));
+    if (NULL == pstate_names || NULL == pstate_values) {
+        ORTE_ERROR_LOG(OPAL_ERR_OUT_OF_RESOURCE);
+        goto cleanup;
+    }
+    for (j=0; j < pstate_count; j++) {
+        /* unpack the pstate entry name */
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_names[j], &n, OPAL_STRING))) {
+            ORTE_ERROR_LOG(rc);
+            goto cleanup;
+        }
+        /* unpack the pstate entry value */
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(sample, &pstate_value, &n, OPAL_UINT))) {
+            ORTE_ERROR_LOG(rc);
+            goto cleanup;
+        }
+        pstate_values[j] = pstate_value;
     }
+    freq_log_pstates(hostname, &sampletime, (int32_t)pstate_count, pstate_names,
+                     pstate_values, NULL);
 
+ cleanup:
+    if (NULL != fvals) {
+        free(fvals);
+    }
+    if (NULL != pstate_names) {
+        opal_argv_free(pstate_names);
+    }
+    if (NULL != pstate_values) {
+        free(pstate_values);
+    }
     if (NULL != hostname) {
         free(hostname);
     }
+}
 
+static void freq_log_compact(orcm_sensor_schema_t *schema,
+                             struct timeval *sampletime,
+                             void *values,
+                             uint8_t *changed)
+{
+    if (!log_enabled) {
+        return;
+    }
+    if (OPAL_FLOAT == schema->type) {
+        freq_log_cores(schema->hostname, sampletime, schema->nitems,
+                       schema->labels, (float*)values, changed);
+    } else if (OPAL_UINT32 == schema->type) {
+        freq_log_pstates(schema->hostname, sampletime, schema->nitems,
+                         schema->labels, (uint32_t*)values, changed);
+    } else {
+        ORTE_ERROR_LOG(ORCM_ERR_BAD_PARAM);
+    }
 }
 
 static void freq_set_sample_rate(int sample_rate)
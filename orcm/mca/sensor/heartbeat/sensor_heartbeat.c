@@ -23,6 +23,8 @@
 #include <string.h>
 #endif  /* HAVE_STRING_H */
 #include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
 
 #include "opal_stdint.h"
 #include "opal/util/argv.h"
@@ -75,9 +77,51 @@ static orte_job_t *daemons=NULL;
 static opal_event_t check_ev;
 static bool check_active = false;
 static struct timeval check_time;
+static orcm_sensor_heartbeat_detector_t detector;
+static bool detector_active = false;
+static orte_vpid_t nknown = 0;
+
+/* deadlines must not move when the date is set */
+static double now_secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/* expect beats from the daemons we did not know of yet - those not
+ * running yet are looked at again when due, until they are */
+static void watch_new(double now)
+{
+    orte_proc_t *proc;
+    int v, rc;
+
+    if (daemons->num_procs == nknown) {
+        return;
+    }
+    for (v=0; v < daemons->procs->size; v++) {
+        if (NULL == (proc = (orte_proc_t*)opal_pointer_array_get_item(daemons->procs, v))) {
+            continue;
+        }
+        if (proc->name.vpid == ORTE_PROC_MY_NAME->vpid ||
+            orcm_sensor_heartbeat_detector_watched(&detector, proc->name.vpid)) {
+            continue;
+        }
+        if (ORCM_SUCCESS != (rc = orcm_sensor_heartbeat_detector_watch(&detector, proc->name.vpid, now))) {
+            /* try again at the next check */
+            ORTE_ERROR_LOG(rc);
+            return;
+        }
+    }
+    nknown = daemons->num_procs;
+}
 
 static int init(void)
 {
+    double rate;
+    int rc;
+
     OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
                          "%s initializing heartbeat recvs",
                          ORTE_NAME_PRINT(ORTE_PROC_MY_NAME)));
@@ -94,6 +138,19 @@ static int init(void)
         daemons = orte_get_job_data_object(ORTE_PROC_MY_NAME->jobid);
     }
 
+    if (NULL != daemons) {
+        rate = (0 < orcm_sensor_base.sample_rate) ? orcm_sensor_base.sample_rate : 1;
+        if (ORCM_SUCCESS != (rc = orcm_sensor_heartbeat_detector_init(&detector, rate,
+                                                                      rate * mca_sensor_heartbeat_component.missed,
+                                                                      mca_sensor_heartbeat_component.phi_threshold,
+                                                                      now_secs()))) {
+            ORTE_ERROR_LOG(rc);
+            return rc;
+        }
+        nknown = 0;
+        detector_active = true;
+    }
+
     return ORCM_SUCCESS;
 }
 
@@ -104,15 +161,22 @@ static void finalize(void)
         opal_event_del(&check_ev);
         check_active = false;
     }
+    if (detector_active) {
+        orcm_sensor_heartbeat_detector_fini(&detector);
+        detector_active = false;
+    }
     return;
 }
 
 static void start(orte_jobid_t job)
 {
     if (!check_active && NULL != daemons) {
-        /* setup the check event */
-        check_time.tv_sec = 3 * orcm_sensor_base.sample_rate;
-        check_time.tv_usec = 0;
+        /* expect beats from the daemons we know of */
+        watch_new(now_secs());
+        /* setup the check event - it only looks at the daemons
+         * whose deadline fell in the last tick */
+        check_time.tv_sec = (time_t)detector.tick;
+        check_time.tv_usec = (suseconds_t)((detector.tick - check_time.tv_sec) * 1000000.0);
         opal_event_evtimer_set(orte_event_base, &check_ev, check_heartbeat, &check_ev);
         opal_event_evtimer_add(&check_ev, &check_time);
         check_active = true;
@@ -167,16 +231,41 @@ static void sample(orcm_sensor_sampler_t *sampler)
     }
 }
 
+static void heartbeat_failed(orte_vpid_t vpid, double phi, uint32_t missed, void *cbdata)
+{
+    orte_proc_t *proc;
+    int rc;
+
+    if (NULL == (proc = (orte_proc_t*)opal_pointer_array_get_item(daemons->procs, vpid))) {
+        return;
+    }
+    if (ORTE_PROC_STATE_RUNNING != proc->state) {
+        OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
+                             "%s sensor:heartbeat DAEMON %s IS NOT RUNNING",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                             ORTE_NAME_PRINT(&proc->name)));
+        /* it may yet come up */
+        if (ORCM_SUCCESS != (rc = orcm_sensor_heartbeat_detector_watch(&detector, vpid,
+                                                                       *(double*)cbdata))) {
+            ORTE_ERROR_LOG(rc);
+        }
+        return;
+    }
+    OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
+                         "%s sensor:check_heartbeat FAILED for daemon %s: PHI %.1f MISSED %u",
+                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                         ORTE_NAME_PRINT(&proc->name), phi, missed));
+    ORTE_ACTIVATE_PROC_STATE(&proc->name, ORTE_PROC_STATE_HEARTBEAT_FAILED);
+}
+
 /* this function automatically gets periodically called
  * by the event library so we can check on the state
  * of the various orcmds
  */
 static void check_heartbeat(int fd, short dummy, void *arg)
 {
-    int v;
-    orte_proc_t *proc;
     opal_event_t *tmp = (opal_event_t*)arg;
-    int32_t beats, *bptr;
+    double now;
 
     OPAL_OUTPUT_VERBOSE((3, orcm_sensor_base_framework.framework_output,
                          "%s sensor:check_heartbeat",
@@ -193,43 +282,11 @@ static void check_heartbeat(int fd, short dummy, void *arg)
         check_active = false;
         return;
     }
-    
-    for (v=0; v < daemons->procs->size; v++) {
-        if (NULL == (proc = (orte_proc_t*)opal_pointer_array_get_item(daemons->procs, v))) {
-            continue;
-        }
-        /* ignore myself */
-        if (proc->name.vpid == ORTE_PROC_MY_NAME->vpid) {
-            continue;
-        }
-        if (ORTE_PROC_STATE_RUNNING != proc->state) {
-            OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
-                                 "%s sensor:heartbeat DAEMON %s IS NOT RUNNING",
-                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                 ORTE_NAME_PRINT(&proc->name)));
-            continue;
-        }
 
-        beats = 0;
-        bptr = &beats;
-        orte_get_attribute(&proc->attributes, ORTE_PROC_NBEATS, (void**)bptr, OPAL_INT32);
-        if (0 == beats) {
-            /* no heartbeat recvd in last window */
-            OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
-                                 "%s sensor:check_heartbeat FAILED for daemon %s",
-                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                 ORTE_NAME_PRINT(&proc->name)));
-            ORTE_ACTIVATE_PROC_STATE(&proc->name, ORTE_PROC_STATE_HEARTBEAT_FAILED);
-        } else {
-            OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
-                                 "%s HEARTBEAT DETECTED FOR %s: NUM BEATS %d",
-                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                 ORTE_NAME_PRINT(&proc->name), beats));
-        }
-        /* reset for next period */
-        beats = 0;
-        orte_set_attribute(&proc->attributes, ORTE_PROC_NBEATS, ORTE_ATTR_LOCAL, (void*)bptr, OPAL_INT32);
-    }
+    /* the daemons that went quiet for too long */
+    now = now_secs();
+    watch_new(now);
+    orcm_sensor_heartbeat_detector_expire(&detector, now, heartbeat_failed, &now);
 
     /* reset the timer */
     opal_event_evtimer_add(tmp, &check_time);
@@ -242,8 +299,8 @@ static void recv_beats(int status, orte_process_name_t* sender,
     orte_proc_t *proc;
     int rc, n;
     char *component=NULL;
-    opal_buffer_t *buf;
-    int32_t beats, *bptr;
+    opal_buffer_t buf;
+    bool failed;
 
     opal_output_verbose(1, orcm_sensor_base_framework.framework_output,
                         "%s received beat from %s",
@@ -255,40 +312,44 @@ static void recv_beats(int status, orte_process_name_t* sender,
         return;
     }
 
-    /* get this daemon's object */
-    if (NULL != daemons) {
-        if (NULL != (proc = (orte_proc_t*)opal_pointer_array_get_item(daemons->procs, sender->vpid))) {
-            OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
-                                 "%s marked beat from %s",
-                                 ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
-                                 ORTE_NAME_PRINT(sender)));
-            beats = 0;
-            bptr = &beats;
-            orte_get_attribute(&proc->attributes, ORTE_PROC_NBEATS, (void**)bptr, OPAL_INT32);
-            beats++;
-            orte_set_attribute(&proc->attributes, ORTE_PROC_NBEATS, ORTE_ATTR_LOCAL, (void*)bptr, OPAL_INT32);
+    /* mark the beat */
+    if (detector_active && sender->vpid != ORTE_PROC_MY_NAME->vpid &&
+        ORTE_VPID_INVALID != sender->vpid) {
+        OPAL_OUTPUT_VERBOSE((1, orcm_sensor_base_framework.framework_output,
+                             "%s marked beat from %s",
+                             ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                             ORTE_NAME_PRINT(sender)));
+        if (ORCM_SUCCESS != (rc = orcm_sensor_heartbeat_detector_beat(&detector, sender->vpid,
+                                                                      now_secs(), &failed))) {
+            ORTE_ERROR_LOG(rc);
+        } else if (failed) {
             /* if this daemon has reappeared, reset things */
-            if (ORTE_PROC_STATE_HEARTBEAT_FAILED == proc->state) {
+            proc = (orte_proc_t*)opal_pointer_array_get_item(daemons->procs, sender->vpid);
+            if (NULL != proc && ORTE_PROC_STATE_HEARTBEAT_FAILED == proc->state) {
                 proc->state = ORTE_PROC_STATE_RUNNING;
             }
         }
     }
 
-    /* unload any sampled data */
-    n=1;
-    while (OPAL_SUCCESS == (rc = opal_dss.unpack(buffer, &buf, &n, OPAL_BUFFER))) {
-        if (NULL != buf) {
-            n=1;
-            if (OPAL_SUCCESS != (rc = opal_dss.unpack(buf, &component, &n, OPAL_STRING))) {
-                ORTE_ERROR_LOG(rc);
-                break;
-            }
-            orcm_sensor_base_log(component, buf);
-            OBJ_RELEASE(buf);
-            free(component);
-            n=1;
+    /* unload any sampled data - each sample is logged straight from
+     * where it sits in the beat rather than from a copy of it */
+    OBJ_CONSTRUCT(&buf, opal_buffer_t);
+    while (OPAL_SUCCESS == (rc = orcm_sensor_base_unpack_view(buffer, &buf))) {
+        n=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(&buf, &component, &n, OPAL_STRING))) {
+            ORTE_ERROR_LOG(rc);
+            orcm_sensor_base_drop_view(&buf);
+            break;
+        }
+        if (0 == strcmp(component, ORCM_SENSOR_BASE_COMPACT)) {
+            orcm_sensor_base_log_compact(sender, &buf);
+        } else {
+            orcm_sensor_base_log(component, &buf);
         }
+        orcm_sensor_base_drop_view(&buf);
+        free(component);
     }
+    OBJ_DESTRUCT(&buf);
 
     /* At the end of completion of all logs commit the data to db */
     if(orcm_sensor_base.enable_group_commits  && (true == orcm_sensor_base.dbhandle_acquired )) {
@@ -18,13 +18,85 @@
 
 #include "orcm_config.h"
 
+#include "orte/types.h"
+
 #include "orcm/mca/sensor/sensor.h"
 
 BEGIN_C_DECLS
 
-ORCM_MODULE_DECLSPEC extern orcm_sensor_base_component_t mca_sensor_heartbeat_component;
+typedef struct {
+    orcm_sensor_base_component_t super;
+    double phi_threshold;
+    int missed;
+} orcm_sensor_heartbeat_component_t;
+
+ORCM_MODULE_DECLSPEC extern orcm_sensor_heartbeat_component_t mca_sensor_heartbeat_component;
 extern orcm_sensor_base_module_t orcm_sensor_heartbeat_module;
 
+/*
+ * Failure detector
+ *
+ * What we know of each daemon lives in a dense array indexed by vpid,
+ * so a beat costs a few arithmetic operations. The time between beats
+ * is tracked as a moving mean and variance per daemon, and the daemon's
+ * suspicion level phi is -log10 of the probability that its next beat
+ * is still to come after this long. The time at which phi crosses the
+ * threshold is the daemon's deadline, kept in a wheel of buckets so
+ * that each check only looks at the daemons that just became due.
+ */
+typedef struct {
+    double last;        // time of the last beat, in secs
+    double mean;        // of the time between beats
+    double var;
+    double deadline;    // when phi reaches the threshold
+    uint32_t nbeats;
+    uint32_t missed;    // beats missed when found failed
+    int32_t slot;       // in the wheel, or -1
+    int32_t next;       // in the slot
+    int32_t prev;
+    bool failed;
+} orcm_sensor_heartbeat_peer_t;
+
+typedef void (*orcm_sensor_heartbeat_failed_fn_t)(orte_vpid_t vpid, double phi,
+                                                  uint32_t missed, void *cbdata);
+
+typedef struct {
+    orcm_sensor_heartbeat_peer_t *peers;
+    int32_t npeers;
+    int32_t *slots;
+    int32_t nslots;
+    double tick;        // secs per slot
+    double start;
+    int64_t last_tick;  // checked up to
+    double interval;    // expected time between beats
+    double pause;       // tolerated on top of it
+    double threshold;   // phi
+    double z;           // std devs past the mean at which phi is the threshold
+} orcm_sensor_heartbeat_detector_t;
+
+ORCM_DECLSPEC int orcm_sensor_heartbeat_detector_init(orcm_sensor_heartbeat_detector_t *det,
+                                                      double interval, double pause,
+                                                      double threshold, double now);
+ORCM_DECLSPEC void orcm_sensor_heartbeat_detector_fini(orcm_sensor_heartbeat_detector_t *det);
+/* expect beats from a daemon from now on */
+ORCM_DECLSPEC int orcm_sensor_heartbeat_detector_watch(orcm_sensor_heartbeat_detector_t *det,
+                                                       orte_vpid_t vpid, double now);
+/* is the daemon watched, or was it ever? */
+ORCM_DECLSPEC bool orcm_sensor_heartbeat_detector_watched(orcm_sensor_heartbeat_detector_t *det,
+                                                          orte_vpid_t vpid);
+/* record a beat - failed tells if the daemon was found failed before */
+ORCM_DECLSPEC int orcm_sensor_heartbeat_detector_beat(orcm_sensor_heartbeat_detector_t *det,
+                                                      orte_vpid_t vpid, double now,
+                                                      bool *failed);
+ORCM_DECLSPEC double orcm_sensor_heartbeat_detector_phi(orcm_sensor_heartbeat_detector_t *det,
+                                                        orte_vpid_t vpid, double now);
+/* report the daemons whose deadline passed, which are then no longer
+ * expected to beat - returns how many */
+ORCM_DECLSPEC int orcm_sensor_heartbeat_detector_expire(orcm_sensor_heartbeat_detector_t *det,
+                                                        double now,
+                                                        orcm_sensor_heartbeat_failed_fn_t cbfunc,
+                                                        void *cbdata);
+
 
 END_C_DECLS
 
@@ -25,29 +25,55 @@
 static int orcm_sensor_heartbeat_open(void);
 static int orcm_sensor_heartbeat_close(void);
 static int orcm_sensor_heartbeat_query(mca_base_module_t **module, int *priority);
+static int orcm_sensor_heartbeat_register(void);
 
-orcm_sensor_base_component_t mca_sensor_heartbeat_component = {
+orcm_sensor_heartbeat_component_t mca_sensor_heartbeat_component = {
     {
-        ORCM_SENSOR_BASE_VERSION_1_0_0,
-        /* Component name and version */
-        .mca_component_name = "heartbeat",
-        MCA_BASE_MAKE_VERSION(component, ORCM_MAJOR_VERSION, ORCM_MINOR_VERSION,
-                              ORCM_RELEASE_VERSION),
-        
-        /* Component open and close functions */
-        .mca_open_component = orcm_sensor_heartbeat_open,
-        .mca_close_component = orcm_sensor_heartbeat_close,
-        .mca_query_component = orcm_sensor_heartbeat_query,
-        NULL
-    },
-    .base_data = {
-        /* The component is checkpoint ready */
-        MCA_BASE_METADATA_PARAM_CHECKPOINT
-    },
-    "heartbeat"
+        {
+            ORCM_SENSOR_BASE_VERSION_1_0_0,
+            /* Component name and version */
+            .mca_component_name = "heartbeat",
+            MCA_BASE_MAKE_VERSION(component, ORCM_MAJOR_VERSION, ORCM_MINOR_VERSION,
+                                  ORCM_RELEASE_VERSION),
+
+            /* Component open and close functions */
+            .mca_open_component = orcm_sensor_heartbeat_open,
+            .mca_close_component = orcm_sensor_heartbeat_close,
+            .mca_query_component = orcm_sensor_heartbeat_query,
+            .mca_register_component_params = orcm_sensor_heartbeat_register
+        },
+        .base_data = {
+            /* The component is checkpoint ready */
+            MCA_BASE_METADATA_PARAM_CHECKPOINT
+        },
+        "heartbeat"
+    }
 };
 
 
+static int orcm_sensor_heartbeat_register(void)
+{
+    mca_base_component_t *c = &mca_sensor_heartbeat_component.super.base_version;
+
+    mca_sensor_heartbeat_component.phi_threshold = 8.0;
+    (void) mca_base_component_var_register(c, "phi_threshold",
+                                           "Suspicion level at which a daemon is declared failed - each unit makes a late beat ten times less likely to be taken for a failure [default: 8]",
+                                           MCA_BASE_VAR_TYPE_DOUBLE, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_sensor_heartbeat_component.phi_threshold);
+
+    mca_sensor_heartbeat_component.missed = 1;
+    (void) mca_base_component_var_register(c, "missed",
+                                           "Number of beats in a row a daemon may miss before it starts being suspected [default: 1]",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_sensor_heartbeat_component.missed);
+    return ORCM_SUCCESS;
+}
+
+
 /**
   * component open/close/init function
   */
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2015      Intel, Inc.  All rights reserved.
+ *
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#include <math.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif  /* HAVE_STRING_H */
+
+#include "sensor_heartbeat.h"
+
+/* number of slots in the wheel, and of slots per expected beat */
+#define ORCM_SENSOR_HEARTBEAT_SLOTS     1024
+#define ORCM_SENSOR_HEARTBEAT_TICKS     4
+/* weight of a new time between beats in the moving mean */
+#define ORCM_SENSOR_HEARTBEAT_ALPHA     0.125
+
+/* the probability that a beat comes more than y std devs late */
+static double phi_of(double y)
+{
+    double p = 0.5 * erfc(y / M_SQRT2);
+
+    return (p < 1e-300) ? 300.0 : -log10(p);
+}
+
+/* daemons beating too regularly would be failed at the first hiccup */
+static double std_of(orcm_sensor_heartbeat_detector_t *det,
+                     orcm_sensor_heartbeat_peer_t *p)
+{
+    double std = sqrt(p->var);
+
+    return (std < det->interval / 4.0) ? det->interval / 4.0 : std;
+}
+
+static int grow(orcm_sensor_heartbeat_detector_t *det, orte_vpid_t vpid)
+{
+    orcm_sensor_heartbeat_peer_t *tmp;
+    int64_t n;
+    int32_t i;
+
+    if (vpid < (orte_vpid_t)det->npeers) {
+        return ORCM_SUCCESS;
+    }
+    /* the wheel links daemons by int32 index */
+    if ((orte_vpid_t)INT32_MAX <= vpid) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    n = (0 == det->npeers) ? 64 : 2 * (int64_t)det->npeers;
+    if (n <= (int64_t)vpid) {
+        n = (int64_t)vpid + 1;
+    }
+    if (INT32_MAX < n) {
+        n = INT32_MAX;
+    }
+    tmp = (orcm_sensor_heartbeat_peer_t*)realloc(det->peers, n * sizeof(orcm_sensor_heartbeat_peer_t));
+    if (NULL == tmp) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    det->peers = tmp;
+    for (i=det->npeers; i < n; i++) {
+        memset(&det->peers[i], 0, sizeof(orcm_sensor_heartbeat_peer_t));
+        det->peers[i].mean = det->interval;
+        det->peers[i].slot = -1;
+        det->peers[i].next = -1;
+        det->peers[i].prev = -1;
+    }
+    det->npeers = (int32_t)n;
+    return ORCM_SUCCESS;
+}
+
+static void unlink_peer(orcm_sensor_heartbeat_detector_t *det, int32_t v)
+{
+    orcm_sensor_heartbeat_peer_t *p = &det->peers[v];
+
+    if (0 > p->slot) {
+        return;
+    }
+    if (0 <= p->prev) {
+        det->peers[p->prev].next = p->next;
+    } else {
+        det->slots[p->slot] = p->next;
+    }
+    if (0 <= p->next) {
+        det->peers[p->next].prev = p->prev;
+    }
+    p->slot = p->next = p->prev = -1;
+}
+
+/* file the daemon under the tick holding its deadline - or the next
+ * one to be checked if that one already went by */
+static void schedule(orcm_sensor_heartbeat_detector_t *det, int32_t v)
+{
+    orcm_sensor_heartbeat_peer_t *p = &det->peers[v];
+    int64_t t;
+
+    p->deadline = p->last + p->mean + det->pause + det->z * std_of(det, p);
+    t = (int64_t)((p->deadline - det->start) / det->tick);
+    if (t <= det->last_tick) {
+        t = det->last_tick + 1;
+    }
+    p->slot = t % det->nslots;
+    p->prev = -1;
+    p->next = det->slots[p->slot];
+    if (0 <= p->next) {
+        det->peers[p->next].prev = v;
+    }
+    det->slots[p->slot] = v;
+}
+
+int orcm_sensor_heartbeat_detector_init(orcm_sensor_heartbeat_detector_t *det,
+                                        double interval, double pause,
+                                        double threshold, double now)
+{
+    double lo = -10.0, hi = 40.0, mid;
+    int32_t i;
+
+    memset(det, 0, sizeof(orcm_sensor_heartbeat_detector_t));
+    det->interval = interval;
+    det->pause = pause;
+    det->threshold = threshold;
+    if (NULL == (det->slots = (int32_t*)malloc(ORCM_SENSOR_HEARTBEAT_SLOTS * sizeof(int32_t)))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    det->nslots = ORCM_SENSOR_HEARTBEAT_SLOTS;
+    for (i=0; i < det->nslots; i++) {
+        det->slots[i] = -1;
+    }
+    det->tick = interval / ORCM_SENSOR_HEARTBEAT_TICKS;
+    det->start = now;
+    det->last_tick = -1;
+
+    /* phi only grows with lateness, so find once how late a beat
+     * must be to reach the threshold */
+    while (hi - lo > 1e-6) {
+        mid = (lo + hi) / 2.0;
+        if (phi_of(mid) < threshold) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    det->z = hi;
+    return ORCM_SUCCESS;
+}
+
+void orcm_sensor_heartbeat_detector_fini(orcm_sensor_heartbeat_detector_t *det)
+{
+    if (NULL != det->peers) {
+        free(det->peers);
+        det->peers = NULL;
+    }
+    if (NULL != det->slots) {
+        free(det->slots);
+        det->slots = NULL;
+    }
+    det->npeers = 0;
+}
+
+int orcm_sensor_heartbeat_detector_watch(orcm_sensor_heartbeat_detector_t *det,
+                                         orte_vpid_t vpid, double now)
+{
+    orcm_sensor_heartbeat_peer_t *p;
+    int rc;
+
+    if (ORCM_SUCCESS != (rc = grow(det, vpid))) {
+        return rc;
+    }
+    p = &det->peers[vpid];
+    unlink_peer(det, vpid);
+    p->last = now;
+    p->failed = false;
+    schedule(det, vpid);
+    return ORCM_SUCCESS;
+}
+
+bool orcm_sensor_heartbeat_detector_watched(orcm_sensor_heartbeat_detector_t *det,
+                                            orte_vpid_t vpid)
+{
+    orcm_sensor_heartbeat_peer_t *p;
+
+    if (vpid >= (orte_vpid_t)det->npeers) {
+        return false;
+    }
+    p = &det->peers[vpid];
+    return (0 <= p->slot || p->failed || 0 < p->nbeats);
+}
+
+int orcm_sensor_heartbeat_detector_beat(orcm_sensor_heartbeat_detector_t *det,
+                                        orte_vpid_t vpid, double now, bool *failed)
+{
+    orcm_sensor_heartbeat_peer_t *p;
+    double diff;
+    int rc;
+
+    if (ORCM_SUCCESS != (rc = grow(det, vpid))) {
+        return rc;
+    }
+    p = &det->peers[vpid];
+    *failed = p->failed;
+
+    /* the time since a watch or a failure says nothing of how
+     * regularly the daemon beats */
+    if (0 < p->nbeats && !*failed && 0 <= p->slot) {
+        diff = (now - p->last) - p->mean;
+        p->mean += ORCM_SENSOR_HEARTBEAT_ALPHA * diff;
+        p->var = (1.0 - ORCM_SENSOR_HEARTBEAT_ALPHA) *
+                 (p->var + ORCM_SENSOR_HEARTBEAT_ALPHA * diff * diff);
+    }
+    p->nbeats++;
+    p->last = now;
+    p->failed = false;
+    p->missed = 0;
+    unlink_peer(det, vpid);
+    schedule(det, vpid);
+    return ORCM_SUCCESS;
+}
+
+double orcm_sensor_heartbeat_detector_phi(orcm_sensor_heartbeat_detector_t *det,
+                                          orte_vpid_t vpid, double now)
+{
+    orcm_sensor_heartbeat_peer_t *p;
+
+    if (vpid >= (orte_vpid_t)det->npeers) {
+        return 0.0;
+    }
+    p = &det->peers[vpid];
+    if (0 > p->slot && !p->failed) {
+        /* not expecting anything from it */
+        return 0.0;
+    }
+    return phi_of((now - p->last - p->mean - det->pause) / std_of(det, p));
+}
+
+int orcm_sensor_heartbeat_detector_expire(orcm_sensor_heartbeat_detector_t *det,
+                                          double now,
+                                          orcm_sensor_heartbeat_failed_fn_t cbfunc,
+                                          void *cbdata)
+{
+    orcm_sensor_heartbeat_peer_t *p;
+    int64_t t, cur;
+    int32_t v, next;
+    int n = 0;
+
+    /* only ticks that are over - their daemons are all due, except
+     * those filed a turn or more ahead */
+    cur = (int64_t)((now - det->start) / det->tick) - 1;
+    t = det->last_tick + 1;
+    if (det->nslots < cur - t + 1) {
+        t = cur - det->nslots + 1;
+    }
+    for (; t <= cur; t++) {
+        for (v=det->slots[t % det->nslots]; 0 <= v; v=next) {
+            p = &det->peers[v];
+            next = p->next;
+            if (p->deadline > now) {
+                continue;
+            }
+            unlink_peer(det, v);
+            p->failed = true;
+            p->missed = (uint32_t)((now - p->last) / p->mean);
+            n++;
+            if (NULL != cbfunc) {
+                cbfunc(v, phi_of((now - p->last - p->mean - det->pause) / std_of(det, p)),
+                       p->missed, cbdata);
+            }
+        }
+    }
+    if (det->last_tick < cur) {
+        det->last_tick = cur;
+    }
+    return n;
+}
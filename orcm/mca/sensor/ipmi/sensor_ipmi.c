@@ -51,6 +51,13 @@ static void ipmi_inventory_log(char *hostname, opal_buffer_t *inventory_snapshot
 static void ipmi_set_sample_rate(int sample_rate);
 static void ipmi_get_sample_rate(int *sample_rate);
 bool does_sensor_group_match_sensor_name(char* sensor_group, char* sensor_name);
+static bool ipmi_sensor_wanted(char *tag);
+static void ipmi_set_credentials(ipmi_capsule_t *cap);
+static void ipmi_engine_sample(void);
+static void ipmi_engine_results(orcm_sensor_hosts_t *host);
+static void ipmi_set_device_id(ipmi_capsule_t *cap, unsigned char *rdata);
+static void ipmi_set_power_states(ipmi_capsule_t *cap, unsigned char *rdata);
+static bool ipmi_add_metric(ipmi_capsule_t *cap, char *tag, double val, char *typestr);
 
 int first_sample = 0;
 
@@ -63,9 +70,13 @@ static orcm_sensor_ipmi_t orcm_sensor_ipmi;
 
 static void ipmi_con(orcm_sensor_hosts_t *host)
 {
+    host->bmc = NULL;
 }
 static void ipmi_des(orcm_sensor_hosts_t *host)
 {
+    if (NULL != host->bmc) {
+        OBJ_RELEASE(host->bmc);
+    }
 }
 OBJ_CLASS_INSTANCE(orcm_sensor_hosts_t,
                    opal_list_item_t,
@@ -1652,6 +1663,11 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         return;
     }
 
+    /* sample all the BMCs at once */
+    if (mca_sensor_ipmi_component.async) {
+        ipmi_engine_sample();
+    }
+
     /* Loop through each host from the host list*/
     OPAL_LIST_FOREACH_SAFE(host, nxt, &sensor_active_hosts, orcm_sensor_hosts_t) {
         opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
@@ -1659,33 +1675,18 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
         /* Clear all memory for the ipmi_capsule */
         memset(&(host->capsule.prop), '\0', sizeof(host->capsule.prop));
 
-        /* If the bmc username was passed as an mca parameter, set it. */
-        if (NULL != mca_sensor_ipmi_component.bmc_username) {
-            strncpy(host->capsule.node.user, mca_sensor_ipmi_component.bmc_username, sizeof(host->capsule.node.user)-1);
-            host->capsule.node.user[sizeof(host->capsule.node.user)-1] = '\0';
-        } else {
-            strncpy(host->capsule.node.user, "root", sizeof(host->capsule.node.user)-1);
-            host->capsule.node.user[sizeof(host->capsule.node.user)-1] = '\0';
-        }
+        ipmi_set_credentials(&host->capsule);
 
-        /*
-        If the bmc password was passed as an mca parameter, set it.
-        Otherwise, leave it as null.
-        */
-        if (NULL != mca_sensor_ipmi_component.bmc_password) {
-            strncpy(host->capsule.node.pasw, mca_sensor_ipmi_component.bmc_password, sizeof(host->capsule.node.pasw)-1);
-            host->capsule.node.pasw[sizeof(host->capsule.node.pasw)-1] = '\0';
+        /* Running a sample for a Node - the engine has it already,
+         * unless the BMC does not do IPMI v1.5 sessions */
+        if (NULL != host->bmc && !host->bmc->unsupported) {
+            ipmi_engine_results(host);
+        } else {
+            orcm_sensor_ipmi_get_device_id(&host->capsule);
+            orcm_sensor_ipmi_get_power_states(&host->capsule);
+            orcm_sensor_ipmi_get_sensor_reading(&host->capsule);
         }
 
-        host->capsule.node.auth = IPMI_SESSION_AUTHTYPE_PASSWORD;
-        host->capsule.node.priv = IPMI_PRIV_LEVEL_ADMIN;
-        host->capsule.node.ciph = 3; /* Cipher suite No. 3 */
-
-        /* Running a sample for a Node */
-        orcm_sensor_ipmi_get_device_id(&host->capsule);
-        orcm_sensor_ipmi_get_power_states(&host->capsule);
-        orcm_sensor_ipmi_get_sensor_reading(&host->capsule);
-
         gettimeofday(&current_time, NULL);
 
         if (OPAL_SUCCESS != (rc = opal_dss.pack(&data, &current_time, 1, OPAL_TIMEVAL))) {
@@ -1804,6 +1805,102 @@ static void collect_sample(orcm_sensor_sampler_t *sampler)
                         "IPMI sensors just got implemented! ----------- ;)");
 }
 
+static void ipmi_set_credentials(ipmi_capsule_t *cap)
+{
+    /* If the bmc username was passed as an mca parameter, set it. */
+    if (NULL != mca_sensor_ipmi_component.bmc_username) {
+        strncpy(cap->node.user, mca_sensor_ipmi_component.bmc_username, sizeof(cap->node.user)-1);
+        cap->node.user[sizeof(cap->node.user)-1] = '\0';
+    } else {
+        strncpy(cap->node.user, "root", sizeof(cap->node.user)-1);
+        cap->node.user[sizeof(cap->node.user)-1] = '\0';
+    }
+
+    /*
+    If the bmc password was passed as an mca parameter, set it.
+    Otherwise, leave it as null.
+    */
+    if (NULL != mca_sensor_ipmi_component.bmc_password) {
+        strncpy(cap->node.pasw, mca_sensor_ipmi_component.bmc_password, sizeof(cap->node.pasw)-1);
+        cap->node.pasw[sizeof(cap->node.pasw)-1] = '\0';
+    }
+
+    cap->node.auth = IPMI_SESSION_AUTHTYPE_PASSWORD;
+    cap->node.priv = IPMI_PRIV_LEVEL_ADMIN;
+    cap->node.ciph = 3; /* Cipher suite No. 3 */
+}
+
+/* a sensor is sampled when listed, or in the sensor group */
+static bool ipmi_sensor_wanted(char *tag)
+{
+    if (orcm_sensor_ipmi_label_found(tag)) {
+        return true;
+    }
+    return (NULL != mca_sensor_ipmi_component.sensor_group &&
+            does_sensor_group_match_sensor_name(mca_sensor_ipmi_component.sensor_group, tag));
+}
+
+static void ipmi_engine_sample(void)
+{
+    orcm_sensor_ipmi_bmc_t **bmcs;
+    orcm_sensor_hosts_t *host;
+    int nbmcs = 0, rc;
+
+    bmcs = (orcm_sensor_ipmi_bmc_t**)malloc(opal_list_get_size(&sensor_active_hosts) *
+                                            sizeof(orcm_sensor_ipmi_bmc_t*));
+    if (NULL == bmcs) {
+        ORTE_ERROR_LOG(ORCM_ERR_OUT_OF_RESOURCE);
+        return;
+    }
+    OPAL_LIST_FOREACH(host, &sensor_active_hosts, orcm_sensor_hosts_t) {
+        if (NULL == host->bmc) {
+            ipmi_set_credentials(&host->capsule);
+            host->bmc = orcm_sensor_ipmi_engine_bmc(host->capsule.node.bmc_ip,
+                                                    ORCM_SENSOR_IPMI_PORT,
+                                                    host->capsule.node.user,
+                                                    host->capsule.node.pasw);
+            if (NULL == host->bmc) {
+                continue;
+            }
+        }
+        if (!host->bmc->unsupported) {
+            bmcs[nbmcs++] = host->bmc;
+        }
+    }
+    if (ORCM_SUCCESS != (rc = orcm_sensor_ipmi_engine_poll(bmcs, nbmcs, ipmi_sensor_wanted))) {
+        ORTE_ERROR_LOG(rc);
+    }
+    free(bmcs);
+}
+
+static void ipmi_engine_results(orcm_sensor_hosts_t *host)
+{
+    orcm_sensor_ipmi_bmc_t *bmc = host->bmc;
+    ipmi_capsule_t *cap = &host->capsule;
+    orcm_sensor_ipmi_reading_t *sensor;
+    int k;
+
+    if (ORCM_SUCCESS != bmc->status) {
+        orte_show_help("help-orcm-sensor-ipmi.txt", "ipmi-cmd-fail",
+                       true, cap->node.name, ORTE_ERROR_NAME(bmc->status));
+    }
+    if (bmc->have_devid) {
+        ipmi_set_device_id(cap, bmc->devid);
+    }
+    if (bmc->have_power) {
+        ipmi_set_power_states(cap, bmc->power);
+    }
+    /* the cached records are those of the wanted sensors */
+    for (k=0; k < bmc->nsensors; k++) {
+        sensor = &bmc->sensors[k];
+        if (sensor->valid &&
+            ipmi_add_metric(cap, sensor->tag, RawToFloat(sensor->reading[0], sensor->sdr),
+                            get_unit_type(sensor->sdr[20], sensor->sdr[21], sensor->sdr[22], 0))) {
+            break;
+        }
+    }
+}
+
 static void mycleanup(int dbhandle, int status, opal_list_t *kvs,
                       opal_list_t *ret, void *cbdata)
 {
@@ -1890,6 +1987,59 @@ void orcm_sensor_ipmi_get_device_power_state(uchar in, char* str, int str_size)
     str[str_size-1] = '\0';
 }
 
+static void ipmi_set_device_id(ipmi_capsule_t *cap, unsigned char *rdata)
+{
+    device_id_t devid;
+
+    memcpy(&devid.raw, rdata, sizeof(devid));
+
+    /*  Pack the BMC FW Rev */
+    snprintf(cap->prop.bmc_rev, sizeof(cap->prop.bmc_rev),
+            "%x.%x", devid.bits.fw_rev_1&0x7F, devid.bits.fw_rev_2&0xFF);
+
+    /*  Pack the IPMI VER */
+    snprintf(cap->prop.ipmi_ver,sizeof(cap->prop.ipmi_ver),
+            "%x.%x", devid.bits.ipmi_ver&0xF, devid.bits.ipmi_ver&0xF0);
+
+    /*  Pack the Manufacturer ID */
+    snprintf(cap->prop.man_id, sizeof(cap->prop.man_id),
+            "%x%02x%02x", (devid.bits.manufacturer_id[2]&0x0f), devid.bits.manufacturer_id[1], devid.bits.manufacturer_id[0]);
+}
+
+static void ipmi_set_power_states(ipmi_capsule_t *cap, unsigned char *rdata)
+{
+    acpi_power_state_t pwr_state;
+    char sys_pwr_state_str[16], dev_pwr_state_str[16];
+
+    memcpy(&pwr_state.raw, rdata, sizeof(pwr_state));
+    orcm_sensor_ipmi_get_system_power_state(pwr_state.bits.sys_power_state, sys_pwr_state_str, sizeof(sys_pwr_state_str));
+    orcm_sensor_ipmi_get_device_power_state(pwr_state.bits.dev_power_state, dev_pwr_state_str, sizeof(dev_pwr_state_str));
+    /* Copy all retrieved information in a global buffer */
+    memcpy(cap->prop.sys_power_state,sys_pwr_state_str,MIN(sizeof(sys_pwr_state_str),sizeof(cap->prop.sys_power_state)));
+    memcpy(cap->prop.dev_power_state,dev_pwr_state_str,MIN(sizeof(dev_pwr_state_str),sizeof(cap->prop.dev_power_state)));
+}
+
+/* returns true once the capsule is full */
+static bool ipmi_add_metric(ipmi_capsule_t *cap, char *tag, double val, char *typestr)
+{
+    int sensor_count = cap->prop.total_metrics;
+
+    /*  Pack the Sensor Metric */
+    cap->prop.collection_metrics[sensor_count]=val;
+    strncpy(cap->prop.collection_metrics_units[sensor_count],typestr,sizeof(cap->prop.collection_metrics_units[sensor_count])-1);
+    cap->prop.collection_metrics_units[sensor_count][sizeof(cap->prop.collection_metrics_units[sensor_count])-1] = '\0';
+    strncpy(cap->prop.metric_label[sensor_count],tag,sizeof(cap->prop.metric_label[sensor_count])-1);
+    cap->prop.metric_label[sensor_count][sizeof(cap->prop.metric_label[sensor_count])-1] = '\0';
+    cap->prop.total_metrics = ++sensor_count;
+    if (sensor_count == TOTAL_FLOAT_METRICS)
+    {
+        opal_output(0, "Max 'sensor' sampling reached for IPMI Plugin: %d",
+            sensor_count);
+        return true;
+    }
+    return false;
+}
+
 void orcm_sensor_ipmi_get_device_id(ipmi_capsule_t *cap)
 {
     int ret = 0;
@@ -1898,7 +2048,6 @@ void orcm_sensor_ipmi_get_device_id(ipmi_capsule_t *cap)
     unsigned char ccode;
     int rlen = MAX_IPMI_RESPONSE;
     char fdebug = 0;
-    device_id_t devid;
     char *error_string;
 
     ret = set_lan_options(cap->node.bmc_ip, cap->node.user, cap->node.pasw, cap->node.auth, cap->node.priv, cap->node.ciph, &addr, 16);
@@ -1908,19 +2057,7 @@ void orcm_sensor_ipmi_get_device_id(ipmi_capsule_t *cap)
         if(0 == ret)
         {
             ipmi_close();
-            memcpy(&devid.raw, rdata, sizeof(devid));
-
-            /*  Pack the BMC FW Rev */
-            snprintf(cap->prop.bmc_rev, sizeof(cap->prop.bmc_rev),
-                    "%x.%x", devid.bits.fw_rev_1&0x7F, devid.bits.fw_rev_2&0xFF);
-
-            /*  Pack the IPMI VER */
-            snprintf(cap->prop.ipmi_ver,sizeof(cap->prop.ipmi_ver),
-                    "%x.%x", devid.bits.ipmi_ver&0xF, devid.bits.ipmi_ver&0xF0);
-
-            /*  Pack the Manufacturer ID */
-            snprintf(cap->prop.man_id, sizeof(cap->prop.man_id),
-                    "%x%02x%02x", (devid.bits.manufacturer_id[2]&0x0f), devid.bits.manufacturer_id[1], devid.bits.manufacturer_id[0]);
+            ipmi_set_device_id(cap, rdata);
         } else {
             /*disable_ipmi = 1;*/
             error_string = decode_rv(ret);
@@ -1949,8 +2086,6 @@ void orcm_sensor_ipmi_get_power_states(ipmi_capsule_t *cap)
     unsigned char ccode;
     int rlen = MAX_IPMI_RESPONSE;
     char fdebug = 0;
-    acpi_power_state_t pwr_state;
-    char sys_pwr_state_str[16], dev_pwr_state_str[16];
     char *error_string;
 
     memset(rdata,0xff,sizeof(rdata));
@@ -1962,12 +2097,7 @@ void orcm_sensor_ipmi_get_power_states(ipmi_capsule_t *cap)
         if(0 == ret)
         {
             ipmi_close();
-            memcpy(&pwr_state.raw, rdata, sizeof(pwr_state));
-            orcm_sensor_ipmi_get_system_power_state(pwr_state.bits.sys_power_state, sys_pwr_state_str, sizeof(sys_pwr_state_str));
-            orcm_sensor_ipmi_get_device_power_state(pwr_state.bits.dev_power_state, dev_pwr_state_str, sizeof(dev_pwr_state_str));
-            /* Copy all retrieved information in a global buffer */
-            memcpy(cap->prop.sys_power_state,sys_pwr_state_str,MIN(sizeof(sys_pwr_state_str),sizeof(cap->prop.sys_power_state)));
-            memcpy(cap->prop.dev_power_state,dev_pwr_state_str,MIN(sizeof(dev_pwr_state_str),sizeof(cap->prop.dev_power_state)));
+            ipmi_set_power_states(cap, rdata);
         } else {
             error_string = decode_rv(ret);
             orte_show_help("help-orcm-sensor-ipmi.txt", "ipmi-cmd-mc-fail",
@@ -2012,7 +2142,6 @@ void orcm_sensor_ipmi_get_sensor_reading(ipmi_capsule_t *cap)
     unsigned char sdrbuf[SDR_SZ];
     unsigned char *sdrlist;
     char *error_string;
-    int sensor_count = 0;
 
     /* BEGIN: Gathering SDRs */
     ret = set_lan_options(cap->node.bmc_ip, cap->node.user, cap->node.pasw, cap->node.auth, cap->node.priv, cap->node.ciph, &addr, 16);
@@ -2048,32 +2177,9 @@ void orcm_sensor_ipmi_get_sensor_reading(ipmi_capsule_t *cap)
                 {
                     val = RawToFloat(reading[0], sdrbuf);
                     typestr = get_unit_type( sdrbuf[20], sdrbuf[21], sdrbuf[22],0);
-                    if(orcm_sensor_ipmi_label_found(tag))
-                    {
-                        /*  Pack the Sensor Metric */
-                        cap->prop.collection_metrics[sensor_count]=val;
-                        strncpy(cap->prop.collection_metrics_units[sensor_count],typestr,sizeof(cap->prop.collection_metrics_units[sensor_count])-1);
-                        cap->prop.collection_metrics_units[sensor_count][sizeof(cap->prop.collection_metrics_units[sensor_count])-1] = '\0';
-                        strncpy(cap->prop.metric_label[sensor_count],tag,sizeof(cap->prop.metric_label[sensor_count])-1);
-                        cap->prop.metric_label[sensor_count][sizeof(cap->prop.metric_label[sensor_count])-1] = '\0';
-                        sensor_count++;
-                    } else if(NULL!=mca_sensor_ipmi_component.sensor_group)
-                    {
-                        if(true == does_sensor_group_match_sensor_name(mca_sensor_ipmi_component.sensor_group, tag))
-                        {
-                            /*  Pack the Sensor Metric */
-                            cap->prop.collection_metrics[sensor_count]=val;
-                            strncpy(cap->prop.collection_metrics_units[sensor_count],typestr,sizeof(cap->prop.collection_metrics_units[sensor_count])-1);
-                            cap->prop.collection_metrics_units[sensor_count][sizeof(cap->prop.collection_metrics_units[sensor_count])-1] = '\0';
-                            strncpy(cap->prop.metric_label[sensor_count],tag,sizeof(cap->prop.metric_label[sensor_count])-1);
-                            cap->prop.metric_label[sensor_count][sizeof(cap->prop.metric_label[sensor_count])-1] = '\0';
-                            sensor_count++;
-                        }
-                    }
-                    if (sensor_count == TOTAL_FLOAT_METRICS)
+                    if(ipmi_sensor_wanted(tag) &&
+                       ipmi_add_metric(cap, tag, val, typestr))
                     {
-                        opal_output(0, "Max 'sensor' sampling reached for IPMI Plugin: %d",
-                            sensor_count);
                         break;
                     }
                 } else {
@@ -2083,7 +2189,6 @@ void orcm_sensor_ipmi_get_sensor_reading(ipmi_capsule_t *cap)
                 memset(sdrbuf,0,SDR_SZ);
             }
             free_sdr_cache(sdrlist);
-            cap->prop.total_metrics = sensor_count;
         }
         ipmi_close();
         /* End: gathering SDRs */
@@ -19,6 +19,7 @@
 
 #include "orcm/mca/sensor/sensor.h"
 #include <ipmicmd.h>
+#include "sensor_ipmi_engine.h"
 #include "sensor_ipmi_decls.h"
 
 BEGIN_C_DECLS
@@ -34,6 +35,7 @@ typedef struct {
     char *sensor_group;
     bool use_progress_thread;
     int sample_rate;
+    bool async;
 } orcm_sensor_ipmi_component_t;
 
 struct ipmi_properties *first_node;
@@ -133,6 +133,38 @@ static int ipmi_component_register(void)
                                            OPAL_INFO_LVL_9,
                                            MCA_BASE_VAR_SCOPE_READONLY,
                                            &mca_sensor_ipmi_component.sample_rate);
+
+    mca_sensor_ipmi_component.async = true;
+    (void) mca_base_component_var_register(c, "async",
+                                           "Sample all the BMCs at once, keeping a session with each, rather than through ipmiutil one at a time [default: true]",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_sensor_ipmi_component.async);
+
+    orcm_sensor_ipmi_engine.timeout = 1000;
+    (void) mca_base_component_var_register(c, "timeout",
+                                           "Milliseconds to wait for a BMC to answer before asking again [default: 1000]",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &orcm_sensor_ipmi_engine.timeout);
+
+    orcm_sensor_ipmi_engine.retries = 2;
+    (void) mca_base_component_var_register(c, "retries",
+                                           "Times to ask a BMC again before giving up on it for the sample [default: 2]",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &orcm_sensor_ipmi_engine.retries);
+
+    orcm_sensor_ipmi_engine.session_idle = 30;
+    (void) mca_base_component_var_register(c, "session_idle",
+                                           "Seconds a BMC session may stay unused before a new one is opened [default: 30]",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &orcm_sensor_ipmi_engine.session_idle);
   
     return ORCM_SUCCESS;
 }
@@ -112,6 +112,7 @@ typedef struct {
 typedef struct _orcm_sensor_hosts_t {
     opal_list_item_t super;
     ipmi_capsule_t  capsule;
+    orcm_sensor_ipmi_bmc_t *bmc;    /* its session with the engine */
 }orcm_sensor_hosts_t;
 
 // List of all properties to be scanned by the IPMI Plugin
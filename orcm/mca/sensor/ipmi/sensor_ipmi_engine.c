@@ -0,0 +1,824 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "opal/util/output.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/name_fns.h"
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/mca/sensor/base/base.h"
+
+#include "sensor_ipmi_engine.h"
+
+/*
+ * The IPMI v1.5 LAN protocol, as much of it as sampling takes: a
+ * request is an RMCP header, a session header and the IPMI message, and
+ * a session is opened by asking for the authentication types of the
+ * channel, a challenge and its activation. Messages of a session are
+ * authenticated by MD5 or the straight password, whichever the BMC
+ * supports first - BMCs with neither are left to ipmiutil, and so are
+ * the sensors owned by a controller other than the BMC, which would take
+ * bridged requests.
+ */
+
+#define NETFN_APP       0x06
+#define NETFN_SE        0x04
+#define NETFN_STORAGE   0x0a
+
+#define CMD_GET_DEVICE_ID       0x01
+#define CMD_GET_ACPI_POWER      0x07
+#define CMD_GET_AUTH_CAP        0x38
+#define CMD_GET_CHALLENGE       0x39
+#define CMD_ACTIVATE_SESSION    0x3a
+#define CMD_SET_PRIVILEGE       0x3b
+#define CMD_CLOSE_SESSION       0x3c
+#define CMD_GET_SENSOR_READING  0x2d
+#define CMD_GET_SDR_REPO_INFO   0x20
+#define CMD_RESERVE_SDR_REPO    0x22
+#define CMD_GET_SDR             0x23
+
+#define AUTH_NONE       0x00
+#define AUTH_MD5        0x02
+#define AUTH_PASSWORD   0x04
+
+#define PRIV_ADMIN      0x04
+#define BMC_ADDR        0x20
+#define REMOTE_ADDR     0x81
+
+#define CC_RESERVATION_CANCELLED 0xc5
+#define SDR_FULL_SENSOR 0x01
+#define SDR_HEADER_SZ   5
+#define SDR_CHUNK       16
+#define SDR_LAST_RECORD 0xffff
+#define SDR_RESTARTS    5
+
+/* where a BMC stands in a sample */
+enum {
+    BMC_AUTH_CAP,
+    BMC_CHALLENGE,
+    BMC_ACTIVATE,
+    BMC_PRIVILEGE,
+    BMC_DEVICE_ID,
+    BMC_POWER,
+    BMC_REPO_INFO,
+    BMC_RESERVE,
+    BMC_SDR_HEADER,
+    BMC_SDR_BODY,
+    BMC_READING,
+    BMC_DONE
+};
+
+orcm_sensor_ipmi_engine_t orcm_sensor_ipmi_engine = {
+    1000,
+    2,
+    30
+};
+
+static void bmc_con(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    bmc->addr = NULL;
+    bmc->port = ORCM_SENSOR_IPMI_PORT;
+    memset(bmc->user, 0, sizeof(bmc->user));
+    memset(bmc->pasw, 0, sizeof(bmc->pasw));
+    bmc->fd = -1;
+    bmc->state = BMC_DONE;
+    bmc->status = ORCM_SUCCESS;
+    bmc->active = false;
+    bmc->fresh = false;
+    bmc->unsupported = false;
+    bmc->rq_seq = 0;
+    bmc->have_devid = false;
+    bmc->have_power = false;
+    bmc->sdr_valid = false;
+    bmc->sensors = NULL;
+    bmc->nsensors = 0;
+    bmc->size = 0;
+    bmc->current = 0;
+    bmc->sessions = 0;
+    bmc->sdr_walks = 0;
+    bmc->requests = 0;
+    bmc->timeouts = 0;
+}
+static void bmc_des(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    orcm_sensor_ipmi_engine_close(bmc);
+    if (0 <= bmc->fd) {
+        close(bmc->fd);
+    }
+    if (NULL != bmc->addr) {
+        free(bmc->addr);
+    }
+    if (NULL != bmc->sensors) {
+        free(bmc->sensors);
+    }
+}
+OBJ_CLASS_INSTANCE(orcm_sensor_ipmi_bmc_t,
+                   opal_object_t,
+                   bmc_con, bmc_des);
+
+/* MD5 as in RFC 1321, for the authentication codes */
+static uint32_t md5_k[64];
+
+static void md5_block(uint32_t s[4], const unsigned char *p)
+{
+    static const unsigned char r[4][4] = {{7, 12, 17, 22}, {5, 9, 14, 20},
+                                          {4, 11, 16, 23}, {6, 10, 15, 21}};
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3], f, t, m[16];
+    int i, g;
+
+    for (i=0; i < 16; i++) {
+        m[i] = (uint32_t)p[4*i] | (uint32_t)p[4*i+1] << 8 |
+               (uint32_t)p[4*i+2] << 16 | (uint32_t)p[4*i+3] << 24;
+    }
+    for (i=0; i < 64; i++) {
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        t = d;
+        d = c;
+        c = b;
+        f += a + md5_k[i] + m[g];
+        b += (f << r[i / 16][i % 4]) | (f >> (32 - r[i / 16][i % 4]));
+        a = t;
+    }
+    s[0] += a;
+    s[1] += b;
+    s[2] += c;
+    s[3] += d;
+}
+
+static void md5(const unsigned char *in, size_t len, unsigned char out[16])
+{
+    uint32_t s[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    unsigned char last[128];
+    size_t i, n;
+
+    if (0 == md5_k[0]) {
+        for (i=0; i < 64; i++) {
+            md5_k[i] = (uint32_t)(fabs(sin((double)(i + 1))) * 4294967296.0);
+        }
+    }
+    for (n=0; n + 64 <= len; n += 64) {
+        md5_block(s, in + n);
+    }
+    memset(last, 0, sizeof(last));
+    memcpy(last, in + n, len - n);
+    last[len - n] = 0x80;
+    n = (len - n < 56) ? 64 : 128;
+    for (i=0; i < 8; i++) {
+        last[n - 8 + i] = (unsigned char)(((uint64_t)len * 8) >> (8 * i));
+    }
+    md5_block(s, last);
+    if (128 == n) {
+        md5_block(s, last + 64);
+    }
+    for (i=0; i < 16; i++) {
+        out[i] = (unsigned char)(s[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static unsigned char checksum(const unsigned char *p, int len)
+{
+    unsigned char sum = 0;
+
+    while (0 < len--) {
+        sum += *p++;
+    }
+    return (unsigned char)(0x100 - sum);
+}
+
+static long msec_until(struct timeval *when, struct timeval *now)
+{
+    return (when->tv_sec - now->tv_sec) * 1000 + (when->tv_usec - now->tv_usec) / 1000;
+}
+
+/* the requests before activation are outside of any session */
+static bool in_session(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    return bmc->active || BMC_ACTIVATE == bmc->state || BMC_PRIVILEGE == bmc->state;
+}
+
+static int transmit(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    unsigned char pkt[ORCM_SENSOR_IPMI_MSG_MAX], msg[64], auth[128];
+    unsigned char authtype = AUTH_NONE;
+    uint32_t seq = 0, id = 0;
+    int len, mlen;
+
+    bmc->rq_seq = (bmc->rq_seq + 1) & 0x3f;
+    msg[0] = BMC_ADDR;
+    msg[1] = (unsigned char)(bmc->netfn << 2 | bmc->lun);
+    msg[2] = checksum(msg, 2);
+    msg[3] = REMOTE_ADDR;
+    msg[4] = (unsigned char)(bmc->rq_seq << 2);
+    msg[5] = bmc->cmd;
+    memcpy(msg + 6, bmc->req, bmc->reqlen);
+    msg[6 + bmc->reqlen] = checksum(msg + 3, 3 + bmc->reqlen);
+    mlen = 7 + bmc->reqlen;
+
+    if (in_session(bmc)) {
+        authtype = bmc->authtype;
+        id = bmc->session_id;
+        /* activation is the first message of the session, at 0 */
+        if (BMC_ACTIVATE != bmc->state) {
+            seq = bmc->seq++;
+            if (0 == bmc->seq) {
+                bmc->seq = 1;
+            }
+        }
+    }
+
+    pkt[0] = 0x06;          /* RMCP version 1.0 */
+    pkt[1] = 0x00;
+    pkt[2] = 0xff;          /* no RMCP ack */
+    pkt[3] = 0x07;          /* IPMI */
+    pkt[4] = authtype;
+    put32(pkt + 5, seq);
+    put32(pkt + 9, id);
+    len = 13;
+    if (AUTH_MD5 == authtype) {
+        memcpy(auth, bmc->pasw, 16);
+        put32(auth + 16, id);
+        memcpy(auth + 20, msg, mlen);
+        put32(auth + 20 + mlen, seq);
+        memcpy(auth + 24 + mlen, bmc->pasw, 16);
+        md5(auth, 40 + mlen, pkt + len);
+        len += 16;
+    } else if (AUTH_PASSWORD == authtype) {
+        memcpy(pkt + len, bmc->pasw, 16);
+        len += 16;
+    }
+    pkt[len++] = (unsigned char)mlen;
+    memcpy(pkt + len, msg, mlen);
+    len += mlen;
+
+    gettimeofday(&bmc->deadline, NULL);
+    bmc->deadline.tv_sec += orcm_sensor_ipmi_engine.timeout / 1000;
+    bmc->deadline.tv_usec += (orcm_sensor_ipmi_engine.timeout % 1000) * 1000;
+    if (1000000 <= bmc->deadline.tv_usec) {
+        bmc->deadline.tv_sec++;
+        bmc->deadline.tv_usec -= 1000000;
+    }
+    bmc->requests++;
+    if (len != send(bmc->fd, pkt, len, 0)) {
+        /* as good as lost - it will time out */
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:ipmi:engine send to %s failed: %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), bmc->addr, strerror(errno));
+    }
+    return ORCM_SUCCESS;
+}
+
+static void request_lun(orcm_sensor_ipmi_bmc_t *bmc, int state, unsigned char netfn,
+                        unsigned char lun, unsigned char cmd, unsigned char *data, int len)
+{
+    bmc->state = state;
+    bmc->netfn = netfn;
+    bmc->lun = lun;
+    bmc->cmd = cmd;
+    memcpy(bmc->req, data, len);
+    bmc->reqlen = len;
+    bmc->tries = 0;
+    transmit(bmc);
+}
+
+static void request(orcm_sensor_ipmi_bmc_t *bmc, int state, unsigned char netfn,
+                    unsigned char cmd, unsigned char *data, int len)
+{
+    request_lun(bmc, state, netfn, 0, cmd, data, len);
+}
+
+static void done(orcm_sensor_ipmi_bmc_t *bmc, int status)
+{
+    bmc->state = BMC_DONE;
+    bmc->status = status;
+    if (ORCM_SUCCESS != status) {
+        opal_output_verbose(2, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:ipmi:engine %s: %s",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), bmc->addr,
+                            ORTE_ERROR_NAME(status));
+    }
+}
+
+/* a session that cannot be had - the BMC is left to the next sample */
+static void fail(orcm_sensor_ipmi_bmc_t *bmc, int status)
+{
+    bmc->active = false;
+    done(bmc, status);
+}
+
+static void open_session(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    unsigned char data[2] = {0x0e, PRIV_ADMIN};   /* this channel */
+
+    bmc->active = false;
+    bmc->fresh = true;
+    request(bmc, BMC_AUTH_CAP, NETFN_APP, CMD_GET_AUTH_CAP, data, 2);
+}
+
+static void read_sensor(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    orcm_sensor_ipmi_reading_t *sensor;
+
+    if (bmc->current >= bmc->nsensors) {
+        done(bmc, ORCM_SUCCESS);
+        return;
+    }
+    /* the sensor number, on the LUN of the record */
+    sensor = &bmc->sensors[bmc->current];
+    request_lun(bmc, BMC_READING, NETFN_SE, sensor->sdr[6] & 0x03,
+                CMD_GET_SENSOR_READING, &sensor->sdr[7], 1);
+}
+
+static void start_readings(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    bmc->current = 0;
+    read_sensor(bmc);
+}
+
+static void reserve(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    request(bmc, BMC_RESERVE, NETFN_STORAGE, CMD_RESERVE_SDR_REPO, NULL, 0);
+}
+
+static void get_sdr(orcm_sensor_ipmi_bmc_t *bmc, int state, int offset, int bytes)
+{
+    unsigned char data[6];
+
+    data[0] = bmc->reservation & 0xff;
+    data[1] = bmc->reservation >> 8;
+    data[2] = bmc->record & 0xff;
+    data[3] = bmc->record >> 8;
+    data[4] = (unsigned char)offset;
+    data[5] = (unsigned char)bytes;
+    request(bmc, state, NETFN_STORAGE, CMD_GET_SDR, data, 6);
+}
+
+/* the cache holds the full sensor records wanted, of sensors on the BMC */
+static void keep_record(orcm_sensor_ipmi_bmc_t *bmc, orcm_sensor_ipmi_want_fn_t want)
+{
+    orcm_sensor_ipmi_reading_t *sensor, *sensors;
+    char tag[17];
+    int len;
+
+    if (BMC_ADDR != bmc->rec[5]) {
+        return;
+    }
+    len = bmc->rec[47] & 0x1f;
+    if (16 < len) {
+        len = 16;
+    }
+    memcpy(tag, &bmc->rec[48], len);
+    tag[len] = '\0';
+    if (NULL != want && !want(tag)) {
+        return;
+    }
+    if (bmc->nsensors == bmc->size) {
+        len = (0 == bmc->size) ? 16 : 2 * bmc->size;
+        sensors = (orcm_sensor_ipmi_reading_t*)realloc(bmc->sensors, len * sizeof(*sensors));
+        if (NULL == sensors) {
+            return;
+        }
+        bmc->sensors = sensors;
+        bmc->size = len;
+    }
+    sensor = &bmc->sensors[bmc->nsensors++];
+    memset(sensor, 0, sizeof(*sensor));
+    memcpy(sensor->sdr, bmc->rec, bmc->reclen);
+    strcpy(sensor->tag, tag);
+}
+
+static void next_record(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    if (SDR_LAST_RECORD == bmc->next_record || bmc->record == bmc->next_record) {
+        bmc->sdr_valid = true;
+        bmc->sdr_walks++;
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:ipmi:engine %s: %d sensors cached",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), bmc->addr, bmc->nsensors);
+        start_readings(bmc);
+        return;
+    }
+    bmc->record = bmc->next_record;
+    get_sdr(bmc, BMC_SDR_HEADER, 0, SDR_HEADER_SZ);
+}
+
+/* the repository could not be walked - report what we have */
+static void sdr_failed(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    bmc->sdr_valid = false;
+    bmc->nsensors = 0;
+    done(bmc, ORCM_ERR_NOT_AVAILABLE);
+}
+
+static void sdr_cancelled(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    if (SDR_RESTARTS <= ++bmc->restarts) {
+        sdr_failed(bmc);
+        return;
+    }
+    /* a new reservation, and the record again */
+    reserve(bmc);
+}
+
+static void handle(orcm_sensor_ipmi_bmc_t *bmc, unsigned char cc,
+                   unsigned char *data, int len, orcm_sensor_ipmi_want_fn_t want)
+{
+    unsigned char req[24];
+    int n;
+
+    switch (bmc->state) {
+    case BMC_AUTH_CAP:
+        if (0 != cc || 2 > len) {
+            fail(bmc, ORCM_ERR_CONNECTION_REFUSED);
+            return;
+        }
+        if (data[1] & (1 << AUTH_MD5)) {
+            bmc->authtype = AUTH_MD5;
+        } else if (data[1] & (1 << AUTH_PASSWORD)) {
+            bmc->authtype = AUTH_PASSWORD;
+        } else {
+            bmc->unsupported = true;
+            fail(bmc, ORCM_ERR_NOT_SUPPORTED);
+            return;
+        }
+        req[0] = bmc->authtype;
+        memcpy(req + 1, bmc->user, 16);
+        request(bmc, BMC_CHALLENGE, NETFN_APP, CMD_GET_CHALLENGE, req, 17);
+        return;
+
+    case BMC_CHALLENGE:
+        if (0 != cc || 20 > len) {
+            fail(bmc, ORCM_ERR_CONNECTION_REFUSED);
+            return;
+        }
+        bmc->session_id = get32(data);
+        memcpy(bmc->challenge, data + 4, 16);
+        req[0] = bmc->authtype;
+        req[1] = PRIV_ADMIN;
+        memcpy(req + 2, bmc->challenge, 16);
+        put32(req + 18, (uint32_t)random() | 1);
+        request(bmc, BMC_ACTIVATE, NETFN_APP, CMD_ACTIVATE_SESSION, req, 22);
+        return;
+
+    case BMC_ACTIVATE:
+        if (0 != cc || 9 > len) {
+            fail(bmc, ORCM_ERR_CONNECTION_REFUSED);
+            return;
+        }
+        bmc->authtype = data[0];
+        bmc->session_id = get32(data + 1);
+        bmc->seq = get32(data + 5);
+        req[0] = PRIV_ADMIN;
+        request(bmc, BMC_PRIVILEGE, NETFN_APP, CMD_SET_PRIVILEGE, req, 1);
+        return;
+
+    case BMC_PRIVILEGE:
+        if (0 != cc) {
+            bmc->active = true;
+            orcm_sensor_ipmi_engine_close(bmc);
+            fail(bmc, ORCM_ERR_PERM);
+            return;
+        }
+        bmc->active = true;
+        bmc->sessions++;
+        request(bmc, BMC_DEVICE_ID, NETFN_APP, CMD_GET_DEVICE_ID, NULL, 0);
+        return;
+
+    case BMC_DEVICE_ID:
+        if (0 == cc && 0 < len) {
+            memcpy(bmc->devid, data, (len < 16) ? len : 16);
+            bmc->have_devid = true;
+        }
+        request(bmc, BMC_POWER, NETFN_APP, CMD_GET_ACPI_POWER, NULL, 0);
+        return;
+
+    case BMC_POWER:
+        if (0 == cc && 2 <= len) {
+            memcpy(bmc->power, data, 2);
+            bmc->have_power = true;
+        }
+        request(bmc, BMC_REPO_INFO, NETFN_STORAGE, CMD_GET_SDR_REPO_INFO, NULL, 0);
+        return;
+
+    case BMC_REPO_INFO:
+        /* the repository is walked again when it had a record added or
+         * erased since the last time */
+        if (0 == cc && 13 <= len) {
+            if (bmc->sdr_valid && bmc->sdr_count == (data[1] | data[2] << 8) &&
+                bmc->sdr_added == get32(data + 5) && bmc->sdr_erased == get32(data + 9)) {
+                start_readings(bmc);
+                return;
+            }
+            bmc->sdr_count = (uint16_t)(data[1] | data[2] << 8);
+            bmc->sdr_added = get32(data + 5);
+            bmc->sdr_erased = get32(data + 9);
+        } else if (bmc->sdr_valid) {
+            /* no way to tell - trust what we have */
+            start_readings(bmc);
+            return;
+        }
+        bmc->sdr_valid = false;
+        bmc->nsensors = 0;
+        bmc->record = 0;
+        bmc->restarts = 0;
+        reserve(bmc);
+        return;
+
+    case BMC_RESERVE:
+        if (0 != cc || 2 > len) {
+            sdr_failed(bmc);
+            return;
+        }
+        bmc->reservation = (uint16_t)(data[0] | data[1] << 8);
+        get_sdr(bmc, BMC_SDR_HEADER, 0, SDR_HEADER_SZ);
+        return;
+
+    case BMC_SDR_HEADER:
+        if (CC_RESERVATION_CANCELLED == cc) {
+            sdr_cancelled(bmc);
+            return;
+        }
+        if (0 != cc || 2 + SDR_HEADER_SZ > len) {
+            sdr_failed(bmc);
+            return;
+        }
+        bmc->next_record = (uint16_t)(data[0] | data[1] << 8);
+        memcpy(bmc->rec, data + 2, SDR_HEADER_SZ);
+        bmc->reclen = SDR_HEADER_SZ + bmc->rec[4];
+        /* only the full sensor records are worth the rest */
+        if (SDR_FULL_SENSOR != bmc->rec[3] || ORCM_SENSOR_IPMI_SDR_SZ < bmc->reclen ||
+            49 > bmc->reclen) {
+            next_record(bmc);
+            return;
+        }
+        bmc->recoff = SDR_HEADER_SZ;
+        n = bmc->reclen - bmc->recoff;
+        get_sdr(bmc, BMC_SDR_BODY, bmc->recoff, (SDR_CHUNK < n) ? SDR_CHUNK : n);
+        return;
+
+    case BMC_SDR_BODY:
+        if (CC_RESERVATION_CANCELLED == cc) {
+            sdr_cancelled(bmc);
+            return;
+        }
+        n = len - 2;
+        if (0 != cc || 0 >= n || bmc->recoff + n > bmc->reclen) {
+            sdr_failed(bmc);
+            return;
+        }
+        memcpy(bmc->rec + bmc->recoff, data + 2, n);
+        bmc->recoff += n;
+        if (bmc->recoff < bmc->reclen) {
+            n = bmc->reclen - bmc->recoff;
+            get_sdr(bmc, BMC_SDR_BODY, bmc->recoff, (SDR_CHUNK < n) ? SDR_CHUNK : n);
+            return;
+        }
+        keep_record(bmc, want);
+        next_record(bmc);
+        return;
+
+    case BMC_READING:
+        /* a reading that is not there yet is left out */
+        bmc->sensors[bmc->current].valid = (0 == cc && 2 <= len && 0 == (data[1] & 0x20));
+        memcpy(bmc->sensors[bmc->current].reading, data, (len < 4) ? len : 4);
+        bmc->current++;
+        read_sensor(bmc);
+        return;
+    }
+}
+
+/* take an answer to the request in flight, ignoring anything else */
+static void receive(orcm_sensor_ipmi_bmc_t *bmc, orcm_sensor_ipmi_want_fn_t want)
+{
+    unsigned char pkt[ORCM_SENSOR_IPMI_MSG_MAX], *msg;
+    int len, off, mlen;
+
+    while (BMC_DONE != bmc->state &&
+           0 < (len = recv(bmc->fd, pkt, sizeof(pkt), 0))) {
+        if (14 > len || 0x06 != pkt[0] || 0x07 != pkt[3]) {
+            continue;
+        }
+        off = 13 + ((AUTH_NONE != pkt[4]) ? 16 : 0);
+        if (off >= len) {
+            continue;
+        }
+        mlen = pkt[off++];
+        if (8 > mlen || off + mlen > len) {
+            continue;
+        }
+        msg = pkt + off;
+        if ((msg[1] >> 2) != (bmc->netfn | 1) || (msg[4] >> 2) != bmc->rq_seq ||
+            msg[5] != bmc->cmd) {
+            continue;
+        }
+        gettimeofday(&bmc->last, NULL);
+        handle(bmc, msg[6], msg + 7, mlen - 8, want);
+    }
+}
+
+static void timed_out(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    bmc->timeouts++;
+    if (bmc->tries < orcm_sensor_ipmi_engine.retries) {
+        bmc->tries++;
+        transmit(bmc);
+        return;
+    }
+    /* the BMC may have closed a session it thought was idle */
+    if (BMC_DEVICE_ID <= bmc->state && !bmc->fresh) {
+        opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
+                            "%s sensor:ipmi:engine %s: session lost",
+                            ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), bmc->addr);
+        open_session(bmc);
+        return;
+    }
+    fail(bmc, ORCM_ERR_TIMEOUT);
+}
+
+static int open_socket(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    int flags;
+
+    memset(&bmc->sa, 0, sizeof(bmc->sa));
+    bmc->sa.sin_family = AF_INET;
+    bmc->sa.sin_port = htons(bmc->port);
+    if (1 != inet_pton(AF_INET, bmc->addr, &bmc->sa.sin_addr)) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 > (bmc->fd = socket(AF_INET, SOCK_DGRAM, 0))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    /* only the BMC is heard on its socket */
+    if (0 > connect(bmc->fd, (struct sockaddr*)&bmc->sa, sizeof(bmc->sa)) ||
+        0 > (flags = fcntl(bmc->fd, F_GETFL, 0)) ||
+        0 > fcntl(bmc->fd, F_SETFL, flags | O_NONBLOCK)) {
+        close(bmc->fd);
+        bmc->fd = -1;
+        return ORCM_ERR_UNREACH;
+    }
+    return ORCM_SUCCESS;
+}
+
+static void start_sample(orcm_sensor_ipmi_bmc_t *bmc, struct timeval *now)
+{
+    int rc;
+
+    bmc->have_devid = false;
+    bmc->have_power = false;
+    bmc->status = ORCM_SUCCESS;
+    bmc->fresh = false;
+    if (0 > bmc->fd && ORCM_SUCCESS != (rc = open_socket(bmc))) {
+        fail(bmc, rc);
+        return;
+    }
+    if (bmc->active && bmc->last.tv_sec + orcm_sensor_ipmi_engine.session_idle < now->tv_sec) {
+        /* BMCs drop sessions left idle - start over rather than wait for it */
+        orcm_sensor_ipmi_engine_close(bmc);
+    }
+    if (!bmc->active) {
+        open_session(bmc);
+        return;
+    }
+    request(bmc, BMC_DEVICE_ID, NETFN_APP, CMD_GET_DEVICE_ID, NULL, 0);
+}
+
+orcm_sensor_ipmi_bmc_t* orcm_sensor_ipmi_engine_bmc(char *addr, int port, char *user, char *pasw)
+{
+    orcm_sensor_ipmi_bmc_t *bmc;
+
+    if (NULL == (bmc = OBJ_NEW(orcm_sensor_ipmi_bmc_t))) {
+        return NULL;
+    }
+    bmc->addr = strdup(addr);
+    bmc->port = port;
+    if (NULL != user) {
+        strncpy(bmc->user, user, sizeof(bmc->user));
+    }
+    if (NULL != pasw) {
+        strncpy(bmc->pasw, pasw, sizeof(bmc->pasw));
+    }
+    return bmc;
+}
+
+int orcm_sensor_ipmi_engine_poll(orcm_sensor_ipmi_bmc_t **bmcs, int nbmcs,
+                                 orcm_sensor_ipmi_want_fn_t want)
+{
+    struct pollfd *fds;
+    struct timeval now;
+    long wait, left;
+    int i, n, busy;
+
+    if (NULL == (fds = (struct pollfd*)malloc(nbmcs * sizeof(struct pollfd)))) {
+        return ORCM_ERR_OUT_OF_RESOURCE;
+    }
+    gettimeofday(&now, NULL);
+    for (i=0; i < nbmcs; i++) {
+        if (!bmcs[i]->unsupported) {
+            start_sample(bmcs[i], &now);
+        }
+    }
+
+    /* every BMC has a request in flight until it is done */
+    for (;;) {
+        gettimeofday(&now, NULL);
+        wait = -1;
+        for (i=0, busy=0; i < nbmcs; i++) {
+            if (bmcs[i]->unsupported || BMC_DONE == bmcs[i]->state) {
+                continue;
+            }
+            if (0 >= (left = msec_until(&bmcs[i]->deadline, &now))) {
+                timed_out(bmcs[i]);
+                if (BMC_DONE == bmcs[i]->state) {
+                    continue;
+                }
+                left = msec_until(&bmcs[i]->deadline, &now);
+            }
+            if (0 > wait || left < wait) {
+                wait = left;
+            }
+            busy++;
+        }
+        if (0 == busy) {
+            break;
+        }
+        for (i=0, n=0; i < nbmcs; i++) {
+            if (!bmcs[i]->unsupported && BMC_DONE != bmcs[i]->state) {
+                fds[n].fd = bmcs[i]->fd;
+                fds[n].events = POLLIN;
+                fds[n].revents = 0;
+                n++;
+            }
+        }
+        if (0 > poll(fds, n, (int)wait) && EINTR != errno) {
+            free(fds);
+            return ORCM_ERR_IN_ERRNO;
+        }
+        for (i=0, n=0; i < nbmcs; i++) {
+            if (!bmcs[i]->unsupported && BMC_DONE != bmcs[i]->state) {
+                if (fds[n++].revents & POLLIN) {
+                    receive(bmcs[i], want);
+                }
+            }
+        }
+    }
+    free(fds);
+    return ORCM_SUCCESS;
+}
+
+void orcm_sensor_ipmi_engine_close(orcm_sensor_ipmi_bmc_t *bmc)
+{
+    if (!bmc->active || 0 > bmc->fd) {
+        return;
+    }
+    bmc->netfn = NETFN_APP;
+    bmc->lun = 0;
+    bmc->cmd = CMD_CLOSE_SESSION;
+    put32(bmc->req, bmc->session_id);
+    bmc->reqlen = 4;
+    transmit(bmc);
+    bmc->active = false;
+}
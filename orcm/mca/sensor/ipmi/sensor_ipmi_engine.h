@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ *
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ * @file
+ *
+ * IPMI over LAN engine
+ *
+ * Samples any number of BMCs at once from a single thread: each BMC has
+ * its own UDP socket and a single request in flight, and the engine
+ * waits on all of them together, retransmitting a request that is not
+ * answered within the timeout. The IPMI v1.5 session opened with a BMC
+ * is kept from one sample to the next, and so are the full sensor
+ * records of its SDR repository, which is only walked again when the
+ * BMC reports it changed.
+ */
+#ifndef ORCM_SENSOR_IPMI_ENGINE_H
+#define ORCM_SENSOR_IPMI_ENGINE_H
+
+#include "orcm_config.h"
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#include "opal/class/opal_object.h"
+
+BEGIN_C_DECLS
+
+#define ORCM_SENSOR_IPMI_PORT       623
+/* as large as the SDR_SZ buffers of ipmiutil */
+#define ORCM_SENSOR_IPMI_SDR_SZ     80
+#define ORCM_SENSOR_IPMI_MSG_MAX    256
+
+/* tells whether the sensor of a tag is to be read */
+typedef bool (*orcm_sensor_ipmi_want_fn_t)(char *tag);
+
+/* a full sensor record of the repository, and its last reading */
+typedef struct {
+    unsigned char sdr[ORCM_SENSOR_IPMI_SDR_SZ];
+    char tag[17];
+    unsigned char reading[4];
+    bool valid;
+} orcm_sensor_ipmi_reading_t;
+
+typedef struct {
+    opal_object_t super;
+    char *addr;
+    int port;
+    char user[16];
+    char pasw[16];
+    int fd;
+    struct sockaddr_in sa;
+    /* where the BMC stands in the current sample */
+    int state;
+    int status;
+    /* the session */
+    bool active;
+    bool fresh;
+    bool unsupported;
+    unsigned char authtype;
+    uint32_t session_id;
+    uint32_t seq;
+    unsigned char rq_seq;
+    unsigned char challenge[16];
+    struct timeval last;
+    /* the request in flight */
+    unsigned char netfn;
+    unsigned char lun;
+    unsigned char cmd;
+    unsigned char req[32];
+    int reqlen;
+    int tries;
+    struct timeval deadline;
+    /* the results of the sample */
+    bool have_devid;
+    unsigned char devid[16];
+    bool have_power;
+    unsigned char power[2];
+    /* the SDR cache */
+    bool sdr_valid;
+    uint32_t sdr_added;
+    uint32_t sdr_erased;
+    uint16_t sdr_count;
+    orcm_sensor_ipmi_reading_t *sensors;
+    int nsensors;
+    int size;
+    /* walking the repository */
+    uint16_t reservation;
+    uint16_t record;
+    uint16_t next_record;
+    unsigned char rec[ORCM_SENSOR_IPMI_MSG_MAX];
+    int reclen;
+    int recoff;
+    int restarts;
+    int current;
+    /* counters */
+    uint64_t sessions;
+    uint64_t sdr_walks;
+    uint64_t requests;
+    uint64_t timeouts;
+} orcm_sensor_ipmi_bmc_t;
+OBJ_CLASS_DECLARATION(orcm_sensor_ipmi_bmc_t);
+
+typedef struct {
+    int timeout;         /* msec before a request is sent again */
+    int retries;         /* times a request is sent again */
+    int session_idle;    /* sec a session is trusted to stay open unused */
+} orcm_sensor_ipmi_engine_t;
+
+ORCM_DECLSPEC extern orcm_sensor_ipmi_engine_t orcm_sensor_ipmi_engine;
+
+/* a BMC, with the credentials of its session */
+ORCM_DECLSPEC orcm_sensor_ipmi_bmc_t* orcm_sensor_ipmi_engine_bmc(char *addr, int port,
+                                                                 char *user, char *pasw);
+
+/* sample all the BMCs at once: the device ID, the power states and the
+ * readings of the wanted sensors of each. The status of each BMC says
+ * how its sample went */
+ORCM_DECLSPEC int orcm_sensor_ipmi_engine_poll(orcm_sensor_ipmi_bmc_t **bmcs, int nbmcs,
+                                               orcm_sensor_ipmi_want_fn_t want);
+
+/* close the session of a BMC, not waiting for the answer */
+ORCM_DECLSPEC void orcm_sensor_ipmi_engine_close(orcm_sensor_ipmi_bmc_t *bmc);
+
+END_C_DECLS
+
+#endif
@@ -12,6 +12,8 @@
 #include "orcm/types.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif  /* HAVE_UNISTD_H */
@@ -65,6 +67,7 @@ static void mcedata_tlb_filter(unsigned long *mce_reg, opal_list_t *vals);
 static void mcedata_mem_ctrl_filter(unsigned long *mce_reg, opal_list_t *vals);
 static void mcedata_cache_filter(unsigned long *mce_reg, opal_list_t *vals);
 static void mcedata_bus_ic_filter(unsigned long *mce_reg, opal_list_t *vals);
+static void log_close(void);
 static uint64_t get_total_lines(char *filename);
 static char* get_line(char *filename, uint64_t line);
 static void perthread_mcedata_sample(int fd, short args, void *cbdata);
@@ -198,6 +201,7 @@ static int init(void)
 
 static void finalize(void)
 {
+    log_close();
     OPAL_LIST_DESTRUCT(&tracking);
     if(true == mce_default) {
         free(mca_sensor_mcedata_component.logfile);
@@ -293,53 +297,135 @@ mcetype get_mcetype(uint64_t mci_status)
 
 }
 
+/* The log file is kept open and read with pread. Lines are only counted
+ * in the bytes appended since the last sample, and get_line scans
+ * forward from the last line it found instead of reading the file from
+ * the top for every line. The file is reopened if it was rotated or
+ * truncated, which restarts the count. */
+#define MCE_LOG_CHUNK  4096
+
+static int log_fd = -1;
+static dev_t log_dev;
+static ino_t log_ino;
+static off_t log_counted = 0;   /* bytes whose lines were counted */
+static uint64_t log_lines = 0;  /* complete lines in them */
+static uint64_t cur_line = 0;   /* line starting at cur_off */
+static off_t cur_off = 0;
+static char log_chunk[MCE_LOG_CHUNK];
+
+static void log_close(void)
+{
+    if (0 <= log_fd) {
+        close(log_fd);
+        log_fd = -1;
+    }
+    log_counted = 0;
+    log_lines = 0;
+    cur_line = 0;
+    cur_off = 0;
+}
+
+static bool log_open(char *filename)
+{
+    struct stat st;
+
+    if (0 <= log_fd) {
+        if (0 == stat(filename, &st) && st.st_dev == log_dev &&
+            st.st_ino == log_ino && st.st_size >= log_counted) {
+            return true;
+        }
+        /* rotated or truncated */
+        log_close();
+    }
+    if (0 > (log_fd = open(filename, O_RDONLY))) {
+        return false;
+    }
+    if (0 != fstat(log_fd, &st)) {
+        log_close();
+        return false;
+    }
+    log_dev = st.st_dev;
+    log_ino = st.st_ino;
+    return true;
+}
+
 static uint64_t get_total_lines(char *filename)
 {
-    FILE *fptr;
-    size_t len = 0;
-    ssize_t linesize = 0;
-    uint64_t linecount=0;
-    char *buffer = NULL;
+    ssize_t n, i;
 
-    fptr = fopen (filename, "r");
-    if(fptr == NULL) {
+    if (!log_open(filename)) {
         opal_output_verbose(5, orcm_sensor_base_framework.framework_output,
                             "Unable to open file to get_tot_lines");
-    } else {
-            while ((linesize = getline(&buffer, &len, fptr)) != -1)
-                linecount++;
-            fclose(fptr);
+        return 0;
+    }
+    while (0 < (n = pread(log_fd, log_chunk, MCE_LOG_CHUNK, log_counted))) {
+        for (i = 0; i < n; i++) {
+            if ('\n' == log_chunk[i]) {
+                log_lines++;
+            }
+        }
+        log_counted += n;
     }
-    return linecount;
+    return log_lines;
 }
 
 static char* get_line(char *filename, uint64_t line)
 {
-    FILE *fptr;
+    char *buffer = NULL, *nl;
     size_t len = 0;
-    ssize_t linesize = 0;
-    uint64_t index;
-    char *buffer = NULL;
+    ssize_t n, i;
+    off_t off;
 
     /* opal_output(0, "%lu, %s\n",line, filename); */
 
-    fptr = fopen (filename, "r");
-    if(fptr == NULL) {
+    if (!log_open(filename)) {
         opal_output(0,"Unable to open file");
-    } else {
-        for (index = 0; index <= line; index++)
-        {
-            if ((linesize = getline(&buffer, &len, fptr)) == -1)
-            {
-                orte_show_help("help-orcm-sensor-mcedata.txt", "mcelog-no-open",
-                       true, orte_process_info.nodename);
-                fclose(fptr);
-                return buffer;
+        return NULL;
+    }
+
+    /* move to the start of the line */
+    if (line < cur_line) {
+        cur_line = 0;
+        cur_off = 0;
+    }
+    off = cur_off;
+    while (cur_line < line) {
+        if (0 >= (n = pread(log_fd, log_chunk, MCE_LOG_CHUNK, off))) {
+            goto notfound;
+        }
+        for (i = 0; i < n && cur_line < line; i++) {
+            if ('\n' == log_chunk[i]) {
+                cur_line++;
+                cur_off = off + i + 1;
             }
         }
-        fclose(fptr);
+        off += i;
     }
-    return buffer;
+
+    /* copy it out, newline included */
+    off = cur_off;
+    while (0 < (n = pread(log_fd, log_chunk, MCE_LOG_CHUNK, off))) {
+        nl = (char*)memchr(log_chunk, '\n', n);
+        i = (NULL != nl) ? (nl - log_chunk) + 1 : n;
+        if (NULL == (buffer = (char*)realloc(buffer, len + i + 1))) {
+            return NULL;
+        }
+        memcpy(buffer + len, log_chunk, i);
+        len += i;
+        buffer[len] = '\0';
+        off += i;
+        if (NULL != nl) {
+            break;
+        }
+    }
+    if (NULL != buffer) {
+        return buffer;
+    }
+
+notfound:
+    orte_show_help("help-orcm-sensor-mcedata.txt", "mcelog-no-open",
+                   true, orte_process_info.nodename);
+    return NULL;
 }
 
 static void mcedata_gen_cache_filter(unsigned long *mce_reg, opal_list_t *vals)
@@ -84,6 +84,16 @@ typedef void (*orcm_sensor_base_module_inventory_log_fn_t) (char *hostname, opal
 /* pass a buffer to the module for logging */
 typedef void (*orcm_sensor_base_module_log_fn_t)(opal_buffer_t *sample);
 
+/* pass a sample received in compact form to the module for logging - the
+ * values are an array of schema->nitems elements of type schema->type that
+ * belongs to the caller. If the sender only reports changed values, the
+ * values it didn't report carry their last reported value and are clear
+ * in the changed bitmap - otherwise changed is NULL */
+typedef void (*orcm_sensor_base_module_log_compact_fn_t)(orcm_sensor_schema_t *schema,
+                                                         struct timeval *sampletime,
+                                                         void *values,
+                                                         uint8_t *changed);
+
 /* set sample rate in the module */
 typedef void (*orcm_sensor_base_module_set_sample_rate_fn_t)(int sample_rate);
 /* get sample rate in the module */
@@ -103,6 +113,7 @@ struct orcm_sensor_base_module_1_0_0_t {
     orcm_sensor_base_module_inventory_log_fn_t      inventory_log;
     orcm_sensor_base_module_set_sample_rate_fn_t    set_sample_rate;
     orcm_sensor_base_module_get_sample_rate_fn_t    get_sample_rate;
+    orcm_sensor_base_module_log_compact_fn_t        log_compact;
 };
 
 typedef struct orcm_sensor_base_module_1_0_0_t orcm_sensor_base_module_1_0_0_t;
@@ -66,6 +66,36 @@ typedef struct {
 } orcm_sensor_sampler_t;
 ORCM_DECLSPEC OBJ_CLASS_DECLARATION(orcm_sensor_sampler_t);
 
+/* define the schema of a compact sample - the sender includes
+ * it with the first sample (and periodically thereafter) so
+ * that the other samples only need to carry the schema id
+ * and an array of nitems values of the given type */
+typedef struct {
+    opal_object_t super;
+    uint16_t id;
+    char *component;         // name of the sensor component the samples belong to
+    char *hostname;          // host the samples are collected on
+    opal_data_type_t type;   // type of the values
+    int32_t nitems;
+    char **labels;           // label of each value
+    char **units;            // units of each value
+    uint32_t nsent;          // samples sent since the schema was last included
+    /* change-only reporting */
+    double epsilon;          // min change for a value to be reported
+    uint32_t interval;       // report all values every interval samples - 0 if disabled
+    uint32_t nsince_full;    // samples since all values were last reported
+    void *last;              // values last reported (sender) or received (receiver)
+    bool have_last;
+    uint8_t *changed;        // bitmap of the values reported in a sample
+    void *scratch;
+    /* local history */
+    void *ring;              // ring of the samples kept on the node, if any
+    int32_t nsummary;        // number of samples summarized by the last one received - 0 if not a summary
+    void *min;               // min and max values of the samples summarized
+    void *max;
+} orcm_sensor_schema_t;
+ORCM_DECLSPEC OBJ_CLASS_DECLARATION(orcm_sensor_schema_t);
+
 END_C_DECLS
 
 #endif
@@ -19,6 +19,7 @@
 #include <string.h>
 #endif  /* HAVE_STRING_H */
 #include <stdio.h>
+#include <sys/time.h>
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
@@ -29,6 +30,7 @@
 #include "opal_stdint.h"
 #include "opal/class/opal_list.h"
 #include "opal/dss/dss.h"
+#include "opal/util/output.h"
 
 #include "orte/util/name_fns.h"
 #include "orte/util/show_help.h"
@@ -61,11 +63,75 @@ orcm_sensor_base_module_t orcm_sensor_test_module = {
 
 static opal_list_t tracking;
 
+/* histogram of the distance between the sample times and the
+ * schedule - bin 0 holds < 1 usec, bin i holds [2^(i-1), 2^i) usecs
+ * and the last bin everything beyond */
+#define TEST_JITTER_BINS 24
+static uint64_t jitter_hist[TEST_JITTER_BINS];
+static uint64_t jitter_max = 0;
+static uint64_t jitter_first = 0;
+static uint64_t jitter_samples = 0;
+
+static void record_jitter(void)
+{
+    struct timeval tv;
+    uint64_t now, rate, delta;
+    int bin;
+
+    gettimeofday(&tv, NULL);
+    now = (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+    rate = (uint64_t)mca_sensor_test_component.sample_usec;
+    if (0 == jitter_samples++) {
+        /* the base aligns the schedule on a multiple of the rate */
+        jitter_first = (now / rate) * rate;
+    }
+    /* distance to the closest scheduled time */
+    delta = (now - jitter_first) % rate;
+    if (delta > rate / 2) {
+        delta = rate - delta;
+    }
+    if (delta > jitter_max) {
+        jitter_max = delta;
+    }
+    for (bin=0; bin < TEST_JITTER_BINS - 1 && 0 < delta; bin++) {
+        delta >>= 1;
+    }
+    jitter_hist[bin]++;
+}
+
+static void report_jitter(void)
+{
+    int bin;
+
+    if (0 == jitter_samples) {
+        return;
+    }
+    opal_output(0, "%s sensor:test: %"PRIu64" samples at %d usecs - max jitter %"PRIu64" usecs",
+                ORTE_NAME_PRINT(ORTE_PROC_MY_NAME), jitter_samples,
+                mca_sensor_test_component.sample_usec, jitter_max);
+    for (bin=0; bin < TEST_JITTER_BINS; bin++) {
+        if (0 == jitter_hist[bin]) {
+            continue;
+        }
+        opal_output(0, "%s sensor:test:   %s %8lu usecs: %"PRIu64,
+                    ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
+                    (TEST_JITTER_BINS - 1 == bin) ? ">=" : " <",
+                    (TEST_JITTER_BINS - 1 == bin) ? 1UL << (bin - 1) : 1UL << bin,
+                    jitter_hist[bin]);
+    }
+}
+
 static int init(void)
 {
     /* always construct this so we don't segfault in finalize */
     OBJ_CONSTRUCT(&tracking, opal_list_t);
 
+    if (0 < mca_sensor_test_component.sample_usec) {
+        memset(jitter_hist, 0, sizeof(jitter_hist));
+        orcm_sensor_base_sched_set_rate("test",
+                                        (uint64_t)mca_sensor_test_component.sample_usec);
+    }
+
 
     /*
      * Normally this check is done at the end of init because an empty
@@ -85,6 +151,7 @@ static int init(void)
 
 static void finalize(void)
 {
+    report_jitter();
     OPAL_LIST_DESTRUCT(&tracking);
 }
 
@@ -109,6 +176,10 @@ static void test_sample(orcm_sensor_sampler_t *sampler)
     bool packed;
     struct tm *sample_time;
 
+    if (0 < mca_sensor_test_component.sample_usec) {
+        record_jitter();
+    }
+
     if (0 == opal_list_get_size(&tracking)) {
         return;
     }
@@ -24,6 +24,7 @@ BEGIN_C_DECLS
 typedef struct {
     orcm_sensor_base_component_t super;
     bool test;
+    int sample_usec;    /* sample at this rate and report the jitter */
 } orcm_sensor_test_component_t;
 
 ORCM_MODULE_DECLSPEC extern orcm_sensor_test_component_t mca_sensor_test_component;
@@ -55,6 +55,13 @@ static int orcm_sensor_test_open(void)
 
 static int orcm_sensor_test_query(mca_base_module_t **module, int *priority)
 {
+    /* only run when asked to measure the sampling jitter */
+    if (0 < mca_sensor_test_component.sample_usec) {
+        *priority = 50;
+        *module = (mca_base_module_t *)&orcm_sensor_test_module;
+        return ORCM_SUCCESS;
+    }
+
     *priority = 0;
     *module = NULL;
     return ORCM_ERROR;
@@ -86,5 +93,14 @@ static int test_component_register(void)
                                             OPAL_INFO_LVL_9,
                                             MCA_BASE_VAR_SCOPE_READONLY,
                                             & mca_sensor_test_component.test);
+
+    mca_sensor_test_component.sample_usec = 0;
+    (void) mca_base_component_var_register (c, "sample_usec",
+                                            "Sample at this rate in usecs and report a histogram "
+                                            "of the sampling jitter at finalize (0: disabled)",
+                                            MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                            OPAL_INFO_LVL_9,
+                                            MCA_BASE_VAR_SCOPE_READONLY,
+                                            & mca_sensor_test_component.sample_usec);
     return ORCM_SUCCESS;
 }
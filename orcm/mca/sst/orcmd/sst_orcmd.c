@@ -220,6 +220,15 @@ static int orcmd_init(void)
         return ORTE_ERR_SILENT;
     }
 
+    /* aggregators hand their part of the system to the daemons
+     * below them so those need not read the config themselves */
+    if (ORCM_PROC_IS_AGGREGATOR &&
+        ORCM_SUCCESS != (ret = orcm_cfgi_base_tree_serve())) {
+        OBJ_DESTRUCT(&buf);
+        error = "cfgi tree serve";
+        goto error;
+    }
+
     /* define a node and proc object for ourselves as some parts
      * of ORTE and ORCM require it */
     if (NULL == (node = OBJ_NEW(orte_node_t))) {
@@ -218,7 +218,7 @@ static int orcmsched_init(void)
                                         ORTE_NAME_PRINT(ORTE_PROC_MY_NAME),
                                         (NULL == node->name) ? "NULL" : node->name);
                     OBJ_RETAIN(node);  // maintain accounting
-                    opal_pointer_array_add(&orcm_scd_base.nodes, node);
+                    orcm_scd_base_add_node(node);
                 }
             }
         }
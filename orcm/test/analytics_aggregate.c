@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Aggregate the power of a number of nodes through racks of 100 to the
+ * top, each level an aggregate step of its own workflow - the nodes and
+ * racks forwarding their partials, here straight to the workflow of the
+ * level above instead of over the routing tree - checking what the top
+ * emits for each period against the samples, and comparing what reaches
+ * the top with sending it the samples:
+ *
+ *   analytics_aggregate [<number of nodes> [<number of periods>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "opal/dss/dss.h"
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/aggregate/analytics_aggregate.h"
+
+#define RACK      100
+#define PERIOD    60
+#define SAMPLES   6      /* per node and period */
+#define LAG       6      /* periods before the top emits one */
+
+enum { TOTAL, SUM, MIN, MAX, COUNT, MEAN, NODES, NSTATS };
+static char *stats[] = { "total", "sum", "min", "max", "count", "mean", "nodes" };
+
+typedef struct {
+    double expected[NSTATS];
+    double got[NSTATS];
+    int emitted;
+} period_t;
+
+static opal_event_base_t *ev_base;
+static orcm_workflow_t **parents;   /* by workflow id, NULL for the top */
+static int nnodes_all;
+static long rack_bytes = 0, top_bytes = 0;
+static period_t *periods;
+static int nperiods_all;
+
+/* the level above is a workflow of this process */
+static int forward(orcm_workflow_t *wf, const char *name, opal_buffer_t *partials)
+{
+    orcm_workflow_t *parent = parents[wf->workflow_id];
+    int rc;
+
+    if (wf->workflow_id < nnodes_all) {
+        rack_bytes += partials->bytes_used;
+    } else {
+        top_bytes += partials->bytes_used;
+    }
+    rc = orcm_analytics_base_aggregate_deliver(parent, name, partials);
+    OBJ_RELEASE(partials);
+    return rc;
+}
+
+/* the step after the top one */
+static int collect(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    size_t i;
+    long p;
+    int k;
+
+    for (i=0; i < opal_value_array_get_size(caddy->data); i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, i);
+        p = value->start_time.tv_sec / PERIOD;
+        if (0 > p || nperiods_all <= p || 0 != strcmp(value->node_regex, "cluster")) {
+            continue;
+        }
+        for (k=0; k < NSTATS; k++) {
+            if (0 == strcmp(value->data.value.key + strlen("power "), stats[k])) {
+                periods[p].got[k] = value->data.value.data.dval;
+                periods[p].emitted |= 1 << k;
+            }
+        }
+    }
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t collector = { NULL, NULL, collect, NULL };
+
+static void add_attr(orcm_workflow_step_t *step, char *key, char *value)
+{
+    opal_value_t *attr = OBJ_NEW(opal_value_t);
+
+    attr->key = strdup(key);
+    attr->type = OPAL_STRING;
+    attr->data.string = strdup(value);
+    opal_list_append(&step->attributes, &attr->super);
+}
+
+static orcm_workflow_t* add_workflow(int id, char *forward, char *group, bool collecting)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->workflow_id = id;
+    wf->ev_base = ev_base;
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("aggregate");
+    step->mod = mca_analytics_aggregate_component.create_handle();
+    add_attr(step, "name", "power");
+    add_attr(step, "forward", forward);
+    add_attr(step, "period", "60s");
+    add_attr(step, "compute", "total;sum;min;max;count;mean;nodes");
+    if (NULL != group) {
+        add_attr(step, "group", group);
+    }
+    opal_list_append(&wf->steps, &step->super);
+    if (collecting) {
+        step = OBJ_NEW(orcm_workflow_step_t);
+        step->analytic = strdup("collect");
+        step->mod = &collector;
+        opal_list_append(&wf->steps, &step->super);
+    }
+    orcm_analytics_base_aggregate_register(wf);
+    return wf;
+}
+
+static void remove_workflow(orcm_workflow_t *wf)
+{
+    orcm_workflow_step_t *step;
+
+    orcm_analytics_base_aggregate_unregister(wf);
+    OPAL_LIST_FOREACH(step, &wf->steps, orcm_workflow_step_t) {
+        if (&collector != step->mod) {
+            step->mod->finalize(step->mod);
+        }
+    }
+    wf->ev_base = NULL;
+    OBJ_RELEASE(wf);
+}
+
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+    opal_event_loop(ev_base, OPAL_EVLOOP_NONBLOCK);
+}
+
+/* what the samples of a node would cost at the top */
+static long raw_bytes(char *node, double x, double t)
+{
+    opal_buffer_t buf;
+    char *sensor = "power", *label = "power";
+    long n;
+
+    OBJ_CONSTRUCT(&buf, opal_buffer_t);
+    opal_dss.pack(&buf, &node, 1, OPAL_STRING);
+    opal_dss.pack(&buf, &sensor, 1, OPAL_STRING);
+    opal_dss.pack(&buf, &label, 1, OPAL_STRING);
+    opal_dss.pack(&buf, &x, 1, OPAL_DOUBLE);
+    opal_dss.pack(&buf, &t, 1, OPAL_DOUBLE);
+    n = buf.bytes_used;
+    OBJ_DESTRUCT(&buf);
+    return n;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_workflow_t **wfs, *top;
+    orcm_metric_value_t *metric;
+    opal_value_array_t *data;
+    orcm_analytics_value_t *value;
+    period_t *per;
+    char node[32];
+    double x, nodesum, t;
+    long sample_bytes = 0;
+    int nnodes = 2000, nperiods = 4, nracks, i, p, s, k, missing = 0, bad = 0;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nperiods = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_aggregates_init();
+    orcm_analytics_base_aggregates.forward = forward;
+    ev_base = opal_event_base_create();
+
+    /* nodes, racks and the top */
+    nnodes_all = nnodes;
+    nracks = (nnodes + RACK - 1) / RACK;
+    nperiods_all = nperiods + LAG;
+    wfs = (orcm_workflow_t**)calloc(nnodes + nracks, sizeof(orcm_workflow_t*));
+    parents = (orcm_workflow_t**)calloc(nnodes + nracks + 1, sizeof(orcm_workflow_t*));
+    periods = (period_t*)calloc(nperiods_all, sizeof(period_t));
+    top = add_workflow(nnodes + nracks, "no", "cluster", true);
+    for (i=0; i < nracks; i++) {
+        snprintf(node, sizeof(node), "rack%03d", i);
+        wfs[nnodes + i] = add_workflow(nnodes + i, "yes", node, false);
+        parents[nnodes + i] = top;
+    }
+    for (i=0; i < nnodes; i++) {
+        snprintf(node, sizeof(node), "node%05d", i);
+        wfs[i] = add_workflow(i, "yes", node, false);
+        parents[i] = wfs[nnodes + i / RACK];
+    }
+
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->units = strdup("W");
+    metric->value.key = strdup("power");
+    metric->value.type = OPAL_DOUBLE;
+    for (p=0; p < nperiods_all; p++) {
+        per = &periods[p];
+        per->expected[MIN] = 1e300;
+        per->expected[MAX] = -1e300;
+        for (s=0; s < SAMPLES; s++) {
+            t = (double)p * PERIOD + (s + 0.5) * PERIOD / SAMPLES;
+            for (i=0; i < nnodes; i++) {
+                snprintf(node, sizeof(node), "node%05d", i);
+                x = 150.0 + (i * 7 + s * 13 + p * 29) % 200;
+                metric->value.data.dval = x;
+                orcm_analytics.array_create(&data, 1);
+                orcm_analytics.array_append(data, 0, "power", node, metric);
+                value = (orcm_analytics_value_t*)opal_value_array_get_item(data, 0);
+                value->end_time.tv_sec = (time_t)t;
+                value->end_time.tv_usec = 0;
+                run_step(wfs[i], data);
+
+                per->expected[SUM] += x;
+                per->expected[COUNT] += 1.0;
+                if (x < per->expected[MIN]) {
+                    per->expected[MIN] = x;
+                }
+                if (x > per->expected[MAX]) {
+                    per->expected[MAX] = x;
+                }
+                sample_bytes += raw_bytes(node, x, t);
+            }
+        }
+        for (i=0; i < nnodes; i++) {
+            nodesum = 0.0;
+            for (s=0; s < SAMPLES; s++) {
+                nodesum += 150.0 + (i * 7 + s * 13 + p * 29) % 200;
+            }
+            per->expected[TOTAL] += nodesum / SAMPLES;
+        }
+        per->expected[MEAN] = per->expected[SUM] / per->expected[COUNT];
+        per->expected[NODES] = nnodes;
+    }
+
+    for (p=0; p < nperiods; p++) {
+        per = &periods[p];
+        if ((1 << NSTATS) - 1 != per->emitted) {
+            missing++;
+            continue;
+        }
+        for (k=0; k < NSTATS; k++) {
+            if (fabs(per->got[k] - per->expected[k]) > 1e-9 * fabs(per->expected[k])) {
+                fprintf(stderr, "period %d %s: %f instead of %f\n", p, stats[k],
+                        per->got[k], per->expected[k]);
+                bad++;
+            }
+        }
+    }
+    fprintf(stderr, "%d nodes in %d racks over %d periods: total %.1f W, mean %.2f W, "
+            "%d periods missing, %d statistics wrong\n", nnodes, nracks, nperiods,
+            periods[0].got[TOTAL], periods[0].got[MEAN], missing, bad);
+    fprintf(stderr, "%ld bytes to the racks, %ld to the top, instead of %ld of samples "
+            "(%.0fx less)\n", rack_bytes, top_bytes, sample_bytes,
+            (double)sample_bytes / (0 < top_bytes ? top_bytes : 1));
+
+    OBJ_RELEASE(metric);
+    for (i=0; i < nnodes + nracks; i++) {
+        remove_workflow(wfs[i]);
+    }
+    remove_workflow(top);
+    free(wfs);
+    free(parents);
+    free(periods);
+    opal_event_base_free(ev_base);
+    orcm_analytics_base_aggregates_finalize();
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return (0 == missing && 0 == bad) ? 0 : 1;
+}
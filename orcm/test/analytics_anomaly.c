@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Check the anomaly step:
+ *
+ *   analytics_anomaly [<number of nodes> [<number of rounds>]]
+ *
+ * - every node sends 90 core temperatures and 10 fan speeds each round;
+ *   after a while a fan of some nodes slows down and a core of others
+ *   creeps up. Every one of them must be raised, and no other series,
+ *   the state of all the series staying a few bytes each
+ * - series following the time of day, without and with a seasonal
+ *   baseline, and spikes on some of them on the last day
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/anomaly/analytics_anomaly.h"
+
+#define NCORES    90
+#define NFANS     10
+#define NSERIES   (NCORES + NFANS)
+#define FAULTY    100    /* one node in FAULTY goes wrong */
+#define DAY       86400
+#define PER_DAY   288
+#define NDAYS     14
+#define NSEASONAL 100
+
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void add_attr(orcm_workflow_step_t *step, char *key, char *value)
+{
+    opal_value_t *attr = OBJ_NEW(opal_value_t);
+
+    attr->key = strdup(key);
+    attr->type = OPAL_STRING;
+    attr->data.string = strdup(value);
+    opal_list_append(&step->attributes, &attr->super);
+}
+
+static orcm_workflow_t* create_workflow(char *season)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("anomaly");
+    step->mod = mca_analytics_anomaly_component.create_handle();
+    add_attr(step, "count", "2");
+    if (NULL != season) {
+        add_attr(step, "season", season);
+        add_attr(step, "bins", "48");
+    }
+    opal_list_append(&wf->steps, &step->super);
+    return wf;
+}
+
+static mca_analytics_anomaly_module_t* module_of(orcm_workflow_t *wf)
+{
+    return (mca_analytics_anomaly_module_t*)
+           ((orcm_workflow_step_t*)opal_list_get_first(&wf->steps))->mod;
+}
+
+/* the anomaly step is the last of the workflow */
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    OBJ_RETAIN(data);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+}
+
+static void release_workflow(orcm_workflow_t *wf)
+{
+    orcm_workflow_step_t *step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+
+    step->mod->finalize(step->mod);
+    OBJ_RELEASE(wf);
+}
+
+static void set_sample(opal_value_array_t *data, int j, double x, time_t t)
+{
+    orcm_analytics_value_t *value;
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(data, j);
+    value->data.value.data.fval = (float)x;
+    value->end_time.tv_sec = t;
+    value->end_time.tv_usec = 0;
+}
+
+static int level_of(mca_analytics_anomaly_module_t *mod, opal_value_array_t *data, int j)
+{
+    orcm_analytics_value_t *value;
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(data, j);
+    return mod->states[value->key_id].level;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_workflow_t *wf;
+    mca_analytics_anomaly_module_t *mod;
+    orcm_metric_value_t *metric;
+    opal_value_array_t **arrays;
+    struct timeval start;
+    char node[32];
+    double x, secs;
+    size_t bytes;
+    long nsamples = 0;
+    int nnodes = 1000, nrounds = 200, onset, i, j, r, faulty = 0, missed = 0, false_raised = 0;
+    int *levels, *raises, level, faulty_raises = 0;
+    int d, s, raised[2], spikes_missed[2] = {0, 0}, bad = 0;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    srand(1);
+
+    /* a batch per node, its keys interned once */
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->value.type = OPAL_FLOAT;
+    arrays = (opal_value_array_t**)malloc(nnodes * sizeof(opal_value_array_t*));
+    for (i=0; i < nnodes; i++) {
+        snprintf(node, sizeof(node), "node%05d", i);
+        orcm_analytics.array_create(&arrays[i], NSERIES);
+        for (j=0; j < NSERIES; j++) {
+            free(metric->value.key);
+            free(metric->units);
+            if (j < NCORES) {
+                asprintf(&metric->value.key, "core %d", j);
+                metric->units = strdup("degrees C");
+                orcm_analytics.array_append(arrays[i], j, "coretemp", node, metric);
+            } else {
+                asprintf(&metric->value.key, "fan %d", j - NCORES);
+                metric->units = strdup("RPM");
+                orcm_analytics.array_append(arrays[i], j, "fanspeed", node, metric);
+            }
+        }
+    }
+
+    /* fans of some nodes slow down, cores of others creep up */
+    levels = (int*)calloc(nnodes, sizeof(int));
+    raises = (int*)calloc(nnodes, sizeof(int));
+    wf = create_workflow(NULL);
+    mod = module_of(wf);
+    onset = nrounds * 2 / 3;
+    gettimeofday(&start, NULL);
+    for (r=0; r < nrounds; r++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NSERIES; j++) {
+                if (j < NCORES) {
+                    x = 45.0 + (i + j) % 20 + gauss();
+                    if (r >= onset && 1 == i % FAULTY && 0 == j) {
+                        x += 0.5 * (r - onset);
+                    }
+                } else {
+                    x = 5000.0 + 50.0 * gauss();
+                    if (r >= onset && 2 == i % FAULTY && NCORES == j) {
+                        x -= 100.0 * (r - onset);
+                    }
+                }
+                set_sample(arrays[i], j, x, 1000000 + 10 * r);
+            }
+            run_step(wf, arrays[i]);
+            /* the faulty series are raised, once */
+            if (1 == i % FAULTY || 2 == i % FAULTY) {
+                j = (1 == i % FAULTY) ? 0 : NCORES;
+                level = level_of(mod, arrays[i], j);
+                if (ORCM_ANALYTICS_ANOMALY_NORMAL == levels[i] &&
+                    ORCM_ANALYTICS_ANOMALY_NORMAL != level) {
+                    raises[i]++;
+                }
+                levels[i] = level;
+            }
+        }
+        nsamples += (long)nnodes * NSERIES;
+    }
+    secs = elapsed(&start);
+    for (i=0; i < nnodes; i++) {
+        if (1 == i % FAULTY || 2 == i % FAULTY) {
+            faulty++;
+            missed += (0 == raises[i]);
+            faulty_raises += raises[i];
+        }
+    }
+    false_raised = (int)mod->raised - faulty_raises;
+    bytes = mod->nstates * sizeof(orcm_analytics_anomaly_state_t);
+    fprintf(stderr, "%lu series, %ld samples in %.2f sec (%.0f samples/sec): %d of %d "
+            "faulty missed, %d others raised, %lu raised and %lu cleared, "
+            "%lu bytes of state (%.1f per series)\n",
+            (unsigned long)mod->nseries, nsamples, secs, nsamples / secs, missed, faulty,
+            false_raised, (unsigned long)mod->raised, (unsigned long)mod->cleared,
+            (unsigned long)bytes, (double)bytes / mod->nseries);
+    /* two outliers in a row are rare, not impossible */
+    bad += missed + (false_raised > nsamples / 1000000);
+    release_workflow(wf);
+    for (i=0; i < nnodes; i++) {
+        OBJ_RELEASE(arrays[i]);
+    }
+
+    /* the time of day, without and with a seasonal baseline - some
+     * series spike on the last day */
+    for (s=0; s < 2; s++) {
+        wf = create_workflow((0 == s) ? NULL : "24h");
+        mod = module_of(wf);
+        for (i=0; i < NSEASONAL; i++) {
+            snprintf(node, sizeof(node), "node%05d", i);
+            orcm_analytics.array_create(&arrays[i], 1);
+            free(metric->value.key);
+            metric->value.key = strdup("inlet");
+            orcm_analytics.array_append(arrays[i], 0, "temp", node, metric);
+        }
+        for (d=0; d < NDAYS; d++) {
+            for (r=0; r < PER_DAY; r++) {
+                for (i=0; i < NSEASONAL; i++) {
+                    x = 25.0 + 10.0 * sin(2.0 * M_PI * r / PER_DAY) + 0.5 * gauss();
+                    if (NDAYS - 1 == d && 0 == i % 10 && PER_DAY / 2 <= r &&
+                        PER_DAY / 2 + 6 > r) {
+                        x += 6.0;
+                    }
+                    set_sample(arrays[i], 0, x, (time_t)d * DAY + r * (DAY / PER_DAY));
+                    run_step(wf, arrays[i]);
+                    if (NDAYS - 1 == d && 0 == i % 10 && PER_DAY / 2 + 5 == r &&
+                        ORCM_ANALYTICS_ANOMALY_NORMAL == level_of(mod, arrays[i], 0)) {
+                        spikes_missed[s]++;
+                    }
+                }
+            }
+        }
+        raised[s] = (int)mod->raised;
+        release_workflow(wf);
+        for (i=0; i < NSEASONAL; i++) {
+            OBJ_RELEASE(arrays[i]);
+        }
+    }
+    fprintf(stderr, "%d series over %d days, %d spiking on the last: without a season "
+            "%d raised, %d spikes missed; with one %d raised, %d spikes missed\n",
+            NSEASONAL, NDAYS, NSEASONAL / 10, raised[0], spikes_missed[0],
+            raised[1], spikes_missed[1]);
+    bad += spikes_missed[1] + (raised[1] > NSEASONAL / 10);
+
+    free(arrays);
+    free(levels);
+    free(raises);
+    OBJ_RELEASE(metric);
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return (0 == bad) ? 0 : 1;
+}
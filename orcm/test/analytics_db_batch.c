@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Store the results of a workflow step the way a step does after each
+ * invocation - storing every invocation, then buffering them over a
+ * db_flush interval - and check the records stored, how many requests
+ * carry them, that the metrics of a flush are those of the last, and
+ * that the timer flushes a step gone quiet. The requests are passed to
+ * the db base the way its workers do, with a stub module refusing to
+ * store batches as postgres does without COPY, so that each record has
+ * to be stored on its own:
+ *
+ *   analytics_db_batch [<number of nodes> [<number of rounds>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/db/base/base.h"
+
+#define NCORES 16
+
+static int nrequests = 0, nrefused = 0, nrecords = 0, nvalues = 0, bad = 0;
+
+static float sample(int node, int core, int round)
+{
+    return (float)(40 + (node + 3 * core + 7 * round) % 30);
+}
+
+/* check a record is that of a node and round */
+static int module_store_new(struct orcm_db_base_module_t *imod,
+                            orcm_db_data_type_t data_type,
+                            opal_list_t *input, opal_list_t *ret)
+{
+    opal_value_t *kv;
+    orcm_metric_value_t *mv;
+    int node = -1, core = 0, round = -1;
+
+    nrecords++;
+    OPAL_LIST_FOREACH(kv, input, opal_value_t) {
+        if (0 == strcmp(kv->key, "hostname")) {
+            node = strtol(kv->data.string + strlen("node"), NULL, 10);
+        } else if (0 == strcmp(kv->key, "data_group")) {
+            bad += (0 != strcmp(kv->data.string, "coretemp_test_workflow 7"));
+        } else if (0 == strncmp(kv->key, "core ", 5)) {
+            mv = (orcm_metric_value_t*)kv;
+            bad += (OPAL_FLOAT != kv->type || 0 != strcmp(mv->units, "C") ||
+                    core != strtol(kv->key + 5, NULL, 10));
+            if (0 == core) {
+                for (round = 0; round < 100 && sample(node, 0, round) !=
+                     kv->data.fval; round++);
+            }
+            bad += (sample(node, core, round) != kv->data.fval);
+            nvalues++;
+            core++;
+        }
+    }
+    bad += (NCORES != core);
+    return ORCM_SUCCESS;
+}
+
+/* what postgres answers without COPY */
+static int module_store_batch(struct orcm_db_base_module_t *imod,
+                              orcm_db_data_type_t data_type,
+                              opal_list_t **inputs, size_t num_inputs)
+{
+    nrefused++;
+    return ORCM_ERR_NOT_SUPPORTED;
+}
+
+static orcm_db_base_module_t module = {
+    NULL,
+    NULL,
+    NULL,
+    module_store_new,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    module_store_batch
+};
+
+/* hand the batch to the module as a db worker does, and give it back */
+static void store_batch(int dbhandle, orcm_db_data_type_t data_type,
+                        opal_list_t **inputs, size_t num_inputs,
+                        orcm_db_callback_fn_t cbfunc, void *cbdata)
+{
+    int rc;
+
+    nrequests++;
+    rc = orcm_db_base_batch_store(&module, data_type, inputs, num_inputs, NULL);
+    bad += (ORCM_SUCCESS != rc);
+    cbfunc(dbhandle, rc, NULL, NULL, cbdata);
+}
+
+static void add_attr(orcm_workflow_step_t *step, char *key, char *value)
+{
+    opal_value_t *attr = OBJ_NEW(opal_value_t);
+
+    attr->key = strdup(key);
+    attr->type = OPAL_STRING;
+    attr->data.string = strdup(value);
+    opal_list_append(&step->attributes, &attr->super);
+}
+
+static int run(char *db_flush, int nnodes, int nrounds, int sleep_usec,
+               opal_value_array_t **arrays)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    orcm_analytics_value_t *value;
+    orcm_analytics_base_db_buffer_t *buffer;
+    uint64_t allocated = 0;
+    int i, j, r, requests;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->workflow_id = 7;
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("test");
+    add_attr(step, "db", "yes");
+    if (NULL != db_flush) {
+        add_attr(step, "db_flush", db_flush);
+    }
+    opal_list_append(&wf->steps, &step->super);
+
+    nrequests = nrefused = nrecords = nvalues = 0;
+    for (r=0; r < nrounds; r++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                value = (orcm_analytics_value_t*)opal_value_array_get_item(arrays[i], j);
+                value->data.value.data.fval = sample(i, j, r);
+            }
+            orcm_analytics_base_store(wf, step, arrays[i]);
+        }
+        /* the metrics come from the first flush only */
+        buffer = step->db_buffer;
+        if (0 < r && 1 < nrequests && allocated != buffer->allocated) {
+            fprintf(stderr, "round %d allocated %lu metrics\n", r,
+                    (unsigned long)(buffer->allocated - allocated));
+            bad++;
+        }
+        allocated = buffer->allocated;
+        usleep(sleep_usec);
+    }
+    orcm_analytics_base_db_stop(wf, step);
+    requests = nrequests;
+    fprintf(stderr, "db_flush %s: %d records of %d values stored from %d requests, "
+            "%lu metrics allocated\n", (NULL == db_flush) ? "unset" : db_flush,
+            nrecords, nvalues, nrequests, (unsigned long)step->db_buffer->allocated);
+    bad += (nnodes * nrounds != nrecords || nnodes * nrounds * NCORES != nvalues ||
+            nrequests != nrefused);
+    OBJ_RELEASE(wf);
+    return requests;
+}
+
+/* a round stored, then nothing - the timer must send it */
+static int quiet(int nnodes, opal_value_array_t **arrays)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    int i, n = 0;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->workflow_id = 7;
+    wf->ev_base = opal_event_base_create();
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("test");
+    add_attr(step, "db", "yes");
+    add_attr(step, "db_flush", "10ms");
+    opal_list_append(&wf->steps, &step->super);
+
+    nrequests = nrefused = nrecords = nvalues = 0;
+    for (i=0; i < nnodes; i++) {
+        orcm_analytics_base_store(wf, step, arrays[i]);
+    }
+    n += (0 != nrecords);
+    usleep(20000);
+    opal_event_loop(wf->ev_base, OPAL_EVLOOP_NONBLOCK);
+    fprintf(stderr, "quiet step: %d records in %d requests after the interval\n",
+            nrecords, nrequests);
+    n += (nnodes != nrecords || 1 != nrequests);
+    orcm_analytics_base_db_stop(wf, step);
+    OBJ_RELEASE(wf);
+    return n;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_metric_value_t *metric;
+    opal_value_array_t **arrays;
+    char node[32];
+    int nnodes = 100, nrounds = 20, i, j, each, batched;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_db.db_handle = 0;
+    orcm_analytics_base_db.db_handle_acquired = true;
+    orcm_db.store_batch = store_batch;
+
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->value.type = OPAL_FLOAT;
+    metric->units = strdup("C");
+    arrays = (opal_value_array_t**)malloc(nnodes * sizeof(opal_value_array_t*));
+    for (i=0; i < nnodes; i++) {
+        snprintf(node, sizeof(node), "node%05d", i);
+        orcm_analytics.array_create(&arrays[i], NCORES);
+        for (j=0; j < NCORES; j++) {
+            free(metric->value.key);
+            asprintf(&metric->value.key, "core %d", j);
+            orcm_analytics.array_append(arrays[i], j, "coretemp", node, metric);
+        }
+    }
+
+    /* a request per invocation, then one per round or so */
+    each = run(NULL, nnodes, nrounds, 0, arrays);
+    batched = run("10ms", nnodes, nrounds, 10000, arrays);
+    bad += (nnodes * nrounds != each || nrounds + 1 < batched || nrounds / 2 > batched);
+    /* all of them at the end */
+    bad += (1 != run("1h", nnodes, nrounds, 0, arrays));
+    bad += quiet(nnodes, arrays);
+
+    for (i=0; i < nnodes; i++) {
+        OBJ_RELEASE(arrays[i]);
+    }
+    free(arrays);
+    OBJ_RELEASE(metric);
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
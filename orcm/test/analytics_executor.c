@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Send sample arrays to a number of workflows the way the sensor
+ * ingest does (array_send), first with a progress thread per workflow
+ * as the analytics base used to create them, then on the shared
+ * executor, checking every workflow gets every array in order:
+ *
+ *   analytics_executor [<number of workflows> [<number of arrays> [<workers>]]]
+ *
+ * Each workflow averages the 64 values of each array, then a last step
+ * checks the sequence number the array carries and when it was sent.
+ * Arrays are sent in bursts of BURST, each once the previous one went
+ * through every workflow.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/time.h>
+
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+#include "opal/runtime/opal_progress_threads.h"
+#include "opal/sys/atomic.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/average/analytics_average.h"
+
+#define NCORES 64
+#define BURST  8
+
+typedef struct {
+    int next;
+    int bad;
+} check_t;
+
+static check_t *checks;
+static volatile int32_t done = 0;
+static volatile int64_t latency_usec = 0;
+
+static uint64_t now_usec(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* the last step: arrays must come in the order they were sent */
+static int check(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    check_t *c = &checks[caddy->wf->workflow_id];
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, 0);
+    if (NULL == value || value->end_time.tv_sec != c->next) {
+        c->bad++;
+    }
+    c->next++;
+    opal_atomic_add_64(&latency_usec, (int64_t)(now_usec() - value->start_time.tv_sec));
+    opal_atomic_add_32(&done, 1);
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t checker = { NULL, NULL, check, NULL };
+
+static void add_workflows(int nwfs, bool threads)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    char name[32];
+    int i;
+
+    OBJ_CONSTRUCT(&orcm_analytics_base_wf.workflows, opal_list_t);
+    for (i=0; i < nwfs; i++) {
+        wf = OBJ_NEW(orcm_workflow_t);
+        wf->workflow_id = i;
+        if (threads) {
+            snprintf(name, sizeof(name), "wfid%i", i);
+            wf->ev_base = opal_progress_thread_init(name);
+        } else {
+            orcm_analytics_base_executor_add_workflow(wf);
+        }
+
+        step = OBJ_NEW(orcm_workflow_step_t);
+        step->analytic = strdup("average");
+        step->mod = mca_analytics_average_component.create_handle();
+        opal_list_append(&wf->steps, &step->super);
+
+        step = OBJ_NEW(orcm_workflow_step_t);
+        step->analytic = strdup("check");
+        step->mod = &checker;
+        opal_list_append(&wf->steps, &step->super);
+        opal_list_append(&orcm_analytics_base_wf.workflows, &wf->super);
+        orcm_analytics_base_subscribe(wf);
+    }
+    memset(checks, 0, nwfs * sizeof(check_t));
+    done = 0;
+    latency_usec = 0;
+}
+
+static void remove_workflows(bool threads)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    opal_list_item_t *item;
+    char name[32];
+
+    while (NULL != (item = opal_list_remove_first(&orcm_analytics_base_wf.workflows))) {
+        wf = (orcm_workflow_t*)item;
+        orcm_analytics_base_unsubscribe(wf);
+        orcm_analytics_base_executor_stop_workflow(wf);
+        if (threads) {
+            snprintf(name, sizeof(name), "wfid%i", wf->workflow_id);
+            opal_progress_thread_finalize(name);
+            /* the progress thread freed it */
+            wf->ev_base = NULL;
+        }
+        step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+        step->mod->finalize(step->mod);
+        OBJ_RELEASE(wf);
+    }
+    OBJ_DESTRUCT(&orcm_analytics_base_wf.workflows);
+}
+
+static double run(char *what, int nwfs, int narrays, opal_value_array_t **arrays)
+{
+    orcm_analytics_value_t *value;
+    struct timeval start;
+    double secs;
+    int i, j, bad = 0;
+
+    gettimeofday(&start, NULL);
+    for (i=0; i < narrays; i++) {
+        for (j=0; j < NCORES; j++) {
+            value = (orcm_analytics_value_t*)opal_value_array_get_item(arrays[i], j);
+            value->end_time.tv_sec = i;
+            value->start_time.tv_sec = (time_t)now_usec();
+        }
+        orcm_analytics.array_send(arrays[i]);
+        /* samples arrive in bursts */
+        if (BURST - 1 == i % BURST) {
+            while (done < nwfs * (i + 1)) {
+                sched_yield();
+            }
+        }
+    }
+    while (done < nwfs * narrays) {
+        usleep(100);
+    }
+    secs = (now_usec() - ((uint64_t)start.tv_sec * 1000000 + start.tv_usec)) / 1000000.0;
+    for (i=0; i < nwfs; i++) {
+        bad += checks[i].bad + (narrays != checks[i].next);
+    }
+    fprintf(stderr, "%s %d arrays to %d workflows in %.2f sec, %.0f steps/sec, "
+            "%.0f usec from send to last step, %d out of order\n",
+            what, narrays, nwfs, secs, 2.0 * nwfs * narrays / secs,
+            (double)latency_usec / done, bad);
+    return secs;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_value_array_t **arrays;
+    orcm_metric_value_t *metric;
+    orcm_analytics_base_worker_t *w;
+    double t1, t2;
+    int nwfs = 32, narrays = 2000, i, j;
+
+    if (1 < argc) {
+        nwfs = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        narrays = strtol(argv[2], NULL, 10);
+    }
+    if (3 < argc) {
+        orcm_analytics_base_executor.num_workers = strtol(argv[3], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_subscriptions_init();
+    checks = (check_t*)malloc(nwfs * sizeof(check_t));
+
+    /* the arrays are shared by the workflows, and must outlive them */
+    arrays = (opal_value_array_t**)malloc(narrays * sizeof(opal_value_array_t*));
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->units = strdup("degrees C");
+    metric->value.type = OPAL_FLOAT;
+    for (i=0; i < narrays; i++) {
+        orcm_analytics.array_create(&arrays[i], NCORES);
+        for (j=0; j < NCORES; j++) {
+            free(metric->value.key);
+            asprintf(&metric->value.key, "core %d", j);
+            metric->value.data.fval = (float)(40 + (i + j) % 30);
+            orcm_analytics.array_append(arrays[i], j, "coretemp", "node00000", metric);
+        }
+        OBJ_RETAIN(arrays[i]);
+    }
+    OBJ_RELEASE(metric);
+
+    add_workflows(nwfs, true);
+    t1 = run("progress threads:", nwfs, narrays, arrays);
+    remove_workflows(true);
+
+    orcm_analytics_base_executor_start();
+    add_workflows(nwfs, false);
+    t2 = run("executor:        ", nwfs, narrays, arrays);
+    fprintf(stderr, "%d workers instead of %d threads, %.1fx the throughput\n",
+            orcm_analytics_base_executor.nworkers, nwfs, t1 / t2);
+    for (i=0; i < orcm_analytics_base_executor.nworkers; i++) {
+        w = &orcm_analytics_base_executor.workers[i];
+        fprintf(stderr, "  worker %d: %lu steps, %lu stolen, %.1f usec average wait, "
+                "%lu usec max\n", i, (unsigned long)w->tasks, (unsigned long)w->steals,
+                (0 < w->tasks) ? (double)w->wait_usec / w->tasks : 0.0,
+                (unsigned long)w->max_wait_usec);
+    }
+    remove_workflows(false);
+    orcm_analytics_base_executor_stop();
+
+    for (i=0; i < narrays; i++) {
+        OBJ_RELEASE(arrays[i]);
+    }
+    free(arrays);
+    free(checks);
+    orcm_analytics_base_subscriptions_finalize();
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return 0;
+}
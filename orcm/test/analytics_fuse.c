@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Send sample arrays to a number of workflows on the executor, each
+ * averaging the averages of the averages of the samples before a last
+ * step checks them, first with every step queued on its own, then with
+ * the steps fused:
+ *
+ *   analytics_fuse [<number of workflows> [<number of arrays> [<workers>]]]
+ *
+ * Both must give the same averages, in order. Fused, a batch takes a
+ * single executor task instead of one per step, and the output arrays
+ * of the steps are reused from one batch to the next.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+#include "opal/sys/atomic.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/average/analytics_average.h"
+
+#define NCORES   64
+#define NAVERAGE 3
+#define BURST    8
+
+typedef struct {
+    int next;
+    int bad;
+    int arrays;
+    opal_value_array_t *last;
+} check_t;
+
+static check_t *checks;
+static double *expected;
+static volatile int32_t done = 0;
+
+/* the last step: the averages of the arrays, in the order they were sent */
+static int check(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    check_t *c = &checks[caddy->wf->workflow_id];
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, 0);
+    if (NULL == value || value->end_time.tv_sec != c->next ||
+        fabs(value->data.value.data.fval - expected[c->next]) > 1e-3 * expected[c->next]) {
+        c->bad++;
+    }
+    if (caddy->data != c->last) {
+        c->arrays++;
+        c->last = caddy->data;
+    }
+    c->next++;
+    opal_atomic_add_32(&done, 1);
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t checker = { NULL, NULL, check, NULL };
+
+static void add_workflows(int nwfs)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    int i, k;
+
+    OBJ_CONSTRUCT(&orcm_analytics_base_wf.workflows, opal_list_t);
+    for (i=0; i < nwfs; i++) {
+        wf = OBJ_NEW(orcm_workflow_t);
+        wf->workflow_id = i;
+        orcm_analytics_base_executor_add_workflow(wf);
+        for (k=0; k < NAVERAGE; k++) {
+            step = OBJ_NEW(orcm_workflow_step_t);
+            step->analytic = strdup("average");
+            step->mod = mca_analytics_average_component.create_handle();
+            opal_list_append(&wf->steps, &step->super);
+        }
+        step = OBJ_NEW(orcm_workflow_step_t);
+        step->analytic = strdup("check");
+        step->mod = &checker;
+        opal_list_append(&wf->steps, &step->super);
+        orcm_analytics_base_workflow_fuse(wf);
+        opal_list_append(&orcm_analytics_base_wf.workflows, &wf->super);
+        orcm_analytics_base_subscribe(wf);
+    }
+    memset(checks, 0, nwfs * sizeof(check_t));
+    done = 0;
+}
+
+static void remove_workflows(void)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    opal_list_item_t *item;
+
+    while (NULL != (item = opal_list_remove_first(&orcm_analytics_base_wf.workflows))) {
+        wf = (orcm_workflow_t*)item;
+        orcm_analytics_base_unsubscribe(wf);
+        orcm_analytics_base_executor_stop_workflow(wf);
+        OPAL_LIST_FOREACH(step, &wf->steps, orcm_workflow_step_t) {
+            if (&checker != step->mod) {
+                step->mod->finalize(step->mod);
+            }
+        }
+        OBJ_RELEASE(wf);
+    }
+    OBJ_DESTRUCT(&orcm_analytics_base_wf.workflows);
+}
+
+static uint64_t tasks(void)
+{
+    uint64_t n = 0;
+    int i;
+
+    for (i=0; i < orcm_analytics_base_executor.nworkers; i++) {
+        n += orcm_analytics_base_executor.workers[i].tasks;
+    }
+    return n;
+}
+
+static double run(char *what, int nwfs, int narrays, opal_value_array_t **arrays,
+                  int *bad, int *narrays_seen, uint64_t *ntasks)
+{
+    orcm_analytics_value_t *value;
+    struct timeval start, end;
+    uint64_t tasks_before = tasks();
+    double secs;
+    int i, j;
+
+    gettimeofday(&start, NULL);
+    for (i=0; i < narrays; i++) {
+        for (j=0; j < NCORES; j++) {
+            value = (orcm_analytics_value_t*)opal_value_array_get_item(arrays[i], j);
+            value->end_time.tv_sec = i;
+        }
+        orcm_analytics.array_send(arrays[i]);
+        if (BURST - 1 == i % BURST) {
+            while (done < nwfs * (i + 1)) {
+                sched_yield();
+            }
+        }
+    }
+    while (done < nwfs * narrays) {
+        usleep(100);
+    }
+    gettimeofday(&end, NULL);
+    secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    *bad = 0;
+    *narrays_seen = 0;
+    for (i=0; i < nwfs; i++) {
+        *bad += checks[i].bad + (narrays != checks[i].next);
+        *narrays_seen += checks[i].arrays;
+    }
+    *ntasks = tasks() - tasks_before;
+    fprintf(stderr, "%s %d arrays to %d workflows in %.2f sec, %.0f batches/sec, "
+            "%.2f tasks per batch, %d arrays reaching the last steps, %d wrong\n",
+            what, narrays, nwfs, secs, (double)nwfs * narrays / secs,
+            (double)*ntasks / ((double)nwfs * narrays), *narrays_seen, *bad);
+    return secs;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_value_array_t **arrays;
+    orcm_metric_value_t *metric;
+    double t1, t2, avg[NAVERAGE];
+    uint64_t tasks1, tasks2;
+    int nwfs = 32, narrays = 2000, i, j, k, bad1, bad2, seen1, seen2;
+
+    if (1 < argc) {
+        nwfs = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        narrays = strtol(argv[2], NULL, 10);
+    }
+    if (3 < argc) {
+        orcm_analytics_base_executor.num_workers = strtol(argv[3], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_subscriptions_init();
+    checks = (check_t*)malloc(nwfs * sizeof(check_t));
+    expected = (double*)malloc(narrays * sizeof(double));
+
+    /* the arrays are shared by the workflows, and must outlive them */
+    arrays = (opal_value_array_t**)malloc(narrays * sizeof(opal_value_array_t*));
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->units = strdup("degrees C");
+    metric->value.type = OPAL_FLOAT;
+    for (i=0; i < narrays; i++) {
+        orcm_analytics.array_create(&arrays[i], NCORES);
+        for (j=0; j < NCORES; j++) {
+            free(metric->value.key);
+            asprintf(&metric->value.key, "core %d", j);
+            metric->value.data.fval = (float)(40 + (i + j) % 30);
+            orcm_analytics.array_append(arrays[i], j, "coretemp", "node00000", metric);
+        }
+        OBJ_RETAIN(arrays[i]);
+        /* the running average of each average, on core 0 */
+        for (k=0; k < NAVERAGE; k++) {
+            avg[k] = (0 == i) ? 0.0 : avg[k];
+            avg[k] += (((0 == k) ? (double)(40 + i % 30) : avg[k - 1]) - avg[k]) / (i + 1);
+        }
+        expected[i] = avg[NAVERAGE - 1];
+    }
+    OBJ_RELEASE(metric);
+
+    orcm_analytics_base_executor_start();
+    orcm_analytics_base_fuse_steps = false;
+    add_workflows(nwfs);
+    t1 = run("steps queued:", nwfs, narrays, arrays, &bad1, &seen1, &tasks1);
+    remove_workflows();
+
+    orcm_analytics_base_fuse_steps = true;
+    add_workflows(nwfs);
+    t2 = run("steps fused: ", nwfs, narrays, arrays, &bad2, &seen2, &tasks2);
+    remove_workflows();
+    fprintf(stderr, "fused: %.1fx the throughput, %.1fx fewer tasks\n", t1 / t2,
+            (double)tasks1 / (0 < tasks2 ? tasks2 : 1));
+    orcm_analytics_base_executor_stop();
+
+    for (i=0; i < narrays; i++) {
+        OBJ_RELEASE(arrays[i]);
+    }
+    free(arrays);
+    free(checks);
+    free(expected);
+    orcm_analytics_base_subscriptions_finalize();
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    /* fused, one task per batch and the same array each time */
+    return (0 == bad1 && 0 == bad2 && (uint64_t)nwfs * narrays == tasks2 &&
+            seen2 <= nwfs) ? 0 : 1;
+}
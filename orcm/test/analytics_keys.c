@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Feed samples into the analytics average step the way the sensor
+ * ingest does - one value array per node and round, built with
+ * array_append - and check the running averages it emits, then
+ * compare the cost per sample against what the ingest and the average
+ * step used to do (strdup node, sensor, label and units for every
+ * value, and asprintf a hash key to find its average):
+ *
+ *   analytics_keys [<number of nodes> [<number of rounds>]]
+ *
+ * Each round delivers one sample of 64 cores per node.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/class/opal_hash_table.h"
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/average/analytics_average.h"
+
+#define NCORES 64
+
+static float *averages = NULL;
+static uint32_t *ids = NULL;
+static int nresults = 0, maxresults = 0;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static float sample(int node, int core, int round)
+{
+    return (float)(40 + (node + 3 * core + 7 * round) % 30);
+}
+
+/* the step after the average, keeping what it got */
+static int collect(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    size_t i;
+
+    for (i=0; i < opal_value_array_get_size(caddy->data); i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, i);
+        if (nresults == maxresults) {
+            maxresults = (0 == maxresults) ? 1024 : 2 * maxresults;
+            averages = (float*)realloc(averages, maxresults * sizeof(float));
+            ids = (uint32_t*)realloc(ids, maxresults * sizeof(uint32_t));
+        }
+        averages[nresults] = value->data.value.data.fval;
+        ids[nresults] = value->key_id;
+        nresults++;
+    }
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t collector = { NULL, NULL, collect, NULL };
+
+static orcm_workflow_t* make_workflow(void)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->ev_base = opal_event_base_create();
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("average");
+    step->mod = mca_analytics_average_component.create_handle();
+    opal_list_append(&wf->steps, &step->super);
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("collect");
+    step->mod = &collector;
+    opal_list_append(&wf->steps, &step->super);
+    return wf;
+}
+
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+    opal_event_loop(wf->ev_base, OPAL_EVLOOP_NONBLOCK);
+}
+
+/* what array_append and the average step did for every value */
+typedef struct {
+    opal_object_t super;
+    unsigned int num_sample;
+    float value_average;
+} old_average_t;
+OBJ_CLASS_INSTANCE(old_average_t, opal_object_t, NULL, NULL);
+
+static float old_path(opal_hash_table_t *table, int index, char *plugin, char *host,
+                      orcm_metric_value_t *metric)
+{
+    char *node_regex, *sensor_name, *key, *units, *hash_key;
+    old_average_t *avg = NULL;
+    float x;
+
+    node_regex = strdup(host);
+    sensor_name = strdup(plugin);
+    key = strdup(metric->value.key);
+    units = strdup(metric->units);
+
+    asprintf(&hash_key, "%s%d%s", node_regex, index, sensor_name);
+    if (OPAL_SUCCESS != opal_hash_table_get_value_ptr(table, hash_key,
+                                                      strlen(hash_key) + 1, (void**)&avg)) {
+        avg = OBJ_NEW(old_average_t);
+        avg->num_sample = 0;
+        avg->value_average = 0.0;
+        opal_hash_table_set_value_ptr(table, hash_key, strlen(hash_key) + 1, avg);
+    }
+    avg->value_average = (avg->num_sample * avg->value_average +
+                          metric->value.data.fval) / (avg->num_sample + 1);
+    avg->num_sample++;
+    x = avg->value_average;
+
+    free(hash_key);
+    free(node_regex);
+    free(sensor_name);
+    free(key);
+    free(units);
+    return x;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_workflow_t *wf;
+    opal_value_array_t *data;
+    orcm_metric_value_t *metrics[NCORES];
+    opal_hash_table_t table;
+    old_average_t *avg;
+    orcm_analytics_key_t *key;
+    struct timeval start;
+    char **nodes, *hash_key;
+    void *node_ptr;
+    size_t len;
+    double *sums, secs1, secs2;
+    long nsamples;
+    float sink = 0.0;
+    int nnodes = 200, nrounds = 100, i, j, k, r, bad = 0, badkeys = 0;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+
+    nodes = (char**)malloc(nnodes * sizeof(char*));
+    for (i=0; i < nnodes; i++) {
+        asprintf(&nodes[i], "node%05d", i);
+    }
+    for (j=0; j < NCORES; j++) {
+        metrics[j] = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&metrics[j]->value.key, "core %d", j);
+        metrics[j]->units = strdup("degrees C");
+        metrics[j]->value.type = OPAL_FLOAT;
+    }
+    sums = (double*)calloc(nnodes * NCORES, sizeof(double));
+
+    /* correctness: every value keeps its key, and gets its average */
+    wf = make_workflow();
+    for (k=0; k < 10; k++) {
+        nresults = 0;
+        for (i=0; i < nnodes; i++) {
+            orcm_analytics.array_create(&data, NCORES);
+            for (j=0; j < NCORES; j++) {
+                metrics[j]->value.data.fval = sample(i, j, k);
+                sums[i * NCORES + j] += metrics[j]->value.data.fval;
+                orcm_analytics.array_append(data, j, "coretemp", nodes[i], metrics[j]);
+            }
+            run_step(wf, data);
+        }
+        for (r=0; r < nresults; r++) {
+            i = r / NCORES;
+            j = r % NCORES;
+            key = orcm_analytics_base_key_get(ids[r]);
+            if (NULL == key || 0 != strcmp(key->node_regex, nodes[i]) ||
+                0 != strcmp(key->sensor_name, "coretemp") || key->index != j ||
+                0 != strncmp(key->label, "core ", 5) || atoi(key->label + 5) != j) {
+                badkeys++;
+            }
+            if (fabs(averages[r] - sums[r] / (k + 1)) > 1e-3) {
+                bad++;
+            }
+        }
+        if (nresults != nnodes * NCORES) {
+            bad++;
+        }
+    }
+    fprintf(stderr, "averages: %d keys interned for %d (node, core), "
+            "%d wrong averages, %d wrong keys\n",
+            (int)orcm_analytics_base_num_keys(), nnodes * NCORES, bad, badkeys);
+
+    /* throughput */
+    OBJ_CONSTRUCT(&table, opal_hash_table_t);
+    opal_hash_table_init(&table, 10000);
+    nsamples = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                metrics[j]->value.data.fval = sample(i, j, k);
+                sink += old_path(&table, j, "coretemp", nodes[i], metrics[j]);
+            }
+            nsamples += NCORES;
+        }
+    }
+    secs1 = elapsed(&start);
+    fprintf(stderr, "strdup + asprintf: %ld samples in %.2f sec, %.0f samples/sec\n",
+            nsamples, secs1, nsamples / secs1);
+
+    nsamples = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        nresults = 0;
+        for (i=0; i < nnodes; i++) {
+            orcm_analytics.array_create(&data, NCORES);
+            for (j=0; j < NCORES; j++) {
+                metrics[j]->value.data.fval = sample(i, j, k);
+                orcm_analytics.array_append(data, j, "coretemp", nodes[i], metrics[j]);
+            }
+            run_step(wf, data);
+            nsamples += NCORES;
+        }
+    }
+    secs2 = elapsed(&start);
+    fprintf(stderr, "interned keys:     %ld samples in %.2f sec, %.0f samples/sec, "
+            "%.1fx faster\n", nsamples, secs2, nsamples / secs2, secs1 / secs2);
+    if (sink < 0.0) {
+        fprintf(stderr, "%f\n", sink);
+    }
+
+    if (OPAL_SUCCESS == opal_hash_table_get_first_key_ptr(&table, (void**)&hash_key, &len,
+                                                          (void**)&avg, &node_ptr)) {
+        do {
+            OBJ_RELEASE(avg);
+        } while (OPAL_SUCCESS == opal_hash_table_get_next_key_ptr(&table, (void**)&hash_key,
+                                                                  &len, (void**)&avg,
+                                                                  node_ptr, &node_ptr));
+    }
+    OBJ_DESTRUCT(&table);
+    for (j=0; j < NCORES; j++) {
+        OBJ_RELEASE(metrics[j]);
+    }
+    for (i=0; i < nnodes; i++) {
+        free(nodes[i]);
+    }
+    free(nodes);
+    free(sums);
+    free(averages);
+    free(ids);
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return 0;
+}
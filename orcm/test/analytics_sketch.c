@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Check the quantile sketches of the analytics base and the sketch step:
+ *
+ *   analytics_sketch [<number of nodes> [<samples per node>]]
+ *
+ * - the quantiles of a sketch against the exact ones, for temperatures,
+ *   a long tailed power draw and values around zero
+ * - a sketch per node, shipped to and merged by its rack, and the
+ *   rack sketches to the top, against a single sketch of all the
+ *   samples, and what shipping them costs compared to the samples
+ * - the sketch step sketching the nodes of a group over periods
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "opal/dss/dss.h"
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/sketch/analytics_sketch.h"
+
+#define ACCURACY 0.01
+#define NCORES   4
+#define RACK     100
+
+static double qs[] = { 0.5, 0.95, 0.99, 0.999 };
+#define NQS (int)(sizeof(qs) / sizeof(qs[0]))
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+/* same rank as the sketch reads */
+static double exact(double *sorted, long n, double q)
+{
+    return sorted[(long)(q * (n - 1))];
+}
+
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static int check_accuracy(char *what, double *v, long n)
+{
+    orcm_analytics_sketch_t sk;
+    double e, x;
+    long i;
+    int k, bad = 0;
+
+    OBJ_CONSTRUCT(&sk, orcm_analytics_sketch_t);
+    orcm_analytics_base_sketch_init(&sk, ACCURACY, 2048);
+    for (i=0; i < n; i++) {
+        orcm_analytics_base_sketch_add(&sk, v[i]);
+    }
+    qsort(v, n, sizeof(double), cmp_double);
+    fprintf(stderr, "%-14s", what);
+    for (k=0; k < NQS; k++) {
+        e = exact(v, n, qs[k]);
+        x = orcm_analytics_base_sketch_quantile(&sk, qs[k]);
+        fprintf(stderr, " p%g %.3f (%.3f)", 100.0 * qs[k], x, e);
+        if (fabs(x - e) > ACCURACY * fabs(e) + 1e-9) {
+            bad++;
+        }
+    }
+    fprintf(stderr, ", %d buckets, %d wrong\n",
+            sk.positive.nbins + sk.negative.nbins, bad);
+    OBJ_DESTRUCT(&sk);
+    return bad;
+}
+
+/* pack a sketch, unpack it and merge it into another */
+static int ship(orcm_analytics_sketch_t *from, orcm_analytics_sketch_t *to, long *nbytes)
+{
+    orcm_analytics_sketch_t *sk;
+    opal_buffer_t buf;
+    int bad = 0;
+
+    OBJ_CONSTRUCT(&buf, opal_buffer_t);
+    if (ORCM_SUCCESS != orcm_analytics_base_sketch_pack(&buf, from)) {
+        bad++;
+    }
+    *nbytes += buf.bytes_used;
+    if (ORCM_SUCCESS != orcm_analytics_base_sketch_unpack(&buf, &sk)) {
+        bad++;
+    } else {
+        if (ORCM_SUCCESS != orcm_analytics_base_sketch_merge(to, sk)) {
+            bad++;
+        }
+        OBJ_RELEASE(sk);
+    }
+    OBJ_DESTRUCT(&buf);
+    return bad;
+}
+
+/* the step after the sketch, keeping the last p95 of the group */
+static double last_p95 = -1.0;
+static int nemitted = 0;
+static char emitted_node[64];
+
+static int collect(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    size_t i;
+
+    for (i=0; i < opal_value_array_get_size(caddy->data); i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, i);
+        if (0 == strcmp(value->data.value.key, "core 0 p95")) {
+            last_p95 = value->data.value.data.fval;
+            snprintf(emitted_node, sizeof(emitted_node), "%s", value->node_regex);
+        }
+        nemitted++;
+    }
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t collector = { NULL, NULL, collect, NULL };
+
+static void add_attr(orcm_workflow_step_t *step, char *key, char *value)
+{
+    opal_value_t *attr = OBJ_NEW(opal_value_t);
+
+    attr->key = strdup(key);
+    attr->type = OPAL_STRING;
+    attr->data.string = strdup(value);
+    opal_list_append(&step->attributes, &attr->super);
+}
+
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+    opal_event_loop(wf->ev_base, OPAL_EVLOOP_NONBLOCK);
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_analytics_sketch_t *sk, *rack, all, merged;
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    orcm_metric_value_t *metric;
+    opal_value_array_t *data;
+    orcm_analytics_value_t *value;
+    double *v, *core0, x, y, e;
+    char node[32];
+    long n, i, ncore0 = 0, node_bytes = 0, rack_bytes = 0;
+    int nnodes = 10000, per_node = 1000, j, k, r, bad = 0, badmerge = 0, badstep = 0;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        per_node = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    srand(1);
+
+    /* accuracy */
+    n = 1000000;
+    v = (double*)malloc(n * sizeof(double));
+    for (i=0; i < n; i++) {
+        v[i] = 30.0 + 70.0 * rand() / (double)RAND_MAX;
+    }
+    bad += check_accuracy("coretemp", v, n);
+    for (i=0; i < n; i++) {
+        v[i] = exp(5.0 + 0.8 * gauss());
+    }
+    bad += check_accuracy("power", v, n);
+    for (i=0; i < n; i++) {
+        v[i] = 10.0 * gauss();
+    }
+    bad += check_accuracy("around zero", v, n);
+    free(v);
+
+    /* a sketch per node, shipped to and merged by its rack, the rack
+     * sketches shipped to and merged at the top */
+    n = (long)nnodes * per_node;
+    v = (double*)malloc(n * sizeof(double));
+    OBJ_CONSTRUCT(&all, orcm_analytics_sketch_t);
+    orcm_analytics_base_sketch_init(&all, ACCURACY, 2048);
+    OBJ_CONSTRUCT(&merged, orcm_analytics_sketch_t);
+    orcm_analytics_base_sketch_init(&merged, ACCURACY, 2048);
+    rack = NULL;
+    for (j=0; j < nnodes; j++) {
+        if (0 == j % RACK) {
+            rack = OBJ_NEW(orcm_analytics_sketch_t);
+            orcm_analytics_base_sketch_init(rack, ACCURACY, 2048);
+        }
+        sk = OBJ_NEW(orcm_analytics_sketch_t);
+        orcm_analytics_base_sketch_init(sk, ACCURACY, 2048);
+        /* each node runs at its own temperature */
+        y = 40.0 + 30.0 * (j % 97) / 97.0;
+        for (k=0; k < per_node; k++) {
+            x = y + 5.0 * gauss();
+            v[(long)j * per_node + k] = x;
+            orcm_analytics_base_sketch_add(sk, x);
+            orcm_analytics_base_sketch_add(&all, x);
+        }
+        badmerge += ship(sk, rack, &node_bytes);
+        OBJ_RELEASE(sk);
+        if (RACK - 1 == j % RACK || nnodes - 1 == j) {
+            badmerge += ship(rack, &merged, &rack_bytes);
+            OBJ_RELEASE(rack);
+        }
+    }
+    qsort(v, n, sizeof(double), cmp_double);
+    for (k=0; k < NQS; k++) {
+        x = orcm_analytics_base_sketch_quantile(&merged, qs[k]);
+        e = exact(v, n, qs[k]);
+        if (x != orcm_analytics_base_sketch_quantile(&all, qs[k]) ||
+            fabs(x - e) > ACCURACY * fabs(e)) {
+            badmerge++;
+        }
+    }
+    if (merged.count != all.count) {
+        badmerge++;
+    }
+    fprintf(stderr, "%d nodes of %d samples in racks of %d: p99 %.3f (%.3f), "
+            "%ld bytes to the racks and %ld to the top instead of %ld of samples, "
+            "%d wrong\n", nnodes, per_node, RACK,
+            orcm_analytics_base_sketch_quantile(&merged, 0.99), exact(v, n, 0.99),
+            node_bytes, rack_bytes, n * (long)sizeof(float), badmerge);
+    OBJ_DESTRUCT(&merged);
+    OBJ_DESTRUCT(&all);
+    free(v);
+
+    /* the step: 64 nodes of a rack, one sample a second, 10s periods */
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->ev_base = opal_event_base_create();
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("sketch");
+    step->mod = mca_analytics_sketch_component.create_handle();
+    add_attr(step, "group", "rack1");
+    add_attr(step, "period", "10s");
+    add_attr(step, "reset", "yes");
+    add_attr(step, "compute", "p50;p95;max");
+    opal_list_append(&wf->steps, &step->super);
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("collect");
+    step->mod = &collector;
+    opal_list_append(&wf->steps, &step->super);
+
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->units = strdup("degrees C");
+    metric->value.type = OPAL_FLOAT;
+    core0 = (double*)malloc(64 * 10 * sizeof(double));
+    for (r=0; r < 100; r++) {
+        for (j=0; j < 64; j++) {
+            snprintf(node, sizeof(node), "node%05d", j);
+            orcm_analytics.array_create(&data, NCORES);
+            for (k=0; k < NCORES; k++) {
+                free(metric->value.key);
+                asprintf(&metric->value.key, "core %d", k);
+                metric->value.data.fval = (float)(40.0 + j % 20 + k + 3.0 * gauss());
+                orcm_analytics.array_append(data, k, "coretemp", node, metric);
+                value = (orcm_analytics_value_t*)opal_value_array_get_item(data, k);
+                value->end_time.tv_sec = 1000000 + r;
+                value->end_time.tv_usec = 0;
+            }
+            /* the first sample of a period closes the one before */
+            if (0 < r && 0 == r % 10 && 0 == j) {
+                qsort(core0, ncore0, sizeof(double), cmp_double);
+                e = exact(core0, ncore0, 0.95);
+                last_p95 = -1.0;
+                run_step(wf, data);
+                if (0 > last_p95 || fabs(last_p95 - e) > ACCURACY * e + 1e-3 ||
+                    0 != strcmp(emitted_node, "rack1")) {
+                    badstep++;
+                }
+                ncore0 = 0;
+            } else {
+                run_step(wf, data);
+            }
+            value = (orcm_analytics_value_t*)opal_value_array_get_item(data, 0);
+            core0[ncore0++] = value->data.value.data.fval;
+        }
+    }
+    fprintf(stderr, "sketch step: %d statistics emitted for group %s, last p95 %.3f, "
+            "%d wrong\n", nemitted, emitted_node, last_p95, badstep);
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    step->mod->finalize(step->mod);
+    OBJ_RELEASE(metric);
+    free(core0);
+    OBJ_RELEASE(wf);
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return (0 == bad && 0 == badmerge && 0 == badstep) ? 0 : 1;
+}
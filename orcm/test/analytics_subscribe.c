@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Send the coretemp arrays of a number of nodes to a workflow per node
+ * (filter nodeid=<node>, average), one taking cores 1 and 1x of every
+ * node and one taking everything, first the way array_send used to -
+ * every array to every workflow, each filter step scanning it - then
+ * through the subscription index, checking every workflow gets exactly
+ * the samples its filter lets through:
+ *
+ *   analytics_subscribe [<number of nodes> [<number of rounds>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+#include "opal/sys/atomic.h"
+
+#include "orte/util/name_fns.h"
+#include "orte/runtime/orte_globals.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/average/analytics_average.h"
+#include "orcm/mca/analytics/filter/analytics_filter.h"
+
+#define NCORES 64
+
+typedef struct {
+    char *node;   /* NULL for any */
+    char *core;   /* NULL for any */
+    long values;
+    int bad;
+} check_t;
+
+static check_t *checks;
+static volatile int32_t calls = 0;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* the last step: only the samples the filter lets through */
+static int check(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    check_t *c = &checks[caddy->wf->workflow_id];
+    size_t i;
+
+    for (i=0; i < opal_value_array_get_size(caddy->data); i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, i);
+        if ((NULL != c->node && 0 != strncmp(c->node, value->node_regex, strlen(c->node))) ||
+            (NULL != c->core && 0 != strncmp(c->core, value->data.value.key, strlen(c->core)))) {
+            c->bad++;
+        }
+        c->values++;
+    }
+    opal_atomic_add_32(&calls, 1);
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t checker = { NULL, NULL, check, NULL };
+
+static void add_step(orcm_workflow_t *wf, char *analytic, orcm_analytics_base_module_t *mod,
+                     char *key, char *value)
+{
+    orcm_workflow_step_t *step;
+    opal_value_t *attr;
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup(analytic);
+    step->mod = mod;
+    if (NULL != key) {
+        attr = OBJ_NEW(opal_value_t);
+        attr->key = strdup(key);
+        attr->type = OPAL_STRING;
+        attr->data.string = strdup(value);
+        opal_list_append(&step->attributes, &attr->super);
+    }
+    opal_list_append(&wf->steps, &step->super);
+}
+
+static void add_workflow(int id, char *key, char *value, char *node, char *core)
+{
+    orcm_workflow_t *wf;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->workflow_id = id;
+    orcm_analytics_base_executor_add_workflow(wf);
+    if (NULL != key) {
+        add_step(wf, "filter", mca_analytics_filter_component.create_handle(), key, value);
+    }
+    add_step(wf, "average", mca_analytics_average_component.create_handle(), NULL, NULL);
+    add_step(wf, "check", &checker, NULL, NULL);
+    opal_list_append(&orcm_analytics_base_wf.workflows, &wf->super);
+    orcm_analytics_base_subscribe(wf);
+
+    checks[id].node = node;
+    checks[id].core = core;
+    checks[id].values = 0;
+    checks[id].bad = 0;
+}
+
+static void add_workflows(char **nodes, int nnodes)
+{
+    int i;
+
+    OBJ_CONSTRUCT(&orcm_analytics_base_wf.workflows, opal_list_t);
+    for (i=0; i < nnodes; i++) {
+        add_workflow(i, "nodeid", nodes[i], nodes[i], NULL);
+    }
+    add_workflow(nnodes, "coreid", "core 1", NULL, "core 1");
+    add_workflow(nnodes + 1, NULL, NULL, NULL, NULL);
+    calls = 0;
+}
+
+static void remove_workflows(void)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    opal_list_item_t *item;
+
+    while (NULL != (item = opal_list_remove_first(&orcm_analytics_base_wf.workflows))) {
+        wf = (orcm_workflow_t*)item;
+        orcm_analytics_base_unsubscribe(wf);
+        orcm_analytics_base_executor_stop_workflow(wf);
+        OPAL_LIST_FOREACH(step, &wf->steps, orcm_workflow_step_t) {
+            if (&checker != step->mod) {
+                step->mod->finalize(step->mod);
+            }
+        }
+        OBJ_RELEASE(wf);
+    }
+    OBJ_DESTRUCT(&orcm_analytics_base_wf.workflows);
+}
+
+/* what array_send used to do */
+static void broadcast(opal_value_array_t *data)
+{
+    orcm_workflow_t *wf = NULL;
+
+    OPAL_LIST_FOREACH(wf, &orcm_analytics_base_wf.workflows, orcm_workflow_t) {
+        OBJ_RETAIN(data);
+        ORCM_ACTIVATE_NEXT_WORKFLOW_STEP(wf,(&(wf->steps.opal_list_sentinel)), data);
+    }
+}
+
+static double run(char *what, char **nodes, int nnodes, int nrounds, bool subscribed)
+{
+    opal_value_array_t *data;
+    orcm_metric_value_t *metric;
+    struct timeval start;
+    double secs;
+    long expected;
+    int32_t ncalls;
+    int i, j, k, bad = 0;
+
+    add_workflows(nodes, nnodes);
+    metric = OBJ_NEW(orcm_metric_value_t);
+    metric->units = strdup("degrees C");
+    metric->value.type = OPAL_FLOAT;
+
+    /* the check step is called for every array a workflow gets */
+    ncalls = subscribed ? nrounds * nnodes * 3 : nrounds * nnodes * (nnodes + 2);
+
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            orcm_analytics.array_create(&data, NCORES);
+            for (j=0; j < NCORES; j++) {
+                free(metric->value.key);
+                asprintf(&metric->value.key, "core %d", j);
+                metric->value.data.fval = (float)(40 + (i + j + k) % 30);
+                orcm_analytics.array_append(data, j, "coretemp", nodes[i], metric);
+            }
+            if (subscribed) {
+                orcm_analytics.array_send(data);
+            } else {
+                broadcast(data);
+            }
+            orcm_analytics.array_cleanup(data);
+        }
+    }
+    while (calls < ncalls) {
+        usleep(100);
+    }
+    secs = elapsed(&start);
+
+    for (i=0; i < nnodes + 2; i++) {
+        if (i < nnodes) {
+            expected = (long)nrounds * NCORES;
+        } else if (i == nnodes) {
+            /* core 1, core 10 .. core 19 */
+            expected = (long)nrounds * nnodes * 11;
+        } else {
+            expected = (long)nrounds * nnodes * NCORES;
+        }
+        bad += checks[i].bad + (expected != checks[i].values);
+    }
+    fprintf(stderr, "%s %d arrays to %d workflows in %.2f sec, %.0f arrays/sec, "
+            "%d workflows wrong\n", what, nrounds * nnodes, nnodes + 2, secs,
+            nrounds * nnodes / secs, bad);
+
+    OBJ_RELEASE(metric);
+    remove_workflows();
+    return secs;
+}
+
+int main(int argc, char* argv[])
+{
+    char **nodes;
+    double t1, t2;
+    int nnodes = 256, nrounds = 10, i;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orcm_analytics_base_keys_init();
+    orcm_analytics_base_subscriptions_init();
+    orcm_analytics_base_executor_start();
+
+    nodes = (char**)malloc(nnodes * sizeof(char*));
+    for (i=0; i < nnodes; i++) {
+        asprintf(&nodes[i], "node%05d", i);
+    }
+    checks = (check_t*)calloc(nnodes + 2, sizeof(check_t));
+
+    t1 = run("every workflow:", nodes, nnodes, nrounds, false);
+    t2 = run("subscriptions: ", nodes, nnodes, nrounds, true);
+    fprintf(stderr, "%.1fx faster\n", t1 / t2);
+
+    orcm_analytics_base_executor_stop();
+    for (i=0; i < nnodes; i++) {
+        free(nodes[i]);
+    }
+    free(nodes);
+    free(checks);
+    orcm_analytics_base_subscriptions_finalize();
+    orcm_analytics_base_keys_finalize();
+    opal_finalize();
+    return 0;
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Drive the analytics threshold step directly, checking the RAS events
+ * it generates against a per-sample model of the limits, hysteresis and
+ * consecutive counts, then measure how many samples per second one
+ * thread evaluates against the limits, compared with walking a list of
+ * policies for every sample the way the coretemp event policy did:
+ *
+ *   analytics_threshold [<number of nodes> [<number of rounds>]]
+ *
+ * Each round delivers one sample of 64 cores per node.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/mca/base/base.h"
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+#include "opal/util/argv.h"
+
+#include "orcm/mca/evgen/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/threshold/analytics_threshold.h"
+
+#define NCORES 64
+#define NCHECK 16
+#define BASE_TIME 1400000000
+
+typedef struct {
+    int key;        /* node * NCHECK + core */
+    int what;       /* 1 high, 2 low, 0 cleared */
+    long round;
+} event_t;
+
+static event_t *events = NULL;
+static int nevents = 0, maxevents = 0;
+static int nsamples_seen = 0;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void add_event(int key, int what, long round)
+{
+    if (nevents == maxevents) {
+        maxevents = (0 == maxevents) ? 1024 : 2 * maxevents;
+        events = (event_t*)realloc(events, maxevents * sizeof(event_t));
+    }
+    events[nevents].key = key;
+    events[nevents].what = what;
+    events[nevents].round = round;
+    nevents++;
+}
+
+/* an evgen module keeping what it got */
+static void generate(orcm_ras_event_t *ev)
+{
+    opal_value_t *kv;
+    int node = -1, core = -1, what = -1;
+
+    OPAL_LIST_FOREACH(kv, &ev->reporter, opal_value_t) {
+        if (0 == strcmp(kv->key, ORCM_LOC_NODE)) {
+            node = strtol(kv->data.string + 4, NULL, 10);
+        }
+    }
+    OPAL_LIST_FOREACH(kv, &ev->description, opal_value_t) {
+        if (0 == strcmp(kv->key, ORCM_DESC_LIMIT_HI)) {
+            what = 1;
+        } else if (0 == strcmp(kv->key, ORCM_DESC_LIMIT_LO)) {
+            what = 2;
+        } else if (0 == strcmp(kv->key, ORCM_DESC_LIMIT_CLEAR)) {
+            what = 0;
+        }
+    }
+    OPAL_LIST_FOREACH(kv, &ev->data, opal_value_t) {
+        core = strtol(kv->key + 5, NULL, 10);
+    }
+    add_event(node * NCHECK + core, what, (long)(ev->timestamp - BASE_TIME));
+}
+
+static orcm_evgen_base_module_t recorder = { NULL, NULL, generate };
+
+/* the step after the threshold, counting what it passed on */
+static int collect(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+
+    nsamples_seen += (int)opal_value_array_get_size(caddy->data);
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t collector = { NULL, NULL, collect, NULL };
+
+static orcm_workflow_t* make_workflow(char *attrs)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    opal_value_t *kv;
+    char **tokens, **kvs;
+    int i;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->ev_base = opal_event_base_create();
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("threshold");
+    tokens = opal_argv_split(attrs, ',');
+    for (i=0; NULL != tokens[i]; i++) {
+        kvs = opal_argv_split(tokens[i], '=');
+        kv = OBJ_NEW(opal_value_t);
+        kv->key = strdup(kvs[0]);
+        kv->type = OPAL_STRING;
+        kv->data.string = strdup(kvs[1]);
+        opal_list_append(&step->attributes, &kv->super);
+        opal_argv_free(kvs);
+    }
+    opal_argv_free(tokens);
+    step->mod = mca_analytics_threshold_component.create_handle();
+    opal_list_append(&wf->steps, &step->super);
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("collect");
+    step->mod = &collector;
+    opal_list_append(&wf->steps, &step->super);
+    return wf;
+}
+
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    OBJ_RETAIN(data);
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+    opal_event_loop(wf->ev_base, OPAL_EVLOOP_NONBLOCK);
+    opal_event_loop(orcm_evgen_evbase, OPAL_EVLOOP_NONBLOCK);
+}
+
+static opal_value_array_t* make_batch(char *node, char *sensor, int ncores)
+{
+    opal_value_array_t *data;
+    orcm_metric_value_t *metric;
+    int i;
+
+    orcm_analytics.array_create(&data, ncores);
+    for (i=0; i < ncores; i++) {
+        metric = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&metric->value.key, "core %d", i);
+        metric->units = strdup("degrees C");
+        metric->value.type = OPAL_FLOAT;
+        metric->value.data.fval = 0.0;
+        orcm_analytics.array_append(data, i, sensor, node, metric);
+        OBJ_RELEASE(metric);
+    }
+    return data;
+}
+
+static void set_sample(opal_value_array_t *data, int i, float x, long round)
+{
+    orcm_analytics_value_t *value;
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(data, i);
+    value->data.value.data.fval = x;
+    value->end_time.tv_sec = BASE_TIME + round;
+    value->end_time.tv_usec = 0;
+    value->start_time = value->end_time;
+}
+
+/* the model: raise after count consecutive samples past the same limit,
+ * clear once back within it by the hysteresis */
+typedef struct {
+    int level, pending, count;
+} model_t;
+
+static void model_sample(model_t *m, int key, float x, float lo, float hi,
+                         float hyst, int count, long round)
+{
+    int side;
+
+    if (1 == m->level) {
+        if (x > hi - hyst) {
+            return;
+        }
+        m->level = 0;
+        add_event(key, 0, round);
+    } else if (2 == m->level) {
+        if (x < lo + hyst) {
+            return;
+        }
+        m->level = 0;
+        add_event(key, 0, round);
+    }
+    side = (x > hi) ? 1 : (x < lo) ? 2 : 0;
+    if (0 == side) {
+        m->count = 0;
+    } else if (side != m->pending) {
+        m->count = 1;
+    } else {
+        m->count++;
+    }
+    m->pending = side;
+    if (0 != side && m->count >= count) {
+        m->level = side;
+        m->count = 0;
+        m->pending = 0;
+        add_event(key, side, round);
+    }
+}
+
+/* what coretemp_policy_filter did for every core: walk the policy list,
+ * comparing sensor names */
+static int walk_policies(opal_list_t *policies, const char *sensor, float x)
+{
+    orcm_sensor_policy_t *plc;
+    int crossed = 0;
+
+    OPAL_LIST_FOREACH(plc, policies, orcm_sensor_policy_t) {
+        if (0 != strcmp(plc->sensor_name, sensor)) {
+            continue;
+        }
+        if ((plc->hi_thres && (x < plc->threshold)) ||
+            (!plc->hi_thres && (x > plc->threshold))) {
+            continue;
+        }
+        crossed++;
+    }
+    return crossed;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_workflow_t *wf;
+    orcm_evgen_active_module_t *active;
+    opal_value_array_t **batches, **others, **checks;
+    orcm_sensor_policy_t *plc;
+    opal_list_t policies;
+    model_t *model;
+    event_t *got;
+    struct timeval start;
+    float *x, lo = 30.0, hi = 80.0, hyst = 5.0;
+    char *node;
+    const char *names[] = {"coretemp", "freq", "power", "ipmi", "dimm", "nodepower"};
+    int nnodes = 200, nrounds = 100, nmodel = 8, n = 2000, ngot, i, j, k, bad, crossed;
+    long nsamples;
+    double secs, secs_walk;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+
+    /* an event generator recording the events */
+    orcm_evgen_evbase = opal_event_base_create();
+    OBJ_CONSTRUCT(&orcm_evgen_base.actives, opal_list_t);
+    active = OBJ_NEW(orcm_evgen_active_module_t);
+    active->module = &recorder;
+    opal_list_append(&orcm_evgen_base.actives, &active->super);
+
+    /* random walks of NCHECK cores on nmodel nodes, wandering across
+     * both limits */
+    checks = (opal_value_array_t**)malloc(nmodel * sizeof(opal_value_array_t*));
+    for (i=0; i < nmodel; i++) {
+        asprintf(&node, "node%05d", i);
+        checks[i] = make_batch(node, "coretemp", NCHECK);
+        free(node);
+    }
+    x = (float*)malloc(nmodel * NCHECK * sizeof(float));
+    model = (model_t*)calloc(nmodel * NCHECK, sizeof(model_t));
+    for (i=0; i < nmodel * NCHECK; i++) {
+        x[i] = 55.0;
+    }
+    srand(1);
+    wf = make_workflow("limits=coretemp:30:80;freq::5000,hysteresis=5,count=3,severity=crit");
+    for (k=0; k < n; k++) {
+        for (i=0; i < nmodel; i++) {
+            for (j=0; j < NCHECK; j++) {
+                x[i * NCHECK + j] += (rand() % 1100 - 550) / 100.0;
+                set_sample(checks[i], j, x[i * NCHECK + j], k);
+            }
+            run_step(wf, checks[i]);
+        }
+    }
+    got = events;
+    ngot = nevents;
+    events = NULL;
+    nevents = maxevents = 0;
+    /* replay the walks through the model */
+    srand(1);
+    for (i=0; i < nmodel * NCHECK; i++) {
+        x[i] = 55.0;
+    }
+    for (k=0; k < n; k++) {
+        for (i=0; i < nmodel; i++) {
+            for (j=0; j < NCHECK; j++) {
+                x[i * NCHECK + j] += (rand() % 1100 - 550) / 100.0;
+                model_sample(&model[i * NCHECK + j], i * NCHECK + j, x[i * NCHECK + j],
+                             lo, hi, hyst, 3, k);
+            }
+        }
+    }
+    bad = abs(ngot - nevents);
+    for (i=0; i < ngot && i < nevents; i++) {
+        if (got[i].key != events[i].key || got[i].what != events[i].what ||
+            got[i].round != events[i].round) {
+            bad++;
+        }
+    }
+    fprintf(stderr, "limits and hysteresis: %d samples, %d events, %d expected, %d wrong\n",
+            n * nmodel * NCHECK, ngot, nevents, bad);
+    for (i=0; i < nmodel; i++) {
+        OBJ_RELEASE(checks[i]);
+    }
+    free(checks);
+    free(got);
+    free(x);
+    free(model);
+
+    /* throughput, with samples within their limits */
+    batches = (opal_value_array_t**)malloc(nnodes * sizeof(opal_value_array_t*));
+    others = (opal_value_array_t**)malloc(nnodes * sizeof(opal_value_array_t*));
+    for (i=0; i < nnodes; i++) {
+        asprintf(&node, "node%05d", i);
+        batches[i] = make_batch(node, "coretemp", NCORES);
+        others[i] = make_batch(node, "freq", NCORES);
+        free(node);
+    }
+    wf = make_workflow("limits=coretemp:0:100;freq::5000;power::400;ipmi::90;dimm::85,"
+                       "hysteresis=2,count=2");
+    nsamples = 0;
+    nsamples_seen = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                set_sample(batches[i], j, (float)(40 + (i + j + k) % 30), k);
+            }
+            run_step(wf, batches[i]);
+            run_step(wf, others[i]);
+            nsamples += 2 * NCORES;
+        }
+    }
+    secs = elapsed(&start);
+    fprintf(stderr, "threshold:    %ld samples in %.2f sec, %.0f samples/sec, %d passed on\n",
+            nsamples, secs, nsamples / secs, nsamples_seen);
+
+    /* the policy list walk, with a high and a low policy per sensor */
+    OBJ_CONSTRUCT(&policies, opal_list_t);
+    for (i=0; i < 6; i++) {
+        for (j=0; j < 2; j++) {
+            plc = OBJ_NEW(orcm_sensor_policy_t);
+            plc->sensor_name = strdup(names[i]);
+            plc->threshold = j ? 100.0 : 0.0;
+            plc->hi_thres = j;
+            opal_list_append(&policies, &plc->super);
+        }
+    }
+    crossed = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                crossed += walk_policies(&policies, "coretemp", (float)(40 + (i + j + k) % 30));
+                crossed += walk_policies(&policies, "freq", (float)(40 + (i + j + k) % 30));
+            }
+        }
+    }
+    secs_walk = elapsed(&start);
+    fprintf(stderr, "policy walk:  %ld samples in %.2f sec, %.0f samples/sec, %d crossed\n",
+            nsamples, secs_walk, nsamples / secs_walk, crossed);
+    OPAL_LIST_DESTRUCT(&policies);
+
+    for (i=0; i < nnodes; i++) {
+        OBJ_RELEASE(batches[i]);
+        OBJ_RELEASE(others[i]);
+    }
+    free(batches);
+    free(others);
+    free(events);
+    OPAL_LIST_DESTRUCT(&orcm_evgen_base.actives);
+    opal_finalize();
+    return 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Drive the analytics window step directly, checking what it emits
+ * against statistics computed over each window from scratch, then
+ * measure how many samples per second one thread can push through it:
+ *
+ *   analytics_window [<number of nodes> [<number of rounds>]]
+ *
+ * Each round delivers one sample of 64 cores per node, one second
+ * after the previous round.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/mca/base/base.h"
+#include "opal/mca/event/event.h"
+#include "opal/runtime/opal.h"
+#include "opal/util/argv.h"
+
+#include "orcm/mca/analytics/base/analytics_private.h"
+#include "orcm/mca/analytics/window/analytics_window.h"
+
+#define NCORES 64
+#define NSTATS 5
+
+typedef struct {
+    float value;
+    struct timeval start, end;
+} result_t;
+
+static result_t *results = NULL;
+static int nresults = 0, maxresults = 0;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* the step after the window, keeping what it got */
+static int collect(int sd, short args, void *cbdata)
+{
+    orcm_workflow_caddy_t *caddy = (orcm_workflow_caddy_t*)cbdata;
+    orcm_analytics_value_t *value;
+    size_t i;
+
+    for (i=0; i < opal_value_array_get_size(caddy->data); i++) {
+        value = (orcm_analytics_value_t*)opal_value_array_get_item(caddy->data, i);
+        if (nresults == maxresults) {
+            maxresults = (0 == maxresults) ? 1024 : 2 * maxresults;
+            results = (result_t*)realloc(results, maxresults * sizeof(result_t));
+        }
+        results[nresults].value = value->data.value.data.fval;
+        results[nresults].start = value->start_time;
+        results[nresults].end = value->end_time;
+        nresults++;
+    }
+    OBJ_RELEASE(caddy);
+    return ORCM_SUCCESS;
+}
+
+static orcm_analytics_base_module_t collector = { NULL, NULL, collect, NULL };
+
+static orcm_workflow_t* make_workflow(char *attrs)
+{
+    orcm_workflow_t *wf;
+    orcm_workflow_step_t *step;
+    opal_value_t *kv;
+    char **tokens, **kvs;
+    int i;
+
+    wf = OBJ_NEW(orcm_workflow_t);
+    wf->ev_base = opal_event_base_create();
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("window");
+    tokens = opal_argv_split(attrs, ',');
+    for (i=0; NULL != tokens[i]; i++) {
+        kvs = opal_argv_split(tokens[i], '=');
+        kv = OBJ_NEW(opal_value_t);
+        kv->key = strdup(kvs[0]);
+        kv->type = OPAL_STRING;
+        kv->data.string = strdup(kvs[1]);
+        opal_list_append(&step->attributes, &kv->super);
+        opal_argv_free(kvs);
+    }
+    opal_argv_free(tokens);
+    step->mod = mca_analytics_window_component.create_handle();
+    opal_list_append(&wf->steps, &step->super);
+
+    step = OBJ_NEW(orcm_workflow_step_t);
+    step->analytic = strdup("collect");
+    step->mod = &collector;
+    opal_list_append(&wf->steps, &step->super);
+    return wf;
+}
+
+static void run_step(orcm_workflow_t *wf, opal_value_array_t *data)
+{
+    orcm_workflow_caddy_t *caddy;
+    orcm_workflow_step_t *step;
+
+    step = (orcm_workflow_step_t*)opal_list_get_first(&wf->steps);
+    caddy = OBJ_NEW(orcm_workflow_caddy_t);
+    OBJ_RETAIN(wf);
+    caddy->wf = wf;
+    OBJ_RETAIN(step);
+    caddy->wf_step = step;
+    OBJ_RETAIN(data);
+    caddy->data = data;
+    caddy->imod = step->mod;
+    step->mod->analyze(0, 0, caddy);
+    opal_event_loop(wf->ev_base, OPAL_EVLOOP_NONBLOCK);
+}
+
+static opal_value_array_t* make_batch(char *node, int ncores)
+{
+    opal_value_array_t *data;
+    orcm_metric_value_t *metric;
+    int i;
+
+    orcm_analytics.array_create(&data, ncores);
+    for (i=0; i < ncores; i++) {
+        metric = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&metric->value.key, "core %d", i);
+        metric->units = strdup("degrees C");
+        metric->value.type = OPAL_FLOAT;
+        metric->value.data.fval = 0.0;
+        orcm_analytics.array_append(data, i, "coretemp", node, metric);
+        OBJ_RELEASE(metric);
+    }
+    return data;
+}
+
+static void set_sample(opal_value_array_t *data, int i, float x, double t)
+{
+    orcm_analytics_value_t *value;
+
+    value = (orcm_analytics_value_t*)opal_value_array_get_item(data, i);
+    value->data.value.data.fval = x;
+    value->end_time.tv_sec = (time_t)t;
+    value->end_time.tv_usec = (suseconds_t)((t - (double)(time_t)t) * 1000000.0 + 0.5);
+    value->start_time = value->end_time;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+/* mean, min, max, stddev and p90 of v[0..n-1] from scratch */
+static void stats(double *v, int n, double *out)
+{
+    double *s, sum = 0.0, sq = 0.0, rank;
+    int i, k;
+
+    s = (double*)malloc(n * sizeof(double));
+    memcpy(s, v, n * sizeof(double));
+    qsort(s, n, sizeof(double), cmp_double);
+    for (i=0; i < n; i++) {
+        sum += s[i];
+    }
+    out[0] = sum / n;
+    for (i=0; i < n; i++) {
+        sq += (s[i] - out[0]) * (s[i] - out[0]);
+    }
+    out[1] = s[0];
+    out[2] = s[n - 1];
+    out[3] = (1 < n) ? sqrt(sq / (n - 1)) : 0.0;
+    rank = 0.9 * (n - 1);
+    k = (int)rank;
+    out[4] = (k + 1 < n) ? s[k] + (rank - k) * (s[k + 1] - s[k]) : s[k];
+    free(s);
+}
+
+static int check(int r, double *expect, double start, double end)
+{
+    int i, bad = 0;
+    double t;
+
+    if (nresults < r + NSTATS) {
+        return 1;
+    }
+    for (i=0; i < NSTATS; i++) {
+        if (fabs(results[r + i].value - expect[i]) > 1e-3 * (1.0 + fabs(expect[i]))) {
+            bad = 1;
+        }
+        t = results[r + i].start.tv_sec + results[r + i].start.tv_usec / 1000000.0;
+        if (fabs(t - start) > 1e-5) {
+            bad = 1;
+        }
+        t = results[r + i].end.tv_sec + results[r + i].end.tv_usec / 1000000.0;
+        if (fabs(t - end) > 1e-5) {
+            bad = 1;
+        }
+    }
+    return bad;
+}
+
+#define COMPUTE "compute=mean;min;max;stddev;p90"
+
+int main(int argc, char* argv[])
+{
+    orcm_workflow_t *wf;
+    opal_value_array_t *data, **batches;
+    struct timeval start, tv;
+    double *v, *times, expect[NSTATS], secs;
+    char *node;
+    int nnodes = 200, nrounds = 100, n = 20000, w = 50, i, j, k, r, bad, first;
+    long nsamples;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nrounds = strtol(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+
+    v = (double*)malloc(n * sizeof(double));
+    times = (double*)malloc(n * sizeof(double));
+    /* times in whole microseconds, as the step sees them */
+    srand(1);
+    tv.tv_sec = 1400000000;
+    tv.tv_usec = 0;
+    for (i=0; i < n; i++) {
+        v[i] = 40.0 + (rand() % 4000) / 100.0;
+        tv.tv_usec += 50000 + (rand() % 100) * 1000 + rand() % 1000;
+        tv.tv_sec += tv.tv_usec / 1000000;
+        tv.tv_usec %= 1000000;
+        times[i] = tv.tv_sec + tv.tv_usec / 1000000.0;
+    }
+    data = make_batch("node00000", 1);
+
+    /* sliding window of w samples, emitted on every sample */
+    wf = make_workflow("win_type=sliding,win_size=50," COMPUTE);
+    for (i=0; i < n; i++) {
+        set_sample(data, 0, (float)v[i], times[i]);
+        run_step(wf, data);
+    }
+    for (bad=0, r=0, i=w - 1; i < n; i++, r += NSTATS) {
+        stats(&v[i - w + 1], w, expect);
+        bad += check(r, expect, times[i - w + 1], times[i]);
+    }
+    fprintf(stderr, "sliding 50 samples:   %d windows, %d results, %d wrong\n",
+            n - w + 1, nresults, bad);
+
+    /* tumbling window of one second */
+    nresults = 0;
+    wf = make_workflow("win_type=tumbling,win_size=1s,win_slots=64," COMPUTE);
+    for (i=0; i < n; i++) {
+        set_sample(data, 0, (float)v[i], times[i]);
+        run_step(wf, data);
+    }
+    for (bad=0, r=0, first=0, i=1; i < n; i++) {
+        if (floor(times[i]) != floor(times[first])) {
+            stats(&v[first], i - first, expect);
+            bad += check(r, expect, floor(times[first]), floor(times[first]) + 1.0);
+            r += NSTATS;
+            first = i;
+        }
+    }
+    fprintf(stderr, "tumbling 1s:          %d windows, %d results, %d wrong\n",
+            r / NSTATS, nresults, bad);
+
+    /* sliding window of two seconds, emitted on every sample */
+    nresults = 0;
+    wf = make_workflow("win_type=sliding,win_size=2s,win_slots=64," COMPUTE);
+    for (i=0; i < n; i++) {
+        set_sample(data, 0, (float)v[i], times[i]);
+        run_step(wf, data);
+    }
+    for (bad=0, r=0, first=0, i=0; i < n; i++, r += NSTATS) {
+        while (times[first] <= times[i] - 2.0) {
+            first++;
+        }
+        stats(&v[first], i - first + 1, expect);
+        bad += check(r, expect, times[i] - 2.0, times[i]);
+    }
+    fprintf(stderr, "sliding 2s:           %d windows, %d results, %d wrong\n",
+            n, nresults, bad);
+    OBJ_RELEASE(data);
+
+    /* throughput */
+    batches = (opal_value_array_t**)malloc(nnodes * sizeof(opal_value_array_t*));
+    for (i=0; i < nnodes; i++) {
+        asprintf(&node, "node%05d", i);
+        batches[i] = make_batch(node, NCORES);
+        free(node);
+    }
+    wf = make_workflow("win_type=tumbling,win_size=60s," COMPUTE);
+    nresults = 0;
+    nsamples = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                set_sample(batches[i], j, (float)(40 + (i + j + k) % 30), 1400000000.0 + k);
+            }
+            run_step(wf, batches[i]);
+            nsamples += NCORES;
+        }
+    }
+    secs = elapsed(&start);
+    fprintf(stderr, "tumbling 60s:         %ld samples of %d keys in %.2f sec, "
+            "%.0f samples/sec, %d results\n",
+            nsamples, nnodes * NCORES, secs, nsamples / secs, nresults);
+
+    wf = make_workflow("win_type=sliding,win_size=30,win_slide=10," COMPUTE);
+    nresults = 0;
+    nsamples = 0;
+    gettimeofday(&start, NULL);
+    for (k=0; k < nrounds; k++) {
+        for (i=0; i < nnodes; i++) {
+            for (j=0; j < NCORES; j++) {
+                set_sample(batches[i], j, (float)(40 + (i + j + k) % 30), 1400000000.0 + k);
+            }
+            run_step(wf, batches[i]);
+            nsamples += NCORES;
+        }
+    }
+    secs = elapsed(&start);
+    fprintf(stderr, "sliding 30 samples:   %ld samples of %d keys in %.2f sec, "
+            "%.0f samples/sec, %d results\n",
+            nsamples, nnodes * NCORES, secs, nsamples / secs, nresults);
+
+    free(v);
+    free(times);
+    free(results);
+    opal_finalize();
+    return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Write the site file of a generated system, then define the system as
+ * a few of its daemons from the site file and from the compiled config:
+ *
+ *   cfgi_cache [<rows> [<racks per row> [<nodes per rack>]]]
+ *
+ * Both must give each daemon the same name, HNP, parent daemon, number
+ * of daemons and cluster definition. The compiled config must not be
+ * used once the site file changed or the compiled config is damaged.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+#include "opal/dss/dss.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/proc_info.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/cfgi/base/base.h"
+
+#define PORT 55805
+
+typedef struct {
+    char *host;
+    orte_proc_type_t type;
+    /* what the site file gives */
+    orte_vpid_t vpid;
+    orte_vpid_t hnp;
+    orte_vpid_t daemon;
+    orte_vpid_t nprocs;
+    char *def;
+    int32_t deflen;
+} me_t;
+
+static int nrows = 8, nracks = 16, nnodes = 64;
+static char site[256], compiled[256 + 8];
+
+static void write_site(FILE *fp)
+{
+    int r, k;
+
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+            "<configuration>\n"
+            "  <version>3.0</version>\n"
+            "  <role>RECORD</role>\n"
+            "  <junction>\n"
+            "    <type>cluster</type>\n"
+            "    <name>test</name>\n"
+            "    <controller>\n"
+            "      <host>master</host>\n"
+            "      <port>%d</port>\n"
+            "      <aggregator>yes</aggregator>\n"
+            "    </controller>\n", PORT);
+    for (r=0; r < nrows; r++) {
+        fprintf(fp, "    <junction>\n"
+                "      <type>row</type>\n"
+                "      <name>row%02d</name>\n", r);
+        /* only the even rows have a controller */
+        if (0 == r % 2) {
+            fprintf(fp, "      <controller>\n"
+                    "        <host>row%02dctl</host>\n"
+                    "        <port>%d</port>\n"
+                    "        <aggregator>yes</aggregator>\n"
+                    "      </controller>\n", r, PORT);
+        }
+        for (k=0; k < nracks; k++) {
+            fprintf(fp, "      <junction>\n"
+                    "        <type>rack</type>\n"
+                    "        <name>r%02dk%02d</name>\n", r, k);
+            /* and the even racks */
+            if (0 == k % 2) {
+                fprintf(fp, "        <controller>\n"
+                        "          <host>r%02dk%02d</host>\n"
+                        "          <port>%d</port>\n"
+                        "          <aggregator>yes</aggregator>\n"
+                        "          <mca-params>sensor_base_sample_rate=%d</mca-params>\n"
+                        "        </controller>\n", r, k, PORT, 5 + k);
+            }
+            fprintf(fp, "        <junction>\n"
+                    "          <type>node</type>\n"
+                    "          <name>r%02dk%02dn[3:0-%d]</name>\n"
+                    "          <controller>\n"
+                    "            <host>@</host>\n"
+                    "            <port>%d</port>\n"
+                    "            <aggregator>no</aggregator>\n"
+                    "          </controller>\n"
+                    "        </junction>\n"
+                    "      </junction>\n", r, k, nnodes - 1, PORT);
+        }
+        fprintf(fp, "    </junction>\n");
+    }
+    fprintf(fp, "  </junction>\n"
+            "  <scheduler>\n"
+            "    <shost>master</shost>\n"
+            "    <port>55820</port>\n"
+            "    <queues>default</queues>\n"
+            "  </scheduler>\n"
+            "</configuration>\n");
+}
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* define the system as a fresh daemon of the given host would */
+static int define(me_t *me, orte_vpid_t *vpid, orte_vpid_t *hnp, orte_vpid_t *daemon,
+                  orte_vpid_t *nprocs, char **def, int32_t *deflen, double *secs)
+{
+    opal_list_t config;
+    opal_buffer_t buf;
+    orcm_node_t *mynode = NULL;
+    double start;
+    int rc;
+
+    orcm_cfgi_base_cache_close();
+    if (NULL != orcm_clusters) {
+        OPAL_LIST_RELEASE(orcm_clusters);
+        OPAL_LIST_RELEASE(orcm_schedulers);
+    }
+    orcm_clusters = OBJ_NEW(opal_list_t);
+    orcm_schedulers = OBJ_NEW(opal_list_t);
+    orte_process_info.nodename = me->host;
+    orte_process_info.proc_type = me->type;
+    ORTE_PROC_MY_NAME->jobid = 0;
+    ORTE_PROC_MY_NAME->vpid = ORTE_VPID_INVALID;
+    ORTE_PROC_MY_HNP->vpid = ORTE_VPID_INVALID;
+    ORTE_PROC_MY_DAEMON->vpid = ORTE_VPID_INVALID;
+
+    start = now();
+    OBJ_CONSTRUCT(&config, opal_list_t);
+    OBJ_CONSTRUCT(&buf, opal_buffer_t);
+    if (ORCM_SUCCESS != (rc = orcm_cfgi.read_config(&config)) ||
+        ORCM_SUCCESS != (rc = orcm_cfgi.define_system(&config, &mynode, nprocs, &buf))) {
+        OPAL_LIST_DESTRUCT(&config);
+        OBJ_DESTRUCT(&buf);
+        return rc;
+    }
+    *secs = now() - start;
+    *vpid = (NULL == mynode) ? ORTE_VPID_INVALID : ORTE_PROC_MY_NAME->vpid;
+    *hnp = ORTE_PROC_MY_HNP->vpid;
+    *daemon = ORTE_PROC_MY_DAEMON->vpid;
+    opal_dss.unload(&buf, (void**)def, deflen);
+    OPAL_LIST_DESTRUCT(&config);
+    OBJ_DESTRUCT(&buf);
+    return ORCM_SUCCESS;
+}
+
+/* the same daemon, from the compiled config */
+static int check(me_t *me, bool cached, double *secs)
+{
+    orte_vpid_t vpid, hnp, daemon, nprocs;
+    char *def;
+    int32_t deflen;
+    int bad = 0;
+
+    if (ORCM_SUCCESS != define(me, &vpid, &hnp, &daemon, &nprocs, &def, &deflen, secs)) {
+        fprintf(stderr, "%s: failed to define the system\n", me->host);
+        return 1;
+    }
+    if (cached != orcm_cfgi_base_cache_is_open()) {
+        fprintf(stderr, "%s: compiled config %s\n", me->host, cached ? "unused" : "used");
+        bad++;
+    }
+    if (vpid != me->vpid || hnp != me->hnp || daemon != me->daemon || nprocs != me->nprocs) {
+        fprintf(stderr, "%s: vpid %u hnp %u daemon %u of %u instead of %u %u %u of %u\n",
+                me->host, vpid, hnp, daemon, nprocs, me->vpid, me->hnp, me->daemon,
+                me->nprocs);
+        bad++;
+    }
+    if (deflen != me->deflen || 0 != memcmp(def, me->def, deflen)) {
+        fprintf(stderr, "%s: different cluster definition\n", me->host);
+        bad++;
+    }
+    free(def);
+    return bad;
+}
+
+int main(int argc, char* argv[])
+{
+    me_t mes[] = {
+        { "master", ORCM_SCHED },
+        { "master", ORCM_DAEMON },
+        { "row00ctl", ORCM_DAEMON },
+        { "r00k00", ORCM_DAEMON },
+        { "r00k00n005", ORCM_DAEMON },
+        { "r00k01n010", ORCM_DAEMON },
+        { "r01k00n020", ORCM_DAEMON },
+        { "r01k03n030", ORCM_DAEMON },
+        { NULL, ORCM_DAEMON },
+        { "nosuchnode", ORCM_DAEMON }
+    };
+    int nmes = sizeof(mes) / sizeof(me_t);
+    double xml = 0.0, cache = 0.0, secs;
+    char *last;
+    int i, bad = 0;
+    FILE *fp;
+
+    if (1 < argc) {
+        nrows = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nracks = strtol(argv[2], NULL, 10);
+    }
+    if (3 < argc) {
+        nnodes = strtol(argv[3], NULL, 10);
+    }
+    asprintf(&last, "r%02dk%02dn%03d", nrows - 1, nracks - 1, nnodes - 1);
+    mes[nmes - 2].host = last;
+
+    snprintf(site, sizeof(site), "/tmp/cfgi_cache.%d.xml", (int)getpid());
+    snprintf(compiled, sizeof(compiled), "%s.cache", site);
+    if (NULL == (fp = fopen(site, "w"))) {
+        perror(site);
+        exit(1);
+    }
+    write_site(fp);
+    fclose(fp);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_config_file", site, 1);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_use_cache", "0", 1);
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    if (ORCM_SUCCESS != mca_base_framework_open(&orcm_cfgi_base_framework, 0) ||
+        ORCM_SUCCESS != orcm_cfgi_base_select()) {
+        fprintf(stderr, "Failed to select a cfgi component\n");
+        exit(1);
+    }
+
+    /* the site file */
+    for (i=0; i < nmes; i++) {
+        if (ORCM_SUCCESS != define(&mes[i], &mes[i].vpid, &mes[i].hnp, &mes[i].daemon,
+                                   &mes[i].nprocs, &mes[i].def, &mes[i].deflen, &secs)) {
+            fprintf(stderr, "%s: failed to define the system from %s\n", mes[i].host, site);
+            exit(1);
+        }
+        xml += secs;
+    }
+    /* the daemons of all kinds were found, and only they */
+    if (ORTE_VPID_INVALID == mes[0].vpid || ORTE_VPID_INVALID == mes[nmes - 2].vpid ||
+        mes[0].vpid == mes[1].vpid || ORTE_VPID_INVALID != mes[nmes - 1].vpid ||
+        mes[1].vpid != mes[2].daemon || mes[3].vpid != mes[4].daemon ||
+        mes[2].vpid != mes[5].daemon || mes[1].vpid != mes[7].daemon) {
+        fprintf(stderr, "the site file did not define the expected daemons\n");
+        bad++;
+    }
+
+    /* compile it, as orcm-cfgc would */
+    if (ORCM_SUCCESS != orcm_cfgi_base_cache_write(compiled)) {
+        fprintf(stderr, "failed to write %s\n", compiled);
+        exit(1);
+    }
+    orcm_cfgi_base.use_cache = true;
+    for (i=0; i < nmes; i++) {
+        bad += check(&mes[i], true, &secs);
+        cache += secs;
+    }
+    fprintf(stderr, "%d daemons: %.2f msec from the site file, %.2f msec compiled, %.1fx faster\n",
+            (int)mes[0].nprocs, 1000.0 * xml / nmes, 1000.0 * cache / nmes, xml / cache);
+
+    /* an edited site file */
+    if (NULL == (fp = fopen(site, "a"))) {
+        perror(site);
+        exit(1);
+    }
+    fprintf(fp, "\n");
+    fclose(fp);
+    bad += check(&mes[4], false, &secs);
+
+    /* a damaged compiled config */
+    orcm_cfgi_base_cache_write(compiled);
+    bad += check(&mes[4], true, &secs);
+    if (NULL == (fp = fopen(compiled, "r+"))) {
+        perror(compiled);
+        exit(1);
+    }
+    fseek(fp, -2, SEEK_END);
+    fputc('x', fp);
+    fclose(fp);
+    bad += check(&mes[4], false, &secs);
+
+    unlink(compiled);
+    unlink(site);
+    for (i=0; i < nmes; i++) {
+        free(mes[i].def);
+    }
+    free(last);
+    orcm_cfgi_base_cache_close();
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
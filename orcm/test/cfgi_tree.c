@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Write the site file of a generated system and serve it from the master,
+ * then define the system as a few of its daemons by asking the master,
+ * and as a compute node by asking its rack controller in turn:
+ *
+ *   cfgi_tree [<rows> [<racks per row> [<nodes per rack>]]]
+ *
+ * Each daemon must get the same name, HNP, parent daemon and number of
+ * daemons as from the site file, with a compute node getting far less
+ * of the system than the master has. A daemon nobody knows must fall
+ * back to the site file. All ask from the loopback, so the daemons are
+ * not held to asking from their host - except for a last one, which must
+ * be refused, as must a daemon asking the rack controller of another rack.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "opal/runtime/opal.h"
+#include "opal/dss/dss.h"
+#include "opal/mca/event/event.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/proc_info.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/cfgi/base/base.h"
+#include "orcm/mca/cfgi/tree/cfgi_tree.h"
+
+#define PORT 55805
+#define TREE_PORT 55806
+
+typedef struct {
+    char *host;
+    /* what the site file gives */
+    orte_vpid_t vpid;
+    orte_vpid_t hnp;
+    orte_vpid_t daemon;
+    orte_vpid_t nprocs;
+    int32_t deflen;
+} me_t;
+
+static int nrows = 8, nracks = 16, nnodes = 64;
+static char site[256];
+
+static void write_site(FILE *fp)
+{
+    int r, k;
+
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+            "<configuration>\n"
+            "  <version>3.0</version>\n"
+            "  <role>RECORD</role>\n"
+            "  <junction>\n"
+            "    <type>cluster</type>\n"
+            "    <name>test</name>\n"
+            "    <controller>\n"
+            "      <host>master</host>\n"
+            "      <port>%d</port>\n"
+            "      <aggregator>yes</aggregator>\n"
+            "    </controller>\n", PORT);
+    for (r=0; r < nrows; r++) {
+        fprintf(fp, "    <junction>\n"
+                "      <type>row</type>\n"
+                "      <name>row%02d</name>\n", r);
+        /* only the even rows have a controller */
+        if (0 == r % 2) {
+            fprintf(fp, "      <controller>\n"
+                    "        <host>row%02dctl</host>\n"
+                    "        <port>%d</port>\n"
+                    "        <aggregator>yes</aggregator>\n"
+                    "      </controller>\n", r, PORT);
+        }
+        for (k=0; k < nracks; k++) {
+            fprintf(fp, "      <junction>\n"
+                    "        <type>rack</type>\n"
+                    "        <name>r%02dk%02d</name>\n", r, k);
+            /* and the even racks */
+            if (0 == k % 2) {
+                fprintf(fp, "        <controller>\n"
+                        "          <host>r%02dk%02d</host>\n"
+                        "          <port>%d</port>\n"
+                        "          <aggregator>yes</aggregator>\n"
+                        "          <mca-params>sensor_base_sample_rate=%d</mca-params>\n"
+                        "        </controller>\n", r, k, PORT, 5 + k);
+            }
+            fprintf(fp, "        <junction>\n"
+                    "          <type>node</type>\n"
+                    "          <name>r%02dk%02dn[3:0-%d]</name>\n"
+                    "          <controller>\n"
+                    "            <host>@</host>\n"
+                    "            <port>%d</port>\n"
+                    "            <aggregator>no</aggregator>\n"
+                    "          </controller>\n"
+                    "        </junction>\n"
+                    "      </junction>\n", r, k, nnodes - 1, PORT);
+        }
+        fprintf(fp, "    </junction>\n");
+    }
+    fprintf(fp, "  </junction>\n"
+            "  <scheduler>\n"
+            "    <shost>master</shost>\n"
+            "    <port>55820</port>\n"
+            "    <queues>default</queues>\n"
+            "  </scheduler>\n"
+            "</configuration>\n");
+}
+
+/* define the system as a fresh daemon of the given host would */
+static int define(char *host, orte_vpid_t *vpid, orte_vpid_t *hnp, orte_vpid_t *daemon,
+                  orte_vpid_t *nprocs, int32_t *deflen)
+{
+    opal_list_t config;
+    opal_buffer_t buf;
+    orcm_node_t *mynode = NULL;
+    int rc;
+
+    if (NULL != orcm_clusters) {
+        OPAL_LIST_RELEASE(orcm_clusters);
+        OPAL_LIST_RELEASE(orcm_schedulers);
+    }
+    orcm_clusters = OBJ_NEW(opal_list_t);
+    orcm_schedulers = OBJ_NEW(opal_list_t);
+    orte_process_info.nodename = host;
+    orte_process_info.proc_type = ORCM_DAEMON;
+    ORTE_PROC_MY_NAME->jobid = 0;
+    ORTE_PROC_MY_NAME->vpid = ORTE_VPID_INVALID;
+    ORTE_PROC_MY_HNP->vpid = ORTE_VPID_INVALID;
+    ORTE_PROC_MY_DAEMON->vpid = ORTE_VPID_INVALID;
+
+    OBJ_CONSTRUCT(&config, opal_list_t);
+    OBJ_CONSTRUCT(&buf, opal_buffer_t);
+    if (ORCM_SUCCESS != (rc = orcm_cfgi.read_config(&config)) ||
+        ORCM_SUCCESS != (rc = orcm_cfgi.define_system(&config, &mynode, nprocs, &buf))) {
+        OPAL_LIST_DESTRUCT(&config);
+        OBJ_DESTRUCT(&buf);
+        return rc;
+    }
+    *vpid = (NULL == mynode) ? ORTE_VPID_INVALID : ORTE_PROC_MY_NAME->vpid;
+    *hnp = ORTE_PROC_MY_HNP->vpid;
+    *daemon = ORTE_PROC_MY_DAEMON->vpid;
+    *deflen = buf.bytes_used;
+    if (NULL != mynode) {
+        OBJ_RELEASE(mynode);
+    }
+    OPAL_LIST_DESTRUCT(&config);
+    OBJ_DESTRUCT(&buf);
+    return ORCM_SUCCESS;
+}
+
+/* the same daemon, from its parent */
+static int check(me_t *me, int32_t *deflen)
+{
+    orte_vpid_t vpid, hnp, daemon, nprocs;
+
+    if (ORCM_SUCCESS != define(me->host, &vpid, &hnp, &daemon, &nprocs, deflen)) {
+        fprintf(stderr, "%s: failed to define the system\n", me->host);
+        return 1;
+    }
+    if (vpid != me->vpid || hnp != me->hnp || daemon != me->daemon || nprocs != me->nprocs) {
+        fprintf(stderr, "%s: vpid %u hnp %u daemon %u of %u instead of %u %u %u of %u\n",
+                me->host, vpid, hnp, daemon, nprocs, me->vpid, me->hnp, me->daemon,
+                me->nprocs);
+        return 1;
+    }
+    fprintf(stderr, "%s: %d bytes of the system instead of %d\n",
+            me->host, (int)*deflen, (int)me->deflen);
+    return 0;
+}
+
+/* serve the system as the given daemon */
+static void serve(me_t *me, int port)
+{
+    orte_vpid_t vpid, hnp, daemon, nprocs;
+    int32_t deflen;
+
+    if (ORCM_SUCCESS != define(me->host, &vpid, &hnp, &daemon, &nprocs, &deflen)) {
+        fprintf(stderr, "%s: failed to define the system\n", me->host);
+        exit(1);
+    }
+    orte_process_info.num_procs = nprocs;
+    orcm_cfgi_base.tree_port = port;
+    if (ORCM_SUCCESS != orcm_cfgi_base_tree_serve()) {
+        fprintf(stderr, "%s: failed to serve the system\n", me->host);
+        exit(1);
+    }
+}
+
+/* the given parent must not serve the host */
+static int refused(char *host, int port)
+{
+    opal_buffer_t slice;
+    char parent[64];
+    int rc;
+
+    snprintf(parent, sizeof(parent), "127.0.0.1:%d", port);
+    OBJ_CONSTRUCT(&slice, opal_buffer_t);
+    rc = orcm_cfgi_base_tree_fetch(parent, host, "127.0.0.1", 2, &slice);
+    OBJ_DESTRUCT(&slice);
+    if (ORCM_ERR_NOT_FOUND != rc) {
+        fprintf(stderr, "%s: served by %s: %s\n", host, parent, ORTE_ERROR_NAME(rc));
+        return 1;
+    }
+    return 0;
+}
+
+/* until the child is done */
+static int serve_child(pid_t child)
+{
+    int status;
+
+    while (0 == waitpid(child, &status, WNOHANG)) {
+        opal_event_loop(orte_event_base, OPAL_EVLOOP_NONBLOCK);
+        usleep(1000);
+    }
+    orcm_cfgi_base_tree_stop();
+    return (WIFEXITED(status) && 0 == WEXITSTATUS(status)) ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    me_t mes[] = {
+        { "master" },
+        { "row00ctl" },
+        { "r00k00" },
+        { "r00k00n005" },
+        { "r00k01n010" },
+        { "r01k00n020" },
+        { "r01k03n030" },
+        { NULL },
+        { "nosuchnode" }
+    };
+    int nmes = sizeof(mes) / sizeof(me_t);
+    char *last, parent[64];
+    int32_t deflen, nodelen = 0;
+    int i, bad = 0;
+    pid_t child, grandchild;
+    FILE *fp;
+
+    if (1 < argc) {
+        nrows = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nracks = strtol(argv[2], NULL, 10);
+    }
+    if (3 < argc) {
+        nnodes = strtol(argv[3], NULL, 10);
+    }
+    asprintf(&last, "r%02dk%02dn%03d", nrows - 1, nracks - 1, nnodes - 1);
+    mes[nmes - 2].host = last;
+
+    snprintf(site, sizeof(site), "/tmp/cfgi_tree.%d.xml", (int)getpid());
+    if (NULL == (fp = fopen(site, "w"))) {
+        perror(site);
+        exit(1);
+    }
+    write_site(fp);
+    fclose(fp);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_config_file", site, 1);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_use_cache", "0", 1);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_tree_if", "127.0.0.1", 1);
+    setenv(OPAL_MCA_PREFIX"cfgi_base_tree_check_peer", "0", 1);
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    orte_event_base = opal_sync_event_base;
+    orte_process_info.proc_type = ORCM_DAEMON;
+    if (ORCM_SUCCESS != mca_base_framework_open(&orcm_cfgi_base_framework, 0) ||
+        ORCM_SUCCESS != orcm_cfgi_base_select()) {
+        fprintf(stderr, "Failed to select a cfgi component\n");
+        exit(1);
+    }
+
+    /* the site file */
+    mca_cfgi_tree_component.parents = NULL;
+    for (i=0; i < nmes; i++) {
+        if (ORCM_SUCCESS != define(mes[i].host, &mes[i].vpid, &mes[i].hnp, &mes[i].daemon,
+                                   &mes[i].nprocs, &mes[i].deflen)) {
+            fprintf(stderr, "%s: failed to define the system from %s\n", mes[i].host, site);
+            exit(1);
+        }
+    }
+
+    serve(&mes[0], TREE_PORT);
+    if (0 == (child = fork())) {
+        /* the daemons, asking the master */
+        opal_event_reinit(orte_event_base);
+        orcm_cfgi_base_tree_stop();
+        snprintf(parent, sizeof(parent), "127.0.0.1:%d", TREE_PORT);
+        mca_cfgi_tree_component.parents = parent;
+        mca_cfgi_tree_component.timeout = 2;
+        for (i=0; i < nmes; i++) {
+            bad += check(&mes[i], &deflen);
+            if (3 == i) {
+                nodelen = deflen;
+            }
+        }
+        if (nodelen * 4 > mes[0].deflen) {
+            fprintf(stderr, "a compute node got too much of the system\n");
+            bad++;
+        }
+
+        serve(&mes[2], TREE_PORT + 1);
+        if (0 == (grandchild = fork())) {
+            /* a compute node, asking its rack controller */
+            snprintf(parent, sizeof(parent), "127.0.0.1:%d", TREE_PORT + 1);
+            mca_cfgi_tree_component.parents = parent;
+            opal_event_reinit(orte_event_base);
+            orcm_cfgi_base_tree_stop();
+            bad += check(&mes[3], &deflen);
+            bad += refused(mes[5].host, TREE_PORT + 1);
+            exit((0 == bad) ? 0 : 1);
+        }
+        /* the rack controller got its part from the master */
+        bad += serve_child(grandchild);
+
+        /* the compute node once more, not asking from its host */
+        orcm_cfgi_base.tree_check_peer = true;
+        orcm_cfgi_base.tree_port = TREE_PORT + 2;
+        if (ORCM_SUCCESS != orcm_cfgi_base_tree_serve()) {
+            fprintf(stderr, "%s: failed to serve the system\n", mes[2].host);
+            exit(1);
+        }
+        if (0 == (grandchild = fork())) {
+            opal_event_reinit(orte_event_base);
+            orcm_cfgi_base_tree_stop();
+            exit(refused(mes[3].host, TREE_PORT + 2));
+        }
+        bad += serve_child(grandchild);
+        exit((0 == bad) ? 0 : 1);
+    }
+    bad += serve_child(child);
+
+    unlink(site);
+    free(last);
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
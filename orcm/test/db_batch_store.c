@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Pass batches of data sets to a stub module the way the db workers do,
+ * the module taking them as a batch or - as postgres does without COPY -
+ * refusing to, and check that every data set is stored once whatever
+ * the size of the batch, and that a bad one only fails itself:
+ *
+ *   db_batch_store
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opal/class/opal_list.h"
+#include "opal/dss/dss.h"
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/db/base/base.h"
+
+#define NSETS 5
+
+static int batch_rc, nbatched, nstored;
+
+static bool is_bad(opal_list_t *input)
+{
+    opal_value_t *kv;
+
+    OPAL_LIST_FOREACH(kv, input, opal_value_t) {
+        if (0 == strcmp(kv->key, "bad")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int store_new(struct orcm_db_base_module_t *imod,
+                     orcm_db_data_type_t data_type,
+                     opal_list_t *input, opal_list_t *ret)
+{
+    if (is_bad(input)) {
+        return ORCM_ERR_BAD_PARAM;
+    }
+    nstored++;
+    return ORCM_SUCCESS;
+}
+
+static int store_batch(struct orcm_db_base_module_t *imod,
+                       orcm_db_data_type_t data_type,
+                       opal_list_t **inputs, size_t num_inputs)
+{
+    if (ORCM_SUCCESS == batch_rc) {
+        nbatched += num_inputs;
+    }
+    return batch_rc;
+}
+
+static orcm_db_base_module_t module = {
+    NULL,
+    NULL,
+    NULL,
+    store_new,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    store_batch
+};
+
+static opal_list_t *make_set(int n, bool bad)
+{
+    opal_list_t *input = OBJ_NEW(opal_list_t);
+    opal_value_t *kv;
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("hostname");
+    kv->type = OPAL_STRING;
+    asprintf(&kv->data.string, "node%03d", n);
+    opal_list_append(input, &kv->super);
+    if (bad) {
+        kv = OBJ_NEW(opal_value_t);
+        kv->key = strdup("bad");
+        kv->type = OPAL_INT;
+        kv->data.integer = 1;
+        opal_list_append(input, &kv->super);
+    }
+    return input;
+}
+
+/* pass the first num sets with the module answering rc to a batch */
+static int check(const char *what, int rc, opal_list_t **inputs, size_t num,
+                 int bad, int nbatch, int nnew, int expected)
+{
+    int rcs[NSETS], ret;
+    size_t i;
+
+    batch_rc = rc;
+    nbatched = nstored = 0;
+    ret = orcm_db_base_batch_store(&module, ORCM_DB_ENV_DATA, inputs, num, rcs);
+    for (i=0; i < num; i++) {
+        if ((ORCM_SUCCESS == rcs[i]) != ((int)i != bad)) {
+            fprintf(stderr, "%s: data set %lu has status %d\n", what, (unsigned long)i, rcs[i]);
+            return 1;
+        }
+    }
+    if (nbatch != nbatched || nnew != nstored || expected != ret) {
+        fprintf(stderr, "%s: %d stored as a batch, %d one at a time, status %d\n",
+                what, nbatched, nstored, ret);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_list_t *inputs[NSETS];
+    int i, bad = 0;
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    for (i=0; i < NSETS; i++) {
+        inputs[i] = make_set(i, false);
+    }
+
+    bad += check("batch", ORCM_SUCCESS, inputs, NSETS, -1, NSETS, 0, ORCM_SUCCESS);
+    bad += check("single", ORCM_SUCCESS, inputs, 1, -1, 1, 0, ORCM_SUCCESS);
+    /* what postgres answers without COPY */
+    bad += check("unsupported batch", ORCM_ERR_NOT_SUPPORTED, inputs, NSETS, -1,
+                 0, NSETS, ORCM_SUCCESS);
+    bad += check("unsupported single", ORCM_ERR_NOT_SUPPORTED, inputs, 1, -1,
+                 0, 1, ORCM_SUCCESS);
+    bad += check("failed single", ORCM_ERROR, inputs, 1, -1, 0, 1, ORCM_SUCCESS);
+    OPAL_LIST_RELEASE(inputs[2]);
+    inputs[2] = make_set(2, true);
+    bad += check("bad data set", ORCM_ERROR, inputs, NSETS, 2, 0, NSETS - 1,
+                 ORCM_ERR_BAD_PARAM);
+
+    for (i=0; i < NSETS; i++) {
+        OPAL_LIST_RELEASE(inputs[i]);
+    }
+    opal_finalize();
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
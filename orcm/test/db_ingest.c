@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Measure the environmental data ingest rate of the postgres db component
+ * using the INSERT path and the binary COPY path. The database connection
+ * is configured with the usual MCA params, e.g.:
+ *
+ *   db_ingest -mca db_postgres_uri <host>:<port> \
+ *             -mca db_postgres_database <db> \
+ *             -mca db_postgres_user <user>:<password> \
+ *             -mca db_base_num_workers 4 \
+ *             <number of samples> <metrics per sample> [<pool size>]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "opal/class/opal_list.h"
+#include "opal/dss/dss.h"
+#include "opal/mca/base/base.h"
+#include "opal/sys/atomic.h"
+#include "opal/util/argv.h"
+#include "opal/util/cmd_line.h"
+#include "opal/util/error.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+#include "orte/runtime/orte_wait.h"
+
+#include "orcm/runtime/runtime.h"
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/db/db.h"
+
+static opal_cmd_line_init_t cmd_line_init[] = {
+    /* End of list */
+    { NULL, '\0', NULL, NULL, 0,
+      NULL, OPAL_CMD_LINE_TYPE_NULL, NULL }
+};
+
+static volatile bool active;
+static volatile int dbhandle;
+static volatile int32_t pending;
+static volatile int32_t failed;
+
+static void open_cb(int handle, int status, opal_list_t *in,
+                    opal_list_t *out, void *cbdata)
+{
+    if (ORCM_SUCCESS != status) {
+        dbhandle = -1;
+    } else {
+        dbhandle = handle;
+    }
+    if (NULL != in) {
+        OPAL_LIST_RELEASE(in);
+    }
+    active = false;
+}
+
+static void close_cb(int handle, int status, opal_list_t *in,
+                     opal_list_t *out, void *cbdata)
+{
+    active = false;
+}
+
+static void store_cb(int handle, int status, opal_list_t *in,
+                     opal_list_t *out, void *cbdata)
+{
+    if (ORCM_SUCCESS != status) {
+        opal_atomic_add_32(&failed, 1);
+    }
+    OPAL_LIST_RELEASE(in);
+    opal_atomic_add_32(&pending, -1);
+}
+
+static opal_list_t *build_sample(long sample, int nmetrics)
+{
+    opal_list_t *vals;
+    opal_value_t *kv;
+    orcm_metric_value_t *mv;
+    int i;
+
+    vals = OBJ_NEW(opal_list_t);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("ctime");
+    kv->type = OPAL_TIMEVAL;
+    gettimeofday(&kv->data.tv, NULL);
+    opal_list_append(vals, &kv->super);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("hostname");
+    kv->type = OPAL_STRING;
+    asprintf(&kv->data.string, "node%05ld", sample % 4096);
+    opal_list_append(vals, &kv->super);
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("data_group");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup("db_ingest");
+    opal_list_append(vals, &kv->super);
+
+    for (i=0; i < nmetrics; i++) {
+        mv = OBJ_NEW(orcm_metric_value_t);
+        asprintf(&mv->value.key, "core %d", i);
+        mv->units = strdup("degrees C");
+        mv->value.type = OPAL_FLOAT;
+        mv->value.data.fval = 40.0 + (float)((sample + i) % 20);
+        opal_list_append(vals, (opal_list_item_t *)mv);
+    }
+
+    return vals;
+}
+
+static int run(bool copy, long nsamples, int nmetrics, int pool_size)
+{
+    opal_list_t *props;
+    opal_value_t *kv;
+    struct timeval tv_start, tv_end;
+    double elapsed;
+    long i;
+
+    props = OBJ_NEW(opal_list_t);
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("components");
+    kv->type = OPAL_STRING;
+    kv->data.string = strdup("postgres");
+    opal_list_append(props, &kv->super);
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("copy");
+    kv->type = OPAL_BOOL;
+    kv->data.flag = copy;
+    opal_list_append(props, &kv->super);
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("pool_size");
+    kv->type = OPAL_INT;
+    kv->data.integer = pool_size;
+    opal_list_append(props, &kv->super);
+
+    active = true;
+    orcm_db.open("db_ingest", props, open_cb, NULL);
+    ORTE_WAIT_FOR_COMPLETION(active);
+    if (0 > dbhandle) {
+        fprintf(stderr, "Unable to open the postgres database\n");
+        return ORCM_ERROR;
+    }
+
+    failed = 0;
+    pending = (int32_t)nsamples;
+    gettimeofday(&tv_start, NULL);
+    for (i=0; i < nsamples; i++) {
+        orcm_db.store_new(dbhandle, ORCM_DB_ENV_DATA,
+                          build_sample(i, nmetrics), NULL, store_cb, NULL);
+    }
+    ORTE_WAIT_FOR_COMPLETION(0 < pending);
+    gettimeofday(&tv_end, NULL);
+
+    elapsed = (tv_end.tv_sec - tv_start.tv_sec) +
+              (tv_end.tv_usec - tv_start.tv_usec) / 1000000.0;
+    fprintf(stderr, "%-6s: %ld rows in %g sec (%g rows/sec, %ld failed stores, "
+            "%d workers)\n", copy ? "COPY" : "INSERT", nsamples * nmetrics,
+            elapsed, (double)(nsamples * nmetrics) / elapsed, (long)failed,
+            pool_size);
+
+    active = true;
+    orcm_db.close(dbhandle, close_cb, NULL);
+    ORTE_WAIT_FOR_COMPLETION(active);
+
+    return ORCM_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_cmd_line_t cmd_line;
+    char **args = NULL;
+    long nsamples = 4096;
+    int nmetrics = 12;
+    int pool_size = 1;
+    int rc;
+
+    opal_cmd_line_create(&cmd_line, cmd_line_init);
+    mca_base_cmd_line_setup(&cmd_line);
+    if (OPAL_SUCCESS != (rc = opal_cmd_line_parse(&cmd_line, true,
+                                                  argc, argv)) ) {
+        if (OPAL_ERR_SILENT != rc) {
+            fprintf(stderr, "%s: command line error (%s)\n", argv[0],
+                    opal_strerror(rc));
+        }
+        return rc;
+    }
+
+    /*
+     * Since this process can now handle MCA/GMCA parameters, make sure to
+     * process them.
+     */
+    mca_base_cmd_line_process_args(&cmd_line, &environ, &environ);
+
+    opal_cmd_line_get_tail(&cmd_line, &argc, &args);
+    if (0 < argc) {
+        nsamples = strtol(args[0], NULL, 10);
+    }
+    if (1 < argc) {
+        nmetrics = (int)strtol(args[1], NULL, 10);
+    }
+    if (2 < argc) {
+        pool_size = (int)strtol(args[2], NULL, 10);
+    }
+    opal_argv_free(args);
+    if (0 >= nsamples || 0 >= nmetrics || 0 >= pool_size) {
+        fprintf(stderr, "usage: db_ingest <number of samples> <metrics per sample> "
+                "[<pool size>]\n");
+        return 1;
+    }
+
+    if (ORTE_SUCCESS != orcm_init(ORCM_TOOL)) {
+        fprintf(stderr, "Failed orcm_init\n");
+        exit(1);
+    }
+
+    if (ORCM_SUCCESS == run(false, nsamples, nmetrics, pool_size)) {
+        run(true, nsamples, nmetrics, pool_size);
+    }
+
+    if (ORTE_SUCCESS != orcm_finalize()) {
+        fprintf(stderr, "Failed orcm_finalize\n");
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Store the data of many nodes through a db handle served by a pool of
+ * workers, each with a slow stub connection, and close the handle while
+ * they are busy and more stores keep coming:
+ *
+ *   db_workers [<number of workers> [<number of stores>]]
+ *
+ * Each store must be answered once, either stored or refused for want
+ * of a handle, the data of a node always by the same worker and in
+ * order, and nothing may reach a connection once it is closed.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "opal/class/opal_list.h"
+#include "opal/dss/dss.h"
+#include "opal/mca/base/base.h"
+#include "opal/runtime/opal.h"
+#include "opal/sys/atomic.h"
+
+#include "orcm/mca/db/base/base.h"
+
+#define NNODES 64
+
+typedef struct {
+    orcm_db_base_module_t super;
+    int worker;
+    volatile bool closed;
+} stub_module_t;
+
+static int nworkers = 4, nstores = 4000;
+static volatile int32_t nanswered = 0, nstored = 0, nrefused = 0, nlate = 0;
+static volatile int32_t nclosed = 0, close_status = -1;
+static int last_seq[NNODES], node_worker[NNODES];
+static int *answers;
+
+static int stub_store_new(struct orcm_db_base_module_t *imod,
+                          orcm_db_data_type_t data_type,
+                          opal_list_t *input, opal_list_t *ret)
+{
+    stub_module_t *mod = (stub_module_t*)imod;
+    opal_value_t *kv;
+    int node = -1, seq = -1;
+
+    if (mod->closed) {
+        opal_atomic_add_32(&nlate, 1);
+        return ORCM_ERROR;
+    }
+    OPAL_LIST_FOREACH(kv, input, opal_value_t) {
+        if (0 == strcmp(kv->key, "hostname")) {
+            node = strtol(kv->data.string + strlen("node"), NULL, 10);
+        } else if (0 == strcmp(kv->key, "seq")) {
+            seq = kv->data.integer;
+        }
+    }
+    /* only this worker sees this node, so no need to lock */
+    if (0 > node_worker[node]) {
+        node_worker[node] = mod->worker;
+    }
+    if (node_worker[node] != mod->worker || seq <= last_seq[node]) {
+        fprintf(stderr, "node%03d: store %d by worker %d after store %d by worker %d\n",
+                node, seq, mod->worker, last_seq[node], node_worker[node]);
+        return ORCM_ERROR;
+    }
+    last_seq[node] = seq;
+    usleep(50);
+    return ORCM_SUCCESS;
+}
+
+static void stub_finalize(struct orcm_db_base_module_t *imod)
+{
+    stub_module_t *mod = (stub_module_t*)imod;
+
+    mod->closed = true;
+    opal_atomic_add_32(&nclosed, 1);
+    /* the module stays around to catch stores that come too late */
+}
+
+static void store_cb(int dbhandle, int status, opal_list_t *in,
+                     opal_list_t *out, void *cbdata)
+{
+    int i = (int)(intptr_t)cbdata;
+
+    answers[i]++;
+    if (ORCM_SUCCESS == status) {
+        opal_atomic_add_32(&nstored, 1);
+    } else if (ORCM_ERR_NOT_FOUND == status) {
+        opal_atomic_add_32(&nrefused, 1);
+    } else {
+        fprintf(stderr, "store %d: status %d\n", i, status);
+    }
+    OPAL_LIST_RELEASE(in);
+    opal_atomic_add_32(&nanswered, 1);
+}
+
+static void close_cb(int dbhandle, int status, opal_list_t *in,
+                     opal_list_t *out, void *cbdata)
+{
+    close_status = status;
+}
+
+static opal_list_t *make_input(int i)
+{
+    opal_list_t *input = OBJ_NEW(opal_list_t);
+    opal_value_t *kv;
+
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("hostname");
+    kv->type = OPAL_STRING;
+    asprintf(&kv->data.string, "node%03d", i % NNODES);
+    opal_list_append(input, &kv->super);
+    kv = OBJ_NEW(opal_value_t);
+    kv->key = strdup("seq");
+    kv->type = OPAL_INT;
+    kv->data.integer = i;
+    opal_list_append(input, &kv->super);
+    return input;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_db_handle_t *hdl;
+    stub_module_t *mods;
+    char *num;
+    int i, dbhandle, waited, bad = 0;
+
+    if (1 < argc) {
+        nworkers = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nstores = strtol(argv[2], NULL, 10);
+    }
+    asprintf(&num, "%d", nworkers);
+    setenv(OPAL_MCA_PREFIX"db_base_num_workers", num, 1);
+    free(num);
+    if (OPAL_SUCCESS != opal_init(&argc, &argv) ||
+        ORCM_SUCCESS != mca_base_framework_open(&orcm_db_base_framework, 0)) {
+        fprintf(stderr, "Failed to open the db framework\n");
+        exit(1);
+    }
+    nworkers = orcm_db_base.num_workers;
+    answers = (int*)calloc(nstores + 1, sizeof(int));
+    for (i=0; i < NNODES; i++) {
+        last_seq[i] = -1;
+        node_worker[i] = -1;
+    }
+
+    /* a handle as process_open makes them, with a connection per worker */
+    mods = (stub_module_t*)calloc(nworkers, sizeof(stub_module_t));
+    hdl = OBJ_NEW(orcm_db_handle_t);
+    hdl->workers = (orcm_db_worker_t*)calloc(nworkers, sizeof(orcm_db_worker_t));
+    for (i=0; i < nworkers; i++) {
+        mods[i].super.store_new = stub_store_new;
+        mods[i].super.finalize = stub_finalize;
+        mods[i].worker = i;
+        hdl->workers[i].module = &mods[i].super;
+        hdl->workers[i].ev_base = orcm_db_base.worker_bases[i];
+    }
+    hdl->num_workers = nworkers;
+    OPAL_THREAD_LOCK(&orcm_db_base.lock);
+    dbhandle = opal_pointer_array_add(&orcm_db_base.handles, hdl);
+    OPAL_THREAD_UNLOCK(&orcm_db_base.lock);
+
+    /* close half way thru */
+    for (i=0; i < nstores; i++) {
+        if (nstores / 2 == i) {
+            orcm_db.close(dbhandle, close_cb, NULL);
+        }
+        orcm_db.store_new(dbhandle, ORCM_DB_ENV_DATA, make_input(i), NULL,
+                          store_cb, (void*)(intptr_t)i);
+    }
+    for (waited=0; (nanswered < nstores || -1 == close_status) && waited < 30000; waited++) {
+        usleep(1000);
+    }
+
+    fprintf(stderr, "%d workers: %d stores, %d stored, %d refused, %d after the close\n",
+            nworkers, nstores, nstored, nrefused, nlate);
+    for (i=0; i < nstores; i++) {
+        if (1 != answers[i]) {
+            fprintf(stderr, "store %d answered %d times\n", i, answers[i]);
+            bad++;
+            break;
+        }
+    }
+    if (nstored + nrefused != nstores || nstored < nstores / 2 || 0 != nlate) {
+        bad++;
+    }
+    if (ORCM_SUCCESS != close_status || nworkers != nclosed) {
+        fprintf(stderr, "close: status %d, %d of %d connections closed\n",
+                close_status, nclosed, nworkers);
+        bad++;
+    }
+    if (NULL != orcm_db_base_get_handle(dbhandle)) {
+        fprintf(stderr, "the handle is still there\n");
+        bad++;
+    }
+
+    mca_base_framework_close(&orcm_db_base_framework);
+    free(mods);
+    free(answers);
+    opal_finalize();
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
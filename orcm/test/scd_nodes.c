@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Allocate and release sessions against the scheduler node pool the way
+ * the scheduler used to (expand the allocation regex into an argv and
+ * compare every name against every node) and through the node index and
+ * regex walk of the scd base, checking both give the same node states:
+ *
+ *   scd_nodes [<number of nodes> [<number of sessions>]]
+ *
+ * Each session gets nodes spread across the pool, so its regex holds
+ * several ranges.
+ *
+ * Then fill the pool one session at a time, picking the nodes the way
+ * the scheduler used to (count the free nodes and take the first ones
+ * by walking the pool) and from the free node bitmap of the scd base.
+ *
+ * The regex walk is first checked against the argv expansion on regexes
+ * without a prefix, as orte_regex_create makes for numeric names.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+#include "opal/util/argv.h"
+
+#include "orte/util/regex.h"
+
+#include "orcm/runtime/orcm_globals.h"
+#include "orcm/mca/scd/base/base.h"
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* what pmf_allocated and pmf_terminated did */
+static void set_state_argv(char *regex, orcm_scd_node_state_t state)
+{
+    char **nodenames = NULL;
+    orcm_node_t *nodeptr;
+    int i, j, num_nodes;
+
+    orte_regex_extract_node_names(regex, &nodenames);
+    num_nodes = opal_argv_count(nodenames);
+    for (i = 0; i < num_nodes; i++) {
+        for (j = 0; j < orcm_scd_base.nodes.size; j++) {
+            if (NULL == (nodeptr =
+                         (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, j))) {
+                continue;
+            }
+            if (0 == strcmp(nodeptr->name, nodenames[i])) {
+                nodeptr->scd_state = state;
+            }
+        }
+    }
+    opal_argv_free(nodenames);
+}
+
+static int set_state(const char *name, void *cbdata)
+{
+    orcm_node_t *nodeptr;
+
+    if (NULL != (nodeptr = orcm_scd_base_get_node_by_name(name))) {
+        orcm_scd_base_set_node_scd_state(nodeptr, *(orcm_scd_node_state_t*)cbdata);
+    }
+    return ORCM_SUCCESS;
+}
+
+static int add_name(const char *name, void *cbdata)
+{
+    opal_argv_append_nosize((char***)cbdata, name);
+    return ORCM_SUCCESS;
+}
+
+/* the walk must give the names the argv expansion gives */
+static int check_walk(char *regex)
+{
+    char **expected = NULL, **walked = NULL;
+    char *e, *w;
+    int rc, differ;
+
+    orte_regex_extract_node_names(regex, &expected);
+    rc = orcm_scd_base_walk_node_regex(regex, add_name, &walked);
+    e = opal_argv_join(expected, ',');
+    w = opal_argv_join(walked, ',');
+    differ = (ORCM_SUCCESS != rc || NULL == e || NULL == w || 0 != strcmp(e, w));
+    if (differ) {
+        fprintf(stderr, "walk of %s: status %d, %s instead of %s - MISMATCH\n",
+                regex, rc, (NULL == w) ? "nothing" : w, (NULL == e) ? "nothing" : e);
+    }
+    free(e);
+    free(w);
+    opal_argv_free(expected);
+    opal_argv_free(walked);
+    return differ;
+}
+
+/* what pmf_schedule and scd_base_rm_request did */
+static char* select_scan(int num_nodes)
+{
+    orcm_node_t *nodeptr;
+    char **names = NULL, *nodelist, *regex = NULL;
+    int i, free_nodes = 0;
+
+    for (i = 0; i < orcm_scd_base.nodes.size; i++) {
+        if (NULL != (nodeptr = (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, i)) &&
+            ORCM_SCD_NODE_STATE_UNALLOC == nodeptr->scd_state &&
+            ORCM_NODE_STATE_UP == nodeptr->state) {
+            free_nodes++;
+        }
+    }
+    if (free_nodes < num_nodes) {
+        return NULL;
+    }
+    for (i = 0; i < orcm_scd_base.nodes.size; i++) {
+        if (NULL != (nodeptr = (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, i)) &&
+            ORCM_SCD_NODE_STATE_UNALLOC == nodeptr->scd_state &&
+            ORCM_NODE_STATE_UP == nodeptr->state) {
+            opal_argv_append_nosize(&names, nodeptr->name);
+            if (0 == --num_nodes) {
+                break;
+            }
+        }
+    }
+    nodelist = opal_argv_join(names, ',');
+    orte_regex_create(nodelist, &regex);
+    free(nodelist);
+    opal_argv_free(names);
+    return regex;
+}
+
+static int count_alloc(void)
+{
+    orcm_node_t *nodeptr;
+    int i, n = 0;
+
+    for (i = 0; i < orcm_scd_base.nodes.size; i++) {
+        if (NULL != (nodeptr = (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, i)) &&
+            ORCM_SCD_NODE_STATE_ALLOC == nodeptr->scd_state) {
+            n++;
+        }
+    }
+    return n;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_node_t *node;
+    char **regexes, **names, *list, *regex;
+    struct timeval start;
+    orcm_scd_node_state_t alloc = ORCM_SCD_NODE_STATE_ALLOC;
+    orcm_scd_node_state_t unalloc = ORCM_SCD_NODE_STATE_UNALLOC;
+    int nnodes = 10000, nsessions = 1000, per, i, j, n1, n2, differ = 0;
+    double t1, t2;
+
+    if (1 < argc) {
+        nnodes = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nsessions = strtol(argv[2], NULL, 10);
+    }
+    per = nnodes / nsessions;
+
+    if (OPAL_SUCCESS != opal_init_util(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init_util\n");
+        exit(1);
+    }
+
+    /* numeric names */
+    if (check_walk("[3:1-10]") || check_walk("[2:1,3-5],[3:100-102]")) {
+        exit(1);
+    }
+    list = strdup("1,2,3,4,5,6,7,8,9,10");
+    orte_regex_create(list, &regex);
+    free(list);
+    if (check_walk(regex)) {
+        exit(1);
+    }
+    free(regex);
+
+    /* the node pool, as the scd base sets it up */
+    OBJ_CONSTRUCT(&orcm_scd_base.nodes, opal_pointer_array_t);
+    opal_pointer_array_init(&orcm_scd_base.nodes, 8, INT_MAX, 8);
+    OBJ_CONSTRUCT(&orcm_scd_base.node_names, opal_hash_table_t);
+    opal_hash_table_init(&orcm_scd_base.node_names, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.node_vpids, opal_hash_table_t);
+    opal_hash_table_init(&orcm_scd_base.node_vpids, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.up_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.up_nodes, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.alloc_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.alloc_nodes, 1024);
+    OBJ_CONSTRUCT(&orcm_scd_base.free_nodes, opal_bitmap_t);
+    opal_bitmap_init(&orcm_scd_base.free_nodes, 1024);
+    for (i = 0; i < nnodes; i++) {
+        node = OBJ_NEW(orcm_node_t);
+        asprintf(&node->name, "node%05d", i);
+        node->daemon.jobid = 0;
+        node->daemon.vpid = i;
+        node->scd_state = ORCM_SCD_NODE_STATE_UNALLOC;
+        orcm_scd_base_add_node(node);
+        orcm_scd_base_set_node_state(node, ORCM_NODE_STATE_UP);
+    }
+
+    /* session i gets pairs of nodes spread across the pool */
+    regexes = (char**)calloc(nsessions, sizeof(char*));
+    for (i = 0; i < nsessions; i++) {
+        names = NULL;
+        for (j = 0; j < per; j++) {
+            asprintf(&list, "node%05d", (j / 2) * nsessions * 2 + i * 2 + j % 2);
+            opal_argv_append_nosize(&names, list);
+            free(list);
+        }
+        list = opal_argv_join(names, ',');
+        orte_regex_create(list, &regexes[i]);
+        free(list);
+        opal_argv_free(names);
+    }
+    fprintf(stderr, "%d nodes, %d sessions of %d nodes, e.g. %s\n",
+            nnodes, nsessions, per, regexes[0]);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < nsessions; i++) {
+        set_state_argv(regexes[i], ORCM_SCD_NODE_STATE_ALLOC);
+    }
+    t1 = elapsed(&start);
+    n1 = count_alloc();
+    for (i = 0; i < nsessions; i++) {
+        set_state_argv(regexes[i], ORCM_SCD_NODE_STATE_UNALLOC);
+    }
+    fprintf(stderr, "argv:     %.3f sec to allocate, %.1f usec/session\n",
+            t1, 1000000.0 * t1 / nsessions);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < nsessions; i++) {
+        orcm_scd_base_walk_node_regex(regexes[i], set_state, &alloc);
+    }
+    t2 = elapsed(&start);
+    n2 = count_alloc();
+    for (i = 0; i < nsessions; i++) {
+        orcm_scd_base_walk_node_regex(regexes[i], set_state, &unalloc);
+    }
+    fprintf(stderr, "index:    %.3f sec to allocate, %.1f usec/session, %.0fx faster\n",
+            t2, 1000000.0 * t2 / nsessions, t1 / t2);
+    fprintf(stderr, "allocated nodes: %d vs %d%s\n", n1, n2,
+            (n1 == n2 && n1 == nsessions * per && 0 == count_alloc()) ? "" : " - MISMATCH");
+
+    /* fill the pool */
+    gettimeofday(&start, NULL);
+    for (i = 0; i < nsessions; i++) {
+        free(regexes[i]);
+        regexes[i] = select_scan(per);
+        set_state_argv(regexes[i], ORCM_SCD_NODE_STATE_ALLOC);
+    }
+    t1 = elapsed(&start);
+    for (i = 0; i < nsessions; i++) {
+        set_state_argv(regexes[i], ORCM_SCD_NODE_STATE_UNALLOC);
+    }
+    fprintf(stderr, "scan:     %.3f sec to fill the pool, %.1f usec/session\n",
+            t1, 1000000.0 * t1 / nsessions);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < nsessions; i++) {
+        if (per > orcm_scd_base.num_free_nodes ||
+            ORCM_SUCCESS != orcm_scd_base_select_nodes(per, &regex)) {
+            differ++;
+            continue;
+        }
+        orcm_scd_base_walk_node_regex(regex, set_state, &alloc);
+        if (NULL == regexes[i] || 0 != strcmp(regex, regexes[i])) {
+            differ++;
+        }
+        free(regex);
+    }
+    t2 = elapsed(&start);
+    fprintf(stderr, "bitmap:   %.3f sec to fill the pool, %.1f usec/session, %.0fx faster\n",
+            t2, 1000000.0 * t2 / nsessions, t1 / t2);
+    fprintf(stderr, "free nodes left: %d, %d sessions got different nodes%s\n",
+            orcm_scd_base.num_free_nodes, differ,
+            (0 == differ && nnodes - nsessions * per == orcm_scd_base.num_free_nodes) ? "" : " - MISMATCH");
+
+    for (i = 0; i < nsessions; i++) {
+        free(regexes[i]);
+    }
+    free(regexes);
+    for (i = 0; i < orcm_scd_base.nodes.size; i++) {
+        if (NULL != (node = (orcm_node_t*)opal_pointer_array_get_item(&orcm_scd_base.nodes, i))) {
+            OBJ_RELEASE(node);
+        }
+    }
+    OBJ_DESTRUCT(&orcm_scd_base.nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.node_names);
+    OBJ_DESTRUCT(&orcm_scd_base.node_vpids);
+    OBJ_DESTRUCT(&orcm_scd_base.up_nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.alloc_nodes);
+    OBJ_DESTRUCT(&orcm_scd_base.free_nodes);
+    opal_finalize_util();
+    return 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Compare the size and the pack/unpack cost of a coretemp sample in the
+ * labelled encoding and in the compact (schema id + value array) encoding
+ * used in heartbeats, and of the same samples when only the values that
+ * changed are reported, checking that a core that can't be read (NaN)
+ * and then recovers is reported both times:
+ *
+ *   sensor_compact [<number of cores> [<number of samples>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "opal/dss/dss.h"
+#include "opal/mca/base/base.h"
+#include "opal/runtime/opal.h"
+
+#include "orte/util/proc_info.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* pack a sample the way the coretemp sensor does without compaction */
+static void pack_labelled(opal_buffer_t *bucket, int32_t ncores,
+                          char **labels, float *degc)
+{
+    opal_buffer_t data, *bptr;
+    struct timeval now;
+    char *comp = "coretemp";
+    int32_t i;
+
+    OBJ_CONSTRUCT(&data, opal_buffer_t);
+    opal_dss.pack(&data, &comp, 1, OPAL_STRING);
+    opal_dss.pack(&data, &orte_process_info.nodename, 1, OPAL_STRING);
+    opal_dss.pack(&data, &ncores, 1, OPAL_INT32);
+    gettimeofday(&now, NULL);
+    opal_dss.pack(&data, &now, 1, OPAL_TIMEVAL);
+    for (i=0; i < ncores; i++) {
+        opal_dss.pack(&data, &labels[i], 1, OPAL_STRING);
+        opal_dss.pack(&data, &degc[i], 1, OPAL_FLOAT);
+    }
+    bptr = &data;
+    opal_dss.pack(bucket, &bptr, 1, OPAL_BUFFER);
+    OBJ_DESTRUCT(&data);
+}
+
+/* unpack it the way the heartbeat and coretemp_log do */
+static float unpack_labelled(opal_buffer_t *bucket)
+{
+    opal_buffer_t *buf;
+    char *comp, *hostname, *label;
+    struct timeval tv;
+    int32_t n, ncores, i;
+    float degc, sum = 0.0;
+
+    n=1;
+    opal_dss.unpack(bucket, &buf, &n, OPAL_BUFFER);
+    n=1;
+    opal_dss.unpack(buf, &comp, &n, OPAL_STRING);
+    n=1;
+    opal_dss.unpack(buf, &hostname, &n, OPAL_STRING);
+    n=1;
+    opal_dss.unpack(buf, &ncores, &n, OPAL_INT32);
+    n=1;
+    opal_dss.unpack(buf, &tv, &n, OPAL_TIMEVAL);
+    for (i=0; i < ncores; i++) {
+        n=1;
+        opal_dss.unpack(buf, &label, &n, OPAL_STRING);
+        n=1;
+        opal_dss.unpack(buf, &degc, &n, OPAL_FLOAT);
+        sum += degc;
+        free(label);
+    }
+    free(hostname);
+    free(comp);
+    OBJ_RELEASE(buf);
+    return sum;
+}
+
+static float unpack_compact(orte_process_name_t *sender, opal_buffer_t *bucket)
+{
+    opal_buffer_t *buf;
+    orcm_sensor_schema_t *schema;
+    struct timeval tv;
+    char *comp;
+    float *degc, sum = 0.0;
+    uint8_t *changed;
+    int32_t n, i;
+
+    n=1;
+    opal_dss.unpack(bucket, &buf, &n, OPAL_BUFFER);
+    n=1;
+    opal_dss.unpack(buf, &comp, &n, OPAL_STRING);
+    if (ORCM_SUCCESS == orcm_sensor_base_unpack_compact(sender, buf, &schema,
+                                                        &tv, (void**)&degc, &changed)) {
+        for (i=0; i < schema->nitems; i++) {
+            sum += degc[i];
+        }
+    }
+    free(comp);
+    OBJ_RELEASE(buf);
+    return sum;
+}
+
+/* pack a change-only sample and return the value the receiver sees for
+ * the given core, 0 if the sample was not sent */
+static int check_value(orte_process_name_t *sender, orcm_sensor_schema_t *schema,
+                       float *degc, int32_t core, float *val)
+{
+    opal_buffer_t bucket, *buf;
+    struct timeval now;
+    orcm_sensor_schema_t *sch;
+    char *comp;
+    float *vals;
+    uint8_t *changed;
+    int32_t n;
+    int rc = 0;
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&now, NULL);
+    orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    if (0 < bucket.bytes_used) {
+        n=1;
+        opal_dss.unpack(&bucket, &buf, &n, OPAL_BUFFER);
+        n=1;
+        opal_dss.unpack(buf, &comp, &n, OPAL_STRING);
+        if (ORCM_SUCCESS == orcm_sensor_base_unpack_compact(sender, buf, &sch, &now,
+                                                            (void**)&vals, &changed) &&
+            ORCM_SENSOR_BASE_CHANGED(changed, core)) {
+            *val = vals[core];
+            rc = 1;
+        }
+        free(comp);
+        OBJ_RELEASE(buf);
+    }
+    OBJ_DESTRUCT(&bucket);
+    return rc;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_buffer_t bucket;
+    orcm_sensor_schema_t *schema;
+    orte_process_name_t sender;
+    struct timeval tv_start, now;
+    char **labels;
+    float *degc, sum = 0.0;
+    int32_t ncores = 64, i;
+    long nsamples = 100000, s;
+    size_t first_size, size, nbytes;
+    uint16_t first_id;
+    float val, saved;
+    double t_pack, t_unpack;
+
+    if (1 < argc) {
+        ncores = (int32_t)strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nsamples = strtol(argv[2], NULL, 10);
+    }
+    if (0 >= ncores || 0 >= nsamples) {
+        fprintf(stderr, "usage: sensor_compact [<number of cores> [<number of samples>]]\n");
+        return 1;
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        return 1;
+    }
+    if (NULL == orte_process_info.nodename) {
+        orte_process_info.nodename = strdup("node00001.cluster");
+    }
+    if (OPAL_SUCCESS != mca_base_framework_open(&orcm_sensor_base_framework, 0)) {
+        fprintf(stderr, "Failed to open the sensor framework\n");
+        return 1;
+    }
+    /* measure the steady state */
+    orcm_sensor_base.schema_refresh = 0;
+
+    labels = (char**)calloc(ncores + 1, sizeof(char*));
+    degc = (float*)malloc(ncores * sizeof(float));
+    for (i=0; i < ncores; i++) {
+        asprintf(&labels[i], "core %d", i);
+        degc[i] = 40.0 + (float)(i % 20);
+    }
+    sender.jobid = 1;
+    sender.vpid = 1;
+
+    /* labelled encoding */
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    pack_labelled(&bucket, ncores, labels, degc);
+    size = bucket.bytes_used;
+    OBJ_DESTRUCT(&bucket);
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        pack_labelled(&bucket, ncores, labels, degc);
+    }
+    t_pack = elapsed(&tv_start);
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        sum += unpack_labelled(&bucket);
+    }
+    t_unpack = elapsed(&tv_start);
+    OBJ_DESTRUCT(&bucket);
+
+    fprintf(stderr, "labelled: %lu bytes/sample, pack %.3f usec/sample, unpack %.3f usec/sample\n",
+            (unsigned long)size, 1000000.0 * t_pack / nsamples,
+            1000000.0 * t_unpack / nsamples);
+
+    /* compact encoding - the first sample carries the schema */
+    schema = orcm_sensor_base_schema_register("coretemp", OPAL_FLOAT, ncores, labels, NULL);
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&now, NULL);
+    orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    first_size = bucket.bytes_used;
+    sum += unpack_compact(&sender, &bucket);
+    OBJ_DESTRUCT(&bucket);
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    size = bucket.bytes_used;
+    OBJ_DESTRUCT(&bucket);
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        gettimeofday(&now, NULL);
+        orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    }
+    t_pack = elapsed(&tv_start);
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        sum += unpack_compact(&sender, &bucket);
+    }
+    t_unpack = elapsed(&tv_start);
+    OBJ_DESTRUCT(&bucket);
+
+    fprintf(stderr, "compact:  %lu bytes/sample (%lu with schema), pack %.3f usec/sample, "
+            "unpack %.3f usec/sample\n", (unsigned long)size, (unsigned long)first_size,
+            1000000.0 * t_pack / nsamples, 1000000.0 * t_unpack / nsamples);
+
+    first_id = schema->id;
+    orcm_sensor_base_schema_deregister(schema);
+
+    /* change-only reporting with one core moving by more than epsilon
+     * per sample and a full report every 10 samples */
+    orcm_sensor_base.change_only = "coretemp:0.5:10";
+    schema = orcm_sensor_base_schema_register("coretemp", OPAL_FLOAT, ncores, labels, NULL);
+    orcm_sensor_base.change_only = NULL;
+    /* a receiver that missed the new schema must not take it for the old */
+    if (schema->id == first_id) {
+        fprintf(stderr, "schema id %u reused\n", (unsigned)first_id);
+        return 1;
+    }
+    sender.vpid = 2;
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&now, NULL);
+    orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    sum += unpack_compact(&sender, &bucket);
+    OBJ_DESTRUCT(&bucket);
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        degc[s % ncores] += 1.0;
+        gettimeofday(&now, NULL);
+        orcm_sensor_base_pack_compact(&bucket, schema, &now, degc);
+    }
+    t_pack = elapsed(&tv_start);
+    nbytes = bucket.bytes_used;
+    gettimeofday(&tv_start, NULL);
+    for (s=0; s < nsamples; s++) {
+        sum += unpack_compact(&sender, &bucket);
+    }
+    t_unpack = elapsed(&tv_start);
+    OBJ_DESTRUCT(&bucket);
+
+    fprintf(stderr, "changes:  %.1f bytes/sample, pack %.3f usec/sample, unpack %.3f usec/sample\n",
+            (double)nbytes / nsamples, 1000000.0 * t_pack / nsamples,
+            1000000.0 * t_unpack / nsamples);
+
+    /* a core that can't be read, then recovers, is reported both times */
+    saved = degc[0];
+    degc[0] = NAN;
+    if (!check_value(&sender, schema, degc, 0, &val) || !isnan(val)) {
+        fprintf(stderr, "unreadable core not reported\n");
+        return 1;
+    }
+    degc[0] = saved;
+    if (!check_value(&sender, schema, degc, 0, &val) || val != saved) {
+        fprintf(stderr, "recovered core not reported\n");
+        return 1;
+    }
+
+    /* keep the compiler from optimizing the unpacks away */
+    fprintf(stderr, "(checksum %g)\n", sum);
+
+    orcm_sensor_base_schema_deregister(schema);
+    for (i=0; i < ncores; i++) {
+        free(labels[i]);
+    }
+    free(labels);
+    free(degc);
+    mca_base_framework_close(&orcm_sensor_base_framework);
+    opal_finalize();
+    return 0;
+}
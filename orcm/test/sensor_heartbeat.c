@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Feed the heartbeat failure detector the beats of a simulated system
+ * whose daemons beat every second with some jitter, where one daemon
+ * dies, one comes back after dying and one slows down under load:
+ *
+ *   sensor_heartbeat [<number of daemons> [<secs>]]
+ *
+ * Only the dead daemons may be found failed, each once and within a few
+ * beats, and the slow one must not be. The cost of a beat is compared
+ * with counting it in the attributes of the daemon's proc object.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/util/attr.h"
+
+#include "orcm/mca/sensor/heartbeat/sensor_heartbeat.h"
+
+#define DEAD      7
+#define BACK      8
+#define SLOW      9
+
+static int ndaemons = 10000, nsecs = 120;
+static int *nfailed;
+static double *failed_at;
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void failed(orte_vpid_t vpid, double phi, uint32_t missed, void *cbdata)
+{
+    double t = *(double*)cbdata;
+
+    nfailed[vpid]++;
+    failed_at[vpid] = t;
+    fprintf(stderr, "t=%.2f: daemon %u failed, phi %.1f after %u missed beats\n",
+            t, vpid, phi, missed);
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_sensor_heartbeat_detector_t det;
+    double *next, t, step, start, secs, check = 0.0;
+    int32_t beats, *bptr;
+    orte_proc_t **procs;
+    bool was_failed;
+    int i, n, nbeats = 0, bad = 0;
+
+    if (1 < argc) {
+        ndaemons = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nsecs = strtol(argv[2], NULL, 10);
+    }
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    srandom(1);
+
+    nfailed = (int*)calloc(ndaemons, sizeof(int));
+    failed_at = (double*)calloc(ndaemons, sizeof(double));
+    next = (double*)malloc(ndaemons * sizeof(double));
+    if (ORCM_SUCCESS != orcm_sensor_heartbeat_detector_init(&det, 1.0, 1.0, 8.0, 0.0)) {
+        fprintf(stderr, "Failed to init the detector\n");
+        exit(1);
+    }
+    for (i=1; i < ndaemons; i++) {
+        orcm_sensor_heartbeat_detector_watch(&det, i, 0.0);
+        next[i] = (double)random() / RAND_MAX;
+    }
+    /* nothing that cannot be a daemon */
+    if (ORCM_SUCCESS == orcm_sensor_heartbeat_detector_watch(&det, ORTE_VPID_INVALID, 0.0) ||
+        0.0 != orcm_sensor_heartbeat_detector_phi(&det, ORTE_VPID_INVALID, 0.0)) {
+        fprintf(stderr, "an invalid daemon was watched\n");
+        bad++;
+    }
+
+    /* step the simulated time, beating the due daemons and checking
+     * at every tick as the module does */
+    step = det.tick;
+    for (t=step; t <= nsecs; t += step) {
+        for (i=1; i < ndaemons; i++) {
+            if (next[i] > t) {
+                continue;
+            }
+            if ((DEAD == i && t > nsecs / 2) ||
+                (BACK == i && t > nsecs / 4 && t < nsecs / 2)) {
+                next[i] += 1.0;
+                continue;
+            }
+            orcm_sensor_heartbeat_detector_beat(&det, i, next[i], &was_failed);
+            if (was_failed && BACK != i) {
+                fprintf(stderr, "daemon %d came back without dying\n", i);
+                bad++;
+            }
+            nbeats++;
+            /* the slow one takes up to 2.5 secs once it is loaded */
+            if (SLOW == i && t > nsecs / 4) {
+                next[i] += 1.5 + (double)random() / RAND_MAX;
+            } else {
+                next[i] += 0.8 + 0.4 * (double)random() / RAND_MAX;
+            }
+        }
+        start = now();
+        orcm_sensor_heartbeat_detector_expire(&det, t, failed, &t);
+        check += now() - start;
+    }
+
+    for (i=1; i < ndaemons; i++) {
+        n = (DEAD == i || BACK == i) ? 1 : 0;
+        if (nfailed[i] != n) {
+            fprintf(stderr, "daemon %d failed %d times instead of %d\n", i, nfailed[i], n);
+            bad++;
+        }
+    }
+    if (failed_at[DEAD] > nsecs / 2 + 5.0 || failed_at[BACK] > nsecs / 4 + 5.0) {
+        fprintf(stderr, "dead daemons took too long to be found\n");
+        bad++;
+    }
+    if (8.0 > orcm_sensor_heartbeat_detector_phi(&det, DEAD, t)) {
+        fprintf(stderr, "a dead daemon is not suspected\n");
+        bad++;
+    }
+    fprintf(stderr, "%d daemons, %d beats: %.1f usec per check\n",
+            ndaemons - 1, nbeats, 1000000.0 * check / (nsecs / step));
+
+    /* what a beat cost before */
+    procs = (orte_proc_t**)malloc(ndaemons * sizeof(orte_proc_t*));
+    for (i=0; i < ndaemons; i++) {
+        procs[i] = OBJ_NEW(orte_proc_t);
+    }
+    start = now();
+    for (n=0; n < 10; n++) {
+        for (i=1; i < ndaemons; i++) {
+            beats = 0;
+            bptr = &beats;
+            orte_get_attribute(&procs[i]->attributes, ORTE_PROC_NBEATS, (void**)&bptr, OPAL_INT32);
+            beats++;
+            orte_set_attribute(&procs[i]->attributes, ORTE_PROC_NBEATS, ORTE_ATTR_LOCAL,
+                               (void*)bptr, OPAL_INT32);
+        }
+    }
+    secs = now() - start;
+    start = now();
+    for (n=0; n < 10; n++) {
+        for (i=1; i < ndaemons; i++) {
+            orcm_sensor_heartbeat_detector_beat(&det, i, t + n, &was_failed);
+        }
+    }
+    fprintf(stderr, "%.0f nsec per beat in the attributes, %.0f nsec in the detector\n",
+            1e9 * secs / (10 * (ndaemons - 1)), 1e9 * (now() - start) / (10 * (ndaemons - 1)));
+
+    for (i=0; i < ndaemons; i++) {
+        OBJ_RELEASE(procs[i]);
+    }
+    free(procs);
+    free(next);
+    free(nfailed);
+    free(failed_at);
+    orcm_sensor_heartbeat_detector_fini(&det);
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
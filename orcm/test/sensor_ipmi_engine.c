@@ -0,0 +1,575 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Sample a number of fake BMCs answering on local UDP ports, with the
+ * delay of a real BMC, through the IPMI engine of the ipmi sensor:
+ *
+ *   sensor_ipmi_engine [<number of BMCs> [<number of samples>]]
+ *
+ * The first sample opens a session with each and walks its SDR
+ * repository, the next ones only read the sensors - one at a time, then
+ * all at once. A BMC whose repository changed is walked again, a BMC
+ * that forgot its session gets a new one within the sample, and a BMC
+ * that does not answer holds up the others no longer than the timeout.
+ *
+ * To sample a BMC or a simulator such as ipmi_sim instead:
+ *
+ *   sensor_ipmi_engine <address>[:<port>] <user> <password> [<number of samples>]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "opal/runtime/opal.h"
+
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/mca/sensor/ipmi/sensor_ipmi_engine.h"
+
+#define USER       "admin"
+#define PASSWORD   "secret"
+#define NRECORDS   12
+#define DELAY_USEC 2000
+#define MAX_QUEUED 4096
+
+typedef struct {
+    int fd;
+    int port;
+    bool dead;
+    uint32_t session_id;
+    uint32_t temp_id;
+    uint32_t seq;
+    uint32_t added;
+    int nrecords;
+    int sessions;
+    int sdr_reads;
+} fake_bmc_t;
+
+typedef struct {
+    int bmc;
+    struct timeval due;
+    unsigned char pkt[128];
+    int len;
+} queued_t;
+
+static fake_bmc_t *fakes;
+static int nfakes;
+static queued_t queued[MAX_QUEUED];
+static int nqueued = 0;
+static volatile int round_no = 0;
+static volatile bool stopping = false;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static unsigned char checksum(const unsigned char *p, int len)
+{
+    unsigned char sum = 0;
+
+    while (0 < len--) {
+        sum += *p++;
+    }
+    return (unsigned char)(0x100 - sum);
+}
+
+/* half the sensors are wanted */
+static char *tag_of(int k, char *tag)
+{
+    if (0 == k % 2) {
+        sprintf(tag, "Fan %d", k / 2);
+    } else {
+        sprintf(tag, "Core %d Temp", k / 2);
+    }
+    return tag;
+}
+
+static bool want(char *tag)
+{
+    return 0 == strncmp(tag, "Fan ", 4);
+}
+
+static unsigned char reading_of(int b, int k, int r)
+{
+    return (unsigned char)((b + 3 * k + r) % 200);
+}
+
+/* record 0 is a management controller locator, 1..n full sensor records */
+static int record_of(fake_bmc_t *f, int id, unsigned char *rec)
+{
+    char tag[17];
+    int len;
+
+    memset(rec, 0, 64);
+    rec[0] = id & 0xff;
+    rec[1] = id >> 8;
+    rec[2] = 0x51;
+    if (0 == id) {
+        rec[3] = 0x12;
+        rec[4] = 11;
+        return 16;
+    }
+    tag_of(id - 1, tag);
+    len = strlen(tag);
+    rec[3] = 0x01;
+    rec[4] = 43 + len;
+    rec[5] = 0x20;
+    rec[7] = (unsigned char)(id - 1);
+    rec[21] = (0 == (id - 1) % 2) ? 18 : 1;
+    rec[24] = 1;
+    rec[47] = 0xc0 | len;
+    memcpy(rec + 48, tag, len);
+    return 48 + len;
+}
+
+static void answer(int b, unsigned char *pkt, unsigned char *msg, unsigned char cc,
+                   unsigned char *data, int len)
+{
+    queued_t *q;
+    unsigned char *m;
+    int off;
+
+    if (MAX_QUEUED == nqueued) {
+        return;
+    }
+    q = &queued[nqueued++];
+    q->bmc = b;
+    gettimeofday(&q->due, NULL);
+    q->due.tv_usec += DELAY_USEC;
+    if (1000000 <= q->due.tv_usec) {
+        q->due.tv_sec++;
+        q->due.tv_usec -= 1000000;
+    }
+    memcpy(q->pkt, pkt, 13);
+    off = 13;
+    if (0 != pkt[4]) {
+        memset(q->pkt + off, 0, 16);
+        off += 16;
+    }
+    q->pkt[off++] = (unsigned char)(8 + len);
+    m = q->pkt + off;
+    m[0] = 0x81;
+    m[1] = (unsigned char)(((msg[1] >> 2) | 1) << 2 | (msg[1] & 3));
+    m[2] = checksum(m, 2);
+    m[3] = 0x20;
+    m[4] = msg[4];
+    m[5] = msg[5];
+    m[6] = cc;
+    memcpy(m + 7, data, len);
+    m[7 + len] = checksum(m + 3, 4 + len);
+    q->len = off + 8 + len;
+}
+
+static void serve(int b, unsigned char *pkt, int len)
+{
+    fake_bmc_t *f = &fakes[b];
+    unsigned char rsp[64], rec[64], *msg, *d;
+    uint32_t seq, id;
+    int off, mlen, dlen, netfn, cmd, offset, n;
+
+    if (f->dead || 14 > len || 0x06 != pkt[0] || 0x07 != pkt[3]) {
+        return;
+    }
+    seq = get32(pkt + 5);
+    id = get32(pkt + 9);
+    off = 13;
+    if (0 != pkt[4]) {
+        /* the straight password is checked, MD5 is taken on trust */
+        if (0x04 == pkt[4] && 0 != strncmp((char*)pkt + off, PASSWORD, 16)) {
+            return;
+        }
+        off += 16;
+    }
+    mlen = pkt[off++];
+    msg = pkt + off;
+    if (off + mlen != len || 7 > mlen) {
+        return;
+    }
+    netfn = msg[1] >> 2;
+    cmd = msg[5];
+    d = msg + 6;
+    dlen = mlen - 7;
+    if (0x06 == netfn && (0x38 == cmd || 0x39 == cmd)) {
+        if (0x38 == cmd) {
+            rsp[0] = 0x01;
+            rsp[1] = 0x14;      /* MD5 and the straight password */
+            rsp[2] = rsp[3] = rsp[4] = rsp[5] = rsp[6] = rsp[7] = 0;
+            answer(b, pkt, msg, 0, rsp, 8);
+            return;
+        }
+        if (0 != strncmp((char*)d + 1, USER, 16)) {
+            answer(b, pkt, msg, 0x81, NULL, 0);
+            return;
+        }
+        f->temp_id = 0x1000 + b;
+        put32(rsp, f->temp_id);
+        memset(rsp + 4, 0x5a, 16);
+        answer(b, pkt, msg, 0, rsp, 20);
+        return;
+    }
+    if (0x06 == netfn && 0x3a == cmd) {
+        if (id != f->temp_id || 0 == pkt[4]) {
+            return;
+        }
+        f->session_id = 0x20000 + b + 0x100 * f->sessions;
+        f->seq = 100;
+        f->sessions++;
+        rsp[0] = d[0];
+        put32(rsp + 1, f->session_id);
+        put32(rsp + 5, f->seq);
+        rsp[9] = 0x04;
+        answer(b, pkt, msg, 0, rsp, 10);
+        return;
+    }
+    /* the rest are for the session, in sequence */
+    if (0 == f->session_id || id != f->session_id || seq < f->seq || seq > f->seq + 8) {
+        return;
+    }
+    f->seq = seq + 1;
+
+    if (0x06 == netfn) {
+        switch (cmd) {
+        case 0x3b:
+            rsp[0] = d[0];
+            answer(b, pkt, msg, 0, rsp, 1);
+            return;
+        case 0x3c:
+            f->session_id = 0;
+            answer(b, pkt, msg, 0, NULL, 0);
+            return;
+        case 0x01:
+            memset(rsp, 0, 15);
+            rsp[2] = 0x01;
+            rsp[3] = (unsigned char)b;
+            rsp[4] = 0x51;
+            rsp[6] = 0x57;
+            rsp[7] = 0x01;
+            answer(b, pkt, msg, 0, rsp, 15);
+            return;
+        case 0x07:
+            rsp[0] = 0x00;
+            rsp[1] = 0x00;
+            answer(b, pkt, msg, 0, rsp, 2);
+            return;
+        }
+    } else if (0x0a == netfn) {
+        switch (cmd) {
+        case 0x20:
+            memset(rsp, 0, 14);
+            rsp[0] = 0x51;
+            rsp[1] = (unsigned char)(f->nrecords + 1);
+            put32(rsp + 5, f->added);
+            answer(b, pkt, msg, 0, rsp, 14);
+            return;
+        case 0x22:
+            rsp[0] = 0x34;
+            rsp[1] = 0x12;
+            answer(b, pkt, msg, 0, rsp, 2);
+            return;
+        case 0x23:
+            f->sdr_reads++;
+            id = d[2] | d[3] << 8;
+            offset = d[4];
+            if (6 != dlen || 0x1234 != (d[0] | d[1] << 8) || (int)id > f->nrecords) {
+                answer(b, pkt, msg, 0xcb, NULL, 0);
+                return;
+            }
+            n = record_of(f, id, rec);
+            if (offset + d[5] > n) {
+                answer(b, pkt, msg, 0xca, NULL, 0);
+                return;
+            }
+            id = ((int)id == f->nrecords) ? 0xffff : id + 1;
+            rsp[0] = id & 0xff;
+            rsp[1] = id >> 8;
+            memcpy(rsp + 2, rec + offset, d[5]);
+            answer(b, pkt, msg, 0, rsp, 2 + d[5]);
+            return;
+        }
+    } else if (0x04 == netfn && 0x2d == cmd && 1 == dlen && d[0] < f->nrecords) {
+        rsp[0] = reading_of(b, d[0], round_no);
+        rsp[1] = 0xc0;
+        rsp[2] = 0;
+        answer(b, pkt, msg, 0, rsp, 3);
+        return;
+    }
+    answer(b, pkt, msg, 0xc1, NULL, 0);
+}
+
+static void* fake_bmcs(void *arg)
+{
+    struct pollfd *fds = (struct pollfd*)malloc(nfakes * sizeof(struct pollfd));
+    struct sockaddr_in from;
+    socklen_t fromlen;
+    unsigned char pkt[256];
+    struct timeval now;
+    struct sockaddr_in *peers = (struct sockaddr_in*)calloc(nfakes, sizeof(struct sockaddr_in));
+    int i, len, wait;
+
+    while (!stopping) {
+        for (i=0; i < nfakes; i++) {
+            fds[i].fd = fakes[i].fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        wait = (0 < nqueued) ? 1 : 10;
+        if (0 < poll(fds, nfakes, wait)) {
+            for (i=0; i < nfakes; i++) {
+                if (!(fds[i].revents & POLLIN)) {
+                    continue;
+                }
+                fromlen = sizeof(from);
+                len = recvfrom(fakes[i].fd, pkt, sizeof(pkt), 0,
+                               (struct sockaddr*)&from, &fromlen);
+                if (0 < len) {
+                    peers[i] = from;
+                    serve(i, pkt, len);
+                }
+            }
+        }
+        /* the answers that are due */
+        gettimeofday(&now, NULL);
+        for (i=0; i < nqueued; ) {
+            if (queued[i].due.tv_sec < now.tv_sec ||
+                (queued[i].due.tv_sec == now.tv_sec && queued[i].due.tv_usec <= now.tv_usec)) {
+                sendto(fakes[queued[i].bmc].fd, queued[i].pkt, queued[i].len, 0,
+                       (struct sockaddr*)&peers[queued[i].bmc], sizeof(peers[0]));
+                queued[i] = queued[--nqueued];
+            } else {
+                i++;
+            }
+        }
+    }
+    free(fds);
+    free(peers);
+    return NULL;
+}
+
+static int start_fakes(int n)
+{
+    struct sockaddr_in sa;
+    socklen_t len;
+    int i;
+
+    nfakes = n;
+    fakes = (fake_bmc_t*)calloc(n, sizeof(fake_bmc_t));
+    for (i=0; i < n; i++) {
+        fakes[i].fd = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        len = sizeof(sa);
+        if (0 > fakes[i].fd || 0 > bind(fakes[i].fd, (struct sockaddr*)&sa, sizeof(sa)) ||
+            0 > getsockname(fakes[i].fd, (struct sockaddr*)&sa, &len)) {
+            return ORCM_ERROR;
+        }
+        fakes[i].port = ntohs(sa.sin_port);
+        fakes[i].nrecords = NRECORDS;
+        fakes[i].added = 1000;
+    }
+    return ORCM_SUCCESS;
+}
+
+/* the sensors of a sample are those wanted, and read at the round */
+static int check(orcm_sensor_ipmi_bmc_t *bmc, int b, int r)
+{
+    char tag[17];
+    int bad = 0, k, n = 0;
+
+    bad += (ORCM_SUCCESS != bmc->status || !bmc->have_devid || b != bmc->devid[3] ||
+            !bmc->have_power);
+    for (k=0; k < fakes[b].nrecords; k++) {
+        if (!want(tag_of(k, tag))) {
+            continue;
+        }
+        if (n >= bmc->nsensors || 0 != strcmp(tag, bmc->sensors[n].tag) ||
+            !bmc->sensors[n].valid || reading_of(b, k, r) != bmc->sensors[n].reading[0]) {
+            bad++;
+        }
+        n++;
+    }
+    return bad + (n != bmc->nsensors);
+}
+
+static double poll_all(orcm_sensor_ipmi_bmc_t **bmcs, int n, int r, bool serial)
+{
+    struct timeval start;
+    int i;
+
+    round_no = r;
+    gettimeofday(&start, NULL);
+    if (serial) {
+        for (i=0; i < n; i++) {
+            orcm_sensor_ipmi_engine_poll(&bmcs[i], 1, want);
+        }
+    } else {
+        orcm_sensor_ipmi_engine_poll(bmcs, n, want);
+    }
+    return elapsed(&start);
+}
+
+static int simulator(int argc, char *argv[])
+{
+    orcm_sensor_ipmi_bmc_t *bmc;
+    char *addr = strdup(argv[1]), *colon;
+    int port = ORCM_SENSOR_IPMI_PORT, nsamples = 3, s, k;
+    double secs;
+
+    if (NULL != (colon = strchr(addr, ':'))) {
+        *colon = '\0';
+        port = strtol(colon + 1, NULL, 10);
+    }
+    if (4 < argc) {
+        nsamples = strtol(argv[4], NULL, 10);
+    }
+    bmc = orcm_sensor_ipmi_engine_bmc(addr, port, argv[2], argv[3]);
+    for (s=0; s < nsamples; s++) {
+        secs = poll_all(&bmc, 1, 0, false);
+        fprintf(stderr, "sample %d: %s in %.3f sec, device id %s, %d sensors, "
+                "%lu sessions, %lu repository walks, %lu requests, %lu timeouts\n",
+                s, ORTE_ERROR_NAME(bmc->status), secs, bmc->have_devid ? "read" : "n/a",
+                bmc->nsensors, (unsigned long)bmc->sessions, (unsigned long)bmc->sdr_walks,
+                (unsigned long)bmc->requests, (unsigned long)bmc->timeouts);
+        for (k=0; k < bmc->nsensors; k++) {
+            fprintf(stderr, "    %-16s %s 0x%02x\n", bmc->sensors[k].tag,
+                    bmc->sensors[k].valid ? "reading" : "n/a    ", bmc->sensors[k].reading[0]);
+        }
+    }
+    s = bmc->status;
+    OBJ_RELEASE(bmc);
+    free(addr);
+    return (ORCM_SUCCESS == s) ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_sensor_ipmi_bmc_t **bmcs;
+    pthread_t thread;
+    double first, serial, together, dead;
+    uint64_t requests;
+    int nbmcs = 80, nsamples = 5, i, r, bad = 0, walks = 0, sessions = 0;
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    if (3 < argc) {
+        return simulator(argc, argv);
+    }
+    if (1 < argc) {
+        nbmcs = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nsamples = strtol(argv[2], NULL, 10);
+    }
+    orcm_sensor_ipmi_engine.timeout = 100;
+    orcm_sensor_ipmi_engine.retries = 2;
+
+    if (ORCM_SUCCESS != start_fakes(nbmcs + 1)) {
+        fprintf(stderr, "Failed to bind the fake BMCs\n");
+        exit(1);
+    }
+    pthread_create(&thread, NULL, fake_bmcs, NULL);
+    bmcs = (orcm_sensor_ipmi_bmc_t**)malloc((nbmcs + 1) * sizeof(orcm_sensor_ipmi_bmc_t*));
+    for (i=0; i <= nbmcs; i++) {
+        bmcs[i] = orcm_sensor_ipmi_engine_bmc("127.0.0.1", fakes[i].port, USER, PASSWORD);
+    }
+
+    /* a session and a walk of the repository each */
+    first = poll_all(bmcs, nbmcs, 0, false);
+    for (i=0; i < nbmcs; i++) {
+        bad += check(bmcs[i], i, 0);
+    }
+    /* then only the readings, one BMC at a time and all at once */
+    requests = bmcs[0]->requests;
+    serial = poll_all(bmcs, nbmcs, 1, true);
+    requests = bmcs[0]->requests - requests;
+    together = 0.0;
+    for (r=2; r < nsamples + 2; r++) {
+        together += poll_all(bmcs, nbmcs, r, false) / nsamples;
+    }
+    for (i=0; i < nbmcs; i++) {
+        bad += check(bmcs[i], i, nsamples + 1);
+        sessions += fakes[i].sessions;
+        walks += bmcs[i]->sdr_walks;
+    }
+    fprintf(stderr, "%d BMCs: first sample %.3f sec, then %lu requests per BMC: "
+            "%.3f sec one at a time, %.3f sec all at once (%.1fx); %d sessions, "
+            "%d repository walks\n", nbmcs, first, (unsigned long)requests, serial,
+            together, serial / together, sessions, walks);
+    bad += (nbmcs != sessions || nbmcs != walks || serial < 2.0 * together);
+
+    /* a sensor added to one, another forgetting its session */
+    fakes[0].nrecords++;
+    fakes[0].added++;
+    fakes[1 % nbmcs].session_id = 0;
+    poll_all(bmcs, nbmcs, 0, false);
+    bad += check(bmcs[0], 0, 0) + check(bmcs[1 % nbmcs], 1 % nbmcs, 0);
+    fprintf(stderr, "repository changed: %lu walks, %d sensors; session lost: %d sessions\n",
+            (unsigned long)bmcs[0]->sdr_walks, bmcs[0]->nsensors, fakes[1 % nbmcs].sessions);
+    bad += (2 != bmcs[0]->sdr_walks || 2 != fakes[1 % nbmcs].sessions ||
+            1 != fakes[0].sessions);
+
+    /* one that does not answer */
+    fakes[nbmcs].dead = true;
+    dead = poll_all(bmcs, nbmcs + 1, 1, false);
+    for (i=0; i < nbmcs; i++) {
+        bad += check(bmcs[i], i, 1);
+    }
+    fprintf(stderr, "one BMC dead: %.3f sec, %s after %lu timeouts\n", dead,
+            ORTE_ERROR_NAME(bmcs[nbmcs]->status), (unsigned long)bmcs[nbmcs]->timeouts);
+    bad += (ORCM_ERR_TIMEOUT != bmcs[nbmcs]->status ||
+            dead > 2.0 * (orcm_sensor_ipmi_engine.retries + 1) *
+                   orcm_sensor_ipmi_engine.timeout / 1000.0 + together);
+
+    for (i=0; i <= nbmcs; i++) {
+        OBJ_RELEASE(bmcs[i]);
+    }
+    free(bmcs);
+    usleep(2 * DELAY_USEC);
+    stopping = true;
+    pthread_join(thread, NULL);
+    for (i=0; i <= nbmcs; i++) {
+        close(fakes[i].fd);
+    }
+    free(fakes);
+    opal_finalize();
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
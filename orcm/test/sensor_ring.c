@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Store samples in an on-node sensor ring from a writer thread while
+ * reading them back from another, checking that no torn or out of order
+ * sample is ever returned, then compare the heartbeat bytes of sending
+ * every sample with sending a summary of them:
+ *
+ *   sensor_ring [<number of cores> [<number of samples>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "opal/dss/dss.h"
+#include "opal/mca/base/base.h"
+#include "opal/runtime/opal.h"
+#include "opal/util/argv.h"
+
+#include "orte/util/proc_info.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+static orcm_sensor_ring_t *ring;
+static int32_t ncores = 16;
+static uint64_t nsamples = 1000000;
+static volatile bool writing = true;
+
+/* every value of sample n is n, so a torn sample shows up as a mix */
+static void* writer(void *arg)
+{
+    struct timeval tv;
+    float *vals;
+    uint64_t n;
+    int32_t i;
+
+    vals = (float*)malloc(ncores * sizeof(float));
+    for (n=0; n < nsamples; n++) {
+        tv.tv_sec = n;
+        tv.tv_usec = 0;
+        for (i=0; i < ncores; i++) {
+            vals[i] = (float)n;
+        }
+        orcm_sensor_base_ring_store(ring, &tv, vals);
+    }
+    free(vals);
+    writing = false;
+    return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_sensor_schema_t *schema;
+    opal_buffer_t bucket;
+    pthread_t thread;
+    struct timeval *times, now;
+    float *vals;
+    char **labels;
+    uint64_t from = 0, nread = 0, nreads = 0, last = 0;
+    uint32_t n, s;
+    int32_t i, torn = 0, disordered = 0;
+    size_t full, summary;
+    bool first = true;
+
+    if (1 < argc) {
+        ncores = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nsamples = strtoull(argv[2], NULL, 10);
+    }
+
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+    if (OPAL_SUCCESS != mca_base_framework_open(&orcm_sensor_base_framework, 0)) {
+        fprintf(stderr, "Failed to open the sensor framework\n");
+        exit(1);
+    }
+    if (NULL == orte_process_info.nodename) {
+        orte_process_info.nodename = strdup("node00001.cluster");
+    }
+    orcm_sensor_base.ring = strdup("coretemp:64");
+    orcm_sensor_base.ring_mmap = false;
+
+    labels = (char**)calloc(ncores + 1, sizeof(char*));
+    for (i=0; i < ncores; i++) {
+        asprintf(&labels[i], "core %d", i);
+    }
+    schema = orcm_sensor_base_schema_register("coretemp", OPAL_FLOAT, ncores, labels, NULL);
+    if (NULL == (ring = (orcm_sensor_ring_t*)schema->ring)) {
+        fprintf(stderr, "No ring was set up\n");
+        exit(1);
+    }
+
+    /* concurrent reads */
+    times = (struct timeval*)malloc(ring->nslots * sizeof(struct timeval));
+    vals = (float*)malloc(ring->nslots * ring->value_size);
+    pthread_create(&thread, NULL, writer, NULL);
+    while (writing || from < *ring->head) {
+        n = orcm_sensor_base_ring_read(ring, &from, ring->nslots, times, vals);
+        nreads++;
+        for (s=0; s < n; s++) {
+            for (i=1; i < ncores; i++) {
+                if (vals[s * ncores + i] != vals[s * ncores]) {
+                    torn++;
+                    break;
+                }
+            }
+            if ((uint64_t)times[s].tv_sec != (uint64_t)vals[s * ncores] ||
+                (!first && (uint64_t)times[s].tv_sec <= last)) {
+                disordered++;
+            }
+            last = times[s].tv_sec;
+            first = false;
+        }
+        nread += n;
+    }
+    pthread_join(thread, NULL);
+    fprintf(stderr, "ring:     %"PRIu64" samples stored, %"PRIu64" read in %"PRIu64" reads, "
+            "%d torn, %d out of order\n", nsamples, nread, nreads, torn, disordered);
+
+    /* heartbeat bytes for a full ring of samples */
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    orcm_sensor_base.ring = NULL;
+    orcm_sensor_base_schema_deregister(schema);
+    schema = orcm_sensor_base_schema_register("coretemp", OPAL_FLOAT, ncores, labels, NULL);
+    gettimeofday(&now, NULL);
+    orcm_sensor_base_pack_compact(&bucket, schema, &now, vals);
+    OBJ_DESTRUCT(&bucket);
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    for (s=0; s < 64; s++) {
+        orcm_sensor_base_pack_compact(&bucket, schema, &now, vals);
+    }
+    full = bucket.bytes_used;
+    OBJ_DESTRUCT(&bucket);
+
+    OBJ_CONSTRUCT(&bucket, opal_buffer_t);
+    free(vals);
+    vals = (float*)calloc(3 * ncores, sizeof(float));
+    orcm_sensor_base_pack_summary(&bucket, schema, &now, 64, vals,
+                                  vals + ncores, vals + 2 * ncores);
+    summary = bucket.bytes_used;
+    OBJ_DESTRUCT(&bucket);
+    fprintf(stderr, "summary:  %lu bytes for 64 samples instead of %lu\n",
+            (unsigned long)summary, (unsigned long)full);
+
+    orcm_sensor_base_schema_deregister(schema);
+    opal_argv_free(labels);
+    free(times);
+    free(vals);
+    mca_base_framework_close(&orcm_sensor_base_framework);
+    opal_finalize();
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Compare the cost of reading a set of sysfs-style integer files the way
+ * the sensors used to (fopen/getline/strtoul/fclose per file and per
+ * sample) with the persistent pread readers of the sensor base:
+ *
+ *   sensor_sysfs [<number of samples> [<file> ...]]
+ *
+ * Without files, one temp file per core is created in /tmp as a stand-in
+ * for /sys/bus/platform/devices/coretemp.N/tempM_input. The read syscalls
+ * per sample are taken from /proc/self/io.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+           (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static unsigned long read_syscalls(void)
+{
+    FILE *fp;
+    char line[128];
+    unsigned long n = 0;
+
+    if (NULL == (fp = fopen("/proc/self/io", "r"))) {
+        return 0;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        if (0 == strncmp(line, "syscr:", 6)) {
+            n = strtoul(line + 6, NULL, 10);
+        }
+    }
+    fclose(fp);
+    return n;
+}
+
+/* what coretemp and freq did for each file */
+static int64_t read_stdio(char *file)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t len = 0;
+    int64_t val = 0;
+
+    if (NULL == (fp = fopen(file, "r"))) {
+        return -1;
+    }
+    if (0 < getline(&line, &len, fp)) {
+        val = strtoul(line, NULL, 10);
+    }
+    free(line);
+    fclose(fp);
+    return val;
+}
+
+int main(int argc, char* argv[])
+{
+    orcm_sensor_sysfs_t set;
+    struct timeval start;
+    char **files;
+    int nfiles = 288, nsamples = 1000, i, s;
+    int64_t sum1 = 0, sum2 = 0;
+    unsigned long sc;
+    double t1, t2;
+    bool created = false;
+    FILE *fp;
+
+    if (1 < argc) {
+        nsamples = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nfiles = argc - 2;
+        files = &argv[2];
+    } else {
+        files = (char**)calloc(nfiles + 1, sizeof(char*));
+        for (i=0; i < nfiles; i++) {
+            asprintf(&files[i], "/tmp/sensor_sysfs.%d.temp%d_input", (int)getpid(), i);
+            fp = fopen(files[i], "w");
+            fprintf(fp, "%d\n", 40000 + i);
+            fclose(fp);
+        }
+        created = true;
+    }
+
+    if (OPAL_SUCCESS != opal_init_util(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init_util\n");
+        exit(1);
+    }
+
+    sc = read_syscalls();
+    gettimeofday(&start, NULL);
+    for (s=0; s < nsamples; s++) {
+        for (i=0; i < nfiles; i++) {
+            sum1 += read_stdio(files[i]);
+        }
+    }
+    t1 = elapsed(&start);
+    fprintf(stderr, "stdio:    %d files, %.2f usec/sample, %.1f reads/sample plus %d opens and closes\n",
+            nfiles, 1000000.0 * t1 / nsamples,
+            (double)(read_syscalls() - sc - 1) / nsamples, nfiles);
+
+    OBJ_CONSTRUCT(&set, orcm_sensor_sysfs_t);
+    for (i=0; i < nfiles; i++) {
+        if (0 > orcm_sensor_base_sysfs_add(&set, files[i])) {
+            fprintf(stderr, "Cannot open %s\n", files[i]);
+            exit(1);
+        }
+    }
+    sc = read_syscalls();
+    gettimeofday(&start, NULL);
+    for (s=0; s < nsamples; s++) {
+        orcm_sensor_base_sysfs_read_all(&set);
+        for (i=0; i < nfiles; i++) {
+            sum2 += set.values[i];
+        }
+    }
+    t2 = elapsed(&start);
+    fprintf(stderr, "pread:    %d files, %.2f usec/sample, %.1f reads/sample, %.1fx faster%s\n",
+            nfiles, 1000000.0 * t2 / nsamples,
+            (double)(read_syscalls() - sc - 1) / nsamples, t1 / t2,
+            (sum1 == sum2) ? "" : " - VALUES DIFFER");
+    OBJ_DESTRUCT(&set);
+
+    if (created) {
+        for (i=0; i < nfiles; i++) {
+            unlink(files[i]);
+            free(files[i]);
+        }
+        free(files);
+    }
+    opal_finalize_util();
+    return 0;
+}
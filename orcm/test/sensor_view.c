@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Pack the samples of a heartbeat as the sensors do and unpack them
+ * both as copies and as views into the beat, in plain and in fully
+ * described buffers, checking that both give the same samples and that
+ * a truncated beat is caught:
+ *
+ *   sensor_view [<samples per beat> [<values per sample>]]
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "opal/dss/dss.h"
+#include "opal/runtime/opal.h"
+
+#include "orcm/mca/sensor/base/base.h"
+#include "orcm/mca/sensor/base/sensor_private.h"
+
+#define NBEATS  1000
+
+static int nsamples = 64, nvalues = 256;
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void pack_beat(opal_buffer_t *beat)
+{
+    opal_buffer_t sample, *bptr;
+    char *comp = "test";
+    float *vals;
+    int i, j;
+
+    vals = (float*)malloc(nvalues * sizeof(float));
+    for (i=0; i < nsamples; i++) {
+        OBJ_CONSTRUCT(&sample, opal_buffer_t);
+        sample.type = beat->type;
+        opal_dss.pack(&sample, &comp, 1, OPAL_STRING);
+        for (j=0; j < nvalues; j++) {
+            vals[j] = (float)(i * nvalues + j);
+        }
+        opal_dss.pack(&sample, vals, nvalues, OPAL_FLOAT);
+        bptr = &sample;
+        opal_dss.pack(beat, &bptr, 1, OPAL_BUFFER);
+        OBJ_DESTRUCT(&sample);
+    }
+    free(vals);
+}
+
+/* what a sensor log function does with a sample */
+static double log_sample(opal_buffer_t *sample)
+{
+    char *comp;
+    float *vals;
+    double sum = 0.0;
+    int32_t n;
+    int j;
+
+    n = 1;
+    if (OPAL_SUCCESS != opal_dss.unpack(sample, &comp, &n, OPAL_STRING)) {
+        return -1.0;
+    }
+    free(comp);
+    vals = (float*)malloc(nvalues * sizeof(float));
+    n = nvalues;
+    if (OPAL_SUCCESS != opal_dss.unpack(sample, vals, &n, OPAL_FLOAT) || n != nvalues) {
+        free(vals);
+        return -1.0;
+    }
+    for (j=0; j < nvalues; j++) {
+        sum += vals[j];
+    }
+    free(vals);
+    return sum;
+}
+
+static double copies(opal_buffer_t *beat, bool logging, int *count)
+{
+    opal_buffer_t *sample;
+    double sum = 0.0;
+    int32_t n = 1;
+
+    *count = 0;
+    while (OPAL_SUCCESS == opal_dss.unpack(beat, &sample, &n, OPAL_BUFFER)) {
+        if (logging) {
+            sum += log_sample(sample);
+        }
+        OBJ_RELEASE(sample);
+        (*count)++;
+        n = 1;
+    }
+    return sum;
+}
+
+static double views(opal_buffer_t *beat, bool logging, int *count, int *rc)
+{
+    opal_buffer_t sample;
+    double sum = 0.0;
+
+    *count = 0;
+    OBJ_CONSTRUCT(&sample, opal_buffer_t);
+    while (OPAL_SUCCESS == (*rc = orcm_sensor_base_unpack_view(beat, &sample))) {
+        if (logging) {
+            sum += log_sample(&sample);
+        }
+        orcm_sensor_base_drop_view(&sample);
+        (*count)++;
+    }
+    OBJ_DESTRUCT(&sample);
+    return sum;
+}
+
+/* unpack the same beat both ways, then time getting at the samples */
+static int check(opal_buffer_t *beat, char *what)
+{
+    char *base = beat->unpack_ptr;
+    double c, v, t0, t1, t2;
+    int nc, nv, rc, i;
+
+    c = copies(beat, true, &nc);
+    beat->unpack_ptr = base;
+    v = views(beat, true, &nv, &rc);
+    if (c != v || nc != nv || nsamples != nv ||
+        OPAL_ERR_UNPACK_READ_PAST_END_OF_BUFFER != rc) {
+        fprintf(stderr, "%s: %d samples summing to %g as views, %d summing to %g as copies\n",
+                what, nv, v, nc, c);
+        return 1;
+    }
+
+    t0 = now();
+    for (i=0; i < NBEATS; i++) {
+        beat->unpack_ptr = base;
+        copies(beat, false, &nc);
+    }
+    t1 = now();
+    for (i=0; i < NBEATS; i++) {
+        beat->unpack_ptr = base;
+        views(beat, false, &nv, &rc);
+    }
+    t2 = now();
+    fprintf(stderr, "%s: %d bytes per beat, %.1f usec as copies, %.1f usec as views\n",
+            what, (int)beat->bytes_used, 1e6 * (t1 - t0) / NBEATS, 1e6 * (t2 - t1) / NBEATS);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    opal_buffer_t beat;
+    int bad = 0, nv, rc;
+
+    if (1 < argc) {
+        nsamples = strtol(argv[1], NULL, 10);
+    }
+    if (2 < argc) {
+        nvalues = strtol(argv[2], NULL, 10);
+    }
+    if (OPAL_SUCCESS != opal_init(&argc, &argv)) {
+        fprintf(stderr, "Failed opal_init\n");
+        exit(1);
+    }
+
+    OBJ_CONSTRUCT(&beat, opal_buffer_t);
+    beat.type = OPAL_DSS_BUFFER_NON_DESC;
+    pack_beat(&beat);
+    bad += check(&beat, "plain");
+
+    /* cut the last sample short - it must not be read past the beat */
+    beat.unpack_ptr = beat.base_ptr;
+    beat.bytes_used -= 5;
+    views(&beat, true, &nv, &rc);
+    if (nsamples - 1 != nv || OPAL_ERR_UNPACK_READ_PAST_END_OF_BUFFER != rc) {
+        fprintf(stderr, "truncated: %d samples, rc %d\n", nv, rc);
+        bad++;
+    }
+    OBJ_DESTRUCT(&beat);
+
+    OBJ_CONSTRUCT(&beat, opal_buffer_t);
+    beat.type = OPAL_DSS_BUFFER_FULLY_DESC;
+    pack_beat(&beat);
+    bad += check(&beat, "described");
+    OBJ_DESTRUCT(&beat);
+
+    fprintf(stderr, "%s\n", (0 == bad) ? "ok" : "FAILED");
+    return (0 == bad) ? 0 : 1;
+}
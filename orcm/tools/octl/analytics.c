@@ -44,6 +44,7 @@ static int orcm_octl_analytics_wf_remove_unpack_buffer(opal_buffer_t *buf, orte_
 static int orcm_octl_analytics_wf_list_parse_args(char **value, orte_process_name_t *wf_agg);
 static int orcm_octl_analytics_wf_list_pack_buffer(opal_buffer_t *buf, orte_rml_recv_cb_t *xfer);
 static int orcm_octl_analytics_wf_list_unpack_buffer(opal_buffer_t *buf, orte_rml_recv_cb_t *xfer);
+static int orcm_octl_analytics_stats_unpack_buffer(opal_buffer_t *buf, orte_rml_recv_cb_t *xfer);
 
 
 
@@ -492,6 +493,88 @@ int orcm_octl_analytics_workflow_list(char **value)
     return ORTE_SUCCESS;
 }
 
+static int orcm_octl_analytics_stats_unpack_buffer(opal_buffer_t *buf, orte_rml_recv_cb_t *xfer)
+{
+    int nworkers;
+    int n;
+    int rc;
+    int temp;
+    uint64_t stats[5];
+
+    n=1;
+    if (ORCM_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &nworkers, &n, OPAL_INT))) {
+        orcm_octl_analytics_process_error(rc, buf, xfer);
+        return rc;
+    }
+    if (0 >= nworkers) {
+        fprintf(stdout, "\nNo analytics workers running\n");
+        return ORCM_SUCCESS;
+    }
+    fprintf(stdout, "\nWORKER       STEPS   STOLEN  AVG WAIT(us)  MAX WAIT(us)  QUEUED\n");
+    for (temp = 0; temp < nworkers; temp++) {
+        n = 5;
+        if (ORCM_SUCCESS != (rc = opal_dss.unpack(&xfer->data, stats, &n, OPAL_UINT64))) {
+            orcm_octl_analytics_process_error(rc, buf, xfer);
+            return rc;
+        }
+        fprintf(stdout, "%6d %11lu %8lu %13.1f %13lu %7lu\n", temp,
+                (unsigned long)stats[0], (unsigned long)stats[1],
+                (0 < stats[0]) ? (double)stats[2] / stats[0] : 0.0,
+                (unsigned long)stats[3], (unsigned long)stats[4]);
+    }
+    return ORCM_SUCCESS;
+}
+
+int orcm_octl_analytics_stats(char **value)
+{
+    orte_rml_recv_cb_t *xfer = NULL;
+    opal_buffer_t *buf;
+    orte_process_name_t wf_agg;
+    orcm_analytics_cmd_flag_t command;
+    int rc;
+
+    if (3 != opal_argv_count(value)) {
+        fprintf(stderr, "\nincorrect arguments! \n usage: \"analytics stats vpid \"\n");
+        return ORCM_ERR_BAD_PARAM;
+    }
+    if (0 != isdigit(value[2][strlen(value[2])-1])) {
+        wf_agg.jobid = 0;
+        wf_agg.vpid = (orte_vpid_t)strtol(value[2], NULL, 10);
+        fprintf(stdout, "\nSending to %s\n", ORTE_NAME_PRINT(&wf_agg));
+    }
+    else {
+        fprintf(stderr, "\nincorrect argument VPID id!\n \"%s\" is not an integer \n", value[2]);
+        return ORCM_ERR_BAD_PARAM;
+    }
+
+    xfer = OBJ_NEW(orte_rml_recv_cb_t);
+    orcm_octl_analytics_output_setup(xfer);
+
+    buf = OBJ_NEW(opal_buffer_t);
+
+    command = ORCM_ANALYTICS_EXECUTOR_STATS;
+    if (ORCM_SUCCESS != (rc = opal_dss.pack(buf, &command, 1, OPAL_UINT8))) {
+        orcm_octl_analytics_process_error(rc, buf, xfer);
+        return rc;
+    }
+
+    rc = orcm_octl_analytics_wf_send_buffer(&wf_agg, buf, xfer);
+    if (ORCM_SUCCESS != rc) {
+        return rc;
+    }
+
+    ORTE_WAIT_FOR_COMPLETION(xfer->active);
+
+    rc = orcm_octl_analytics_stats_unpack_buffer(buf, xfer);
+    if (ORCM_SUCCESS != rc) {
+        return rc;
+    }
+
+    OBJ_DESTRUCT(xfer);
+    orte_rml.recv_cancel(ORTE_NAME_WILDCARD, ORCM_RML_TAG_ANALYTICS);
+    return ORTE_SUCCESS;
+}
+
 /* get key/value from line */
 static int orcm_octl_wf_add_parse_line(FILE *fp, int *params_array_length,
                                        opal_value_t tokenized[])
@@ -69,12 +69,14 @@ int orcm_octl_sensor_sample_rate_set(int cmd, char **argv);
 int orcm_octl_sensor_sample_rate_get(int cmd, char **argv);
 int orcm_octl_sensor_policy_set(int cmd, char **argv);
 int orcm_octl_sensor_policy_get(int cmd, char **argv);
+int orcm_octl_sensor_history_get(int cmd, char **argv);
 int orcm_octl_grouping_add(int argc, char **argv);
 int orcm_octl_grouping_remove(int argc, char **argv);
 int orcm_octl_grouping_list(int argc, char **argv);
 int orcm_octl_analytics_workflow_add(char *file);
 int orcm_octl_analytics_workflow_remove(char **value);
 int orcm_octl_analytics_workflow_list (char **value);
+int orcm_octl_analytics_stats(char **value);
 
 END_C_DECLS
 
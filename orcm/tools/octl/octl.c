@@ -562,6 +562,9 @@ static int run_cmd(char *cmd)
                 case 31: //sample-rate
                     rc = orcm_octl_sensor_sample_rate_get(ORCM_GET_SENSOR_SAMPLE_RATE_COMMAND, cmdlist);
                     break;
+                case 37: //history
+                    rc = orcm_octl_sensor_history_get(ORCM_GET_SENSOR_RING_COMMAND, cmdlist);
+                    break;
                 default:
                     rc = ORCM_ERROR;
                     break;
@@ -625,6 +628,9 @@ static int run_cmd(char *cmd)
                 break;
             }
             break;
+        case 38: //stats
+            rc = orcm_octl_analytics_stats(cmdlist);
+            break;
 
         default:
             rc = ORCM_ERROR;
@@ -123,6 +123,8 @@ static orcm_cli_init_t cli_init[] = {
     { { "sensor", "get", NULL }, "sample-rate", 0, 2, "Get Sensor Sample Rate: get sample-rate <sensor-name> <node-name>" },
     // sensor policy subcommand
     { { "sensor", "get", NULL }, "policy", 0, 1, "Get Sensor Event Policy" },
+    // sensor history subcommand
+    { { "sensor", "get", NULL }, "history", 0, 2, "Get Sensor Samples Kept On The Nodes: get history <sensor-name> <node-name>" },
 
     /****** power command ******/
     { { NULL }, "power", 0, 0, "Global Power Policy" },
@@ -180,6 +182,7 @@ static orcm_cli_init_t cli_init[] = {
     { { "analytics", "workflow", NULL }, "add", 0, 1, "add workflow: add file..txt" },
     { { "analytics", "workflow", NULL }, "remove", 0, 2, "remove workflow: remove VPID workflow_id" },
     { { "analytics", "workflow", NULL }, "get", 0, 0, "list workflow: get VPID" },
+    { { "analytics", NULL }, "stats", 0, 1, "executor statistics: stats VPID" },
 
     /* quit command */
     { { NULL }, "exit", 0, 0, "Exit the shell" },
@@ -230,6 +233,8 @@ const char *orcm_octl_commands[] = { "resource",          //0
                                      "exit",              //34
                                      "analytics",         //35
                                      "workflow",          //36
+                                     "history",           //37
+                                     "stats",             //38
                                      "\0" };
 
 END_C_DECLS
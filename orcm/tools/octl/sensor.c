@@ -7,6 +7,8 @@
  * $HEADER$
  */
 
+#include <time.h>
+
 #include "orcm/tools/octl/common.h"
 #include "orte/mca/notifier/notifier.h"
 #include "orcm/util/logical_group.h"
@@ -649,3 +651,219 @@ done:
     orte_rml.recv_cancel(ORTE_NAME_WILDCARD, ORCM_RML_TAG_SENSOR);
     return rc;
 }
+
+int orcm_octl_sensor_history_get(int cmd, char **argv)
+{
+    orcm_sensor_cmd_flag_t command;
+    opal_buffer_t *buf = NULL;
+    int rc = ORCM_SUCCESS;
+    int response, cnt, i, j, k;
+    orte_process_name_t tgt;
+    orte_rml_recv_cb_t *xfer = NULL;
+    char **nodelist = NULL;
+    char *hostname = NULL;
+    char **labels = NULL, **units = NULL;
+    struct timeval *times = NULL;
+    double *values = NULL;
+    int32_t nrings, nitems, nsamples;
+    time_t sec;
+    char tbuf[32];
+
+    if (5 != opal_argv_count(argv)) {
+        fprintf(stderr, "\n  incorrect arguments! \n\n usage: \"sensor \
+get history <sensor-name> <nodelist>\"\n");
+        return ORCM_ERR_BAD_PARAM;
+    }
+
+    /* setup the receiver nodelist */
+    orcm_node_names(argv[4], &nodelist);
+    if (0 == opal_argv_count(nodelist)) {
+        fprintf(stdout, "\nERROR: unable to extract nodelist\n");
+        opal_argv_free(nodelist);
+        return ORCM_ERR_BAD_PARAM;
+    }
+
+    /* pack the buffer to send */
+    buf = OBJ_NEW(opal_buffer_t);
+
+    command = ORCM_GET_SENSOR_COMMAND;
+    /* pack the command flag */
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &command,
+                                            1, ORCM_SENSOR_CMD_T))) {
+        goto done;
+    }
+
+    command = cmd;
+    /* pack the sub-command flag */
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &command,
+                                            1, ORCM_SENSOR_CMD_T))) {
+        goto done;
+    }
+
+    /* pack sensor name */
+    if (OPAL_SUCCESS != (rc = opal_dss.pack(buf, &argv[3],
+                                            1, OPAL_STRING))) {
+        goto done;
+    }
+
+    /* Loop through the nodelist to get the samples kept on each node */
+    xfer = OBJ_NEW(orte_rml_recv_cb_t);
+    for (i = 0; i < opal_argv_count(nodelist); i++) {
+        OBJ_RETAIN(buf);
+        OBJ_RETAIN(xfer);
+
+        xfer->active = true;
+        orte_rml.recv_buffer_nb(ORTE_NAME_WILDCARD,
+                            ORCM_RML_TAG_SENSOR,
+                            ORTE_RML_NON_PERSISTENT,
+                            orte_rml_recv_callback, xfer);
+
+        fprintf(stdout, "\nORCM getting sensor %s history from node:%s\n",
+                argv[3], nodelist[i]);
+        if (ORCM_SUCCESS != (rc = orcm_cfgi_base_get_hostname_proc(nodelist[i],
+                                                                   &tgt))) {
+            goto done;
+        }
+
+        /* send command to node daemon */
+        if (ORTE_SUCCESS !=
+            (rc = orte_rml.send_buffer_nb(&tgt, buf,
+                                          ORCM_RML_TAG_SENSOR,
+                                          orte_rml_send_callback, NULL))) {
+            goto done;
+        }
+
+        /* wait for status message */
+        ORTE_WAIT_FOR_COMPLETION(xfer->active);
+
+        cnt=1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &response,
+                                                  &cnt, OPAL_INT))) {
+            goto done;
+        }
+
+        if ( 0 != response ) {
+            rc = ORCM_SUCCESS;
+            fprintf(stdout, "\nERROR: Bad parameter\n");
+            goto done;
+        }
+
+        cnt = 1;
+        if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &nrings,
+                                                  &cnt, OPAL_INT32))) {
+            goto done;
+        }
+        if (0 == nrings) {
+            fprintf(stdout, "\nNo samples kept for sensor %s\n", argv[3]);
+            continue;
+        }
+
+        for (j = 0; j < nrings; j++) {
+            cnt = 1;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &hostname,
+                                                      &cnt, OPAL_STRING))) {
+                goto done;
+            }
+            cnt = 1;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &nitems,
+                                                      &cnt, OPAL_INT32))) {
+                goto done;
+            }
+            labels = (char**)calloc(nitems + 1, sizeof(char*));
+            units = (char**)calloc(nitems + 1, sizeof(char*));
+            if (NULL == labels || NULL == units) {
+                rc = ORCM_ERR_OUT_OF_RESOURCE;
+                goto done;
+            }
+            cnt = nitems;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, labels,
+                                                      &cnt, OPAL_STRING))) {
+                goto done;
+            }
+            cnt = nitems;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, units,
+                                                      &cnt, OPAL_STRING))) {
+                goto done;
+            }
+            cnt = 1;
+            if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, &nsamples,
+                                                      &cnt, OPAL_INT32))) {
+                goto done;
+            }
+
+            printf("\n%s: %d samples\ntime", hostname, nsamples);
+            for (k = 0; k < nitems; k++) {
+                printf(",%s (%s)", labels[k], units[k]);
+            }
+            printf("\n");
+            printf("------------------------------------------------------------------------------\n");
+
+            if (0 < nsamples) {
+                times = (struct timeval*)malloc(nsamples * sizeof(struct timeval));
+                values = (double*)malloc((size_t)nsamples * nitems * sizeof(double));
+                if (NULL == times || NULL == values) {
+                    rc = ORCM_ERR_OUT_OF_RESOURCE;
+                    goto done;
+                }
+                cnt = nsamples;
+                if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, times,
+                                                          &cnt, OPAL_TIMEVAL))) {
+                    goto done;
+                }
+                /* doubles are sent as their bit patterns */
+                cnt = nsamples * nitems;
+                if (OPAL_SUCCESS != (rc = opal_dss.unpack(&xfer->data, values,
+                                                          &cnt, OPAL_UINT64))) {
+                    goto done;
+                }
+                for (cnt = 0; cnt < nsamples; cnt++) {
+                    sec = times[cnt].tv_sec;
+                    strftime(tbuf, sizeof(tbuf), "%Y-%m-%d %H:%M:%S", localtime(&sec));
+                    printf("%s.%06ld", tbuf, (long)times[cnt].tv_usec);
+                    for (k = 0; k < nitems; k++) {
+                        printf(",%f", values[cnt * nitems + k]);
+                    }
+                    printf("\n");
+                }
+                free(times);
+                times = NULL;
+                free(values);
+                values = NULL;
+            }
+            free(hostname);
+            hostname = NULL;
+            opal_argv_free(labels);
+            labels = NULL;
+            opal_argv_free(units);
+            units = NULL;
+        }
+    }
+
+done:
+    if(buf) {
+       OBJ_RELEASE(buf);
+    }
+    if(xfer) {
+       OBJ_RELEASE(xfer);
+    }
+    if(nodelist) {
+       opal_argv_free(nodelist);
+    }
+    if (NULL != hostname) {
+        free(hostname);
+    }
+    if (NULL != labels) {
+        opal_argv_free(labels);
+    }
+    if (NULL != units) {
+        opal_argv_free(units);
+    }
+    if (NULL != times) {
+        free(times);
+    }
+    if (NULL != values) {
+        free(values);
+    }
+    orte_rml.recv_cancel(ORTE_NAME_WILDCARD, ORCM_RML_TAG_SENSOR);
+    return rc;
+}
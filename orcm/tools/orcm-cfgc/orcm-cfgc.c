@@ -0,0 +1,128 @@
+/* -*- C -*-
+ * Copyright (c) 2015      Intel, Inc. All rights reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ ***************************************************************************
+ *                                                                         *
+ *              Open Resilient Cluster Manager Config Compiler             *
+ *                                                                         *
+ *              http://www.open-mpi.org/projects/orcm                      *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Reads the site file once and writes the system it defines to the
+ * compiled config the daemons load at startup in its place, for as long
+ * as the site file does not change. Run it again after editing the site
+ * file - until then, the daemons fall back to reading the site file.
+ */
+
+#include "orcm_config.h"
+#include "orcm/constants.h"
+
+#include <stdio.h>
+
+#include "opal/util/cmd_line.h"
+#include "opal/util/opal_environ.h"
+#include "opal/mca/base/mca_base_var.h"
+
+#include "orte/runtime/orte_globals.h"
+#include "orte/mca/errmgr/errmgr.h"
+
+#include "orcm/runtime/runtime.h"
+#include "orcm/mca/cfgi/base/base.h"
+
+static struct {
+    bool help;
+    bool version;
+    bool verbose;
+} orcm_globals;
+
+static opal_cmd_line_init_t cmd_line_init[] = {
+    /* Various "obvious" options */
+    { NULL, 'h', NULL, "help", 0,
+      &orcm_globals.help, OPAL_CMD_LINE_TYPE_BOOL,
+      "This help message" },
+
+    { NULL, 'V', NULL, "version", 0,
+      &orcm_globals.version, OPAL_CMD_LINE_TYPE_BOOL,
+      "Print version and exit" },
+
+    { NULL, 'v', NULL, "verbose", 0,
+      &orcm_globals.verbose, OPAL_CMD_LINE_TYPE_BOOL,
+      "Be verbose" },
+
+    { "cfgi_base_config_file", 's', "site-file", "site-file", 1,
+      NULL, OPAL_CMD_LINE_TYPE_STRING,
+      "Site configuration file to compile" },
+
+    { "cfgi_base_cache_file", 'o', "output", "output", 1,
+      NULL, OPAL_CMD_LINE_TYPE_STRING,
+      "Compiled config to write [default: the site file with .cache appended]" },
+
+    /* End of list */
+    { NULL, '\0', NULL, NULL, 0,
+      NULL, OPAL_CMD_LINE_TYPE_NULL, NULL }
+};
+
+int main(int argc, char *argv[])
+{
+    int ret;
+    opal_cmd_line_t cmd_line;
+    char *path;
+
+    /* process the cmd line arguments to get any MCA params on them */
+    opal_cmd_line_create(&cmd_line, cmd_line_init);
+    mca_base_cmd_line_setup(&cmd_line);
+    if (ORCM_SUCCESS != (ret = opal_cmd_line_parse(&cmd_line, false, argc, argv)) ||
+        orcm_globals.help) {
+        char *args = NULL;
+        args = opal_cmd_line_get_usage_msg(&cmd_line);
+        fprintf(stderr, "Usage: %s [OPTION]...\n%s\n", argv[0], args);
+        free(args);
+        return ret;
+    }
+
+    if (orcm_globals.version) {
+        fprintf(stderr, "orcm %s\n", ORCM_VERSION);
+        exit(0);
+    }
+
+    /*
+     * Since this process can now handle MCA/GMCA parameters, make sure to
+     * process them.
+     */
+    mca_base_cmd_line_process_args(&cmd_line, &environ, &environ);
+
+    /* we compile the site file itself, never an older compiled copy */
+    opal_setenv(OPAL_MCA_PREFIX"cfgi_base_use_cache", "0", true, &environ);
+
+    /***************
+     * Initialize
+     ***************/
+    if (ORCM_SUCCESS != (ret = orcm_init(ORCM_TOOL))) {
+        return ret;
+    }
+
+    if (NULL == (path = orcm_cfgi_base_cache_path())) {
+        ret = ORCM_ERR_BAD_PARAM;
+        fprintf(stderr, "%s: no site file given\n", argv[0]);
+    } else if (ORCM_SUCCESS != (ret = orcm_cfgi_base_cache_write(path))) {
+        fprintf(stderr, "%s: failed to write %s: %s\n", argv[0], path,
+                ORTE_ERROR_NAME(ret));
+    } else if (orcm_globals.verbose) {
+        fprintf(stderr, "%s: compiled %s into %s, %d daemons\n", argv[0],
+                orcm_cfgi_base.config_file, path,
+                (int)orte_process_info.num_procs);
+    }
+    free(path);
+
+    /***************
+     * Cleanup
+     ***************/
+    orcm_finalize();
+
+    return (ORCM_SUCCESS == ret) ? 0 : 1;
+}